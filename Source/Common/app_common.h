@@ -229,6 +229,10 @@ PUBLIC uint16 APP_u16ZncWriteDataPattern( uint8 *pu8Data,
                                           teZCL_ZCLAttributeType eAttributeDataType,
                                           uint8 *pu8Struct,
                                          uint32 u32Size);
+PUBLIC uint16 APP_u16ZncReadDataPattern( uint8 *pu8Data,
+                                         teZCL_ZCLAttributeType eAttributeDataType,
+                                         void *pvValue,
+                                         uint16 u16Elements);
 PUBLIC void APP_vSendDataIndicationToHost( ZPS_tsAfEvent *psStackEvent,
                                            uint8* pau8StatusBuffer);
 PUBLIC void Znc_vSendDataIndicationToHost( ZPS_tsAfEvent *psStackEvent,
@@ -259,6 +263,7 @@ extern bool_t APP_bZCL_IsManufacturerCodeSupported( uint16 u16ManufacturerCode )
 /****************************************************************************/
 /***        External Variables                                            ***/
 /****************************************************************************/
+extern bool_t bDataIndicationForwarded;
 #ifdef FULL_FUNC_DEVICE
 extern tsZllEndpointInfoTable     sEndpointTable;
 extern tsZllGroupInfoTable        sGroupTable;
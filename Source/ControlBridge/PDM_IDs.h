@@ -61,12 +61,18 @@ extern "C" {
 /****************************************************************************/
 /***        Macro Definitions                                             ***/
 /****************************************************************************/
+/* NVM area handed to PDM_eInitialise */
+#define PDM_START_SEGMENT                   1200
+#define PDM_NUM_SEGMENTS                    63
+
 #define PDM_ID_APP_ZLL_CMSSION                    (0x1)
 #define PDM_ID_APP_END_P_TABLE                    (0x2)
 #define PDM_ID_APP_GROUP_TABLE                    (0x3)
 
 
 #define PDM_ID_APP_VERSION                  0x10
+#define PDM_ID_APP_OTA_STORE                0x11
+#define PDM_ID_APP_CHANNEL_QUALITY          0x12
 
 #define PDM_ID_INTERNAL_AIB                 0xf000
 #define PDM_ID_INTERNAL_BINDS               0xf001
@@ -83,8 +89,14 @@ extern "C" {
 
 #ifdef  CLD_GREENPOWER
 #define PDM_ID_POWER_ON_COUNTER         0xa
+/* Whole-table records of earlier builds, only read to migrate them */
 #define PDM_ID_APP_CLD_GP_TRANS_TABLE       (0xA103)
 #define PDM_ID_APP_CLD_GP_SINK_PROXY_TABLE  (0xA104)
+#define PDM_ID_APP_CLD_GP_RESTORE_INFO      (0xA105)
+#define PDM_ID_APP_CLD_GP_CMD_INFO_UPDATE   (0xA106)
+/* One record per table entry: base + entry index */
+#define PDM_ID_APP_CLD_GP_TRANS_ENTRY       (0xA110)
+#define PDM_ID_APP_CLD_GP_SINK_PROXY_ENTRY  (0xA120)
 #endif
 
 /****************************************************************************/
@@ -68,6 +68,13 @@
 /***        Macro Definitions                                             ***/
 /****************************************************************************/
 
+/* Fold one byte into a running message checksum */
+#ifdef CCITT_CRC
+#define SL_CRC_UPDATE(CRC, VAL)    u8CCITT_CRC((CRC), (VAL))
+#else
+#define SL_CRC_UPDATE(CRC, VAL)    ((CRC) ^ (VAL))
+#endif
+
 /****************************************************************************/
 /***        Type Definitions                                              ***/
 /****************************************************************************/
@@ -141,6 +148,7 @@ PUBLIC bool bSL_ReadMessage(uint16 *pu16Type, uint16 *pu16Length, uint16 u16MaxL
     static uint8 u8CRC;
     static uint16 u16Bytes;
     static bool bInEsc = FALSE;
+    bool bComplete;
 
     switch(u8Data)
     {
@@ -161,8 +169,11 @@ PUBLIC bool bSL_ReadMessage(uint16 *pu16Type, uint16 *pu16Length, uint16 u16MaxL
         case SL_END_CHAR:
             // End message
             DBG_vPrintf(DEBUG_SL, "\nGot END");
+            /* Only a frame whose whole payload has arrived can complete, a stray
+             * END would otherwise pass the previous frame up again */
+            bComplete = ((eRxState == E_STATE_RX_WAIT_DATA) && (u16Bytes == *pu16Length));
             eRxState = E_STATE_RX_WAIT_START;
-            if(*pu16Length < u16MaxLength)
+            if(bComplete && (*pu16Length < u16MaxLength))
             {
                 if(u8CRC == u8SL_CalculateCRC(*pu16Type, *pu16Length, pu8Message))
                 {
@@ -256,15 +267,62 @@ PUBLIC bool bSL_ReadMessage(uint16 *pu16Type, uint16 *pu16Length, uint16 u16MaxL
  ****************************************************************************/
 PUBLIC void vSL_WriteMessage(uint16 u16Type, uint16 u16Length, uint8 *pu8Data, uint8 u8LinkQuality)
 {
-    int n;
-    uint8 u8CRC;
+    tsSL_Segment sSegment;
+
+    /* The link quality goes out after the payload rather than being stored
+     * past its end, so buffers only need to hold the payload */
+    sSegment.pu8Data = pu8Data;
+    sSegment.u16Length = u16Length;
+    vSL_WriteMessageVector(u16Type, 1, &sSegment, u8LinkQuality);
+}
+
+
+/****************************************************************************
+ *
+ * NAME: vSL_WriteMessageVector
+ *
+ * DESCRIPTION:
+ * Write a message whose payload is split over several buffers, e.g. a
+ * header built on the stack followed by the payload still held in an APDU.
+ * The segments are escaped straight onto the serial link so no contiguous
+ * copy of the payload is needed. The caller must keep the segments valid
+ * until the function returns.
+ *
+ * PARAMETERS: Name                   RW  Usage
+ *             u16Type                R   Message type
+ *             u8NumSegments          R   Number of payload segments
+ *             psSegments             R   Payload segments, in order
+ *             u8LinkQuality          R   Message radio quality
+ * RETURNS:
+ * void
+ ****************************************************************************/
+PUBLIC void vSL_WriteMessageVector(uint16 u16Type, uint8 u8NumSegments, const tsSL_Segment *psSegments, uint8 u8LinkQuality)
+{
+    uint8 i;
+    uint16 n;
+    uint16 u16Length = 1;
+    uint8 u8CRC = 0;
 
-    u16Length++;
+    for(i = 0; i < u8NumSegments; i++)
+    {
+        u16Length += psSegments[i].u16Length;
+    }
 
-    pu8Data[u16Length-1]=u8LinkQuality;
-    u8CRC = u8SL_CalculateCRC(u16Type, u16Length, pu8Data);
+    /* Checksum is sent ahead of the payload, so it needs a pass of its own */
+    u8CRC = SL_CRC_UPDATE(u8CRC, (u16Type   >> 0) & 0xff);
+    u8CRC = SL_CRC_UPDATE(u8CRC, (u16Type   >> 8) & 0xff);
+    u8CRC = SL_CRC_UPDATE(u8CRC, (u16Length >> 0) & 0xff);
+    u8CRC = SL_CRC_UPDATE(u8CRC, (u16Length >> 8) & 0xff);
+    for(i = 0; i < u8NumSegments; i++)
+    {
+        for(n = 0; n < psSegments[i].u16Length; n++)
+        {
+            u8CRC = SL_CRC_UPDATE(u8CRC, psSegments[i].pu8Data[n]);
+        }
+    }
+    u8CRC = SL_CRC_UPDATE(u8CRC, u8LinkQuality);
 
-    DBG_vPrintf(DEBUG_SL, "\nvSL_WriteMessage(%d, %d, %02x)", u16Type, u16Length, u8CRC);
+    DBG_vPrintf(DEBUG_SL, "\nvSL_WriteMessageVector(%d, %d, %02x)", u16Type, u16Length, u8CRC);
 
     /* Send start character */
     vSL_TxByte(TRUE, SL_START_CHAR);
@@ -280,11 +338,15 @@ PUBLIC void vSL_WriteMessage(uint16 u16Type, uint16 u16Length, uint8 *pu8Data, u
     /* Send message checksum */
     vSL_TxByte(FALSE, u8CRC);
 
-    /* Send message payload */
-    for(n = 0; n < u16Length; n++)
+    /* Send message payload, one segment after the other */
+    for(i = 0; i < u8NumSegments; i++)
     {
-        vSL_TxByte(FALSE, pu8Data[n]);
+        for(n = 0; n < psSegments[i].u16Length; n++)
+        {
+            vSL_TxByte(FALSE, psSegments[i].pu8Data[n]);
+        }
     }
+    vSL_TxByte(FALSE, u8LinkQuality);
 
     /* Send end character */
     vSL_TxByte(TRUE, SL_END_CHAR);
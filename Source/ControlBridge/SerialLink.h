@@ -186,6 +186,28 @@ typedef enum
 	E_SL_MSG_PDM_GET_ROUTING_TABLE_LIST						   =   0x8053,
 	E_SL_MSG_PDM_GET_NETWORK_KEY							   =   0x0054,
 	E_SL_MSG_PDM_GET_NETWORK_KEY_LIST						   =   0x8054,
+    E_SL_MSG_GET_DEVICE_SNAPSHOT                               =   0x0055,
+    E_SL_MSG_DEVICE_SNAPSHOT_FRAME                             =   0x8055,
+    E_SL_MSG_GET_PDM_TELEMETRY                                 =   0x0056,
+    E_SL_MSG_PDM_TELEMETRY                                     =   0x8056,
+    E_SL_MSG_GET_BOOT_TIMING                                   =   0x0057,
+    E_SL_MSG_BOOT_TIMING                                       =   0x8057,
+    E_SL_MSG_SECLIB_BENCHMARK                                  =   0x0058,
+    E_SL_MSG_SECLIB_BENCHMARK_RESULT                           =   0x8058,
+    E_SL_MSG_GET_OTA_FLEET_STATS                               =   0x0059,
+    E_SL_MSG_OTA_FLEET_STATS                                   =   0x8059,
+    E_SL_MSG_GET_OTA_BLOCK_SIZE                                =   0x005A,
+    E_SL_MSG_OTA_BLOCK_SIZE                                    =   0x805A,
+    E_SL_MSG_OTA_STORE                                         =   0x005B,
+    E_SL_MSG_OTA_STORE_RESPONSE                                =   0x805B,
+    E_SL_MSG_BEACON_FILTER                                     =   0x005C,
+    E_SL_MSG_BEACON_FILTER_RESPONSE                            =   0x805C,
+    E_SL_MSG_CHANNEL_QUALITY                                   =   0x005D,
+    E_SL_MSG_CHANNEL_QUALITY_RESPONSE                          =   0x805D,
+    E_SL_MSG_STACK_WATERMARK                                   =   0x005E,
+    E_SL_MSG_STACK_WATERMARK_RESPONSE                          =   0x805E,
+    E_SL_MSG_ZCL_BENCHMARK                                     =   0x005F,
+    E_SL_MSG_ZCL_BENCHMARK_RESULT                              =   0x805F,
 
     E_SL_MSG_USER_DESC_SET                                     =   0x0533,
     E_SL_MSG_USER_DESC_REQ                                     =   0x0532,
@@ -301,6 +323,19 @@ typedef enum
     E_SL_MSG_REPORT_ATTRIBUTES                                  =  0x8121,
     E_SL_MSG_READ_REPORT_CONFIG_REQUEST                         =  0x0122,
     E_SL_MSG_READ_REPORT_CONFIG_RESPONSE                        =  0x8122,
+    E_SL_MSG_REPORT_FILTER_SET_RULE                             =  0x0123,
+    E_SL_MSG_REPORT_FILTER_GET_STATS                            =  0x0124,
+    E_SL_MSG_REPORT_FILTER_STATS                                =  0x8124,
+    E_SL_MSG_ATTRIBUTE_CACHE_SET_RULE                           =  0x0125,
+    E_SL_MSG_ATTRIBUTE_CACHE_GET_STATS                          =  0x0126,
+    E_SL_MSG_ATTRIBUTE_CACHE_STATS                              =  0x8126,
+    E_SL_MSG_DEVICE_INTERVIEW_START                             =  0x0127,
+    E_SL_MSG_DEVICE_INTERVIEW_RESULT                            =  0x8127,
+    E_SL_MSG_CHILD_QUEUE_SET_EXPIRY                             =  0x0128,
+    E_SL_MSG_CHILD_QUEUE_GET_STATS                              =  0x0129,
+    E_SL_MSG_CHILD_QUEUE_STATS                                  =  0x8129,
+    E_SL_MSG_CHILD_QUEUE_EXPIRED                                =  0x812A,
+    E_SL_MSG_APS_QUEUE_REPORT_DEPTH                             =  0x012B,
     E_SL_MSG_ATTRIBUTE_DISCOVERY_REQUEST                        =  0x0140,
     E_SL_MSG_ATTRIBUTE_DISCOVERY_RESPONSE                       =  0x8140,
     E_SL_MSG_ATTRIBUTE_DISCOVERY_INDIVIDUAL_RESPONSE            =  0x8139,
@@ -347,6 +382,8 @@ typedef enum
     E_SL_MSG_IMAGE_NOTIFY                                       =  0x0505,
     E_SL_MSG_SEND_WAIT_FOR_DATA_PARAMS                          =  0x0506,
     E_SL_MSG_SEND_RAW_APS_DATA_PACKET                          =   0x0530,
+    E_SL_MSG_GET_APS_FRAGMENTATION_INFO                        =   0x0534,
+    E_SL_MSG_APS_FRAGMENTATION_INFO_RESPONSE                   =   0x8534,
 
     E_SL_MSG_NWK_RECOVERY_EXTRACT_REQ                           =  0x0600,
     E_SL_MSG_NWK_RECOVERY_EXTRACT_RSP                           =  0x8600,
@@ -406,6 +443,13 @@ typedef struct
     uint8 au8Message[256];
 }  tsSL_Msg_Log;
 
+/** One piece of a message payload for vSL_WriteMessageVector */
+typedef struct
+{
+    const uint8 *pu8Data;
+    uint16 u16Length;
+} tsSL_Segment;
+
 /****************************************************************************/
 /***        Local Function Prototypes                                     ***/
 /****************************************************************************/
@@ -424,6 +468,7 @@ typedef struct
 
 PUBLIC bool bSL_ReadMessage(uint16 *pu16Type, uint16 *pu16Length, uint16 u16MaxLength, uint8 *pu8Message,uint8 u8Byte);
 PUBLIC void vSL_WriteMessage(uint16 u16Type, uint16 u16Length, uint8 *pu8Data, uint8 u8LinkQuality);
+PUBLIC void vSL_WriteMessageVector(uint16 u16Type, uint8 u8NumSegments, const tsSL_Segment *psSegments, uint8 u8LinkQuality);
 PUBLIC uint8 u8SL_CalculateCRC(uint16 u16Type, uint16 u16Length, uint8 *pu8Data);
 /****************************************************************************/
 /***        Local Functions                                               ***/
@@ -89,6 +89,51 @@
 #include "app_ota_server.h"
 #endif
 
+#ifdef APS_QUEUE
+#include "app_aps_queue.h"
+#endif
+#ifdef CHILD_QUEUE
+#include "app_child_queue.h"
+#endif
+
+#ifdef REPORT_FILTER
+#include "app_report_filter.h"
+#endif
+#ifdef ATTRIBUTE_CACHE
+#include "app_attribute_cache.h"
+#endif
+#ifdef DEVICE_INTERVIEW
+#include "app_device_interview.h"
+#endif
+#ifdef DEVICE_SNAPSHOT
+#include "app_device_snapshot.h"
+#endif
+#ifdef PDM_TELEMETRY
+#include "app_pdm_telemetry.h"
+#endif
+#include "app_boot_timing.h"
+#ifdef SECLIB_BENCHMARK
+#include "app_seclib_benchmark.h"
+#endif
+#ifdef ZCL_BENCHMARK
+#include "app_zcl_benchmark.h"
+#endif
+#ifdef OTA_FLEET
+#include "app_ota_fleet.h"
+#endif
+#ifdef OTA_STORE
+#include "app_ota_store.h"
+#endif
+#ifdef BEACON_FILTER
+#include "app_beacon_filter.h"
+#endif
+#ifdef CHANNEL_QUALITY
+#include "app_channel_quality.h"
+#endif
+#ifdef STACK_WATERMARK
+#include "app_stack_watermark.h"
+#endif
+
 #if (APP_NCI_ICODE == 1)
 #include "app_nci_icode.h"
 #endif
@@ -141,19 +186,9 @@ PRIVATE ZPS_teStatus APP_eZdpLeaveReq ( ZPS_tuAddress     uAddress,
 PRIVATE ZPS_teStatus APP_eZdpRemoveDeviceReq ( ZPS_tuAddress    uParentAddress,
                                                ZPS_tuAddress    uChildAddress );
 
-PRIVATE ZPS_teStatus APP_eZdpNodeDescReq ( uint16     u16Addr,
-                                           uint8*     pu8Seq );
-
 PRIVATE ZPS_teStatus APP_eZdpPowerDescReq ( uint16    u16Addr,
                                             uint8*    pu8Seq );
 
-PRIVATE ZPS_teStatus APP_eZdpSimpleDescReq ( uint16    u16Addr,
-                                             uint8     u8Endpoint,
-                                             uint8*    pu8Seq);
-
-PRIVATE ZPS_teStatus APP_eZdpActiveEndpointReq ( uint16    u16Addr,
-                                                 uint8*    pu8Seq );
-
 PRIVATE ZPS_teStatus APP_eZdpMatchDescReq ( uint16    u16Addr,
                                             uint16    u16profile,
                                             uint8     u8InputCount,
@@ -190,11 +225,11 @@ PRIVATE ZPS_teStatus APP_eBindUnbindEntry ( bool_t         bBind,
                                             uint8          *pu8Seq,
                                             uint8*         pu8SeqMask);
 
+#ifdef LEGACY_SUPPORT
 PRIVATE ZPS_teStatus APP_eZdpComplexDescReq ( uint16    u16Addr,
                                               uint16    u16NwkAddressInterst,
                                               uint8*    pu8Seq );
-
-PRIVATE bool APP_APSKeysExist( uint16 u16Addr, uint16 tmp[50]);
+#endif
 
 //PRIVATE void APP_MigratePDM( void );
 
@@ -250,9 +285,14 @@ PRIVATE teZCL_Status APP_eZclBasicResetToFactoryDefaults (  uint8            u8S
 
 PRIVATE ZPS_teStatus APP_eApsProfileDataRequest ( ZPS_tsAfProfileDataReq*    psProfileDataReq,
                                                   uint8*                     pu8Data,
-                                                  uint8                      u8DataLength,
+                                                  uint16                     u16DataLength,
                                                   uint8*                     pu8Seq  ) ;
 
+PRIVATE void APP_vHandleSerialCommand ( void );
+
+PRIVATE uint8 APP_u8ApsMaxPayloadSize ( uint8             u8DstAddrMode,
+                                        ZPS_tuAddress*    puDstAddr );
+
 #ifdef LEGACY_SUPPORT
 PRIVATE ZPS_teStatus APP_eSetUserDescriptorReq( uint16    u16Addr,
                                                 uint16    u16AddrOfInt,
@@ -277,11 +317,16 @@ PRIVATE void APP_vUpdateReportableChange( tuZCL_AttributeReportable *puAttribute
 
 extern tsLedState      s_sLedState;
 
+PUBLIC tsApsFragmentationStats    sApsFragmentationStats;
+
 /****************************************************************************/
 /***    Local Variables                           ***/
 /****************************************************************************/
 uint16             u16PacketType;
 uint16             u16PacketLength;
+PRIVATE uint16     u16RxPacketType;
+PRIVATE uint16     u16RxPacketLength;
+PRIVATE uint8      au8SerialRxFrame[MAX_PACKET_SIZE];
 bool_t             bResetIssued          =  FALSE;
 uint32             u32ChannelMask        =  0;
 uint32             u32OldFrameCtr;
@@ -339,6 +384,138 @@ PUBLIC  teZCL_Status  APP_eSendWriteAttributesRequest ( uint8            u8Sourc
 /****************************************************************************/
 
 PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
+{
+    if( TRUE == bSL_ReadMessage( &u16RxPacketType,
+                                 &u16RxPacketLength,
+                                 MAX_PACKET_SIZE,
+                                 au8SerialRxFrame,
+                                 u8RxByte
+                               )
+      )
+    {
+#ifdef APS_QUEUE
+        teApsQueueAdmit    eAdmit;
+        uint8              u8Held;
+
+#ifdef CHILD_QUEUE
+        eAdmit = APP_eChildQueueAdmit ( u16RxPacketType, u16RxPacketLength, au8SerialRxFrame );
+        if ( eAdmit == E_APS_QUEUE_BYPASS )
+#endif
+        {
+            eAdmit = APP_eApsQueueAdmit ( u16RxPacketType, u16RxPacketLength, au8SerialRxFrame );
+        }
+        if ( eAdmit != E_APS_QUEUE_BYPASS )
+        {
+            switch ( eAdmit )
+            {
+                case E_APS_QUEUE_QUEUED:
+                    u8Held = APS_QUEUE_REQUEST_QUEUED;
+                break;
+#ifdef CHILD_QUEUE
+                case E_APS_QUEUE_HELD:
+                    u8Held = CHILD_QUEUE_REQUEST_HELD;
+                break;
+
+                case E_APS_QUEUE_COALESCED:
+                    u8Held = CHILD_QUEUE_REQUEST_COALESCED;
+                break;
+#endif
+                default:
+                    u8Held = 0;
+                break;
+            }
+
+            APP_vSendStatus ( ( eAdmit == E_APS_QUEUE_FULL ) ? E_SL_MSG_STATUS_BUSY : E_SL_MSG_STATUS_SUCCESS,
+                              0,
+                              u16RxPacketType,
+                              u8Held,
+                              0 );
+            return;
+        }
+#endif
+        APP_vReplaySerialCommand ( u16RxPacketType, u16RxPacketLength, au8SerialRxFrame );
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vSendStatus
+ *
+ * DESCRIPTION:
+ * Sends the E_SL_MSG_STATUS reply to a host command: status, ZCL sequence
+ * number, command type, whether a request went on air and the APS counter,
+ * followed by the NPDU and ZDP APDU use and, if the host asked for it, the
+ * APS queue depth.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vSendStatus ( uint8     u8Status,
+                              uint8     u8SeqNum,
+                              uint16    u16PacketType,
+                              uint8     u8RequestSent,
+                              uint8     u8SeqApsNum )
+{
+    /* Eight bytes and the queue depth */
+    uint8    au8values[9];
+    uint8    u8Length = 0;
+
+    ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8Status,                 u8Length );
+    ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8SeqNum,                 u8Length );
+    ZNC_BUF_U16_UPD ( &au8values[ u8Length ], u16PacketType,            u8Length );
+    ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8RequestSent,            u8Length );
+    ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8SeqApsNum,              u8Length );
+    ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], PDUM_u8GetNpduUse(),      u8Length );
+    ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8GetApduUsed(apduZDP),   u8Length );
+#ifdef APS_QUEUE
+    u8Length +=  APP_u8ApsQueueWriteDepth ( &au8values[ u8Length ] );
+#endif
+    vSL_WriteMessage ( E_SL_MSG_STATUS,
+                       u8Length,
+                       au8values,
+                       0 );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vReplaySerialCommand
+ *
+ * DESCRIPTION:
+ * Processes one complete host command. The serial receiver assembles frames
+ * in its own buffer so that commands released from the APS admission queue
+ * can be run from here without disturbing a frame still being received.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vReplaySerialCommand ( uint16    u16Type,
+                                       uint16    u16Length,
+                                       uint8*    pu8Payload )
+{
+    u16PacketType      =  u16Type;
+    u16PacketLength    =  u16Length;
+    if ( pu8Payload != au8LinkRxBuffer )
+    {
+        memcpy ( au8LinkRxBuffer, pu8Payload, u16Length );
+    }
+#ifdef PDM_TELEMETRY
+    APP_vPdmTelemetrySetCommandContext ( TRUE );
+#endif
+#ifdef STACK_WATERMARK
+    APP_vStackWatermarkEnter ( STACK_WATERMARK_KIND_COMMAND, u16Type );
+#endif
+    APP_vHandleSerialCommand ( );
+#ifdef STACK_WATERMARK
+    APP_vStackWatermarkExit ( );
+#endif
+#ifdef PDM_TELEMETRY
+    APP_vPdmTelemetrySetCommandContext ( FALSE );
+#endif
+}
+
+PRIVATE void APP_vHandleSerialCommand ( void )
 {
     uint8                  u8SeqNum = 0; // this contains now the APP (zcl, zdp)  sequence number
     uint8                  u8SeqApsNum = 0; // this contains the aps sequence number
@@ -346,19 +523,11 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
     uint8                  u8Status = 0;
     uint16                 u16TargetAddress;
     tsZCL_Address          sAddress;
-    uint8                  au8values[10];
-    uint8                  u8Length = 0;
 #ifdef FULL_FUNC_DEVICE
     tsBDB_ZCLEvent         sEvent;
 #endif
 
-    if( TRUE == bSL_ReadMessage( &u16PacketType,
-                                 &u16PacketLength,
-                                 MAX_PACKET_SIZE,
-                                 au8LinkRxBuffer,
-                                 u8RxByte
-                               )
-      )
+    if ( u16PacketLength < MAX_PACKET_SIZE )
     {
         if (u16PacketType >= E_SL_MSG_AHI_START && u16PacketType <= E_SL_MSG_AHI_END)
         {
@@ -367,22 +536,16 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
             APP_vCMDHandleAHICommand(u16PacketType, u16PacketLength, au8LinkRxBuffer, &u8Status);
             if (u16PacketType == E_SL_MSG_AHI_GET_TX_POWER || u16PacketType == E_SL_MSG_AHI_SET_TX_POWER)
             {
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8Status,      u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8SeqNum,      u8Length );
-                ZNC_BUF_U16_UPD ( &au8values[ u8Length ], u16PacketType, u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8RequestSent, u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8SeqApsNum,   u8Length );
-                vSL_WriteMessage ( E_SL_MSG_STATUS,
-                                   u8Length,
-                                   au8values,
-                                   0 );
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
 
-                uint16 u16ResponseCode = E_SL_MSG_AHI_GET_TX_POWER_RSP;
                 // In case of Set TX power use Get TX power to get current TX level
                 if (u16PacketType == E_SL_MSG_AHI_SET_TX_POWER)
                 {
                     APP_vCMDHandleAHICommand(E_SL_MSG_AHI_GET_TX_POWER, 0, au8LinkRxBuffer, &u8Status);
-                    u16ResponseCode = E_SL_MSG_AHI_SET_TX_POWER_RSP;
                 }
                 // Only return value if command succeed.
                 // TX power value range is 0x00-0xbf so uint8 is big enough
@@ -399,7 +562,7 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                     u8Length = 0;
                     ZNC_BUF_U8_UPD  ( &au8values[ 0 ], u8TXlevelRaw,   u8Length );
                     ZNC_BUF_U8_UPD  ( &au8values[ 1 ], u8TXlevel,      u8Length );
-                    vSL_WriteMessage ( u16ResponseCode,
+                    vSL_WriteMessage ( (u16PacketType == E_SL_MSG_AHI_SET_TX_POWER) ? E_SL_MSG_AHI_SET_TX_POWER_RSP : E_SL_MSG_AHI_GET_TX_POWER_RSP,
                                        u8Length,
                                        au8values,
                                        0);*/
@@ -446,19 +609,11 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 
                 ZNC_BUF_U32_UPD ( &au8Version[ u8L ], u32Version, u8L);
 
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8Status,      u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8SeqNum,      u8Length );
-                ZNC_BUF_U16_UPD ( &au8values[ u8Length ], u16PacketType, u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8RequestSent, u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8SeqApsNum,   u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], PDUM_u8GetNpduUse(),   u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ],  u8GetApduUsed(apduZDP),   u8Length );
-
-
-                vSL_WriteMessage ( E_SL_MSG_STATUS,
-                                   u8Length,
-                                   au8values,
-                                   0 );
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
                 vSL_WriteMessage ( E_SL_MSG_VERSION_LIST,
                                    sizeof ( uint32 ),
 								   au8Version,
@@ -538,19 +693,11 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 			    ZNC_BUF_U32_UPD ( &au8Time[ u8L ], u32Value, u8L);
 
 
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8Status,      u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8SeqNum,      u8Length );
-                ZNC_BUF_U16_UPD ( &au8values[ u8Length ], u16PacketType, u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8RequestSent, u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8SeqApsNum,   u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], PDUM_u8GetNpduUse(),   u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8GetApduUsed(apduZDP),   u8Length );
-
-
-                vSL_WriteMessage ( E_SL_MSG_STATUS,
-                                   u8Length,
-                                   au8values,
-                                   0 );
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
                 vSL_WriteMessage ( E_SL_MSG_GET_TIMESERVER_LIST,
                                                     sizeof ( uint32 ),
 													au8Time,
@@ -579,19 +726,11 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
             case (E_SL_MSG_GET_DISPLAY_ADDRESS_MAP_TABLE):
             {
 
-                ZNC_BUF_U8_UPD  ( &au8values [u8Length ], u8Status,      u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8SeqNum,      u8Length );
-                ZNC_BUF_U16_UPD ( &au8values[ u8Length ], u16PacketType, u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8RequestSent, u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8SeqApsNum,   u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], PDUM_u8GetNpduUse(),   u8Length );
-                ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8GetApduUsed(apduZDP),   u8Length );
-
-
-                vSL_WriteMessage ( E_SL_MSG_STATUS,
-                                   u8Length,
-                                   au8values,
-                                   0 );
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
                 uint16 i = 0;
                 uint16 j = 0;
 
@@ -715,13 +854,16 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 
 				uint32   j = 0;
 				uint64 u64Addr;
-				uint16 u16Length =  0;
-				uint8  au8LinkRxBuffer[10];
+				uint16 u16Length =  1;
+				uint8  au8LinkRxBuffer[250];
 
 				ZPS_tsAplAib * tsAplAib  = ZPS_psAplAibGetAib();
-				ZNC_BUF_U8_UPD   ( &au8LinkRxBuffer [u16Length ], tsAplAib->psAplApsmeAibBindingTable->psAplApsmeBindingTable[0].u32SizeOfBindingTable,      u16Length );
 
-				for( j = 0 ; j < tsAplAib->psAplApsmeAibBindingTable->psAplApsmeBindingTable[0].u32SizeOfBindingTable ; j++ )
+				/* Entries take up to 13 bytes, stop at those that fit and count
+				 * only those sent, the count byte is filled in afterwards */
+				for( j = 0 ; ( j < tsAplAib->psAplApsmeAibBindingTable->psAplApsmeBindingTable[0].u32SizeOfBindingTable ) &&
+				             ( j < 0xFF ) &&
+				             ( ( ( uint32 ) u16Length + 13 ) < sizeof ( au8LinkRxBuffer ) ) ; j++ )
 				{
 					ZNC_BUF_U8_UPD   ( &au8LinkRxBuffer [u16Length ], tsAplAib->psAplApsmeAibBindingTable->psAplApsmeBindingTable[0].pvAplApsmeBindingTableEntryForSpSrcAddr[j].u8DstAddrMode,      u16Length );
 					if (tsAplAib->psAplApsmeAibBindingTable->psAplApsmeBindingTable[0].pvAplApsmeBindingTableEntryForSpSrcAddr[j].u8DstAddrMode == ZPS_E_ADDR_MODE_GROUP)
@@ -738,8 +880,10 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 						ZNC_BUF_U64_UPD   ( &au8LinkRxBuffer [u16Length ], u64Addr,      u16Length );
 						ZNC_BUF_U8_UPD    ( &au8LinkRxBuffer [u16Length ], tsAplAib->psAplApsmeAibBindingTable->psAplApsmeBindingTable[0].pvAplApsmeBindingTableEntryForSpSrcAddr[j].u8SourceEndpoint,      u16Length );
 						ZNC_BUF_U8_UPD    ( &au8LinkRxBuffer [u16Length ], tsAplAib->psAplApsmeAibBindingTable->psAplApsmeBindingTable[0].pvAplApsmeBindingTableEntryForSpSrcAddr[j].u8DestinationEndPoint,      u16Length );
-						ZNC_BUF_U16_UPD   ( &au8LinkRxBuffer [u16Length ], tsAplAib->psAplApsmeAibBindingTable->psAplApsmeBindingTable[0].pvAplApsmeBindingTableEntryForSpSrcAddr[j].u16ClusterId,      u16Length );					}
+						ZNC_BUF_U16_UPD   ( &au8LinkRxBuffer [u16Length ], tsAplAib->psAplApsmeAibBindingTable->psAplApsmeBindingTable[0].pvAplApsmeBindingTableEntryForSpSrcAddr[j].u16ClusterId,      u16Length );
+					}
 				}
+				au8LinkRxBuffer[0] = ( uint8 ) j;
 
 				vSL_WriteMessage ( E_SL_MSG_PDM_GET_BINDING_TABLE_LIST,
 																		   u16Length,
@@ -786,7 +930,8 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 				uint16 u16Length =  0;
 				uint8  au8LinkRxBuffer[1024];
 				uint16 i = 0;
-				for( i=0;i<thisNib->sTblSize.u16Rt;i++)
+				/* Routes take 5 bytes, stop at those that fit */
+				for( i=0;( i<thisNib->sTblSize.u16Rt ) && ( ( ( uint32 ) u16Length + 5 ) < sizeof ( au8LinkRxBuffer ) );i++)
 				{
 					if (thisNib->sTbl.psRt[i].u16NwkDstAddr != 0xfffe)
 					{
@@ -819,7 +964,9 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 				void * thisNet = ZPS_pvAplZdoGetNwkHandle();
 				thisNib = ZPS_psNwkNibGetHandle(thisNet);
 
-				for(i=0;i<(thisNib->sTblSize.u8SecMatSet-1);i++)
+				/* Only the keys that fit */
+				for( i = 0 ; ( ( i + 1 ) < thisNib->sTblSize.u8SecMatSet ) &&
+				             ( ( ( uint32 ) u16Length + 16 ) < sizeof ( au8LinkRxBuffer ) ) ; i++ )
 				{
 					 ZNC_BUF_U8_UPD   ( &au8LinkRxBuffer [u16Length ], thisNib->sTbl.psSecMatSet[i].au8Key[0],      u16Length );
 					 ZNC_BUF_U8_UPD   ( &au8LinkRxBuffer [u16Length ], thisNib->sTbl.psSecMatSet[i].au8Key[1],      u16Length );
@@ -844,6 +991,174 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 																									   0 );
             }
             break;
+#ifdef DEVICE_SNAPSHOT
+            case E_SL_MSG_GET_DEVICE_SNAPSHOT:
+            {
+                uint32    u32BaseGeneration =  0;
+
+                /* Optional base generation: only records changed after it are sent */
+                if ( u16PacketLength >= sizeof ( uint32 ) )
+                {
+                    u32BaseGeneration =  ZNC_RTN_U32 ( au8LinkRxBuffer, 0 );
+                }
+
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                APP_vDeviceSnapshotSend ( u32BaseGeneration );
+                return;
+            }
+            break;
+#endif
+#ifdef PDM_TELEMETRY
+            case E_SL_MSG_GET_PDM_TELEMETRY:
+            {
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Optional options byte, PDM_TELEMETRY_OPTION_RESET clears the counters once reported */
+                APP_vPdmTelemetrySend ( ( u16PacketLength > 0 ) ? au8LinkRxBuffer[0] : 0 );
+                return;
+            }
+            break;
+#endif
+            case E_SL_MSG_GET_BOOT_TIMING:
+            {
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                APP_vBootTimingSend ( );
+                return;
+            }
+            break;
+#ifdef SECLIB_BENCHMARK
+            case E_SL_MSG_SECLIB_BENCHMARK:
+            {
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Optional iteration count, 0 selects the default */
+                APP_vSecLibBenchmarkRun ( ( u16PacketLength >= sizeof ( uint16 ) ) ? ZNC_RTN_U16 ( au8LinkRxBuffer, 0 ) : 0 );
+                return;
+            }
+            break;
+#endif
+#ifdef ZCL_BENCHMARK
+            case E_SL_MSG_ZCL_BENCHMARK:
+            {
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Optional iteration count, 0 selects the default */
+                APP_vZclBenchmarkRun ( ( u16PacketLength >= sizeof ( uint16 ) ) ? ZNC_RTN_U16 ( au8LinkRxBuffer, 0 ) : 0 );
+                return;
+            }
+            break;
+#endif
+#ifdef OTA_FLEET
+            case E_SL_MSG_GET_OTA_FLEET_STATS:
+            {
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Optional options byte, OTA_FLEET_OPTION_RESET clears the counters once reported */
+                APP_vOtaFleetSendStats ( ( u16PacketLength > 0 ) ? au8LinkRxBuffer[0] : 0 );
+                return;
+            }
+            break;
+#endif
+            case E_SL_MSG_GET_OTA_BLOCK_SIZE:
+            {
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Destination address then an optional options byte, bit 0 clears the counters */
+                APP_vOtaServerSendBlockSize ( ( u16PacketLength >= 2 ) ? ZNC_RTN_U16 ( au8LinkRxBuffer, 0 ) : 0,
+                                              ( u16PacketLength >= 3 ) ? au8LinkRxBuffer[2] : 0 );
+                return;
+            }
+            break;
+#ifdef OTA_STORE
+            case E_SL_MSG_OTA_STORE:
+            {
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Operation byte first, the store answers with E_SL_MSG_OTA_STORE_RESPONSE */
+                APP_vOtaStoreCommand ( au8LinkRxBuffer, u16PacketLength );
+                return;
+            }
+            break;
+#endif
+#ifdef BEACON_FILTER
+            case E_SL_MSG_BEACON_FILTER:
+            {
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Operation byte first, answered with E_SL_MSG_BEACON_FILTER_RESPONSE */
+                APP_vBeaconFilterCommand ( au8LinkRxBuffer, u16PacketLength );
+                return;
+            }
+            break;
+#endif
+#ifdef CHANNEL_QUALITY
+            case E_SL_MSG_CHANNEL_QUALITY:
+            {
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Operation byte first, answered with E_SL_MSG_CHANNEL_QUALITY_RESPONSE */
+                APP_vChannelQualityCommand ( au8LinkRxBuffer, u16PacketLength );
+                return;
+            }
+            break;
+#endif
+#ifdef STACK_WATERMARK
+            case E_SL_MSG_STACK_WATERMARK:
+            {
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Operation byte first, answered with E_SL_MSG_STACK_WATERMARK_RESPONSE */
+                APP_vStackWatermarkCommand ( au8LinkRxBuffer, u16PacketLength );
+                return;
+            }
+            break;
+#endif
             case (E_SL_MSG_BIND_GROUP):
             {
                 uint16    u16Clusterid;
@@ -1081,8 +1396,12 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
             case (E_SL_MSG_SEND_RAW_APS_DATA_PACKET):
             {
                 ZPS_tsAfProfileDataReq    sAfProfileDataReq;
-                uint8                     u8DataLength;
+                uint16                    u16DataLength;
 
+                /* The payload length travels in one byte, so a raw APS
+                 * payload is bounded by the apduZDP size (200) rather than
+                 * by the 255 the field could carry; longer ones are
+                 * refused with E_ZCL_ERR_ZBUFFER_FAIL */
 				if ((au8LinkRxBuffer[0]== E_ZCL_AM_IEEE) || (au8LinkRxBuffer[0]== E_ZCL_AM_IEEE_NO_ACK))
 				{
 					sAfProfileDataReq.uDstAddr.u64Addr    =  ZNC_RTN_U64 ( au8LinkRxBuffer, 1 );
@@ -1093,10 +1412,15 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 					sAfProfileDataReq.u8DstEp             =  au8LinkRxBuffer[10];
 					sAfProfileDataReq.eSecurityMode       =  au8LinkRxBuffer[15];
 					sAfProfileDataReq.u8Radius            =  au8LinkRxBuffer[16];
-					u8DataLength                          =  au8LinkRxBuffer[17];
+					u16DataLength                         =  au8LinkRxBuffer[17];
+					if ( u16PacketLength < ( 18 + u16DataLength ) )
+					{
+						u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+						break;
+					}
 					 u8Status      =  APP_eApsProfileDataRequest ( &sAfProfileDataReq,
 																					  &au8LinkRxBuffer[18],
-																					  u8DataLength,
+																					  u16DataLength,
 																					  &u8SeqNum );
 				}else{
 
@@ -1108,10 +1432,15 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 					sAfProfileDataReq.u8DstEp             =  au8LinkRxBuffer[4];
 					sAfProfileDataReq.eSecurityMode       =  au8LinkRxBuffer[9];
 					sAfProfileDataReq.u8Radius            =  au8LinkRxBuffer[10];
-					u8DataLength                          =  au8LinkRxBuffer[11];
+					u16DataLength                         =  au8LinkRxBuffer[11];
+					if ( u16PacketLength < ( 12 + u16DataLength ) )
+					{
+						u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+						break;
+					}
 					u8Status      =  APP_eApsProfileDataRequest( &sAfProfileDataReq,
 																					  &au8LinkRxBuffer[12],
-																					  u8DataLength,
+																					  u16DataLength,
 																					  &u8SeqNum );
 				}
 
@@ -1121,6 +1450,50 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 				u8RequestSent = 1;
             }
             break;
+
+            case (E_SL_MSG_GET_APS_FRAGMENTATION_INFO):
+            {
+                uint8    au8Info[32];
+                uint8    u8InfoLength =  0;
+                uint8    u8ApduUsed   =  u8GetApduUsed ( apduZDP );
+
+                if ( u8ApduUsed > sApsFragmentationStats.u8ApduPeakUsed )
+                {
+                    sApsFragmentationStats.u8ApduPeakUsed =  u8ApduUsed;
+                }
+
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                ZNC_BUF_U8_UPD  ( &au8Info[ u8InfoLength ], ZPS_bAplDoesDeviceSupportFragmentation ( ZPS_pvAplZdoGetAplHandle ( ) ), u8InfoLength );
+                ZNC_BUF_U8_UPD  ( &au8Info[ u8InfoLength ], ZPS_bIsFragmentationEngineActive ( ),              u8InfoLength );
+                ZNC_BUF_U8_UPD  ( &au8Info[ u8InfoLength ], ZPS_psAplAibGetAib ( )->u8ApsMaxWindowSize,        u8InfoLength );
+                ZNC_BUF_U16_UPD ( &au8Info[ u8InfoLength ], PDUM_u16APduGetSize ( apduZDP ),                   u8InfoLength );
+                ZNC_BUF_U8_UPD  ( &au8Info[ u8InfoLength ], ( apduZDP )->u16NumInstances,                          u8InfoLength );
+                ZNC_BUF_U8_UPD  ( &au8Info[ u8InfoLength ], u8ApduUsed,                                        u8InfoLength );
+                ZNC_BUF_U8_UPD  ( &au8Info[ u8InfoLength ], sApsFragmentationStats.u8ApduPeakUsed,             u8InfoLength );
+                ZNC_BUF_U32_UPD ( &au8Info[ u8InfoLength ], sApsFragmentationStats.u32TxFragmentedCount,       u8InfoLength );
+                ZNC_BUF_U32_UPD ( &au8Info[ u8InfoLength ], sApsFragmentationStats.u32TxFragmentedBytes,       u8InfoLength );
+                ZNC_BUF_U32_UPD ( &au8Info[ u8InfoLength ], sApsFragmentationStats.u32TxTooLongCount,          u8InfoLength );
+                ZNC_BUF_U32_UPD ( &au8Info[ u8InfoLength ], sApsFragmentationStats.u32RxReassembledCount,      u8InfoLength );
+                ZNC_BUF_U32_UPD ( &au8Info[ u8InfoLength ], sApsFragmentationStats.u32RxReassembledBytes,      u8InfoLength );
+                ZNC_BUF_U16_UPD ( &au8Info[ u8InfoLength ], sApsFragmentationStats.u16RxLargestPayload,        u8InfoLength );
+                vSL_WriteMessage ( E_SL_MSG_APS_FRAGMENTATION_INFO_RESPONSE,
+                                   u8InfoLength,
+                                   au8Info,
+                                   0 );
+
+                /* Optional first byte set to 1 clears the counters once reported */
+                if ( ( u16PacketLength > 0 ) && ( au8LinkRxBuffer[0] == 1 ) )
+                {
+                    memset ( &sApsFragmentationStats, 0, sizeof ( tsApsFragmentationStats ) );
+                }
+                return;
+            }
+            break;
 #ifdef LEGACY_SUPPORT
             case (E_SL_MSG_COMPLEX_DESCRIPTOR_REQUEST):
             {
@@ -1143,8 +1516,22 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                 uint16    u16Profile;
                 uint8     i                 =  0 ;
                 uint8     u8InClusterCount  =  au8LinkRxBuffer [ 4 ];
-                uint8     u8OutClusterCount =  au8LinkRxBuffer [ ( ( au8LinkRxBuffer [ 4 ] *
-                                                                 ( sizeof ( uint16 ) ) ) + 5) ];
+                uint8     u8OutClusterCount;
+
+                /* Both counts go to the ZDP with the lists, so they cannot exceed them */
+                if ( ( u8InClusterCount > 10 ) ||
+                     ( u16PacketLength < ( 6 + ( u8InClusterCount * 2 ) ) ) )
+                {
+                    u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+                    break;
+                }
+                u8OutClusterCount =  au8LinkRxBuffer [ ( ( u8InClusterCount * ( sizeof ( uint16 ) ) ) + 5) ];
+                if ( ( u8OutClusterCount > 10 ) ||
+                     ( u16PacketLength < ( 6 + ( ( u8InClusterCount + u8OutClusterCount ) * 2 ) ) ) )
+                {
+                    u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+                    break;
+                }
 
                 u16TargetAddress    =  ZNC_RTN_U16 ( au8LinkRxBuffer, 0 );
                 u16Profile          =  ZNC_RTN_U16 ( au8LinkRxBuffer, 2 );
@@ -1623,6 +2010,13 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 					uint16                                           au16GroupList [ 10 ];
 					uint8                                            i = 0 ;
 
+					if ( ( au8LinkRxBuffer [ 5 ] > 10 ) ||
+					     ( u16PacketLength < ( 6 + ( au8LinkRxBuffer [ 5 ] * 2 ) ) ) )
+					{
+						u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+						break;
+					}
+
 					while ( ( i < 10 ) &&
 							( i < au8LinkRxBuffer [ 5 ] ) )
 					{
@@ -1655,6 +2049,18 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                 sRequest.sSceneName.u8Length       =  au8LinkRxBuffer[10];
                 sRequest.sSceneName.u8MaxLength    =  au8LinkRxBuffer[11];
 
+                /* The name is sent from au8Data, so it cannot be longer */
+                if ( ( sRequest.sSceneName.u8Length > sizeof ( au8Data ) ) ||
+                     ( u16PacketLength < ( 12 + sRequest.sSceneName.u8Length ) ) )
+                {
+                    u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+                    break;
+                }
+                if ( sRequest.sSceneName.u8MaxLength > sizeof ( au8Data ) )
+                {
+                    sRequest.sSceneName.u8MaxLength =  sizeof ( au8Data );
+                }
+
                 while ( ( i < 16 ) &&
                         ( i < sRequest.sSceneName.u8Length ) )
                 {
@@ -1760,6 +2166,12 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                 sRequest.sExtensionField.u16Length    =  ZNC_RTN_U16 ( au8LinkRxBuffer, 9 );
                 sRequest.sExtensionField.u16MaxLength =  ZNC_RTN_U16 ( au8LinkRxBuffer, 11 );
                 sRequest.sExtensionField.pu8Data      =  &au8LinkRxBuffer[ 12 ];
+                if ( ( u16PacketLength < 12 ) ||
+                     ( sRequest.sExtensionField.u16Length > ( u16PacketLength - 12 ) ) )
+                {
+                    u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+                    break;
+                }
                 u8Status    =  eCLD_ScenesCommandEnhancedAddSceneRequestSend ( au8LinkRxBuffer [ 3 ],
                                                                                au8LinkRxBuffer [ 4 ],
                                                                                &sAddress,
@@ -2319,6 +2731,14 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                 uint16    u16ManId;
                 uint8     i = 0;
 
+                /* The count goes to the ZCL with the list, so it cannot exceed it */
+                if ( ( u16PacketLength < 12 ) ||
+                     ( au8LinkRxBuffer[11] > 10 ) ||
+                     ( u16PacketLength < ( 12 + ( au8LinkRxBuffer[11] * 2 ) ) ) )
+                {
+                    u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+                    break;
+                }
 
                 u16ClusterId    =  ZNC_RTN_U16 (au8LinkRxBuffer, 5 );
                 u16ManId    =  ZNC_RTN_U16 (au8LinkRxBuffer, 9 );
@@ -2331,6 +2751,34 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                     i++;
                 }
 
+#ifdef ATTRIBUTE_CACHE
+                /* Standard server attributes of one device, all held: answered without going on air */
+                if ( ( ( au8LinkRxBuffer[0] == E_ZCL_AM_SHORT ) || ( au8LinkRxBuffer[0] == E_ZCL_AM_SHORT_NO_ACK ) ) &&
+                     ( au8LinkRxBuffer[7] == 0 ) &&
+                     ( au8LinkRxBuffer[8] == 0 ) &&
+                     APP_bAttributeCacheLookup ( u16TargetAddress,
+                                                 au8LinkRxBuffer [ 4 ],
+                                                 u16ClusterId,
+                                                 au8LinkRxBuffer [ 11 ],
+                                                 au16AttributeList ) )
+                {
+                    u8SeqNum =  u8GetTransactionSequenceNumber ( );
+
+                    APP_vSendStatus ( u8Status,
+                                      u8SeqNum,
+                                      u16PacketType,
+                                      ATTRIBUTE_CACHE_REQUEST_SERVED,
+                                      u8SeqApsNum );
+
+                    APP_vAttributeCacheSend ( u16TargetAddress,
+                                              au8LinkRxBuffer [ 4 ],
+                                              u16ClusterId,
+                                              au8LinkRxBuffer [ 11 ],
+                                              au16AttributeList,
+                                              u8SeqNum );
+                    return;
+                }
+#endif
                 u8Status    =  eZCL_SendReadAttributesRequest ( au8LinkRxBuffer [ 3 ],
                                                                 au8LinkRxBuffer [ 4 ],
                                                                 u16ClusterId,
@@ -2352,11 +2800,17 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                 uint16    u16ManId;
                 uint16    u16SizePayload;
 
-
-
+                if ( u16PacketLength < 12 )
+                {
+                    u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+                    break;
+                }
 
                 u16ClusterId      =  ZNC_RTN_U16 ( au8LinkRxBuffer, 5 );
                 u16ManId          =  ZNC_RTN_U16 ( au8LinkRxBuffer, 9 );
+#ifdef ATTRIBUTE_CACHE
+                APP_vAttributeCacheInvalidate ( u16TargetAddress, au8LinkRxBuffer [ 4 ], u16ClusterId );
+#endif
 
 
                 /* payload - sum of add mode , short addr, cluster id, manf id, manf specific flag */
@@ -2386,12 +2840,17 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 				uint16    u16ManId;
 				uint16    u16SizePayload;
 
-
-
+				if ( u16PacketLength < 12 )
+				{
+					u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+					break;
+				}
 
 				u16ClusterId      =  ZNC_RTN_U16 ( au8LinkRxBuffer, 5 );
 				u16ManId          =  ZNC_RTN_U16 ( au8LinkRxBuffer, 9 );
-
+#ifdef ATTRIBUTE_CACHE
+				APP_vAttributeCacheInvalidate ( u16TargetAddress, au8LinkRxBuffer [ 4 ], u16ClusterId );
+#endif
 
 				/* payload - sum of add mode , short addr, cluster id, manf id, manf specific flag */
 				/* src ep,  dest ep, num attrib , direction*/
@@ -2470,14 +2929,21 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                 int                                            i;
                 uint8                                          u8Offset = 12;
 
+                /* The count goes to the ZCL with the records, so it cannot exceed them */
+                if ( ( u16PacketLength < 12 ) ||
+                     ( au8LinkRxBuffer[11] > 10 ) )
+                {
+                    u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+                    break;
+                }
+
                 u16ClusterId      =  ZNC_RTN_U16 ( au8LinkRxBuffer, 5 );
                 u16ManId          =  ZNC_RTN_U16 ( au8LinkRxBuffer, 9 );
 
 
                 for (i = 0; i < au8LinkRxBuffer[11]; i++)
                 {
-                	if ( ( i < 10 )  &&
-                	     ( u8Offset < 256 ) )
+                	if ( i < 10 )
                     {
                     /* Destination structure is not packed so we have to manually load rather than just copy */
                         asAttribReportConfigRecord [ i ].u8DirectionIsReceived          =  au8LinkRxBuffer [ u8Offset++ ];
@@ -2591,6 +3057,125 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                 u8RequestSent = 1;
             }
             break;
+#ifdef REPORT_FILTER
+            case E_SL_MSG_REPORT_FILTER_SET_RULE:
+            {
+                u8Status =  APP_u8ReportFilterSetRule ( au8LinkRxBuffer, u16PacketLength );
+            }
+            break;
+
+            case E_SL_MSG_REPORT_FILTER_GET_STATS:
+            {
+                uint8     au8Stats[32];
+                uint16    u16StatsLength;
+
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Optional first byte set to 1 clears the counters once reported */
+                u16StatsLength =  APP_u16ReportFilterGetStats ( au8Stats,
+                                                                ( ( u16PacketLength > 0 ) && ( au8LinkRxBuffer[0] == 1 ) ) );
+                vSL_WriteMessage ( E_SL_MSG_REPORT_FILTER_STATS,
+                                   u16StatsLength,
+                                   au8Stats,
+                                   0 );
+                return;
+            }
+            break;
+#endif
+#ifdef ATTRIBUTE_CACHE
+            case E_SL_MSG_ATTRIBUTE_CACHE_SET_RULE:
+            {
+                u8Status =  APP_u8AttributeCacheSetRule ( au8LinkRxBuffer, u16PacketLength );
+            }
+            break;
+
+            case E_SL_MSG_ATTRIBUTE_CACHE_GET_STATS:
+            {
+                uint8     au8Stats[32];
+                uint16    u16StatsLength;
+
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Optional first byte set to 1 clears the counters once reported */
+                u16StatsLength =  APP_u16AttributeCacheGetStats ( au8Stats,
+                                                                  ( ( u16PacketLength > 0 ) && ( au8LinkRxBuffer[0] == 1 ) ) );
+                vSL_WriteMessage ( E_SL_MSG_ATTRIBUTE_CACHE_STATS,
+                                   u16StatsLength,
+                                   au8Stats,
+                                   0 );
+                return;
+            }
+            break;
+#endif
+#ifdef APS_QUEUE
+            case E_SL_MSG_APS_QUEUE_REPORT_DEPTH:
+            {
+                u8Status =  APP_u8ApsQueueSetReportDepth ( au8LinkRxBuffer, u16PacketLength );
+            }
+            break;
+#endif
+#ifdef CHILD_QUEUE
+            case E_SL_MSG_CHILD_QUEUE_SET_EXPIRY:
+            {
+                u8Status =  APP_u8ChildQueueSetExpiry ( au8LinkRxBuffer, u16PacketLength );
+            }
+            break;
+
+            case E_SL_MSG_CHILD_QUEUE_GET_STATS:
+            {
+                uint8     au8Stats[256];
+                uint16    u16StatsLength;
+
+                APP_vSendStatus ( u8Status,
+                                  u8SeqNum,
+                                  u16PacketType,
+                                  u8RequestSent,
+                                  u8SeqApsNum );
+
+                /* Optional first byte set to 1 clears the counters once reported */
+                u16StatsLength =  APP_u16ChildQueueGetStats ( au8Stats,
+                                                              sizeof ( au8Stats ),
+                                                              ( ( u16PacketLength > 0 ) && ( au8LinkRxBuffer[0] == 1 ) ) );
+                vSL_WriteMessage ( E_SL_MSG_CHILD_QUEUE_STATS,
+                                   u16StatsLength,
+                                   au8Stats,
+                                   0 );
+                return;
+            }
+            break;
+#endif
+#ifdef DEVICE_INTERVIEW
+            case E_SL_MSG_DEVICE_INTERVIEW_START:
+            {
+                uint64    u64IeeeAddr;
+
+                /* u16ShortAddress, u8Capability as in the device announce */
+                if ( u16PacketLength < 3 )
+                {
+                    u8Status =  E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+                    break;
+                }
+                u16TargetAddress =  ZNC_RTN_U16 ( au8LinkRxBuffer, 0 );
+                u64IeeeAddr      =  ZPS_u64AplZdoLookupIeeeAddr ( u16TargetAddress );
+                if ( u64IeeeAddr == 0 )
+                {
+                    u8Status =  E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+                }
+                else if ( !APP_bDeviceInterviewStart ( u16TargetAddress, u64IeeeAddr, au8LinkRxBuffer[2] ) )
+                {
+                    u8Status =  E_SL_MSG_STATUS_BUSY;
+                }
+            }
+            break;
+#endif
             case E_SL_MSG_READ_REPORT_CONFIG_REQUEST:
             {
                 uint8                                               i;
@@ -2601,6 +3186,12 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                 uint8                                               u8BufferOffset = 12;
 
                 u8NumberOfAttributesInRequest    =  au8LinkRxBuffer[8];
+                if ( ( u8NumberOfAttributesInRequest > 8 ) ||
+                     ( u16PacketLength < ( 12 + ( u8NumberOfAttributesInRequest * 3 ) ) ) )
+                {
+                    u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+                    break;
+                }
                 u16ClusterId                     =  ZNC_RTN_U16 ( au8LinkRxBuffer, 5  );
                 u16ManufacturerCode              =  ZNC_RTN_U16 ( au8LinkRxBuffer, 10 );
 
@@ -2675,30 +3266,52 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                     break;
 
                     case (E_CLD_WC_CMD_GO_TO_LIFT_VALUE):
+                    {
+                    	tsCLD_WindowCovering_GoToLiftValuePayload sGoToValueRequestPayload;
+                        sGoToValueRequestPayload.u16LiftValue = ZNC_RTN_U16 ( au8LinkRxBuffer, 6 );
+                        u8Status    = eCLD_WindowCoveringCommandGoToLiftValueSend ( au8LinkRxBuffer [ 3 ],       // u8SourceEndPointId,
+                                                                                       au8LinkRxBuffer [ 4 ],       // u8DestinationEndPointId,
+                                                                                       &sAddress,                   // *psDestinationAddress,
+                                                                                       &u8SeqNum,                   // *pu8TransactionSequenceNumber,
+                                                                                       &sGoToValueRequestPayload ); // *psGoToValueRequestPayload);
+                        u8RequestSent = 1;
+                    }
+                    break;
+
                     case (E_CLD_WC_CMD_GO_TO_TILT_VALUE):
                     {
                     	tsCLD_WindowCovering_GoToTiltValuePayload sGoToValueRequestPayload;
                         sGoToValueRequestPayload.u16TiltValue = ZNC_RTN_U16 ( au8LinkRxBuffer, 6 );
-                        u8Status    = eCLD_WindowCoveringCommandGoToLiftValueSend ( au8LinkRxBuffer [ 3 ],       // u8SourceEndPointId,
+                        u8Status    = eCLD_WindowCoveringCommandGoToTiltValueSend ( au8LinkRxBuffer [ 3 ],       // u8SourceEndPointId,
                                                                                        au8LinkRxBuffer [ 4 ],       // u8DestinationEndPointId,
                                                                                        &sAddress,                   // *psDestinationAddress,
                                                                                        &u8SeqNum,                   // *pu8TransactionSequenceNumber,
-                                                                                       //au8LinkRxBuffer [ 5 ],       // u8CommandId
                                                                                        &sGoToValueRequestPayload ); // *psGoToValueRequestPayload);
                         u8RequestSent = 1;
                     }
                     break;
 
                     case (E_CLD_WC_CMD_GO_TO_LIFT_PERCENTAGE):
+                    {
+                    	tsCLD_WindowCovering_GoToLiftPercentagePayload sGoToPercentageRequestPayload;
+                        sGoToPercentageRequestPayload.u8LiftPercentage = au8LinkRxBuffer[6];
+                        u8Status    = eCLD_WindowCoveringCommandGoToLiftPercentageSend ( au8LinkRxBuffer [ 3 ],            // u8SourceEndPointId,
+                                                                                            au8LinkRxBuffer [ 4 ],            // u8DestinationEndPointId,
+                                                                                            &sAddress,                        // *psDestinationAddress,
+                                                                                            &u8SeqNum,                        // *pu8TransactionSequenceNumber,
+                                                                                            &sGoToPercentageRequestPayload ); // *sGoToPercentageRequestPayload);
+                        u8RequestSent = 1;
+                    }
+                    break;
+
                     case (E_CLD_WC_CMD_GO_TO_TILT_PERCENTAGE):
                     {
                     	tsCLD_WindowCovering_GoToTiltPercentagePayload sGoToPercentageRequestPayload;
                         sGoToPercentageRequestPayload.u8TiltPercentage = au8LinkRxBuffer[6];
-                        u8Status    = eCLD_WindowCoveringCommandGoToLiftPercentageSend ( au8LinkRxBuffer [ 3 ],            // u8SourceEndPointId,
+                        u8Status    = eCLD_WindowCoveringCommandGoToTiltPercentageSend ( au8LinkRxBuffer [ 3 ],            // u8SourceEndPointId,
                                                                                             au8LinkRxBuffer [ 4 ],            // u8DestinationEndPointId,
                                                                                             &sAddress,                        // *psDestinationAddress,
                                                                                             &u8SeqNum,                        // *pu8TransactionSequenceNumber,
-                                                                                            //au8LinkRxBuffer [ 5 ],            // u8CommandId
                                                                                             &sGoToPercentageRequestPayload ); // *sGoToPercentageRequestPayload);
                         u8RequestSent = 1;
                     }
@@ -2833,6 +3446,19 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                 sImageBlockResponsePayload.uMessage.sBlockPayloadSuccess.u16ManufacturerCode     =  ZNC_RTN_U16 ( au8LinkRxBuffer, 17 );
                 sImageBlockResponsePayload.uMessage.sBlockPayloadSuccess.u8DataSize              =  au8LinkRxBuffer[19];
                 sImageBlockResponsePayload.uMessage.sBlockPayloadSuccess.pu8Data                 =  &au8LinkRxBuffer[20];
+                if ( ( sImageBlockResponsePayload.u8Status == OTA_STATUS_SUCCESS ) &&
+                     ( u16PacketLength < ( 20 + sImageBlockResponsePayload.uMessage.sBlockPayloadSuccess.u8DataSize ) ) )
+                {
+                    u8Status = E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+                    break;
+                }
+
+                /* Hosts sizing blocks themselves may exceed what fits in one frame to this client */
+                if ( ( sImageBlockResponsePayload.u8Status == OTA_STATUS_SUCCESS ) &&
+                     ( sImageBlockResponsePayload.uMessage.sBlockPayloadSuccess.u8DataSize > APP_u8OtaServerBlockLimit ( sAddress.uAddress.u16DestinationAddress ) ) )
+                {
+                    sImageBlockResponsePayload.uMessage.sBlockPayloadSuccess.u8DataSize =  APP_u8OtaServerBlockLimit ( sAddress.uAddress.u16DestinationAddress );
+                }
 
                 vLog_Printf ( TRACE_APP, LOG_DEBUG, "\nE_SL_MSG_BLOCK_SEND");
                 vLog_Printf ( TRACE_APP, LOG_DEBUG, "\nAddr Mode: %x", sAddress.eAddressMode);
@@ -2852,6 +3478,12 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                                                              &sImageBlockResponsePayload,                                            // *psImageBlockResponsePayload
                                                              sImageBlockResponsePayload.uMessage.sBlockPayloadSuccess.u8DataSize,    //    u8BlockSize
                                                              au8LinkRxBuffer[5] );                                                   //  u8TransactionSequenceNumber
+#ifdef OTA_FLEET
+                APP_vOtaFleetBlockReceived ( sAddress.uAddress.u16DestinationAddress,
+                                             &sImageBlockResponsePayload,
+                                             u16PacketLength,
+                                             ( u8Status == E_ZCL_SUCCESS ) );
+#endif
             }
             break;
 
@@ -2898,6 +3530,12 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                 vLog_Printf ( TRACE_APP, LOG_DEBUG, "\nMaxHwVersion: %x", sCoProcessorOTAHeader.sOTA_ImageHeader[0].u16MaxHwVersion);
 
                 u8Status    =  eOTA_NewImageLoaded(CONTROLBRIDGE_ZLO_ENDPOINT, TRUE, &sCoProcessorOTAHeader);
+#ifdef OTA_STORE
+                APP_vOtaStoreHostImageLoaded ( );
+#endif
+#ifdef OTA_FLEET
+                APP_vOtaFleetReset ( );
+#endif
             }
             break;
 
@@ -2942,14 +3580,22 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
                 break;
             }
         }
+#ifdef APS_QUEUE
+        if ( ( u8RequestSent != 0 ) && ( u8Status == E_SL_MSG_STATUS_SUCCESS ) )
+        {
+            uint8    u8LastApsSeqNum = ( ( zps_tsApl* ) ZPS_pvAplZdoGetAplHandle ( ) )->sApsContext.u8SeqNum - 1;
+
+            APP_vApsQueueRequestSent ( u8LastApsSeqNum, u16PacketType, au8LinkRxBuffer );
+#ifdef CHILD_QUEUE
+            APP_vChildQueueRequestSent ( u8LastApsSeqNum, u16PacketType, u16PacketLength, au8LinkRxBuffer );
+#endif
+        }
+#endif
         //PDM Messages
         if (u16PacketType < 0x8200 || u16PacketType > 0x8300)
         {
             //vLog_Printf(TRACE_APP,LOG_DEBUG, "\nPacket Type %x \n",u16PacketType );
 
-			u8Length    =  0;
-
-
 			//if (u8RequestSent == 1){
 				//u8SeqApsNum = u8ZCL_GetApsSequenceNumberOfLastTransmit ();
 				//zps_tsApl *  s_sApl = ( zps_tsApl * ) ZPS_pvAplZdoGetAplHandle ();
@@ -2966,18 +3612,11 @@ PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte )
 				zps_tsApl *  s_sApl = ( zps_tsApl * ) ZPS_pvAplZdoGetAplHandle ();
 				u8SeqApsNum =s_sApl->sApsContext.u8SeqNum-1;
 			//}
-			ZNC_BUF_U8_UPD  ( &au8values [ u8Length ], u8Status,      u8Length );
-			ZNC_BUF_U8_UPD  ( &au8values [ u8Length ], u8SeqNum,      u8Length );
-			ZNC_BUF_U16_UPD ( &au8values [ u8Length ], u16PacketType, u8Length );
-            ZNC_BUF_U8_UPD  ( &au8values [ u8Length ], u8RequestSent, u8Length );
-            ZNC_BUF_U8_UPD  ( &au8values [ u8Length ], u8SeqApsNum,   u8Length );
-            ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], PDUM_u8GetNpduUse(),   u8Length );
-            ZNC_BUF_U8_UPD  ( &au8values[ u8Length ], u8GetApduUsed(apduZDP),   u8Length );
-
-            vSL_WriteMessage ( E_SL_MSG_STATUS,
-							   u8Length,
-							   au8values,
-							   0 );
+			APP_vSendStatus ( u8Status,
+			                  u8SeqNum,
+			                  u16PacketType,
+			                  u8RequestSent,
+			                  u8SeqApsNum );
         }
 
     }
@@ -3327,8 +3966,8 @@ PRIVATE ZPS_teStatus APP_eZdpRemoveDeviceReq ( ZPS_tuAddress    uParentAddress,
  *
  *
  ****************************************************************************/
-PRIVATE ZPS_teStatus APP_eZdpNodeDescReq ( uint16    u16Addr,
-                                           uint8*    pu8SeqNum )
+PUBLIC ZPS_teStatus APP_eZdpNodeDescReq ( uint16    u16Addr,
+                                          uint8*    pu8SeqNum )
 {
     PDUM_thAPduInstance    hAPduInst;
     ZPS_teStatus eStatus = ZPS_APL_APS_E_INVALID_PARAMETER;
@@ -3406,9 +4045,9 @@ PRIVATE ZPS_teStatus APP_eZdpPowerDescReq ( uint16    u16Addr,
  *
  *
  ****************************************************************************/
-PRIVATE ZPS_teStatus APP_eZdpSimpleDescReq ( uint16    u16Addr,
-                                             uint8     u8Endpoint,
-                                             uint8*    pu8Seq )
+PUBLIC ZPS_teStatus APP_eZdpSimpleDescReq ( uint16    u16Addr,
+                                            uint8     u8Endpoint,
+                                            uint8*    pu8Seq )
 {
     PDUM_thAPduInstance    hAPduInst;
     ZPS_teStatus eStatus = ZPS_APL_APS_E_INVALID_PARAMETER;
@@ -3448,8 +4087,8 @@ PRIVATE ZPS_teStatus APP_eZdpSimpleDescReq ( uint16    u16Addr,
  *
  *
  ****************************************************************************/
-PRIVATE ZPS_teStatus APP_eZdpActiveEndpointReq ( uint16    u16Addr,
-                                                 uint8*    pu8SeqNum )
+PUBLIC ZPS_teStatus APP_eZdpActiveEndpointReq ( uint16    u16Addr,
+                                                uint8*    pu8SeqNum )
 {
     PDUM_thAPduInstance    hAPduInst;
     ZPS_teStatus eStatus = ZPS_APL_APS_E_INVALID_PARAMETER;
@@ -3871,6 +4510,14 @@ PRIVATE void APP_vControlNodeStartNetwork(void)
 #endif
             }
             sBDB.sAttrib.u8bdbCommissioningMode =  BDB_COMMISSIONING_MODE_NWK_FORMATION;
+#ifdef BEACON_FILTER
+            /* Keep clear of channels the last scan found crowded */
+            sBDB.sAttrib.u32bdbPrimaryChannelSet =  APP_u32BeaconFilterQuietChannels ( sBDB.sAttrib.u32bdbPrimaryChannelSet );
+#endif
+#ifdef CHANNEL_QUALITY
+            /* Then settle on the channel with the best delivery history */
+            sBDB.sAttrib.u32bdbPrimaryChannelSet =  APP_u32ChannelQualityPreferred ( sBDB.sAttrib.u32bdbPrimaryChannelSet );
+#endif
             u8Status =  BDB_eNfStartNwkFormation();
             if ( BDB_E_SUCCESS != u8Status )
             {
@@ -4401,20 +5048,11 @@ PUBLIC  teZCL_Status  APP_eSendWriteAttributesRequest ( uint8               u8So
         if (pu8AttributeRequestList [ i + 2 ] == 0x42)
         {
         	uint16 u16StringSize;
-        	uint16 j;
         	u16StringSize= pu8AttributeRequestList [ i + 3 ];
 			u16offset     +=  APP_u16ZncWriteDataPattern ( &pu8Data [ u16offset ],
-			        														E_ZCL_UINT8,
-			        														&pu8AttributeRequestList [ i + 3 ],
-																		   1 );
-        	for (j=0;j<u16StringSize;j++)
-        	{
-
-        		u16offset     +=  APP_u16ZncWriteDataPattern ( &pu8Data [ u16offset ],
-        														E_ZCL_UINT8,
-															   &pu8AttributeRequestList [ i + j + 4 ],
-															   1 );
-        	}
+			                                               E_ZCL_CSTRING,
+			                                               &pu8AttributeRequestList [ i + 3 ],
+			                                               u16Size + u16StringSize );
         	i              =  i + u16Size + 3 + u16StringSize;
 
         }else{
@@ -4682,17 +5320,32 @@ void APP_vSaveAllRecords ( void )
  ****************************************************************************/
 PRIVATE ZPS_teStatus APP_eApsProfileDataRequest ( ZPS_tsAfProfileDataReq*    psProfileDataReq,
                                                   uint8*                     pu8Data,
-                                                  uint8                     u8DataLength,
+                                                  uint16                     u16DataLength,
                                                   uint8*                     pu8Seq  )
 {
     PDUM_thAPduInstance    hAPduInst = PDUM_INVALID_HANDLE;
     ZPS_teStatus           eStatus =  ZPS_APL_APS_E_INVALID_PARAMETER;
+    uint8                  u8MaxPayload;
+    uint8                  u8ApduUsed;
 
-    if (u8DataLength > PDUM_u16APduGetSize(apduZDP) )
+    u8MaxPayload =  APP_u8ApsMaxPayloadSize ( psProfileDataReq->eDstAddrMode,
+                                              &psProfileDataReq->uDstAddr );
+
+    if (u16DataLength > PDUM_u16APduGetSize(apduZDP) )
     {
         vLog_Printf(TRACE_APP,LOG_DEBUG, "APDU too small \n");
         eStatus =  E_ZCL_ERR_ZBUFFER_FAIL;
     }
+    else if ( ( u16DataLength > u8MaxPayload ) &&
+              ( psProfileDataReq->eDstAddrMode != ZPS_E_ADDR_MODE_SHORT ) &&
+              ( psProfileDataReq->eDstAddrMode != ZPS_E_ADDR_MODE_IEEE ) )
+    {
+        /* APS fragmentation is only defined for acknowledged unicast */
+        vLog_Printf(TRACE_APP,LOG_DEBUG, "ASDU too long for mode %d: %d > %d\n",
+                    psProfileDataReq->eDstAddrMode, u16DataLength, u8MaxPayload);
+        sApsFragmentationStats.u32TxTooLongCount++;
+        eStatus =  ZPS_APL_APS_E_ASDU_TOO_LONG;
+    }
     else
     {
         hAPduInst =  PDUM_hAPduAllocateAPduInstance ( apduZDP );
@@ -4702,7 +5355,7 @@ PRIVATE ZPS_teStatus APP_eApsProfileDataRequest ( ZPS_tsAfProfileDataReq*    psP
     {
         uint16    u16LoopCounter =  0;
         uint16    u16Location    =  0;
-        for (u16LoopCounter = 0 ; u16LoopCounter < u8DataLength ; u16LoopCounter++)
+        for (u16LoopCounter = 0 ; u16LoopCounter < u16DataLength ; u16LoopCounter++)
         {
             APDU_BUF_INC(hAPduInst, u16Location) = pu8Data[u16LoopCounter];
         }
@@ -4802,12 +5455,93 @@ PRIVATE ZPS_teStatus APP_eApsProfileDataRequest ( ZPS_tsAfProfileDataReq*    psP
             {
                 PDUM_eAPduFreeAPduInstance(hAPduInst);
             }
+            else if ( u16DataLength > u8MaxPayload )
+            {
+                sApsFragmentationStats.u32TxFragmentedCount++;
+                sApsFragmentationStats.u32TxFragmentedBytes +=  u16DataLength;
+            }
         }
     }
 
+    u8ApduUsed =  u8GetApduUsed ( apduZDP );
+    if ( u8ApduUsed > sApsFragmentationStats.u8ApduPeakUsed )
+    {
+        sApsFragmentationStats.u8ApduPeakUsed =  u8ApduUsed;
+    }
+
     return eStatus;
 }
 
+/****************************************************************************
+ **
+ ** NAME:       APP_u8ApsMaxPayloadSize
+ **
+ ** DESCRIPTION:
+ ** Largest ASDU that fits a single (unfragmented) frame to the destination
+ **
+ ** RETURNS:
+ ** Payload size in bytes
+ **
+ ****************************************************************************/
+PRIVATE uint8 APP_u8ApsMaxPayloadSize ( uint8             u8DstAddrMode,
+                                        ZPS_tuAddress*    puDstAddr )
+{
+    uint16    u16Addr;
+
+    switch ( u8DstAddrMode )
+    {
+        case ZPS_E_ADDR_MODE_IEEE:
+        case ZPS_E_ADDR_MODE_IEEE_NO_ACK:
+            u16Addr =  ZPS_u16AplZdoLookupAddr ( puDstAddr->u64Addr );
+        break;
+
+        case ZPS_E_ADDR_MODE_BOUND:
+        case ZPS_E_ADDR_MODE_BOUND_NO_ACK:
+        case ZPS_E_ADDR_MODE_BROADCAST:
+            u16Addr =  0xFFFF;
+        break;
+
+        default:
+            u16Addr =  puDstAddr->u16Addr;
+        break;
+    }
+
+    return ZPS_u8AplGetMaxPayloadSize ( ZPS_pvAplZdoGetAplHandle ( ), u16Addr );
+}
+
+/****************************************************************************
+ **
+ ** NAME:       APP_vApsFragmentationRxIndication
+ **
+ ** DESCRIPTION:
+ ** Accounts for indications the stack had to reassemble from fragments
+ **
+ ** RETURNS:
+ ** void
+ **
+ ****************************************************************************/
+PUBLIC void APP_vApsFragmentationRxIndication ( ZPS_tsAfDataIndEvent*    psDataIndEvent )
+{
+    uint16    u16Size;
+    uint16    u16SrcAddr =  psDataIndEvent->uSrcAddress.u16Addr;
+
+    if ( psDataIndEvent->u8SrcAddrMode == ZPS_E_ADDR_MODE_IEEE )
+    {
+        u16SrcAddr =  ZPS_u16AplZdoLookupAddr ( psDataIndEvent->uSrcAddress.u64Addr );
+    }
+
+    u16Size =  PDUM_u16APduInstanceGetPayloadSize ( psDataIndEvent->hAPduInst );
+    if ( u16Size > ZPS_u8AplGetMaxPayloadSize ( ZPS_pvAplZdoGetAplHandle ( ), u16SrcAddr ) )
+    {
+        sApsFragmentationStats.u32RxReassembledCount++;
+        sApsFragmentationStats.u32RxReassembledBytes +=  u16Size;
+        if ( u16Size > sApsFragmentationStats.u16RxLargestPayload )
+        {
+            sApsFragmentationStats.u16RxLargestPayload =  u16Size;
+        }
+    }
+}
+
 
 
 #ifdef LEGACY_SUPPORT
@@ -4978,19 +5712,6 @@ PUBLIC uint8 u8GetApduUsed(PDUM_thAPdu pAPdu)
     return count;
 }
 
-PRIVATE bool APP_APSKeysExist( uint16 u16Addr, uint16 tmp[50])
-{
-	uint8 i=0;
-	for (i=0;i<50;i++)
-	{
-		if (u16Addr == tmp[i])
-		{
-			return true;
-		}
-	}
-	return false;
-}
-
 
 /***    END OF FILE                           ***/
 /****************************************************************************/
@@ -55,6 +55,17 @@
 /****************************************************************************/
 /***        Type Definitions                                              ***/
 /****************************************************************************/
+/* Fragmented APS traffic seen since boot or the last reset request */
+typedef struct
+{
+    uint32    u32TxFragmentedCount;
+    uint32    u32TxFragmentedBytes;
+    uint32    u32TxTooLongCount;
+    uint32    u32RxReassembledCount;
+    uint32    u32RxReassembledBytes;
+    uint16    u16RxLargestPayload;
+    uint8     u8ApduPeakUsed;
+} tsApsFragmentationStats;
 
 /****************************************************************************/
 /***        Exported Functions                                            ***/
@@ -64,7 +75,15 @@ PUBLIC void vSendStatus ( uint8          u8Status,
                           uint8          u8SeqNum,
                           const char*    pcMessage );
 
+PUBLIC void APP_vSendStatus ( uint8     u8Status,
+                              uint8     u8SeqNum,
+                              uint16    u16PacketType,
+                              uint8     u8RequestSent,
+                              uint8     u8SeqApsNum );
 PUBLIC void APP_vProcessIncomingSerialCommands ( uint8    u8RxByte );
+PUBLIC void APP_vReplaySerialCommand ( uint16    u16Type,
+                                       uint16    u16Length,
+                                       uint8*    pu8Payload );
 
 PUBLIC uint8 APP_GetIndexDevice(uint64 IEEEAddr);
 PUBLIC bool APP_ExistDevice(uint64 IEEEAddr);
@@ -75,9 +94,18 @@ PUBLIC ZPS_teStatus APP_eZdpMgmtLqiRequest ( uint16    u16Addr,
 PUBLIC ZPS_teStatus APP_eZdpMgmtRtgRequest ( uint16    u16Addr,
                                               uint8     u8StartIndex,
                                               uint8     *pu8Seq);
+PUBLIC ZPS_teStatus APP_eZdpNodeDescReq ( uint16    u16Addr,
+                                          uint8*    pu8SeqNum );
+PUBLIC ZPS_teStatus APP_eZdpSimpleDescReq ( uint16    u16Addr,
+                                            uint8     u8Endpoint,
+                                            uint8*    pu8Seq );
+PUBLIC ZPS_teStatus APP_eZdpActiveEndpointReq ( uint16    u16Addr,
+                                                uint8*    pu8SeqNum );
+PUBLIC void APP_vApsFragmentationRxIndication ( ZPS_tsAfDataIndEvent*    psDataIndEvent );
 /****************************************************************************/
 /***        External Variables                                            ***/
 /****************************************************************************/
+extern tsApsFragmentationStats    sApsFragmentationStats;
 
 /****************************************************************************/
 /***        Inlined Functions                                            ***/
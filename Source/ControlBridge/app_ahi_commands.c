@@ -76,7 +76,7 @@ PUBLIC void APP_vCMDHandleAHICommand(uint16 u16PacketType,
                                      uint8 *pu8LinkRxBuffer,
                                      uint8 *peAHIStatus)
 {
-	eAHI_Status eAHI_Status;
+	eAHI_Status eAHI_Status = E_AHI_COMMAND_UNRECOGNISED;
 
     switch (u16PacketType)
     {
@@ -87,7 +87,7 @@ PUBLIC void APP_vCMDHandleAHICommand(uint16 u16PacketType,
         }
         case E_SL_MSG_AHI_DIO_SET_OUTPUT:
         {
-           // vAPP_DIOSetOutput(u16PacketLength, pu8LinkRxBuffer, &eAHI_Status);
+            vAPP_DIOSetOutput(u16PacketLength, pu8LinkRxBuffer, &eAHI_Status);
             break;
         }
         case E_SL_MSG_AHI_DIO_READ_INPUT:
@@ -143,7 +143,7 @@ PRIVATE void vAPP_DIOSetDirection(uint16 u16PacketLength, uint8 *pu8LinkRxBuffer
 
         // Configure the IPN
         //vAHI_DioSetOutput(u32DioInputPinMask, u32DioOutputPinMask);
-        /*GPIO_PinWrite(base, port, u32DioInputPinMask, u32DioOutputPinMask)
+        //GPIO_PinWrite(base, port, u32DioInputPinMask, u32DioOutputPinMask)
         *peAHIStatus = E_AHI_SUCCESS;
     }*/
 }
@@ -162,24 +162,24 @@ PRIVATE void vAPP_DIOSetDirection(uint16 u16PacketLength, uint8 *pu8LinkRxBuffer
  ****************************************************************************/
 PRIVATE void vAPP_DIOSetOutput(uint16 u16PacketLength, uint8 *pu8LinkRxBuffer, eAHI_Status *peAHIStatus)
 {
-    uint32 u32DioOnPinMask;
+    /*uint32 u32DioOnPinMask;
     uint32 u32DioOffPinMask;
     uint32 u32BytesRead = 0;
 
-    /**peAHIStatus = E_AHI_PARSE_ERROR;
+    *peAHIStatus = E_AHI_PARSE_ERROR;
 
     DBG_vPrintf(TRUE, "AHI: %s", __FUNCTION__);
 
     if (8 == u16PacketLength)
     {
-        /* Parse the information out */
+        // Parse the information out
         u32DioOnPinMask = ZNC_RTN_U32( pu8LinkRxBuffer, u32BytesRead );
         u32BytesRead += sizeof(u32DioOnPinMask);
         u32DioOffPinMask = ZNC_RTN_U32( pu8LinkRxBuffer, u32BytesRead );
 
-        /* Configure the IPN */
-       /* vAHI_DioSetDirection(u32DioOnPinMask, u32DioOffPinMask);
-        GPIO_PinWrite(base, port, pin, output)
+        // Configure the IPN
+        //vAHI_DioSetDirection(u32DioOnPinMask, u32DioOffPinMask);
+        //GPIO_PinWrite(base, port, pin, output)
 
         *peAHIStatus = E_AHI_SUCCESS;
     }*/
@@ -0,0 +1,685 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_aps_queue.c
+ *
+ * DESCRIPTION:        Admission queue for host commands that issue APS data
+ *                     requests (Implementation)
+ *
+ *                     The coordinator only has a handful of APSDE request
+ *                     slots. Host commands that would transmit while those
+ *                     slots are busy are held here in their serial encoding
+ *                     and replayed through the command dispatcher as APS
+ *                     data confirms come back. Destinations are served in
+ *                     least recently served order so that one chatty device
+ *                     cannot starve the others.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "dbg.h"
+#include "pdum_apl.h"
+#include "pdum_gen.h"
+#include "zps_apl_af.h"
+#include "zps_apl_zdo.h"
+#include "zps_nwk_nib.h"
+#include "zps_struct.h"
+#include "zcl.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_Znc_cmds.h"
+#include "app_aps_queue.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_APS_QUEUE
+#define TRACE_APS_QUEUE               TRUE
+#else
+#define TRACE_APS_QUEUE               FALSE
+#endif
+
+/* APDU instances left free for incoming indications */
+#define APS_QUEUE_APDU_RESERVE        2
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint16    u16Start;
+    uint16    u16End;
+} tsApsQueueRange;
+
+typedef struct
+{
+    uint16    u16PacketType;
+    uint16    u16PacketLength;
+    uint16    u16DstKey;
+    bool_t    bAck;
+    uint8     au8Payload[APS_QUEUE_MAX_PAYLOAD];
+} tsApsQueueEntry;
+
+typedef struct
+{
+    uint16    u16DstKey;
+    uint16    u16ServedStamp;
+} tsApsQueueDst;
+
+typedef struct
+{
+    bool_t    bUsed;
+    bool_t    bAck;
+    uint8     u8ApsSeqNum;
+    uint8     u8Ticks;
+} tsApsQueueInFlight;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE uint16 APP_u16ApsQueueDstKey ( uint16    u16PacketType,
+                                       uint8*    pu8Payload );
+PRIVATE bool_t APP_bApsQueueNeedsAck ( uint16    u16PacketType,
+                                       uint8*    pu8Payload );
+PRIVATE bool_t APP_bApsQueueCanSend ( bool_t    bAck );
+PRIVATE tsApsQueueInFlight* APP_psApsQueueFindInFlight ( uint8    u8ApsSeqNum );
+PRIVATE uint8 APP_u8ApsQueueSelect ( void );
+PRIVATE void APP_vApsQueueMarkServed ( uint16    u16DstKey );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+/* Serial commands which end up in an APSDE-DATA.request */
+PRIVATE const tsApsQueueRange asApsQueueTxRanges[] =
+{
+    { E_SL_MSG_BIND,                              E_SL_MSG_UNBIND_GROUP                    },
+    { E_SL_MSG_NETWORK_ADDRESS_REQUEST,           E_SL_MSG_BASIC_RESET_TO_FACTORY_DEFAULTS },
+    { E_SL_MSG_ADD_GROUP,                         E_SL_MSG_STEP_COLOUR_TEMPERATURE         },
+    { E_SL_MSG_IDENTIFY_TRIGGER_EFFECT,           E_SL_MSG_COMMAND_GENERATED_DISCOVERY_REQUEST },
+    { E_SL_MSG_SEND_IAS_ZONE_ENROLL_RSP,          E_SL_MSG_SEND_IAS_ZONE_ENROLL_RSP        },
+    { E_SL_MSG_BLOCK_SEND,                        E_SL_MSG_SEND_WAIT_FOR_DATA_PARAMS       },
+    { E_SL_MSG_SEND_RAW_APS_DATA_PACKET,          E_SL_MSG_USER_DESC_SET                   }
+};
+
+PRIVATE tsApsQueueEntry       asApsQueue[APS_QUEUE_SIZE];
+PRIVATE tsApsQueueDst         asApsQueueDst[APS_QUEUE_SIZE];
+PRIVATE tsApsQueueInFlight    asApsInFlight[APS_QUEUE_MAX_IN_FLIGHT];
+PRIVATE uint8                 u8ApsQueueHead;
+PRIVATE uint8                 u8ApsQueueCount;
+PRIVATE uint16                u16ApsServedStamp;
+PRIVATE bool_t                bApsQueueReportDepth;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vApsQueueInit
+ *
+ * DESCRIPTION:
+ * Empties the admission queue and forgets the outstanding requests. The
+ * host has to ask for the queue depth again after a reset.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vApsQueueInit ( void )
+{
+    memset ( asApsQueueDst, 0, sizeof ( asApsQueueDst ) );
+    memset ( asApsInFlight, 0, sizeof ( asApsInFlight ) );
+    u8ApsQueueHead          =  0;
+    u8ApsQueueCount         =  0;
+    u16ApsServedStamp       =  0;
+    bApsQueueReportDepth    =  FALSE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_eApsQueueAdmit
+ *
+ * DESCRIPTION:
+ * Decides whether a received host command can be processed now. Commands
+ * that transmit over the air are queued while earlier commands are still
+ * waiting or while there is no room for another APS data request.
+ *
+ * RETURNS:
+ * E_APS_QUEUE_BYPASS when the caller should process the command itself
+ *
+ ****************************************************************************/
+PUBLIC teApsQueueAdmit APP_eApsQueueAdmit ( uint16    u16PacketType,
+                                            uint16    u16PacketLength,
+                                            uint8*    pu8Payload )
+{
+    tsApsQueueEntry    *psEntry;
+
+    if ( ( FALSE == APP_bApsQueueIsTxCommand ( u16PacketType ) ) ||
+         ( u16PacketLength > APS_QUEUE_MAX_PAYLOAD ) )
+    {
+        return E_APS_QUEUE_BYPASS;
+    }
+
+    if ( ( 0 == u8ApsQueueCount ) &&
+         APP_bApsQueueCanSend ( APP_bApsQueueNeedsAck ( u16PacketType, pu8Payload ) ) )
+    {
+        APP_vApsQueueMarkServed ( APP_u16ApsQueueDstKey ( u16PacketType, pu8Payload ) );
+        return E_APS_QUEUE_BYPASS;
+    }
+
+    if ( u8ApsQueueCount >= APS_QUEUE_SIZE )
+    {
+        vLog_Printf ( TRACE_APS_QUEUE, LOG_DEBUG, "\nAPS queue full, drop %04x", u16PacketType );
+        return E_APS_QUEUE_FULL;
+    }
+
+    psEntry = &asApsQueue[ ( u8ApsQueueHead + u8ApsQueueCount ) % APS_QUEUE_SIZE ];
+    psEntry->u16PacketType      =  u16PacketType;
+    psEntry->u16PacketLength    =  u16PacketLength;
+    psEntry->u16DstKey          =  APP_u16ApsQueueDstKey ( u16PacketType, pu8Payload );
+    psEntry->bAck               =  APP_bApsQueueNeedsAck ( u16PacketType, pu8Payload );
+    memcpy ( psEntry->au8Payload, pu8Payload, u16PacketLength );
+    u8ApsQueueCount++;
+
+    vLog_Printf ( TRACE_APS_QUEUE, LOG_DEBUG, "\nAPS queue %04x dst %04x depth %d",
+                  u16PacketType, psEntry->u16DstKey, u8ApsQueueCount );
+
+    return E_APS_QUEUE_QUEUED;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vApsQueueRequestSent
+ *
+ * DESCRIPTION:
+ * Called by the dispatcher when a command has been handed to the stack with
+ * the APS counter of the frame it sent. Should every slot be taken, the
+ * request that has waited longest for its confirm is given up on.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vApsQueueRequestSent ( uint8     u8ApsSeqNum,
+                                       uint16    u16PacketType,
+                                       uint8*    pu8Payload )
+{
+    tsApsQueueInFlight    *psInFlight;
+    uint8                 i;
+
+    psInFlight = APP_psApsQueueFindInFlight ( u8ApsSeqNum );
+    for ( i = 0; ( psInFlight == NULL ) && ( i < APS_QUEUE_MAX_IN_FLIGHT ); i++ )
+    {
+        if ( FALSE == asApsInFlight[i].bUsed )
+        {
+            psInFlight = &asApsInFlight[i];
+        }
+    }
+    if ( psInFlight == NULL )
+    {
+        psInFlight = &asApsInFlight[0];
+        for ( i = 1; i < APS_QUEUE_MAX_IN_FLIGHT; i++ )
+        {
+            if ( asApsInFlight[i].u8Ticks > psInFlight->u8Ticks )
+            {
+                psInFlight = &asApsInFlight[i];
+            }
+        }
+    }
+
+    psInFlight->bUsed          =  TRUE;
+    psInFlight->bAck           =  APP_bApsQueueNeedsAck ( u16PacketType, pu8Payload );
+    psInFlight->u8ApsSeqNum    =  u8ApsSeqNum;
+    psInFlight->u8Ticks        =  0;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vApsQueueConfirm
+ *
+ * DESCRIPTION:
+ * Called for every APS data confirm. Frees the slot of the request with that
+ * APS counter; confirms for frames the queue did not send are ignored.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vApsQueueConfirm ( uint8    u8ApsSeqNum )
+{
+    tsApsQueueInFlight    *psInFlight;
+
+    psInFlight = APP_psApsQueueFindInFlight ( u8ApsSeqNum );
+    if ( psInFlight != NULL )
+    {
+        psInFlight->bUsed = FALSE;
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vApsQueueTick
+ *
+ * DESCRIPTION:
+ * 100ms tick. Confirms are not guaranteed for every request the host issues
+ * (local ZDO requests, stack aborted requests), so each outstanding request
+ * is forgotten once it has waited too long for its own confirm rather than
+ * stalling the queue.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vApsQueueTick ( void )
+{
+    uint8    i;
+
+    for ( i = 0; i < APS_QUEUE_MAX_IN_FLIGHT; i++ )
+    {
+        if ( asApsInFlight[i].bUsed )
+        {
+            asApsInFlight[i].u8Ticks++;
+            if ( asApsInFlight[i].u8Ticks >= APS_QUEUE_IN_FLIGHT_TIMEOUT )
+            {
+                vLog_Printf ( TRACE_APS_QUEUE, LOG_DEBUG, "\nAPS queue: request %d timed out",
+                              asApsInFlight[i].u8ApsSeqNum );
+                asApsInFlight[i].bUsed = FALSE;
+            }
+        }
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vApsQueueService
+ *
+ * DESCRIPTION:
+ * Replays queued commands while there is room for more APS data requests.
+ * Run from the main loop so that commands are never issued from inside a
+ * stack event callback.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vApsQueueService ( void )
+{
+    tsApsQueueEntry    sEntry;
+    uint8              u8Index;
+    uint8              u8Slot;
+    uint8              u8Next;
+
+    while ( u8ApsQueueCount > 0 )
+    {
+        u8Index    =  APP_u8ApsQueueSelect ( );
+        u8Slot     =  ( u8ApsQueueHead + u8Index ) % APS_QUEUE_SIZE;
+        sEntry     =  asApsQueue[ u8Slot ];
+        if ( FALSE == APP_bApsQueueCanSend ( sEntry.bAck ) )
+        {
+            break;
+        }
+
+        /* Close the gap so the remaining entries stay in arrival order */
+        while ( u8Index > 0 )
+        {
+            u8Next = ( u8Slot + APS_QUEUE_SIZE - 1 ) % APS_QUEUE_SIZE;
+            asApsQueue[ u8Slot ] = asApsQueue[ u8Next ];
+            u8Slot = u8Next;
+            u8Index--;
+        }
+        u8ApsQueueHead = ( u8ApsQueueHead + 1 ) % APS_QUEUE_SIZE;
+        u8ApsQueueCount--;
+
+        APP_vApsQueueMarkServed ( sEntry.u16DstKey );
+        APP_vReplaySerialCommand ( sEntry.u16PacketType,
+                                   sEntry.u16PacketLength,
+                                   sEntry.au8Payload );
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8ApsQueueDepth
+ *
+ * DESCRIPTION:
+ * Number of commands waiting in the admission queue
+ *
+ * RETURNS:
+ * uint8
+ *
+ ****************************************************************************/
+PUBLIC uint8 APP_u8ApsQueueDepth ( void )
+{
+    return u8ApsQueueCount;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8ApsQueueSetReportDepth
+ *
+ * DESCRIPTION:
+ * Handles E_SL_MSG_APS_QUEUE_REPORT_DEPTH: a first byte of 1 asks for the
+ * queue depth to be appended to every status message, 0 stops it. Hosts
+ * that never send it see status messages of the original length.
+ *
+ * RETURNS:
+ * Status for the E_SL_MSG_STATUS reply
+ *
+ ****************************************************************************/
+PUBLIC uint8 APP_u8ApsQueueSetReportDepth ( uint8*    pu8Payload,
+                                            uint16    u16PayloadLength )
+{
+    if ( ( u16PayloadLength < 1 ) || ( pu8Payload[0] > 1 ) )
+    {
+        return E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+    }
+    bApsQueueReportDepth = ( pu8Payload[0] == 1 );
+    return E_SL_MSG_STATUS_SUCCESS;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8ApsQueueWriteDepth
+ *
+ * DESCRIPTION:
+ * Appends the queue depth to a status message if the host asked for it
+ *
+ * RETURNS:
+ * Number of bytes written
+ *
+ ****************************************************************************/
+PUBLIC uint8 APP_u8ApsQueueWriteDepth ( uint8*    pu8Buffer )
+{
+    if ( FALSE == bApsQueueReportDepth )
+    {
+        return 0;
+    }
+    *pu8Buffer = u8ApsQueueCount;
+    return 1;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bApsQueueIsTxCommand
+ *
+ * DESCRIPTION:
+ * Whether a host command ends up in an APSDE-DATA.request
+ *
+ * RETURNS:
+ * bool_t
+ *
+ ****************************************************************************/
+PUBLIC bool_t APP_bApsQueueIsTxCommand ( uint16    u16PacketType )
+{
+    uint8    i;
+
+    for ( i = 0; i < ( sizeof ( asApsQueueTxRanges ) / sizeof ( asApsQueueTxRanges[0] ) ); i++ )
+    {
+        if ( ( u16PacketType >= asApsQueueTxRanges[i].u16Start ) &&
+             ( u16PacketType <= asApsQueueTxRanges[i].u16End ) )
+        {
+            return ( ( u16PacketType != E_SL_MSG_DEVICE_ANNOUNCE ) &&
+                     ( u16PacketType != E_SL_MSG_MANY_TO_ONE_ROUTE_REQUEST ) &&
+                     ( u16PacketType != E_SL_MSG_APS_QUEUE_REPORT_DEPTH ) &&
+                     ( u16PacketType != E_SL_MSG_REPORT_FILTER_SET_RULE ) &&
+                     ( u16PacketType != E_SL_MSG_REPORT_FILTER_GET_STATS ) &&
+                     ( u16PacketType != E_SL_MSG_ATTRIBUTE_CACHE_SET_RULE ) &&
+                     ( u16PacketType != E_SL_MSG_ATTRIBUTE_CACHE_GET_STATS ) &&
+                     ( u16PacketType != E_SL_MSG_DEVICE_INTERVIEW_START ) &&
+                     ( u16PacketType != E_SL_MSG_CHILD_QUEUE_SET_EXPIRY ) &&
+                     ( u16PacketType != E_SL_MSG_CHILD_QUEUE_GET_STATS ) );
+        }
+    }
+    return FALSE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u16ApsQueueDstAddr
+ *
+ * DESCRIPTION:
+ * Short address of the single device a transmit command is sent to, laid
+ * out as APP_u16ApsQueueDstKey reads it
+ *
+ * RETURNS:
+ * ZPS_NWK_INVALID_NWK_ADDR for group and broadcast commands, and for IEEE
+ * addresses not in the address map
+ *
+ ****************************************************************************/
+PUBLIC uint16 APP_u16ApsQueueDstAddr ( uint16    u16PacketType,
+                                       uint8*    pu8Payload )
+{
+    uint64    u64Addr;
+    uint16    u16Addr;
+
+    if ( u16PacketType <= E_SL_MSG_UNBIND_GROUP )
+    {
+        u64Addr = ZNC_RTN_U64 ( pu8Payload, 0 );
+    }
+    else if ( u16PacketType <= E_SL_MSG_BASIC_RESET_TO_FACTORY_DEFAULTS )
+    {
+        u16Addr = ZNC_RTN_U16 ( pu8Payload, 0 );
+        return ( u16Addr < ZPS_NWK_INVALID_NWK_ADDR ) ? u16Addr : ZPS_NWK_INVALID_NWK_ADDR;
+    }
+    else if ( ( pu8Payload[0] == E_ZCL_AM_IEEE ) || ( pu8Payload[0] == E_ZCL_AM_IEEE_NO_ACK ) )
+    {
+        u64Addr = ZNC_RTN_U64 ( pu8Payload, 1 );
+    }
+    else if ( ( pu8Payload[0] == E_ZCL_AM_SHORT ) || ( pu8Payload[0] == E_ZCL_AM_SHORT_NO_ACK ) )
+    {
+        u16Addr = ZNC_RTN_U16 ( pu8Payload, 1 );
+        return ( u16Addr < ZPS_NWK_INVALID_NWK_ADDR ) ? u16Addr : ZPS_NWK_INVALID_NWK_ADDR;
+    }
+    else
+    {
+        return ZPS_NWK_INVALID_NWK_ADDR;
+    }
+
+    u16Addr = ZPS_u16AplZdoLookupAddr ( u64Addr );
+    return ( u16Addr < ZPS_NWK_INVALID_NWK_ADDR ) ? u16Addr : ZPS_NWK_INVALID_NWK_ADDR;
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* Fold whatever identifies the destination of a command into 16 bits. ZCL
+ * commands carry address mode then address, ZDP requests start with the
+ * target short address and binds with the source IEEE address. */
+PRIVATE uint16 APP_u16ApsQueueDstKey ( uint16    u16PacketType,
+                                       uint8*    pu8Payload )
+{
+    uint64    u64Addr;
+
+    if ( u16PacketType <= E_SL_MSG_UNBIND_GROUP )
+    {
+        u64Addr = ZNC_RTN_U64 ( pu8Payload, 0 );
+    }
+    else if ( u16PacketType <= E_SL_MSG_BASIC_RESET_TO_FACTORY_DEFAULTS )
+    {
+        return ZNC_RTN_U16 ( pu8Payload, 0 );
+    }
+    else if ( ( pu8Payload[0] == E_ZCL_AM_IEEE ) || ( pu8Payload[0] == E_ZCL_AM_IEEE_NO_ACK ) )
+    {
+        u64Addr = ZNC_RTN_U64 ( pu8Payload, 1 );
+    }
+    else
+    {
+        return ZNC_RTN_U16 ( pu8Payload, 1 );
+    }
+
+    return ( uint16 ) ( u64Addr ^ ( u64Addr >> 16 ) ^ ( u64Addr >> 32 ) ^ ( u64Addr >> 48 ) );
+}
+
+/* Unicasts are taken to ask for an APS ack unless the address mode says
+ * otherwise; ZDP requests carry no address mode and are counted as acked */
+PRIVATE bool_t APP_bApsQueueNeedsAck ( uint16    u16PacketType,
+                                       uint8*    pu8Payload )
+{
+    if ( u16PacketType <= E_SL_MSG_BASIC_RESET_TO_FACTORY_DEFAULTS )
+    {
+        return TRUE;
+    }
+
+    switch ( pu8Payload[0] )
+    {
+        case E_ZCL_AM_GROUP:
+        case E_ZCL_AM_BROADCAST:
+        case E_ZCL_AM_NO_TRANSMIT:
+        case E_ZCL_AM_BOUND_NO_ACK:
+        case E_ZCL_AM_SHORT_NO_ACK:
+        case E_ZCL_AM_IEEE_NO_ACK:
+        case E_ZCL_AM_BOUND_NON_BLOCKING_NO_ACK:
+            return FALSE;
+
+        default:
+            return TRUE;
+    }
+}
+
+PRIVATE bool_t APP_bApsQueueCanSend ( bool_t    bAck )
+{
+    uint8    u8InFlight    =  0;
+    uint8    u8AckInFlight =  0;
+    uint8    i;
+
+    for ( i = 0; i < APS_QUEUE_MAX_IN_FLIGHT; i++ )
+    {
+        if ( asApsInFlight[i].bUsed )
+        {
+            u8InFlight++;
+            if ( asApsInFlight[i].bAck )
+            {
+                u8AckInFlight++;
+            }
+        }
+    }
+
+    if ( ( u8InFlight >= APS_QUEUE_MAX_IN_FLIGHT ) ||
+         ( bAck && ( u8AckInFlight >= APS_QUEUE_MAX_ACK_IN_FLIGHT ) ) )
+    {
+        return FALSE;
+    }
+    return ( ( u8GetApduUsed ( apduZDP ) + APS_QUEUE_APDU_RESERVE ) < ( apduZDP )->u16NumInstances );
+}
+
+PRIVATE tsApsQueueInFlight* APP_psApsQueueFindInFlight ( uint8    u8ApsSeqNum )
+{
+    uint8    i;
+
+    for ( i = 0; i < APS_QUEUE_MAX_IN_FLIGHT; i++ )
+    {
+        if ( asApsInFlight[i].bUsed && ( asApsInFlight[i].u8ApsSeqNum == u8ApsSeqNum ) )
+        {
+            return &asApsInFlight[i];
+        }
+    }
+    return NULL;
+}
+
+/* Index, relative to the head, of the oldest entry for the destination that
+ * was served longest ago */
+PRIVATE uint8 APP_u8ApsQueueSelect ( void )
+{
+    uint8     i, j;
+    uint8     u8Best = 0;
+    uint16    u16Age;
+    uint16    u16BestAge = 0;
+    uint16    u16Key;
+
+    for ( i = 0; i < u8ApsQueueCount; i++ )
+    {
+        u16Key = asApsQueue[ ( u8ApsQueueHead + i ) % APS_QUEUE_SIZE ].u16DstKey;
+        u16Age = 0xFFFF;
+
+        for ( j = 0; j < APS_QUEUE_SIZE; j++ )
+        {
+            if ( ( asApsQueueDst[j].u16ServedStamp != 0 ) &&
+                 ( asApsQueueDst[j].u16DstKey == u16Key ) )
+            {
+                u16Age = u16ApsServedStamp - asApsQueueDst[j].u16ServedStamp;
+                break;
+            }
+        }
+
+        if ( u16Age > u16BestAge )
+        {
+            u16BestAge = u16Age;
+            u8Best     = i;
+            if ( u16Age == 0xFFFF )
+            {
+                break;
+            }
+        }
+    }
+    return u8Best;
+}
+
+PRIVATE void APP_vApsQueueMarkServed ( uint16    u16DstKey )
+{
+    uint8    j;
+    uint8    u8Oldest = 0;
+
+    u16ApsServedStamp++;
+    if ( u16ApsServedStamp == 0 )
+    {
+        /* Stamp 0 marks a free entry */
+        memset ( asApsQueueDst, 0, sizeof ( asApsQueueDst ) );
+        u16ApsServedStamp = 1;
+    }
+
+    for ( j = 0; j < APS_QUEUE_SIZE; j++ )
+    {
+        if ( ( asApsQueueDst[j].u16ServedStamp == 0 ) ||
+             ( asApsQueueDst[j].u16DstKey == u16DstKey ) )
+        {
+            u8Oldest = j;
+            break;
+        }
+        if ( ( uint16 ) ( u16ApsServedStamp - asApsQueueDst[j].u16ServedStamp ) >
+             ( uint16 ) ( u16ApsServedStamp - asApsQueueDst[u8Oldest].u16ServedStamp ) )
+        {
+            u8Oldest = j;
+        }
+    }
+    asApsQueueDst[u8Oldest].u16DstKey         =  u16DstKey;
+    asApsQueueDst[u8Oldest].u16ServedStamp    =  u16ApsServedStamp;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
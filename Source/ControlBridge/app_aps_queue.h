@@ -0,0 +1,128 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_aps_queue.h
+ *
+ * DESCRIPTION:        Admission queue for host commands that issue APS data
+ *                     requests (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef APP_APS_QUEUE_H_
+#define APP_APS_QUEUE_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Number of host commands that can be held back waiting for APS resources */
+#ifndef APS_QUEUE_SIZE
+#define APS_QUEUE_SIZE                  16
+#endif
+
+/* Longest command payload that is queued; longer commands go straight through */
+#ifndef APS_QUEUE_MAX_PAYLOAD
+#define APS_QUEUE_MAX_PAYLOAD           96
+#endif
+
+/* MaxNumSimultaneousApsdeReq and MaxNumSimultaneousApsdeAckReq of the
+ * zpscfg the stack is configured from; the firmware build passes them in,
+ * the defaults are those of every variant but Full_GpProxy */
+#ifndef APS_QUEUE_ZPS_MAX_APSDE_REQ
+#define APS_QUEUE_ZPS_MAX_APSDE_REQ     5
+#endif
+
+#ifndef APS_QUEUE_ZPS_MAX_APSDE_ACK_REQ
+#define APS_QUEUE_ZPS_MAX_APSDE_ACK_REQ 3
+#endif
+
+/* Simultaneous APSDE requests, less one kept for the stack's own traffic
+ * (default responses, ZDO replies) */
+#ifndef APS_QUEUE_MAX_IN_FLIGHT
+#define APS_QUEUE_MAX_IN_FLIGHT         ( APS_QUEUE_ZPS_MAX_APSDE_REQ - 1 )
+#endif
+
+/* Of those, requests with an APS ack, again keeping one back */
+#ifndef APS_QUEUE_MAX_ACK_IN_FLIGHT
+#define APS_QUEUE_MAX_ACK_IN_FLIGHT     ( APS_QUEUE_ZPS_MAX_APSDE_ACK_REQ - 1 )
+#endif
+
+/* Forget an outstanding request after this many 100ms ticks without its confirm */
+#ifndef APS_QUEUE_IN_FLIGHT_TIMEOUT
+#define APS_QUEUE_IN_FLIGHT_TIMEOUT     100
+#endif
+
+/* Value of the "request sent" field of the status message for a queued command */
+#define APS_QUEUE_REQUEST_QUEUED        3
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+    E_APS_QUEUE_BYPASS,         /* Command may be processed straight away */
+    E_APS_QUEUE_QUEUED,         /* Command held until APS resources are free */
+    E_APS_QUEUE_FULL,           /* Command needs to wait but queue is full */
+    E_APS_QUEUE_HELD,           /* Command held for a sleepy child until it polls */
+    E_APS_QUEUE_COALESCED       /* Command merged into the same command held for a child */
+} teApsQueueAdmit;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vApsQueueInit ( void );
+PUBLIC teApsQueueAdmit APP_eApsQueueAdmit ( uint16    u16PacketType,
+                                            uint16    u16PacketLength,
+                                            uint8*    pu8Payload );
+PUBLIC void APP_vApsQueueRequestSent ( uint8     u8ApsSeqNum,
+                                       uint16    u16PacketType,
+                                       uint8*    pu8Payload );
+PUBLIC void APP_vApsQueueConfirm ( uint8    u8ApsSeqNum );
+PUBLIC void APP_vApsQueueTick ( void );
+PUBLIC void APP_vApsQueueService ( void );
+PUBLIC uint8 APP_u8ApsQueueDepth ( void );
+PUBLIC uint8 APP_u8ApsQueueSetReportDepth ( uint8*    pu8Payload,
+                                            uint16    u16PayloadLength );
+PUBLIC uint8 APP_u8ApsQueueWriteDepth ( uint8*    pu8Buffer );
+PUBLIC bool_t APP_bApsQueueIsTxCommand ( uint16    u16PacketType );
+PUBLIC uint16 APP_u16ApsQueueDstAddr ( uint16    u16PacketType,
+                                       uint8*    pu8Payload );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_APS_QUEUE_H_ */
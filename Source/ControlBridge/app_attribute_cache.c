@@ -0,0 +1,612 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_attribute_cache.c
+ *
+ * DESCRIPTION:        Cache of attribute values answering repeated host
+ *                     reads without going on air (Implementation)
+ *
+ *                     Hosts read the same static attributes (model,
+ *                     manufacturer, power source, firmware version) over and
+ *                     over, each read a radio transaction to a device that
+ *                     may be asleep. Values from read attribute responses and
+ *                     reports are kept here, keyed by device IEEE address,
+ *                     endpoint, cluster and attribute, for as long as the
+ *                     rule for their cluster allows. A host read whose
+ *                     attributes are all held and fresh is answered from the
+ *                     cache: the status message carries
+ *                     ATTRIBUTE_CACHE_REQUEST_SERVED in its "request sent"
+ *                     field and the read attribute responses follow as if
+ *                     received, with the link quality of the original frame.
+ *                     When full, the value used least recently is dropped.
+ *                     Values of a device that announces itself or leaves,
+ *                     and of a cluster the host writes to, are dropped.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "dbg.h"
+#include "zps_apl_zdo.h"
+#include "zcl.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_attribute_cache.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_ATTRIBUTE_CACHE
+#define TRACE_ATTRIBUTE_CACHE           TRUE
+#else
+#define TRACE_ATTRIBUTE_CACHE           FALSE
+#endif
+
+#define ATTRIBUTE_CACHE_TICKS_PER_S     10
+
+/* Sequence number, short address, endpoint, cluster, attribute and status
+ * ahead of the cached record in a read attribute response */
+#define ATTRIBUTE_CACHE_RESPONSE_HEADER 9
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    bool_t    bInUse;
+    uint16    u16ClusterId;
+    uint32    u32Ttl;                 /* seconds */
+} tsAttributeCacheRule;
+
+typedef struct
+{
+    uint64    u64IeeeAddr;            /* 0 when unused */
+    uint32    u32StoredAt;            /* 100ms ticks */
+    uint32    u32Ttl;                 /* 100ms ticks */
+    uint32    u32LastUsed;            /* 100ms ticks */
+    uint16    u16ClusterId;
+    uint16    u16AttributeId;
+    uint8     u8Endpoint;
+    uint8     u8LinkQuality;
+    uint8     u8RecordLength;
+    uint8     au8Record[ATTRIBUTE_CACHE_MAX_RECORD];
+} tsAttributeCacheEntry;
+
+typedef struct
+{
+    uint32    u32Hits;                /* host reads answered from the cache */
+    uint32    u32Misses;              /* cacheable host reads sent on air */
+    uint32    u32Stored;
+    uint32    u32Expired;
+    uint32    u32Evicted;
+    uint32    u32Invalidated;
+} tsAttributeCacheStats;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE uint32 APP_u32AttributeCacheTtl ( uint16    u16ClusterId );
+PRIVATE tsAttributeCacheEntry* APP_psAttributeCacheFind ( uint64    u64IeeeAddr,
+                                                          uint8     u8Endpoint,
+                                                          uint16    u16ClusterId,
+                                                          uint16    u16AttributeId );
+PRIVATE tsAttributeCacheEntry* APP_psAttributeCacheAllocate ( void );
+PRIVATE bool_t APP_bAttributeCacheIsFresh ( tsAttributeCacheEntry*    psEntry );
+PRIVATE void APP_vAttributeCacheDrop ( uint64    u64IeeeAddr,
+                                       uint8     u8Endpoint,
+                                       uint16    u16ClusterId );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsAttributeCacheRule     asAttributeCacheRules[ATTRIBUTE_CACHE_MAX_RULES];
+PRIVATE tsAttributeCacheEntry    asAttributeCacheEntries[ATTRIBUTE_CACHE_MAX_ENTRIES];
+PRIVATE tsAttributeCacheStats    sAttributeCacheStats;
+PRIVATE uint32                   u32AttributeCacheTicks;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vAttributeCacheInit
+ *
+ * DESCRIPTION:
+ * Empties the cache and the counters, and caches only the Basic cluster
+ * until the host sets rules
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vAttributeCacheInit ( void )
+{
+    memset ( asAttributeCacheRules,   0, sizeof ( asAttributeCacheRules ) );
+    memset ( asAttributeCacheEntries, 0, sizeof ( asAttributeCacheEntries ) );
+    memset ( &sAttributeCacheStats,   0, sizeof ( sAttributeCacheStats ) );
+    u32AttributeCacheTicks =  0;
+
+    asAttributeCacheRules[0].bInUse        =  TRUE;
+    asAttributeCacheRules[0].u16ClusterId  =  GENERAL_CLUSTER_ID_BASIC;
+    asAttributeCacheRules[0].u32Ttl        =  ATTRIBUTE_CACHE_BASIC_TTL;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vAttributeCacheTick
+ *
+ * DESCRIPTION:
+ * 100ms time base for the value lifetimes
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vAttributeCacheTick ( void )
+{
+    u32AttributeCacheTicks++;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vAttributeCacheStore
+ *
+ * DESCRIPTION:
+ * Keeps an attribute value received from a device, if its cluster has a
+ * lifetime. pu8Record is the type, size and value as encoded in the 0x8100
+ * and 0x8102 messages.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vAttributeCacheStore ( uint16    u16Addr,
+                                       uint8     u8Endpoint,
+                                       uint16    u16ClusterId,
+                                       uint16    u16AttributeId,
+                                       uint8*    pu8Record,
+                                       uint16    u16RecordLength,
+                                       uint8     u8LinkQuality )
+{
+    tsAttributeCacheEntry*    psEntry;
+    uint64                    u64IeeeAddr;
+    uint32                    u32Ttl;
+
+    u32Ttl =  APP_u32AttributeCacheTtl ( u16ClusterId );
+    if ( ( u32Ttl == 0 ) ||
+         ( u16RecordLength == 0 ) ||
+         ( u16RecordLength > ATTRIBUTE_CACHE_MAX_RECORD ) )
+    {
+        return;
+    }
+
+    /* Short addresses change when devices rejoin */
+    u64IeeeAddr =  ZPS_u64AplZdoLookupIeeeAddr ( u16Addr );
+    if ( u64IeeeAddr == 0 )
+    {
+        return;
+    }
+
+    psEntry =  APP_psAttributeCacheFind ( u64IeeeAddr, u8Endpoint, u16ClusterId, u16AttributeId );
+    if ( psEntry == NULL )
+    {
+        psEntry =  APP_psAttributeCacheAllocate ( );
+    }
+
+    psEntry->u64IeeeAddr     =  u64IeeeAddr;
+    psEntry->u8Endpoint      =  u8Endpoint;
+    psEntry->u16ClusterId    =  u16ClusterId;
+    psEntry->u16AttributeId  =  u16AttributeId;
+    psEntry->u8LinkQuality   =  u8LinkQuality;
+    psEntry->u8RecordLength  =  ( uint8 ) u16RecordLength;
+    memcpy ( psEntry->au8Record, pu8Record, u16RecordLength );
+    psEntry->u32StoredAt     =  u32AttributeCacheTicks;
+    psEntry->u32LastUsed     =  u32AttributeCacheTicks;
+    psEntry->u32Ttl          =  ( u32Ttl > ( 0xFFFFFFFFUL / ATTRIBUTE_CACHE_TICKS_PER_S ) ) ?
+                                    0xFFFFFFFFUL : ( u32Ttl * ATTRIBUTE_CACHE_TICKS_PER_S );
+    sAttributeCacheStats.u32Stored++;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bAttributeCacheLookup
+ *
+ * DESCRIPTION:
+ * Whether a host read of u8Attributes attributes can be answered from the
+ * cache, which needs every one of them held and fresh
+ *
+ * RETURNS:
+ * TRUE if APP_vAttributeCacheSend can answer the read
+ *
+ ****************************************************************************/
+PUBLIC bool_t APP_bAttributeCacheLookup ( uint16    u16Addr,
+                                          uint8     u8Endpoint,
+                                          uint16    u16ClusterId,
+                                          uint8     u8Attributes,
+                                          uint16*   pu16Attributes )
+{
+    tsAttributeCacheEntry*    psEntry;
+    uint64                    u64IeeeAddr;
+    uint8                     i;
+
+    if ( ( u8Attributes == 0 ) ||
+         ( APP_u32AttributeCacheTtl ( u16ClusterId ) == 0 ) )
+    {
+        return FALSE;
+    }
+
+    u64IeeeAddr =  ZPS_u64AplZdoLookupIeeeAddr ( u16Addr );
+    for ( i = 0; ( u64IeeeAddr != 0 ) && ( i < u8Attributes ); i++ )
+    {
+        psEntry =  APP_psAttributeCacheFind ( u64IeeeAddr, u8Endpoint, u16ClusterId, pu16Attributes[i] );
+        if ( ( psEntry == NULL ) || !APP_bAttributeCacheIsFresh ( psEntry ) )
+        {
+            break;
+        }
+    }
+    if ( ( u64IeeeAddr == 0 ) || ( i < u8Attributes ) )
+    {
+        sAttributeCacheStats.u32Misses++;
+        return FALSE;
+    }
+
+    for ( i = 0; i < u8Attributes; i++ )
+    {
+        psEntry =  APP_psAttributeCacheFind ( u64IeeeAddr, u8Endpoint, u16ClusterId, pu16Attributes[i] );
+        psEntry->u32LastUsed =  u32AttributeCacheTicks;
+    }
+    sAttributeCacheStats.u32Hits++;
+
+    return TRUE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vAttributeCacheSend
+ *
+ * DESCRIPTION:
+ * Sends a read attribute response for each attribute of a read that
+ * APP_bAttributeCacheLookup accepted, with sequence number u8SeqNum
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vAttributeCacheSend ( uint16    u16Addr,
+                                      uint8     u8Endpoint,
+                                      uint16    u16ClusterId,
+                                      uint8     u8Attributes,
+                                      uint16*   pu16Attributes,
+                                      uint8     u8SeqNum )
+{
+    tsAttributeCacheEntry*    psEntry;
+    uint8                     au8Buffer[ATTRIBUTE_CACHE_RESPONSE_HEADER + ATTRIBUTE_CACHE_MAX_RECORD + 1];
+    uint64                    u64IeeeAddr;
+    uint16                    u16Length;
+    uint8                     i;
+
+    u64IeeeAddr =  ZPS_u64AplZdoLookupIeeeAddr ( u16Addr );
+    for ( i = 0; i < u8Attributes; i++ )
+    {
+        psEntry =  APP_psAttributeCacheFind ( u64IeeeAddr, u8Endpoint, u16ClusterId, pu16Attributes[i] );
+        if ( psEntry == NULL )
+        {
+            continue;
+        }
+
+        u16Length =  0;
+        ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], u8SeqNum,                  u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[u16Length], u16Addr,                   u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], u8Endpoint,                u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[u16Length], u16ClusterId,              u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[u16Length], psEntry->u16AttributeId,   u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], E_ZCL_CMDS_SUCCESS,        u16Length );
+        memcpy ( &au8Buffer[u16Length], psEntry->au8Record, psEntry->u8RecordLength );
+        u16Length +=  psEntry->u8RecordLength;
+
+        vSL_WriteMessage ( E_SL_MSG_READ_ATTRIBUTE_RESPONSE,
+                           u16Length,
+                           au8Buffer,
+                           psEntry->u8LinkQuality );
+    }
+
+    vLog_Printf ( TRACE_ATTRIBUTE_CACHE, LOG_DEBUG, "\nAttribute cache served %d from %04x/%d cluster %04x",
+                  u8Attributes, u16Addr, u8Endpoint, u16ClusterId );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vAttributeCacheInvalidate
+ *
+ * DESCRIPTION:
+ * Drops the values of one cluster of a device endpoint, as the host is
+ * about to write to it
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vAttributeCacheInvalidate ( uint16    u16Addr,
+                                            uint8     u8Endpoint,
+                                            uint16    u16ClusterId )
+{
+    uint64    u64IeeeAddr;
+
+    u64IeeeAddr =  ZPS_u64AplZdoLookupIeeeAddr ( u16Addr );
+    if ( u64IeeeAddr != 0 )
+    {
+        APP_vAttributeCacheDrop ( u64IeeeAddr, u8Endpoint, u16ClusterId );
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vAttributeCacheRemoveDevice
+ *
+ * DESCRIPTION:
+ * Drops every value of a device that announced itself or left; it may have
+ * been reset or updated
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vAttributeCacheRemoveDevice ( uint64    u64IeeeAddr )
+{
+    if ( u64IeeeAddr != 0 )
+    {
+        APP_vAttributeCacheDrop ( u64IeeeAddr, 0xFF, ATTRIBUTE_CACHE_ANY_CLUSTER );
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8AttributeCacheSetRule
+ *
+ * DESCRIPTION:
+ * Handles E_SL_MSG_ATTRIBUTE_CACHE_SET_RULE:
+ *   u8Index, u16ClusterId, u32Ttl (seconds)
+ * A rule with a lifetime of 0 removes the rule at u8Index; u8Index 0xFF
+ * removes every rule, the default Basic cluster one included, and empties
+ * the cache. A rule for ATTRIBUTE_CACHE_ANY_CLUSTER applies to clusters
+ * without a rule of their own.
+ *
+ * RETURNS:
+ * Serial link status
+ *
+ ****************************************************************************/
+PUBLIC uint8 APP_u8AttributeCacheSetRule ( uint8*    pu8Payload,
+                                           uint16    u16PayloadLength )
+{
+    tsAttributeCacheRule*    psRule;
+    uint8                    u8Index;
+
+    if ( u16PayloadLength < 1 )
+    {
+        return E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+    }
+
+    u8Index =  pu8Payload[0];
+    if ( u8Index == ATTRIBUTE_CACHE_CLEAR_ALL )
+    {
+        memset ( asAttributeCacheRules,   0, sizeof ( asAttributeCacheRules ) );
+        memset ( asAttributeCacheEntries, 0, sizeof ( asAttributeCacheEntries ) );
+        return E_SL_MSG_STATUS_SUCCESS;
+    }
+
+    if ( ( u8Index >= ATTRIBUTE_CACHE_MAX_RULES ) ||
+         ( u16PayloadLength < ATTRIBUTE_CACHE_RULE_LENGTH ) )
+    {
+        return E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+    }
+
+    psRule =  &asAttributeCacheRules[u8Index];
+    /* Values held under the rule replaced were stored with its lifetime */
+    if ( psRule->bInUse )
+    {
+        APP_vAttributeCacheDrop ( 0, 0xFF, psRule->u16ClusterId );
+    }
+    psRule->u16ClusterId  =  ZNC_RTN_U16 ( pu8Payload, 1 );
+    psRule->u32Ttl        =  ZNC_RTN_U32 ( pu8Payload, 3 );
+    psRule->bInUse        =  ( psRule->u32Ttl != 0 );
+    APP_vAttributeCacheDrop ( 0, 0xFF, psRule->u16ClusterId );
+
+    vLog_Printf ( TRACE_ATTRIBUTE_CACHE, LOG_DEBUG, "\nAttribute cache rule %d cluster %04x %ds", u8Index,
+                  psRule->u16ClusterId, psRule->u32Ttl );
+
+    return E_SL_MSG_STATUS_SUCCESS;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u16AttributeCacheGetStats
+ *
+ * DESCRIPTION:
+ * Writes the E_SL_MSG_ATTRIBUTE_CACHE_STATS payload: number of active
+ * rules, values held, capacity, then the hit, miss, stored, expired,
+ * evicted and invalidated counters
+ *
+ * RETURNS:
+ * Number of bytes written
+ *
+ ****************************************************************************/
+PUBLIC uint16 APP_u16AttributeCacheGetStats ( uint8*    pu8Buffer,
+                                              bool_t    bReset )
+{
+    uint16    u16Length  =  0;
+    uint8     u8Rules    =  0;
+    uint8     u8Held     =  0;
+    uint8     i;
+
+    for ( i = 0; i < ATTRIBUTE_CACHE_MAX_RULES; i++ )
+    {
+        u8Rules +=  asAttributeCacheRules[i].bInUse ? 1 : 0;
+    }
+    for ( i = 0; i < ATTRIBUTE_CACHE_MAX_ENTRIES; i++ )
+    {
+        u8Held +=  ( asAttributeCacheEntries[i].u64IeeeAddr != 0 ) ? 1 : 0;
+    }
+
+    ZNC_BUF_U8_UPD  ( &pu8Buffer[u16Length], u8Rules,                               u16Length );
+    ZNC_BUF_U8_UPD  ( &pu8Buffer[u16Length], u8Held,                                u16Length );
+    ZNC_BUF_U8_UPD  ( &pu8Buffer[u16Length], ATTRIBUTE_CACHE_MAX_ENTRIES,           u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sAttributeCacheStats.u32Hits,          u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sAttributeCacheStats.u32Misses,        u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sAttributeCacheStats.u32Stored,        u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sAttributeCacheStats.u32Expired,       u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sAttributeCacheStats.u32Evicted,       u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sAttributeCacheStats.u32Invalidated,   u16Length );
+
+    if ( bReset )
+    {
+        memset ( &sAttributeCacheStats, 0, sizeof ( sAttributeCacheStats ) );
+    }
+
+    return u16Length;
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* Lifetime in seconds of the cluster's rule, else of the wildcard rule;
+ * 0 when the cluster is not cached */
+PRIVATE uint32 APP_u32AttributeCacheTtl ( uint16    u16ClusterId )
+{
+    uint32    u32Ttl =  0;
+    uint8     i;
+
+    for ( i = 0; i < ATTRIBUTE_CACHE_MAX_RULES; i++ )
+    {
+        if ( !asAttributeCacheRules[i].bInUse )
+        {
+            continue;
+        }
+        if ( asAttributeCacheRules[i].u16ClusterId == u16ClusterId )
+        {
+            return asAttributeCacheRules[i].u32Ttl;
+        }
+        if ( asAttributeCacheRules[i].u16ClusterId == ATTRIBUTE_CACHE_ANY_CLUSTER )
+        {
+            u32Ttl =  asAttributeCacheRules[i].u32Ttl;
+        }
+    }
+    return u32Ttl;
+}
+
+PRIVATE tsAttributeCacheEntry* APP_psAttributeCacheFind ( uint64    u64IeeeAddr,
+                                                          uint8     u8Endpoint,
+                                                          uint16    u16ClusterId,
+                                                          uint16    u16AttributeId )
+{
+    tsAttributeCacheEntry*    psEntry;
+    uint8                     i;
+
+    for ( i = 0; i < ATTRIBUTE_CACHE_MAX_ENTRIES; i++ )
+    {
+        psEntry =  &asAttributeCacheEntries[i];
+        if ( ( psEntry->u64IeeeAddr == u64IeeeAddr ) &&
+             ( psEntry->u16AttributeId == u16AttributeId ) &&
+             ( psEntry->u16ClusterId == u16ClusterId ) &&
+             ( psEntry->u8Endpoint == u8Endpoint ) )
+        {
+            return psEntry;
+        }
+    }
+    return NULL;
+}
+
+/* A free entry, else an expired one, else the one used least recently */
+PRIVATE tsAttributeCacheEntry* APP_psAttributeCacheAllocate ( void )
+{
+    tsAttributeCacheEntry*    psEntry;
+    tsAttributeCacheEntry*    psVictim =  &asAttributeCacheEntries[0];
+    uint8                     i;
+
+    for ( i = 0; i < ATTRIBUTE_CACHE_MAX_ENTRIES; i++ )
+    {
+        psEntry =  &asAttributeCacheEntries[i];
+        if ( psEntry->u64IeeeAddr == 0 )
+        {
+            return psEntry;
+        }
+        if ( !APP_bAttributeCacheIsFresh ( psEntry ) )
+        {
+            sAttributeCacheStats.u32Expired++;
+            return psEntry;
+        }
+        if ( ( u32AttributeCacheTicks - psEntry->u32LastUsed ) > ( u32AttributeCacheTicks - psVictim->u32LastUsed ) )
+        {
+            psVictim =  psEntry;
+        }
+    }
+
+    sAttributeCacheStats.u32Evicted++;
+    return psVictim;
+}
+
+PRIVATE bool_t APP_bAttributeCacheIsFresh ( tsAttributeCacheEntry*    psEntry )
+{
+    return ( ( u32AttributeCacheTicks - psEntry->u32StoredAt ) < psEntry->u32Ttl );
+}
+
+/* Drops the values matching a device (0 for any), endpoint (0xFF for any)
+ * and cluster (ATTRIBUTE_CACHE_ANY_CLUSTER for any) */
+PRIVATE void APP_vAttributeCacheDrop ( uint64    u64IeeeAddr,
+                                       uint8     u8Endpoint,
+                                       uint16    u16ClusterId )
+{
+    tsAttributeCacheEntry*    psEntry;
+    uint8                     i;
+
+    for ( i = 0; i < ATTRIBUTE_CACHE_MAX_ENTRIES; i++ )
+    {
+        psEntry =  &asAttributeCacheEntries[i];
+        if ( ( psEntry->u64IeeeAddr != 0 ) &&
+             ( ( u64IeeeAddr == 0 )                               || ( psEntry->u64IeeeAddr == u64IeeeAddr ) ) &&
+             ( ( u8Endpoint == 0xFF )                             || ( psEntry->u8Endpoint == u8Endpoint ) ) &&
+             ( ( u16ClusterId == ATTRIBUTE_CACHE_ANY_CLUSTER )    || ( psEntry->u16ClusterId == u16ClusterId ) ) )
+        {
+            memset ( psEntry, 0, sizeof ( tsAttributeCacheEntry ) );
+            sAttributeCacheStats.u32Invalidated++;
+        }
+    }
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
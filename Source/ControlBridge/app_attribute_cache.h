@@ -0,0 +1,126 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_attribute_cache.h
+ *
+ * DESCRIPTION:        Cache of attribute values answering repeated host
+ *                     reads without going on air (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef APP_ATTRIBUTE_CACHE_H_
+#define APP_ATTRIBUTE_CACHE_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Number of (device, endpoint, cluster, attribute) values held, enough for
+ * the five Basic cluster attributes a host reads of a dozen devices */
+#ifndef ATTRIBUTE_CACHE_MAX_ENTRIES
+#define ATTRIBUTE_CACHE_MAX_ENTRIES         64
+#endif
+
+/* Type, size and value bytes of a read attribute response; longer values,
+ * beyond a 32 character string, are not cached */
+#ifndef ATTRIBUTE_CACHE_MAX_RECORD
+#define ATTRIBUTE_CACHE_MAX_RECORD          35
+#endif
+
+/* Number of per cluster lifetimes the host can set */
+#ifndef ATTRIBUTE_CACHE_MAX_RULES
+#define ATTRIBUTE_CACHE_MAX_RULES           8
+#endif
+
+/* Lifetime of Basic cluster values until the host sets its own rules */
+#ifndef ATTRIBUTE_CACHE_BASIC_TTL
+#define ATTRIBUTE_CACHE_BASIC_TTL           86400
+#endif
+
+/* Rule cluster matching any cluster not named by another rule */
+#define ATTRIBUTE_CACHE_ANY_CLUSTER         0xFFFF
+
+/* Rule index that clears the whole rule table and the cache */
+#define ATTRIBUTE_CACHE_CLEAR_ALL           0xFF
+
+/* Length of the E_SL_MSG_ATTRIBUTE_CACHE_SET_RULE payload */
+#define ATTRIBUTE_CACHE_RULE_LENGTH         7
+
+/* Value of the "request sent" field of the status message for a read
+ * answered from the cache */
+#define ATTRIBUTE_CACHE_REQUEST_SERVED      4
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vAttributeCacheInit ( void );
+PUBLIC void APP_vAttributeCacheTick ( void );
+PUBLIC void APP_vAttributeCacheStore ( uint16    u16Addr,
+                                       uint8     u8Endpoint,
+                                       uint16    u16ClusterId,
+                                       uint16    u16AttributeId,
+                                       uint8*    pu8Record,
+                                       uint16    u16RecordLength,
+                                       uint8     u8LinkQuality );
+PUBLIC bool_t APP_bAttributeCacheLookup ( uint16    u16Addr,
+                                          uint8     u8Endpoint,
+                                          uint16    u16ClusterId,
+                                          uint8     u8Attributes,
+                                          uint16*   pu16Attributes );
+PUBLIC void APP_vAttributeCacheSend ( uint16    u16Addr,
+                                      uint8     u8Endpoint,
+                                      uint16    u16ClusterId,
+                                      uint8     u8Attributes,
+                                      uint16*   pu16Attributes,
+                                      uint8     u8SeqNum );
+PUBLIC void APP_vAttributeCacheInvalidate ( uint16    u16Addr,
+                                            uint8     u8Endpoint,
+                                            uint16    u16ClusterId );
+PUBLIC void APP_vAttributeCacheRemoveDevice ( uint64    u64IeeeAddr );
+PUBLIC uint8 APP_u8AttributeCacheSetRule ( uint8*    pu8Payload,
+                                           uint16    u16PayloadLength );
+PUBLIC uint16 APP_u16AttributeCacheGetStats ( uint8*    pu8Buffer,
+                                              bool_t    bReset );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_ATTRIBUTE_CACHE_H_ */
@@ -0,0 +1,772 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_beacon_filter.c
+ *
+ * DESCRIPTION:        Beacon filter tables and per channel congestion
+ *                     statistics (Implementation)
+ *
+ *                     The extended PAN ID list of a host filter is hashed
+ *                     once when the filter is installed, ahead of the scan,
+ *                     so the stack's beacon handler decides each beacon
+ *                     with one table lookup instead of walking the list.
+ *                     Every Zigbee beacon heard during a scan is counted
+ *                     per channel: beacons, distinct networks, average
+ *                     link quality and beacons permitting joins.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zps_apl_af.h"
+#include "TimersManager.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_beacon_filter.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_BEACON_FILTER
+#define TRACE_BEACON_FILTER             TRUE
+#else
+#define TRACE_BEACON_FILTER             FALSE
+#endif
+
+/* Open addressed tables, the extended PAN ID table is kept at most half
+ * full so a miss ends after a probe or two */
+#define BEACON_FILTER_EPID_TABLE_SIZE   ( 2 * BEACON_FILTER_MAX_EPIDS + 1 )
+#define BEACON_FILTER_NETWORK_LIMIT     ( ( BEACON_FILTER_SCAN_NETWORKS * 3 ) / 4 )
+
+/* Set: operation, u16 filter map, u16 PAN ID, u8 LQI, u8 depth, u8 count */
+#define BEACON_FILTER_SET_HEADER        8
+
+#define BEACON_FILTER_CHANNEL_REPORT    7
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint64    u64ExtendedPanId;
+    uint16    u16PanId;
+    uint8     u8Channel;
+} tsBeaconFilterNetwork;
+
+typedef struct
+{
+    uint32    u32LqiSum;
+    uint16    u16Beacons;
+    uint16    u16PermitJoin;
+    uint8     u8Networks;
+} tsBeaconFilterChannel;
+
+typedef struct
+{
+    tsBeaconFilterChannel    asChannel[BEACON_FILTER_CHANNELS];
+    uint64                   u64LastBeacon;
+    uint16                   u16Scans;
+    uint16                   u16Overflows;
+    uint16                   u16Networks;
+} tsBeaconFilterStats;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE uint32 APP_u32BeaconFilterHash ( uint64    u64ExtendedPanId,
+                                         uint16    u16PanId,
+                                         uint8     u8Channel );
+PRIVATE void APP_vBeaconFilterBuild ( void );
+PRIVATE void APP_vBeaconFilterCount ( uint8     u8Channel,
+                                      uint16    u16PanId,
+                                      uint64    u64ExtendedPanId );
+PRIVATE uint8 APP_u8BeaconFilterSet ( uint8*    pu8Command,
+                                      uint16    u16Length );
+PRIVATE void APP_vBeaconFilterRespond ( uint8    u8Operation,
+                                        uint8    u8Status,
+                                        uint8    u8Value );
+PRIVATE void APP_vBeaconFilterSendStats ( void );
+#ifdef BEACON_FILTER_BENCHMARK
+PRIVATE uint64 APP_u64BeaconFilterSynthetic ( MAC_MlmeDcfmInd_s*    psIndication,
+                                              uint8                 u8Channel,
+                                              uint8                 u8Network );
+PRIVATE void APP_vBeaconFilterBenchmark ( uint16    u16PerChannel,
+                                          uint8     u8ListSize,
+                                          uint8     u8Networks );
+#endif
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Imported Variables                                            ***/
+/****************************************************************************/
+extern tsBeaconFilterType*    psBeaconFilter;
+extern uint64 zps_u64NwkLibFromPayload ( uint8*    pu8Buffer );
+extern PUBLIC bool_t ZPS_bAppPassBeaconToHigherLayer ( MAC_MlmeDcfmInd_s*    psBeaconIndication );
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsBeaconFilterType       sBeaconFilter;
+PRIVATE uint64                   au64BeaconFilterEpid[BEACON_FILTER_MAX_EPIDS];
+/* Index into au64BeaconFilterEpid plus one, 0 for a free entry */
+PRIVATE uint8                    au8BeaconFilterEpidTable[BEACON_FILTER_EPID_TABLE_SIZE];
+PRIVATE bool_t                   bBeaconFilterTables =  TRUE;
+PRIVATE bool_t                   bBeaconFilterPaused =  FALSE;
+PRIVATE tsBeaconFilterNetwork    asBeaconFilterNetwork[BEACON_FILTER_SCAN_NETWORKS];
+PRIVATE tsBeaconFilterStats      sBeaconFilterStats;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vBeaconFilterCommand
+ *
+ * DESCRIPTION:
+ * Handles E_SL_MSG_BEACON_FILTER. The first byte selects the operation:
+ *  STATS     - optional options byte, see APP_vBeaconFilterSendStats
+ *  SET       - u16 filter map, u16 PAN ID, u8 LQI, u8 depth, u8 count and
+ *              count u64 extended PAN IDs, as tsBeaconFilterType
+ *  CLEAR     - removes the filter
+ *  BENCHMARK - optional u16 beacons per channel, u8 list size, u8 networks
+ *              per channel
+ * SET and CLEAR are answered with E_SL_MSG_BEACON_FILTER_RESPONSE carrying
+ * operation, status and the extended PAN IDs held.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vBeaconFilterCommand ( uint8*    pu8Command,
+                                       uint16    u16Length )
+{
+    uint8    u8Operation;
+
+    if ( u16Length == 0 )
+    {
+        return;
+    }
+    u8Operation =  pu8Command[0];
+
+    switch ( u8Operation )
+    {
+        case BEACON_FILTER_OP_STATS:
+            APP_vBeaconFilterSendStats ( );
+            if ( ( u16Length > 1 ) && ( pu8Command[1] & BEACON_FILTER_OPTION_RESET ) )
+            {
+                memset ( &sBeaconFilterStats, 0, sizeof ( sBeaconFilterStats ) );
+                memset ( asBeaconFilterNetwork, 0, sizeof ( asBeaconFilterNetwork ) );
+            }
+        break;
+
+        case BEACON_FILTER_OP_SET:
+            APP_vBeaconFilterRespond ( u8Operation,
+                                       APP_u8BeaconFilterSet ( pu8Command, u16Length ),
+                                       sBeaconFilter.u8ListSize );
+        break;
+
+        case BEACON_FILTER_OP_CLEAR:
+            if ( psBeaconFilter == &sBeaconFilter )
+            {
+                ZPS_bAppRemoveBeaconFilter ( );
+            }
+            memset ( &sBeaconFilter, 0, sizeof ( sBeaconFilter ) );
+            APP_vBeaconFilterBuild ( );
+            APP_vBeaconFilterRespond ( u8Operation, BEACON_FILTER_STATUS_OK, 0 );
+        break;
+
+#ifdef BEACON_FILTER_BENCHMARK
+        case BEACON_FILTER_OP_BENCHMARK:
+            APP_vBeaconFilterBenchmark ( ( u16Length >= 3 ) ? ZNC_RTN_U16 ( pu8Command, 1 ) : 0,
+                                         ( u16Length >= 4 ) ? pu8Command[3] : 0,
+                                         ( u16Length >= 5 ) ? pu8Command[4] : 0 );
+        break;
+#endif
+
+        default:
+            APP_vBeaconFilterRespond ( u8Operation, BEACON_FILTER_STATUS_UNSUPPORTED, 0 );
+        break;
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u32BeaconFilterQuietChannels
+ *
+ * DESCRIPTION:
+ * Narrows a formation channel mask to the channels the last scan heard
+ * carrying fewer than BEACON_FILTER_CONGESTED_NETWORKS networks, or to the
+ * least congested one when all are busy
+ *
+ * RETURNS:
+ * Channel mask, unchanged when no beacon was heard on any of its channels
+ *
+ ****************************************************************************/
+PUBLIC uint32 APP_u32BeaconFilterQuietChannels ( uint32    u32ChannelMask )
+{
+    tsBeaconFilterChannel*    psChannel;
+    uint32                    u32Quiet   =  0;
+    bool_t                    bHeard     =  FALSE;
+    uint8                     u8Fewest   =  0xFF;
+    uint8                     u8Best     =  0;
+    uint8                     i;
+
+    for ( i = 0; i < BEACON_FILTER_CHANNELS; i++ )
+    {
+        if ( ( u32ChannelMask & ( 1UL << ( BEACON_FILTER_FIRST_CHANNEL + i ) ) ) == 0 )
+        {
+            continue;
+        }
+        psChannel =  &sBeaconFilterStats.asChannel[i];
+        if ( psChannel->u16Beacons > 0 )
+        {
+            bHeard =  TRUE;
+        }
+        if ( psChannel->u8Networks < BEACON_FILTER_CONGESTED_NETWORKS )
+        {
+            u32Quiet |=  1UL << ( BEACON_FILTER_FIRST_CHANNEL + i );
+        }
+        if ( psChannel->u8Networks < u8Fewest )
+        {
+            u8Fewest =  psChannel->u8Networks;
+            u8Best   =  BEACON_FILTER_FIRST_CHANNEL + i;
+        }
+    }
+
+    if ( !bHeard )
+    {
+        return u32ChannelMask;
+    }
+    if ( u32Quiet == 0 )
+    {
+        u32Quiet =  1UL << u8Best;
+    }
+    vLog_Printf ( TRACE_BEACON_FILTER, LOG_DEBUG, "\nBeacon filter: formation mask %08x -> %08x", u32ChannelMask, u32Quiet );
+    return u32Quiet;
+}
+
+/****************************************************************************
+ *
+ * NAME: vAPPBeaconHandler
+ *
+ * DESCRIPTION:
+ * Called by ZPS_bAppPassBeaconToHigherLayer for every Zigbee beacon ahead
+ * of filtering. Counts it against its channel, a beacon heard after
+ * BEACON_FILTER_SCAN_GAP_US of silence starts the counts of a new scan.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void vAPPBeaconHandler ( MAC_MlmeDcfmInd_s*    psBeaconIndication )
+{
+    MAC_MlmeIndBeacon_s*      psBeacon =  &psBeaconIndication->uParam.sIndBeacon;
+    tsBeaconFilterChannel*    psChannel;
+    uint64                    u64Now;
+    uint8                     u8Channel =  psBeacon->sPANdescriptor.u8LogicalChan;
+
+    if ( bBeaconFilterPaused ||
+         ( u8Channel < BEACON_FILTER_FIRST_CHANNEL ) ||
+         ( u8Channel >= ( BEACON_FILTER_FIRST_CHANNEL + BEACON_FILTER_CHANNELS ) ) )
+    {
+        return;
+    }
+
+    u64Now =  TMR_GetTimestamp ( );
+    if ( ( sBeaconFilterStats.u16Scans == 0 ) ||
+         ( ( u64Now - sBeaconFilterStats.u64LastBeacon ) > BEACON_FILTER_SCAN_GAP_US ) )
+    {
+        memset ( sBeaconFilterStats.asChannel, 0, sizeof ( sBeaconFilterStats.asChannel ) );
+        memset ( asBeaconFilterNetwork, 0, sizeof ( asBeaconFilterNetwork ) );
+        sBeaconFilterStats.u16Networks =  0;
+        sBeaconFilterStats.u16Scans++;
+    }
+    sBeaconFilterStats.u64LastBeacon =  u64Now;
+
+    psChannel =  &sBeaconFilterStats.asChannel[u8Channel - BEACON_FILTER_FIRST_CHANNEL];
+    if ( psChannel->u16Beacons < 0xFFFF )
+    {
+        psChannel->u16Beacons++;
+        psChannel->u32LqiSum +=  psBeacon->sPANdescriptor.u8LinkQuality;
+        if ( BF_GET_ASSOC_PERMIT ( psBeacon->sPANdescriptor.u16SuperframeSpec ) )
+        {
+            psChannel->u16PermitJoin++;
+        }
+    }
+
+    APP_vBeaconFilterCount ( u8Channel,
+                             psBeacon->sPANdescriptor.sCoord.u16PanId,
+                             zps_u64NwkLibFromPayload ( BF_BCN_PL_EXT_PAN_ID_PTR ( psBeacon->u8SDU ) ) );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bBeaconFilterListed
+ *
+ * DESCRIPTION:
+ * Looks an extended PAN ID up in the table built for the filter, called by
+ * ZPS_bAppPassBeaconToHigherLayer in place of walking the filter's list
+ *
+ * RETURNS:
+ * TRUE with *pbListed set if the filter is the one installed from here,
+ * FALSE if the list must be walked
+ *
+ ****************************************************************************/
+PUBLIC bool_t APP_bBeaconFilterListed ( tsBeaconFilterType*    psFilter,
+                                        uint64                 u64ExtendedPanId,
+                                        bool_t*                pbListed )
+{
+    uint32    u32Entry;
+    uint8     u8Index;
+    uint8     i;
+
+    if ( ( psFilter != &sBeaconFilter ) || !bBeaconFilterTables )
+    {
+        return FALSE;
+    }
+
+    *pbListed =  FALSE;
+    u32Entry  =  APP_u32BeaconFilterHash ( u64ExtendedPanId, 0, 0 ) % BEACON_FILTER_EPID_TABLE_SIZE;
+    for ( i = 0; i < BEACON_FILTER_EPID_TABLE_SIZE; i++ )
+    {
+        u8Index =  au8BeaconFilterEpidTable[u32Entry];
+        if ( u8Index == 0 )
+        {
+            break;
+        }
+        if ( au64BeaconFilterEpid[u8Index - 1] == u64ExtendedPanId )
+        {
+            *pbListed =  TRUE;
+            break;
+        }
+        u32Entry =  ( u32Entry + 1 ) % BEACON_FILTER_EPID_TABLE_SIZE;
+    }
+    return TRUE;
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_u32BeaconFilterHash
+ *
+ * DESCRIPTION:
+ * Mixes a network's identifiers into a table index
+ *
+ * RETURNS:
+ * Hash value
+ *
+ ****************************************************************************/
+PRIVATE uint32 APP_u32BeaconFilterHash ( uint64    u64ExtendedPanId,
+                                         uint16    u16PanId,
+                                         uint8     u8Channel )
+{
+    /* Multiplied as 64 bits: folding the halves together first sent IDs
+     * with related halves to one probe chain */
+    uint64    u64Hash =  ( u64ExtendedPanId ^ ( ( uint64 ) u16PanId << 8 ) ^ u8Channel ) * 0x9E3779B97F4A7C15ULL;
+
+    return ( uint32 ) ( u64Hash >> 32 );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vBeaconFilterBuild
+ *
+ * DESCRIPTION:
+ * Hashes the extended PAN IDs of the filter into au8BeaconFilterEpidTable
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vBeaconFilterBuild ( void )
+{
+    uint32    u32Entry;
+    uint8     i;
+
+    memset ( au8BeaconFilterEpidTable, 0, sizeof ( au8BeaconFilterEpidTable ) );
+    for ( i = 0; i < sBeaconFilter.u8ListSize; i++ )
+    {
+        u32Entry =  APP_u32BeaconFilterHash ( au64BeaconFilterEpid[i], 0, 0 ) % BEACON_FILTER_EPID_TABLE_SIZE;
+        while ( au8BeaconFilterEpidTable[u32Entry] != 0 )
+        {
+            u32Entry =  ( u32Entry + 1 ) % BEACON_FILTER_EPID_TABLE_SIZE;
+        }
+        au8BeaconFilterEpidTable[u32Entry] =  i + 1;
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vBeaconFilterCount
+ *
+ * DESCRIPTION:
+ * Records a network heard during the current scan, counting it against its
+ * channel the first time it is heard
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vBeaconFilterCount ( uint8     u8Channel,
+                                      uint16    u16PanId,
+                                      uint64    u64ExtendedPanId )
+{
+    tsBeaconFilterNetwork*    psNetwork;
+    uint32                    u32Entry =  APP_u32BeaconFilterHash ( u64ExtendedPanId, u16PanId, u8Channel ) % BEACON_FILTER_SCAN_NETWORKS;
+    uint16                    i;
+
+    for ( i = 0; i < BEACON_FILTER_SCAN_NETWORKS; i++ )
+    {
+        psNetwork =  &asBeaconFilterNetwork[u32Entry];
+        if ( psNetwork->u8Channel == 0 )
+        {
+            break;
+        }
+        if ( ( psNetwork->u8Channel == u8Channel ) &&
+             ( psNetwork->u16PanId == u16PanId ) &&
+             ( psNetwork->u64ExtendedPanId == u64ExtendedPanId ) )
+        {
+            return;
+        }
+        u32Entry =  ( u32Entry + 1 ) % BEACON_FILTER_SCAN_NETWORKS;
+    }
+
+    if ( sBeaconFilterStats.u16Networks >= BEACON_FILTER_NETWORK_LIMIT )
+    {
+        sBeaconFilterStats.u16Overflows++;
+        return;
+    }
+    psNetwork->u64ExtendedPanId =  u64ExtendedPanId;
+    psNetwork->u16PanId         =  u16PanId;
+    psNetwork->u8Channel        =  u8Channel;
+    sBeaconFilterStats.u16Networks++;
+    if ( sBeaconFilterStats.asChannel[u8Channel - BEACON_FILTER_FIRST_CHANNEL].u8Networks < 0xFF )
+    {
+        sBeaconFilterStats.asChannel[u8Channel - BEACON_FILTER_FIRST_CHANNEL].u8Networks++;
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8BeaconFilterSet
+ *
+ * DESCRIPTION:
+ * Installs the filter carried by a BEACON_FILTER_OP_SET command and builds
+ * its lookup table
+ *
+ * RETURNS:
+ * E_SL_MSG_BEACON_FILTER_RESPONSE status
+ *
+ ****************************************************************************/
+PRIVATE uint8 APP_u8BeaconFilterSet ( uint8*    pu8Command,
+                                      uint16    u16Length )
+{
+    uint8    u8Count;
+    uint8    i;
+
+    if ( u16Length < BEACON_FILTER_SET_HEADER )
+    {
+        return BEACON_FILTER_STATUS_MALFORMED;
+    }
+    u8Count =  pu8Command[7];
+    if ( u8Count > BEACON_FILTER_MAX_EPIDS )
+    {
+        return BEACON_FILTER_STATUS_TOO_MANY;
+    }
+    if ( u16Length < ( BEACON_FILTER_SET_HEADER + u8Count * sizeof ( uint64 ) ) )
+    {
+        return BEACON_FILTER_STATUS_MALFORMED;
+    }
+
+    sBeaconFilter.u16FilterMap        =  ZNC_RTN_U16 ( pu8Command, 1 );
+    sBeaconFilter.u16Panid            =  ZNC_RTN_U16 ( pu8Command, 3 );
+    sBeaconFilter.u8Lqi               =  pu8Command[5];
+    sBeaconFilter.u8Depth             =  pu8Command[6];
+    sBeaconFilter.u8ListSize          =  u8Count;
+    sBeaconFilter.pu64ExtendPanIdList =  au64BeaconFilterEpid;
+    for ( i = 0; i < u8Count; i++ )
+    {
+        au64BeaconFilterEpid[i] =  ZNC_RTN_U64 ( pu8Command, BEACON_FILTER_SET_HEADER + i * sizeof ( uint64 ) );
+    }
+    APP_vBeaconFilterBuild ( );
+    ZPS_bAppAddBeaconFilter ( &sBeaconFilter );
+
+    vLog_Printf ( TRACE_BEACON_FILTER, LOG_DEBUG, "\nBeacon filter: map %04x, %d extended PAN IDs",
+                  sBeaconFilter.u16FilterMap, u8Count );
+    return BEACON_FILTER_STATUS_OK;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vBeaconFilterRespond
+ *
+ * DESCRIPTION:
+ * Sends E_SL_MSG_BEACON_FILTER_RESPONSE
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vBeaconFilterRespond ( uint8    u8Operation,
+                                        uint8    u8Status,
+                                        uint8    u8Value )
+{
+    uint8     au8Buffer[3 + 1];
+    uint16    u16Length =  0;
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Operation,  u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Status,     u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Value,      u16Length );
+    vSL_WriteMessage ( E_SL_MSG_BEACON_FILTER_RESPONSE,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vBeaconFilterSendStats
+ *
+ * DESCRIPTION:
+ * Sends E_SL_MSG_BEACON_FILTER_RESPONSE for BEACON_FILTER_OP_STATS:
+ * operation, status, u16 scans, u16 networks not tracked for lack of room,
+ * u16 networks heard, channel count, then per channel its number, u16
+ * beacons, networks, average LQI and u16 beacons permitting joins, all for
+ * the latest scan
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vBeaconFilterSendStats ( void )
+{
+    tsBeaconFilterChannel*    psChannel;
+    uint8                     au8Buffer[9 + BEACON_FILTER_CHANNELS * BEACON_FILTER_CHANNEL_REPORT + 1];
+    uint16                    u16Length =  0;
+    uint8                     i;
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], BEACON_FILTER_OP_STATS,            u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], BEACON_FILTER_STATUS_OK,           u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], sBeaconFilterStats.u16Scans,       u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], sBeaconFilterStats.u16Overflows,   u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], sBeaconFilterStats.u16Networks,    u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], BEACON_FILTER_CHANNELS,            u16Length );
+    for ( i = 0; i < BEACON_FILTER_CHANNELS; i++ )
+    {
+        psChannel =  &sBeaconFilterStats.asChannel[i];
+        ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], BEACON_FILTER_FIRST_CHANNEL + i,    u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], psChannel->u16Beacons,              u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], psChannel->u8Networks,              u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ],
+                          ( psChannel->u16Beacons > 0 ) ? ( uint8 ) ( psChannel->u32LqiSum / psChannel->u16Beacons ) : 0,
+                          u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], psChannel->u16PermitJoin,           u16Length );
+    }
+    vSL_WriteMessage ( E_SL_MSG_BEACON_FILTER_RESPONSE,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+}
+
+#ifdef BEACON_FILTER_BENCHMARK
+/****************************************************************************
+ *
+ * NAME: APP_u64BeaconFilterSynthetic
+ *
+ * DESCRIPTION:
+ * Fills in the beacon of a made up network, each channel and network
+ * number giving its own PAN ID and extended PAN ID
+ *
+ * RETURNS:
+ * Extended PAN ID of the network
+ *
+ ****************************************************************************/
+PRIVATE uint64 APP_u64BeaconFilterSynthetic ( MAC_MlmeDcfmInd_s*    psIndication,
+                                              uint8                 u8Channel,
+                                              uint8                 u8Network )
+{
+    MAC_MlmeIndBeacon_s*    psBeacon =  &psIndication->uParam.sIndBeacon;
+    uint32                  u32Seed  =  ( ( ( uint32 ) u8Channel << 8 ) | u8Network ) * 2654435761UL;
+    uint8                   i;
+
+    psBeacon->sPANdescriptor.sCoord.u16PanId    =  ( uint16 ) ( u32Seed >> 16 );
+    psBeacon->sPANdescriptor.u8LogicalChan      =  u8Channel;
+    psBeacon->sPANdescriptor.u8LinkQuality      =  ( uint8 ) ( 40 + ( u8Network * 37 ) % 200 );
+    psBeacon->sPANdescriptor.u16SuperframeSpec  =  ( u8Network & 1 ) ? BF_ASSOC_PERMIT_MASK : 0;
+    psBeacon->u8SDUlength                       =  15;
+    /* Protocol ID 0, ZigBee PRO stack profile, protocol version 2, router
+     * and end device capacity at depth 0 */
+    psBeacon->u8SDU[0]                          =  0x00;
+    psBeacon->u8SDU[1]                          =  0x22;
+    psBeacon->u8SDU[2]                          =  0x84;
+    for ( i = 0; i < sizeof ( uint64 ); i++ )
+    {
+        psBeacon->u8SDU[3 + i] =  ( uint8 ) ( u32Seed >> ( ( i & 3 ) * 8 ) ) ^ ( uint8 ) ( i * 0x5B );
+    }
+    memset ( &psBeacon->u8SDU[11], 0xFF, 4 );
+    return zps_u64NwkLibFromPayload ( BF_BCN_PL_EXT_PAN_ID_PTR ( psBeacon->u8SDU ) );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vBeaconFilterBenchmark
+ *
+ * DESCRIPTION:
+ * Replays u16PerChannel synthetic beacons on every channel through the
+ * stack's beacon handler three times: with no filter, with a blacklist of
+ * u8ListSize extended PAN IDs walked as a list and with the same blacklist
+ * looked up in its table. The installed filter and the scan statistics
+ * are left as they were. Reports E_SL_MSG_BEACON_FILTER_RESPONSE:
+ * operation, status, u16 beacons per channel, list size, networks per
+ * channel, then u32 microseconds and u16 beacons passed for each run.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vBeaconFilterBenchmark ( uint16    u16PerChannel,
+                                          uint8     u8ListSize,
+                                          uint8     u8Networks )
+{
+    MAC_MlmeDcfmInd_s      sIndication;
+    tsBeaconFilterType*    psSavedFilter =  psBeaconFilter;
+    tsBeaconFilterType     sSavedFilter  =  sBeaconFilter;
+    uint64                 au64SavedEpid[BEACON_FILTER_MAX_EPIDS];
+    uint64                 u64Start;
+    uint32                 au32Us[3];
+    uint16                 au16Passed[3];
+    uint8                  au8Buffer[6 + 3 * ( sizeof ( uint32 ) + sizeof ( uint16 ) ) + 1];
+    uint16                 u16Length =  0;
+    uint16                 n;
+    uint8                  u8Run;
+    uint8                  u8Channel;
+
+    if ( ( u16PerChannel == 0 ) || ( u16PerChannel > BEACON_FILTER_BENCHMARK_MAX_BEACONS ) )
+    {
+        u16PerChannel =  BEACON_FILTER_BENCHMARK_BEACONS;
+    }
+    if ( ( u8ListSize == 0 ) || ( u8ListSize > BEACON_FILTER_MAX_EPIDS ) )
+    {
+        u8ListSize =  BEACON_FILTER_MAX_EPIDS;
+    }
+    if ( u8Networks == 0 )
+    {
+        u8Networks =  BEACON_FILTER_BENCHMARK_NETWORKS;
+    }
+
+    memset ( &sIndication, 0, sizeof ( sIndication ) );
+    memcpy ( au64SavedEpid, au64BeaconFilterEpid, sizeof ( au64SavedEpid ) );
+
+    /* Blacklist networks spread over all channels, with an LQI floor so the
+     * beacons that pass the list still go through a second check */
+    sBeaconFilter.u16FilterMap        =  BF_BITMAP_BLACKLIST | BF_BITMAP_LQI;
+    sBeaconFilter.u8Lqi               =  60;
+    sBeaconFilter.u8ListSize          =  u8ListSize;
+    sBeaconFilter.pu64ExtendPanIdList =  au64BeaconFilterEpid;
+    for ( n = 0; n < u8ListSize; n++ )
+    {
+        au64BeaconFilterEpid[n] =  APP_u64BeaconFilterSynthetic ( &sIndication,
+                                                                  BEACON_FILTER_FIRST_CHANNEL + ( n % BEACON_FILTER_CHANNELS ),
+                                                                  ( uint8 ) ( n % u8Networks ) );
+    }
+    APP_vBeaconFilterBuild ( );
+
+    bBeaconFilterPaused =  TRUE;
+    for ( u8Run = 0; u8Run < 3; u8Run++ )
+    {
+        if ( u8Run == 0 )
+        {
+            ZPS_bAppRemoveBeaconFilter ( );
+        }
+        else
+        {
+            ZPS_bAppAddBeaconFilter ( &sBeaconFilter );
+        }
+        bBeaconFilterTables =  ( u8Run == 2 );
+        au16Passed[u8Run]   =  0;
+
+        u64Start =  TMR_GetTimestamp ( );
+        for ( u8Channel = BEACON_FILTER_FIRST_CHANNEL; u8Channel < ( BEACON_FILTER_FIRST_CHANNEL + BEACON_FILTER_CHANNELS ); u8Channel++ )
+        {
+            for ( n = 0; n < u16PerChannel; n++ )
+            {
+                APP_u64BeaconFilterSynthetic ( &sIndication, u8Channel, ( uint8 ) ( n % u8Networks ) );
+                if ( ZPS_bAppPassBeaconToHigherLayer ( &sIndication ) )
+                {
+                    au16Passed[u8Run]++;
+                }
+            }
+        }
+        au32Us[u8Run] =  ( uint32 ) ( TMR_GetTimestamp ( ) - u64Start );
+    }
+    bBeaconFilterPaused =  FALSE;
+    bBeaconFilterTables =  TRUE;
+
+    sBeaconFilter =  sSavedFilter;
+    memcpy ( au64BeaconFilterEpid, au64SavedEpid, sizeof ( au64SavedEpid ) );
+    APP_vBeaconFilterBuild ( );
+    if ( psSavedFilter != NULL )
+    {
+        ZPS_bAppAddBeaconFilter ( psSavedFilter );
+    }
+    else
+    {
+        ZPS_bAppRemoveBeaconFilter ( );
+    }
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], BEACON_FILTER_OP_BENCHMARK,    u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], BEACON_FILTER_STATUS_OK,       u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], u16PerChannel,                 u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8ListSize,                    u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Networks,                    u16Length );
+    for ( u8Run = 0; u8Run < 3; u8Run++ )
+    {
+        ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], au32Us[u8Run],             u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], au16Passed[u8Run],         u16Length );
+    }
+    vSL_WriteMessage ( E_SL_MSG_BEACON_FILTER_RESPONSE,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+}
+#endif
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,114 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_beacon_filter.h
+ *
+ * DESCRIPTION:        Beacon filter tables and per channel congestion
+ *                     statistics (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef APP_BEACON_FILTER_H_
+#define APP_BEACON_FILTER_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include "mac_sap.h"
+#include "appZpsBeaconHandler.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Extended PAN IDs a host filter may list */
+#ifndef BEACON_FILTER_MAX_EPIDS
+#define BEACON_FILTER_MAX_EPIDS             24
+#endif
+
+/* Networks (channel, PAN ID, extended PAN ID) told apart during one scan */
+#ifndef BEACON_FILTER_SCAN_NETWORKS
+#define BEACON_FILTER_SCAN_NETWORKS         128
+#endif
+
+/* A channel heard carrying this many networks is left out of formation
+ * when a quieter channel in the mask was scanned */
+#ifndef BEACON_FILTER_CONGESTED_NETWORKS
+#define BEACON_FILTER_CONGESTED_NETWORKS    6
+#endif
+
+/* Silence between beacons that starts a new scan */
+#define BEACON_FILTER_SCAN_GAP_US           5000000
+
+#define BEACON_FILTER_FIRST_CHANNEL         11
+#define BEACON_FILTER_CHANNELS              16
+
+/* Synthetic beacons replayed per channel by default and at most */
+#define BEACON_FILTER_BENCHMARK_BEACONS     500
+#define BEACON_FILTER_BENCHMARK_MAX_BEACONS 1000
+#define BEACON_FILTER_BENCHMARK_NETWORKS    40
+
+/* E_SL_MSG_BEACON_FILTER operations, first byte of the command */
+#define BEACON_FILTER_OP_STATS              0
+#define BEACON_FILTER_OP_SET                1
+#define BEACON_FILTER_OP_CLEAR              2
+#define BEACON_FILTER_OP_BENCHMARK          3
+
+/* BEACON_FILTER_OP_STATS option bits */
+#define BEACON_FILTER_OPTION_RESET          0x01
+
+/* E_SL_MSG_BEACON_FILTER_RESPONSE status */
+#define BEACON_FILTER_STATUS_OK             0
+#define BEACON_FILTER_STATUS_MALFORMED      1
+#define BEACON_FILTER_STATUS_TOO_MANY       2
+#define BEACON_FILTER_STATUS_UNSUPPORTED    3
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vBeaconFilterCommand ( uint8*    pu8Command,
+                                       uint16    u16Length );
+PUBLIC uint32 APP_u32BeaconFilterQuietChannels ( uint32    u32ChannelMask );
+PUBLIC void vAPPBeaconHandler ( MAC_MlmeDcfmInd_s*    psBeaconIndication );
+PUBLIC bool_t APP_bBeaconFilterListed ( tsBeaconFilterType*    psFilter,
+                                        uint64                 u64ExtendedPanId,
+                                        bool_t*                pbListed );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_BEACON_FILTER_H_ */
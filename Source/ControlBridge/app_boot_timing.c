@@ -0,0 +1,134 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_boot_timing.c
+ *
+ * DESCRIPTION:        Boot stage timestamps reported to the host
+ *                     (Implementation)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include "TimersManager.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "app_boot_timing.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE uint64    au64BootTimingStamp[E_BOOT_TIMING_COUNT];
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vBootTimingMark
+ *
+ * DESCRIPTION:
+ * Records the time a boot stage completed
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vBootTimingMark ( teBootTimingStage    eStage )
+{
+    if ( eStage < E_BOOT_TIMING_COUNT )
+    {
+        au64BootTimingStamp[eStage] =  TMR_GetTimestamp ( );
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vBootTimingSend
+ *
+ * DESCRIPTION:
+ * Sends E_SL_MSG_BOOT_TIMING: version, whether application tables are
+ * restored after the stack starts, stage count, then the time in us from
+ * E_BOOT_TIMING_START to the end of every stage (0 when not reached yet)
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vBootTimingSend ( void )
+{
+    uint8     au8Buffer[3 + E_BOOT_TIMING_COUNT * sizeof ( uint32 ) + 1];
+    uint16    u16Length =  0;
+    uint32    u32Elapsed;
+    uint8     i;
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], BOOT_TIMING_VERSION,     u16Length );
+#ifdef STAGED_BOOT
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], TRUE,                    u16Length );
+#else
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], FALSE,                   u16Length );
+#endif
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], E_BOOT_TIMING_COUNT,     u16Length );
+    for ( i = 0; i < E_BOOT_TIMING_COUNT; i++ )
+    {
+        u32Elapsed =  0;
+        if ( au64BootTimingStamp[i] >= au64BootTimingStamp[E_BOOT_TIMING_START] )
+        {
+            u32Elapsed =  ( uint32 ) ( au64BootTimingStamp[i] - au64BootTimingStamp[E_BOOT_TIMING_START] );
+        }
+        ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], u32Elapsed,          u16Length );
+    }
+
+    vSL_WriteMessage ( E_SL_MSG_BOOT_TIMING,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
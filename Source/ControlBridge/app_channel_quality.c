@@ -0,0 +1,668 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_channel_quality.c
+ *
+ * DESCRIPTION:        Persisted per channel quality history and channel
+ *                     ranking (Implementation)
+ *
+ *                     Every channel keeps the frames sent on it, those lost
+ *                     for want of a MAC or APS acknowledgement, those that
+ *                     never went out because CSMA found the channel busy,
+ *                     and a running average of the energy scans reported in
+ *                     Mgmt_NWK_Update_notify. A channel's expected delivery
+ *                     blends what was measured with an estimate from its
+ *                     energy, so channels the network never ran on can be
+ *                     ranked against the one it runs on.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "pdum_gen.h"
+#include "PDM.h"
+#include "PDM_IDs.h"
+#include "zps_apl_af.h"
+#include "zps_apl_zdo.h"
+#include "zps_apl_zdp.h"
+#include "zps_nwk_nib.h"
+#include "bdb_api.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_channel_quality.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_CHANNEL_QUALITY
+#define TRACE_CHANNEL_QUALITY           TRUE
+#else
+#define TRACE_CHANNEL_QUALITY           FALSE
+#endif
+
+/* MAC statuses passed up in the APS data confirm, see MiniMac.h */
+#define CHANNEL_QUALITY_MAC_ACCESS_FAILURE      0xE1
+#define CHANNEL_QUALITY_MAC_NO_ACK              0xE9
+
+/* Mgmt_NWK_Update_req scan duration asking for a channel change */
+#define CHANNEL_QUALITY_CHANGE_DURATION         0xFE
+
+#define CHANNEL_QUALITY_CHANNEL_REPORT          11
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint16    u16Sent;
+    uint16    u16NoAck;
+    uint16    u16Busy;
+    uint8     u8Energy;
+    uint8     u8EnergyScans;
+} tsChannelQualityChannel;
+
+/* Persisted as PDM_ID_APP_CHANNEL_QUALITY */
+typedef struct
+{
+    tsChannelQualityChannel    asChannel[CHANNEL_QUALITY_CHANNELS];
+} tsChannelQualityRecord;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE void APP_vChannelQualityLoad ( void );
+PRIVATE void APP_vChannelQualitySave ( void );
+PRIVATE tsChannelQualityChannel* APP_psChannelQualityChannel ( uint8    u8Channel );
+PRIVATE uint16 APP_u16ChannelQualityDelivery ( tsChannelQualityChannel*    psChannel );
+PRIVATE uint8 APP_u8ChannelQualityBest ( uint32    u32ChannelMask );
+PRIVATE uint8 APP_u8ChannelQualityChange ( uint8*    pu8Command,
+                                           uint16    u16Length,
+                                           uint8*    pu8Channel );
+PRIVATE void APP_vChannelQualityRespond ( uint8    u8Operation,
+                                          uint8    u8Status,
+                                          uint8    u8Value );
+PRIVATE void APP_vChannelQualitySendReport ( uint32    u32ChannelMask );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsChannelQualityRecord    sChannelQualityRecord;
+PRIVATE bool_t                    bChannelQualityLoaded =  FALSE;
+PRIVATE bool_t                    bChannelQualityDirty =  FALSE;
+PRIVATE uint16                    u16ChannelQualityTicks =  0;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vChannelQualityCommand
+ *
+ * DESCRIPTION:
+ * Handles E_SL_MSG_CHANNEL_QUALITY. The first byte selects the operation:
+ *  REPORT - optional u32 mask of the channels to rank, all by default
+ *  CHANGE - u8 channel, 0 for the best ranked one, and optional u32 mask
+ *           as for REPORT. Broadcasts Mgmt_NWK_Update_req moving the
+ *           network to the channel
+ *  RESET  - forgets the history of every channel
+ * CHANGE and RESET are answered with E_SL_MSG_CHANNEL_QUALITY_RESPONSE
+ * carrying operation, status and channel.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vChannelQualityCommand ( uint8*    pu8Command,
+                                         uint16    u16Length )
+{
+    uint8    u8Operation;
+    uint8    u8Status;
+    uint8    u8Channel =  0;
+
+    if ( u16Length == 0 )
+    {
+        return;
+    }
+    APP_vChannelQualityLoad ( );
+    u8Operation =  pu8Command[0];
+
+    switch ( u8Operation )
+    {
+        case CHANNEL_QUALITY_OP_REPORT:
+            APP_vChannelQualitySendReport ( ( u16Length >= 5 ) ? ZNC_RTN_U32 ( pu8Command, 1 ) : CHANNEL_QUALITY_ALL_CHANNELS );
+        break;
+
+        case CHANNEL_QUALITY_OP_CHANGE:
+            u8Status =  APP_u8ChannelQualityChange ( pu8Command, u16Length, &u8Channel );
+            APP_vChannelQualityRespond ( u8Operation, u8Status, u8Channel );
+        break;
+
+        case CHANNEL_QUALITY_OP_RESET:
+            memset ( &sChannelQualityRecord, 0, sizeof ( sChannelQualityRecord ) );
+            APP_vChannelQualitySave ( );
+            APP_vChannelQualityRespond ( u8Operation, CHANNEL_QUALITY_STATUS_OK, 0 );
+        break;
+
+        default:
+            APP_vChannelQualityRespond ( u8Operation, CHANNEL_QUALITY_STATUS_UNSUPPORTED, 0 );
+        break;
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChannelQualityDataConfirm
+ *
+ * DESCRIPTION:
+ * Counts a unicast APS data confirm against the channel the network is on.
+ * Broadcast and group frames are not acknowledged and so say nothing about
+ * the channel, nor do failures such as a missing route.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vChannelQualityDataConfirm ( ZPS_tsAfDataConfEvent*    psConfirm )
+{
+    tsChannelQualityChannel*    psChannel;
+
+    switch ( psConfirm->u8DstAddrMode )
+    {
+        case ZPS_E_ADDR_MODE_SHORT:
+        case ZPS_E_ADDR_MODE_SHORT_NO_ACK:
+            if ( psConfirm->uDstAddr.u16Addr >= 0xFFF8 )
+            {
+                return;
+            }
+        break;
+
+        case ZPS_E_ADDR_MODE_IEEE:
+        case ZPS_E_ADDR_MODE_IEEE_NO_ACK:
+        break;
+
+        default:
+            return;
+    }
+
+    APP_vChannelQualityLoad ( );
+    psChannel =  APP_psChannelQualityChannel ( ZPS_u8AplZdoGetRadioChannel ( ) );
+    if ( psChannel == NULL )
+    {
+        return;
+    }
+
+    switch ( psConfirm->u8Status )
+    {
+        case ZPS_E_SUCCESS:
+        break;
+
+        case CHANNEL_QUALITY_MAC_NO_ACK:
+        case ZPS_APL_APS_E_NO_ACK:
+            psChannel->u16NoAck++;
+        break;
+
+        case CHANNEL_QUALITY_MAC_ACCESS_FAILURE:
+            psChannel->u16Busy++;
+        break;
+
+        default:
+            return;
+    }
+
+    psChannel->u16Sent++;
+    if ( psChannel->u16Sent >= CHANNEL_QUALITY_COUNTER_LIMIT )
+    {
+        psChannel->u16Sent  >>=  1;
+        psChannel->u16NoAck >>=  1;
+        psChannel->u16Busy  >>=  1;
+    }
+    bChannelQualityDirty =  TRUE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChannelQualityEnergyScan
+ *
+ * DESCRIPTION:
+ * Folds the energy readings of a Mgmt_NWK_Update_notify into the running
+ * average of each channel, one reading per channel set in the scanned
+ * channel mask, lowest channel first
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vChannelQualityEnergyScan ( uint32    u32ScannedChannels,
+                                            uint8     u8Count,
+                                            uint8*    pu8Energy )
+{
+    tsChannelQualityChannel*    psChannel;
+    uint8                       u8Channel;
+    uint8                       i =  0;
+
+    APP_vChannelQualityLoad ( );
+    for ( u8Channel = CHANNEL_QUALITY_FIRST_CHANNEL;
+          ( u8Channel < CHANNEL_QUALITY_FIRST_CHANNEL + CHANNEL_QUALITY_CHANNELS ) && ( i < u8Count );
+          u8Channel++ )
+    {
+        if ( ( u32ScannedChannels & ( 1UL << u8Channel ) ) == 0 )
+        {
+            continue;
+        }
+        psChannel =  APP_psChannelQualityChannel ( u8Channel );
+        if ( psChannel->u8EnergyScans == 0 )
+        {
+            psChannel->u8Energy =  pu8Energy[i];
+        }
+        else
+        {
+            psChannel->u8Energy =  ( uint8 ) ( ( ( uint16 ) psChannel->u8Energy * ( 8 - CHANNEL_QUALITY_ENERGY_WEIGHT ) +
+                                                 ( uint16 ) pu8Energy[i] * CHANNEL_QUALITY_ENERGY_WEIGHT ) / 8 );
+        }
+        if ( psChannel->u8EnergyScans < 0xFF )
+        {
+            psChannel->u8EnergyScans++;
+        }
+        vLog_Printf ( TRACE_CHANNEL_QUALITY, LOG_DEBUG, "\nCQ: channel %d energy %d average %d",
+                      u8Channel, pu8Energy[i], psChannel->u8Energy );
+        i++;
+    }
+    bChannelQualityDirty =  TRUE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u32ChannelQualityPreferred
+ *
+ * DESCRIPTION:
+ * Narrows a formation channel mask to its best ranked channel
+ *
+ * RETURNS:
+ * Channel mask, unchanged when no channel in it has any history
+ *
+ ****************************************************************************/
+PUBLIC uint32 APP_u32ChannelQualityPreferred ( uint32    u32ChannelMask )
+{
+    tsChannelQualityChannel*    psChannel;
+    uint8                       u8Channel;
+
+    APP_vChannelQualityLoad ( );
+    for ( u8Channel = CHANNEL_QUALITY_FIRST_CHANNEL;
+          u8Channel < CHANNEL_QUALITY_FIRST_CHANNEL + CHANNEL_QUALITY_CHANNELS;
+          u8Channel++ )
+    {
+        psChannel =  APP_psChannelQualityChannel ( u8Channel );
+        if ( ( u32ChannelMask & ( 1UL << u8Channel ) ) &&
+             ( ( psChannel->u16Sent > 0 ) || ( psChannel->u8EnergyScans > 0 ) ) )
+        {
+            return 1UL << APP_u8ChannelQualityBest ( u32ChannelMask );
+        }
+    }
+    return u32ChannelMask;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChannelQualityTick
+ *
+ * DESCRIPTION:
+ * Called every 100ms, saves a changed history every
+ * CHANNEL_QUALITY_SAVE_TICKS so counting frames does not wear the flash
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vChannelQualityTick ( void )
+{
+    if ( !bChannelQualityDirty )
+    {
+        return;
+    }
+    u16ChannelQualityTicks++;
+    if ( u16ChannelQualityTicks >= CHANNEL_QUALITY_SAVE_TICKS )
+    {
+        APP_vChannelQualitySave ( );
+    }
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vChannelQualityLoad
+ *
+ * DESCRIPTION:
+ * Restores the history on first use
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vChannelQualityLoad ( void )
+{
+    uint16    u16BytesRead =  0;
+
+    if ( bChannelQualityLoaded )
+    {
+        return;
+    }
+    if ( ( PDM_eReadDataFromRecord ( PDM_ID_APP_CHANNEL_QUALITY,
+                                     &sChannelQualityRecord,
+                                     sizeof ( sChannelQualityRecord ),
+                                     &u16BytesRead ) != PDM_E_STATUS_OK ) ||
+         ( u16BytesRead != sizeof ( sChannelQualityRecord ) ) )
+    {
+        memset ( &sChannelQualityRecord, 0, sizeof ( sChannelQualityRecord ) );
+    }
+    bChannelQualityLoaded =  TRUE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChannelQualitySave
+ *
+ * DESCRIPTION:
+ * Persists the history
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vChannelQualitySave ( void )
+{
+    PDM_eSaveRecordData ( PDM_ID_APP_CHANNEL_QUALITY,
+                          &sChannelQualityRecord,
+                          sizeof ( sChannelQualityRecord ) );
+    bChannelQualityDirty =  FALSE;
+    u16ChannelQualityTicks =  0;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_psChannelQualityChannel
+ *
+ * DESCRIPTION:
+ * Looks up the history of a channel
+ *
+ * RETURNS:
+ * Channel history, NULL for a channel outside 11 to 26
+ *
+ ****************************************************************************/
+PRIVATE tsChannelQualityChannel* APP_psChannelQualityChannel ( uint8    u8Channel )
+{
+    if ( ( u8Channel < CHANNEL_QUALITY_FIRST_CHANNEL ) ||
+         ( u8Channel >= CHANNEL_QUALITY_FIRST_CHANNEL + CHANNEL_QUALITY_CHANNELS ) )
+    {
+        return NULL;
+    }
+    return &sChannelQualityRecord.asChannel[u8Channel - CHANNEL_QUALITY_FIRST_CHANNEL];
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u16ChannelQualityDelivery
+ *
+ * DESCRIPTION:
+ * Expected delivery of a channel. The energy average gives an estimate,
+ * which weighs as CHANNEL_QUALITY_PRIOR_FRAMES frames against the share of
+ * frames actually delivered there.
+ *
+ * RETURNS:
+ * Delivery per mille
+ *
+ ****************************************************************************/
+PRIVATE uint16 APP_u16ChannelQualityDelivery ( tsChannelQualityChannel*    psChannel )
+{
+    uint32    u32Estimate =  CHANNEL_QUALITY_UNKNOWN;
+    uint32    u32Delivered;
+
+    if ( psChannel->u8EnergyScans > 0 )
+    {
+        u32Estimate =  CHANNEL_QUALITY_SCALE -
+                       ( ( uint32 ) psChannel->u8Energy * CHANNEL_QUALITY_ENERGY_LOSS ) / 0xFF;
+    }
+    u32Delivered =  psChannel->u16Sent - psChannel->u16NoAck - psChannel->u16Busy;
+
+    return ( uint16 ) ( ( u32Delivered * CHANNEL_QUALITY_SCALE + u32Estimate * CHANNEL_QUALITY_PRIOR_FRAMES ) /
+                        ( psChannel->u16Sent + CHANNEL_QUALITY_PRIOR_FRAMES ) );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8ChannelQualityBest
+ *
+ * DESCRIPTION:
+ * Ranks the channels in a mask, a tie going to the channel the network is
+ * on and then to the lower channel
+ *
+ * RETURNS:
+ * Best channel, the current one when the mask holds no channel
+ *
+ ****************************************************************************/
+PRIVATE uint8 APP_u8ChannelQualityBest ( uint32    u32ChannelMask )
+{
+    uint8     u8Current =  ZPS_u8AplZdoGetRadioChannel ( );
+    uint8     u8Best =  u8Current;
+    uint16    u16Best =  0;
+    uint16    u16Delivery;
+    uint8     u8Channel;
+
+    if ( ( u32ChannelMask & ( 1UL << u8Current ) ) && ( APP_psChannelQualityChannel ( u8Current ) != NULL ) )
+    {
+        u16Best =  APP_u16ChannelQualityDelivery ( APP_psChannelQualityChannel ( u8Current ) );
+    }
+    for ( u8Channel = CHANNEL_QUALITY_FIRST_CHANNEL;
+          u8Channel < CHANNEL_QUALITY_FIRST_CHANNEL + CHANNEL_QUALITY_CHANNELS;
+          u8Channel++ )
+    {
+        if ( ( u32ChannelMask & ( 1UL << u8Channel ) ) == 0 )
+        {
+            continue;
+        }
+        u16Delivery =  APP_u16ChannelQualityDelivery ( APP_psChannelQualityChannel ( u8Channel ) );
+        if ( u16Delivery > u16Best )
+        {
+            u16Best =  u16Delivery;
+            u8Best =  u8Channel;
+        }
+    }
+    return u8Best;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8ChannelQualityChange
+ *
+ * DESCRIPTION:
+ * Moves the network to the requested channel, or to the best ranked one
+ * when it beats the current channel by CHANNEL_QUALITY_CHANGE_MARGIN
+ *
+ * RETURNS:
+ * E_SL_MSG_CHANNEL_QUALITY_RESPONSE status, the channel in *pu8Channel
+ *
+ ****************************************************************************/
+PRIVATE uint8 APP_u8ChannelQualityChange ( uint8*    pu8Command,
+                                           uint16    u16Length,
+                                           uint8*    pu8Channel )
+{
+    PDUM_thAPduInstance             hAPduInst;
+    ZPS_tsAplZdpMgmtNwkUpdateReq    sMgmtNwkUpdateReq;
+    ZPS_tuAddress                   uDstAddr;
+    ZPS_tsNwkNib*                   psNib =  ZPS_psAplZdoGetNib ( );
+    uint8                           u8Current =  ZPS_u8AplZdoGetRadioChannel ( );
+    uint8                           u8SeqNum;
+
+    if ( u16Length < 2 )
+    {
+        return CHANNEL_QUALITY_STATUS_MALFORMED;
+    }
+    *pu8Channel =  pu8Command[1];
+    if ( *pu8Channel == 0 )
+    {
+        *pu8Channel =  APP_u8ChannelQualityBest ( ( u16Length >= 6 ) ? ZNC_RTN_U32 ( pu8Command, 2 ) : CHANNEL_QUALITY_ALL_CHANNELS );
+        if ( ( *pu8Channel == u8Current ) ||
+             ( APP_psChannelQualityChannel ( u8Current ) == NULL ) ||
+             ( APP_u16ChannelQualityDelivery ( APP_psChannelQualityChannel ( *pu8Channel ) ) <
+               APP_u16ChannelQualityDelivery ( APP_psChannelQualityChannel ( u8Current ) ) + CHANNEL_QUALITY_CHANGE_MARGIN ) )
+        {
+            *pu8Channel =  u8Current;
+            return CHANNEL_QUALITY_STATUS_NO_BETTER;
+        }
+    }
+    if ( APP_psChannelQualityChannel ( *pu8Channel ) == NULL )
+    {
+        return CHANNEL_QUALITY_STATUS_MALFORMED;
+    }
+    if ( !sBDB.sAttrib.bbdbNodeIsOnANetwork )
+    {
+        return CHANNEL_QUALITY_STATUS_NO_NETWORK;
+    }
+
+    hAPduInst =  PDUM_hAPduAllocateAPduInstance ( apduZDP );
+    if ( hAPduInst == PDUM_INVALID_HANDLE )
+    {
+        return CHANNEL_QUALITY_STATUS_SEND_FAILED;
+    }
+    uDstAddr.u16Addr                    =  0xFFFD;
+    sMgmtNwkUpdateReq.u32ScanChannels   =  1UL << *pu8Channel;
+    sMgmtNwkUpdateReq.u8ScanDuration    =  CHANNEL_QUALITY_CHANGE_DURATION;
+    sMgmtNwkUpdateReq.u8ScanCount       =  0;
+    sMgmtNwkUpdateReq.u8NwkUpdateId     =  psNib->sPersist.u8UpdateId + 1;
+    sMgmtNwkUpdateReq.u16NwkManagerAddr =  psNib->u16ManagerAddr;
+    if ( ZPS_eAplZdpMgmtNwkUpdateRequest ( hAPduInst,
+                                           uDstAddr,
+                                           FALSE,
+                                           &u8SeqNum,
+                                           &sMgmtNwkUpdateReq ) != ZPS_E_SUCCESS )
+    {
+        PDUM_eAPduFreeAPduInstance ( hAPduInst );
+        return CHANNEL_QUALITY_STATUS_SEND_FAILED;
+    }
+    vLog_Printf ( TRACE_CHANNEL_QUALITY, LOG_DEBUG, "\nCQ: channel %d to %d", u8Current, *pu8Channel );
+
+    return CHANNEL_QUALITY_STATUS_OK;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChannelQualityRespond
+ *
+ * DESCRIPTION:
+ * Sends E_SL_MSG_CHANNEL_QUALITY_RESPONSE
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vChannelQualityRespond ( uint8    u8Operation,
+                                          uint8    u8Status,
+                                          uint8    u8Value )
+{
+    uint8     au8Buffer[3 + 1];
+    uint16    u16Length =  0;
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Operation,  u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Status,     u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Value,      u16Length );
+    vSL_WriteMessage ( E_SL_MSG_CHANNEL_QUALITY_RESPONSE,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChannelQualitySendReport
+ *
+ * DESCRIPTION:
+ * Sends E_SL_MSG_CHANNEL_QUALITY_RESPONSE for CHANNEL_QUALITY_OP_REPORT:
+ * operation, status, current channel, best ranked channel in the mask,
+ * u16 delivery of each, channel count, then per channel its number,
+ * energy average, energy scans, u16 frames sent, u16 frames not
+ * acknowledged, u16 frames held off by a busy channel and u16 delivery
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vChannelQualitySendReport ( uint32    u32ChannelMask )
+{
+    tsChannelQualityChannel*    psChannel;
+    uint8                       au8Buffer[9 + CHANNEL_QUALITY_CHANNELS * CHANNEL_QUALITY_CHANNEL_REPORT + 1];
+    uint16                      u16Length =  0;
+    uint8                       u8Current =  ZPS_u8AplZdoGetRadioChannel ( );
+    uint8                       u8Best =  APP_u8ChannelQualityBest ( u32ChannelMask );
+    uint8                       u8Channel;
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], CHANNEL_QUALITY_OP_REPORT,    u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], CHANNEL_QUALITY_STATUS_OK,    u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Current,                    u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Best,                       u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ],
+                      ( APP_psChannelQualityChannel ( u8Current ) != NULL ) ?
+                          APP_u16ChannelQualityDelivery ( APP_psChannelQualityChannel ( u8Current ) ) : 0,
+                      u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ],
+                      ( APP_psChannelQualityChannel ( u8Best ) != NULL ) ?
+                          APP_u16ChannelQualityDelivery ( APP_psChannelQualityChannel ( u8Best ) ) : 0,
+                      u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], CHANNEL_QUALITY_CHANNELS,     u16Length );
+    for ( u8Channel = CHANNEL_QUALITY_FIRST_CHANNEL;
+          u8Channel < CHANNEL_QUALITY_FIRST_CHANNEL + CHANNEL_QUALITY_CHANNELS;
+          u8Channel++ )
+    {
+        psChannel =  APP_psChannelQualityChannel ( u8Channel );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Channel,                                          u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], psChannel->u8Energy,                                u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], psChannel->u8EnergyScans,                           u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], psChannel->u16Sent,                                 u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], psChannel->u16NoAck,                                u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], psChannel->u16Busy,                                 u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], APP_u16ChannelQualityDelivery ( psChannel ),        u16Length );
+    }
+    vSL_WriteMessage ( E_SL_MSG_CHANNEL_QUALITY_RESPONSE,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,118 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_channel_quality.h
+ *
+ * DESCRIPTION:        Persisted per channel quality history and channel
+ *                     ranking (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef APP_CHANNEL_QUALITY_H_
+#define APP_CHANNEL_QUALITY_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include "zps_apl_af.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define CHANNEL_QUALITY_FIRST_CHANNEL       11
+#define CHANNEL_QUALITY_CHANNELS            16
+#define CHANNEL_QUALITY_ALL_CHANNELS        0x07FFF800
+
+/* Delivery is expressed per mille throughout */
+#define CHANNEL_QUALITY_SCALE               1000
+
+/* Delivery assumed for a channel nothing is known about */
+#define CHANNEL_QUALITY_UNKNOWN             500
+
+/* Loss at full scale energy (0xFF) before any frame was sent there */
+#define CHANNEL_QUALITY_ENERGY_LOSS         750
+
+/* Frames the energy based estimate weighs as when blended with measured
+ * delivery, so a few frames do not outvote a scan */
+#define CHANNEL_QUALITY_PRIOR_FRAMES        20
+
+/* Frame counters are halved once past this, ageing out old history */
+#define CHANNEL_QUALITY_COUNTER_LIMIT       0x8000
+
+/* Weight of a new energy reading, in 1/8ths, against the running average */
+#define CHANNEL_QUALITY_ENERGY_WEIGHT       2
+
+/* A change is only recommended for at least this much better delivery */
+#ifndef CHANNEL_QUALITY_CHANGE_MARGIN
+#define CHANNEL_QUALITY_CHANGE_MARGIN       50
+#endif
+
+/* 100ms ticks between saves of a changed history, 15 minutes */
+#ifndef CHANNEL_QUALITY_SAVE_TICKS
+#define CHANNEL_QUALITY_SAVE_TICKS          9000
+#endif
+
+/* E_SL_MSG_CHANNEL_QUALITY operations, first byte of the command */
+#define CHANNEL_QUALITY_OP_REPORT           0
+#define CHANNEL_QUALITY_OP_CHANGE           1
+#define CHANNEL_QUALITY_OP_RESET            2
+
+/* E_SL_MSG_CHANNEL_QUALITY_RESPONSE status */
+#define CHANNEL_QUALITY_STATUS_OK           0
+#define CHANNEL_QUALITY_STATUS_MALFORMED    1
+#define CHANNEL_QUALITY_STATUS_NO_BETTER    2
+#define CHANNEL_QUALITY_STATUS_NO_NETWORK   3
+#define CHANNEL_QUALITY_STATUS_SEND_FAILED  4
+#define CHANNEL_QUALITY_STATUS_UNSUPPORTED  5
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vChannelQualityCommand ( uint8*    pu8Command,
+                                         uint16    u16Length );
+PUBLIC void APP_vChannelQualityDataConfirm ( ZPS_tsAfDataConfEvent*    psConfirm );
+PUBLIC void APP_vChannelQualityEnergyScan ( uint32    u32ScannedChannels,
+                                            uint8     u8Count,
+                                            uint8*    pu8Energy );
+PUBLIC uint32 APP_u32ChannelQualityPreferred ( uint32    u32ChannelMask );
+PUBLIC void APP_vChannelQualityTick ( void );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_CHANNEL_QUALITY_H_ */
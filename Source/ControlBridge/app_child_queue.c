@@ -0,0 +1,854 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_child_queue.c
+ *
+ * DESCRIPTION:        Host commands held for sleepy children and released
+ *                     one at a time as they poll (Implementation)
+ *
+ *                     Commands for a sleepy end device wait at its parent
+ *                     for its next poll, for 7.68s at most. A host that
+ *                     does not know the poll schedule sends them anyway;
+ *                     they expire at the parent, take its indirect slots
+ *                     meanwhile, and are resent blindly. Commands sent to a
+ *                     sleepy child of this node are held here instead,
+ *                     one at the parent per child at any time: the next is
+ *                     released when the confirm shows the child polled for
+ *                     the previous one, and a frame the parent dropped is
+ *                     handed to it again until the command's expiry, set
+ *                     by the host. Confirms are matched on the APS counter
+ *                     of the frame; a command whose confirm never comes is
+ *                     reported expired. Identical commands are merged.
+ *                     Delivery latency is counted per child.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "dbg.h"
+#include "zps_apl_af.h"
+#include "zps_apl_zdo.h"
+#include "zps_nwk_nib.h"
+#include "zps_nwk_pub.h"
+#include "zcl.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_Znc_cmds.h"
+#include "app_aps_queue.h"
+#include "app_child_queue.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_CHILD_QUEUE
+#define TRACE_CHILD_QUEUE               TRUE
+#else
+#define TRACE_CHILD_QUEUE               FALSE
+#endif
+
+#define CHILD_QUEUE_TICKS_PER_S         10
+
+#define CHILD_QUEUE_NONE                0xFF
+
+/* Bytes of the E_SL_MSG_CHILD_QUEUE_STATS payload ahead of the children,
+ * and per child */
+#define CHILD_QUEUE_STATS_HEADER        29
+#define CHILD_QUEUE_STATS_CHILD         15
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+    E_CHILD_QUEUE_FREE,
+    E_CHILD_QUEUE_HELD,                 /* waiting for the child's earlier command */
+    E_CHILD_QUEUE_RELEASED,             /* handed to the dispatcher or the APS queue */
+    E_CHILD_QUEUE_SENT                  /* at the parent, waiting for a poll */
+} teChildQueueState;
+
+typedef struct
+{
+    uint32    u32Submitted;             /* 100ms ticks */
+    uint32    u32Deadline;              /* 100ms ticks */
+    uint32    u32Released;              /* 100ms ticks, when released and again when sent */
+    uint16    u16PacketType;
+    uint16    u16PacketLength;
+    uint8     u8State;
+    uint8     u8Child;
+    uint8     u8ApsSeqNum;
+    uint8     au8Payload[APS_QUEUE_MAX_PAYLOAD];
+} tsChildQueueEntry;
+
+typedef struct
+{
+    uint64    u64IeeeAddr;              /* 0 when unused */
+    uint32    u32LastUsed;              /* 100ms ticks */
+    uint32    u32LatencySum;            /* 100ms ticks over the delivered commands */
+    uint16    u16Addr;
+    uint16    u16Delivered;
+    uint16    u16Expired;
+    uint16    u16Coalesced;
+    uint16    u16Rearmed;
+    uint16    u16LatencyMax;            /* 100ms ticks */
+} tsChildQueueChild;
+
+typedef struct
+{
+    uint32    u32Held;                  /* host commands accepted */
+    uint32    u32Delivered;
+    uint32    u32Expired;
+    uint32    u32Coalesced;
+    uint32    u32Rearmed;               /* frames handed to the parent again after expiring there */
+    uint32    u32Full;
+} tsChildQueueStats;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE bool_t APP_bChildQueueIsSleepyChild ( uint16    u16Addr );
+PRIVATE uint8 APP_u8ChildQueueFindChild ( uint64    u64IeeeAddr );
+PRIVATE uint8 APP_u8ChildQueueAllocateChild ( uint64    u64IeeeAddr );
+PRIVATE uint8 APP_u8ChildQueueHeld ( uint8    u8Child );
+PRIVATE void APP_vChildQueueRelease ( uint8    u8Child );
+PRIVATE void APP_vChildQueueDelivered ( tsChildQueueEntry*    psEntry );
+PRIVATE void APP_vChildQueueRearm ( tsChildQueueEntry*    psEntry );
+PRIVATE void APP_vChildQueueExpire ( tsChildQueueEntry*    psEntry );
+PRIVATE void APP_vChildQueueDropChild ( uint8    u8Child );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsChildQueueEntry    asChildQueueEntries[CHILD_QUEUE_SIZE];
+PRIVATE tsChildQueueChild    asChildQueueChildren[CHILD_QUEUE_MAX_CHILDREN];
+PRIVATE tsChildQueueStats    sChildQueueStats;
+PRIVATE uint32               u32ChildQueueTicks;
+PRIVATE uint16               u16ChildQueueExpiry;
+PRIVATE uint8                u8ChildQueueReplaying;
+PRIVATE bool_t               bChildQueueReleasable;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vChildQueueInit
+ *
+ * DESCRIPTION:
+ * Empties the queue and the counters and sets the default expiry
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vChildQueueInit ( void )
+{
+    memset ( asChildQueueEntries,  0, sizeof ( asChildQueueEntries ) );
+    memset ( asChildQueueChildren, 0, sizeof ( asChildQueueChildren ) );
+    memset ( &sChildQueueStats,    0, sizeof ( sChildQueueStats ) );
+    u32ChildQueueTicks       =  0;
+    u16ChildQueueExpiry      =  CHILD_QUEUE_DEFAULT_EXPIRY;
+    u8ChildQueueReplaying    =  CHILD_QUEUE_NONE;
+    bChildQueueReleasable    =  FALSE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_eChildQueueAdmit
+ *
+ * DESCRIPTION:
+ * Holds a host command sent to a sleepy child of this node. The child gets
+ * one command at a time: the next one is released once the parent has
+ * handed the previous one over on a poll, so commands do not pile up in the
+ * indirect queue and expire there. A command identical to one already held
+ * for the child, as a host retrying or repeating a configure reporting
+ * sends, is merged into it.
+ *
+ * RETURNS:
+ * E_APS_QUEUE_BYPASS when the command is not for a sleepy child
+ *
+ ****************************************************************************/
+PUBLIC teApsQueueAdmit APP_eChildQueueAdmit ( uint16    u16PacketType,
+                                              uint16    u16PacketLength,
+                                              uint8*    pu8Payload )
+{
+    tsChildQueueEntry*    psEntry =  NULL;
+    uint64                u64IeeeAddr;
+    uint16                u16Addr;
+    uint8                 u8Child;
+    uint8                 i;
+
+    if ( ( u16ChildQueueExpiry == 0 ) ||
+         ( FALSE == APP_bApsQueueIsTxCommand ( u16PacketType ) ) ||
+         ( u16PacketLength > APS_QUEUE_MAX_PAYLOAD ) )
+    {
+        return E_APS_QUEUE_BYPASS;
+    }
+
+    u16Addr =  APP_u16ApsQueueDstAddr ( u16PacketType, pu8Payload );
+    if ( !APP_bChildQueueIsSleepyChild ( u16Addr ) )
+    {
+        return E_APS_QUEUE_BYPASS;
+    }
+    u64IeeeAddr =  ZPS_u64AplZdoLookupIeeeAddr ( u16Addr );
+    if ( u64IeeeAddr == 0 )
+    {
+        return E_APS_QUEUE_BYPASS;
+    }
+
+    u8Child =  APP_u8ChildQueueFindChild ( u64IeeeAddr );
+    if ( u8Child == CHILD_QUEUE_NONE )
+    {
+        u8Child =  APP_u8ChildQueueAllocateChild ( u64IeeeAddr );
+    }
+    if ( u8Child == CHILD_QUEUE_NONE )
+    {
+        sChildQueueStats.u32Full++;
+        return E_APS_QUEUE_FULL;
+    }
+    asChildQueueChildren[u8Child].u16Addr        =  u16Addr;
+    asChildQueueChildren[u8Child].u32LastUsed    =  u32ChildQueueTicks;
+
+    for ( i = 0; i < CHILD_QUEUE_SIZE; i++ )
+    {
+        if ( ( asChildQueueEntries[i].u8State != E_CHILD_QUEUE_FREE ) &&
+             ( asChildQueueEntries[i].u8Child == u8Child ) &&
+             ( asChildQueueEntries[i].u16PacketType == u16PacketType ) &&
+             ( asChildQueueEntries[i].u16PacketLength == u16PacketLength ) &&
+             ( 0 == memcmp ( asChildQueueEntries[i].au8Payload, pu8Payload, u16PacketLength ) ) )
+        {
+            /* The host still wants it, give it the full expiry again */
+            asChildQueueEntries[i].u32Deadline =  u32ChildQueueTicks + ( uint32 ) u16ChildQueueExpiry * CHILD_QUEUE_TICKS_PER_S;
+            asChildQueueChildren[u8Child].u16Coalesced++;
+            sChildQueueStats.u32Coalesced++;
+            return E_APS_QUEUE_COALESCED;
+        }
+        if ( ( psEntry == NULL ) && ( asChildQueueEntries[i].u8State == E_CHILD_QUEUE_FREE ) )
+        {
+            psEntry =  &asChildQueueEntries[i];
+        }
+    }
+
+    if ( psEntry == NULL )
+    {
+        vLog_Printf ( TRACE_CHILD_QUEUE, LOG_DEBUG, "\nChild queue full, drop %04x for %04x", u16PacketType, u16Addr );
+        sChildQueueStats.u32Full++;
+        return E_APS_QUEUE_FULL;
+    }
+
+    psEntry->u8State            =  E_CHILD_QUEUE_HELD;
+    psEntry->u8Child            =  u8Child;
+    psEntry->u16PacketType      =  u16PacketType;
+    psEntry->u16PacketLength    =  u16PacketLength;
+    psEntry->u32Submitted       =  u32ChildQueueTicks;
+    psEntry->u32Deadline        =  u32ChildQueueTicks + ( uint32 ) u16ChildQueueExpiry * CHILD_QUEUE_TICKS_PER_S;
+    memcpy ( psEntry->au8Payload, pu8Payload, u16PacketLength );
+    sChildQueueStats.u32Held++;
+    bChildQueueReleasable =  TRUE;
+
+    vLog_Printf ( TRACE_CHILD_QUEUE, LOG_DEBUG, "\nChild queue hold %04x for %04x, %d held",
+                  u16PacketType, u16Addr, APP_u8ChildQueueHeld ( u8Child ) );
+
+    return E_APS_QUEUE_HELD;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChildQueueRequestSent
+ *
+ * DESCRIPTION:
+ * Called by the dispatcher when a command has been handed to the stack,
+ * with the APS counter of its frame, to tell the confirm of a released
+ * command from those of other frames for the same child. A command the
+ * APS queue held on release is found again by its content when the APS
+ * queue replays it.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vChildQueueRequestSent ( uint8     u8ApsSeqNum,
+                                         uint16    u16PacketType,
+                                         uint16    u16PacketLength,
+                                         uint8*    pu8Payload )
+{
+    tsChildQueueEntry*    psEntry =  NULL;
+    uint8                 i;
+
+    if ( u8ChildQueueReplaying != CHILD_QUEUE_NONE )
+    {
+        psEntry =  &asChildQueueEntries[u8ChildQueueReplaying];
+    }
+    for ( i = 0; ( psEntry == NULL ) && ( i < CHILD_QUEUE_SIZE ); i++ )
+    {
+        if ( ( asChildQueueEntries[i].u8State == E_CHILD_QUEUE_RELEASED ) &&
+             ( asChildQueueEntries[i].u16PacketType == u16PacketType ) &&
+             ( asChildQueueEntries[i].u16PacketLength == u16PacketLength ) &&
+             ( 0 == memcmp ( asChildQueueEntries[i].au8Payload, pu8Payload, u16PacketLength ) ) )
+        {
+            psEntry =  &asChildQueueEntries[i];
+        }
+    }
+
+    if ( ( psEntry != NULL ) && ( psEntry->u8State == E_CHILD_QUEUE_RELEASED ) )
+    {
+        psEntry->u8State        =  E_CHILD_QUEUE_SENT;
+        psEntry->u8ApsSeqNum    =  u8ApsSeqNum;
+        psEntry->u32Released    =  u32ChildQueueTicks;
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChildQueueDataConfirm
+ *
+ * DESCRIPTION:
+ * Called for every APS data confirm. For a direct child the confirm of an
+ * indirect frame comes when the child polled for it, or when the parent
+ * gave up waiting; in the first case the child's next command is released,
+ * in the second the same command is handed to the parent again until it
+ * expires, without the host resending it. Only the confirm with the APS
+ * counter of the command's own frame counts; other frames to the child
+ * say nothing about it.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vChildQueueDataConfirm ( ZPS_tsAfDataConfEvent*    psConfirm )
+{
+    tsChildQueueEntry*    psEntry;
+    uint16                u16Addr;
+    uint8                 i;
+
+    if ( ( psConfirm->u8DstAddrMode == E_ZCL_AM_IEEE ) || ( psConfirm->u8DstAddrMode == E_ZCL_AM_IEEE_NO_ACK ) )
+    {
+        u16Addr =  ZPS_u16AplZdoLookupAddr ( psConfirm->uDstAddr.u64Addr );
+    }
+    else if ( ( psConfirm->u8DstAddrMode == E_ZCL_AM_SHORT ) || ( psConfirm->u8DstAddrMode == E_ZCL_AM_SHORT_NO_ACK ) )
+    {
+        u16Addr =  psConfirm->uDstAddr.u16Addr;
+    }
+    else
+    {
+        return;
+    }
+
+    for ( i = 0; i < CHILD_QUEUE_SIZE; i++ )
+    {
+        psEntry =  &asChildQueueEntries[i];
+        if ( ( psEntry->u8State == E_CHILD_QUEUE_SENT ) &&
+             ( psEntry->u8ApsSeqNum == psConfirm->u8SequenceNum ) &&
+             ( asChildQueueChildren[psEntry->u8Child].u16Addr == u16Addr ) )
+        {
+            if ( psConfirm->u8Status == ZPS_E_SUCCESS )
+            {
+                APP_vChildQueueDelivered ( psEntry );
+            }
+            else
+            {
+                APP_vChildQueueRearm ( psEntry );
+            }
+            return;
+        }
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChildQueueTick
+ *
+ * DESCRIPTION:
+ * 100ms tick. Drops held commands past their expiry, and sent ones whose
+ * confirm never came: the frame may have reached the child, so it is not
+ * sent again, and the host is told instead. A command still waiting in the
+ * APS queue for a free slot has not been on air; it is only dropped once
+ * past its expiry as well.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vChildQueueTick ( void )
+{
+    tsChildQueueEntry*    psEntry;
+    uint8                 i;
+
+    u32ChildQueueTicks++;
+
+    for ( i = 0; i < CHILD_QUEUE_SIZE; i++ )
+    {
+        psEntry =  &asChildQueueEntries[i];
+        if ( psEntry->u8State == E_CHILD_QUEUE_HELD )
+        {
+            if ( ( int32 ) ( u32ChildQueueTicks - psEntry->u32Deadline ) >= 0 )
+            {
+                APP_vChildQueueExpire ( psEntry );
+            }
+        }
+        else if ( ( psEntry->u8State != E_CHILD_QUEUE_FREE ) &&
+                  ( ( u32ChildQueueTicks - psEntry->u32Released ) >= CHILD_QUEUE_CONFIRM_TIMEOUT ) &&
+                  ( ( psEntry->u8State == E_CHILD_QUEUE_SENT ) ||
+                    ( ( int32 ) ( u32ChildQueueTicks - psEntry->u32Deadline ) >= 0 ) ) )
+        {
+            APP_vChildQueueExpire ( psEntry );
+        }
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChildQueueService
+ *
+ * DESCRIPTION:
+ * Releases the oldest held command of every child with none at its
+ * parent. Run from the main loop so that commands are never issued from
+ * inside a stack event callback.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vChildQueueService ( void )
+{
+    uint8    u8Child;
+
+    if ( !bChildQueueReleasable )
+    {
+        return;
+    }
+    bChildQueueReleasable =  FALSE;
+
+    for ( u8Child = 0; u8Child < CHILD_QUEUE_MAX_CHILDREN; u8Child++ )
+    {
+        if ( asChildQueueChildren[u8Child].u64IeeeAddr != 0 )
+        {
+            APP_vChildQueueRelease ( u8Child );
+        }
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChildQueueAnnounce
+ *
+ * DESCRIPTION:
+ * Drops the commands held for a child that announced itself with a new
+ * short address; they were built for the old one
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vChildQueueAnnounce ( uint16    u16Addr,
+                                      uint64    u64IeeeAddr )
+{
+    uint8    u8Child;
+
+    u8Child =  APP_u8ChildQueueFindChild ( u64IeeeAddr );
+    if ( ( u8Child != CHILD_QUEUE_NONE ) &&
+         ( asChildQueueChildren[u8Child].u16Addr != u16Addr ) )
+    {
+        APP_vChildQueueDropChild ( u8Child );
+        asChildQueueChildren[u8Child].u16Addr =  u16Addr;
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vChildQueueRemoveDevice
+ *
+ * DESCRIPTION:
+ * Drops the commands held for a device that left
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vChildQueueRemoveDevice ( uint64    u64IeeeAddr )
+{
+    uint8    u8Child;
+
+    u8Child =  APP_u8ChildQueueFindChild ( u64IeeeAddr );
+    if ( u8Child != CHILD_QUEUE_NONE )
+    {
+        APP_vChildQueueDropChild ( u8Child );
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8ChildQueueSetExpiry
+ *
+ * DESCRIPTION:
+ * Handles E_SL_MSG_CHILD_QUEUE_SET_EXPIRY:
+ *   u16Expiry (seconds)
+ * Applies to commands held from now on; 0 sends commands for sleepy
+ * children straight through as without the queue.
+ *
+ * RETURNS:
+ * Serial link status
+ *
+ ****************************************************************************/
+PUBLIC uint8 APP_u8ChildQueueSetExpiry ( uint8*    pu8Payload,
+                                         uint16    u16PayloadLength )
+{
+    if ( u16PayloadLength < sizeof ( uint16 ) )
+    {
+        return E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+    }
+
+    u16ChildQueueExpiry =  ZNC_RTN_U16 ( pu8Payload, 0 );
+
+    vLog_Printf ( TRACE_CHILD_QUEUE, LOG_DEBUG, "\nChild queue expiry %ds", u16ChildQueueExpiry );
+
+    return E_SL_MSG_STATUS_SUCCESS;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u16ChildQueueGetStats
+ *
+ * DESCRIPTION:
+ * Writes the E_SL_MSG_CHILD_QUEUE_STATS payload: expiry in seconds,
+ * commands held, capacity, number of children that follow, the held,
+ * delivered, expired, coalesced, re-armed and full counters, then for
+ * each child its short address, commands held, delivered, expired,
+ * coalesced and re-armed counts, and the mean and longest delivery
+ * latency in 100ms ticks. Children that do not fit in u16BufferLength,
+ * less the byte vSL_WriteMessage needs, are left out.
+ *
+ * RETURNS:
+ * Number of bytes written
+ *
+ ****************************************************************************/
+PUBLIC uint16 APP_u16ChildQueueGetStats ( uint8*    pu8Buffer,
+                                          uint16    u16BufferLength,
+                                          bool_t    bReset )
+{
+    tsChildQueueChild*    psChild;
+    uint16                u16Length    =  0;
+    uint16                u16Children;
+    uint8                 u8Reported   =  0;
+    uint8                 u8Held       =  0;
+    uint8                 i;
+
+    for ( i = 0; i < CHILD_QUEUE_SIZE; i++ )
+    {
+        u8Held +=  ( asChildQueueEntries[i].u8State != E_CHILD_QUEUE_FREE ) ? 1 : 0;
+    }
+    u16Children =  ( u16BufferLength > CHILD_QUEUE_STATS_HEADER ) ?
+                       ( ( u16BufferLength - CHILD_QUEUE_STATS_HEADER - 1 ) / CHILD_QUEUE_STATS_CHILD ) : 0;
+
+    ZNC_BUF_U16_UPD ( &pu8Buffer[u16Length], u16ChildQueueExpiry,              u16Length );
+    ZNC_BUF_U8_UPD  ( &pu8Buffer[u16Length], u8Held,                           u16Length );
+    ZNC_BUF_U8_UPD  ( &pu8Buffer[u16Length], CHILD_QUEUE_SIZE,                 u16Length );
+    /* Number of children, filled in below */
+    ZNC_BUF_U8_UPD  ( &pu8Buffer[u16Length], 0,                                u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sChildQueueStats.u32Held,         u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sChildQueueStats.u32Delivered,    u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sChildQueueStats.u32Expired,      u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sChildQueueStats.u32Coalesced,    u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sChildQueueStats.u32Rearmed,      u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sChildQueueStats.u32Full,         u16Length );
+
+    for ( i = 0; ( i < CHILD_QUEUE_MAX_CHILDREN ) && ( u8Reported < u16Children ); i++ )
+    {
+        psChild =  &asChildQueueChildren[i];
+        if ( psChild->u64IeeeAddr == 0 )
+        {
+            continue;
+        }
+        ZNC_BUF_U16_UPD ( &pu8Buffer[u16Length], psChild->u16Addr,                 u16Length );
+        ZNC_BUF_U8_UPD  ( &pu8Buffer[u16Length], APP_u8ChildQueueHeld ( i ),       u16Length );
+        ZNC_BUF_U16_UPD ( &pu8Buffer[u16Length], psChild->u16Delivered,            u16Length );
+        ZNC_BUF_U16_UPD ( &pu8Buffer[u16Length], psChild->u16Expired,              u16Length );
+        ZNC_BUF_U16_UPD ( &pu8Buffer[u16Length], psChild->u16Coalesced,            u16Length );
+        ZNC_BUF_U16_UPD ( &pu8Buffer[u16Length], psChild->u16Rearmed,              u16Length );
+        ZNC_BUF_U16_UPD ( &pu8Buffer[u16Length], ( psChild->u16Delivered == 0 ) ? 0 :
+                                                     ( uint16 ) ( psChild->u32LatencySum / psChild->u16Delivered ),
+                                                                                   u16Length );
+        ZNC_BUF_U16_UPD ( &pu8Buffer[u16Length], psChild->u16LatencyMax,           u16Length );
+        u8Reported++;
+
+        if ( bReset )
+        {
+            psChild->u16Delivered     =  0;
+            psChild->u16Expired       =  0;
+            psChild->u16Coalesced     =  0;
+            psChild->u16Rearmed       =  0;
+            psChild->u32LatencySum    =  0;
+            psChild->u16LatencyMax    =  0;
+        }
+    }
+    pu8Buffer[4] =  u8Reported;
+
+    if ( bReset )
+    {
+        memset ( &sChildQueueStats, 0, sizeof ( sChildQueueStats ) );
+    }
+
+    return u16Length;
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* An end device of this node with its receiver off when idle, whose frames
+ * wait at this node for its polls */
+PRIVATE bool_t APP_bChildQueueIsSleepyChild ( uint16    u16Addr )
+{
+    ZPS_tsNwkNib*    psNib;
+    uint16           i;
+
+    if ( u16Addr >= ZPS_NWK_INVALID_NWK_ADDR )
+    {
+        return FALSE;
+    }
+
+    psNib =  ZPS_psNwkNibGetHandle ( ZPS_pvAplZdoGetNwkHandle ( ) );
+    for ( i = 0; i < psNib->sTblSize.u16NtActv; i++ )
+    {
+        ZPS_tsNwkActvNtEntry*    psNt =  &psNib->sTbl.psNtActv[i];
+
+        if ( psNt->u16NwkAddr == u16Addr )
+        {
+            return ( ( psNt->uAncAttrs.bfBitfields.u2Relationship == ZPS_NWK_NT_AP_RELATIONSHIP_CHILD ) &&
+                     ( psNt->uAncAttrs.bfBitfields.u1RxOnWhenIdle == 0 ) );
+        }
+    }
+    return FALSE;
+}
+
+PRIVATE uint8 APP_u8ChildQueueFindChild ( uint64    u64IeeeAddr )
+{
+    uint8    i;
+
+    for ( i = 0; ( u64IeeeAddr != 0 ) && ( i < CHILD_QUEUE_MAX_CHILDREN ); i++ )
+    {
+        if ( asChildQueueChildren[i].u64IeeeAddr == u64IeeeAddr )
+        {
+            return i;
+        }
+    }
+    return CHILD_QUEUE_NONE;
+}
+
+/* A free record, else that of the child without held commands used least
+ * recently, whose counters are lost */
+PRIVATE uint8 APP_u8ChildQueueAllocateChild ( uint64    u64IeeeAddr )
+{
+    uint8    u8Victim =  CHILD_QUEUE_NONE;
+    uint8    i;
+
+    for ( i = 0; i < CHILD_QUEUE_MAX_CHILDREN; i++ )
+    {
+        if ( asChildQueueChildren[i].u64IeeeAddr == 0 )
+        {
+            u8Victim =  i;
+            break;
+        }
+        if ( ( APP_u8ChildQueueHeld ( i ) == 0 ) &&
+             ( ( u8Victim == CHILD_QUEUE_NONE ) ||
+               ( ( u32ChildQueueTicks - asChildQueueChildren[i].u32LastUsed ) >
+                 ( u32ChildQueueTicks - asChildQueueChildren[u8Victim].u32LastUsed ) ) ) )
+        {
+            u8Victim =  i;
+        }
+    }
+
+    if ( u8Victim != CHILD_QUEUE_NONE )
+    {
+        memset ( &asChildQueueChildren[u8Victim], 0, sizeof ( tsChildQueueChild ) );
+        asChildQueueChildren[u8Victim].u64IeeeAddr =  u64IeeeAddr;
+    }
+    return u8Victim;
+}
+
+PRIVATE uint8 APP_u8ChildQueueHeld ( uint8    u8Child )
+{
+    uint8    u8Held =  0;
+    uint8    i;
+
+    for ( i = 0; i < CHILD_QUEUE_SIZE; i++ )
+    {
+        if ( ( asChildQueueEntries[i].u8State != E_CHILD_QUEUE_FREE ) &&
+             ( asChildQueueEntries[i].u8Child == u8Child ) )
+        {
+            u8Held++;
+        }
+    }
+    return u8Held;
+}
+
+/* Hands the child's oldest held command to the dispatcher, unless one is
+ * already at the parent */
+PRIVATE void APP_vChildQueueRelease ( uint8    u8Child )
+{
+    tsChildQueueEntry*    psEntry;
+    uint8                 u8Oldest =  CHILD_QUEUE_NONE;
+    uint8                 i;
+
+    for ( i = 0; i < CHILD_QUEUE_SIZE; i++ )
+    {
+        psEntry =  &asChildQueueEntries[i];
+        if ( ( psEntry->u8State == E_CHILD_QUEUE_FREE ) || ( psEntry->u8Child != u8Child ) )
+        {
+            continue;
+        }
+        if ( psEntry->u8State != E_CHILD_QUEUE_HELD )
+        {
+            return;
+        }
+        if ( ( u8Oldest == CHILD_QUEUE_NONE ) ||
+             ( ( u32ChildQueueTicks - psEntry->u32Submitted ) >
+               ( u32ChildQueueTicks - asChildQueueEntries[u8Oldest].u32Submitted ) ) )
+        {
+            u8Oldest =  i;
+        }
+    }
+    if ( u8Oldest == CHILD_QUEUE_NONE )
+    {
+        return;
+    }
+
+    psEntry =  &asChildQueueEntries[u8Oldest];
+    switch ( APP_eApsQueueAdmit ( psEntry->u16PacketType, psEntry->u16PacketLength, psEntry->au8Payload ) )
+    {
+        case E_APS_QUEUE_BYPASS:
+            psEntry->u8State        =  E_CHILD_QUEUE_RELEASED;
+            psEntry->u32Released    =  u32ChildQueueTicks;
+            u8ChildQueueReplaying   =  u8Oldest;
+            APP_vReplaySerialCommand ( psEntry->u16PacketType,
+                                       psEntry->u16PacketLength,
+                                       psEntry->au8Payload );
+            u8ChildQueueReplaying   =  CHILD_QUEUE_NONE;
+        break;
+
+        case E_APS_QUEUE_QUEUED:
+            psEntry->u8State        =  E_CHILD_QUEUE_RELEASED;
+            psEntry->u32Released    =  u32ChildQueueTicks;
+        break;
+
+        default:
+            /* No room in the APS queue, try again on the next pass */
+            bChildQueueReleasable   =  TRUE;
+        break;
+    }
+}
+
+PRIVATE void APP_vChildQueueDelivered ( tsChildQueueEntry*    psEntry )
+{
+    tsChildQueueChild*    psChild   =  &asChildQueueChildren[psEntry->u8Child];
+    uint32                u32Latency =  u32ChildQueueTicks - psEntry->u32Submitted;
+
+    psChild->u16Delivered++;
+    psChild->u32LatencySum +=  u32Latency;
+    if ( u32Latency > psChild->u16LatencyMax )
+    {
+        psChild->u16LatencyMax =  ( u32Latency > 0xFFFF ) ? 0xFFFF : ( uint16 ) u32Latency;
+    }
+    psChild->u32LastUsed =  u32ChildQueueTicks;
+    sChildQueueStats.u32Delivered++;
+
+    vLog_Printf ( TRACE_CHILD_QUEUE, LOG_DEBUG, "\nChild queue %04x took %04x after %d",
+                  psChild->u16Addr, psEntry->u16PacketType, u32Latency );
+
+    psEntry->u8State      =  E_CHILD_QUEUE_FREE;
+    bChildQueueReleasable =  TRUE;
+}
+
+/* The parent dropped the frame: the same command goes to the parent again
+ * for the child's next poll while it has not expired */
+PRIVATE void APP_vChildQueueRearm ( tsChildQueueEntry*    psEntry )
+{
+    if ( ( int32 ) ( u32ChildQueueTicks - psEntry->u32Deadline ) >= 0 )
+    {
+        APP_vChildQueueExpire ( psEntry );
+        return;
+    }
+
+    asChildQueueChildren[psEntry->u8Child].u16Rearmed++;
+    sChildQueueStats.u32Rearmed++;
+    psEntry->u8State      =  E_CHILD_QUEUE_HELD;
+    bChildQueueReleasable =  TRUE;
+}
+
+/* Tells the host a command it was told is held never reached the child:
+ * u16ShortAddress, u16PacketType, u16Waited (100ms ticks) */
+PRIVATE void APP_vChildQueueExpire ( tsChildQueueEntry*    psEntry )
+{
+    tsChildQueueChild*    psChild   =  &asChildQueueChildren[psEntry->u8Child];
+    uint32                u32Waited =  u32ChildQueueTicks - psEntry->u32Submitted;
+    uint8                 au8Buffer[7];
+    uint16                u16Length =  0;
+
+    psChild->u16Expired++;
+    sChildQueueStats.u32Expired++;
+
+    ZNC_BUF_U16_UPD ( &au8Buffer[u16Length], psChild->u16Addr,                                       u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[u16Length], psEntry->u16PacketType,                                 u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[u16Length], ( u32Waited > 0xFFFF ) ? 0xFFFF : ( uint16 ) u32Waited, u16Length );
+    vSL_WriteMessage ( E_SL_MSG_CHILD_QUEUE_EXPIRED,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+
+    vLog_Printf ( TRACE_CHILD_QUEUE, LOG_DEBUG, "\nChild queue %04x expired %04x after %d",
+                  psChild->u16Addr, psEntry->u16PacketType, u32Waited );
+
+    psEntry->u8State      =  E_CHILD_QUEUE_FREE;
+    bChildQueueReleasable =  TRUE;
+}
+
+PRIVATE void APP_vChildQueueDropChild ( uint8    u8Child )
+{
+    uint8    i;
+
+    for ( i = 0; i < CHILD_QUEUE_SIZE; i++ )
+    {
+        if ( ( asChildQueueEntries[i].u8State != E_CHILD_QUEUE_FREE ) &&
+             ( asChildQueueEntries[i].u8Child == u8Child ) )
+        {
+            APP_vChildQueueExpire ( &asChildQueueEntries[i] );
+        }
+    }
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,112 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_child_queue.h
+ *
+ * DESCRIPTION:        Host commands held for sleepy children and released
+ *                     one at a time as they poll (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef APP_CHILD_QUEUE_H_
+#define APP_CHILD_QUEUE_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include "zps_apl_af.h"
+#include "app_aps_queue.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Host commands held for all sleepy children together */
+#ifndef CHILD_QUEUE_SIZE
+#define CHILD_QUEUE_SIZE                    16
+#endif
+
+/* Sleepy children with held commands or delivery counters */
+#ifndef CHILD_QUEUE_MAX_CHILDREN
+#define CHILD_QUEUE_MAX_CHILDREN            16
+#endif
+
+/* Seconds a held command may wait for its child before it is dropped,
+ * until the host sets its own */
+#ifndef CHILD_QUEUE_DEFAULT_EXPIRY
+#define CHILD_QUEUE_DEFAULT_EXPIRY          120
+#endif
+
+/* 100ms ticks a released command waits for its confirm before it is
+ * reported expired; the parent keeps an indirect frame 7.68s for the next
+ * poll */
+#ifndef CHILD_QUEUE_CONFIRM_TIMEOUT
+#define CHILD_QUEUE_CONFIRM_TIMEOUT         100
+#endif
+
+/* Values of the "request sent" field of the status message for a command
+ * held for a sleepy child, and for one merged into a held command */
+#define CHILD_QUEUE_REQUEST_HELD            5
+#define CHILD_QUEUE_REQUEST_COALESCED       6
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vChildQueueInit ( void );
+PUBLIC teApsQueueAdmit APP_eChildQueueAdmit ( uint16    u16PacketType,
+                                              uint16    u16PacketLength,
+                                              uint8*    pu8Payload );
+PUBLIC void APP_vChildQueueRequestSent ( uint8     u8ApsSeqNum,
+                                         uint16    u16PacketType,
+                                         uint16    u16PacketLength,
+                                         uint8*    pu8Payload );
+PUBLIC void APP_vChildQueueDataConfirm ( ZPS_tsAfDataConfEvent*    psConfirm );
+PUBLIC void APP_vChildQueueTick ( void );
+PUBLIC void APP_vChildQueueService ( void );
+PUBLIC void APP_vChildQueueAnnounce ( uint16    u16Addr,
+                                      uint64    u64IeeeAddr );
+PUBLIC void APP_vChildQueueRemoveDevice ( uint64    u64IeeeAddr );
+PUBLIC uint8 APP_u8ChildQueueSetExpiry ( uint8*    pu8Payload,
+                                         uint16    u16PayloadLength );
+PUBLIC uint16 APP_u16ChildQueueGetStats ( uint8*    pu8Buffer,
+                                          uint16    u16BufferLength,
+                                          bool_t    bReset );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_CHILD_QUEUE_H_ */
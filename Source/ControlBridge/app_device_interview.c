@@ -0,0 +1,819 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_device_interview.c
+ *
+ * DESCRIPTION:        Interview of newly announced devices while they are
+ *                     awake (Implementation)
+ *
+ *                     A host interviewing a new device sends the node
+ *                     descriptor, active endpoint, simple descriptor and
+ *                     Basic cluster requests one after the other, each after
+ *                     the previous response crossed the serial link, and a
+ *                     sleepy device is often back to its slow poll before
+ *                     the last of them. Here the requests go out as soon as
+ *                     the device announces itself, up to
+ *                     DEVICE_INTERVIEW_MAX_OUTSTANDING at a time, each
+ *                     resent on timeout, and the answers are gathered into
+ *                     one E_SL_MSG_DEVICE_INTERVIEW_RESULT delivered when
+ *                     the last request is answered or given up. The usual
+ *                     response messages still reach the host as they arrive.
+ *
+ *                     E_SL_MSG_DEVICE_INTERVIEW_RESULT is sent as sections,
+ *                     each starting with the short address and the section:
+ *                       summary:   u64IeeeAddr, u8Capability, u8Status,
+ *                                  u16Duration (100ms), u8Requests,
+ *                                  u8NodeDescStatus, node descriptor as in
+ *                                  E_SL_MSG_NODE_DESCRIPTOR_RESPONSE,
+ *                                  u8ActiveEpStatus, u8Endpoints,
+ *                                  u8BasicEndpoint, u8Attributes
+ *                       endpoint:  u8Status, u8Endpoint, then on success
+ *                                  the simple descriptor as in
+ *                                  E_SL_MSG_SIMPLE_DESCRIPTOR_RESPONSE
+ *                       attribute: u16AttributeId, u8Status, u8Type,
+ *                                  u16Size, value, as in
+ *                                  E_SL_MSG_READ_ATTRIBUTE_RESPONSE
+ *                     A summary is followed by u8Endpoints endpoint and
+ *                     u8Attributes attribute sections.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "dbg.h"
+#include "zps_apl_af.h"
+#include "zps_apl_zdo.h"
+#include "zps_apl_zdp.h"
+#include "zcl.h"
+#include "Basic.h"
+#include "zps_gen.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_Znc_cmds.h"
+#include "app_device_interview.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_DEVICE_INTERVIEW
+#define TRACE_DEVICE_INTERVIEW              TRUE
+#else
+#define TRACE_DEVICE_INTERVIEW              FALSE
+#endif
+
+/* Capability bit of a device that keeps its receiver on */
+#define DEVICE_INTERVIEW_RX_ON_WHEN_IDLE    0x08
+
+/* Status recorded for a request never answered */
+#define DEVICE_INTERVIEW_NO_RESPONSE        0xFF
+
+/* Manufacturer code, max rx and tx sizes, server mask, descriptor
+ * capability, MAC flags, max buffer size and the flag bit field */
+#define DEVICE_INTERVIEW_NODE_DESC_BYTES    13
+
+/* Profile, device, version, then the two counted cluster lists */
+#define DEVICE_INTERVIEW_SIMPLE_DESC_BYTES  ( 7 + ( 4 * DEVICE_INTERVIEW_MAX_CLUSTERS ) )
+
+/* Attribute records of the Basic reads, each with a length byte ahead */
+#define DEVICE_INTERVIEW_ATTRIBUTE_BYTES    160
+
+/* Basic cluster read requests, see asDeviceInterviewBasicReads */
+#define DEVICE_INTERVIEW_BASIC_READS        2
+
+/* Node descriptor, active endpoints, a simple descriptor per endpoint and
+ * the Basic reads */
+#define DEVICE_INTERVIEW_MAX_STEPS          ( 2 + DEVICE_INTERVIEW_MAX_ENDPOINTS + DEVICE_INTERVIEW_BASIC_READS )
+
+/* Short address and section ahead of every section */
+#define DEVICE_INTERVIEW_SECTION_HEADER     3
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+    E_DEVICE_INTERVIEW_NODE_DESC,
+    E_DEVICE_INTERVIEW_ACTIVE_EP,
+    E_DEVICE_INTERVIEW_SIMPLE_DESC,
+    E_DEVICE_INTERVIEW_BASIC_READ
+} teDeviceInterviewKind;
+
+typedef enum
+{
+    E_DEVICE_INTERVIEW_BLOCKED,         /* waits on an earlier answer */
+    E_DEVICE_INTERVIEW_READY,
+    E_DEVICE_INTERVIEW_SENT,
+    E_DEVICE_INTERVIEW_DONE,
+    E_DEVICE_INTERVIEW_FAILED
+} teDeviceInterviewState;
+
+typedef struct
+{
+    uint8     u8Attributes;
+    uint16    au16Attributes[4];
+} tsDeviceInterviewBasicRead;
+
+typedef struct
+{
+    uint8     u8Kind;
+    uint8     u8State;
+    uint8     u8Index;                  /* endpoint index or Basic read */
+    uint8     u8SeqNum;
+    uint8     u8Attempts;
+    uint8     u8Timer;                  /* 100ms ticks */
+} tsDeviceInterviewStep;
+
+typedef struct
+{
+    uint64                   u64IeeeAddr;            /* 0 when unused */
+    uint16                   u16Addr;
+    uint16                   u16Elapsed;             /* 100ms ticks */
+    uint8                    u8Capability;
+    uint8                    u8Requests;
+    uint8                    u8Status;
+    uint8                    u8Steps;
+    tsDeviceInterviewStep    asSteps[DEVICE_INTERVIEW_MAX_STEPS];
+    uint8                    u8NodeDescStatus;
+    uint8                    au8NodeDesc[DEVICE_INTERVIEW_NODE_DESC_BYTES];
+    uint8                    u8ActiveEpStatus;
+    uint8                    u8Endpoints;
+    uint8                    au8Endpoints[DEVICE_INTERVIEW_MAX_ENDPOINTS];
+    uint8                    au8SimpleDescStatus[DEVICE_INTERVIEW_MAX_ENDPOINTS];
+    uint8                    au8SimpleDescLength[DEVICE_INTERVIEW_MAX_ENDPOINTS];
+    uint8                    au8SimpleDesc[DEVICE_INTERVIEW_MAX_ENDPOINTS][DEVICE_INTERVIEW_SIMPLE_DESC_BYTES];
+    uint8                    u8BasicEndpoint;        /* 0 until known */
+    uint8                    u8Attributes;
+    uint8                    u8AttributeBytes;
+    uint8                    au8Attributes[DEVICE_INTERVIEW_ATTRIBUTE_BYTES];
+} tsDeviceInterviewSession;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE tsDeviceInterviewSession* APP_psDeviceInterviewFind ( uint16    u16Addr );
+PRIVATE tsDeviceInterviewStep* APP_psDeviceInterviewFindStep ( tsDeviceInterviewSession*    psSession,
+                                                               uint8                        u8Kind,
+                                                               uint8                        u8SeqNum );
+PRIVATE void APP_vDeviceInterviewAddStep ( tsDeviceInterviewSession*    psSession,
+                                           uint8                        u8Kind,
+                                           uint8                        u8State,
+                                           uint8                        u8Index );
+PRIVATE bool_t APP_bDeviceInterviewSend ( tsDeviceInterviewSession*    psSession,
+                                          tsDeviceInterviewStep*       psStep );
+PRIVATE void APP_vDeviceInterviewRun ( tsDeviceInterviewSession*    psSession );
+PRIVATE void APP_vDeviceInterviewSetBasicEndpoint ( tsDeviceInterviewSession*    psSession );
+PRIVATE void APP_vDeviceInterviewFinish ( tsDeviceInterviewSession*    psSession );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+/* Split so that each response fits one unfragmented frame with 32
+ * character strings */
+PRIVATE const tsDeviceInterviewBasicRead    asDeviceInterviewBasicReads[DEVICE_INTERVIEW_BASIC_READS] =
+{
+    { 2, { E_CLD_BAS_ATTR_ID_MANUFACTURER_NAME, E_CLD_BAS_ATTR_ID_MODEL_IDENTIFIER } },
+    { 4, { E_CLD_BAS_ATTR_ID_ZCL_VERSION, E_CLD_BAS_ATTR_ID_APPLICATION_VERSION,
+           E_CLD_BAS_ATTR_ID_POWER_SOURCE, E_CLD_BAS_ATTR_ID_SW_BUILD_ID } }
+};
+
+PRIVATE tsDeviceInterviewSession    asDeviceInterviewSessions[DEVICE_INTERVIEW_MAX_SESSIONS];
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vDeviceInterviewInit
+ *
+ * DESCRIPTION:
+ * Drops every interview in progress
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vDeviceInterviewInit ( void )
+{
+    memset ( asDeviceInterviewSessions, 0, sizeof ( asDeviceInterviewSessions ) );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vDeviceInterviewTick
+ *
+ * DESCRIPTION:
+ * 100ms time base: resends requests whose response is overdue, gives up
+ * after DEVICE_INTERVIEW_RETRIES resends or DEVICE_INTERVIEW_MAX_DURATION,
+ * and sends requests held back for want of buffers
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vDeviceInterviewTick ( void )
+{
+    tsDeviceInterviewSession*    psSession;
+    tsDeviceInterviewStep*       psStep;
+    uint8                        i;
+    uint8                        j;
+
+    for ( i = 0; i < DEVICE_INTERVIEW_MAX_SESSIONS; i++ )
+    {
+        psSession =  &asDeviceInterviewSessions[i];
+        if ( psSession->u64IeeeAddr == 0 )
+        {
+            continue;
+        }
+
+        psSession->u16Elapsed++;
+        for ( j = 0; j < psSession->u8Steps; j++ )
+        {
+            psStep =  &psSession->asSteps[j];
+            if ( psSession->u16Elapsed >= DEVICE_INTERVIEW_MAX_DURATION )
+            {
+                if ( psStep->u8State < E_DEVICE_INTERVIEW_DONE )
+                {
+                    psStep->u8State     =  E_DEVICE_INTERVIEW_FAILED;
+                    psSession->u8Status =  DEVICE_INTERVIEW_STATUS_TIMEOUT;
+                }
+            }
+            else if ( ( psStep->u8State == E_DEVICE_INTERVIEW_SENT ) &&
+                      ( --psStep->u8Timer == 0 ) )
+            {
+                psStep->u8State =  ( psStep->u8Attempts > DEVICE_INTERVIEW_RETRIES ) ?
+                                       E_DEVICE_INTERVIEW_FAILED : E_DEVICE_INTERVIEW_READY;
+            }
+        }
+
+        APP_vDeviceInterviewSetBasicEndpoint ( psSession );
+        APP_vDeviceInterviewRun ( psSession );
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bDeviceInterviewStart
+ *
+ * DESCRIPTION:
+ * Interviews a device that has just announced itself, or that the host
+ * names. An interview of the same device in progress starts over.
+ *
+ * RETURNS:
+ * FALSE if every session is busy
+ *
+ ****************************************************************************/
+PUBLIC bool_t APP_bDeviceInterviewStart ( uint16    u16Addr,
+                                          uint64    u64IeeeAddr,
+                                          uint8     u8Capability )
+{
+    tsDeviceInterviewSession*    psSession =  NULL;
+    uint8                        i;
+    uint8                        j;
+
+    if ( u64IeeeAddr == 0 )
+    {
+        return FALSE;
+    }
+
+    APP_vDeviceInterviewCancel ( u64IeeeAddr );
+    for ( i = 0; ( i < DEVICE_INTERVIEW_MAX_SESSIONS ) && ( psSession == NULL ); i++ )
+    {
+        if ( asDeviceInterviewSessions[i].u64IeeeAddr == 0 )
+        {
+            psSession =  &asDeviceInterviewSessions[i];
+        }
+    }
+    if ( psSession == NULL )
+    {
+        vLog_Printf ( TRACE_DEVICE_INTERVIEW, LOG_DEBUG, "\nInterview of %04x not started, sessions busy", u16Addr );
+        return FALSE;
+    }
+
+    memset ( psSession, 0, sizeof ( tsDeviceInterviewSession ) );
+    psSession->u64IeeeAddr       =  u64IeeeAddr;
+    psSession->u16Addr           =  u16Addr;
+    psSession->u8Capability      =  u8Capability;
+    psSession->u8NodeDescStatus  =  DEVICE_INTERVIEW_NO_RESPONSE;
+    psSession->u8ActiveEpStatus  =  DEVICE_INTERVIEW_NO_RESPONSE;
+
+    APP_vDeviceInterviewAddStep ( psSession, E_DEVICE_INTERVIEW_NODE_DESC, E_DEVICE_INTERVIEW_READY, 0 );
+    APP_vDeviceInterviewAddStep ( psSession, E_DEVICE_INTERVIEW_ACTIVE_EP, E_DEVICE_INTERVIEW_READY, 0 );
+    for ( j = 0; j < DEVICE_INTERVIEW_BASIC_READS; j++ )
+    {
+        APP_vDeviceInterviewAddStep ( psSession, E_DEVICE_INTERVIEW_BASIC_READ, E_DEVICE_INTERVIEW_BLOCKED, j );
+    }
+
+    vLog_Printf ( TRACE_DEVICE_INTERVIEW, LOG_DEBUG, "\nInterview of %04x started", u16Addr );
+    APP_vDeviceInterviewRun ( psSession );
+
+    return TRUE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vDeviceInterviewCancel
+ *
+ * DESCRIPTION:
+ * Drops the interview of a device that left or announced itself again,
+ * without a result
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vDeviceInterviewCancel ( uint64    u64IeeeAddr )
+{
+    uint8    i;
+
+    for ( i = 0; i < DEVICE_INTERVIEW_MAX_SESSIONS; i++ )
+    {
+        if ( asDeviceInterviewSessions[i].u64IeeeAddr == u64IeeeAddr )
+        {
+            asDeviceInterviewSessions[i].u64IeeeAddr =  0;
+        }
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vDeviceInterviewZdpResponse
+ *
+ * DESCRIPTION:
+ * Takes the node descriptor, active endpoint and simple descriptor
+ * responses answering an interview request
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vDeviceInterviewZdpResponse ( uint16               u16SrcAddr,
+                                              ZPS_tsAfZdpEvent*    psZdpEvent )
+{
+    tsDeviceInterviewSession*    psSession;
+    tsDeviceInterviewStep*       psStep;
+    uint16                       u16Length =  0;
+    uint8                        u8Kind;
+    uint8                        u8In;
+    uint8                        u8Out;
+    uint8*                       pu8Desc;
+    uint8                        i;
+
+    switch ( psZdpEvent->u16ClusterId )
+    {
+        case ZPS_ZDP_NODE_DESC_RSP_CLUSTER_ID:
+            u8Kind =  E_DEVICE_INTERVIEW_NODE_DESC;
+            break;
+        case ZPS_ZDP_ACTIVE_EP_RSP_CLUSTER_ID:
+            u8Kind =  E_DEVICE_INTERVIEW_ACTIVE_EP;
+            break;
+        case ZPS_ZDP_SIMPLE_DESC_RSP_CLUSTER_ID:
+            u8Kind =  E_DEVICE_INTERVIEW_SIMPLE_DESC;
+            break;
+        default:
+            return;
+    }
+
+    psSession =  APP_psDeviceInterviewFind ( u16SrcAddr );
+    if ( psSession == NULL )
+    {
+        return;
+    }
+    psStep =  APP_psDeviceInterviewFindStep ( psSession, u8Kind, psZdpEvent->u8SequNumber );
+    if ( psStep == NULL )
+    {
+        return;
+    }
+    psStep->u8State =  E_DEVICE_INTERVIEW_DONE;
+
+    switch ( u8Kind )
+    {
+        case E_DEVICE_INTERVIEW_NODE_DESC:
+        {
+            ZPS_tsAplZdpNodeDescriptor*    psNodeDesc =  &psZdpEvent->uZdpData.sNodeDescRsp.sNodeDescriptor;
+
+            psSession->u8NodeDescStatus =  psZdpEvent->uZdpData.sNodeDescRsp.u8Status;
+            pu8Desc =  psSession->au8NodeDesc;
+            ZNC_BUF_U16_UPD ( &pu8Desc[u16Length], psNodeDesc->u16ManufacturerCode,       u16Length );
+            ZNC_BUF_U16_UPD ( &pu8Desc[u16Length], psNodeDesc->u16MaxRxSize,              u16Length );
+            ZNC_BUF_U16_UPD ( &pu8Desc[u16Length], psNodeDesc->u16MaxTxSize,              u16Length );
+            ZNC_BUF_U16_UPD ( &pu8Desc[u16Length], psNodeDesc->u16ServerMask,             u16Length );
+            ZNC_BUF_U8_UPD  ( &pu8Desc[u16Length], psNodeDesc->u8DescriptorCapability,    u16Length );
+            ZNC_BUF_U8_UPD  ( &pu8Desc[u16Length], psNodeDesc->u8MacFlags,                u16Length );
+            ZNC_BUF_U8_UPD  ( &pu8Desc[u16Length], psNodeDesc->u8MaxBufferSize,           u16Length );
+            ZNC_BUF_U16_UPD ( &pu8Desc[u16Length], psNodeDesc->uBitUnion.u16Value,        u16Length );
+        }
+        break;
+
+        case E_DEVICE_INTERVIEW_ACTIVE_EP:
+        {
+            psSession->u8ActiveEpStatus =  psZdpEvent->uZdpData.sActiveEpRsp.u8Status;
+            if ( psSession->u8ActiveEpStatus != ZPS_E_SUCCESS )
+            {
+                psStep->u8State =  E_DEVICE_INTERVIEW_FAILED;
+                break;
+            }
+            for ( i = 0; ( i < psZdpEvent->uZdpData.sActiveEpRsp.u8ActiveEpCount ) &&
+                         ( i < DEVICE_INTERVIEW_MAX_ENDPOINTS ); i++ )
+            {
+                psSession->au8Endpoints[i]         =  psZdpEvent->uLists.au8Data[i];
+                psSession->au8SimpleDescStatus[i]  =  DEVICE_INTERVIEW_NO_RESPONSE;
+                APP_vDeviceInterviewAddStep ( psSession, E_DEVICE_INTERVIEW_SIMPLE_DESC, E_DEVICE_INTERVIEW_READY, i );
+            }
+            psSession->u8Endpoints =  i;
+        }
+        break;
+
+        case E_DEVICE_INTERVIEW_SIMPLE_DESC:
+        {
+            ZPS_tsAplZdpSimpleDescType*    psSimpleDesc =  &psZdpEvent->uZdpData.sSimpleDescRsp.sSimpleDescriptor;
+
+            psSession->au8SimpleDescStatus[psStep->u8Index] =  psZdpEvent->uZdpData.sSimpleDescRsp.u8Status;
+            if ( psZdpEvent->uZdpData.sSimpleDescRsp.u8Status == ZPS_E_SUCCESS )
+            {
+                u8In    =  ( psSimpleDesc->u8InClusterCount  < DEVICE_INTERVIEW_MAX_CLUSTERS ) ?
+                               psSimpleDesc->u8InClusterCount  : DEVICE_INTERVIEW_MAX_CLUSTERS;
+                u8Out   =  ( psSimpleDesc->u8OutClusterCount < DEVICE_INTERVIEW_MAX_CLUSTERS ) ?
+                               psSimpleDesc->u8OutClusterCount : DEVICE_INTERVIEW_MAX_CLUSTERS;
+                pu8Desc =  psSession->au8SimpleDesc[psStep->u8Index];
+                ZNC_BUF_U16_UPD ( &pu8Desc[u16Length], psSimpleDesc->u16ApplicationProfileId,    u16Length );
+                ZNC_BUF_U16_UPD ( &pu8Desc[u16Length], psSimpleDesc->u16DeviceId,                u16Length );
+                ZNC_BUF_U8_UPD  ( &pu8Desc[u16Length], psSimpleDesc->uBitUnion.u8Value,          u16Length );
+                ZNC_BUF_U8_UPD  ( &pu8Desc[u16Length], u8In,                                     u16Length );
+                for ( i = 0; i < u8In; i++ )
+                {
+                    ZNC_BUF_U16_UPD ( &pu8Desc[u16Length], psZdpEvent->uLists.au16Data[i],       u16Length );
+                    /* The Basic server is read on the first endpoint hosting it */
+                    if ( ( psZdpEvent->uLists.au16Data[i] == GENERAL_CLUSTER_ID_BASIC ) &&
+                         ( psSession->u8BasicEndpoint == 0 ) )
+                    {
+                        psSession->u8BasicEndpoint =  psSession->au8Endpoints[psStep->u8Index];
+                    }
+                }
+                ZNC_BUF_U8_UPD  ( &pu8Desc[u16Length], u8Out,                                    u16Length );
+                for ( i = 0; i < u8Out; i++ )
+                {
+                    ZNC_BUF_U16_UPD ( &pu8Desc[u16Length],
+                                      psZdpEvent->uLists.au16Data[psSimpleDesc->u8InClusterCount + i],
+                                      u16Length );
+                }
+                psSession->au8SimpleDescLength[psStep->u8Index] =  ( uint8 ) u16Length;
+            }
+        }
+        break;
+
+        default:
+            break;
+    }
+
+    APP_vDeviceInterviewSetBasicEndpoint ( psSession );
+    APP_vDeviceInterviewRun ( psSession );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vDeviceInterviewAttribute
+ *
+ * DESCRIPTION:
+ * Keeps an attribute record of a Basic read response: attribute, status,
+ * type, size and value as encoded in E_SL_MSG_READ_ATTRIBUTE_RESPONSE
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vDeviceInterviewAttribute ( uint16    u16SrcAddr,
+                                            uint8     u8SeqNum,
+                                            uint16    u16ClusterId,
+                                            uint8*    pu8Record,
+                                            uint16    u16RecordLength )
+{
+    tsDeviceInterviewSession*    psSession;
+
+    psSession =  APP_psDeviceInterviewFind ( u16SrcAddr );
+    if ( ( psSession == NULL ) ||
+         ( u16ClusterId != GENERAL_CLUSTER_ID_BASIC ) ||
+         ( APP_psDeviceInterviewFindStep ( psSession, E_DEVICE_INTERVIEW_BASIC_READ, u8SeqNum ) == NULL ) )
+    {
+        return;
+    }
+
+    /* Values beyond the space left are for the host to read itself */
+    if ( ( u16RecordLength + 1 ) <= ( DEVICE_INTERVIEW_ATTRIBUTE_BYTES - psSession->u8AttributeBytes ) )
+    {
+        psSession->au8Attributes[psSession->u8AttributeBytes] =  ( uint8 ) u16RecordLength;
+        memcpy ( &psSession->au8Attributes[psSession->u8AttributeBytes + 1], pu8Record, u16RecordLength );
+        psSession->u8AttributeBytes +=  ( uint8 ) ( u16RecordLength + 1 );
+        psSession->u8Attributes++;
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vDeviceInterviewZclResponse
+ *
+ * DESCRIPTION:
+ * Ends a Basic read on its read attributes response, or on a default
+ * response refusing it
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vDeviceInterviewZclResponse ( uint16    u16SrcAddr,
+                                              uint8     u8SeqNum,
+                                              uint16    u16ClusterId,
+                                              bool_t    bSuccess )
+{
+    tsDeviceInterviewSession*    psSession;
+    tsDeviceInterviewStep*       psStep;
+
+    psSession =  APP_psDeviceInterviewFind ( u16SrcAddr );
+    if ( ( psSession == NULL ) || ( u16ClusterId != GENERAL_CLUSTER_ID_BASIC ) )
+    {
+        return;
+    }
+    psStep =  APP_psDeviceInterviewFindStep ( psSession, E_DEVICE_INTERVIEW_BASIC_READ, u8SeqNum );
+    if ( psStep != NULL )
+    {
+        psStep->u8State =  bSuccess ? E_DEVICE_INTERVIEW_DONE : E_DEVICE_INTERVIEW_FAILED;
+        APP_vDeviceInterviewRun ( psSession );
+    }
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE tsDeviceInterviewSession* APP_psDeviceInterviewFind ( uint16    u16Addr )
+{
+    uint8    i;
+
+    for ( i = 0; i < DEVICE_INTERVIEW_MAX_SESSIONS; i++ )
+    {
+        if ( ( asDeviceInterviewSessions[i].u64IeeeAddr != 0 ) &&
+             ( asDeviceInterviewSessions[i].u16Addr == u16Addr ) )
+        {
+            return &asDeviceInterviewSessions[i];
+        }
+    }
+    return NULL;
+}
+
+/* The request of that kind waiting on the response with sequence number u8SeqNum */
+PRIVATE tsDeviceInterviewStep* APP_psDeviceInterviewFindStep ( tsDeviceInterviewSession*    psSession,
+                                                               uint8                        u8Kind,
+                                                               uint8                        u8SeqNum )
+{
+    uint8    i;
+
+    for ( i = 0; i < psSession->u8Steps; i++ )
+    {
+        if ( ( psSession->asSteps[i].u8Kind == u8Kind ) &&
+             ( psSession->asSteps[i].u8State == E_DEVICE_INTERVIEW_SENT ) &&
+             ( psSession->asSteps[i].u8SeqNum == u8SeqNum ) )
+        {
+            return &psSession->asSteps[i];
+        }
+    }
+    return NULL;
+}
+
+PRIVATE void APP_vDeviceInterviewAddStep ( tsDeviceInterviewSession*    psSession,
+                                           uint8                        u8Kind,
+                                           uint8                        u8State,
+                                           uint8                        u8Index )
+{
+    tsDeviceInterviewStep*    psStep;
+
+    if ( psSession->u8Steps < DEVICE_INTERVIEW_MAX_STEPS )
+    {
+        psStep =  &psSession->asSteps[psSession->u8Steps++];
+        memset ( psStep, 0, sizeof ( tsDeviceInterviewStep ) );
+        psStep->u8Kind   =  u8Kind;
+        psStep->u8State  =  u8State;
+        psStep->u8Index  =  u8Index;
+    }
+}
+
+PRIVATE bool_t APP_bDeviceInterviewSend ( tsDeviceInterviewSession*    psSession,
+                                          tsDeviceInterviewStep*       psStep )
+{
+    ZPS_teStatus    eStatus =  ZPS_E_SUCCESS;
+
+    switch ( psStep->u8Kind )
+    {
+        case E_DEVICE_INTERVIEW_NODE_DESC:
+            eStatus =  APP_eZdpNodeDescReq ( psSession->u16Addr, &psStep->u8SeqNum );
+            break;
+
+        case E_DEVICE_INTERVIEW_ACTIVE_EP:
+            eStatus =  APP_eZdpActiveEndpointReq ( psSession->u16Addr, &psStep->u8SeqNum );
+            break;
+
+        case E_DEVICE_INTERVIEW_SIMPLE_DESC:
+            eStatus =  APP_eZdpSimpleDescReq ( psSession->u16Addr,
+                                               psSession->au8Endpoints[psStep->u8Index],
+                                               &psStep->u8SeqNum );
+            break;
+
+        default:
+        {
+            tsZCL_Address    sAddress;
+
+            sAddress.eAddressMode                    =  E_ZCL_AM_SHORT;
+            sAddress.uAddress.u16DestinationAddress  =  psSession->u16Addr;
+            return ( E_ZCL_SUCCESS == eZCL_SendReadAttributesRequest ( CONTROLBRIDGE_ZLO_ENDPOINT,
+                                                        psSession->u8BasicEndpoint,
+                                                        GENERAL_CLUSTER_ID_BASIC,
+                                                        FALSE,
+                                                        &sAddress,
+                                                        &psStep->u8SeqNum,
+                                                        asDeviceInterviewBasicReads[psStep->u8Index].u8Attributes,
+                                                        FALSE,
+                                                        0,
+                                                        ( uint16* ) asDeviceInterviewBasicReads[psStep->u8Index].au16Attributes ) );
+        }
+    }
+
+    return ( eStatus == ZPS_E_SUCCESS );
+}
+
+/* Sends what is ready within the bound on outstanding requests, and
+ * delivers the result once nothing is left to ask */
+PRIVATE void APP_vDeviceInterviewRun ( tsDeviceInterviewSession*    psSession )
+{
+    tsDeviceInterviewStep*    psStep;
+    uint8                     u8Outstanding =  0;
+    uint8                     u8Open        =  0;
+    uint8                     i;
+
+    for ( i = 0; i < psSession->u8Steps; i++ )
+    {
+        u8Outstanding +=  ( psSession->asSteps[i].u8State == E_DEVICE_INTERVIEW_SENT ) ? 1 : 0;
+    }
+
+    for ( i = 0; i < psSession->u8Steps; i++ )
+    {
+        psStep =  &psSession->asSteps[i];
+        if ( ( psStep->u8State == E_DEVICE_INTERVIEW_READY ) &&
+             ( u8Outstanding < DEVICE_INTERVIEW_MAX_OUTSTANDING ) )
+        {
+            /* Out of buffers: left ready for the next tick */
+            if ( !APP_bDeviceInterviewSend ( psSession, psStep ) )
+            {
+                u8Open++;
+                continue;
+            }
+            psStep->u8State  =  E_DEVICE_INTERVIEW_SENT;
+            psStep->u8Timer  =  ( psSession->u8Capability & DEVICE_INTERVIEW_RX_ON_WHEN_IDLE ) ?
+                                    DEVICE_INTERVIEW_RX_ON_TIMEOUT : DEVICE_INTERVIEW_SLEEPY_TIMEOUT;
+            psStep->u8Attempts++;
+            psSession->u8Requests++;
+            u8Outstanding++;
+        }
+        u8Open +=  ( psStep->u8State < E_DEVICE_INTERVIEW_DONE ) ? 1 : 0;
+    }
+
+    if ( u8Open == 0 )
+    {
+        APP_vDeviceInterviewFinish ( psSession );
+    }
+}
+
+/* Unblocks the Basic reads once an endpoint is known to host the Basic
+ * server, or, with every simple descriptor in, on the first endpoint; gives
+ * them up when there is no endpoint to read */
+PRIVATE void APP_vDeviceInterviewSetBasicEndpoint ( tsDeviceInterviewSession*    psSession )
+{
+    bool_t    bDescriptorsIn;
+    uint8     i;
+
+    /* Step 1 asks for the active endpoints */
+    bDescriptorsIn =  ( psSession->asSteps[1].u8State >= E_DEVICE_INTERVIEW_DONE );
+    for ( i = 0; i < psSession->u8Steps; i++ )
+    {
+        if ( ( psSession->asSteps[i].u8Kind == E_DEVICE_INTERVIEW_SIMPLE_DESC ) &&
+             ( psSession->asSteps[i].u8State < E_DEVICE_INTERVIEW_DONE ) )
+        {
+            bDescriptorsIn =  FALSE;
+        }
+    }
+    if ( ( psSession->u8BasicEndpoint == 0 ) && bDescriptorsIn && ( psSession->u8Endpoints > 0 ) )
+    {
+        psSession->u8BasicEndpoint =  psSession->au8Endpoints[0];
+    }
+
+    for ( i = 0; i < psSession->u8Steps; i++ )
+    {
+        if ( psSession->asSteps[i].u8State == E_DEVICE_INTERVIEW_BLOCKED )
+        {
+            if ( psSession->u8BasicEndpoint != 0 )
+            {
+                psSession->asSteps[i].u8State =  E_DEVICE_INTERVIEW_READY;
+            }
+            else if ( bDescriptorsIn )
+            {
+                psSession->asSteps[i].u8State =  E_DEVICE_INTERVIEW_FAILED;
+            }
+        }
+    }
+}
+
+PRIVATE void APP_vDeviceInterviewFinish ( tsDeviceInterviewSession*    psSession )
+{
+    /* An attribute record is the longest section */
+    uint8     au8Buffer[DEVICE_INTERVIEW_SECTION_HEADER + DEVICE_INTERVIEW_ATTRIBUTE_BYTES];
+    uint16    u16Length;
+    uint8     u8Offset;
+    uint8     i;
+
+    for ( i = 0; i < psSession->u8Steps; i++ )
+    {
+        if ( ( psSession->asSteps[i].u8State == E_DEVICE_INTERVIEW_FAILED ) &&
+             ( psSession->u8Status == DEVICE_INTERVIEW_STATUS_COMPLETE ) )
+        {
+            psSession->u8Status =  DEVICE_INTERVIEW_STATUS_INCOMPLETE;
+        }
+    }
+
+    u16Length =  0;
+    ZNC_BUF_U16_UPD ( &au8Buffer[u16Length], psSession->u16Addr,                      u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], DEVICE_INTERVIEW_SECTION_SUMMARY,        u16Length );
+    ZNC_BUF_U64_UPD ( &au8Buffer[u16Length], psSession->u64IeeeAddr,                  u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], psSession->u8Capability,                 u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], psSession->u8Status,                     u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[u16Length], psSession->u16Elapsed,                   u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], psSession->u8Requests,                   u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], psSession->u8NodeDescStatus,             u16Length );
+    memcpy ( &au8Buffer[u16Length], psSession->au8NodeDesc, DEVICE_INTERVIEW_NODE_DESC_BYTES );
+    u16Length +=  DEVICE_INTERVIEW_NODE_DESC_BYTES;
+    ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], psSession->u8ActiveEpStatus,             u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], psSession->u8Endpoints,                  u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], psSession->u8BasicEndpoint,              u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], psSession->u8Attributes,                 u16Length );
+    vSL_WriteMessage ( E_SL_MSG_DEVICE_INTERVIEW_RESULT, u16Length, au8Buffer, 0 );
+
+    for ( i = 0; i < psSession->u8Endpoints; i++ )
+    {
+        u16Length =  0;
+        ZNC_BUF_U16_UPD ( &au8Buffer[u16Length], psSession->u16Addr,                  u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], DEVICE_INTERVIEW_SECTION_ENDPOINT,   u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], psSession->au8SimpleDescStatus[i],   u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], psSession->au8Endpoints[i],          u16Length );
+        memcpy ( &au8Buffer[u16Length], psSession->au8SimpleDesc[i], psSession->au8SimpleDescLength[i] );
+        u16Length +=  psSession->au8SimpleDescLength[i];
+        vSL_WriteMessage ( E_SL_MSG_DEVICE_INTERVIEW_RESULT, u16Length, au8Buffer, 0 );
+    }
+
+    for ( u8Offset = 0; u8Offset < psSession->u8AttributeBytes; u8Offset += psSession->au8Attributes[u8Offset] + 1 )
+    {
+        u16Length =  0;
+        ZNC_BUF_U16_UPD ( &au8Buffer[u16Length], psSession->u16Addr,                  u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[u16Length], DEVICE_INTERVIEW_SECTION_ATTRIBUTE,  u16Length );
+        memcpy ( &au8Buffer[u16Length], &psSession->au8Attributes[u8Offset + 1], psSession->au8Attributes[u8Offset] );
+        u16Length +=  psSession->au8Attributes[u8Offset];
+        vSL_WriteMessage ( E_SL_MSG_DEVICE_INTERVIEW_RESULT, u16Length, au8Buffer, 0 );
+    }
+
+    vLog_Printf ( TRACE_DEVICE_INTERVIEW, LOG_DEBUG, "\nInterview of %04x done, status %d in %d ticks, %d requests",
+                  psSession->u16Addr, psSession->u8Status, psSession->u16Elapsed, psSession->u8Requests );
+    psSession->u64IeeeAddr =  0;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,130 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_device_interview.h
+ *
+ * DESCRIPTION:        Interview of newly announced devices while they are
+ *                     awake (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef APP_DEVICE_INTERVIEW_H_
+#define APP_DEVICE_INTERVIEW_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include "zcl.h"
+#include "appZdpExtraction.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Devices interviewed at the same time */
+#ifndef DEVICE_INTERVIEW_MAX_SESSIONS
+#define DEVICE_INTERVIEW_MAX_SESSIONS           4
+#endif
+
+/* Requests of one interview on air at the same time; a sleepy device's
+ * parent holds few indirect frames for it */
+#ifndef DEVICE_INTERVIEW_MAX_OUTSTANDING
+#define DEVICE_INTERVIEW_MAX_OUTSTANDING        2
+#endif
+
+/* Endpoints, and clusters per direction of an endpoint, reported */
+#ifndef DEVICE_INTERVIEW_MAX_ENDPOINTS
+#define DEVICE_INTERVIEW_MAX_ENDPOINTS          4
+#endif
+#ifndef DEVICE_INTERVIEW_MAX_CLUSTERS
+#define DEVICE_INTERVIEW_MAX_CLUSTERS           16
+#endif
+
+/* Resends of a request before it is given up */
+#ifndef DEVICE_INTERVIEW_RETRIES
+#define DEVICE_INTERVIEW_RETRIES                2
+#endif
+
+/* Response timeouts in 100ms ticks; frames for a sleepy device wait up to
+ * 7.68s at its parent for the next poll */
+#ifndef DEVICE_INTERVIEW_RX_ON_TIMEOUT
+#define DEVICE_INTERVIEW_RX_ON_TIMEOUT          20
+#endif
+#ifndef DEVICE_INTERVIEW_SLEEPY_TIMEOUT
+#define DEVICE_INTERVIEW_SLEEPY_TIMEOUT         80
+#endif
+
+/* Whole interview limit in 100ms ticks */
+#ifndef DEVICE_INTERVIEW_MAX_DURATION
+#define DEVICE_INTERVIEW_MAX_DURATION           600
+#endif
+
+/* E_SL_MSG_DEVICE_INTERVIEW_RESULT sections */
+#define DEVICE_INTERVIEW_SECTION_SUMMARY        0
+#define DEVICE_INTERVIEW_SECTION_ENDPOINT       1
+#define DEVICE_INTERVIEW_SECTION_ATTRIBUTE      2
+
+/* E_SL_MSG_DEVICE_INTERVIEW_RESULT summary status */
+#define DEVICE_INTERVIEW_STATUS_COMPLETE        0
+#define DEVICE_INTERVIEW_STATUS_INCOMPLETE      1
+#define DEVICE_INTERVIEW_STATUS_TIMEOUT         2
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vDeviceInterviewInit ( void );
+PUBLIC void APP_vDeviceInterviewTick ( void );
+PUBLIC bool_t APP_bDeviceInterviewStart ( uint16    u16Addr,
+                                          uint64    u64IeeeAddr,
+                                          uint8     u8Capability );
+PUBLIC void APP_vDeviceInterviewCancel ( uint64    u64IeeeAddr );
+PUBLIC void APP_vDeviceInterviewZdpResponse ( uint16               u16SrcAddr,
+                                              ZPS_tsAfZdpEvent*    psZdpEvent );
+PUBLIC void APP_vDeviceInterviewAttribute ( uint16    u16SrcAddr,
+                                            uint8     u8SeqNum,
+                                            uint16    u16ClusterId,
+                                            uint8*    pu8Record,
+                                            uint16    u16RecordLength );
+PUBLIC void APP_vDeviceInterviewZclResponse ( uint16    u16SrcAddr,
+                                              uint8     u8SeqNum,
+                                              uint16    u16ClusterId,
+                                              bool_t    bSuccess );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_DEVICE_INTERVIEW_H_ */
@@ -0,0 +1,574 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_device_snapshot.c
+ *
+ * DESCRIPTION:        Compact snapshot of the devices known to the coordinator
+ *                     for fast host resynchronisation (Implementation)
+ *
+ *                     One record per device merged from the active neighbour
+ *                     table, the NWK address map, tmpNtActv and the APS key
+ *                     table (presence only, never key material). Each record
+ *                     remembers the generation in which it last changed so a
+ *                     host holding generation G can ask for the records that
+ *                     changed after G, including devices that went away.
+ *                     The upper 16 bits of a generation are a random epoch
+ *                     chosen at first use, so a generation from before a
+ *                     reset is never mistaken for a current one.
+ *
+ *                     Link quality is carried in every record but does not by
+ *                     itself mark a record as changed.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "dbg.h"
+#include "pdum_apl.h"
+#include "zps_apl.h"
+#include "zps_apl_zdo.h"
+#include "zps_apl_aib.h"
+#include "zps_apl_af.h"
+#include "zps_nwk_nib.h"
+#include "zps_struct.h"
+#include "rnd_pub.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_device_snapshot.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_DEVICE_SNAPSHOT
+#define TRACE_DEVICE_SNAPSHOT           TRUE
+#else
+#define TRACE_DEVICE_SNAPSHOT           FALSE
+#endif
+
+/* Version, mode, generation, base generation, frame index, frame count,
+ * total records, records in frame */
+#define DEVICE_SNAPSHOT_HEADER_LENGTH   15
+
+#define DEVICE_SNAPSHOT_CRC_INIT        0xFFFF
+#define DEVICE_SNAPSHOT_CRC_POLY        0x1021
+
+#define DEVICE_SNAPSHOT_GENERATION(u16Counter)    \
+    ( ( ( uint32 ) u16DeviceSnapshotEpoch << 16 ) | ( u16Counter ) )
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint64    u64IeeeAddr;          /* 0 when the slot is free */
+    uint16    u16NwkAddr;
+    uint16    u16Changed;           /* Counter part of the last generation that changed the record */
+    uint16    u16WorkNwkAddr;       /* Values gathered by the current refresh */
+    uint8     u8WorkFlags;
+    uint8     u8WorkLinkQuality;
+    uint8     u8Flags;
+    uint8     u8LinkQuality;
+} tsDeviceSnapshotEntry;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE void APP_vDeviceSnapshotRefresh ( void );
+PRIVATE void APP_vDeviceSnapshotMerge ( uint64    u64IeeeAddr,
+                                        uint16    u16NwkAddr,
+                                        uint8     u8Flags,
+                                        uint8     u8LinkQuality );
+PRIVATE bool_t APP_bDeviceSnapshotSelected ( tsDeviceSnapshotEntry*    psEntry,
+                                             bool_t                    bDiff,
+                                             uint16                    u16BaseCounter );
+PRIVATE uint16 APP_u16DeviceSnapshotCrc ( uint16    u16Crc,
+                                          uint8*    pu8Data,
+                                          uint16    u16Length );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+extern ZPS_NwkDevice    tmpNtActv[200];
+extern uint8            u8SizeTmpNtActv;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsDeviceSnapshotEntry    asDeviceSnapshot[DEVICE_SNAPSHOT_MAX_DEVICES];
+PRIVATE uint16                   u16DeviceSnapshotEpoch;
+PRIVATE uint16                   u16DeviceSnapshotCounter;
+/* Newest generation whose removal record was recycled; diffs must start at or after it */
+PRIVATE uint16                   u16DeviceSnapshotDiffFloor;
+PRIVATE uint16                   u16DeviceSnapshotOverflow;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ **
+ ** NAME:       APP_vDeviceSnapshotInit
+ **
+ ** DESCRIPTION:
+ ** Forgets all devices; the next snapshot starts a new generation history
+ **
+ ** RETURNS:
+ ** void
+ **
+ ****************************************************************************/
+PUBLIC void APP_vDeviceSnapshotInit ( void )
+{
+    memset ( asDeviceSnapshot, 0, sizeof ( asDeviceSnapshot ) );
+    u16DeviceSnapshotEpoch        =  0;
+    u16DeviceSnapshotCounter      =  0;
+    u16DeviceSnapshotDiffFloor    =  0;
+    u16DeviceSnapshotOverflow     =  0;
+}
+
+/****************************************************************************
+ **
+ ** NAME:       APP_vDeviceSnapshotSend
+ **
+ ** DESCRIPTION:
+ ** Refreshes the device records and streams them to the host as a series of
+ ** E_SL_MSG_DEVICE_SNAPSHOT_FRAME messages. The last frame carries a
+ ** CRC-16/CCITT over all frames, headers and records, in order.
+ **
+ ** A base generation of 0, from another epoch or older than the recycled
+ ** removal records gives a full snapshot; otherwise only the records that
+ ** changed after the base generation are sent.
+ **
+ ** RETURNS:
+ ** void
+ **
+ ****************************************************************************/
+PUBLIC void APP_vDeviceSnapshotSend ( uint32    u32BaseGeneration )
+{
+    uint8     au8Frame[ DEVICE_SNAPSHOT_HEADER_LENGTH +
+                        ( DEVICE_SNAPSHOT_RECORDS_PER_FRAME * DEVICE_SNAPSHOT_RECORD_LENGTH ) +
+                        sizeof ( uint16 ) + 1 ];
+    uint16    u16BaseCounter =  ( uint16 ) u32BaseGeneration;
+    uint16    u16Total       =  0;
+    uint16    u16Crc         =  DEVICE_SNAPSHOT_CRC_INIT;
+    uint16    u16Length;
+    uint16    i              =  0;
+    uint8     u8FrameCount;
+    uint8     u8FrameIndex;
+    uint8     u8InFrame;
+    uint8     u8RecordStart;
+    bool_t    bDiff;
+
+    APP_vDeviceSnapshotRefresh ( );
+
+    bDiff =  ( ( u32BaseGeneration != 0 )                                      &&
+               ( ( u32BaseGeneration >> 16 ) == u16DeviceSnapshotEpoch )      &&
+               ( u16BaseCounter >= u16DeviceSnapshotDiffFloor )               &&
+               ( u16BaseCounter <= u16DeviceSnapshotCounter ) );
+    if ( !bDiff )
+    {
+        u32BaseGeneration =  0;
+    }
+
+    for ( i = 0; i < DEVICE_SNAPSHOT_MAX_DEVICES; i++ )
+    {
+        if ( APP_bDeviceSnapshotSelected ( &asDeviceSnapshot[i], bDiff, u16BaseCounter ) )
+        {
+            u16Total++;
+        }
+    }
+
+    u8FrameCount =  ( u16Total + DEVICE_SNAPSHOT_RECORDS_PER_FRAME - 1 ) / DEVICE_SNAPSHOT_RECORDS_PER_FRAME;
+    if ( u8FrameCount == 0 )
+    {
+        /* Still send one frame so the host gets the generation and CRC */
+        u8FrameCount =  1;
+    }
+
+    vLog_Printf ( TRACE_DEVICE_SNAPSHOT, LOG_DEBUG, "\nSnapshot %s gen %08x base %08x: %d records %d frames",
+                  bDiff ? "diff" : "full",
+                  DEVICE_SNAPSHOT_GENERATION ( u16DeviceSnapshotCounter ),
+                  u32BaseGeneration,
+                  u16Total,
+                  u8FrameCount );
+
+    i =  0;
+    for ( u8FrameIndex = 0; u8FrameIndex < u8FrameCount; u8FrameIndex++ )
+    {
+        u16Length =  0;
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], DEVICE_SNAPSHOT_VERSION,                                    u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], bDiff ? DEVICE_SNAPSHOT_MODE_DIFF : DEVICE_SNAPSHOT_MODE_FULL, u16Length );
+        ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], DEVICE_SNAPSHOT_GENERATION ( u16DeviceSnapshotCounter ),     u16Length );
+        ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], u32BaseGeneration,                                          u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], u8FrameIndex,                                               u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], u8FrameCount,                                               u16Length );
+        ZNC_BUF_U16_UPD ( &au8Frame[ u16Length ], u16Total,                                                   u16Length );
+        /* Record count for this frame is filled in once known */
+        u8RecordStart =  u16Length;
+        u16Length++;
+
+        u8InFrame =  0;
+        while ( ( i < DEVICE_SNAPSHOT_MAX_DEVICES ) && ( u8InFrame < DEVICE_SNAPSHOT_RECORDS_PER_FRAME ) )
+        {
+            tsDeviceSnapshotEntry*    psEntry =  &asDeviceSnapshot[i++];
+
+            if ( APP_bDeviceSnapshotSelected ( psEntry, bDiff, u16BaseCounter ) )
+            {
+                ZNC_BUF_U64_UPD ( &au8Frame[ u16Length ], psEntry->u64IeeeAddr,     u16Length );
+                ZNC_BUF_U16_UPD ( &au8Frame[ u16Length ], psEntry->u16NwkAddr,      u16Length );
+                ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], psEntry->u8Flags,         u16Length );
+                ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], psEntry->u8LinkQuality,   u16Length );
+                u8InFrame++;
+            }
+        }
+        au8Frame[ u8RecordStart ] =  u8InFrame;
+
+        /* The CRC runs over every byte of every frame up to the CRC itself,
+         * so a header damaged in transit (a wrong frame index or record
+         * count) is caught as well as a damaged record */
+        u16Crc =  APP_u16DeviceSnapshotCrc ( u16Crc, au8Frame, u16Length );
+
+        if ( u8FrameIndex == ( u8FrameCount - 1 ) )
+        {
+            ZNC_BUF_U16_UPD ( &au8Frame[ u16Length ], u16Crc,                  u16Length );
+        }
+
+        vSL_WriteMessage ( E_SL_MSG_DEVICE_SNAPSHOT_FRAME,
+                           u16Length,
+                           au8Frame,
+                           0 );
+    }
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/****************************************************************************
+ **
+ ** NAME:       APP_vDeviceSnapshotRefresh
+ **
+ ** DESCRIPTION:
+ ** Merges the stack tables into the device records and stamps the records
+ ** that changed, or disappeared, with a new generation
+ **
+ ** RETURNS:
+ ** void
+ **
+ ****************************************************************************/
+PRIVATE void APP_vDeviceSnapshotRefresh ( void )
+{
+    void*                               pvNwk  =  ZPS_pvAplZdoGetNwkHandle ( );
+    ZPS_tsNwkNib*                       psNib  =  ZPS_psNwkNibGetHandle ( pvNwk );
+    ZPS_tsAplApsKeyDescriptorTable*     psKeys =  ZPS_psAplAibGetAib ( )->psAplDeviceKeyPairTable;
+    tsDeviceSnapshotEntry*              psEntry;
+    uint16                              u16Counter;
+    uint16                              i;
+    uint8                               u8Flags;
+    bool_t                              bChanged =  FALSE;
+
+    if ( u16DeviceSnapshotEpoch == 0 )
+    {
+        u16DeviceSnapshotEpoch =  RND_u32GetRand ( 1, 0xFFFF );
+    }
+
+    for ( i = 0; i < DEVICE_SNAPSHOT_MAX_DEVICES; i++ )
+    {
+        asDeviceSnapshot[i].u16WorkNwkAddr       =  ZPS_NWK_INVALID_NWK_ADDR;
+        asDeviceSnapshot[i].u8WorkFlags          =  0;
+        asDeviceSnapshot[i].u8WorkLinkQuality    =  0;
+    }
+
+    for ( i = 0; i < psNib->sTblSize.u16NtActv; i++ )
+    {
+        ZPS_tsNwkActvNtEntry*    psNt =  &psNib->sTbl.psNtActv[i];
+
+        if ( psNt->u16NwkAddr < ZPS_NWK_INVALID_NWK_ADDR )
+        {
+            u8Flags =  DEVICE_SNAPSHOT_FLAG_NEIGHBOUR;
+            if ( psNt->uAncAttrs.bfBitfields.u1RxOnWhenIdle )
+            {
+                u8Flags |=  DEVICE_SNAPSHOT_FLAG_RX_ON_WHEN_IDLE;
+            }
+            if ( psNt->uAncAttrs.bfBitfields.u1DeviceType )
+            {
+                u8Flags |=  DEVICE_SNAPSHOT_FLAG_ROUTER;
+            }
+            if ( psNt->uAncAttrs.bfBitfields.u1PowerSource )
+            {
+                u8Flags |=  DEVICE_SNAPSHOT_FLAG_MAINS_POWERED;
+            }
+            APP_vDeviceSnapshotMerge ( ZPS_u64NwkNibGetMappedIeeeAddr ( pvNwk, psNt->u16Lookup ),
+                                       psNt->u16NwkAddr,
+                                       u8Flags,
+                                       psNt->u8LinkQuality );
+        }
+    }
+
+    for ( i = 0; i < psNib->sTblSize.u16AddrMap; i++ )
+    {
+        if ( psNib->sTbl.pu16AddrMapNwk[i] < ZPS_NWK_INVALID_NWK_ADDR )
+        {
+            APP_vDeviceSnapshotMerge ( ZPS_u64NwkNibGetMappedIeeeAddr ( pvNwk, psNib->sTbl.pu16AddrLookup[i] ),
+                                       psNib->sTbl.pu16AddrMapNwk[i],
+                                       DEVICE_SNAPSHOT_FLAG_ADDRESS_MAP,
+                                       0 );
+        }
+    }
+
+    for ( i = 0; i < u8SizeTmpNtActv; i++ )
+    {
+        APP_vDeviceSnapshotMerge ( tmpNtActv[i].u64IEEEAddr,
+                                   tmpNtActv[i].u16ShortAddr,
+                                   DEVICE_SNAPSHOT_FLAG_DISCOVERED |
+                                   ( ( tmpNtActv[i].u8Type == 1 ) ? DEVICE_SNAPSHOT_FLAG_ROUTER : 0 ),
+                                   tmpNtActv[i].u8LinkQuality );
+    }
+
+    if ( psKeys != NULL )
+    {
+        for ( i = 0; i < psKeys->u16SizeOfKeyDescriptorTable; i++ )
+        {
+            APP_vDeviceSnapshotMerge ( ZPS_u64NwkNibGetMappedIeeeAddr ( pvNwk, psKeys->psAplApsKeyDescriptorEntry[i].u16ExtAddrLkup ),
+                                       ZPS_NWK_INVALID_NWK_ADDR,
+                                       DEVICE_SNAPSHOT_FLAG_LINK_KEY,
+                                       0 );
+        }
+    }
+
+    u16Counter =  u16DeviceSnapshotCounter + 1;
+    for ( i = 0; i < DEVICE_SNAPSHOT_MAX_DEVICES; i++ )
+    {
+        psEntry =  &asDeviceSnapshot[i];
+        if ( psEntry->u64IeeeAddr == 0 )
+        {
+            continue;
+        }
+
+        if ( psEntry->u8WorkFlags != 0 )
+        {
+            if ( ( psEntry->u8WorkFlags != psEntry->u8Flags ) ||
+                 ( psEntry->u16WorkNwkAddr != psEntry->u16NwkAddr ) )
+            {
+                psEntry->u8Flags       =  psEntry->u8WorkFlags;
+                psEntry->u16NwkAddr    =  psEntry->u16WorkNwkAddr;
+                psEntry->u16Changed    =  u16Counter;
+                bChanged               =  TRUE;
+            }
+            psEntry->u8LinkQuality =  psEntry->u8WorkLinkQuality;
+        }
+        else if ( ( psEntry->u8Flags & DEVICE_SNAPSHOT_FLAG_REMOVED ) == 0 )
+        {
+            psEntry->u8Flags       =  DEVICE_SNAPSHOT_FLAG_REMOVED;
+            psEntry->u8LinkQuality =  0;
+            psEntry->u16Changed    =  u16Counter;
+            bChanged               =  TRUE;
+        }
+    }
+
+    if ( bChanged )
+    {
+        if ( u16Counter == 0xFFFF )
+        {
+            /* Counter exhausted: start a new epoch, hosts resync with a full snapshot */
+            u16DeviceSnapshotEpoch++;
+            if ( u16DeviceSnapshotEpoch == 0 )
+            {
+                u16DeviceSnapshotEpoch =  1;
+            }
+            u16Counter                    =  1;
+            u16DeviceSnapshotDiffFloor    =  0;
+            for ( i = 0; i < DEVICE_SNAPSHOT_MAX_DEVICES; i++ )
+            {
+                if ( asDeviceSnapshot[i].u8Flags & DEVICE_SNAPSHOT_FLAG_REMOVED )
+                {
+                    memset ( &asDeviceSnapshot[i], 0, sizeof ( tsDeviceSnapshotEntry ) );
+                }
+                else
+                {
+                    asDeviceSnapshot[i].u16Changed =  u16Counter;
+                }
+            }
+        }
+        u16DeviceSnapshotCounter =  u16Counter;
+    }
+
+    if ( u16DeviceSnapshotOverflow != 0 )
+    {
+        vLog_Printf ( TRACE_DEVICE_SNAPSHOT, LOG_DEBUG, "\nSnapshot table full, %d devices dropped",
+                      u16DeviceSnapshotOverflow );
+        u16DeviceSnapshotOverflow =  0;
+    }
+}
+
+/****************************************************************************
+ **
+ ** NAME:       APP_vDeviceSnapshotMerge
+ **
+ ** DESCRIPTION:
+ ** Adds what one stack table knows about a device to its record. When the
+ ** table is full the oldest removal record is recycled.
+ **
+ ** RETURNS:
+ ** void
+ **
+ ****************************************************************************/
+PRIVATE void APP_vDeviceSnapshotMerge ( uint64    u64IeeeAddr,
+                                        uint16    u16NwkAddr,
+                                        uint8     u8Flags,
+                                        uint8     u8LinkQuality )
+{
+    tsDeviceSnapshotEntry*    psEntry    =  NULL;
+    tsDeviceSnapshotEntry*    psFree     =  NULL;
+    tsDeviceSnapshotEntry*    psOldest   =  NULL;
+    uint16                    i;
+
+    if ( ( u64IeeeAddr == ZPS_NWK_NULL_EXT_ADDR ) || ( u64IeeeAddr == 0xFFFFFFFFFFFFFFFFULL ) )
+    {
+        return;
+    }
+
+    for ( i = 0; i < DEVICE_SNAPSHOT_MAX_DEVICES; i++ )
+    {
+        if ( asDeviceSnapshot[i].u64IeeeAddr == u64IeeeAddr )
+        {
+            psEntry =  &asDeviceSnapshot[i];
+            break;
+        }
+        if ( asDeviceSnapshot[i].u64IeeeAddr == 0 )
+        {
+            if ( psFree == NULL )
+            {
+                psFree =  &asDeviceSnapshot[i];
+            }
+        }
+        else if ( ( asDeviceSnapshot[i].u8WorkFlags == 0 )                           &&
+                  ( asDeviceSnapshot[i].u8Flags & DEVICE_SNAPSHOT_FLAG_REMOVED )     &&
+                  ( ( psOldest == NULL ) || ( asDeviceSnapshot[i].u16Changed < psOldest->u16Changed ) ) )
+        {
+            psOldest =  &asDeviceSnapshot[i];
+        }
+    }
+
+    if ( psEntry == NULL )
+    {
+        if ( psFree != NULL )
+        {
+            psEntry =  psFree;
+        }
+        else if ( psOldest != NULL )
+        {
+            if ( psOldest->u16Changed > u16DeviceSnapshotDiffFloor )
+            {
+                u16DeviceSnapshotDiffFloor =  psOldest->u16Changed;
+            }
+            psEntry =  psOldest;
+        }
+        else
+        {
+            u16DeviceSnapshotOverflow++;
+            return;
+        }
+
+        memset ( psEntry, 0, sizeof ( tsDeviceSnapshotEntry ) );
+        psEntry->u64IeeeAddr       =  u64IeeeAddr;
+        psEntry->u16NwkAddr        =  ZPS_NWK_INVALID_NWK_ADDR;
+        psEntry->u16WorkNwkAddr    =  ZPS_NWK_INVALID_NWK_ADDR;
+    }
+
+    psEntry->u8WorkFlags |=  u8Flags;
+    if ( u16NwkAddr < ZPS_NWK_INVALID_NWK_ADDR )
+    {
+        psEntry->u16WorkNwkAddr =  u16NwkAddr;
+    }
+    if ( u8LinkQuality > psEntry->u8WorkLinkQuality )
+    {
+        psEntry->u8WorkLinkQuality =  u8LinkQuality;
+    }
+}
+
+/****************************************************************************
+ **
+ ** NAME:       APP_bDeviceSnapshotSelected
+ **
+ ** DESCRIPTION:
+ ** Whether a record belongs in the snapshot being sent
+ **
+ ** RETURNS:
+ ** TRUE if the record is sent
+ **
+ ****************************************************************************/
+PRIVATE bool_t APP_bDeviceSnapshotSelected ( tsDeviceSnapshotEntry*    psEntry,
+                                             bool_t                    bDiff,
+                                             uint16                    u16BaseCounter )
+{
+    if ( psEntry->u64IeeeAddr == 0 )
+    {
+        return FALSE;
+    }
+    if ( bDiff )
+    {
+        return ( psEntry->u16Changed > u16BaseCounter );
+    }
+    return ( ( psEntry->u8Flags & DEVICE_SNAPSHOT_FLAG_REMOVED ) == 0 );
+}
+
+/****************************************************************************
+ **
+ ** NAME:       APP_u16DeviceSnapshotCrc
+ **
+ ** DESCRIPTION:
+ ** CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over a block of bytes
+ **
+ ** RETURNS:
+ ** Updated CRC
+ **
+ ****************************************************************************/
+PRIVATE uint16 APP_u16DeviceSnapshotCrc ( uint16    u16Crc,
+                                          uint8*    pu8Data,
+                                          uint16    u16Length )
+{
+    uint8    u8Bit;
+
+    while ( u16Length-- )
+    {
+        u16Crc ^=  ( uint16 ) ( *pu8Data++ ) << 8;
+        for ( u8Bit = 0; u8Bit < 8; u8Bit++ )
+        {
+            u16Crc =  ( u16Crc & 0x8000 ) ? ( uint16 ) ( ( u16Crc << 1 ) ^ DEVICE_SNAPSHOT_CRC_POLY ) : ( uint16 ) ( u16Crc << 1 );
+        }
+    }
+    return u16Crc;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
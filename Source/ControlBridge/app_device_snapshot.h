@@ -0,0 +1,92 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_device_snapshot.h
+ *
+ * DESCRIPTION:        Compact snapshot of the devices known to the coordinator
+ *                     for fast host resynchronisation (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef APP_DEVICE_SNAPSHOT_H_
+#define APP_DEVICE_SNAPSHOT_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Number of devices remembered between snapshots (matches tmpNtActv) */
+#ifndef DEVICE_SNAPSHOT_MAX_DEVICES
+#define DEVICE_SNAPSHOT_MAX_DEVICES             200
+#endif
+
+/* Records carried by one E_SL_MSG_DEVICE_SNAPSHOT_FRAME */
+#ifndef DEVICE_SNAPSHOT_RECORDS_PER_FRAME
+#define DEVICE_SNAPSHOT_RECORDS_PER_FRAME       16
+#endif
+
+/* Version 2: the CRC also covers the frame headers */
+#define DEVICE_SNAPSHOT_VERSION                 2
+#define DEVICE_SNAPSHOT_RECORD_LENGTH           12
+
+#define DEVICE_SNAPSHOT_MODE_FULL               0
+#define DEVICE_SNAPSHOT_MODE_DIFF               1
+
+/* Record flags */
+#define DEVICE_SNAPSHOT_FLAG_NEIGHBOUR          0x01    /* In the active neighbour table */
+#define DEVICE_SNAPSHOT_FLAG_ADDRESS_MAP        0x02    /* In the NWK address map */
+#define DEVICE_SNAPSHOT_FLAG_DISCOVERED         0x04    /* Learnt from Mgmt_Lqi / Mgmt_Rtg (tmpNtActv) */
+#define DEVICE_SNAPSHOT_FLAG_LINK_KEY           0x08    /* Has an APS link key entry */
+#define DEVICE_SNAPSHOT_FLAG_RX_ON_WHEN_IDLE    0x10
+#define DEVICE_SNAPSHOT_FLAG_ROUTER             0x20
+#define DEVICE_SNAPSHOT_FLAG_MAINS_POWERED      0x40
+#define DEVICE_SNAPSHOT_FLAG_REMOVED            0x80    /* Diff only: device has gone */
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vDeviceSnapshotInit ( void );
+PUBLIC void APP_vDeviceSnapshotSend ( uint32    u32BaseGeneration );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_DEVICE_SNAPSHOT_H_ */
@@ -76,6 +76,24 @@
 #ifdef CLD_OTA
 #include "app_ota_server.h"
 #endif
+#ifdef APS_QUEUE
+#include "app_aps_queue.h"
+#endif
+#ifdef CHILD_QUEUE
+#include "app_child_queue.h"
+#endif
+#ifdef CHANNEL_QUALITY
+#include "app_channel_quality.h"
+#endif
+#ifdef ATTRIBUTE_CACHE
+#include "app_attribute_cache.h"
+#endif
+#ifdef DEVICE_INTERVIEW
+#include "app_device_interview.h"
+#endif
+#ifdef OTA_FLEET
+#include "app_ota_fleet.h"
+#endif
 #include "fsl_wwdt.h"
 
 #include "app.h"
@@ -113,6 +131,7 @@ extern void *ZPS_pvNwkSecGetNetworkKey ( void*    pvNwk );
 /****************************************************************************/
 
 uint32    u32Storage;
+bool_t    bDataIndicationForwarded =  FALSE;
 
 /****************************************************************************/
 /***        Local Variables                                               ***/
@@ -617,6 +636,18 @@ PUBLIC void APP_vHandleStackEvents ( ZPS_tsAfEvent*    psStackEvent )
 		}
 		break;
         case ZPS_EVENT_APS_DATA_CONFIRM:
+#ifdef APS_QUEUE
+            APP_vApsQueueConfirm ( psStackEvent->uEvent.sApsDataConfirmEvent.u8SequenceNum );
+#endif
+#ifdef CHILD_QUEUE
+            APP_vChildQueueDataConfirm ( &psStackEvent->uEvent.sApsDataConfirmEvent );
+#endif
+#ifdef CHANNEL_QUALITY
+            APP_vChannelQualityDataConfirm ( &psStackEvent->uEvent.sApsDataConfirmEvent );
+#endif
+#ifdef OTA_FLEET
+            APP_vOtaFleetDataConfirm ( );
+#endif
             vLog_Printf(TRACE_APP,LOG_DEBUG, "\nCFM: SEP=%d DEP=%d Status=%d\n",
                     psStackEvent->uEvent.sApsDataConfirmEvent.u8SrcEndpoint,
                     psStackEvent->uEvent.sApsDataConfirmEvent.u8DstEndpoint,
@@ -721,6 +752,10 @@ PUBLIC void APP_vHandleStackEvents ( ZPS_tsAfEvent*    psStackEvent )
 
                 zps_bAplZdpUnpackResponse ( psStackEvent,
                                             &sApsZdpEvent );
+#ifdef DEVICE_INTERVIEW
+                APP_vDeviceInterviewZdpResponse ( psStackEvent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr,
+                                                  &sApsZdpEvent );
+#endif
 
                 ZNC_BUF_U8_UPD ( &au8LinkTxBuffer [0] , sApsZdpEvent.u8SequNumber, u16Length );
 
@@ -746,6 +781,22 @@ PUBLIC void APP_vHandleStackEvents ( ZPS_tsAfEvent*    psStackEvent )
                                            u16Length,
                                            au8LinkTxBuffer,
                                            u8LinkQuality);
+#ifdef ATTRIBUTE_CACHE
+                        APP_vAttributeCacheRemoveDevice ( sApsZdpEvent.uZdpData.sDeviceAnnce.u64IeeeAddr );
+#endif
+#ifdef CHILD_QUEUE
+                        APP_vChildQueueAnnounce ( sApsZdpEvent.uZdpData.sDeviceAnnce.u16NwkAddr,
+                                                  sApsZdpEvent.uZdpData.sDeviceAnnce.u64IeeeAddr );
+#endif
+#ifdef DEVICE_INTERVIEW
+                        /* A raw mode host decodes the frames itself */
+                        if ( sZllState.u8RawMode != RAW_MODE_ON )
+                        {
+                            APP_bDeviceInterviewStart ( sApsZdpEvent.uZdpData.sDeviceAnnce.u16NwkAddr,
+                                                        sApsZdpEvent.uZdpData.sDeviceAnnce.u64IeeeAddr,
+                                                        sApsZdpEvent.uZdpData.sDeviceAnnce.u8Capability );
+                        }
+#endif
                         uint8 u8Index = 0xff;
                         if ( bIsMacAddrInMacInstallCodeTable(sApsZdpEvent.uZdpData.sDeviceAnnce.u64IeeeAddr, &u8Index))
                         {
@@ -1036,6 +1087,11 @@ PUBLIC void APP_vHandleStackEvents ( ZPS_tsAfEvent*    psStackEvent )
                         ZNC_BUF_U8_UPD   ( &au8LinkTxBuffer [u16Length] , sApsZdpEvent.uZdpData.sMgmtNwkUpdateNotify.u8ScannedChannelListCount,    u16Length );
                         if( sApsZdpEvent.uZdpData.sMgmtNwkUpdateNotify.u8Status == ZPS_E_SUCCESS )
                         {
+#ifdef CHANNEL_QUALITY
+                            APP_vChannelQualityEnergyScan ( sApsZdpEvent.uZdpData.sMgmtNwkUpdateNotify.u32ScannedChannels,
+                                                            sApsZdpEvent.uZdpData.sMgmtNwkUpdateNotify.u8ScannedChannelListCount,
+                                                            sApsZdpEvent.uLists.au8Data );
+#endif
                             while ( i < sApsZdpEvent.uZdpData.sMgmtNwkUpdateNotify.u8ScannedChannelListCount )
                             {
                                 ZNC_BUF_U8_UPD  ( &au8LinkTxBuffer [u16Length] , sApsZdpEvent.uLists.au8Data [ i ],    u16Length );
@@ -1296,6 +1352,15 @@ PUBLIC void APP_vHandleStackEvents ( ZPS_tsAfEvent*    psStackEvent )
                                         u16Length,
                                         au8LinkTxBuffer,
                                         u8LinkQuality );
+#ifdef ATTRIBUTE_CACHE
+                     APP_vAttributeCacheRemoveDevice ( psStackEvent->uEvent.sNwkLeaveIndicationEvent.u64ExtAddr );
+#endif
+#ifdef DEVICE_INTERVIEW
+                     APP_vDeviceInterviewCancel ( psStackEvent->uEvent.sNwkLeaveIndicationEvent.u64ExtAddr );
+#endif
+#ifdef CHILD_QUEUE
+                     APP_vChildQueueRemoveDevice ( psStackEvent->uEvent.sNwkLeaveIndicationEvent.u64ExtAddr );
+#endif
                 }
             }
             break;
@@ -1611,11 +1676,15 @@ PRIVATE void APP_vWrite64Nbo( uint64    u64dWord,
 PUBLIC void Znc_vSendDataIndicationToHost ( ZPS_tsAfEvent*    psStackEvent,
                                             uint8*            pau8LinkTxBuffer )
 {
-    uint16    u16Length =  0;
-    uint16    i         =  0;
-    uint8*    dataPtr   =  ( uint8* ) PDUM_pvAPduInstanceGetPayload ( psStackEvent->uEvent.sApsDataIndEvent.hAPduInst );
-    uint8     u8Size    =  PDUM_u16APduInstanceGetPayloadSize( psStackEvent->uEvent.sApsDataIndEvent.hAPduInst);
-    uint8     u8LinkQuality;
+    uint16          u16Length =  0;
+    uint8           u8LinkQuality;
+    tsSL_Segment    asSegments[2];
+
+    /* Hybrid mode already forwarded this indication before ZCL parsed it */
+    if ( bDataIndicationForwarded )
+    {
+        return;
+    }
     u8LinkQuality=psStackEvent->uEvent.sApsDataIndEvent.u8LinkQuality;
 
     ZNC_BUF_U8_UPD  ( &pau8LinkTxBuffer[u16Length] ,
@@ -1666,18 +1735,17 @@ PUBLIC void Znc_vSendDataIndicationToHost ( ZPS_tsAfEvent*    psStackEvent,
                           psStackEvent->uEvent.sApsDataIndEvent.uDstAddress.u16Addr,
                           u16Length );
     }
-    while ( i < u8Size )
-    {
-        ZNC_BUF_U8_UPD  ( &pau8LinkTxBuffer[u16Length] ,
-                          dataPtr [ i ],
-                          u16Length );
-        i++;
-    }
 
-    vSL_WriteMessage ( E_SL_MSG_DATA_INDICATION,
-                       u16Length,
-                       pau8LinkTxBuffer,
-                       u8LinkQuality);
+    /* Payload goes out straight from the APDU, which the caller frees after */
+    asSegments[0].pu8Data   =  pau8LinkTxBuffer;
+    asSegments[0].u16Length =  u16Length;
+    asSegments[1].pu8Data   =  ( uint8* ) PDUM_pvAPduInstanceGetPayload ( psStackEvent->uEvent.sApsDataIndEvent.hAPduInst );
+    asSegments[1].u16Length =  PDUM_u16APduInstanceGetPayloadSize ( psStackEvent->uEvent.sApsDataIndEvent.hAPduInst );
+
+    vSL_WriteMessageVector ( E_SL_MSG_DATA_INDICATION,
+                             2,
+                             asSegments,
+                             u8LinkQuality);
 
     if ((psStackEvent->uEvent.sApsDataIndEvent.u8SrcEndpoint!=0) && (psStackEvent->uEvent.sApsDataIndEvent.u8DstEndpoint!=0))
     {
@@ -62,6 +62,16 @@
 #define DEVICE_ID_GP_PROXY_BASIC            0x61
 #define PDM_VALID_BITS                      0x000F
 #define PDM_TRANS_POINTER_INFO_INDEX        0x04
+#define GP_PDM_HASH_OFFSET                  0x811C9DC5UL
+#define GP_PDM_HASH_PRIME                   0x01000193UL
+/* Translation table index key of entries holding a wildcard address */
+#define GP_TRANS_KEY_WILDCARD               0x00000000UL
+#define GP_TRANS_APP_ID_MASK                0x07
+#define GP_TRANS_APP_ID_SRC_ID              0x00
+
+#if (GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES > 16) || (GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES > 16)
+#error "GP tables are persisted one PDM record per entry, 16 IDs are reserved per table"
+#endif
 /****************************************************************************/
 /***        Type Definitions                                              ***/
 /****************************************************************************/
@@ -103,7 +113,18 @@ bool  bAppAddTransTableEntries(
 void vApp_UpdateTranslationTableOnPairingCfg(tsGP_ZgpsPairingConfigCmdRcvd *psPairingConfigCmdRcvd);
 #ifdef GP_COMBO_BASIC_DEVICE
 void vInitTranslationTablePointers(void);
+PRIVATE uint32 u32App_GPTransKey(
+        uint8                u8AppId,
+        tuGP_ZgpdDeviceAddr *puAddr);
+PRIVATE void vApp_GPTransIndexUpdate(uint8 u8Index);
+PRIVATE void vApp_GPTransIndexRebuild(void);
+PRIVATE uint8 u8App_GPClearTranslationEntries(
+        uint8                u8AppId,
+        tuGP_ZgpdDeviceAddr *puAddr);
 #endif
+PRIVATE uint32 u32App_GPHash(void *pvData, uint16 u16Length);
+PRIVATE void vApp_GPMarkPersisted(void);
+PRIVATE uint16 u16App_GPSaveDirtyRecords(bool_t bForce);
 /****************************************************************************/
 /*          Exported Variables                                              */
 /****************************************************************************/
@@ -116,6 +137,23 @@ tsGP_PDM_Data sGP_PDM_Data;
 
 tsGP_GreenPowerDevice               sGPDeviceInfo;
 
+#ifdef GP_COMBO_BASIC_DEVICE
+/* Index over the translation table: one bit per occupied slot and a key
+ * (hash of application id and GPD address) per slot, so lookups only run
+ * the full address match on likely candidates and free slots are found
+ * without a scan */
+PRIVATE uint32 u32GpTransUsed;
+PRIVATE uint32 au32GpTransKey[GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES];
+PRIVATE uint32 au32GpTransPersisted[GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES];
+PRIVATE uint32 u32GpCmdInfoPersisted;
+#endif
+/* Hash of each record as last written to PDM; entries whose hash moved are dirty */
+PRIVATE uint32 au32GpSinkPersisted[GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES];
+PRIVATE uint32 u32GpRestoreInfoPersisted;
+/* Set once the tables hold what PDM holds; until then (staged boot) a
+ * persist request would overwrite the records with empty entries */
+PRIVATE bool_t bGpPdmLoaded = FALSE;
+
 #if 0
 /* ZCL command info for default Level control device . The same is used for on/off device,Generic 1-state Switch, Advanced Generic 1-state Switch*/
 tsGP_GpToZclCommandInfo asGpToZclLevelControlCmdInfo[] = {
@@ -293,6 +331,47 @@ void vAPP_GP_LoadPDMData(void)
 {
     uint8 u8Status;
     uint16 u16ByteRead;
+    uint8 i;
+
+    bGpPdmLoaded = TRUE;
+    if((FALSE == PDM_bDoesDataExist(PDM_ID_APP_CLD_GP_TRANS_TABLE, &u16ByteRead)) &&
+       (FALSE == PDM_bDoesDataExist(PDM_ID_APP_CLD_GP_SINK_PROXY_TABLE, &u16ByteRead)))
+    {
+        PDM_eReadDataFromRecord(PDM_ID_APP_CLD_GP_RESTORE_INFO,
+                                &sGP_PDM_Data.u32RestoreGPPDMInfo,
+                                sizeof(sGP_PDM_Data.u32RestoreGPPDMInfo),
+                                &u16ByteRead);
+#ifdef GP_COMBO_BASIC_DEVICE
+        PDM_eReadDataFromRecord(PDM_ID_APP_CLD_GP_CMD_INFO_UPDATE,
+                                sGP_PDM_Data.asGpToZclCmdInfoUpdate,
+                                sizeof(sGP_PDM_Data.asGpToZclCmdInfoUpdate),
+                                &u16ByteRead);
+        for(i = 0; i < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; i++)
+        {
+            PDM_eReadDataFromRecord(PDM_ID_APP_CLD_GP_TRANS_ENTRY + i,
+                                    &sGP_PDM_Data.asGpTranslationTable[i],
+                                    sizeof(tsGP_TranslationTableEntry),
+                                    &u16ByteRead);
+        }
+        vApp_GPTransIndexRebuild();
+#endif
+        for(i = 0; i < GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES; i++)
+        {
+            PDM_eReadDataFromRecord(PDM_ID_APP_CLD_GP_SINK_PROXY_ENTRY + i,
+                                    &sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[i],
+                                    sizeof(tsGP_ZgppProxySinkTable),
+                                    &u16ByteRead);
+        }
+        vApp_GPMarkPersisted();
+        DBG_vPrintf(TRACE_APP_GP, "\n vAPP_GP_LoadPDMData info = 0x%x address = 0x%8x %d\n",
+                sGP_PDM_Data.u32RestoreGPPDMInfo,
+                sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[0].uZgpdDeviceAddr.u32ZgpdSrcId,
+                sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[0].bProxyTableEntryOccupied);
+        return;
+    }
+
+    /* Whole-table records from an earlier build: load them, rewrite them as
+     * per-entry records and drop them */
     u8Status = PDM_eReadDataFromRecord(PDM_ID_APP_CLD_GP_TRANS_TABLE,
                                                &sGP_PDM_Data,
                                                sizeof(sGP_PDM_Data),
@@ -306,6 +385,31 @@ void vAPP_GP_LoadPDMData(void)
     DBG_vPrintf(TRACE_APP_GP, "\n vAPP_GP_LoadPDMData PDM_ID_APP_CLD_GP_SINK_PROXY_TABLE u8Status = %d u16ByteRead = %d %d address = 0x%8x %d\n",u8Status, u16ByteRead,
             sizeof(sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable),sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[0].uZgpdDeviceAddr.u32ZgpdSrcId,
             sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[0].bProxyTableEntryOccupied);
+#ifdef GP_COMBO_BASIC_DEVICE
+    vApp_GPTransIndexRebuild();
+#endif
+    u16App_GPSaveDirtyRecords(TRUE);
+    PDM_vDeleteDataRecord(PDM_ID_APP_CLD_GP_TRANS_TABLE);
+    PDM_vDeleteDataRecord(PDM_ID_APP_CLD_GP_SINK_PROXY_TABLE);
+}
+
+/****************************************************************************
+ * NAME: vAPP_GP_LoadDeferredPDMData
+ *
+ * DESCRIPTION:
+ * Loads GP data from PDM after the GP end point has been registered (staged
+ * boot). The cluster works on sGPDeviceInfo's sink table in place, so only
+ * the translation table pointers need to be set up again
+ ****************************************************************************/
+void vAPP_GP_LoadDeferredPDMData(void)
+{
+    vAPP_GP_LoadPDMData();
+#ifdef GP_COMBO_BASIC_DEVICE
+    if(GP_PDM_DATA_VALID == (sGP_PDM_Data.u32RestoreGPPDMInfo & PDM_VALID_BITS))
+    {
+        vInitTranslationTablePointers();
+    }
+#endif
 }
 
 /****************************************************************************
@@ -316,13 +420,31 @@ void vAPP_GP_LoadPDMData(void)
  ****************************************************************************/
 void vAPP_GP_ResetData(void)
 {
+    uint8 i;
 
+    bGpPdmLoaded = TRUE;
     PDM_vDeleteDataRecord(PDM_ID_APP_CLD_GP_TRANS_TABLE);
     PDM_vDeleteDataRecord(PDM_ID_APP_CLD_GP_SINK_PROXY_TABLE);
+    PDM_vDeleteDataRecord(PDM_ID_APP_CLD_GP_RESTORE_INFO);
+#ifdef GP_COMBO_BASIC_DEVICE
+    PDM_vDeleteDataRecord(PDM_ID_APP_CLD_GP_CMD_INFO_UPDATE);
+    for(i = 0; i < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; i++)
+    {
+        PDM_vDeleteDataRecord(PDM_ID_APP_CLD_GP_TRANS_ENTRY + i);
+    }
+#endif
+    for(i = 0; i < GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES; i++)
+    {
+        PDM_vDeleteDataRecord(PDM_ID_APP_CLD_GP_SINK_PROXY_ENTRY + i);
+    }
     memset( &(sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable),0,
                sizeof(sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable));
     memset(&sGP_PDM_Data,0,
             sizeof(tsGP_PDM_Data));
+#ifdef GP_COMBO_BASIC_DEVICE
+    vApp_GPTransIndexRebuild();
+#endif
+    vApp_GPMarkPersisted();
 }
 /****************************************************************************
  * NAME: vAPP_GP_SetCommModeLtWt
@@ -351,8 +473,6 @@ void vHandleGreenPowerEvent(tsGP_GreenPowerCallBackMessage *psGPMessage)
 {
     DBG_vPrintf(TRACE_APP_GP, "Green Power Callback Message\n");
 #ifdef GP_COMBO_BASIC_DEVICE
-    uint8  u8Count;
-    tsGP_TranslationTableEntry *psTranslationTableEntry = NULL;
     tsZCL_Address                          sDestinationAddress;
 #endif
     switch(psGPMessage->eEventType)
@@ -508,15 +628,15 @@ void vHandleGreenPowerEvent(tsGP_GreenPowerCallBackMessage *psGPMessage)
         case E_GP_PERSIST_SINK_PROXY_TABLE:
         {
             DBG_vPrintf(TRACE_APP_GP, "E_GP_PERSIST_SINK_PROXY_TABLE \n");
+            if(!bGpPdmLoaded)
+            {
+                DBG_vPrintf(TRACE_APP_GP, "GP PDM data not loaded yet, persist skipped\n");
+                break;
+            }
             sGP_PDM_Data.u32RestoreGPPDMInfo &= ~PDM_VALID_BITS;
             sGP_PDM_Data.u32RestoreGPPDMInfo |= GP_PDM_DATA_VALID;
 
-            PDM_eSaveRecordData(PDM_ID_APP_CLD_GP_TRANS_TABLE,
-                                &sGP_PDM_Data,
-                                sizeof(tsGP_PDM_Data));
-            PDM_eSaveRecordData(PDM_ID_APP_CLD_GP_SINK_PROXY_TABLE,
-                                   &(sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable),
-                                   sizeof(sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable));
+            u16App_GPSaveDirtyRecords(FALSE);
             break;
         }
 #ifdef GP_COMBO_BASIC_DEVICE
@@ -536,19 +656,8 @@ void vHandleGreenPowerEvent(tsGP_GreenPowerCallBackMessage *psGPMessage)
             DBG_vPrintf(TRACE_APP_GP, "E_GP_DECOMM_CMD_RCVD ,0x%08x\n",
                     psGPMessage->uMessage.psZgpDecommissionIndication->uZgpdDeviceAddr.u32ZgpdSrcId);
 #ifdef GP_COMBO_BASIC_DEVICE
-            for(u8Count = 0; u8Count < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; u8Count++)
-            {
-                uint8                u8TranslationTableIndex;
-                psTranslationTableEntry =
-                    psApp_GPGetTranslationTable(psGPMessage->uMessage.psZgpDecommissionIndication->u8ApplicationId,
-                            &u8TranslationTableIndex,
-                            &(psGPMessage->uMessage.psZgpDecommissionIndication->uZgpdDeviceAddr));
-                if(NULL != psTranslationTableEntry)
-                {
-                    memset(psTranslationTableEntry,0,sizeof(tsGP_TranslationTableEntry));
-                    sGP_PDM_Data.u32RestoreGPPDMInfo &= ~(1 << (u8TranslationTableIndex + PDM_TRANS_POINTER_INFO_INDEX ));
-                }
-            }
+            u8App_GPClearTranslationEntries(psGPMessage->uMessage.psZgpDecommissionIndication->u8ApplicationId,
+                    &(psGPMessage->uMessage.psZgpDecommissionIndication->uZgpdDeviceAddr));
             sDestinationAddress.eAddressMode = E_ZCL_AM_BROADCAST;
                     sDestinationAddress.uAddress.eBroadcastMode = ZPS_E_APL_AF_BROADCAST_RX_ON;
 
@@ -586,29 +695,14 @@ bool  bAppAddTransTableEntries(
         )
 {
 
-    uint8 u8Count = 0,u8TranslationTableIndex;
+    uint8 u8TranslationTableIndex;
     tsGP_TranslationTableEntry *psTranslationTableEntry;
     /* uDummydeviceAddr will be used to get a unused/free entry from translation table */
     tuGP_ZgpdDeviceAddr uDummydeviceAddr = { 0 };
 
     /* Check if previous entry with the same device exists, delete all such entries
      * if any  */
-    for(u8Count = 0; u8Count < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; u8Count++)
-    {
-        psTranslationTableEntry =
-            psApp_GPGetTranslationTable(b8Options,&u8TranslationTableIndex, &(uRcvdGPDAddr));
-        if( psTranslationTableEntry == NULL )
-        {
-            break;
-        }
-        else
-        {
-            /* clear entry */
-            memset(&psTranslationTableEntry->uZgpdDeviceAddr, 0, sizeof(tuGP_ZgpdDeviceAddr));
-            DBG_vPrintf(TRACE_APP_GP, "cleared translation table  \n");
-            sGP_PDM_Data.u32RestoreGPPDMInfo &= ~(1 << (u8TranslationTableIndex + PDM_TRANS_POINTER_INFO_INDEX ));
-        }
-    }
+    u8App_GPClearTranslationEntries(b8Options, &uRcvdGPDAddr);
 
     /* Now add translation table entry for each command supported */
 
@@ -625,6 +719,7 @@ bool  bAppAddTransTableEntries(
 
         psTranslationTableEntry->psGpToZclCmdInfo = asGpToZclLevelControlCmdInfo;
         psTranslationTableEntry->u8NoOfCmdInfo = sizeof(asGpToZclLevelControlCmdInfo)/sizeof(tsGP_GpToZclCommandInfo);
+        vApp_GPTransIndexUpdate(u8TranslationTableIndex);
         DBG_vPrintf(TRACE_APP_GP, "ENTRY ADDED TO THE TABLE = 0x%x\n", psTranslationTableEntry->psGpToZclCmdInfo->eZgpdCommandId);
         return TRUE;
     }
@@ -648,10 +743,32 @@ PRIVATE tsGP_TranslationTableEntry* psApp_GPGetTranslationTable(
         tuGP_ZgpdDeviceAddr *uSrcAddr)
 {
     uint8 u8Count;
+    uint32 u32Key;
+
+    if((u8AppId == 0) && (uSrcAddr->u32ZgpdSrcId == 0))
+    {
+        /* free entry: first slot without a GPD */
+        for(u8Count = 0; u8Count < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; u8Count++)
+        {
+            if((u32GpTransUsed & (1UL << u8Count)) == 0)
+            {
+                *pu8TranslationTableIndex = u8Count;
+                return &(sGP_PDM_Data.asGpTranslationTable[u8Count]);
+            }
+        }
+        return NULL;
+    }
 
+    u32Key = u32App_GPTransKey(u8AppId, uSrcAddr);
     for(u8Count = 0; u8Count < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; u8Count++)
     {
-        /* if ZGPD Src ID is zero then it is free entry */
+        if(((u32GpTransUsed & (1UL << u8Count)) == 0) ||
+           ((u32Key != GP_TRANS_KEY_WILDCARD) &&
+            (au32GpTransKey[u8Count] != GP_TRANS_KEY_WILDCARD) &&
+            (au32GpTransKey[u8Count] != u32Key)))
+        {
+            continue;
+        }
         if(bGP_CheckGPDAddressMatch(
                 sGP_PDM_Data.asGpTranslationTable[u8Count].b8Options,
                 u8AppId,
@@ -791,6 +908,7 @@ teGP_GreenPowerStatus eApp_UpdateTranslationTable(tsGP_ZgpsTranslationTableUpdat
                     &psUpdateCmd->psTranslationUpdateEntry->au8ZbCmdPayload[0],
                     psTranslationTableEntry->psGpToZclCmdInfo->u8ZbCmdLength);
 
+            vApp_GPTransIndexUpdate(psTranslationTableEntry - sGP_PDM_Data.asGpTranslationTable);
             eStatus =E_GP_TRANSLATION_UPDATE_SUCCESS;
 
         }
@@ -801,6 +919,7 @@ teGP_GreenPowerStatus eApp_UpdateTranslationTable(tsGP_ZgpsTranslationTableUpdat
             psTranslationTableEntry =
                 &sGP_PDM_Data.asGpTranslationTable[psUpdateCmd->psTranslationUpdateEntry->u8Index];
             memset(psTranslationTableEntry,0,sizeof(tsGP_TranslationTableEntry));
+            vApp_GPTransIndexUpdate(psUpdateCmd->psTranslationUpdateEntry->u8Index);
             eStatus = E_GP_TRANSLATION_UPDATE_SUCCESS;
             sGP_PDM_Data.u32RestoreGPPDMInfo &= ~(1 << (psUpdateCmd->psTranslationUpdateEntry->u8Index + PDM_TRANS_POINTER_INFO_INDEX ));
         }
@@ -825,8 +944,6 @@ teGP_GreenPowerStatus eApp_UpdateTranslationTable(tsGP_ZgpsTranslationTableUpdat
 void vApp_UpdateTranslationTableOnPairingCfg(tsGP_ZgpsPairingConfigCmdRcvd *psPairingConfigCmdRcvd)
 {
 
-    tsGP_TranslationTableEntry *psTranslationTableEntry = NULL;
-    bool u8Count;
     uint8 i = 0, j=0;
     bool bAddTranslationTable = FALSE;
 
@@ -892,19 +1009,8 @@ void vApp_UpdateTranslationTableOnPairingCfg(tsGP_ZgpsPairingConfigCmdRcvd *psPa
     case E_GP_PAIRING_CONFIG_TRANSLATION_TABLE_REMOVE_ENTRY:
 
         DBG_vPrintf(TRACE_APP_GP, "E_GP_PAIRING_CONFIG_REMOVE_SINK_TABLE_ENTRY  \n");
-        for(u8Count = 0; u8Count < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; u8Count++)
-        {
-            uint8 u8TranslationTableIndex;
-            psTranslationTableEntry = psApp_GPGetTranslationTable(
-                    psPairingConfigCmdRcvd->u8ApplicationId,
-                    &u8TranslationTableIndex,
-                    &psPairingConfigCmdRcvd->uZgpdDeviceAddr);
-            if(NULL != psTranslationTableEntry)
-            {
-                memset(psTranslationTableEntry,0,sizeof(tsGP_TranslationTableEntry));
-                sGP_PDM_Data.u32RestoreGPPDMInfo &= ~(1 << (u8TranslationTableIndex + PDM_TRANS_POINTER_INFO_INDEX ));
-            }
-        }
+        u8App_GPClearTranslationEntries(psPairingConfigCmdRcvd->u8ApplicationId,
+                &psPairingConfigCmdRcvd->uZgpdDeviceAddr);
         break;
     default:
         DBG_vPrintf(TRACE_APP_GP, "vApp_UpdateTranslationTableOnPairingCfg default   \n");
@@ -948,9 +1054,294 @@ void vInitTranslationTablePointers(void)
             }
         }
     }
+    /* Pointers are rebuilt, not restored: don't count them as changes */
+    vApp_GPTransIndexRebuild();
+    for(u8Count = 0; u8Count < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; u8Count++)
+    {
+        au32GpTransPersisted[u8Count] = u32App_GPHash(&sGP_PDM_Data.asGpTranslationTable[u8Count],
+                                                      sizeof(tsGP_TranslationTableEntry));
+    }
+
+}
+
+/****************************************************************************
+ *
+ * NAME: u32App_GPTransKey
+ *
+ * DESCRIPTION:
+ * Index key of a GPD address: hash of the application id and the source id
+ * or IEEE address. Wildcard addresses get GP_TRANS_KEY_WILDCARD and are
+ * always checked with the full address match.
+ *
+ ****************************************************************************/
+PRIVATE uint32 u32App_GPTransKey(
+        uint8                u8AppId,
+        tuGP_ZgpdDeviceAddr *puAddr)
+{
+    uint32 u32Key;
+
+    u8AppId &= GP_TRANS_APP_ID_MASK;
+    if(u8AppId == GP_TRANS_APP_ID_SRC_ID)
+    {
+        if(puAddr->u32ZgpdSrcId == 0xFFFFFFFF)
+        {
+            return GP_TRANS_KEY_WILDCARD;
+        }
+        u32Key = u32App_GPHash(&puAddr->u32ZgpdSrcId, sizeof(uint32));
+    }
+    else
+    {
+        if(puAddr->sZgpdDeviceAddrAppId2.u64ZgpdIEEEAddr == 0xFFFFFFFFFFFFFFFFULL)
+        {
+            return GP_TRANS_KEY_WILDCARD;
+        }
+        u32Key = u32App_GPHash(&puAddr->sZgpdDeviceAddrAppId2.u64ZgpdIEEEAddr, sizeof(uint64));
+    }
+    u32Key ^= u8AppId;
+
+    return (u32Key == GP_TRANS_KEY_WILDCARD) ? 1 : u32Key;
+}
+
+/****************************************************************************
+ *
+ * NAME: vApp_GPTransIndexUpdate
+ *
+ * DESCRIPTION:
+ * Refreshes the index after a translation table entry has been written
+ *
+ ****************************************************************************/
+PRIVATE void vApp_GPTransIndexUpdate(uint8 u8Index)
+{
+    tsGP_TranslationTableEntry *psEntry;
+    tuGP_ZgpdDeviceAddr uDummydeviceAddr = { 0 };
+
+    if(u8Index >= GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES)
+    {
+        return;
+    }
+    psEntry = &sGP_PDM_Data.asGpTranslationTable[u8Index];
 
+    if(0 == memcmp(&psEntry->uZgpdDeviceAddr, &uDummydeviceAddr, sizeof(tuGP_ZgpdDeviceAddr)))
+    {
+        u32GpTransUsed &= ~(1UL << u8Index);
+        au32GpTransKey[u8Index] = GP_TRANS_KEY_WILDCARD;
+    }
+    else
+    {
+        u32GpTransUsed |= (1UL << u8Index);
+        au32GpTransKey[u8Index] = u32App_GPTransKey(psEntry->b8Options, &psEntry->uZgpdDeviceAddr);
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: vApp_GPTransIndexRebuild
+ *
+ * DESCRIPTION:
+ * Rebuilds the whole translation table index (restore from PDM, reset)
+ *
+ ****************************************************************************/
+PRIVATE void vApp_GPTransIndexRebuild(void)
+{
+    uint8 u8Count;
+
+    u32GpTransUsed = 0;
+    for(u8Count = 0; u8Count < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; u8Count++)
+    {
+        vApp_GPTransIndexUpdate(u8Count);
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: u8App_GPClearTranslationEntries
+ *
+ * DESCRIPTION:
+ * Clears every translation table entry of a GPD in one pass
+ *
+ * RETURNS:
+ * Number of entries cleared
+ *
+ ****************************************************************************/
+PRIVATE uint8 u8App_GPClearTranslationEntries(
+        uint8                u8AppId,
+        tuGP_ZgpdDeviceAddr *puAddr)
+{
+    tsGP_TranslationTableEntry *psEntry;
+    uint8 u8Index;
+    uint8 u8Cleared = 0;
+
+    while((psEntry = psApp_GPGetTranslationTable(u8AppId, &u8Index, puAddr)) != NULL)
+    {
+        memset(psEntry, 0, sizeof(tsGP_TranslationTableEntry));
+        vApp_GPTransIndexUpdate(u8Index);
+        sGP_PDM_Data.u32RestoreGPPDMInfo &= ~(1 << (u8Index + PDM_TRANS_POINTER_INFO_INDEX ));
+        u8Cleared++;
+    }
+    DBG_vPrintf(TRACE_APP_GP, "cleared %d translation table entries\n", u8Cleared);
+
+    return u8Cleared;
 }
 #endif
+
+/****************************************************************************
+ *
+ * NAME: u32App_GPHash
+ *
+ * DESCRIPTION:
+ * FNV-1a hash of a block of bytes
+ *
+ ****************************************************************************/
+PRIVATE uint32 u32App_GPHash(void *pvData, uint16 u16Length)
+{
+    uint8 *pu8Data = (uint8 *)pvData;
+    uint32 u32Hash = GP_PDM_HASH_OFFSET;
+
+    while(u16Length--)
+    {
+        u32Hash ^= *pu8Data++;
+        u32Hash *= GP_PDM_HASH_PRIME;
+    }
+    return u32Hash;
+}
+
+/****************************************************************************
+ *
+ * NAME: vApp_GPMarkPersisted
+ *
+ * DESCRIPTION:
+ * Records the current tables as the PDM contents
+ *
+ ****************************************************************************/
+PRIVATE void vApp_GPMarkPersisted(void)
+{
+    uint8 i;
+
+    u32GpRestoreInfoPersisted = u32App_GPHash(&sGP_PDM_Data.u32RestoreGPPDMInfo, sizeof(uint32));
+#ifdef GP_COMBO_BASIC_DEVICE
+    u32GpCmdInfoPersisted = u32App_GPHash(sGP_PDM_Data.asGpToZclCmdInfoUpdate,
+                                          sizeof(sGP_PDM_Data.asGpToZclCmdInfoUpdate));
+    for(i = 0; i < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; i++)
+    {
+        au32GpTransPersisted[i] = u32App_GPHash(&sGP_PDM_Data.asGpTranslationTable[i],
+                                                sizeof(tsGP_TranslationTableEntry));
+    }
+#endif
+    for(i = 0; i < GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES; i++)
+    {
+        au32GpSinkPersisted[i] = u32App_GPHash(&sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[i],
+                                               sizeof(tsGP_ZgppProxySinkTable));
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: u16App_GPSaveDirtyRecords
+ *
+ * DESCRIPTION:
+ * Writes to PDM only the records that changed since they were last written;
+ * entries that became free have their record deleted
+ *
+ * RETURNS:
+ * Number of bytes written
+ *
+ ****************************************************************************/
+PRIVATE uint16 u16App_GPSaveDirtyRecords(bool_t bForce)
+{
+    tsGP_ZgppProxySinkTable *psSinkEntry;
+    uint32 u32SinkDirty = 0;
+    uint32 u32Hash;
+    uint16 u16Written = 0;
+    uint8 i;
+
+    u32Hash = u32App_GPHash(&sGP_PDM_Data.u32RestoreGPPDMInfo, sizeof(uint32));
+    if(bForce || (u32Hash != u32GpRestoreInfoPersisted))
+    {
+        PDM_eSaveRecordData(PDM_ID_APP_CLD_GP_RESTORE_INFO,
+                            &sGP_PDM_Data.u32RestoreGPPDMInfo,
+                            sizeof(uint32));
+        u32GpRestoreInfoPersisted = u32Hash;
+        u16Written += sizeof(uint32);
+    }
+
+#ifdef GP_COMBO_BASIC_DEVICE
+    {
+        uint32 u32TransDirty = 0;
+
+        u32Hash = u32App_GPHash(sGP_PDM_Data.asGpToZclCmdInfoUpdate,
+                                sizeof(sGP_PDM_Data.asGpToZclCmdInfoUpdate));
+        if(bForce || (u32Hash != u32GpCmdInfoPersisted))
+        {
+            PDM_eSaveRecordData(PDM_ID_APP_CLD_GP_CMD_INFO_UPDATE,
+                                sGP_PDM_Data.asGpToZclCmdInfoUpdate,
+                                sizeof(sGP_PDM_Data.asGpToZclCmdInfoUpdate));
+            u32GpCmdInfoPersisted = u32Hash;
+            u16Written += sizeof(sGP_PDM_Data.asGpToZclCmdInfoUpdate);
+        }
+
+        for(i = 0; i < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; i++)
+        {
+            u32Hash = u32App_GPHash(&sGP_PDM_Data.asGpTranslationTable[i], sizeof(tsGP_TranslationTableEntry));
+            if(bForce || (u32Hash != au32GpTransPersisted[i]))
+            {
+                u32TransDirty |= (1UL << i);
+                au32GpTransPersisted[i] = u32Hash;
+            }
+        }
+        for(i = 0; i < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; i++)
+        {
+            if((u32TransDirty & (1UL << i)) == 0)
+            {
+                continue;
+            }
+            if(u32GpTransUsed & (1UL << i))
+            {
+                PDM_eSaveRecordData(PDM_ID_APP_CLD_GP_TRANS_ENTRY + i,
+                                    &sGP_PDM_Data.asGpTranslationTable[i],
+                                    sizeof(tsGP_TranslationTableEntry));
+                u16Written += sizeof(tsGP_TranslationTableEntry);
+            }
+            else
+            {
+                PDM_vDeleteDataRecord(PDM_ID_APP_CLD_GP_TRANS_ENTRY + i);
+            }
+        }
+    }
+#endif
+
+    for(i = 0; i < GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES; i++)
+    {
+        u32Hash = u32App_GPHash(&sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[i],
+                                sizeof(tsGP_ZgppProxySinkTable));
+        if(bForce || (u32Hash != au32GpSinkPersisted[i]))
+        {
+            u32SinkDirty |= (1UL << i);
+            au32GpSinkPersisted[i] = u32Hash;
+        }
+    }
+    for(i = 0; i < GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES; i++)
+    {
+        if((u32SinkDirty & (1UL << i)) == 0)
+        {
+            continue;
+        }
+        psSinkEntry = &sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[i];
+        if(psSinkEntry->bProxyTableEntryOccupied)
+        {
+            PDM_eSaveRecordData(PDM_ID_APP_CLD_GP_SINK_PROXY_ENTRY + i,
+                                psSinkEntry,
+                                sizeof(tsGP_ZgppProxySinkTable));
+            u16Written += sizeof(tsGP_ZgppProxySinkTable);
+        }
+        else
+        {
+            PDM_vDeleteDataRecord(PDM_ID_APP_CLD_GP_SINK_PROXY_ENTRY + i);
+        }
+    }
+
+    DBG_vPrintf(TRACE_APP_GP, "GP PDM: sink dirty 0x%x, %d bytes written\n", u32SinkDirty, u16Written);
+    return u16Written;
+}
 #endif /*  CLD_GREENPOWER */
 /****************************************************************************/
 /***        END OF FILE                                                   ***/
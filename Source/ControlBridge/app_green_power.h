@@ -48,6 +48,7 @@
 void vApp_GP_RegisterDevice(tfpZCL_ZCLCallBackFunction fptrEPCallBack);
 void vApp_GP_EnterCommissioningMode(void);
 void vAPP_GP_LoadPDMData(void);
+void vAPP_GP_LoadDeferredPDMData(void);
 void vHandleGreenPowerEvent(tsGP_GreenPowerCallBackMessage *psGPMessage);
 void vAPP_GP_ResetData(void);
 /****************************************************************************/
@@ -0,0 +1,1063 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_ota_fleet.c
+ *
+ * DESCRIPTION:        OTA image distribution to many clients from one host
+ *                     copy (Implementation)
+ *
+ *                     Image blocks held by the host are fetched once and
+ *                     kept in a small cache. Clients asking for a block
+ *                     already cached are answered locally, clients asking
+ *                     for a block the host is already fetching wait for
+ *                     that fetch instead of causing another one. Page
+ *                     requests are streamed from the same cache, paced
+ *                     across all clients by the 100ms tick.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zcl.h"
+#include "OTA.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_ota_fleet.h"
+#ifdef OTA_STORE
+#include "app_ota_store.h"
+#endif
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_OTA_FLEET
+#define TRACE_OTA_FLEET                 TRUE
+#else
+#define TRACE_OTA_FLEET                 FALSE
+#endif
+
+/* Host fetches a page client may lose before its page is abandoned, the
+ * client then sends a new page request */
+#define OTA_FLEET_PAGE_RETRIES          3
+
+#define OTA_FLEET_CLIENT_IN_USE         0x80
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint32    u32FileVersion;
+    uint16    u16ImageType;
+    uint16    u16ManufacturerCode;
+} tsOtaFleetImage;
+
+typedef struct
+{
+    tsOtaFleetImage    sImage;
+    uint32             u32Offset;
+    uint32             u32LastUsed;
+    uint8              u8Size;
+    uint8              au8Data[OTA_MAX_BLOCK_SIZE];
+} tsOtaFleetBlock;
+
+typedef struct
+{
+    tsOtaFleetImage    sImage;
+    uint32             u32Offset;
+    uint32             u32Issued;
+    uint8              u8Size;
+} tsOtaFleetFetch;
+
+typedef struct
+{
+    uint64             u64IeeeAddress;
+    tsOtaFleetImage    sImage;
+    uint32             u32Offset;
+    uint32             u32PageEnd;
+    uint32             u32Blocks;
+    uint32             u32LastActive;
+    uint16             u16Address;
+    uint8              u8LocalEndpoint;
+    uint8              u8Endpoint;
+    uint8              u8Tsn;
+    uint8              u8MaxDataSize;
+    uint8              u8FieldControl;
+    uint8              u8SpacingTicks;
+    uint8              u8TicksToNext;
+    uint8              u8Retries;
+    uint8              u8State;
+} tsOtaFleetClient;
+
+typedef struct
+{
+    uint32    u32BlockRequests;
+    uint32    u32BlocksServed;
+    uint32    u32CacheHits;
+    uint32    u32Coalesced;
+    uint32    u32HostFetches;
+    uint32    u32HostBytes;
+    uint32    u32AirBytes;
+    uint16    u16PageRequests;
+} tsOtaFleetStats;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE bool_t APP_bOtaFleetSameImage ( tsOtaFleetImage*    psA,
+                                        tsOtaFleetImage*    psB );
+PRIVATE tsOtaFleetClient* APP_psOtaFleetClient ( uint16    u16Address,
+                                                 bool_t    bCreate );
+PRIVATE tsOtaFleetBlock* APP_psOtaFleetFindBlock ( tsOtaFleetImage*    psImage,
+                                                   uint32              u32Offset );
+PRIVATE tsOtaFleetFetch* APP_psOtaFleetFindFetch ( tsOtaFleetImage*    psImage,
+                                                   uint32              u32Offset );
+PRIVATE void APP_vOtaFleetTrackFetch ( tsOtaFleetClient*    psClient );
+PRIVATE void APP_vOtaFleetRequestFromHost ( tsOtaFleetClient*    psClient );
+PRIVATE uint8 APP_u8OtaFleetRequestSize ( tsOtaFleetClient*    psClient );
+PRIVATE bool_t APP_bOtaFleetServe ( tsOtaFleetClient*    psClient,
+                                    tsOtaFleetBlock*     psBlock );
+PRIVATE void APP_vOtaFleetAdvance ( tsOtaFleetClient*    psClient,
+                                    uint8                u8Size );
+PRIVATE bool_t APP_bOtaFleetServeWaiting ( void );
+#ifdef OTA_STORE
+PRIVATE bool_t APP_bOtaFleetServeFromStore ( tsOtaFleetClient*    psClient );
+#endif
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsOtaFleetClient    asOtaFleetClient[OTA_FLEET_MAX_CLIENTS];
+PRIVATE tsOtaFleetBlock     asOtaFleetBlock[OTA_FLEET_CACHE_BLOCKS];
+PRIVATE tsOtaFleetFetch     asOtaFleetFetch[OTA_FLEET_MAX_FETCHES];
+PRIVATE tsOtaFleetStats     sOtaFleetStats;
+PRIVATE uint32              u32OtaFleetTick;
+PRIVATE uint32              u32OtaFleetUse;
+PRIVATE uint8               u8OtaFleetPageNext;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaFleetReset
+ *
+ * DESCRIPTION:
+ * Forgets cached blocks, outstanding fetches and client progress, called
+ * when the host loads a new image
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vOtaFleetReset ( void )
+{
+    memset ( asOtaFleetClient, 0, sizeof ( asOtaFleetClient ) );
+    memset ( asOtaFleetBlock,  0, sizeof ( asOtaFleetBlock ) );
+    memset ( asOtaFleetFetch,  0, sizeof ( asOtaFleetFetch ) );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaFleetTick
+ *
+ * DESCRIPTION:
+ * 100ms tick: drops host fetches left unanswered, serves the clients still
+ * waiting for a cached block and sends the next page blocks, at most
+ * OTA_FLEET_PAGE_BLOCKS_PER_TICK and round robin so that every paging
+ * client progresses
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vOtaFleetTick ( void )
+{
+    tsOtaFleetClient*    psClient;
+    tsOtaFleetBlock*     psBlock;
+    uint8                u8Budget =  OTA_FLEET_PAGE_BLOCKS_PER_TICK;
+    uint8                u8Start;
+    uint8                i;
+
+    u32OtaFleetTick++;
+
+    for ( i = 0; i < OTA_FLEET_MAX_FETCHES; i++ )
+    {
+        if ( ( asOtaFleetFetch[i].u8Size != 0 ) &&
+             ( ( u32OtaFleetTick - asOtaFleetFetch[i].u32Issued ) > OTA_FLEET_FETCH_TIMEOUT_TICKS ) )
+        {
+            asOtaFleetFetch[i].u8Size =  0;
+        }
+    }
+
+    while ( APP_bOtaFleetServeWaiting ( ) )
+    {
+    }
+
+    u8Start =  u8OtaFleetPageNext;
+    u8OtaFleetPageNext =  ( u8OtaFleetPageNext + 1 ) % OTA_FLEET_MAX_CLIENTS;
+    for ( i = 0; i < OTA_FLEET_MAX_CLIENTS; i++ )
+    {
+        psClient =  &asOtaFleetClient[( u8Start + i ) % OTA_FLEET_MAX_CLIENTS];
+
+        if ( ( psClient->u8State & OTA_FLEET_CLIENT_WAITING ) &&
+             ( ( u32OtaFleetTick - psClient->u32LastActive ) > OTA_FLEET_FETCH_TIMEOUT_TICKS ) )
+        {
+            /* The fetch it was waiting for is lost, block clients retry by themselves */
+            psClient->u8State &=  ~OTA_FLEET_CLIENT_WAITING;
+            if ( ( psClient->u8State & OTA_FLEET_CLIENT_PAGE ) &&
+                 ( ++psClient->u8Retries > OTA_FLEET_PAGE_RETRIES ) )
+            {
+                psClient->u8State &=  ~OTA_FLEET_CLIENT_PAGE;
+            }
+        }
+
+        if ( ( psClient->u8State & ( OTA_FLEET_CLIENT_PAGE | OTA_FLEET_CLIENT_WAITING ) ) != OTA_FLEET_CLIENT_PAGE )
+        {
+            continue;
+        }
+        if ( psClient->u8TicksToNext > 0 )
+        {
+            psClient->u8TicksToNext--;
+            continue;
+        }
+        if ( u8Budget == 0 )
+        {
+            continue;
+        }
+        u8Budget--;
+
+        psBlock =  APP_psOtaFleetFindBlock ( &psClient->sImage, psClient->u32Offset );
+        if ( psBlock != NULL )
+        {
+            if ( APP_bOtaFleetServe ( psClient, psBlock ) )
+            {
+                sOtaFleetStats.u32CacheHits++;
+            }
+        }
+#ifdef OTA_STORE
+        else if ( APP_bOtaFleetServeFromStore ( psClient ) )
+        {
+            continue;
+        }
+#endif
+        else if ( APP_psOtaFleetFindFetch ( &psClient->sImage, psClient->u32Offset ) != NULL )
+        {
+            psClient->u8State       |=  OTA_FLEET_CLIENT_WAITING;
+            psClient->u32LastActive  =  u32OtaFleetTick;
+            sOtaFleetStats.u32Coalesced++;
+        }
+        else
+        {
+            APP_vOtaFleetRequestFromHost ( psClient );
+        }
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bOtaFleetBlockRequest
+ *
+ * DESCRIPTION:
+ * Handles an image block request from a client, answering it from the
+ * cache or attaching it to a host fetch already outstanding for the block
+ *
+ * RETURNS:
+ * TRUE when handled here, FALSE when it must be forwarded to the host
+ *
+ ****************************************************************************/
+PUBLIC bool_t APP_bOtaFleetBlockRequest ( tsZCL_CallBackEvent*      psEvent,
+                                          tsOTA_CallBackMessage*    psCallBackMessage )
+{
+    tsOTA_BlockRequest*    psRequest =  &psCallBackMessage->uMessage.sBlockRequestPayload;
+    tsOtaFleetClient*      psClient;
+    tsOtaFleetBlock*       psBlock;
+
+    if ( ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8SrcAddrMode != ZPS_E_ADDR_MODE_SHORT ) ||
+         ( psRequest->u8MaxDataSize == 0 ) )
+    {
+        return FALSE;
+    }
+    psClient =  APP_psOtaFleetClient ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr, TRUE );
+    if ( psClient == NULL )
+    {
+        return FALSE;
+    }
+
+    psClient->sImage.u32FileVersion         =  psRequest->u32FileVersion;
+    psClient->sImage.u16ImageType           =  psRequest->u16ImageType;
+    psClient->sImage.u16ManufacturerCode    =  psRequest->u16ManufactureCode;
+    psClient->u64IeeeAddress                =  psRequest->u64RequestNodeAddress;
+    psClient->u32Offset                     =  psRequest->u32FileOffset;
+    psClient->u32LastActive                 =  u32OtaFleetTick;
+    psClient->u8LocalEndpoint               =  psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8DstEndpoint;
+    psClient->u8Endpoint                    =  psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8SrcEndpoint;
+    psClient->u8Tsn                         =  psEvent->u8TransactionSequenceNumber;
+    psClient->u8MaxDataSize                 =  psRequest->u8MaxDataSize;
+    psClient->u8FieldControl                =  psRequest->u8FieldControl;
+    psClient->u8State                       =  OTA_FLEET_CLIENT_IN_USE;
+    sOtaFleetStats.u32BlockRequests++;
+
+    psBlock =  APP_psOtaFleetFindBlock ( &psClient->sImage, psClient->u32Offset );
+    if ( psBlock != NULL )
+    {
+        if ( !APP_bOtaFleetServe ( psClient, psBlock ) )
+        {
+            /* No room in the stack, the next data confirm serves it */
+            psClient->u8State |=  OTA_FLEET_CLIENT_WAITING;
+        }
+        sOtaFleetStats.u32CacheHits++;
+        return TRUE;
+    }
+    if ( APP_psOtaFleetFindFetch ( &psClient->sImage, psClient->u32Offset ) != NULL )
+    {
+        psClient->u8State |=  OTA_FLEET_CLIENT_WAITING;
+        sOtaFleetStats.u32Coalesced++;
+        return TRUE;
+    }
+
+    /* Waiting as well, in case the host's answer finds no room in the stack */
+    APP_vOtaFleetTrackFetch ( psClient );
+    psClient->u8State |=  OTA_FLEET_CLIENT_WAITING;
+    sOtaFleetStats.u32HostFetches++;
+    return FALSE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaFleetPageRequest
+ *
+ * DESCRIPTION:
+ * Starts streaming a page to a client, the blocks are sent from the tick
+ * at the client's response spacing
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vOtaFleetPageRequest ( tsZCL_CallBackEvent*      psEvent,
+                                       tsOTA_CallBackMessage*    psCallBackMessage )
+{
+    tsOTA_ImagePageRequest*    psPage =  &psCallBackMessage->uMessage.sImagePageRequestPayload;
+    tsOtaFleetClient*          psClient;
+    uint16                     u16Spacing;
+
+    if ( ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8SrcAddrMode != ZPS_E_ADDR_MODE_SHORT ) ||
+         ( psPage->u8MaxDataSize == 0 ) ||
+         ( psPage->u16PageSize == 0 ) )
+    {
+        return;
+    }
+    psClient =  APP_psOtaFleetClient ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr, TRUE );
+    if ( psClient == NULL )
+    {
+        return;
+    }
+
+    u16Spacing =  ( psPage->u16ResponseSpacing > OTA_PAGE_REQ_RESPONSE_SPACING ) ? psPage->u16ResponseSpacing : OTA_PAGE_REQ_RESPONSE_SPACING;
+
+    psClient->sImage.u32FileVersion         =  psPage->u32FileVersion;
+    psClient->sImage.u16ImageType           =  psPage->u16ImageType;
+    psClient->sImage.u16ManufacturerCode    =  psPage->u16ManufactureCode;
+    psClient->u64IeeeAddress                =  psPage->u64RequestNodeAddress;
+    psClient->u32Offset                     =  psPage->u32FileOffset;
+    psClient->u32PageEnd                    =  psPage->u32FileOffset + psPage->u16PageSize;
+    psClient->u32LastActive                 =  u32OtaFleetTick;
+    psClient->u8LocalEndpoint               =  psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8DstEndpoint;
+    psClient->u8Endpoint                    =  psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8SrcEndpoint;
+    psClient->u8Tsn                         =  psEvent->u8TransactionSequenceNumber;
+    psClient->u8MaxDataSize                 =  psPage->u8MaxDataSize;
+    psClient->u8FieldControl                =  psPage->u8FieldControl;
+    psClient->u8SpacingTicks                =  ( uint8 ) ( ( u16Spacing + 99 ) / 100 );
+    psClient->u8TicksToNext                 =  0;
+    psClient->u8Retries                     =  0;
+    psClient->u8State                       =  OTA_FLEET_CLIENT_IN_USE | OTA_FLEET_CLIENT_PAGE;
+    sOtaFleetStats.u16PageRequests++;
+
+    vLog_Printf ( TRACE_OTA_FLEET, LOG_DEBUG, "\nOTA fleet page %04x %08x+%d every %d ticks",
+                  psClient->u16Address, psPage->u32FileOffset, psPage->u16PageSize, psClient->u8SpacingTicks );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaFleetBlockReceived
+ *
+ * DESCRIPTION:
+ * Called with a block the host sent for u16Address, bSent when it was
+ * passed on: keeps it in the cache, records the client's progress and
+ * answers the clients waiting for it. A block the stack had no room for
+ * is still shared, the waiting page client among the others.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vOtaFleetBlockReceived ( uint16                              u16Address,
+                                         tsOTA_ImageBlockResponsePayload*    psPayload,
+                                         uint16                              u16FrameLength,
+                                         bool_t                              bSent )
+{
+    tsOtaFleetImage       sImage;
+    tsOtaFleetClient*     psClient;
+    tsOtaFleetBlock*      psBlock =  NULL;
+    uint32                u32Offset =  psPayload->uMessage.sBlockPayloadSuccess.u32FileOffset;
+    uint8                 u8Size    =  psPayload->uMessage.sBlockPayloadSuccess.u8DataSize;
+    uint8                 u8Requested;
+    uint8                 i;
+
+    if ( ( psPayload->u8Status != OTA_STATUS_SUCCESS ) ||
+         ( u8Size == 0 ) ||
+         ( u8Size > OTA_MAX_BLOCK_SIZE ) )
+    {
+        return;
+    }
+    sOtaFleetStats.u32HostBytes +=  u16FrameLength;
+
+    sImage.u32FileVersion         =  psPayload->uMessage.sBlockPayloadSuccess.u32FileVersion;
+    sImage.u16ImageType           =  psPayload->uMessage.sBlockPayloadSuccess.u16ImageType;
+    sImage.u16ManufacturerCode    =  psPayload->uMessage.sBlockPayloadSuccess.u16ManufacturerCode;
+
+    /* Blocks waiting clients have yet to be sent are kept over any other */
+    for ( i = 0; i < OTA_FLEET_MAX_CLIENTS; i++ )
+    {
+        if ( asOtaFleetClient[i].u8State & OTA_FLEET_CLIENT_WAITING )
+        {
+            psBlock =  APP_psOtaFleetFindBlock ( &asOtaFleetClient[i].sImage, asOtaFleetClient[i].u32Offset );
+            if ( psBlock != NULL )
+            {
+                psBlock->u32LastUsed =  ++u32OtaFleetUse;
+            }
+        }
+    }
+
+    /* Same block again, free slot, or the least recently used one */
+    psBlock =  NULL;
+    for ( i = 0; i < OTA_FLEET_CACHE_BLOCKS; i++ )
+    {
+        if ( ( asOtaFleetBlock[i].u8Size != 0 ) &&
+             ( asOtaFleetBlock[i].u32Offset == u32Offset ) &&
+             APP_bOtaFleetSameImage ( &asOtaFleetBlock[i].sImage, &sImage ) )
+        {
+            psBlock =  &asOtaFleetBlock[i];
+            break;
+        }
+        if ( ( psBlock == NULL ) ||
+             ( ( psBlock->u8Size != 0 ) &&
+               ( ( asOtaFleetBlock[i].u8Size == 0 ) || ( asOtaFleetBlock[i].u32LastUsed < psBlock->u32LastUsed ) ) ) )
+        {
+            psBlock =  &asOtaFleetBlock[i];
+        }
+    }
+    if ( ( psBlock->u8Size == 0 ) || ( psBlock->u32Offset != u32Offset ) || ( u8Size >= psBlock->u8Size ) )
+    {
+        psBlock->sImage         =  sImage;
+        psBlock->u32Offset      =  u32Offset;
+        psBlock->u8Size         =  u8Size;
+        memcpy ( psBlock->au8Data, psPayload->uMessage.sBlockPayloadSuccess.pu8Data, u8Size );
+    }
+    psBlock->u32LastUsed =  ++u32OtaFleetUse;
+
+    for ( i = 0; i < OTA_FLEET_MAX_FETCHES; i++ )
+    {
+        if ( ( asOtaFleetFetch[i].u8Size != 0 ) &&
+             ( asOtaFleetFetch[i].u32Offset >= u32Offset ) &&
+             ( asOtaFleetFetch[i].u32Offset < ( u32Offset + u8Size ) ) &&
+             APP_bOtaFleetSameImage ( &asOtaFleetFetch[i].sImage, &sImage ) )
+        {
+            asOtaFleetFetch[i].u8Size =  0;
+        }
+    }
+
+    psClient =  APP_psOtaFleetClient ( u16Address, FALSE );
+    if ( bSent &&
+         ( psClient != NULL ) &&
+         ( psClient->u32Offset == u32Offset ) &&
+         APP_bOtaFleetSameImage ( &psClient->sImage, &sImage ) )
+    {
+        u8Requested =  APP_u8OtaFleetRequestSize ( psClient );
+        APP_vOtaFleetAdvance ( psClient, u8Size );
+        if ( u8Size < u8Requested )
+        {
+            /* Short block: the image ends here */
+            psClient->u8State &=  ~OTA_FLEET_CLIENT_PAGE;
+        }
+    }
+
+    for ( i = 0; i < OTA_FLEET_MAX_CLIENTS; i++ )
+    {
+        psClient =  &asOtaFleetClient[i];
+        if ( ( psClient->u8State & OTA_FLEET_CLIENT_WAITING ) &&
+             ( psClient->u32Offset >= u32Offset ) &&
+             ( psClient->u32Offset < ( u32Offset + u8Size ) ) &&
+             APP_bOtaFleetSameImage ( &psClient->sImage, &sImage ) )
+        {
+            APP_bOtaFleetServe ( psClient, psBlock );
+        }
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaFleetUpgradeEnd
+ *
+ * DESCRIPTION:
+ * Records the outcome of a client's download
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vOtaFleetUpgradeEnd ( uint16    u16Address,
+                                      uint8     u8Status )
+{
+    tsOtaFleetClient*    psClient =  APP_psOtaFleetClient ( u16Address, FALSE );
+
+    if ( psClient != NULL )
+    {
+        psClient->u8State =  OTA_FLEET_CLIENT_IN_USE |
+                             ( ( u8Status == OTA_STATUS_SUCCESS ) ? OTA_FLEET_CLIENT_COMPLETE : OTA_FLEET_CLIENT_FAILED );
+        psClient->u32LastActive =  u32OtaFleetTick;
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaFleetDataConfirm
+ *
+ * DESCRIPTION:
+ * Called on an APS data confirm: the stack has room for another frame, so
+ * a client left waiting for want of it gets its block
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vOtaFleetDataConfirm ( void )
+{
+    APP_bOtaFleetServeWaiting ( );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaFleetSendStats
+ *
+ * DESCRIPTION:
+ * Sends E_SL_MSG_OTA_FLEET_STATS frames. The summary carries version,
+ * clients tracked, completed and paging, page requests, then block
+ * requests, blocks served, cache hits, coalesced requests, host fetches,
+ * bytes received from the host and block bytes sent. Client frames carry
+ * first index, count, then address, state, next offset and blocks per
+ * client. OTA_FLEET_OPTION_RESET clears the counters and finished clients
+ * once reported.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vOtaFleetSendStats ( uint8    u8Options )
+{
+    uint8     au8Buffer[3 + OTA_FLEET_CLIENTS_PER_FRAME * 11 + 1];
+    uint16    u16Length   =  0;
+    uint8     u8Clients   =  0;
+    uint8     u8Complete  =  0;
+    uint8     u8Paging    =  0;
+    uint8     u8Reported  =  0;
+    uint8     u8InFrame   =  0;
+    uint8     i;
+
+    for ( i = 0; i < OTA_FLEET_MAX_CLIENTS; i++ )
+    {
+        if ( asOtaFleetClient[i].u8State & OTA_FLEET_CLIENT_IN_USE )
+        {
+            u8Clients++;
+            u8Complete +=  ( asOtaFleetClient[i].u8State & OTA_FLEET_CLIENT_COMPLETE ) ? 1 : 0;
+            u8Paging   +=  ( asOtaFleetClient[i].u8State & OTA_FLEET_CLIENT_PAGE ) ? 1 : 0;
+        }
+    }
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], OTA_FLEET_SECTION_SUMMARY,          u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], OTA_FLEET_VERSION,                  u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Clients,                          u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Complete,                         u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Paging,                           u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], sOtaFleetStats.u16PageRequests,     u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaFleetStats.u32BlockRequests,    u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaFleetStats.u32BlocksServed,     u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaFleetStats.u32CacheHits,        u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaFleetStats.u32Coalesced,        u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaFleetStats.u32HostFetches,      u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaFleetStats.u32HostBytes,        u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaFleetStats.u32AirBytes,         u16Length );
+    vSL_WriteMessage ( E_SL_MSG_OTA_FLEET_STATS,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+
+    for ( i = 0; i < OTA_FLEET_MAX_CLIENTS; i++ )
+    {
+        if ( ( asOtaFleetClient[i].u8State & OTA_FLEET_CLIENT_IN_USE ) == 0 )
+        {
+            continue;
+        }
+        if ( u8InFrame == 0 )
+        {
+            u16Length =  0;
+            ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], OTA_FLEET_SECTION_CLIENTS,  u16Length );
+            ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Reported,                 u16Length );
+            ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], 0,                          u16Length );
+        }
+        ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], asOtaFleetClient[i].u16Address,                         u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], asOtaFleetClient[i].u8State & ~OTA_FLEET_CLIENT_IN_USE,  u16Length );
+        ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], asOtaFleetClient[i].u32Offset,                          u16Length );
+        ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], asOtaFleetClient[i].u32Blocks,                          u16Length );
+        u8Reported++;
+        u8InFrame++;
+        au8Buffer[2] =  u8InFrame;
+
+        if ( ( u8InFrame == OTA_FLEET_CLIENTS_PER_FRAME ) || ( u8Reported == u8Clients ) )
+        {
+            vSL_WriteMessage ( E_SL_MSG_OTA_FLEET_STATS,
+                               u16Length,
+                               au8Buffer,
+                               0 );
+            u8InFrame =  0;
+        }
+    }
+
+    if ( u8Options & OTA_FLEET_OPTION_RESET )
+    {
+        memset ( &sOtaFleetStats, 0, sizeof ( sOtaFleetStats ) );
+        for ( i = 0; i < OTA_FLEET_MAX_CLIENTS; i++ )
+        {
+            if ( asOtaFleetClient[i].u8State & ( OTA_FLEET_CLIENT_COMPLETE | OTA_FLEET_CLIENT_FAILED ) )
+            {
+                asOtaFleetClient[i].u8State =  0;
+            }
+        }
+    }
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_bOtaFleetSameImage
+ *
+ * DESCRIPTION:
+ * Compares manufacturer, image type and file version
+ *
+ * RETURNS:
+ * TRUE when both identify the same image
+ *
+ ****************************************************************************/
+PRIVATE bool_t APP_bOtaFleetSameImage ( tsOtaFleetImage*    psA,
+                                        tsOtaFleetImage*    psB )
+{
+    return ( ( psA->u32FileVersion == psB->u32FileVersion ) &&
+             ( psA->u16ImageType == psB->u16ImageType ) &&
+             ( psA->u16ManufacturerCode == psB->u16ManufacturerCode ) );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_psOtaFleetClient
+ *
+ * DESCRIPTION:
+ * Looks a client up by short address, optionally taking a free entry or
+ * else the one idle the longest for a new client
+ *
+ * RETURNS:
+ * Client entry, NULL if unknown and not created
+ *
+ ****************************************************************************/
+PRIVATE tsOtaFleetClient* APP_psOtaFleetClient ( uint16    u16Address,
+                                                 bool_t    bCreate )
+{
+    tsOtaFleetClient*    psFree =  NULL;
+    tsOtaFleetClient*    psClient;
+    uint8                i;
+
+    for ( i = 0; i < OTA_FLEET_MAX_CLIENTS; i++ )
+    {
+        psClient =  &asOtaFleetClient[i];
+        if ( ( psClient->u8State & OTA_FLEET_CLIENT_IN_USE ) == 0 )
+        {
+            if ( ( psFree == NULL ) || ( psFree->u8State & OTA_FLEET_CLIENT_IN_USE ) )
+            {
+                psFree =  psClient;
+            }
+        }
+        else if ( psClient->u16Address == u16Address )
+        {
+            return psClient;
+        }
+        else if ( ( ( psClient->u8State & ( OTA_FLEET_CLIENT_WAITING | OTA_FLEET_CLIENT_PAGE ) ) == 0 ) &&
+                  ( ( psFree == NULL ) ||
+                    ( ( psFree->u8State & OTA_FLEET_CLIENT_IN_USE ) && ( psClient->u32LastActive < psFree->u32LastActive ) ) ) )
+        {
+            psFree =  psClient;
+        }
+    }
+
+    if ( ( !bCreate ) || ( psFree == NULL ) )
+    {
+        return NULL;
+    }
+    memset ( psFree, 0, sizeof ( tsOtaFleetClient ) );
+    psFree->u16Address =  u16Address;
+    psFree->u8State    =  OTA_FLEET_CLIENT_IN_USE;
+    return psFree;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_psOtaFleetFindBlock
+ *
+ * DESCRIPTION:
+ * Finds a cached block holding the byte at u32Offset of the image
+ *
+ * RETURNS:
+ * Cached block, NULL on a miss
+ *
+ ****************************************************************************/
+PRIVATE tsOtaFleetBlock* APP_psOtaFleetFindBlock ( tsOtaFleetImage*    psImage,
+                                                   uint32              u32Offset )
+{
+    uint8    i;
+
+    for ( i = 0; i < OTA_FLEET_CACHE_BLOCKS; i++ )
+    {
+        if ( ( asOtaFleetBlock[i].u8Size != 0 ) &&
+             ( u32Offset >= asOtaFleetBlock[i].u32Offset ) &&
+             ( u32Offset < ( asOtaFleetBlock[i].u32Offset + asOtaFleetBlock[i].u8Size ) ) &&
+             APP_bOtaFleetSameImage ( &asOtaFleetBlock[i].sImage, psImage ) )
+        {
+            return &asOtaFleetBlock[i];
+        }
+    }
+    return NULL;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_psOtaFleetFindFetch
+ *
+ * DESCRIPTION:
+ * Finds an outstanding host fetch whose block will hold u32Offset
+ *
+ * RETURNS:
+ * Fetch entry, NULL if none
+ *
+ ****************************************************************************/
+PRIVATE tsOtaFleetFetch* APP_psOtaFleetFindFetch ( tsOtaFleetImage*    psImage,
+                                                   uint32              u32Offset )
+{
+    uint8    i;
+
+    for ( i = 0; i < OTA_FLEET_MAX_FETCHES; i++ )
+    {
+        if ( ( asOtaFleetFetch[i].u8Size != 0 ) &&
+             ( u32Offset >= asOtaFleetFetch[i].u32Offset ) &&
+             ( u32Offset < ( asOtaFleetFetch[i].u32Offset + asOtaFleetFetch[i].u8Size ) ) &&
+             APP_bOtaFleetSameImage ( &asOtaFleetFetch[i].sImage, psImage ) )
+        {
+            return &asOtaFleetFetch[i];
+        }
+    }
+    return NULL;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaFleetTrackFetch
+ *
+ * DESCRIPTION:
+ * Records that the host was asked for the client's next block so that
+ * other clients needing it wait for the answer. Without a free entry the
+ * fetch simply isn't shared.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vOtaFleetTrackFetch ( tsOtaFleetClient*    psClient )
+{
+    uint8    i;
+
+    for ( i = 0; i < OTA_FLEET_MAX_FETCHES; i++ )
+    {
+        if ( asOtaFleetFetch[i].u8Size == 0 )
+        {
+            asOtaFleetFetch[i].sImage       =  psClient->sImage;
+            asOtaFleetFetch[i].u32Offset    =  psClient->u32Offset;
+            asOtaFleetFetch[i].u32Issued    =  u32OtaFleetTick;
+            asOtaFleetFetch[i].u8Size       =  APP_u8OtaFleetRequestSize ( psClient );
+            return;
+        }
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaFleetRequestFromHost
+ *
+ * DESCRIPTION:
+ * Asks the host for a page client's next block with the same
+ * E_SL_MSG_BLOCK_REQUEST a client block request produces, the host answer
+ * is sent to the client and then shared through APP_vOtaFleetBlockReceived
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vOtaFleetRequestFromHost ( tsOtaFleetClient*    psClient )
+{
+    uint8     au8Buffer[34 + 1];
+    uint16    u16Length =  0;
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], psClient->u8Tsn,                        u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], psClient->u8Endpoint,                   u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], OTA_CLUSTER_ID,                         u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], ZPS_E_ADDR_MODE_SHORT,                  u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], psClient->u16Address,                   u16Length );
+    ZNC_BUF_U64_UPD ( &au8Buffer[ u16Length ], psClient->u64IeeeAddress,               u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], psClient->u32Offset,                    u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], psClient->sImage.u32FileVersion,        u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], psClient->sImage.u16ImageType,          u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], psClient->sImage.u16ManufacturerCode,   u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], 0,                                      u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], APP_u8OtaFleetRequestSize ( psClient ), u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], psClient->u8FieldControl,               u16Length );
+    vSL_WriteMessage ( E_SL_MSG_BLOCK_REQUEST,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+
+    APP_vOtaFleetTrackFetch ( psClient );
+    psClient->u8State       |=  OTA_FLEET_CLIENT_WAITING;
+    psClient->u32LastActive  =  u32OtaFleetTick;
+    sOtaFleetStats.u32HostFetches++;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8OtaFleetRequestSize
+ *
+ * DESCRIPTION:
+ * Size of the client's next block: its maximum data size, bounded by
+ * OTA_MAX_BLOCK_SIZE and by the end of its page
+ *
+ * RETURNS:
+ * Block size
+ *
+ ****************************************************************************/
+PRIVATE uint8 APP_u8OtaFleetRequestSize ( tsOtaFleetClient*    psClient )
+{
+    uint8    u8Size =  ( psClient->u8MaxDataSize < OTA_MAX_BLOCK_SIZE ) ? psClient->u8MaxDataSize : OTA_MAX_BLOCK_SIZE;
+
+    if ( ( psClient->u8State & OTA_FLEET_CLIENT_PAGE ) &&
+         ( ( psClient->u32PageEnd - psClient->u32Offset ) < u8Size ) )
+    {
+        u8Size =  ( uint8 ) ( psClient->u32PageEnd - psClient->u32Offset );
+    }
+    return u8Size;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bOtaFleetServe
+ *
+ * DESCRIPTION:
+ * Sends the client the part of a cached block from its next offset
+ *
+ * RETURNS:
+ * TRUE if the block response was sent
+ *
+ ****************************************************************************/
+PRIVATE bool_t APP_bOtaFleetServe ( tsOtaFleetClient*    psClient,
+                                    tsOtaFleetBlock*     psBlock )
+{
+    tsOTA_ImageBlockResponsePayload    sPayload;
+    tsZCL_Address                      sAddress;
+    uint8                              u8Skip =  ( uint8 ) ( psClient->u32Offset - psBlock->u32Offset );
+    uint8                              u8Size =  APP_u8OtaFleetRequestSize ( psClient );
+
+    if ( u8Size > ( psBlock->u8Size - u8Skip ) )
+    {
+        u8Size =  psBlock->u8Size - u8Skip;
+    }
+
+    sPayload.u8Status                                           =  OTA_STATUS_SUCCESS;
+    sPayload.uMessage.sBlockPayloadSuccess.u32FileOffset        =  psClient->u32Offset;
+    sPayload.uMessage.sBlockPayloadSuccess.u32FileVersion       =  psClient->sImage.u32FileVersion;
+    sPayload.uMessage.sBlockPayloadSuccess.u16ImageType         =  psClient->sImage.u16ImageType;
+    sPayload.uMessage.sBlockPayloadSuccess.u16ManufacturerCode  =  psClient->sImage.u16ManufacturerCode;
+    sPayload.uMessage.sBlockPayloadSuccess.u8DataSize           =  u8Size;
+    sPayload.uMessage.sBlockPayloadSuccess.pu8Data              =  &psBlock->au8Data[u8Skip];
+
+    sAddress.eAddressMode                   =  E_ZCL_AM_SHORT;
+    sAddress.uAddress.u16DestinationAddress =  psClient->u16Address;
+
+    if ( E_ZCL_SUCCESS != eOTA_ServerImageBlockResponse ( psClient->u8LocalEndpoint,
+                                                          psClient->u8Endpoint,
+                                                          &sAddress,
+                                                          &sPayload,
+                                                          u8Size,
+                                                          psClient->u8Tsn ) )
+    {
+        return FALSE;
+    }
+    psBlock->u32LastUsed =  ++u32OtaFleetUse;
+    APP_vOtaFleetAdvance ( psClient, u8Size );
+    return TRUE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaFleetAdvance
+ *
+ * DESCRIPTION:
+ * Accounts a block sent to the client and moves it to its next offset, a
+ * page client gets the next transaction number and its next slot
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vOtaFleetAdvance ( tsOtaFleetClient*    psClient,
+                                    uint8                u8Size )
+{
+    psClient->u32Offset     +=  u8Size;
+    psClient->u32Blocks++;
+    psClient->u32LastActive  =  u32OtaFleetTick;
+    psClient->u8State       &=  ~OTA_FLEET_CLIENT_WAITING;
+    sOtaFleetStats.u32BlocksServed++;
+    sOtaFleetStats.u32AirBytes +=  u8Size;
+
+    if ( psClient->u8State & OTA_FLEET_CLIENT_PAGE )
+    {
+        psClient->u8Tsn++;
+        psClient->u8TicksToNext =  psClient->u8SpacingTicks - 1;
+        psClient->u8Retries     =  0;
+        if ( psClient->u32Offset >= psClient->u32PageEnd )
+        {
+            psClient->u8State &=  ~OTA_FLEET_CLIENT_PAGE;
+        }
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bOtaFleetServeWaiting
+ *
+ * DESCRIPTION:
+ * Serves the first waiting client whose block is already cached: its
+ * response could not be sent when the block came, the stack being out of
+ * APSDE request resources with every other waiting client served at once
+ *
+ * RETURNS:
+ * TRUE if a block response was sent
+ *
+ ****************************************************************************/
+PRIVATE bool_t APP_bOtaFleetServeWaiting ( void )
+{
+    tsOtaFleetClient*    psClient;
+    tsOtaFleetBlock*     psBlock;
+    uint8                i;
+
+    for ( i = 0; i < OTA_FLEET_MAX_CLIENTS; i++ )
+    {
+        psClient =  &asOtaFleetClient[i];
+        if ( ( ( psClient->u8State & OTA_FLEET_CLIENT_WAITING ) == 0 ) ||
+             ( APP_psOtaFleetFindFetch ( &psClient->sImage, psClient->u32Offset ) != NULL ) )
+        {
+            continue;
+        }
+        psBlock =  APP_psOtaFleetFindBlock ( &psClient->sImage, psClient->u32Offset );
+        if ( psBlock != NULL )
+        {
+            return APP_bOtaFleetServe ( psClient, psBlock );
+        }
+    }
+    return FALSE;
+}
+
+#ifdef OTA_STORE
+/****************************************************************************
+ *
+ * NAME: APP_bOtaFleetServeFromStore
+ *
+ * DESCRIPTION:
+ * Sends a page client its next block straight from the image held in
+ * internal flash, a short read ends the page at the end of the image
+ *
+ * RETURNS:
+ * TRUE if the store holds the block, no host fetch is needed
+ *
+ ****************************************************************************/
+PRIVATE bool_t APP_bOtaFleetServeFromStore ( tsOtaFleetClient*    psClient )
+{
+    tsOtaFleetBlock    sBlock;
+    uint8              u8Size =  APP_u8OtaFleetRequestSize ( psClient );
+
+    sBlock.u8Size =  APP_u8OtaStoreRead ( psClient->sImage.u16ManufacturerCode,
+                                          psClient->sImage.u16ImageType,
+                                          psClient->sImage.u32FileVersion,
+                                          psClient->u32Offset,
+                                          u8Size,
+                                          sBlock.au8Data );
+    if ( sBlock.u8Size == 0 )
+    {
+        return FALSE;
+    }
+    sBlock.sImage    =  psClient->sImage;
+    sBlock.u32Offset =  psClient->u32Offset;
+
+    if ( APP_bOtaFleetServe ( psClient, &sBlock ) &&
+         ( sBlock.u8Size < u8Size ) )
+    {
+        psClient->u8State &=  ~OTA_FLEET_CLIENT_PAGE;
+    }
+    return TRUE;
+}
+#endif
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,118 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_ota_fleet.h
+ *
+ * DESCRIPTION:        OTA image distribution to many clients from one host
+ *                     copy (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef APP_OTA_FLEET_H_
+#define APP_OTA_FLEET_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include "zcl.h"
+#include "OTA.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Clients whose download progress is tracked */
+#ifndef OTA_FLEET_MAX_CLIENTS
+#define OTA_FLEET_MAX_CLIENTS               32
+#endif
+
+/* Image blocks kept from the host, OTA_MAX_BLOCK_SIZE bytes each */
+#ifndef OTA_FLEET_CACHE_BLOCKS
+#define OTA_FLEET_CACHE_BLOCKS              16
+#endif
+
+/* Host fetches outstanding at once, further requests go straight through */
+#ifndef OTA_FLEET_MAX_FETCHES
+#define OTA_FLEET_MAX_FETCHES               4
+#endif
+
+/* 100ms ticks before an unanswered host fetch is dropped */
+#define OTA_FLEET_FETCH_TIMEOUT_TICKS       30
+
+/* Page request blocks sent per 100ms tick across all clients */
+#ifndef OTA_FLEET_PAGE_BLOCKS_PER_TICK
+#define OTA_FLEET_PAGE_BLOCKS_PER_TICK      4
+#endif
+
+#define OTA_FLEET_CLIENTS_PER_FRAME         16
+#define OTA_FLEET_VERSION                   1
+
+/* First byte of every E_SL_MSG_OTA_FLEET_STATS frame */
+#define OTA_FLEET_SECTION_SUMMARY           0
+#define OTA_FLEET_SECTION_CLIENTS           1
+
+/* E_SL_MSG_GET_OTA_FLEET_STATS option bits */
+#define OTA_FLEET_OPTION_RESET              0x01
+
+/* Client state bits reported per client */
+#define OTA_FLEET_CLIENT_WAITING            0x01
+#define OTA_FLEET_CLIENT_PAGE               0x02
+#define OTA_FLEET_CLIENT_COMPLETE           0x04
+#define OTA_FLEET_CLIENT_FAILED             0x08
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vOtaFleetReset ( void );
+PUBLIC void APP_vOtaFleetTick ( void );
+PUBLIC bool_t APP_bOtaFleetBlockRequest ( tsZCL_CallBackEvent*      psEvent,
+                                          tsOTA_CallBackMessage*    psCallBackMessage );
+PUBLIC void APP_vOtaFleetPageRequest ( tsZCL_CallBackEvent*      psEvent,
+                                       tsOTA_CallBackMessage*    psCallBackMessage );
+PUBLIC void APP_vOtaFleetBlockReceived ( uint16                              u16Address,
+                                         tsOTA_ImageBlockResponsePayload*    psPayload,
+                                         uint16                              u16FrameLength,
+                                         bool_t                              bSent );
+PUBLIC void APP_vOtaFleetUpgradeEnd ( uint16    u16Address,
+                                      uint8     u8Status );
+PUBLIC void APP_vOtaFleetDataConfirm ( void );
+PUBLIC void APP_vOtaFleetSendStats ( uint8    u8Options );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_OTA_FLEET_H_ */
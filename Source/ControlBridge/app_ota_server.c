@@ -35,6 +35,7 @@
 /***        Include files                                                 ***/
 /****************************************************************************/
 #include <jendefs.h>
+#include <string.h>
 #include "dbg.h"
 #include "PDM.h"
 #include "PDM_IDs.h"
@@ -43,6 +44,12 @@
 #include "app_ota_server.h"
 #include "app_common.h"
 #include "zps_gen.h"
+#include "zps_apl_af.h"
+#include "zps_apl_zdo.h"
+#include "SerialLink.h"
+#ifdef OTA_STORE
+#include "app_ota_store.h"
+#endif
 
 /****************************************************************************/
 /***        Macro Definitions                                             ***/
@@ -68,6 +75,13 @@
 /****************************************************************************/
 /***        Type Definitions                                              ***/
 /****************************************************************************/
+typedef struct
+{
+    uint32    u32Sized;
+    uint32    u32Reduced;
+    uint8     u8Smallest;
+    uint8     u8Largest;
+} tsOtaBlockSizeStats;
 
 /****************************************************************************/
 /***        Local Function Prototypes                                     ***/
@@ -94,7 +108,9 @@ PUBLIC    uint8    s_au8LnkKeyArray[16] __attribute__ ((section (".ro_se_lnkKey"
     0x6c, 0x69, 0x61, 0x6e, 0x63, 0x65, 0x30, 0x39
 };
 
-volatile PRIVATE uint8    au8MacAddressVolatile [ 8 ];
+PRIVATE volatile uint8    au8MacAddressVolatile [ 8 ];
+
+PRIVATE tsOtaBlockSizeStats    sOtaBlockSizeStats;
 
 /****************************************************************************/
 /***        Exported Functions                                            ***/
@@ -156,6 +172,119 @@ PUBLIC void vAppInitOTA ( void )
     {
         DBG_vPrintf ( TRACE_APP_OTA, "eSetServerAuthorisation returned error 0x%x\n", eZCL_Status );
     }
+#ifdef OTA_STORE
+    APP_vOtaStoreInit ( );
+#endif
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8OtaServerBlockLimit
+ *
+ * DESCRIPTION:
+ * Largest image block that reaches u16Addr in one unfragmented frame: the
+ * APS payload the stack can carry to it (less source route relays and APS
+ * security when used) minus the block response header, bounded by
+ * OTA_MAX_BLOCK_SIZE. Should the stack report no room at all the ceiling is
+ * returned and fragmentation is left to the APS layer.
+ *
+ * RETURNS:
+ * Block data size
+ *
+ ****************************************************************************/
+PUBLIC uint8 APP_u8OtaServerBlockLimit ( uint16    u16Addr )
+{
+    uint8    u8MaxPayload =  ZPS_u8AplGetMaxPayloadSize ( ZPS_pvAplZdoGetAplHandle ( ), u16Addr );
+
+    if ( ( u8MaxPayload > OTA_BLOCK_RESPONSE_OVERHEAD ) &&
+         ( ( u8MaxPayload - OTA_BLOCK_RESPONSE_OVERHEAD ) < OTA_MAX_BLOCK_SIZE ) )
+    {
+        return ( u8MaxPayload - OTA_BLOCK_RESPONSE_OVERHEAD );
+    }
+    return OTA_MAX_BLOCK_SIZE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8OtaServerBlockSize
+ *
+ * DESCRIPTION:
+ * Block size to serve a client at u16Addr that asked for u8Requested bytes,
+ * counted in the statistics reported by APP_vOtaServerSendBlockSize
+ *
+ * RETURNS:
+ * Block data size
+ *
+ ****************************************************************************/
+PUBLIC uint8 APP_u8OtaServerBlockSize ( uint16    u16Addr,
+                                        uint8     u8Requested )
+{
+    uint8    u8Size =  APP_u8OtaServerBlockLimit ( u16Addr );
+
+    if ( u8Requested == 0 )
+    {
+        return 0;
+    }
+    if ( u8Requested < u8Size )
+    {
+        u8Size =  u8Requested;
+    }
+
+    sOtaBlockSizeStats.u32Sized++;
+    if ( u8Size < u8Requested )
+    {
+        sOtaBlockSizeStats.u32Reduced++;
+    }
+    if ( ( sOtaBlockSizeStats.u8Smallest == 0 ) || ( u8Size < sOtaBlockSizeStats.u8Smallest ) )
+    {
+        sOtaBlockSizeStats.u8Smallest =  u8Size;
+    }
+    if ( u8Size > sOtaBlockSizeStats.u8Largest )
+    {
+        sOtaBlockSizeStats.u8Largest =  u8Size;
+    }
+    return u8Size;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaServerSendBlockSize
+ *
+ * DESCRIPTION:
+ * Sends E_SL_MSG_OTA_BLOCK_SIZE: address, APS payload limit to it, block
+ * size it would get, OTA_MAX_BLOCK_SIZE, then requests sized, requests
+ * given less than asked, smallest and largest size chosen. Option bit 0
+ * clears the counters once reported.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vOtaServerSendBlockSize ( uint16    u16Addr,
+                                          uint8     u8Options )
+{
+    uint8     au8Buffer[5 + 2 * sizeof ( uint32 ) + 2 + 1];
+    uint16    u16Length       =  0;
+    uint8     u8MaxPayload    =  ZPS_u8AplGetMaxPayloadSize ( ZPS_pvAplZdoGetAplHandle ( ), u16Addr );
+    uint8     u8Size          =  APP_u8OtaServerBlockLimit ( u16Addr );
+
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], u16Addr,                           u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8MaxPayload,                      u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Size,                            u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], OTA_MAX_BLOCK_SIZE,                u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaBlockSizeStats.u32Sized,       u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaBlockSizeStats.u32Reduced,     u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], sOtaBlockSizeStats.u8Smallest,     u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], sOtaBlockSizeStats.u8Largest,      u16Length );
+    vSL_WriteMessage ( E_SL_MSG_OTA_BLOCK_SIZE,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+
+    if ( u8Options & 0x01 )
+    {
+        memset ( &sOtaBlockSizeStats, 0, sizeof ( sOtaBlockSizeStats ) );
+    }
 }
 
 /****************************************************************************
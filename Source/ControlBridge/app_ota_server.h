@@ -37,6 +37,9 @@
 /****************************************************************************/
 /***        Macro Definitions                                             ***/
 /****************************************************************************/
+/* Bytes of an image block response around the data: ZCL header (3), status,
+ * manufacturer code, image type, file version, file offset and data size */
+#define OTA_BLOCK_RESPONSE_OVERHEAD         17
 
 /****************************************************************************/
 /***        Type Definitions                                              ***/
@@ -46,6 +49,11 @@
 /***        Exported Functions                                            ***/
 /****************************************************************************/
 PUBLIC void vAppInitOTA(void);
+PUBLIC uint8 APP_u8OtaServerBlockLimit ( uint16    u16Addr );
+PUBLIC uint8 APP_u8OtaServerBlockSize ( uint16    u16Addr,
+                                        uint8     u8Requested );
+PUBLIC void APP_vOtaServerSendBlockSize ( uint16    u16Addr,
+                                          uint8     u8Options );
 
 /****************************************************************************/
 /***        External Variables                                            ***/
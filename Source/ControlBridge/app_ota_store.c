@@ -0,0 +1,957 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_ota_store.c
+ *
+ * DESCRIPTION:        OTA images held in internal flash and served without
+ *                     the host (Implementation)
+ *
+ *                     The host writes an OTA file into a slot of the
+ *                     OTA storage area page by page. Once its SHA-256 and
+ *                     header check out the slot can be advertised, and
+ *                     block requests for it are answered from flash
+ *                     without a round trip to the host.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stdint.h>
+#include <string.h>
+#include "zcl.h"
+#include "OTA.h"
+#include "PDM.h"
+#include "PDM_IDs.h"
+#include "zps_gen.h"
+#include "SecLib.h"
+#include "TimersManager.h"
+#include "Eeprom.h"
+#include "fsl_flash.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_ota_store.h"
+#ifdef OTA_FLEET
+#include "app_ota_fleet.h"
+#endif
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_OTA_STORE
+#define TRACE_OTA_STORE                 TRUE
+#else
+#define TRACE_OTA_STORE                 FALSE
+#endif
+
+/* Begin: operation, slot, image size and SHA-256 of the image */
+#define OTA_STORE_BEGIN_LENGTH          ( 2 + sizeof ( uint32 ) + SHA256_HASH_SIZE )
+/* Write: operation, slot and offset ahead of the data */
+#define OTA_STORE_WRITE_HEADER          ( 2 + sizeof ( uint32 ) )
+
+#define OTA_STORE_SLOT_REPORT_SIZE      17
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint32    u32Size;
+    uint32    u32FileVersion;
+    uint16    u16ManufacturerCode;
+    uint16    u16ImageType;
+    uint8     u8State;
+} tsOtaStoreSlot;
+
+/* Persisted as PDM_ID_APP_OTA_STORE, the images themselves stay in flash */
+typedef struct
+{
+    tsOtaStoreSlot    asSlot[OTA_STORE_SLOTS];
+    uint8             u8Advertised;
+} tsOtaStoreRecord;
+
+typedef struct
+{
+    uint32    au32Page[FLASH_PAGE_SIZE / sizeof ( uint32 )];
+    void*     pvSha256;
+    uint64    u64Started;
+    uint32    u32FlashUs;
+    uint32    u32Received;
+    uint16    u16PageFill;
+    uint8     au8Digest[SHA256_HASH_SIZE];
+    uint8     u8Slot;
+} tsOtaStoreUpload;
+
+typedef struct
+{
+    uint32    u32BlocksServed;
+    uint32    u32ServeUs;
+} tsOtaStoreStats;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE void APP_vOtaStoreLoad ( void );
+PRIVATE uint32 APP_u32OtaStoreSlotSize ( void );
+PRIVATE uintptr_t APP_uOtaStoreSlotBase ( uint8    u8Slot );
+PRIVATE uint64 APP_u64OtaStoreLittleEndian ( const uint8*    pu8Data,
+                                             uint8           u8Bytes );
+PRIVATE bool_t APP_bOtaStoreReadHeader ( uint8                 u8Slot,
+                                         tsOTA_ImageHeader*    psHeader );
+PRIVATE uint8 APP_u8OtaStoreAdvertise ( uint8    u8Slot );
+PRIVATE bool_t APP_bOtaStoreFlushPage ( void );
+PRIVATE void APP_vOtaStoreAbortUpload ( void );
+PRIVATE uint8 APP_u8OtaStoreBegin ( uint8*    pu8Command,
+                                    uint16    u16Length );
+PRIVATE uint8 APP_u8OtaStoreWrite ( uint8*    pu8Command,
+                                    uint16    u16Length );
+PRIVATE uint8 APP_u8OtaStoreCommit ( uint8    u8Slot );
+PRIVATE void APP_vOtaStoreSave ( void );
+PRIVATE void APP_vOtaStoreRespond ( uint8     u8Operation,
+                                    uint8     u8Status,
+                                    uint8     u8Slot,
+                                    uint32    u32Value );
+PRIVATE void APP_vOtaStoreSendInfo ( void );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsOtaStoreRecord    sOtaStoreRecord;
+PRIVATE tsOtaStoreUpload    sOtaStoreUpload;
+PRIVATE tsOtaStoreStats     sOtaStoreStats;
+PRIVATE bool_t              bOtaStoreLoaded =  FALSE;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaStoreInit
+ *
+ * DESCRIPTION:
+ * Advertises the selected stored image again, called from vAppInitOTA
+ * once the OTA cluster is up
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vOtaStoreInit ( void )
+{
+    APP_vOtaStoreLoad ( );
+    if ( ( sOtaStoreRecord.u8Advertised != OTA_STORE_SLOT_NONE ) &&
+         ( APP_u8OtaStoreAdvertise ( sOtaStoreRecord.u8Advertised ) != OTA_STORE_STATUS_OK ) )
+    {
+        sOtaStoreRecord.u8Advertised =  OTA_STORE_SLOT_NONE;
+    }
+    vLog_Printf ( TRACE_OTA_STORE, LOG_DEBUG, "\nOTA store %d slots of %d bytes, advertising %d",
+                  OTA_STORE_SLOTS, APP_u32OtaStoreSlotSize ( ), sOtaStoreRecord.u8Advertised );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaStoreCommand
+ *
+ * DESCRIPTION:
+ * Handles E_SL_MSG_OTA_STORE. The first byte selects the operation:
+ *  INFO   - capacity and slot table, see APP_vOtaStoreSendInfo
+ *  BEGIN  - slot, u32 image size, SHA-256 of the image
+ *  WRITE  - slot, u32 offset, data; chunks must arrive in order
+ *  COMMIT - slot; checks the digest and the OTA header, then advertises it
+ *  SELECT - slot to advertise, OTA_STORE_SLOT_NONE to stop serving
+ *  ERASE  - slot
+ * Every operation but INFO is answered with E_SL_MSG_OTA_STORE_RESPONSE
+ * carrying operation, status, slot and a u32: bytes received for BEGIN and
+ * WRITE, microseconds spent programming and hashing for COMMIT.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vOtaStoreCommand ( uint8*    pu8Command,
+                                   uint16    u16Length )
+{
+    uint8    u8Operation;
+    uint8    u8Slot;
+    uint8    u8Status;
+
+    if ( u16Length == 0 )
+    {
+        return;
+    }
+    APP_vOtaStoreLoad ( );
+    u8Operation =  pu8Command[0];
+    if ( u8Operation == OTA_STORE_OP_INFO )
+    {
+        APP_vOtaStoreSendInfo ( );
+        return;
+    }
+    if ( u16Length < 2 )
+    {
+        APP_vOtaStoreRespond ( u8Operation, OTA_STORE_STATUS_MALFORMED, OTA_STORE_SLOT_NONE, 0 );
+        return;
+    }
+    u8Slot =  pu8Command[1];
+    if ( ( u8Slot >= OTA_STORE_SLOTS ) &&
+         !( ( u8Operation == OTA_STORE_OP_SELECT ) && ( u8Slot == OTA_STORE_SLOT_NONE ) ) )
+    {
+        APP_vOtaStoreRespond ( u8Operation, OTA_STORE_STATUS_BAD_SLOT, u8Slot, 0 );
+        return;
+    }
+
+    switch ( u8Operation )
+    {
+        case OTA_STORE_OP_BEGIN:
+            u8Status =  APP_u8OtaStoreBegin ( pu8Command, u16Length );
+        break;
+
+        case OTA_STORE_OP_WRITE:
+            u8Status =  APP_u8OtaStoreWrite ( pu8Command, u16Length );
+        break;
+
+        case OTA_STORE_OP_COMMIT:
+            u8Status =  APP_u8OtaStoreCommit ( u8Slot );
+            APP_vOtaStoreRespond ( u8Operation, u8Status, u8Slot, sOtaStoreUpload.u32FlashUs );
+            return;
+
+        case OTA_STORE_OP_SELECT:
+            u8Status =  APP_u8OtaStoreAdvertise ( u8Slot );
+            if ( u8Status == OTA_STORE_STATUS_OK )
+            {
+                APP_vOtaStoreSave ( );
+            }
+        break;
+
+        case OTA_STORE_OP_ERASE:
+            if ( sOtaStoreUpload.u8Slot == u8Slot )
+            {
+                APP_vOtaStoreAbortUpload ( );
+            }
+            if ( sOtaStoreRecord.u8Advertised == u8Slot )
+            {
+                sOtaStoreRecord.u8Advertised =  OTA_STORE_SLOT_NONE;
+            }
+            memset ( &sOtaStoreRecord.asSlot[u8Slot], 0, sizeof ( tsOtaStoreSlot ) );
+            APP_vOtaStoreSave ( );
+            u8Status =  OTA_STORE_STATUS_OK;
+        break;
+
+        default:
+            u8Status =  OTA_STORE_STATUS_MALFORMED;
+        break;
+    }
+    APP_vOtaStoreRespond ( u8Operation, u8Status, u8Slot, sOtaStoreUpload.u32Received );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaStoreHostImageLoaded
+ *
+ * DESCRIPTION:
+ * The host advertised an image of its own with E_SL_MSG_LOAD_NEW_IMAGE,
+ * which replaces the stored one as the image offered to clients
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vOtaStoreHostImageLoaded ( void )
+{
+    APP_vOtaStoreLoad ( );
+    if ( sOtaStoreRecord.u8Advertised != OTA_STORE_SLOT_NONE )
+    {
+        sOtaStoreRecord.u8Advertised =  OTA_STORE_SLOT_NONE;
+        APP_vOtaStoreSave ( );
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bOtaStoreBlockRequest
+ *
+ * DESCRIPTION:
+ * Answers a client block request for the advertised stored image straight
+ * from flash
+ *
+ * RETURNS:
+ * TRUE when answered here, FALSE when it must go to the host
+ *
+ ****************************************************************************/
+PUBLIC bool_t APP_bOtaStoreBlockRequest ( tsZCL_CallBackEvent*      psEvent,
+                                          tsOTA_CallBackMessage*    psCallBackMessage )
+{
+    tsOTA_BlockRequest*                psRequest =  &psCallBackMessage->uMessage.sBlockRequestPayload;
+    tsOTA_ImageBlockResponsePayload    sPayload;
+    tsZCL_Address                      sAddress;
+    uint8                              au8Data[OTA_MAX_BLOCK_SIZE];
+    uint64                             u64Start =  TMR_GetTimestamp ( );
+    uint8                              u8Size;
+
+    if ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8SrcAddrMode != ZPS_E_ADDR_MODE_SHORT )
+    {
+        return FALSE;
+    }
+    u8Size =  APP_u8OtaStoreRead ( psRequest->u16ManufactureCode,
+                                   psRequest->u16ImageType,
+                                   psRequest->u32FileVersion,
+                                   psRequest->u32FileOffset,
+                                   psRequest->u8MaxDataSize,
+                                   au8Data );
+    if ( u8Size == 0 )
+    {
+        return FALSE;
+    }
+
+    sPayload.u8Status                                           =  OTA_STATUS_SUCCESS;
+    sPayload.uMessage.sBlockPayloadSuccess.u32FileOffset        =  psRequest->u32FileOffset;
+    sPayload.uMessage.sBlockPayloadSuccess.u32FileVersion       =  psRequest->u32FileVersion;
+    sPayload.uMessage.sBlockPayloadSuccess.u16ImageType         =  psRequest->u16ImageType;
+    sPayload.uMessage.sBlockPayloadSuccess.u16ManufacturerCode  =  psRequest->u16ManufactureCode;
+    sPayload.uMessage.sBlockPayloadSuccess.u8DataSize           =  u8Size;
+    sPayload.uMessage.sBlockPayloadSuccess.pu8Data              =  au8Data;
+
+    sAddress.eAddressMode                   =  E_ZCL_AM_SHORT;
+    sAddress.uAddress.u16DestinationAddress =  psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr;
+
+    eOTA_ServerImageBlockResponse ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8DstEndpoint,
+                                    psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8SrcEndpoint,
+                                    &sAddress,
+                                    &sPayload,
+                                    u8Size,
+                                    psEvent->u8TransactionSequenceNumber );
+
+    sOtaStoreStats.u32BlocksServed++;
+    sOtaStoreStats.u32ServeUs +=  ( uint32 ) ( TMR_GetTimestamp ( ) - u64Start );
+    return TRUE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8OtaStoreRead
+ *
+ * DESCRIPTION:
+ * Copies up to u8Size bytes (at most OTA_MAX_BLOCK_SIZE) of the advertised
+ * stored image from u32Offset if it is the image described
+ *
+ * RETURNS:
+ * Bytes copied, 0 if the image isn't stored or the offset is past its end
+ *
+ ****************************************************************************/
+PUBLIC uint8 APP_u8OtaStoreRead ( uint16    u16ManufacturerCode,
+                                  uint16    u16ImageType,
+                                  uint32    u32FileVersion,
+                                  uint32    u32Offset,
+                                  uint8     u8Size,
+                                  uint8*    pu8Data )
+{
+    tsOtaStoreSlot*    psSlot;
+
+    if ( sOtaStoreRecord.u8Advertised >= OTA_STORE_SLOTS )
+    {
+        return 0;
+    }
+    psSlot =  &sOtaStoreRecord.asSlot[sOtaStoreRecord.u8Advertised];
+    if ( ( psSlot->u8State != OTA_STORE_SLOT_VERIFIED ) ||
+         ( psSlot->u16ManufacturerCode != u16ManufacturerCode ) ||
+         ( psSlot->u16ImageType != u16ImageType ) ||
+         ( psSlot->u32FileVersion != u32FileVersion ) ||
+         ( u32Offset >= psSlot->u32Size ) )
+    {
+        return 0;
+    }
+
+    if ( u8Size > OTA_MAX_BLOCK_SIZE )
+    {
+        u8Size =  OTA_MAX_BLOCK_SIZE;
+    }
+    if ( ( psSlot->u32Size - u32Offset ) < u8Size )
+    {
+        u8Size =  ( uint8 ) ( psSlot->u32Size - u32Offset );
+    }
+    memcpy ( pu8Data, ( const uint8* ) ( APP_uOtaStoreSlotBase ( sOtaStoreRecord.u8Advertised ) + u32Offset ), u8Size );
+    return u8Size;
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaStoreLoad
+ *
+ * DESCRIPTION:
+ * Restores the slot table from PDM the first time the store is used. An
+ * upload cut short by a reset leaves its slot empty.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vOtaStoreLoad ( void )
+{
+    uint16    u16BytesRead =  0;
+    uint8     i;
+
+    if ( bOtaStoreLoaded )
+    {
+        return;
+    }
+    sOtaStoreUpload.u8Slot =  OTA_STORE_SLOT_NONE;
+    if ( ( PDM_eReadDataFromRecord ( PDM_ID_APP_OTA_STORE,
+                                     &sOtaStoreRecord,
+                                     sizeof ( sOtaStoreRecord ),
+                                     &u16BytesRead ) != PDM_E_STATUS_OK ) ||
+         ( u16BytesRead != sizeof ( sOtaStoreRecord ) ) )
+    {
+        memset ( &sOtaStoreRecord, 0, sizeof ( sOtaStoreRecord ) );
+        sOtaStoreRecord.u8Advertised =  OTA_STORE_SLOT_NONE;
+    }
+    for ( i = 0; i < OTA_STORE_SLOTS; i++ )
+    {
+        if ( sOtaStoreRecord.asSlot[i].u8State == OTA_STORE_SLOT_RECEIVING )
+        {
+            sOtaStoreRecord.asSlot[i].u8State =  OTA_STORE_SLOT_EMPTY;
+        }
+    }
+    bOtaStoreLoaded =  TRUE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u32OtaStoreSlotSize
+ *
+ * DESCRIPTION:
+ * Bytes available to each slot: the OTA storage area the linker leaves
+ * between the application and the PDM, less the reserved pages, split
+ * evenly and rounded down to whole flash pages
+ *
+ * RETURNS:
+ * Slot size in bytes
+ *
+ ****************************************************************************/
+PRIVATE uint32 APP_u32OtaStoreSlotSize ( void )
+{
+    uint32    u32Pages =  gEepromParams_TotalSize_c / FLASH_PAGE_SIZE;
+
+    if ( u32Pages <= OTA_STORE_RESERVED_PAGES )
+    {
+        return 0;
+    }
+    return ( ( u32Pages - OTA_STORE_RESERVED_PAGES ) / OTA_STORE_SLOTS ) * FLASH_PAGE_SIZE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_uOtaStoreSlotBase
+ *
+ * DESCRIPTION:
+ * Flash address of the first byte of a slot
+ *
+ * RETURNS:
+ * Address
+ *
+ ****************************************************************************/
+PRIVATE uintptr_t APP_uOtaStoreSlotBase ( uint8    u8Slot )
+{
+    return ( ( uintptr_t ) gEepromParams_StartOffset_c +
+             ( OTA_STORE_RESERVED_PAGES * FLASH_PAGE_SIZE ) +
+             ( u8Slot * APP_u32OtaStoreSlotSize ( ) ) );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u64OtaStoreLittleEndian
+ *
+ * DESCRIPTION:
+ * Reads a little endian OTA file field
+ *
+ * RETURNS:
+ * Field value
+ *
+ ****************************************************************************/
+PRIVATE uint64 APP_u64OtaStoreLittleEndian ( const uint8*    pu8Data,
+                                             uint8           u8Bytes )
+{
+    uint64    u64Value =  0;
+
+    while ( u8Bytes > 0 )
+    {
+        u8Bytes--;
+        u64Value =  ( u64Value << 8 ) | pu8Data[u8Bytes];
+    }
+    return u64Value;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bOtaStoreReadHeader
+ *
+ * DESCRIPTION:
+ * Decodes the OTA header at the start of a stored image and checks it
+ * describes the image actually held
+ *
+ * RETURNS:
+ * TRUE if the header is valid
+ *
+ ****************************************************************************/
+PRIVATE bool_t APP_bOtaStoreReadHeader ( uint8                 u8Slot,
+                                         tsOTA_ImageHeader*    psHeader )
+{
+    const uint8*    pu8Header =  ( const uint8* ) APP_uOtaStoreSlotBase ( u8Slot );
+    uint32          u32Size   =  sOtaStoreRecord.asSlot[u8Slot].u32Size;
+    uint16          u16Length =  OTA_MIN_HEADER_SIZE;
+
+    memset ( psHeader, 0, sizeof ( tsOTA_ImageHeader ) );
+    if ( u32Size < OTA_MIN_HEADER_SIZE )
+    {
+        return FALSE;
+    }
+
+    psHeader->u32FileIdentifier         =  ( uint32 ) APP_u64OtaStoreLittleEndian ( &pu8Header[0],  4 );
+    psHeader->u16HeaderVersion          =  ( uint16 ) APP_u64OtaStoreLittleEndian ( &pu8Header[4],  2 );
+    psHeader->u16HeaderLength           =  ( uint16 ) APP_u64OtaStoreLittleEndian ( &pu8Header[6],  2 );
+    psHeader->u16HeaderControlField     =  ( uint16 ) APP_u64OtaStoreLittleEndian ( &pu8Header[8],  2 );
+    psHeader->u16ManufacturerCode       =  ( uint16 ) APP_u64OtaStoreLittleEndian ( &pu8Header[10], 2 );
+    psHeader->u16ImageType              =  ( uint16 ) APP_u64OtaStoreLittleEndian ( &pu8Header[12], 2 );
+    psHeader->u32FileVersion            =  ( uint32 ) APP_u64OtaStoreLittleEndian ( &pu8Header[14], 4 );
+    psHeader->u16StackVersion           =  ( uint16 ) APP_u64OtaStoreLittleEndian ( &pu8Header[18], 2 );
+    memcpy ( psHeader->stHeaderString, &pu8Header[20], OTA_HEADER_STRING_SIZE );
+    psHeader->u32TotalImage             =  ( uint32 ) APP_u64OtaStoreLittleEndian ( &pu8Header[52], 4 );
+
+    if ( psHeader->u16HeaderControlField & OTA_HDR_SECURITY_CRED_VER_PRESENT )
+    {
+        psHeader->u8SecurityCredVersion =  pu8Header[u16Length];
+        u16Length +=  1;
+    }
+    if ( psHeader->u16HeaderControlField & OTA_HDR_DEV_SPECF_FILE )
+    {
+        psHeader->u64UpgradeFileDest    =  APP_u64OtaStoreLittleEndian ( &pu8Header[u16Length], 8 );
+        u16Length +=  8;
+    }
+    if ( psHeader->u16HeaderControlField & OTA_HDR_HW_VER_PRESENT )
+    {
+        psHeader->u16MinimumHwVersion   =  ( uint16 ) APP_u64OtaStoreLittleEndian ( &pu8Header[u16Length],     2 );
+        psHeader->u16MaxHwVersion       =  ( uint16 ) APP_u64OtaStoreLittleEndian ( &pu8Header[u16Length + 2], 2 );
+        u16Length +=  4;
+    }
+
+    return ( ( psHeader->u32FileIdentifier == OTA_FILE_IDENTIFIER ) &&
+             ( psHeader->u16HeaderLength >= u16Length ) &&
+             ( psHeader->u16HeaderLength <= OTA_MAX_HEADER_SIZE ) &&
+             ( psHeader->u32TotalImage == u32Size ) );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8OtaStoreAdvertise
+ *
+ * DESCRIPTION:
+ * Offers a verified slot's image to clients in place of the host image,
+ * clients then get its blocks from flash
+ *
+ * RETURNS:
+ * OTA_STORE_STATUS_xxx
+ *
+ ****************************************************************************/
+PRIVATE uint8 APP_u8OtaStoreAdvertise ( uint8    u8Slot )
+{
+    tsOTA_CoProcessorOTAHeader    sCoProcessorOTAHeader;
+
+    if ( u8Slot == OTA_STORE_SLOT_NONE )
+    {
+        /* The cluster keeps offering the last header until the host loads one */
+        sOtaStoreRecord.u8Advertised =  OTA_STORE_SLOT_NONE;
+        return OTA_STORE_STATUS_OK;
+    }
+    if ( sOtaStoreRecord.asSlot[u8Slot].u8State != OTA_STORE_SLOT_VERIFIED )
+    {
+        return OTA_STORE_STATUS_BAD_STATE;
+    }
+
+    memset ( &sCoProcessorOTAHeader, 0, sizeof ( sCoProcessorOTAHeader ) );
+    if ( !APP_bOtaStoreReadHeader ( u8Slot, &sCoProcessorOTAHeader.sOTA_ImageHeader[0] ) ||
+         ( eOTA_NewImageLoaded ( CONTROLBRIDGE_ZLO_ENDPOINT, TRUE, &sCoProcessorOTAHeader ) != E_ZCL_SUCCESS ) )
+    {
+        return OTA_STORE_STATUS_BAD_HEADER;
+    }
+    sOtaStoreRecord.u8Advertised =  u8Slot;
+#ifdef OTA_FLEET
+    APP_vOtaFleetReset ( );
+#endif
+    return OTA_STORE_STATUS_OK;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bOtaStoreFlushPage
+ *
+ * DESCRIPTION:
+ * Programs the page being assembled, padding a short last page, and feeds
+ * what reads back from flash to the digest so that it covers the stored
+ * copy rather than what came over the serial link
+ *
+ * RETURNS:
+ * TRUE if the page was programmed and reads back unchanged
+ *
+ ****************************************************************************/
+PRIVATE bool_t APP_bOtaStoreFlushPage ( void )
+{
+    uint8*       pu8Page  =  ( uint8* ) sOtaStoreUpload.au32Page;
+    uintptr_t    uAddress =  APP_uOtaStoreSlotBase ( sOtaStoreUpload.u8Slot ) +
+                             ( sOtaStoreUpload.u32Received - sOtaStoreUpload.u16PageFill );
+    uint64       u64Start =  TMR_GetTimestamp ( );
+
+    memset ( &pu8Page[sOtaStoreUpload.u16PageFill], 0xFF, FLASH_PAGE_SIZE - sOtaStoreUpload.u16PageFill );
+    if ( ( FLASH_ErasePages ( FLASH, ( uint32 ) ( uAddress / FLASH_PAGE_SIZE ), 1 ) != FLASH_DONE ) ||
+         ( FLASH_Program ( FLASH, ( uint32* ) uAddress, sOtaStoreUpload.au32Page, FLASH_PAGE_SIZE ) != FLASH_DONE ) ||
+         ( memcmp ( ( const void* ) uAddress, pu8Page, FLASH_PAGE_SIZE ) != 0 ) )
+    {
+        return FALSE;
+    }
+    SHA256_HashUpdate ( sOtaStoreUpload.pvSha256, ( const uint8* ) uAddress, sOtaStoreUpload.u16PageFill );
+
+    sOtaStoreUpload.u16PageFill  =  0;
+    sOtaStoreUpload.u32FlashUs  +=  ( uint32 ) ( TMR_GetTimestamp ( ) - u64Start );
+    return TRUE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaStoreAbortUpload
+ *
+ * DESCRIPTION:
+ * Drops the upload in progress, its slot is left empty
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vOtaStoreAbortUpload ( void )
+{
+    uint8    au8Digest[SHA256_HASH_SIZE];
+
+    if ( sOtaStoreUpload.u8Slot == OTA_STORE_SLOT_NONE )
+    {
+        return;
+    }
+    /* Finishing releases the hardware SHA engine */
+    SHA256_HashFinish ( sOtaStoreUpload.pvSha256, au8Digest );
+    SHA256_FreeCtx ( sOtaStoreUpload.pvSha256 );
+    sOtaStoreRecord.asSlot[sOtaStoreUpload.u8Slot].u8State =  OTA_STORE_SLOT_EMPTY;
+    sOtaStoreUpload.pvSha256 =  NULL;
+    sOtaStoreUpload.u8Slot   =  OTA_STORE_SLOT_NONE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8OtaStoreBegin
+ *
+ * DESCRIPTION:
+ * Starts an upload into a slot, dropping any upload in progress. A slot
+ * that held the advertised image stops being served.
+ *
+ * RETURNS:
+ * OTA_STORE_STATUS_xxx
+ *
+ ****************************************************************************/
+PRIVATE uint8 APP_u8OtaStoreBegin ( uint8*    pu8Command,
+                                    uint16    u16Length )
+{
+    uint8     u8Slot =  pu8Command[1];
+    uint32    u32Size;
+
+    if ( u16Length < OTA_STORE_BEGIN_LENGTH )
+    {
+        return OTA_STORE_STATUS_MALFORMED;
+    }
+    u32Size =  ZNC_RTN_U32 ( pu8Command, 2 );
+    if ( u32Size > APP_u32OtaStoreSlotSize ( ) )
+    {
+        return OTA_STORE_STATUS_TOO_LARGE;
+    }
+    if ( u32Size < OTA_MIN_HEADER_SIZE )
+    {
+        return OTA_STORE_STATUS_BAD_HEADER;
+    }
+
+    APP_vOtaStoreAbortUpload ( );
+    sOtaStoreUpload.pvSha256 =  SHA256_AllocCtx ( );
+    if ( sOtaStoreUpload.pvSha256 == NULL )
+    {
+        return OTA_STORE_STATUS_NO_MEMORY;
+    }
+    SHA256_Init ( sOtaStoreUpload.pvSha256 );
+    memcpy ( sOtaStoreUpload.au8Digest, &pu8Command[2 + sizeof ( uint32 )], SHA256_HASH_SIZE );
+    sOtaStoreUpload.u8Slot       =  u8Slot;
+    sOtaStoreUpload.u32Received  =  0;
+    sOtaStoreUpload.u16PageFill  =  0;
+    sOtaStoreUpload.u32FlashUs   =  0;
+    sOtaStoreUpload.u64Started   =  TMR_GetTimestamp ( );
+
+    if ( sOtaStoreRecord.u8Advertised == u8Slot )
+    {
+        sOtaStoreRecord.u8Advertised =  OTA_STORE_SLOT_NONE;
+    }
+    memset ( &sOtaStoreRecord.asSlot[u8Slot], 0, sizeof ( tsOtaStoreSlot ) );
+    sOtaStoreRecord.asSlot[u8Slot].u32Size =  u32Size;
+    sOtaStoreRecord.asSlot[u8Slot].u8State =  OTA_STORE_SLOT_RECEIVING;
+    APP_vOtaStoreSave ( );
+
+    vLog_Printf ( TRACE_OTA_STORE, LOG_DEBUG, "\nOTA store slot %d receiving %d bytes", u8Slot, u32Size );
+    return OTA_STORE_STATUS_OK;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8OtaStoreWrite
+ *
+ * DESCRIPTION:
+ * Adds the next chunk of the image, programming every page it completes
+ *
+ * RETURNS:
+ * OTA_STORE_STATUS_xxx
+ *
+ ****************************************************************************/
+PRIVATE uint8 APP_u8OtaStoreWrite ( uint8*    pu8Command,
+                                    uint16    u16Length )
+{
+    uint8*    pu8Page =  ( uint8* ) sOtaStoreUpload.au32Page;
+    uint16    u16Data;
+    uint16    u16Copy;
+    uint16    u16Done =  0;
+
+    if ( u16Length < OTA_STORE_WRITE_HEADER )
+    {
+        return OTA_STORE_STATUS_MALFORMED;
+    }
+    if ( sOtaStoreUpload.u8Slot != pu8Command[1] )
+    {
+        return OTA_STORE_STATUS_BAD_STATE;
+    }
+    if ( ZNC_RTN_U32 ( pu8Command, 2 ) != sOtaStoreUpload.u32Received )
+    {
+        return OTA_STORE_STATUS_BAD_OFFSET;
+    }
+    u16Data =  u16Length - OTA_STORE_WRITE_HEADER;
+    if ( u16Data > ( sOtaStoreRecord.asSlot[sOtaStoreUpload.u8Slot].u32Size - sOtaStoreUpload.u32Received ) )
+    {
+        return OTA_STORE_STATUS_TOO_LARGE;
+    }
+
+    while ( u16Done < u16Data )
+    {
+        u16Copy =  FLASH_PAGE_SIZE - sOtaStoreUpload.u16PageFill;
+        if ( u16Copy > ( u16Data - u16Done ) )
+        {
+            u16Copy =  u16Data - u16Done;
+        }
+        memcpy ( &pu8Page[sOtaStoreUpload.u16PageFill], &pu8Command[OTA_STORE_WRITE_HEADER + u16Done], u16Copy );
+        sOtaStoreUpload.u16PageFill +=  u16Copy;
+        sOtaStoreUpload.u32Received +=  u16Copy;
+        u16Done                     +=  u16Copy;
+
+        if ( ( sOtaStoreUpload.u16PageFill == FLASH_PAGE_SIZE ) &&
+             !APP_bOtaStoreFlushPage ( ) )
+        {
+            APP_vOtaStoreAbortUpload ( );
+            APP_vOtaStoreSave ( );
+            return OTA_STORE_STATUS_FLASH_ERROR;
+        }
+    }
+    return OTA_STORE_STATUS_OK;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8OtaStoreCommit
+ *
+ * DESCRIPTION:
+ * Completes an upload: programs the last page, checks the digest of the
+ * stored copy and its OTA header, then advertises the image
+ *
+ * RETURNS:
+ * OTA_STORE_STATUS_xxx
+ *
+ ****************************************************************************/
+PRIVATE uint8 APP_u8OtaStoreCommit ( uint8    u8Slot )
+{
+    tsOtaStoreSlot*      psSlot =  &sOtaStoreRecord.asSlot[u8Slot];
+    tsOTA_ImageHeader    sHeader;
+    uint8                au8Digest[SHA256_HASH_SIZE];
+    uint8                u8Status;
+
+    if ( ( sOtaStoreUpload.u8Slot != u8Slot ) ||
+         ( sOtaStoreUpload.u32Received != psSlot->u32Size ) )
+    {
+        return OTA_STORE_STATUS_BAD_STATE;
+    }
+    if ( ( sOtaStoreUpload.u16PageFill != 0 ) &&
+         !APP_bOtaStoreFlushPage ( ) )
+    {
+        APP_vOtaStoreAbortUpload ( );
+        APP_vOtaStoreSave ( );
+        return OTA_STORE_STATUS_FLASH_ERROR;
+    }
+
+    SHA256_HashFinish ( sOtaStoreUpload.pvSha256, au8Digest );
+    SHA256_FreeCtx ( sOtaStoreUpload.pvSha256 );
+    sOtaStoreUpload.pvSha256 =  NULL;
+    sOtaStoreUpload.u8Slot   =  OTA_STORE_SLOT_NONE;
+
+    if ( memcmp ( au8Digest, sOtaStoreUpload.au8Digest, SHA256_HASH_SIZE ) != 0 )
+    {
+        u8Status =  OTA_STORE_STATUS_BAD_HASH;
+    }
+    else if ( !APP_bOtaStoreReadHeader ( u8Slot, &sHeader ) )
+    {
+        u8Status =  OTA_STORE_STATUS_BAD_HEADER;
+    }
+    else
+    {
+        psSlot->u32FileVersion      =  sHeader.u32FileVersion;
+        psSlot->u16ManufacturerCode =  sHeader.u16ManufacturerCode;
+        psSlot->u16ImageType        =  sHeader.u16ImageType;
+        psSlot->u8State             =  OTA_STORE_SLOT_VERIFIED;
+        u8Status                    =  APP_u8OtaStoreAdvertise ( u8Slot );
+    }
+    if ( psSlot->u8State != OTA_STORE_SLOT_VERIFIED )
+    {
+        psSlot->u8State =  OTA_STORE_SLOT_EMPTY;
+    }
+    APP_vOtaStoreSave ( );
+
+    vLog_Printf ( TRACE_OTA_STORE, LOG_DEBUG, "\nOTA store slot %d commit %d after %d ms", u8Slot, u8Status,
+                  ( uint32 ) ( ( TMR_GetTimestamp ( ) - sOtaStoreUpload.u64Started ) / 1000 ) );
+    return u8Status;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaStoreSave
+ *
+ * DESCRIPTION:
+ * Persists the slot table
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vOtaStoreSave ( void )
+{
+    PDM_eSaveRecordData ( PDM_ID_APP_OTA_STORE,
+                          &sOtaStoreRecord,
+                          sizeof ( sOtaStoreRecord ) );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaStoreRespond
+ *
+ * DESCRIPTION:
+ * Sends E_SL_MSG_OTA_STORE_RESPONSE
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vOtaStoreRespond ( uint8     u8Operation,
+                                    uint8     u8Status,
+                                    uint8     u8Slot,
+                                    uint32    u32Value )
+{
+    uint8     au8Buffer[3 + sizeof ( uint32 ) + 1];
+    uint16    u16Length =  0;
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Operation,  u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Status,     u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Slot,       u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], u32Value,     u16Length );
+    vSL_WriteMessage ( E_SL_MSG_OTA_STORE_RESPONSE,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vOtaStoreSendInfo
+ *
+ * DESCRIPTION:
+ * Sends E_SL_MSG_OTA_STORE_RESPONSE for OTA_STORE_OP_INFO: operation,
+ * status, slot count, advertised slot, u32 storage area size, u32 slot
+ * size, u32 blocks served from flash and u32 microseconds spent serving
+ * them, then per slot its state, manufacturer code, image type, file
+ * version, image size and bytes received
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vOtaStoreSendInfo ( void )
+{
+    uint8     au8Buffer[4 + 4 * sizeof ( uint32 ) + OTA_STORE_SLOTS * OTA_STORE_SLOT_REPORT_SIZE + 1];
+    uint16    u16Length =  0;
+    uint8     i;
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], OTA_STORE_OP_INFO,                  u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], OTA_STORE_STATUS_OK,                u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], OTA_STORE_SLOTS,                    u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], sOtaStoreRecord.u8Advertised,       u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], gEepromParams_TotalSize_c,          u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], APP_u32OtaStoreSlotSize ( ),        u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaStoreStats.u32BlocksServed,     u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaStoreStats.u32ServeUs,          u16Length );
+    for ( i = 0; i < OTA_STORE_SLOTS; i++ )
+    {
+        ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], sOtaStoreRecord.asSlot[i].u8State,              u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], sOtaStoreRecord.asSlot[i].u16ManufacturerCode,  u16Length );
+        ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], sOtaStoreRecord.asSlot[i].u16ImageType,         u16Length );
+        ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaStoreRecord.asSlot[i].u32FileVersion,       u16Length );
+        ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], sOtaStoreRecord.asSlot[i].u32Size,              u16Length );
+        ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ],
+                          ( sOtaStoreUpload.u8Slot == i ) ? sOtaStoreUpload.u32Received :
+                          ( ( sOtaStoreRecord.asSlot[i].u8State == OTA_STORE_SLOT_VERIFIED ) ? sOtaStoreRecord.asSlot[i].u32Size : 0 ),
+                          u16Length );
+    }
+    vSL_WriteMessage ( E_SL_MSG_OTA_STORE_RESPONSE,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
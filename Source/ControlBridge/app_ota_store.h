@@ -0,0 +1,117 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_ota_store.h
+ *
+ * DESCRIPTION:        OTA images held in internal flash and served without
+ *                     the host (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+
+#ifndef APP_OTA_STORE_H_
+#define APP_OTA_STORE_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include "zcl.h"
+#include "OTA.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Images held at once, the OTA storage area is split evenly between them */
+#ifndef OTA_STORE_SLOTS
+#define OTA_STORE_SLOTS                     2
+#endif
+
+/* Flash pages at the start of the OTA storage area left to the image
+ * space vAppInitOTA allocates to the OTA cluster */
+#define OTA_STORE_RESERVED_PAGES            16
+
+/* Largest image chunk carried by one E_SL_MSG_OTA_STORE write */
+#define OTA_STORE_CHUNK_MAX                 256
+
+#define OTA_STORE_SLOT_NONE                 0xFF
+
+/* E_SL_MSG_OTA_STORE operations, first byte of the command */
+#define OTA_STORE_OP_INFO                   0
+#define OTA_STORE_OP_BEGIN                  1
+#define OTA_STORE_OP_WRITE                  2
+#define OTA_STORE_OP_COMMIT                 3
+#define OTA_STORE_OP_SELECT                 4
+#define OTA_STORE_OP_ERASE                  5
+
+/* Slot states */
+#define OTA_STORE_SLOT_EMPTY                0
+#define OTA_STORE_SLOT_RECEIVING            1
+#define OTA_STORE_SLOT_VERIFIED             2
+
+/* E_SL_MSG_OTA_STORE_RESPONSE status */
+#define OTA_STORE_STATUS_OK                 0
+#define OTA_STORE_STATUS_BAD_SLOT           1
+#define OTA_STORE_STATUS_TOO_LARGE          2
+#define OTA_STORE_STATUS_BAD_STATE          3
+#define OTA_STORE_STATUS_BAD_OFFSET         4
+#define OTA_STORE_STATUS_FLASH_ERROR        5
+#define OTA_STORE_STATUS_BAD_HEADER         6
+#define OTA_STORE_STATUS_BAD_HASH           7
+#define OTA_STORE_STATUS_MALFORMED          8
+#define OTA_STORE_STATUS_NO_MEMORY          9
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vOtaStoreInit ( void );
+PUBLIC void APP_vOtaStoreCommand ( uint8*    pu8Command,
+                                   uint16    u16Length );
+PUBLIC void APP_vOtaStoreHostImageLoaded ( void );
+PUBLIC bool_t APP_bOtaStoreBlockRequest ( tsZCL_CallBackEvent*      psEvent,
+                                          tsOTA_CallBackMessage*    psCallBackMessage );
+PUBLIC uint8 APP_u8OtaStoreRead ( uint16    u16ManufacturerCode,
+                                  uint16    u16ImageType,
+                                  uint32    u32FileVersion,
+                                  uint32    u32Offset,
+                                  uint8     u8Size,
+                                  uint8*    pu8Data );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_OTA_STORE_H_ */
@@ -0,0 +1,468 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_pdm_telemetry.c
+ *
+ * DESCRIPTION:        Flash wear and PDM save statistics reported to the
+ *                     host (Implementation)
+ *
+ *                     Every PDM_eSaveRecordData call, from the application
+ *                     or the stack libraries, goes through the linker wrap
+ *                     below so it can be counted per record ID and timed.
+ *                     Segment wear comes from the PDM library itself.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "dbg.h"
+#include "PDM.h"
+#include "PDM_IDs.h"
+#include "TimersManager.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_pdm_telemetry.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_PDM_TELEMETRY
+#define TRACE_PDM_TELEMETRY           TRUE
+#else
+#define TRACE_PDM_TELEMETRY           FALSE
+#endif
+
+/* Section, first index, count (and total for records) */
+#define PDM_TELEMETRY_LIST_HEADER_LENGTH    4
+#define PDM_TELEMETRY_RECORD_LENGTH         10
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint16    u16RecordId;
+    uint32    u32Saves;
+    uint32    u32Bytes;
+} tsPdmTelemetryRecord;
+
+typedef struct
+{
+    uint32    u32Saves;
+    uint32    u32SavesInCommand;
+    uint32    u32SavesIdle;
+    uint32    u32FailedSaves;
+    uint32    u32Bytes;
+    uint32    u32MinDurationUs;
+    uint32    u32MaxDurationUs;
+    uint64    u64TotalDurationUs;
+    uint32    au32Latency[PDM_TELEMETRY_LATENCY_BUCKETS];
+} tsPdmTelemetryStats;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE tsPdmTelemetryRecord* APP_psPdmTelemetryGetRecord ( uint16    u16RecordId );
+PRIVATE uint32 APP_u32PdmTelemetryWearSum ( uint32*    pu32Min,
+                                            uint32*    pu32Max );
+PRIVATE void APP_vPdmTelemetryReset ( void );
+PRIVATE uint8 APP_u8PdmTelemetryLatencyBucket ( uint32    u32DurationUs );
+
+/* Provided by the linker for -Wl,--wrap=PDM_eSaveRecordData */
+extern PDM_teStatus __real_PDM_eSaveRecordData ( uint16_t    u16IdValue,
+                                                 void*       pvDataBuffer,
+                                                 uint16_t    u16Datalength );
+PUBLIC PDM_teStatus __wrap_PDM_eSaveRecordData ( uint16_t    u16IdValue,
+                                                 void*       pvDataBuffer,
+                                                 uint16_t    u16Datalength );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsPdmTelemetryRecord    asPdmTelemetryRecords[PDM_TELEMETRY_MAX_RECORDS];
+PRIVATE uint8                   u8PdmTelemetryRecordCount;
+PRIVATE tsPdmTelemetryStats     sPdmTelemetryStats;
+PRIVATE uint32                  u32PdmTelemetryWearBase;
+PRIVATE uint32                  u32PdmTelemetryBootUs;
+PRIVATE bool_t                  bPdmTelemetryInCommand;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vPdmTelemetryInit
+ *
+ * DESCRIPTION:
+ * Clears the counters; erases are counted from the current segment wear.
+ * Keeps how long PDM_eInitialise took to scan and recover the NVM at boot
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vPdmTelemetryInit ( uint32    u32BootDurationUs )
+{
+    APP_vPdmTelemetryReset ( );
+    u32PdmTelemetryBootUs  =  u32BootDurationUs;
+    bPdmTelemetryInCommand =  FALSE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vPdmTelemetrySetCommandContext
+ *
+ * DESCRIPTION:
+ * Marks the span of a host command handler, saves made inside it are
+ * counted separately from saves made by the stack in the background
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vPdmTelemetrySetCommandContext ( bool_t    bInCommand )
+{
+    bPdmTelemetryInCommand =  bInCommand;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vPdmTelemetrySend
+ *
+ * DESCRIPTION:
+ * Sends the summary, the per-segment wear counts and the per-record save
+ * counts as E_SL_MSG_PDM_TELEMETRY frames, then optionally resets them
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vPdmTelemetrySend ( uint8    u8Options )
+{
+    uint8     au8Frame[PDM_TELEMETRY_LIST_HEADER_LENGTH + PDM_TELEMETRY_RECORDS_PER_FRAME * PDM_TELEMETRY_RECORD_LENGTH + 1];
+    uint16    u16Length =  0;
+    uint32    u32WearMin;
+    uint32    u32WearMax;
+    uint32    u32WearSum;
+    uint32    u32Wear;
+    uint32    u32Average =  0;
+    uint8     u8First;
+    uint8     u8Count;
+    uint8     i;
+
+    u32WearSum =  APP_u32PdmTelemetryWearSum ( &u32WearMin, &u32WearMax );
+    if ( sPdmTelemetryStats.u32Saves > 0 )
+    {
+        u32Average =  ( uint32 ) ( sPdmTelemetryStats.u64TotalDurationUs / sPdmTelemetryStats.u32Saves );
+    }
+
+    ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], PDM_TELEMETRY_SECTION_SUMMARY,          u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], PDM_TELEMETRY_VERSION,                  u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], sPdmTelemetryStats.u32Saves,            u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], sPdmTelemetryStats.u32SavesInCommand,   u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], sPdmTelemetryStats.u32SavesIdle,        u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], sPdmTelemetryStats.u32FailedSaves,      u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], sPdmTelemetryStats.u32Bytes,            u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], sPdmTelemetryStats.u32MinDurationUs,    u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], u32Average,                             u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], sPdmTelemetryStats.u32MaxDurationUs,    u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], u32WearSum - u32PdmTelemetryWearBase,   u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], u32WearSum,                             u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], u32WearMin,                             u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], u32WearMax,                             u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], PDM_NUM_SEGMENTS,                       u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], u8PdmTelemetryRecordCount,              u16Length );
+    ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], u32PdmTelemetryBootUs,                  u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], PDM_TELEMETRY_LATENCY_BUCKETS,          u16Length );
+    for ( i = 0; i < PDM_TELEMETRY_LATENCY_BUCKETS; i++ )
+    {
+        ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], sPdmTelemetryStats.au32Latency[i],  u16Length );
+    }
+    vSL_WriteMessage ( E_SL_MSG_PDM_TELEMETRY,
+                       u16Length,
+                       au8Frame,
+                       0 );
+
+    /* Wear count of every segment */
+    for ( u8First = 0; u8First < PDM_NUM_SEGMENTS; u8First += u8Count )
+    {
+        u8Count =  PDM_NUM_SEGMENTS - u8First;
+        if ( u8Count > PDM_TELEMETRY_SEGMENTS_PER_FRAME )
+        {
+            u8Count =  PDM_TELEMETRY_SEGMENTS_PER_FRAME;
+        }
+
+        u16Length =  0;
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], PDM_TELEMETRY_SECTION_WEAR,   u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], u8First,                      u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], u8Count,                      u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], PDM_NUM_SEGMENTS,             u16Length );
+        for ( i = 0; i < u8Count; i++ )
+        {
+            u32Wear =  0;
+            PDM_eGetSegmentWearCount ( u8First + i, &u32Wear );
+            ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], u32Wear,                  u16Length );
+        }
+        vSL_WriteMessage ( E_SL_MSG_PDM_TELEMETRY,
+                           u16Length,
+                           au8Frame,
+                           0 );
+    }
+
+    /* Saves per record ID, always at least one (possibly empty) frame */
+    u8First =  0;
+    do
+    {
+        u8Count =  u8PdmTelemetryRecordCount - u8First;
+        if ( u8Count > PDM_TELEMETRY_RECORDS_PER_FRAME )
+        {
+            u8Count =  PDM_TELEMETRY_RECORDS_PER_FRAME;
+        }
+
+        u16Length =  0;
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], PDM_TELEMETRY_SECTION_RECORDS,  u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], u8First,                        u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], u8Count,                        u16Length );
+        ZNC_BUF_U8_UPD  ( &au8Frame[ u16Length ], u8PdmTelemetryRecordCount,      u16Length );
+        for ( i = u8First; i < ( u8First + u8Count ); i++ )
+        {
+            ZNC_BUF_U16_UPD ( &au8Frame[ u16Length ], asPdmTelemetryRecords[i].u16RecordId,   u16Length );
+            ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], asPdmTelemetryRecords[i].u32Saves,      u16Length );
+            ZNC_BUF_U32_UPD ( &au8Frame[ u16Length ], asPdmTelemetryRecords[i].u32Bytes,      u16Length );
+        }
+        vSL_WriteMessage ( E_SL_MSG_PDM_TELEMETRY,
+                           u16Length,
+                           au8Frame,
+                           0 );
+        u8First +=  u8Count;
+    } while ( u8First < u8PdmTelemetryRecordCount );
+
+    if ( u8Options & PDM_TELEMETRY_OPTION_RESET )
+    {
+        APP_vPdmTelemetryReset ( );
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: __wrap_PDM_eSaveRecordData
+ *
+ * DESCRIPTION:
+ * Times and counts a save before handing the result back to the caller
+ *
+ * RETURNS:
+ * PDM_teStatus of the real save
+ *
+ ****************************************************************************/
+PUBLIC PDM_teStatus __wrap_PDM_eSaveRecordData ( uint16_t    u16IdValue,
+                                                 void*       pvDataBuffer,
+                                                 uint16_t    u16Datalength )
+{
+    tsPdmTelemetryRecord*    psRecord;
+    PDM_teStatus             eStatus;
+    uint64                   u64Start;
+    uint32                   u32Duration;
+
+    u64Start       =  TMR_GetTimestamp ( );
+    eStatus        =  __real_PDM_eSaveRecordData ( u16IdValue, pvDataBuffer, u16Datalength );
+    u32Duration    =  ( uint32 ) ( TMR_GetTimestamp ( ) - u64Start );
+
+    sPdmTelemetryStats.u32Saves++;
+    if ( bPdmTelemetryInCommand )
+    {
+        sPdmTelemetryStats.u32SavesInCommand++;
+    }
+    else
+    {
+        sPdmTelemetryStats.u32SavesIdle++;
+    }
+    if ( eStatus != PDM_E_STATUS_OK )
+    {
+        sPdmTelemetryStats.u32FailedSaves++;
+    }
+    sPdmTelemetryStats.u32Bytes              +=  u16Datalength;
+    sPdmTelemetryStats.u64TotalDurationUs    +=  u32Duration;
+    if ( ( sPdmTelemetryStats.u32Saves == 1 ) || ( u32Duration < sPdmTelemetryStats.u32MinDurationUs ) )
+    {
+        sPdmTelemetryStats.u32MinDurationUs =  u32Duration;
+    }
+    if ( u32Duration > sPdmTelemetryStats.u32MaxDurationUs )
+    {
+        sPdmTelemetryStats.u32MaxDurationUs =  u32Duration;
+    }
+    sPdmTelemetryStats.au32Latency[APP_u8PdmTelemetryLatencyBucket ( u32Duration )]++;
+
+    psRecord =  APP_psPdmTelemetryGetRecord ( u16IdValue );
+    psRecord->u32Saves++;
+    psRecord->u32Bytes +=  u16Datalength;
+
+    vLog_Printf ( TRACE_PDM_TELEMETRY, LOG_DEBUG, "PDM save 0x%04x %d bytes %d us status %d\n",
+                  u16IdValue, u16Datalength, u32Duration, eStatus );
+
+    return eStatus;
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_psPdmTelemetryGetRecord
+ *
+ * DESCRIPTION:
+ * Finds or allocates the counters of a record ID. Once the table is full
+ * new IDs are accounted in the last slot under PDM_TELEMETRY_OTHER_RECORD_ID
+ *
+ * RETURNS:
+ * Record counters, never NULL
+ *
+ ****************************************************************************/
+PRIVATE tsPdmTelemetryRecord* APP_psPdmTelemetryGetRecord ( uint16    u16RecordId )
+{
+    uint8    i;
+
+    for ( i = 0; i < u8PdmTelemetryRecordCount; i++ )
+    {
+        if ( asPdmTelemetryRecords[i].u16RecordId == u16RecordId )
+        {
+            return &asPdmTelemetryRecords[i];
+        }
+    }
+
+    if ( u8PdmTelemetryRecordCount < ( PDM_TELEMETRY_MAX_RECORDS - 1 ) )
+    {
+        asPdmTelemetryRecords[u8PdmTelemetryRecordCount].u16RecordId =  u16RecordId;
+        return &asPdmTelemetryRecords[u8PdmTelemetryRecordCount++];
+    }
+
+    if ( u8PdmTelemetryRecordCount < PDM_TELEMETRY_MAX_RECORDS )
+    {
+        asPdmTelemetryRecords[u8PdmTelemetryRecordCount++].u16RecordId =  PDM_TELEMETRY_OTHER_RECORD_ID;
+    }
+    return &asPdmTelemetryRecords[PDM_TELEMETRY_MAX_RECORDS - 1];
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8PdmTelemetryLatencyBucket
+ *
+ * DESCRIPTION:
+ * Histogram bucket of a save duration, bounds double from
+ * PDM_TELEMETRY_LATENCY_BASE_US
+ *
+ * RETURNS:
+ * Bucket index
+ *
+ ****************************************************************************/
+PRIVATE uint8 APP_u8PdmTelemetryLatencyBucket ( uint32    u32DurationUs )
+{
+    uint32    u32Bound =  PDM_TELEMETRY_LATENCY_BASE_US;
+    uint8     u8Bucket =  0;
+
+    while ( ( u32DurationUs >= u32Bound ) && ( u8Bucket < ( PDM_TELEMETRY_LATENCY_BUCKETS - 1 ) ) )
+    {
+        u32Bound <<=  1;
+        u8Bucket++;
+    }
+
+    return u8Bucket;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u32PdmTelemetryWearSum
+ *
+ * DESCRIPTION:
+ * Adds up the wear count of all segments, each one is an erase
+ *
+ * RETURNS:
+ * Sum of the segment wear counts
+ *
+ ****************************************************************************/
+PRIVATE uint32 APP_u32PdmTelemetryWearSum ( uint32*    pu32Min,
+                                            uint32*    pu32Max )
+{
+    uint32    u32Sum =  0;
+    uint32    u32Wear;
+    uint8     i;
+
+    *pu32Min =  0xFFFFFFFF;
+    *pu32Max =  0;
+    for ( i = 0; i < PDM_NUM_SEGMENTS; i++ )
+    {
+        u32Wear =  0;
+        PDM_eGetSegmentWearCount ( i, &u32Wear );
+        u32Sum +=  u32Wear;
+        if ( u32Wear < *pu32Min )
+        {
+            *pu32Min =  u32Wear;
+        }
+        if ( u32Wear > *pu32Max )
+        {
+            *pu32Max =  u32Wear;
+        }
+    }
+
+    return u32Sum;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vPdmTelemetryReset
+ *
+ * DESCRIPTION:
+ * Clears the save counters and restarts erase counting from now
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vPdmTelemetryReset ( void )
+{
+    uint32    u32Min;
+    uint32    u32Max;
+
+    memset ( asPdmTelemetryRecords, 0, sizeof ( asPdmTelemetryRecords ) );
+    memset ( &sPdmTelemetryStats,   0, sizeof ( sPdmTelemetryStats ) );
+    u8PdmTelemetryRecordCount =  0;
+    u32PdmTelemetryWearBase   =  APP_u32PdmTelemetryWearSum ( &u32Min, &u32Max );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,93 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_pdm_telemetry.h
+ *
+ * DESCRIPTION:        Flash wear and PDM save statistics reported to the
+ *                     host (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef APP_PDM_TELEMETRY_H_
+#define APP_PDM_TELEMETRY_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Number of distinct record IDs counted individually, the rest share one
+ * PDM_TELEMETRY_OTHER_RECORD_ID entry */
+#ifndef PDM_TELEMETRY_MAX_RECORDS
+#define PDM_TELEMETRY_MAX_RECORDS           32
+#endif
+
+/* Record entries and segment wear counts carried by one frame */
+#define PDM_TELEMETRY_RECORDS_PER_FRAME     16
+#define PDM_TELEMETRY_SEGMENTS_PER_FRAME    32
+
+/* Save duration histogram: bucket 0 holds saves under
+ * PDM_TELEMETRY_LATENCY_BASE_US, each next bucket doubles the bound and the
+ * last one takes everything slower (segment compaction and erase stalls) */
+#define PDM_TELEMETRY_LATENCY_BUCKETS       8
+#define PDM_TELEMETRY_LATENCY_BASE_US       250
+
+#define PDM_TELEMETRY_VERSION               2
+#define PDM_TELEMETRY_OTHER_RECORD_ID       0xFFFF
+
+/* First byte of every E_SL_MSG_PDM_TELEMETRY frame */
+#define PDM_TELEMETRY_SECTION_SUMMARY       0
+#define PDM_TELEMETRY_SECTION_WEAR          1
+#define PDM_TELEMETRY_SECTION_RECORDS       2
+
+/* E_SL_MSG_GET_PDM_TELEMETRY option bits */
+#define PDM_TELEMETRY_OPTION_RESET          0x01
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vPdmTelemetryInit ( uint32    u32BootDurationUs );
+PUBLIC void APP_vPdmTelemetrySetCommandContext ( bool_t    bInCommand );
+PUBLIC void APP_vPdmTelemetrySend ( uint8    u8Options );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_PDM_TELEMETRY_H_ */
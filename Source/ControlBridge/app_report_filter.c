@@ -0,0 +1,582 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_report_filter.c
+ *
+ * DESCRIPTION:        Deduplication and rate limiting of attribute reports
+ *                     forwarded to the host (Implementation)
+ *
+ *                     Some devices report the same attribute several times a
+ *                     second. The host installs rules that match reports by
+ *                     device, endpoint, cluster and attribute (any of them
+ *                     may be a wildcard); the first matching rule decides:
+ *                      - a value identical to the last one forwarded is
+ *                        dropped until both the duplicate window and the
+ *                        minimum interval have passed,
+ *                      - within the minimum interval a new value is only
+ *                        forwarded if it moved by more than the threshold;
+ *                        the latest value held back is sent when the
+ *                        interval is over.
+ *                     The threshold applies to integers of up to 64 bits
+ *                     only; any change of a boolean, bitmap, enum, float or
+ *                     string is forwarded straight away. Reports that match
+ *                     no rule are forwarded untouched. Rules live in RAM and
+ *                     are lost on reset.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "dbg.h"
+#include "zcl.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_report_filter.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_REPORT_FILTER
+#define TRACE_REPORT_FILTER           TRUE
+#else
+#define TRACE_REPORT_FILTER           FALSE
+#endif
+
+#define REPORT_FILTER_FNV_OFFSET      0x811C9DC5UL
+#define REPORT_FILTER_FNV_PRIME       0x01000193UL
+
+/* Integers up to 64 bits are compared against the threshold */
+#define REPORT_FILTER_MAX_VALUE       8
+
+/* Sequence number, address, endpoint, cluster, attribute, status, type and
+ * size in front of the value of an 0x8102 message */
+#define REPORT_FILTER_HEADER_LENGTH   12
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    bool_t    bInUse;
+    uint16    u16Addr;
+    uint8     u8Endpoint;
+    uint16    u16ClusterId;
+    uint16    u16AttributeId;
+    uint16    u16DuplicateWindow;     /* 100ms ticks */
+    uint16    u16MinInterval;         /* 100ms ticks */
+    uint32    u32Threshold;
+} tsReportFilterRule;
+
+typedef struct
+{
+    bool_t    bInUse;
+    uint16    u16Addr;
+    uint8     u8Endpoint;
+    uint16    u16ClusterId;
+    uint16    u16AttributeId;
+    uint32    u32Hash;
+    int64     i64Value;
+    uint32    u32LastForward;
+    uint32    u32LastSeen;
+    /* Latest changed value held back by the minimum interval */
+    bool_t    bPending;
+    uint8     u8PendingSeqNum;
+    uint8     u8PendingLinkQuality;
+    uint8     u8PendingDataType;
+    uint8     u8PendingLength;
+    uint8     au8PendingValue[REPORT_FILTER_MAX_VALUE];
+    uint32    u32PendingHash;
+    int64     i64PendingValue;
+} tsReportFilterEntry;
+
+typedef struct
+{
+    uint32    u32Received;
+    uint32    u32Forwarded;
+    uint32    u32SuppressedDuplicate;
+    uint32    u32SuppressedRate;
+    uint32    u32ForwardedOnChange;
+    uint32    u32Evicted;
+    uint32    u32Flushed;
+} tsReportFilterStats;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE tsReportFilterRule* APP_psReportFilterFindRule ( uint16    u16Addr,
+                                                         uint8     u8Endpoint,
+                                                         uint16    u16ClusterId,
+                                                         uint16    u16AttributeId );
+PRIVATE tsReportFilterEntry* APP_psReportFilterFindEntry ( uint16    u16Addr,
+                                                           uint8     u8Endpoint,
+                                                           uint16    u16ClusterId,
+                                                           uint16    u16AttributeId );
+PRIVATE bool_t APP_bReportFilterIsInteger ( uint8     u8DataType,
+                                            bool_t*   pbSigned );
+PRIVATE void APP_vReportFilterFlush ( tsReportFilterEntry*    psEntry );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsReportFilterRule     asReportFilterRules[REPORT_FILTER_MAX_RULES];
+PRIVATE tsReportFilterEntry    asReportFilterEntries[REPORT_FILTER_MAX_TRACKED];
+PRIVATE tsReportFilterStats    sReportFilterStats;
+PRIVATE uint32                 u32ReportFilterTicks;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vReportFilterInit
+ *
+ * DESCRIPTION:
+ * Removes all rules, remembered values and counters
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vReportFilterInit ( void )
+{
+    memset ( asReportFilterRules,   0, sizeof ( asReportFilterRules ) );
+    memset ( asReportFilterEntries, 0, sizeof ( asReportFilterEntries ) );
+    memset ( &sReportFilterStats,   0, sizeof ( sReportFilterStats ) );
+    u32ReportFilterTicks =  0;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vReportFilterTick
+ *
+ * DESCRIPTION:
+ * 100ms time base for the duplicate window and minimum interval. A changed
+ * value held back by the minimum interval is sent once the interval is over
+ * so the host always ends up with the latest value.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vReportFilterTick ( void )
+{
+    tsReportFilterEntry*    psEntry;
+    tsReportFilterRule*     psRule;
+    uint8                   i;
+
+    u32ReportFilterTicks++;
+
+    for ( i = 0; i < REPORT_FILTER_MAX_TRACKED; i++ )
+    {
+        psEntry =  &asReportFilterEntries[i];
+        if ( !psEntry->bInUse || !psEntry->bPending )
+        {
+            continue;
+        }
+        psRule =  APP_psReportFilterFindRule ( psEntry->u16Addr,
+                                               psEntry->u8Endpoint,
+                                               psEntry->u16ClusterId,
+                                               psEntry->u16AttributeId );
+        if ( ( psRule == NULL ) ||
+             ( ( u32ReportFilterTicks - psEntry->u32LastForward ) >= psRule->u16MinInterval ) )
+        {
+            APP_vReportFilterFlush ( psEntry );
+        }
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bReportFilterForward
+ *
+ * DESCRIPTION:
+ * Decides whether an attribute report should go to the host. pu8Value is
+ * the value as encoded in the 0x8102 message (big endian); the sequence
+ * number and link quality are kept to send a held back value later.
+ *
+ * RETURNS:
+ * TRUE if the report should be forwarded
+ *
+ ****************************************************************************/
+PUBLIC bool_t APP_bReportFilterForward ( uint8     u8SeqNum,
+                                         uint16    u16Addr,
+                                         uint8     u8Endpoint,
+                                         uint16    u16ClusterId,
+                                         uint16    u16AttributeId,
+                                         uint8     u8DataType,
+                                         uint8*    pu8Value,
+                                         uint16    u16ValueLength,
+                                         uint8     u8LinkQuality )
+{
+    tsReportFilterRule*     psRule;
+    tsReportFilterEntry*    psEntry;
+    uint32                  u32Hash  =  REPORT_FILTER_FNV_OFFSET;
+    uint64                  u64Value =  0;
+    int64                   i64Value =  0;
+    uint32                  u32Since;
+    uint64                  u64Delta;
+    bool_t                  bSigned  =  FALSE;
+    bool_t                  bInteger;
+    uint16                  i;
+
+    sReportFilterStats.u32Received++;
+
+    psRule =  APP_psReportFilterFindRule ( u16Addr, u8Endpoint, u16ClusterId, u16AttributeId );
+    if ( psRule == NULL )
+    {
+        sReportFilterStats.u32Forwarded++;
+        return TRUE;
+    }
+
+    u32Hash  =  ( u32Hash ^ u8DataType ) * REPORT_FILTER_FNV_PRIME;
+    for ( i = 0; i < u16ValueLength; i++ )
+    {
+        u32Hash  =  ( u32Hash ^ pu8Value[i] ) * REPORT_FILTER_FNV_PRIME;
+    }
+
+    /* Only integers that fit 64 bits have a value to compare; anything else
+     * is matched on its hash alone */
+    bInteger =  APP_bReportFilterIsInteger ( u8DataType, &bSigned ) &&
+                ( u16ValueLength > 0 ) && ( u16ValueLength <= REPORT_FILTER_MAX_VALUE );
+    if ( bInteger )
+    {
+        for ( i = 0; i < u16ValueLength; i++ )
+        {
+            u64Value =  ( u64Value << 8 ) | pu8Value[i];
+        }
+        if ( bSigned && ( u16ValueLength < REPORT_FILTER_MAX_VALUE ) && ( pu8Value[0] & 0x80 ) )
+        {
+            /* Sign extend */
+            u64Value |=  ~( uint64 ) 0 << ( u16ValueLength * 8 );
+        }
+        i64Value =  ( int64 ) u64Value;
+    }
+
+    psEntry =  APP_psReportFilterFindEntry ( u16Addr, u8Endpoint, u16ClusterId, u16AttributeId );
+    if ( psEntry->bInUse )
+    {
+        u32Since =  u32ReportFilterTicks - psEntry->u32LastForward;
+        psEntry->u32LastSeen =  u32ReportFilterTicks;
+
+        if ( psEntry->u32Hash == u32Hash )
+        {
+            if ( ( u32Since < psRule->u16DuplicateWindow ) ||
+                 ( u32Since < psRule->u16MinInterval ) )
+            {
+                /* Back to what the host has, nothing left to send */
+                psEntry->bPending =  FALSE;
+                sReportFilterStats.u32SuppressedDuplicate++;
+                return FALSE;
+            }
+        }
+        else if ( u32Since < psRule->u16MinInterval )
+        {
+            /* Signed values compare as signed, unsigned ones as unsigned */
+            if ( bSigned )
+            {
+                u64Delta =  ( i64Value > psEntry->i64Value ) ? ( uint64 ) i64Value - ( uint64 ) psEntry->i64Value :
+                                                               ( uint64 ) psEntry->i64Value - ( uint64 ) i64Value;
+            }
+            else
+            {
+                u64Delta =  ( u64Value > ( uint64 ) psEntry->i64Value ) ? u64Value - ( uint64 ) psEntry->i64Value :
+                                                                          ( uint64 ) psEntry->i64Value - u64Value;
+            }
+            if ( bInteger && ( u64Delta <= psRule->u32Threshold ) )
+            {
+                /* Held back until the interval is over */
+                psEntry->bPending               =  TRUE;
+                psEntry->u8PendingSeqNum        =  u8SeqNum;
+                psEntry->u8PendingLinkQuality   =  u8LinkQuality;
+                psEntry->u8PendingDataType      =  u8DataType;
+                psEntry->u8PendingLength        =  ( uint8 ) u16ValueLength;
+                psEntry->u32PendingHash         =  u32Hash;
+                psEntry->i64PendingValue        =  i64Value;
+                memcpy ( psEntry->au8PendingValue, pu8Value, u16ValueLength );
+                sReportFilterStats.u32SuppressedRate++;
+                return FALSE;
+            }
+            sReportFilterStats.u32ForwardedOnChange++;
+        }
+    }
+    else
+    {
+        psEntry->bInUse            =  TRUE;
+        psEntry->u16Addr           =  u16Addr;
+        psEntry->u8Endpoint        =  u8Endpoint;
+        psEntry->u16ClusterId      =  u16ClusterId;
+        psEntry->u16AttributeId    =  u16AttributeId;
+        psEntry->u32LastSeen       =  u32ReportFilterTicks;
+    }
+
+    psEntry->u32Hash           =  u32Hash;
+    psEntry->i64Value          =  i64Value;
+    psEntry->u32LastForward    =  u32ReportFilterTicks;
+    psEntry->bPending          =  FALSE;
+    sReportFilterStats.u32Forwarded++;
+
+    return TRUE;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u8ReportFilterSetRule
+ *
+ * DESCRIPTION:
+ * Handles E_SL_MSG_REPORT_FILTER_SET_RULE:
+ *   u8Index, u16Addr, u8Endpoint, u16ClusterId, u16AttributeId,
+ *   u16DuplicateWindow, u16MinInterval (100ms units), u32Threshold
+ * A rule with both times 0 removes the rule at u8Index; u8Index 0xFF
+ * removes every rule. Rules are matched in index order.
+ *
+ * RETURNS:
+ * Serial link status
+ *
+ ****************************************************************************/
+PUBLIC uint8 APP_u8ReportFilterSetRule ( uint8*    pu8Payload,
+                                         uint16    u16PayloadLength )
+{
+    tsReportFilterRule*    psRule;
+    uint8                  u8Index;
+
+    if ( u16PayloadLength < 1 )
+    {
+        return E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+    }
+
+    u8Index =  pu8Payload[0];
+    if ( u8Index == REPORT_FILTER_CLEAR_ALL )
+    {
+        APP_vReportFilterInit ( );
+        return E_SL_MSG_STATUS_SUCCESS;
+    }
+
+    if ( ( u8Index >= REPORT_FILTER_MAX_RULES ) ||
+         ( u16PayloadLength < REPORT_FILTER_RULE_LENGTH ) )
+    {
+        return E_SL_MSG_STATUS_INCORRECT_PARAMETERS;
+    }
+
+    psRule =  &asReportFilterRules[u8Index];
+    psRule->u16Addr               =  ZNC_RTN_U16 ( pu8Payload, 1 );
+    psRule->u8Endpoint            =  pu8Payload[3];
+    psRule->u16ClusterId          =  ZNC_RTN_U16 ( pu8Payload, 4 );
+    psRule->u16AttributeId        =  ZNC_RTN_U16 ( pu8Payload, 6 );
+    psRule->u16DuplicateWindow    =  ZNC_RTN_U16 ( pu8Payload, 8 );
+    psRule->u16MinInterval        =  ZNC_RTN_U16 ( pu8Payload, 10 );
+    psRule->u32Threshold          =  ZNC_RTN_U32 ( pu8Payload, 12 );
+    psRule->bInUse                =  ( psRule->u16DuplicateWindow != 0 ) ||
+                                     ( psRule->u16MinInterval != 0 );
+
+    /* Remembered values may now fall under different rules */
+    memset ( asReportFilterEntries, 0, sizeof ( asReportFilterEntries ) );
+
+    vLog_Printf ( TRACE_REPORT_FILTER, LOG_DEBUG, "\nReport filter rule %d %s", u8Index,
+                  psRule->bInUse ? "set" : "removed" );
+
+    return E_SL_MSG_STATUS_SUCCESS;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u16ReportFilterGetStats
+ *
+ * DESCRIPTION:
+ * Writes the E_SL_MSG_REPORT_FILTER_STATS payload: number of active rules,
+ * number of tracked values, then the received, forwarded, duplicate
+ * suppressed, rate suppressed, forwarded on change, evicted and flushed
+ * counters
+ *
+ * RETURNS:
+ * Number of bytes written
+ *
+ ****************************************************************************/
+PUBLIC uint16 APP_u16ReportFilterGetStats ( uint8*    pu8Buffer,
+                                            bool_t    bReset )
+{
+    uint16    u16Length  =  0;
+    uint8     u8Rules    =  0;
+    uint8     u8Tracked  =  0;
+    uint8     i;
+
+    for ( i = 0; i < REPORT_FILTER_MAX_RULES; i++ )
+    {
+        u8Rules +=  asReportFilterRules[i].bInUse ? 1 : 0;
+    }
+    for ( i = 0; i < REPORT_FILTER_MAX_TRACKED; i++ )
+    {
+        u8Tracked +=  asReportFilterEntries[i].bInUse ? 1 : 0;
+    }
+
+    ZNC_BUF_U8_UPD  ( &pu8Buffer[u16Length], u8Rules,                                      u16Length );
+    ZNC_BUF_U8_UPD  ( &pu8Buffer[u16Length], u8Tracked,                                    u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sReportFilterStats.u32Received,               u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sReportFilterStats.u32Forwarded,              u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sReportFilterStats.u32SuppressedDuplicate,    u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sReportFilterStats.u32SuppressedRate,         u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sReportFilterStats.u32ForwardedOnChange,      u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sReportFilterStats.u32Evicted,                u16Length );
+    ZNC_BUF_U32_UPD ( &pu8Buffer[u16Length], sReportFilterStats.u32Flushed,                u16Length );
+
+    if ( bReset )
+    {
+        memset ( &sReportFilterStats, 0, sizeof ( sReportFilterStats ) );
+    }
+
+    return u16Length;
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE tsReportFilterRule* APP_psReportFilterFindRule ( uint16    u16Addr,
+                                                         uint8     u8Endpoint,
+                                                         uint16    u16ClusterId,
+                                                         uint16    u16AttributeId )
+{
+    tsReportFilterRule*    psRule;
+    uint8                  i;
+
+    for ( i = 0; i < REPORT_FILTER_MAX_RULES; i++ )
+    {
+        psRule =  &asReportFilterRules[i];
+        if ( psRule->bInUse &&
+             ( ( psRule->u16Addr        == REPORT_FILTER_ANY_ADDR )      || ( psRule->u16Addr        == u16Addr ) ) &&
+             ( ( psRule->u8Endpoint     == REPORT_FILTER_ANY_ENDPOINT )  || ( psRule->u8Endpoint     == u8Endpoint ) ) &&
+             ( ( psRule->u16ClusterId   == REPORT_FILTER_ANY_CLUSTER )   || ( psRule->u16ClusterId   == u16ClusterId ) ) &&
+             ( ( psRule->u16AttributeId == REPORT_FILTER_ANY_ATTRIBUTE ) || ( psRule->u16AttributeId == u16AttributeId ) ) )
+        {
+            return psRule;
+        }
+    }
+    return NULL;
+}
+
+/* Entry tracking this attribute; if there is none, a free entry or the one
+ * seen least recently, which is then marked unused */
+PRIVATE tsReportFilterEntry* APP_psReportFilterFindEntry ( uint16    u16Addr,
+                                                           uint8     u8Endpoint,
+                                                           uint16    u16ClusterId,
+                                                           uint16    u16AttributeId )
+{
+    tsReportFilterEntry*    psEntry;
+    tsReportFilterEntry*    psVictim =  &asReportFilterEntries[0];
+    uint8                   i;
+
+    for ( i = 0; i < REPORT_FILTER_MAX_TRACKED; i++ )
+    {
+        psEntry =  &asReportFilterEntries[i];
+        if ( !psEntry->bInUse )
+        {
+            if ( psVictim->bInUse )
+            {
+                psVictim =  psEntry;
+            }
+            continue;
+        }
+        if ( ( psEntry->u16Addr == u16Addr ) &&
+             ( psEntry->u8Endpoint == u8Endpoint ) &&
+             ( psEntry->u16ClusterId == u16ClusterId ) &&
+             ( psEntry->u16AttributeId == u16AttributeId ) )
+        {
+            return psEntry;
+        }
+        if ( psVictim->bInUse &&
+             ( ( u32ReportFilterTicks - psEntry->u32LastSeen ) > ( u32ReportFilterTicks - psVictim->u32LastSeen ) ) )
+        {
+            psVictim =  psEntry;
+        }
+    }
+
+    if ( psVictim->bInUse )
+    {
+        sReportFilterStats.u32Evicted++;
+        psVictim->bInUse =  FALSE;
+    }
+    return psVictim;
+}
+
+PRIVATE bool_t APP_bReportFilterIsInteger ( uint8     u8DataType,
+                                            bool_t*   pbSigned )
+{
+    if ( ( u8DataType >= E_ZCL_UINT8 ) && ( u8DataType <= E_ZCL_UINT64 ) )
+    {
+        *pbSigned =  FALSE;
+        return TRUE;
+    }
+    if ( ( u8DataType >= E_ZCL_INT8 ) && ( u8DataType <= E_ZCL_INT64 ) )
+    {
+        *pbSigned =  TRUE;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* Sends the held back value as the 0x8102 message it was suppressed from */
+PRIVATE void APP_vReportFilterFlush ( tsReportFilterEntry*    psEntry )
+{
+    uint8     au8Message[REPORT_FILTER_HEADER_LENGTH + REPORT_FILTER_MAX_VALUE + 1];
+    uint16    u16Length =  0;
+
+    ZNC_BUF_U8_UPD  ( &au8Message[u16Length], psEntry->u8PendingSeqNum,      u16Length );
+    ZNC_BUF_U16_UPD ( &au8Message[u16Length], psEntry->u16Addr,              u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Message[u16Length], psEntry->u8Endpoint,           u16Length );
+    ZNC_BUF_U16_UPD ( &au8Message[u16Length], psEntry->u16ClusterId,         u16Length );
+    ZNC_BUF_U16_UPD ( &au8Message[u16Length], psEntry->u16AttributeId,       u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Message[u16Length], E_ZCL_CMDS_SUCCESS,            u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Message[u16Length], psEntry->u8PendingDataType,    u16Length );
+    ZNC_BUF_U16_UPD ( &au8Message[u16Length], psEntry->u8PendingLength,      u16Length );
+    memcpy ( &au8Message[u16Length], psEntry->au8PendingValue, psEntry->u8PendingLength );
+    u16Length +=  psEntry->u8PendingLength;
+
+    vSL_WriteMessage ( E_SL_MSG_REPORT_IND_ATTR_RESPONSE,
+                       u16Length,
+                       au8Message,
+                       psEntry->u8PendingLinkQuality );
+
+    psEntry->u32Hash           =  psEntry->u32PendingHash;
+    psEntry->i64Value          =  psEntry->i64PendingValue;
+    psEntry->u32LastForward    =  u32ReportFilterTicks;
+    psEntry->bPending          =  FALSE;
+    sReportFilterStats.u32Forwarded++;
+    sReportFilterStats.u32Flushed++;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
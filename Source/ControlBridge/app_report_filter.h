@@ -0,0 +1,100 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_report_filter.h
+ *
+ * DESCRIPTION:        Deduplication and rate limiting of attribute reports
+ *                     forwarded to the host (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef APP_REPORT_FILTER_H_
+#define APP_REPORT_FILTER_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Number of filter rules the host can install */
+#ifndef REPORT_FILTER_MAX_RULES
+#define REPORT_FILTER_MAX_RULES         8
+#endif
+
+/* Number of (device, endpoint, cluster, attribute) values remembered */
+#ifndef REPORT_FILTER_MAX_TRACKED
+#define REPORT_FILTER_MAX_TRACKED       32
+#endif
+
+/* Rule field values that match anything */
+#define REPORT_FILTER_ANY_ADDR          0xFFFF
+#define REPORT_FILTER_ANY_ENDPOINT      0xFF
+#define REPORT_FILTER_ANY_CLUSTER       0xFFFF
+#define REPORT_FILTER_ANY_ATTRIBUTE     0xFFFF
+
+/* Rule index that clears the whole rule table */
+#define REPORT_FILTER_CLEAR_ALL         0xFF
+
+/* Length of the E_SL_MSG_REPORT_FILTER_SET_RULE payload */
+#define REPORT_FILTER_RULE_LENGTH       16
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vReportFilterInit ( void );
+PUBLIC void APP_vReportFilterTick ( void );
+PUBLIC bool_t APP_bReportFilterForward ( uint8     u8SeqNum,
+                                         uint16    u16Addr,
+                                         uint8     u8Endpoint,
+                                         uint16    u16ClusterId,
+                                         uint16    u16AttributeId,
+                                         uint8     u8DataType,
+                                         uint8*    pu8Value,
+                                         uint16    u16ValueLength,
+                                         uint8     u8LinkQuality );
+PUBLIC uint8 APP_u8ReportFilterSetRule ( uint8*    pu8Payload,
+                                         uint16    u16PayloadLength );
+PUBLIC uint16 APP_u16ReportFilterGetStats ( uint8*    pu8Buffer,
+                                            bool_t    bReset );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_REPORT_FILTER_H_ */
@@ -0,0 +1,266 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_seclib_benchmark.c
+ *
+ * DESCRIPTION:        SecLib AES known answer test and throughput
+ *                     measurement (Implementation)
+ *
+ *                     Measures the AES backend selected with
+ *                     SECLIB_AES_BACKEND. When SecLib is built with run time
+ *                     HW/SW selection (DYN and SW backends), the software
+ *                     path is measured too and both outputs are compared.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "SecLib.h"
+#include "TimersManager.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_seclib_benchmark.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_SECLIB_BENCHMARK
+#define TRACE_SECLIB_BENCHMARK          TRUE
+#else
+#define TRACE_SECLIB_BENCHMARK          FALSE
+#endif
+
+#define SECLIB_BENCHMARK_NONCE_LENGTH   13
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint32    u32BlockUs;
+    uint32    u32FrameUs;
+    uint8     au8Block[AES_BLOCK_SIZE];
+    uint8     au8Frame[SECLIB_BENCHMARK_FRAME_LENGTH];
+    uint8     au8Mic[SECLIB_BENCHMARK_MIC_LENGTH];
+    bool_t    bRoundTrip;
+} tsSecLibBenchmarkRun;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE void APP_vSecLibBenchmarkMeasure ( uint16                   u16Iterations,
+                                           tsSecLibBenchmarkRun*    psRun );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+/* FIPS-197 appendix C.1 AES-128 vector */
+PRIVATE const uint8 au8SecLibKatKey[AES_BLOCK_SIZE] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+PRIVATE const uint8 au8SecLibKatPlain[AES_BLOCK_SIZE] =
+{
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+PRIVATE const uint8 au8SecLibKatCipher[AES_BLOCK_SIZE] =
+{
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+    0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+
+PRIVATE tsSecLibBenchmarkRun    asSecLibBenchmarkRun[2];
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vSecLibBenchmarkRun
+ *
+ * DESCRIPTION:
+ * Runs the known answer test, times u16Iterations AES blocks and CCM
+ * frames on each available backend and sends
+ * E_SL_MSG_SECLIB_BENCHMARK_RESULT: result bits, iterations, frame length,
+ * then block and frame totals in us for the selected backend and for the
+ * software backend (0 when it can't be selected at run time)
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vSecLibBenchmarkRun ( uint16    u16Iterations )
+{
+    uint8     au8Buffer[4 + 4 * sizeof ( uint32 ) + 1];
+    uint16    u16Length =  0;
+    uint8     u8Result  =  0;
+#if (gSecLibAESMethodSelectionDynHwSw_c > 0)
+    bool_t    bHwDisabled;
+#endif
+
+    if ( ( u16Iterations == 0 ) || ( u16Iterations > SECLIB_BENCHMARK_MAX_ITERATIONS ) )
+    {
+        u16Iterations =  ( u16Iterations == 0 ) ? SECLIB_BENCHMARK_DEFAULT_ITERATIONS : SECLIB_BENCHMARK_MAX_ITERATIONS;
+    }
+    memset ( asSecLibBenchmarkRun, 0, sizeof ( asSecLibBenchmarkRun ) );
+
+    APP_vSecLibBenchmarkMeasure ( u16Iterations, &asSecLibBenchmarkRun[0] );
+    if ( 0 == memcmp ( asSecLibBenchmarkRun[0].au8Block, au8SecLibKatCipher, AES_BLOCK_SIZE ) )
+    {
+        u8Result |=  SECLIB_BENCHMARK_KAT_PASSED;
+    }
+    if ( asSecLibBenchmarkRun[0].bRoundTrip )
+    {
+        u8Result |=  SECLIB_BENCHMARK_CCM_ROUND_TRIP_PASSED;
+    }
+
+#if (gSecLibAESMethodSelectionDynHwSw_c > 0)
+    bHwDisabled =  SecLib_AES_Is_HW_Accelerator_disabled ( );
+    if ( bHwDisabled )
+    {
+        u8Result |=  SECLIB_BENCHMARK_HW_DISABLED;
+    }
+    /* Same work again on the software path, then restore the selection */
+    SecLib_AES_HW_Accelerator_disable ( TRUE );
+    APP_vSecLibBenchmarkMeasure ( u16Iterations, &asSecLibBenchmarkRun[1] );
+    SecLib_AES_HW_Accelerator_disable ( bHwDisabled );
+
+    u8Result |=  SECLIB_BENCHMARK_SW_MEASURED;
+    if ( ( 0 == memcmp ( asSecLibBenchmarkRun[0].au8Block, asSecLibBenchmarkRun[1].au8Block, AES_BLOCK_SIZE ) ) &&
+         ( 0 == memcmp ( asSecLibBenchmarkRun[0].au8Frame, asSecLibBenchmarkRun[1].au8Frame, SECLIB_BENCHMARK_FRAME_LENGTH ) ) &&
+         ( 0 == memcmp ( asSecLibBenchmarkRun[0].au8Mic,   asSecLibBenchmarkRun[1].au8Mic,   SECLIB_BENCHMARK_MIC_LENGTH ) ) &&
+         ( asSecLibBenchmarkRun[1].bRoundTrip ) )
+    {
+        u8Result |=  SECLIB_BENCHMARK_BACKENDS_AGREE;
+    }
+#endif
+
+    vLog_Printf ( TRACE_SECLIB_BENCHMARK, LOG_DEBUG, "\nSecLib benchmark 0x%02x x%d: block %d/%d us frame %d/%d us",
+                  u8Result, u16Iterations,
+                  asSecLibBenchmarkRun[0].u32BlockUs, asSecLibBenchmarkRun[1].u32BlockUs,
+                  asSecLibBenchmarkRun[0].u32FrameUs, asSecLibBenchmarkRun[1].u32FrameUs );
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Result,                             u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], u16Iterations,                        u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], SECLIB_BENCHMARK_FRAME_LENGTH,        u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], asSecLibBenchmarkRun[0].u32BlockUs,   u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], asSecLibBenchmarkRun[0].u32FrameUs,   u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], asSecLibBenchmarkRun[1].u32BlockUs,   u16Length );
+    ZNC_BUF_U32_UPD ( &au8Buffer[ u16Length ], asSecLibBenchmarkRun[1].u32FrameUs,   u16Length );
+    vSL_WriteMessage ( E_SL_MSG_SECLIB_BENCHMARK_RESULT,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vSecLibBenchmarkMeasure
+ *
+ * DESCRIPTION:
+ * Times single block encryption and CCM encryption of a frame on the AES
+ * path currently selected, keeps the last outputs for comparison and checks
+ * that the frame decrypts and authenticates
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vSecLibBenchmarkMeasure ( uint16                   u16Iterations,
+                                           tsSecLibBenchmarkRun*    psRun )
+{
+    uint8     au8Plain[SECLIB_BENCHMARK_FRAME_LENGTH];
+    uint8     au8Decrypted[SECLIB_BENCHMARK_FRAME_LENGTH];
+    uint8     au8Auth[SECLIB_BENCHMARK_AUTH_LENGTH];
+    uint8     au8Nonce[SECLIB_BENCHMARK_NONCE_LENGTH];
+    uint8     au8Mic[SECLIB_BENCHMARK_MIC_LENGTH];
+    uint64    u64Start;
+    uint16    i;
+
+    for ( i = 0; i < SECLIB_BENCHMARK_FRAME_LENGTH; i++ )
+    {
+        au8Plain[i] =  ( uint8 ) i;
+    }
+    for ( i = 0; i < SECLIB_BENCHMARK_AUTH_LENGTH; i++ )
+    {
+        au8Auth[i] =  ( uint8 ) ( 0xA0 + i );
+    }
+    for ( i = 0; i < SECLIB_BENCHMARK_NONCE_LENGTH; i++ )
+    {
+        au8Nonce[i] =  ( uint8 ) ( 0x10 + i );
+    }
+
+    u64Start =  TMR_GetTimestamp ( );
+    for ( i = 0; i < u16Iterations; i++ )
+    {
+        AES_128_Encrypt ( au8SecLibKatPlain, au8SecLibKatKey, psRun->au8Block );
+    }
+    psRun->u32BlockUs =  ( uint32 ) ( TMR_GetTimestamp ( ) - u64Start );
+
+    u64Start =  TMR_GetTimestamp ( );
+    for ( i = 0; i < u16Iterations; i++ )
+    {
+        AES_128_CCM ( au8Plain, SECLIB_BENCHMARK_FRAME_LENGTH,
+                      au8Auth,  SECLIB_BENCHMARK_AUTH_LENGTH,
+                      au8Nonce, SECLIB_BENCHMARK_NONCE_LENGTH,
+                      au8SecLibKatKey,
+                      psRun->au8Frame,
+                      psRun->au8Mic, SECLIB_BENCHMARK_MIC_LENGTH,
+                      gSecLib_CCM_Encrypt_c );
+    }
+    psRun->u32FrameUs =  ( uint32 ) ( TMR_GetTimestamp ( ) - u64Start );
+
+    memcpy ( au8Mic, psRun->au8Mic, SECLIB_BENCHMARK_MIC_LENGTH );
+    psRun->bRoundTrip =  ( 0 == AES_128_CCM ( psRun->au8Frame, SECLIB_BENCHMARK_FRAME_LENGTH,
+                                              au8Auth,  SECLIB_BENCHMARK_AUTH_LENGTH,
+                                              au8Nonce, SECLIB_BENCHMARK_NONCE_LENGTH,
+                                              au8SecLibKatKey,
+                                              au8Decrypted,
+                                              au8Mic, SECLIB_BENCHMARK_MIC_LENGTH,
+                                              gSecLib_CCM_Decrypt_c ) ) &&
+                         ( 0 == memcmp ( au8Decrypted, au8Plain, SECLIB_BENCHMARK_FRAME_LENGTH ) );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,81 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_seclib_benchmark.h
+ *
+ * DESCRIPTION:        SecLib AES known answer test and throughput
+ *                     measurement (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef APP_SECLIB_BENCHMARK_H_
+#define APP_SECLIB_BENCHMARK_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define SECLIB_BENCHMARK_DEFAULT_ITERATIONS     100
+/* Bounded so that a run stays well inside the watchdog period */
+#define SECLIB_BENCHMARK_MAX_ITERATIONS         500
+
+/* Frame encrypted by the CCM measurement: NWK header as authenticated data,
+ * a typical APS payload and a 32 bit MIC as used by the NWK layer */
+#define SECLIB_BENCHMARK_FRAME_LENGTH           64
+#define SECLIB_BENCHMARK_AUTH_LENGTH            16
+#define SECLIB_BENCHMARK_MIC_LENGTH             4
+
+/* E_SL_MSG_SECLIB_BENCHMARK_RESULT result bits */
+#define SECLIB_BENCHMARK_KAT_PASSED             0x01
+#define SECLIB_BENCHMARK_CCM_ROUND_TRIP_PASSED  0x02
+#define SECLIB_BENCHMARK_SW_MEASURED            0x04
+#define SECLIB_BENCHMARK_BACKENDS_AGREE         0x08
+#define SECLIB_BENCHMARK_HW_DISABLED            0x10
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vSecLibBenchmarkRun ( uint16    u16Iterations );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_SECLIB_BENCHMARK_H_ */
@@ -0,0 +1,628 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_stack_watermark.c
+ *
+ * DESCRIPTION:        Stack high-water telemetry per task and per handler
+ *                     (Implementation)
+ *
+ *                     The stack below the main loop is painted with a
+ *                     pattern a few words per pass of the loop. Each main
+ *                     loop task, and each host command and stack event
+ *                     within one, checks a few words below the lowest used
+ *                     word (the mark) as it returns, so a new mark is
+ *                     credited to the handler that set it and to the tasks
+ *                     around it. A sweep of the painted stack, again a few
+ *                     words per pass, catches use that skipped over the
+ *                     words checked; such peaks cannot be attributed. The
+ *                     stack is repainted every STACK_WATERMARK_REPAINT_TICKS
+ *                     so that handlers shallower than the deepest one are
+ *                     measured too.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stdint.h>
+#include <string.h>
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_stack_watermark.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_STACK_WATERMARK
+#define TRACE_STACK_WATERMARK           TRUE
+#else
+#define TRACE_STACK_WATERMARK           FALSE
+#endif
+
+#if defined ( __arm__ )
+#define STACK_WATERMARK_GET_SP( uSp )       __asm volatile ( "MRS %0, msp\n" : "=r" ( uSp ) )
+#else
+/* Host builds, near enough for the logic to be exercised */
+#define STACK_WATERMARK_GET_SP( uSp )       ( uSp ) =  ( uintptr_t ) &( uSp )
+#endif
+
+#define STACK_WATERMARK_PHASE_OFF           0
+#define STACK_WATERMARK_PHASE_REPAINT       1
+#define STACK_WATERMARK_PHASE_MEASURE       2
+
+#define STACK_WATERMARK_HANDLER_REPORT      7
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint16    u16Id;
+    uint8     u8Kind;
+} tsStackWatermarkContext;
+
+typedef struct
+{
+    uint16    u16Id;
+    uint16    u16Peak;
+    uint16    u16Marks;
+    uint8     u8Kind;
+} tsStackWatermarkHandler;
+
+typedef struct
+{
+    uint16    u16Peak;
+    uint16    u16PeakId;
+    uint16    u16Sweeps;
+    uint16    u16Repaints;
+    uint16    u16Unattributed;
+    uint8     u8PeakKind;
+    bool_t    bOverflow;
+} tsStackWatermarkStats;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE uint16 APP_u16StackWatermarkDepth ( uint32*    pu32Word );
+PRIVATE void APP_vStackWatermarkCredit ( uint16    u16Depth );
+PRIVATE void APP_vStackWatermarkRecord ( uint8     u8Kind,
+                                         uint16    u16Id,
+                                         uint16    u16Depth );
+PRIVATE void APP_vStackWatermarkRepaint ( void );
+PRIVATE void APP_vStackWatermarkRespond ( uint8    u8Operation,
+                                          uint8    u8Status );
+PRIVATE void APP_vStackWatermarkSendReport ( void );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Imported Variables                                            ***/
+/****************************************************************************/
+/* Linker script symbols bounding the stack */
+extern uint32    __StackLimit;
+extern uint32    _vStackTop;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE uint32*                    pu32StackWatermarkFloor;
+PRIVATE uint32*                    pu32StackWatermarkTop;
+/* Lowest word found used since the last repaint */
+PRIVATE uint32*                    pu32StackWatermarkMark;
+/* Next word to sweep upwards or, while repainting, last word painted */
+PRIVATE uint32*                    pu32StackWatermarkCursor;
+PRIVATE uint8                      u8StackWatermarkPhase =  STACK_WATERMARK_PHASE_OFF;
+PRIVATE uint16                     u16StackWatermarkTicks;
+PRIVATE tsStackWatermarkContext    asStackWatermarkContext[STACK_WATERMARK_NESTING];
+PRIVATE uint8                      u8StackWatermarkNesting;
+PRIVATE tsStackWatermarkHandler    asStackWatermarkHandler[STACK_WATERMARK_HANDLERS];
+PRIVATE tsStackWatermarkStats      sStackWatermarkStats;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vStackWatermarkInit
+ *
+ * DESCRIPTION:
+ * Bounds the stack from the linker script, painting starts on the first
+ * pass of the main loop
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vStackWatermarkInit ( void )
+{
+    pu32StackWatermarkFloor =  ( uint32* ) ( ( ( uintptr_t ) &__StackLimit + 3 ) & ~( uintptr_t ) 3 );
+    pu32StackWatermarkTop   =  ( uint32* ) ( ( uintptr_t ) &_vStackTop & ~( uintptr_t ) 3 );
+    memset ( &sStackWatermarkStats, 0, sizeof ( sStackWatermarkStats ) );
+    sStackWatermarkStats.u8PeakKind =  STACK_WATERMARK_KIND_NONE;
+    memset ( asStackWatermarkHandler, 0, sizeof ( asStackWatermarkHandler ) );
+    u8StackWatermarkNesting =  0;
+    APP_vStackWatermarkRepaint ( );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vStackWatermarkIdle
+ *
+ * DESCRIPTION:
+ * Called once per pass of the main loop, between tasks. Paints or sweeps
+ * STACK_WATERMARK_WORDS_PER_IDLE words.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vStackWatermarkIdle ( void )
+{
+    uintptr_t uSp;
+    uint8     i;
+
+    if ( u8StackWatermarkPhase == STACK_WATERMARK_PHASE_REPAINT )
+    {
+        if ( pu32StackWatermarkCursor == NULL )
+        {
+            /* Paint downwards from just below this frame, and only when it
+             * is on the stack measured: host builds run most callers on
+             * their own stack, below which lies memory that is not ours */
+            STACK_WATERMARK_GET_SP ( uSp );
+            if ( ( uSp <= ( uintptr_t ) pu32StackWatermarkFloor + STACK_WATERMARK_IDLE_MARGIN ) ||
+                 ( uSp > ( uintptr_t ) pu32StackWatermarkTop ) )
+            {
+                return;
+            }
+            pu32StackWatermarkCursor =  ( uint32* ) ( ( uSp - STACK_WATERMARK_IDLE_MARGIN ) & ~( uintptr_t ) 3 );
+            pu32StackWatermarkMark   =  pu32StackWatermarkCursor;
+        }
+        for ( i = 0; i < STACK_WATERMARK_WORDS_PER_IDLE; i++ )
+        {
+            if ( pu32StackWatermarkCursor <= pu32StackWatermarkFloor )
+            {
+                pu32StackWatermarkCursor =  pu32StackWatermarkFloor;
+                sStackWatermarkStats.u16Repaints++;
+                u8StackWatermarkPhase =  STACK_WATERMARK_PHASE_MEASURE;
+                break;
+            }
+            *--pu32StackWatermarkCursor =  STACK_WATERMARK_PATTERN;
+        }
+    }
+    else if ( u8StackWatermarkPhase == STACK_WATERMARK_PHASE_MEASURE )
+    {
+        for ( i = 0; i < STACK_WATERMARK_WORDS_PER_IDLE; i++ )
+        {
+            if ( pu32StackWatermarkCursor >= pu32StackWatermarkMark )
+            {
+                pu32StackWatermarkCursor =  pu32StackWatermarkFloor;
+                sStackWatermarkStats.u16Sweeps++;
+                break;
+            }
+            if ( *pu32StackWatermarkCursor != STACK_WATERMARK_PATTERN )
+            {
+                /* Used by whatever ran since the words were last checked */
+                pu32StackWatermarkMark =  pu32StackWatermarkCursor;
+                sStackWatermarkStats.u16Unattributed++;
+                if ( APP_u16StackWatermarkDepth ( pu32StackWatermarkMark ) > sStackWatermarkStats.u16Peak )
+                {
+                    sStackWatermarkStats.u16Peak    =  APP_u16StackWatermarkDepth ( pu32StackWatermarkMark );
+                    sStackWatermarkStats.u8PeakKind =  STACK_WATERMARK_KIND_NONE;
+                    sStackWatermarkStats.u16PeakId  =  0;
+                }
+                if ( pu32StackWatermarkCursor == pu32StackWatermarkFloor )
+                {
+                    sStackWatermarkStats.bOverflow =  TRUE;
+                }
+                pu32StackWatermarkCursor =  pu32StackWatermarkFloor;
+                break;
+            }
+            pu32StackWatermarkCursor++;
+        }
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vStackWatermarkTick
+ *
+ * DESCRIPTION:
+ * Called every 100ms, repaints the stack every STACK_WATERMARK_REPAINT_TICKS
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vStackWatermarkTick ( void )
+{
+    u16StackWatermarkTicks++;
+    if ( u16StackWatermarkTicks >= STACK_WATERMARK_REPAINT_TICKS )
+    {
+        APP_vStackWatermarkRepaint ( );
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vStackWatermarkEnter
+ *
+ * DESCRIPTION:
+ * Notes the task or handler about to run, paired with
+ * APP_vStackWatermarkExit. Handlers nest within tasks.
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vStackWatermarkEnter ( uint8     u8Kind,
+                                       uint16    u16Id )
+{
+    if ( u8StackWatermarkNesting < STACK_WATERMARK_NESTING )
+    {
+        asStackWatermarkContext[u8StackWatermarkNesting].u8Kind =  u8Kind;
+        asStackWatermarkContext[u8StackWatermarkNesting].u16Id  =  u16Id;
+    }
+    u8StackWatermarkNesting++;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vStackWatermarkExit
+ *
+ * DESCRIPTION:
+ * Checks the words below the mark for use by the task or handler
+ * returning, following used words down until STACK_WATERMARK_GUARD_WORDS
+ * in a row are found unused
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vStackWatermarkExit ( void )
+{
+    uint32*    pu32Word;
+    uint32*    pu32Used =  NULL;
+    uint8      u8Unused =  0;
+
+    if ( u8StackWatermarkPhase == STACK_WATERMARK_PHASE_MEASURE )
+    {
+        pu32Word =  pu32StackWatermarkMark;
+        while ( ( pu32Word > pu32StackWatermarkFloor ) && ( u8Unused < STACK_WATERMARK_GUARD_WORDS ) )
+        {
+            pu32Word--;
+            if ( *pu32Word != STACK_WATERMARK_PATTERN )
+            {
+                pu32Used =  pu32Word;
+                u8Unused =  0;
+            }
+            else
+            {
+                u8Unused++;
+            }
+        }
+        if ( pu32Used != NULL )
+        {
+            pu32StackWatermarkMark =  pu32Used;
+            if ( pu32Used == pu32StackWatermarkFloor )
+            {
+                sStackWatermarkStats.bOverflow =  TRUE;
+            }
+            APP_vStackWatermarkCredit ( APP_u16StackWatermarkDepth ( pu32Used ) );
+        }
+    }
+    if ( u8StackWatermarkNesting > 0 )
+    {
+        u8StackWatermarkNesting--;
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vStackWatermarkCommand
+ *
+ * DESCRIPTION:
+ * Handles E_SL_MSG_STACK_WATERMARK. The first byte selects the operation:
+ *  REPORT  - optional options byte, STACK_WATERMARK_OPTION_RESET clears the
+ *            peaks once reported and repaints
+ *  REPAINT - repaints the stack now
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vStackWatermarkCommand ( uint8*    pu8Command,
+                                         uint16    u16Length )
+{
+    if ( u16Length == 0 )
+    {
+        return;
+    }
+
+    switch ( pu8Command[0] )
+    {
+        case STACK_WATERMARK_OP_REPORT:
+            APP_vStackWatermarkSendReport ( );
+            if ( ( u16Length > 1 ) && ( pu8Command[1] & STACK_WATERMARK_OPTION_RESET ) )
+            {
+                memset ( asStackWatermarkHandler, 0, sizeof ( asStackWatermarkHandler ) );
+                sStackWatermarkStats.u16Peak    =  0;
+                sStackWatermarkStats.u16PeakId  =  0;
+                sStackWatermarkStats.u8PeakKind =  STACK_WATERMARK_KIND_NONE;
+                sStackWatermarkStats.bOverflow  =  FALSE;
+                APP_vStackWatermarkRepaint ( );
+            }
+        break;
+
+        case STACK_WATERMARK_OP_REPAINT:
+            APP_vStackWatermarkRepaint ( );
+            APP_vStackWatermarkRespond ( pu8Command[0], STACK_WATERMARK_STATUS_OK );
+        break;
+
+        default:
+            APP_vStackWatermarkRespond ( pu8Command[0], STACK_WATERMARK_STATUS_UNSUPPORTED );
+        break;
+    }
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_u16StackWatermarkDepth
+ *
+ * DESCRIPTION:
+ * Stack in use when a word is reached
+ *
+ * RETURNS:
+ * Bytes from the top of the stack to the word
+ *
+ ****************************************************************************/
+PRIVATE uint16 APP_u16StackWatermarkDepth ( uint32*    pu32Word )
+{
+    return ( uint16 ) ( ( uintptr_t ) pu32StackWatermarkTop - ( uintptr_t ) pu32Word );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vStackWatermarkCredit
+ *
+ * DESCRIPTION:
+ * Credits a new mark to the running handler and every task or handler
+ * it runs within
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vStackWatermarkCredit ( uint16    u16Depth )
+{
+    tsStackWatermarkContext*    psContext;
+    uint8                       u8Nesting =  u8StackWatermarkNesting;
+    uint8                       i;
+
+    if ( u8Nesting > STACK_WATERMARK_NESTING )
+    {
+        u8Nesting =  STACK_WATERMARK_NESTING;
+    }
+    for ( i = 0; i < u8Nesting; i++ )
+    {
+        APP_vStackWatermarkRecord ( asStackWatermarkContext[i].u8Kind,
+                                    asStackWatermarkContext[i].u16Id,
+                                    u16Depth );
+    }
+    if ( u16Depth > sStackWatermarkStats.u16Peak )
+    {
+        sStackWatermarkStats.u16Peak =  u16Depth;
+        if ( u8Nesting > 0 )
+        {
+            psContext =  &asStackWatermarkContext[u8Nesting - 1];
+            sStackWatermarkStats.u8PeakKind =  psContext->u8Kind;
+            sStackWatermarkStats.u16PeakId  =  psContext->u16Id;
+        }
+        else
+        {
+            sStackWatermarkStats.u8PeakKind =  STACK_WATERMARK_KIND_NONE;
+            sStackWatermarkStats.u16PeakId  =  0;
+        }
+        vLog_Printf ( TRACE_STACK_WATERMARK, LOG_DEBUG, "\nSW: peak %d bytes, kind %d id %04x",
+                      u16Depth, sStackWatermarkStats.u8PeakKind, sStackWatermarkStats.u16PeakId );
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vStackWatermarkRecord
+ *
+ * DESCRIPTION:
+ * Raises the peak of a task or handler, taking over the entry with the
+ * lowest peak when the table is full
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vStackWatermarkRecord ( uint8     u8Kind,
+                                         uint16    u16Id,
+                                         uint16    u16Depth )
+{
+    tsStackWatermarkHandler*    psHandler;
+    tsStackWatermarkHandler*    psLowest =  NULL;
+    uint8                       i;
+
+    for ( i = 0; i < STACK_WATERMARK_HANDLERS; i++ )
+    {
+        psHandler =  &asStackWatermarkHandler[i];
+        if ( ( psHandler->u16Marks > 0 ) && ( psHandler->u8Kind == u8Kind ) && ( psHandler->u16Id == u16Id ) )
+        {
+            break;
+        }
+        if ( ( psLowest == NULL ) || ( psHandler->u16Marks == 0 ) ||
+             ( ( psLowest->u16Marks > 0 ) && ( psHandler->u16Peak < psLowest->u16Peak ) ) )
+        {
+            psLowest =  psHandler;
+        }
+    }
+    if ( i == STACK_WATERMARK_HANDLERS )
+    {
+        if ( ( psLowest->u16Marks > 0 ) && ( psLowest->u16Peak >= u16Depth ) )
+        {
+            return;
+        }
+        psHandler =  psLowest;
+        psHandler->u8Kind   =  u8Kind;
+        psHandler->u16Id    =  u16Id;
+        psHandler->u16Peak  =  0;
+        psHandler->u16Marks =  0;
+    }
+    if ( u16Depth > psHandler->u16Peak )
+    {
+        psHandler->u16Peak =  u16Depth;
+    }
+    if ( psHandler->u16Marks < 0xFFFF )
+    {
+        psHandler->u16Marks++;
+    }
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vStackWatermarkRepaint
+ *
+ * DESCRIPTION:
+ * Stops measuring until the next passes of the main loop have painted
+ * the stack again
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vStackWatermarkRepaint ( void )
+{
+    u16StackWatermarkTicks   =  0;
+    pu32StackWatermarkCursor =  NULL;
+    u8StackWatermarkPhase    =  STACK_WATERMARK_PHASE_REPAINT;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vStackWatermarkRespond
+ *
+ * DESCRIPTION:
+ * Sends E_SL_MSG_STACK_WATERMARK_RESPONSE
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vStackWatermarkRespond ( uint8    u8Operation,
+                                          uint8    u8Status )
+{
+    uint8     au8Buffer[2 + 1];
+    uint16    u16Length =  0;
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Operation,  u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Status,     u16Length );
+    vSL_WriteMessage ( E_SL_MSG_STACK_WATERMARK_RESPONSE,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vStackWatermarkSendReport
+ *
+ * DESCRIPTION:
+ * Sends E_SL_MSG_STACK_WATERMARK_RESPONSE for STACK_WATERMARK_OP_REPORT:
+ * operation, status, u16 stack size, u16 peak, peak kind, u16 peak id,
+ * u16 depth reached since the last repaint, u16 sweeps, u16 repaints,
+ * u16 peaks found by a sweep, overflow, handler count, then per task or
+ * handler its kind, u16 id, u16 peak and u16 marks set
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vStackWatermarkSendReport ( void )
+{
+    tsStackWatermarkHandler*    psHandler;
+    uint8                       au8Buffer[19 + STACK_WATERMARK_HANDLERS * STACK_WATERMARK_HANDLER_REPORT + 1];
+    uint16                      u16Length =  0;
+    uint8                       u8Count =  0;
+    uint8                       i;
+
+    for ( i = 0; i < STACK_WATERMARK_HANDLERS; i++ )
+    {
+        if ( asStackWatermarkHandler[i].u16Marks > 0 )
+        {
+            u8Count++;
+        }
+    }
+
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], STACK_WATERMARK_OP_REPORT,                  u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], STACK_WATERMARK_STATUS_OK,                  u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ],
+                      APP_u16StackWatermarkDepth ( pu32StackWatermarkFloor ),              u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], sStackWatermarkStats.u16Peak,               u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], sStackWatermarkStats.u8PeakKind,            u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], sStackWatermarkStats.u16PeakId,             u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ],
+                      ( u8StackWatermarkPhase == STACK_WATERMARK_PHASE_MEASURE ) ?
+                          APP_u16StackWatermarkDepth ( pu32StackWatermarkMark ) : 0,       u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], sStackWatermarkStats.u16Sweeps,             u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], sStackWatermarkStats.u16Repaints,           u16Length );
+    ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], sStackWatermarkStats.u16Unattributed,       u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], sStackWatermarkStats.bOverflow,             u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], u8Count,                                    u16Length );
+    for ( i = 0; i < STACK_WATERMARK_HANDLERS; i++ )
+    {
+        psHandler =  &asStackWatermarkHandler[i];
+        if ( psHandler->u16Marks > 0 )
+        {
+            ZNC_BUF_U8_UPD  ( &au8Buffer[ u16Length ], psHandler->u8Kind,      u16Length );
+            ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], psHandler->u16Id,       u16Length );
+            ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], psHandler->u16Peak,     u16Length );
+            ZNC_BUF_U16_UPD ( &au8Buffer[ u16Length ], psHandler->u16Marks,    u16Length );
+        }
+    }
+    vSL_WriteMessage ( E_SL_MSG_STACK_WATERMARK_RESPONSE,
+                       u16Length,
+                       au8Buffer,
+                       0 );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,126 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_stack_watermark.h
+ *
+ * DESCRIPTION:        Stack high-water telemetry per task and per handler
+ *                     (Interface)
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+
+#ifndef APP_STACK_WATERMARK_H_
+#define APP_STACK_WATERMARK_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Fill of unused stack, the pattern StackMeasure.c uses */
+#define STACK_WATERMARK_PATTERN             0xFACEFACE
+
+/* Words painted or swept per pass of the main loop */
+#ifndef STACK_WATERMARK_WORDS_PER_IDLE
+#define STACK_WATERMARK_WORDS_PER_IDLE      16
+#endif
+
+/* Unused words below the mark checked when a handler returns */
+#define STACK_WATERMARK_GUARD_WORDS         16
+
+/* Space left below the main loop's stack pointer when painting */
+#define STACK_WATERMARK_IDLE_MARGIN         64
+
+/* 100ms ticks between repaints, each repaint lets every handler be
+ * measured afresh */
+#ifndef STACK_WATERMARK_REPAINT_TICKS
+#define STACK_WATERMARK_REPAINT_TICKS       100
+#endif
+
+/* Tasks and handlers tracked, and handlers nested within one task */
+#ifndef STACK_WATERMARK_HANDLERS
+#define STACK_WATERMARK_HANDLERS            24
+#endif
+#define STACK_WATERMARK_NESTING             4
+
+/* Kind of context a peak is attributed to */
+#define STACK_WATERMARK_KIND_TASK           0
+#define STACK_WATERMARK_KIND_COMMAND        1
+#define STACK_WATERMARK_KIND_STACK_EVENT    2
+#define STACK_WATERMARK_KIND_ZCL_EVENT      3
+#define STACK_WATERMARK_KIND_BDB_EVENT      4
+#define STACK_WATERMARK_KIND_NONE           0xFF
+
+/* Main loop tasks, the id of STACK_WATERMARK_KIND_TASK */
+#define STACK_WATERMARK_TASK_ZPS            0
+#define STACK_WATERMARK_TASK_BDB            1
+#define STACK_WATERMARK_TASK_APP_EVENTS     2
+#define STACK_WATERMARK_TASK_SERIAL         3
+#define STACK_WATERMARK_TASK_APS_QUEUE      4
+#define STACK_WATERMARK_TASK_TIMERS         5
+#define STACK_WATERMARK_TASK_CHILD_QUEUE    6
+
+/* E_SL_MSG_STACK_WATERMARK operations, first byte of the command */
+#define STACK_WATERMARK_OP_REPORT           0
+#define STACK_WATERMARK_OP_REPAINT          1
+
+/* STACK_WATERMARK_OP_REPORT option bits */
+#define STACK_WATERMARK_OPTION_RESET        0x01
+
+/* E_SL_MSG_STACK_WATERMARK_RESPONSE status */
+#define STACK_WATERMARK_STATUS_OK           0
+#define STACK_WATERMARK_STATUS_UNSUPPORTED  1
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+PUBLIC void APP_vStackWatermarkInit ( void );
+PUBLIC void APP_vStackWatermarkIdle ( void );
+PUBLIC void APP_vStackWatermarkTick ( void );
+PUBLIC void APP_vStackWatermarkEnter ( uint8     u8Kind,
+                                       uint16    u16Id );
+PUBLIC void APP_vStackWatermarkExit ( void );
+PUBLIC void APP_vStackWatermarkCommand ( uint8*    pu8Command,
+                                         uint16    u16Length );
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* APP_STACK_WATERMARK_H_ */
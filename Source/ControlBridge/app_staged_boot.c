@@ -0,0 +1,206 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_staged_boot.c
+ *
+ * DESCRIPTION:        Application table restore at boot (Implementation)
+ *
+ *                     Without STAGED_BOOT the ZLL endpoint and group tables
+ *                     and the Green Power tables are read before the stack
+ *                     starts. With it, vInitialiseApp reads only what the
+ *                     network needs to resume and sends
+ *                     E_SL_MSG_PDM_LOADED; the main loop then restores one
+ *                     table per pass and sends the boot timing when done.
+ *
+ ****************************************************************************
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include "PDM.h"
+#include "PDM_IDs.h"
+#include "app_common.h"
+#include "app_boot_timing.h"
+#include "app_staged_boot.h"
+#ifdef CLD_GREENPOWER
+#include "app_green_power.h"
+#endif
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+/* Next application table to restore once the stack is running */
+typedef enum
+{
+#ifdef FULL_FUNC_DEVICE
+    E_STAGED_BOOT_ZLL_TABLES,
+#endif
+#ifdef CLD_GREENPOWER
+    E_STAGED_BOOT_GREEN_POWER,
+#endif
+    E_STAGED_BOOT_DONE,
+    E_STAGED_BOOT_IDLE
+} teStagedBootStep;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+#ifdef FULL_FUNC_DEVICE
+PRIVATE void APP_vStagedBootReadZllTables ( void );
+#endif
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE teStagedBootStep    eStagedBootStep =  ( teStagedBootStep ) 0;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vBootRestoreTables
+ *
+ * DESCRIPTION:
+ * Restores every application table at once, before the end points are
+ * registered, for builds without STAGED_BOOT
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vBootRestoreTables ( void )
+{
+#ifdef CLD_GREENPOWER
+    vAPP_GP_LoadPDMData ( );
+#endif
+#ifdef FULL_FUNC_DEVICE
+    APP_vStagedBootReadZllTables ( );
+#endif
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vStagedBootInit
+ *
+ * DESCRIPTION:
+ * Starts the staged restore over from the first table
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vStagedBootInit ( void )
+{
+    eStagedBootStep =  ( teStagedBootStep ) 0;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bStagedBootRestore
+ *
+ * DESCRIPTION:
+ * Restores one application table per pass of the main loop once the stack
+ * is up, the records needed to resume the network having been read by
+ * vInitialiseApp and ZPS_eAplAfInit. Sends the boot timing when done.
+ *
+ * RETURNS:
+ * TRUE if a step was taken, FALSE once everything is restored
+ *
+ ****************************************************************************/
+PUBLIC bool_t APP_bStagedBootRestore ( void )
+{
+    switch ( eStagedBootStep )
+    {
+#ifdef FULL_FUNC_DEVICE
+        case E_STAGED_BOOT_ZLL_TABLES:
+            APP_vStagedBootReadZllTables ( );
+        break;
+#endif
+#ifdef CLD_GREENPOWER
+        case E_STAGED_BOOT_GREEN_POWER:
+            vAPP_GP_LoadDeferredPDMData ( );
+        break;
+#endif
+        case E_STAGED_BOOT_DONE:
+            APP_vBootTimingMark ( E_BOOT_TIMING_DEFERRED );
+            APP_vBootTimingSend ( );
+        break;
+
+        default:
+            return FALSE;
+    }
+
+    eStagedBootStep++;
+    return TRUE;
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+#ifdef FULL_FUNC_DEVICE
+/****************************************************************************
+ *
+ * NAME: APP_vStagedBootReadZllTables
+ *
+ * DESCRIPTION:
+ * Reads the ZLL endpoint and group tables
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vStagedBootReadZllTables ( void )
+{
+    uint16    u16DataBytesRead;
+
+    PDM_eReadDataFromRecord ( PDM_ID_APP_END_P_TABLE,
+                              &sEndpointTable,
+                              sizeof ( tsZllEndpointInfoTable ),
+                              &u16DataBytesRead );
+    PDM_eReadDataFromRecord ( PDM_ID_APP_GROUP_TABLE,
+                              &sGroupTable,
+                              sizeof ( tsZllGroupInfoTable ),
+                              &u16DataBytesRead );
+}
+#endif
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
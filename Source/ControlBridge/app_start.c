@@ -96,6 +96,38 @@
 #ifdef CLD_OTA
 #include "app_ota_server.h"
 #endif
+#ifdef APS_QUEUE
+#include "app_aps_queue.h"
+#endif
+#ifdef CHILD_QUEUE
+#include "app_child_queue.h"
+#endif
+#ifdef REPORT_FILTER
+#include "app_report_filter.h"
+#endif
+#ifdef ATTRIBUTE_CACHE
+#include "app_attribute_cache.h"
+#endif
+#ifdef DEVICE_INTERVIEW
+#include "app_device_interview.h"
+#endif
+#ifdef DEVICE_SNAPSHOT
+#include "app_device_snapshot.h"
+#endif
+#ifdef PDM_TELEMETRY
+#include "app_pdm_telemetry.h"
+#endif
+#include "app_boot_timing.h"
+#include "app_staged_boot.h"
+#ifdef OTA_FLEET
+#include "app_ota_fleet.h"
+#endif
+#ifdef CHANNEL_QUALITY
+#include "app_channel_quality.h"
+#endif
+#ifdef STACK_WATERMARK
+#include "app_stack_watermark.h"
+#endif
 #include "app.h"
 #include "fsl_wwdt.h"
 
@@ -132,6 +164,20 @@
 
 #define APP_NUM_STD_TMRS                5
 
+/* Runs a main loop task, noting its stack use when STACK_WATERMARK is set */
+#ifdef STACK_WATERMARK
+#define APP_TASK( u8Task, vTask )                                 \
+    do                                                            \
+    {                                                             \
+        APP_vStackWatermarkEnter ( STACK_WATERMARK_KIND_TASK,     \
+                                   u8Task );                      \
+        vTask;                                                    \
+        APP_vStackWatermarkExit ( );                              \
+    } while ( 0 )
+#else
+#define APP_TASK( u8Task, vTask )                                 vTask
+#endif
+
 PUBLIC uint8 u8TimerPowerOn;
 
 #ifdef CLD_GREENPOWER
@@ -363,6 +409,9 @@ PUBLIC void vAppMain(void)
     wwdt_config_t  config;
 #ifdef STACK_MEASURE
     vInitStackMeasure ( );
+#endif
+#ifdef STACK_WATERMARK
+    APP_vStackWatermarkInit ( );
 #endif
     /* Initialise debugging */
 
@@ -540,7 +589,11 @@ PRIVATE void vInitialiseApp ( void )
     uint16            u16DataBytesRead;
     BDB_tsInitArgs    sArgs;
     uint8             u8DeviceType;
+#ifdef PDM_TELEMETRY
+    uint64            u64PdmInitStart;
+#endif
 
+    APP_vBootTimingMark ( E_BOOT_TIMING_START );
     /* Initialise Power Manager even on non-sleeping nodes as it allows the
      * device to doze when in the idle task */
 #ifdef APP_LOW_POWER_API
@@ -552,8 +605,33 @@ PRIVATE void vInitialiseApp ( void )
     PWRM_vForceRadioRetention(TRUE);
 #endif
 
-    PDM_eInitialise(1200, 63, NULL);
+#ifdef PDM_TELEMETRY
+    u64PdmInitStart =  TMR_GetTimestamp();
+#endif
+    PDM_eInitialise(PDM_START_SEGMENT, PDM_NUM_SEGMENTS, NULL);
     PDUM_vInit();
+#ifdef APS_QUEUE
+    APP_vApsQueueInit();
+#endif
+#ifdef CHILD_QUEUE
+    APP_vChildQueueInit();
+#endif
+#ifdef REPORT_FILTER
+    APP_vReportFilterInit();
+#endif
+#ifdef ATTRIBUTE_CACHE
+    APP_vAttributeCacheInit();
+#endif
+#ifdef DEVICE_INTERVIEW
+    APP_vDeviceInterviewInit();
+#endif
+#ifdef DEVICE_SNAPSHOT
+    APP_vDeviceSnapshotInit();
+#endif
+#ifdef PDM_TELEMETRY
+    APP_vPdmTelemetryInit((uint32)(TMR_GetTimestamp() - u64PdmInitStart));
+#endif
+    APP_vBootTimingMark ( E_BOOT_TIMING_PDM_INIT );
 
 
     /* Update radio temperature (loading calibration) */
@@ -561,7 +639,6 @@ PRIVATE void vInitialiseApp ( void )
 
     #ifdef CLD_GREENPOWER
     vManagePowerOnCountLoadRecord();
-    vAPP_GP_LoadPDMData();
     #endif
 
     sZllState.eNodeState =  E_STARTUP;
@@ -570,16 +647,10 @@ PRIVATE void vInitialiseApp ( void )
                               &sZllState,
                               sizeof ( tsZllState ),
                               &u16DataBytesRead );
-#ifdef FULL_FUNC_DEVICE
-    PDM_eReadDataFromRecord ( PDM_ID_APP_END_P_TABLE,
-                              &sEndpointTable,
-                              sizeof ( tsZllEndpointInfoTable ),
-                              &u16DataBytesRead );
-    PDM_eReadDataFromRecord ( PDM_ID_APP_GROUP_TABLE,
-                              &sGroupTable,
-                              sizeof ( tsZllGroupInfoTable ),
-                              &u16DataBytesRead );
+#ifndef STAGED_BOOT
+    APP_vBootRestoreTables ( );
 #endif
+    APP_vBootTimingMark ( E_BOOT_TIMING_APP_RECORDS );
     ZPS_u32MacSetTxBuffers ( 5 );
 
     if ( sZllState.eNodeState == E_RUNNING )
@@ -587,11 +658,13 @@ PRIVATE void vInitialiseApp ( void )
         u8DeviceType = ( sZllState.u8DeviceType >=  2 ) ? 1 : sZllState.u8DeviceType;
         APP_vConfigureDevice ( u8DeviceType );
         ZPS_eAplAfInit ( );
+        APP_vBootTimingMark ( E_BOOT_TIMING_STACK );
     }
     else
     {
 
         ZPS_eAplAfInit ( );
+        APP_vBootTimingMark ( E_BOOT_TIMING_STACK );
         sZllState.u8DeviceType =  0;
         ZPS_vNwkNibSetChannel ( ZPS_pvAplZdoGetNwkHandle(), DEFAULT_CHANNEL);
         ZPS_vNwkNibSetPanId (ZPS_pvAplZdoGetNwkHandle(), (uint16) RND_u32GetRand ( 1, 0xfff0 ) );
@@ -604,6 +677,7 @@ PRIVATE void vInitialiseApp ( void )
                                        1,
                                        au8values,
                                        0 );
+    APP_vBootTimingMark ( E_BOOT_TIMING_READY );
 
 
     //DBG_vPrintf(TRACE_APPSTART, "\r\nAPP: NV_STORAGE_START_ADDRESS @ %08x ",NV_STORAGE_START_ADDRESS);
@@ -631,6 +705,11 @@ PRIVATE void vInitialiseApp ( void )
     }
 #ifdef CLD_GREENPOWER
     vManagePowerOnCountInit();
+#endif
+    APP_vBootTimingMark ( E_BOOT_TIMING_ZCL );
+#ifndef STAGED_BOOT
+    APP_vBootTimingMark ( E_BOOT_TIMING_DEFERRED );
+    APP_vBootTimingSend ( );
 #endif
 }
 
@@ -657,6 +736,9 @@ void main_task (uint32_t parameter)
         initialized = TRUE;
 #if (ZIGBEE_USE_FRAMEWORK != 0)
         SecLib_Init();
+#ifdef SECLIB_AES_FORCE_SW
+        SecLib_AES_HW_Accelerator_disable(TRUE);
+#endif
 		if(gRngSuccess_d != RNG_Init())
 		{
 			DBG_vPrintf(TRUE,"Failed to init RNG\n");
@@ -671,11 +753,23 @@ void main_task (uint32_t parameter)
     while(1)
     {
          /* place event handler code here... */
-        zps_taskZPS ( );
-        bdb_taskBDB ( );
-        APP_vHandleAppEvents ( );
-        APP_vProcessRxData ( );
-        ZTIMER_vTask ( );
+        APP_TASK ( STACK_WATERMARK_TASK_ZPS,          zps_taskZPS ( ) );
+        APP_TASK ( STACK_WATERMARK_TASK_BDB,          bdb_taskBDB ( ) );
+        APP_TASK ( STACK_WATERMARK_TASK_APP_EVENTS,   APP_vHandleAppEvents ( ) );
+#ifdef STAGED_BOOT
+        APP_bStagedBootRestore ( );
+#endif
+        APP_TASK ( STACK_WATERMARK_TASK_SERIAL,       APP_vProcessRxData ( ) );
+#ifdef CHILD_QUEUE
+        APP_TASK ( STACK_WATERMARK_TASK_CHILD_QUEUE,  APP_vChildQueueService ( ) );
+#endif
+#ifdef APS_QUEUE
+        APP_TASK ( STACK_WATERMARK_TASK_APS_QUEUE,    APP_vApsQueueService ( ) );
+#endif
+        APP_TASK ( STACK_WATERMARK_TASK_TIMERS,       ZTIMER_vTask ( ) );
+#ifdef STACK_WATERMARK
+        APP_vStackWatermarkIdle ( );
+#endif
 
 #ifdef DBG_ENABLE
         vSL_LogFlush ( ); /* flush buffers */
@@ -1266,6 +1360,31 @@ PRIVATE void APP_cbTimerZclTick (void*    pvParam)
     /* Provide 100ms tick to cluster */
     eZCL_Update100mS();
 
+#ifdef APS_QUEUE
+    APP_vApsQueueTick ( );
+#endif
+#ifdef CHILD_QUEUE
+    APP_vChildQueueTick ( );
+#endif
+#ifdef REPORT_FILTER
+    APP_vReportFilterTick ( );
+#endif
+#ifdef ATTRIBUTE_CACHE
+    APP_vAttributeCacheTick ( );
+#endif
+#ifdef DEVICE_INTERVIEW
+    APP_vDeviceInterviewTick ( );
+#endif
+#ifdef OTA_FLEET
+    APP_vOtaFleetTick ( );
+#endif
+#ifdef CHANNEL_QUALITY
+    APP_vChannelQualityTick ( );
+#endif
+#ifdef STACK_WATERMARK
+    APP_vStackWatermarkTick ( );
+#endif
+
     /* Provide 1sec tick to cluster - Wrap 1 second  */
     u8Tick100Ms++;
     if(u8Tick100Ms > 9)
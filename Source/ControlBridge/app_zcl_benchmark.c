@@ -0,0 +1,674 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge
+ *
+ * COMPONENT:          app_zcl_benchmark.c
+ *
+ * DESCRIPTION:        Cycle counts of ZCL header and attribute
+ *                     serialisation (Implementation)
+ *
+ *                     Times, with the core cycle counter, the paths every
+ *                     ZCL frame goes through: the ZCL header written and
+ *                     parsed by ZCIF, an attribute record (identifier, type,
+ *                     value) of each ZCL type written and read back through
+ *                     the ZCIF PDU buffer functions, the value read back
+ *                     forwarded to the host as a report is, with
+ *                     APP_u16ZncReadDataPattern, and those host bytes
+ *                     encoded again as APP_eSendWriteAttributesRequest does,
+ *                     with APP_u16ZncWriteDataPattern. The encoded value must
+ *                     match what ZCIF wrote, for every type ZCIF supports.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "fsl_common.h"
+#include "pdum_apl.h"
+#include "zcl.h"
+#include "zcl_customcommand.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "Log.h"
+#include "app_zcl_benchmark.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef DEBUG_ZCL_BENCHMARK
+#define TRACE_ZCL_BENCHMARK             TRUE
+#else
+#define TRACE_ZCL_BENCHMARK             FALSE
+#endif
+
+#define ZCL_BENCHMARK_ATTRIBUTE_ID      0x4000
+#define ZCL_BENCHMARK_MANUFACTURER      0x1037
+#define ZCL_BENCHMARK_COMMAND           0x0A
+
+/* Attribute identifier and type ahead of each value */
+#define ZCL_BENCHMARK_RECORD_HEADER     3
+
+/* Value sizes of the variable length types as encoded */
+#define ZCL_BENCHMARK_STRING_SIZE       ( 1 + ZCL_BENCHMARK_STRING_LENGTH )
+#define ZCL_BENCHMARK_LONG_STRING_SIZE  ( 2 + ZCL_BENCHMARK_STRING_LENGTH )
+#define ZCL_BENCHMARK_ARRAY_SIZE        ( 3 + 2 * ZCL_BENCHMARK_ARRAY_ELEMENTS )
+
+#define ZCL_BENCHMARK_TYPES             ( sizeof ( asZclBenchmarkTypes ) / sizeof ( asZclBenchmarkTypes[0] ) )
+
+/* Status, iterations, core clock, header write and read cycles, type count,
+ * then per type: type, encoded bytes, write, read, forward and encode cycles */
+#define ZCL_BENCHMARK_RESULT_HEADER     ( 1 + 2 + 4 + 4 + 4 + 1 )
+#define ZCL_BENCHMARK_RESULT_RECORD     ( 1 + 1 + 4 + 4 + 4 + 4 )
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    teZCL_ZCLAttributeType    eType;
+    uint8                     u8Size;
+} tsZclBenchmarkType;
+
+typedef struct
+{
+    uint32    u32WriteCycles;
+    uint32    u32ReadCycles;
+    uint32    u32ForwardCycles;
+    uint32    u32EncodeCycles;
+} tsZclBenchmarkCycles;
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE uint8 APP_u8ZclBenchmarkType ( PDUM_thAPduInstance         hAPduInst,
+                                       const tsZclBenchmarkType*   psType,
+                                       uint16                      u16Iterations,
+                                       tsZclBenchmarkCycles*       psCycles );
+PRIVATE uint16 APP_u16ZclBenchmarkWrite ( PDUM_thAPduInstance         hAPduInst,
+                                          teZCL_ZCLAttributeType      eType );
+PRIVATE uint16 APP_u16ZclBenchmarkRead ( PDUM_thAPduInstance         hAPduInst,
+                                         teZCL_ZCLAttributeType      eType );
+PRIVATE uint16 APP_u16ZclBenchmarkForward ( uint8*                      pu8Host,
+                                            const tsZclBenchmarkType*   psType );
+PRIVATE uint16 APP_u16ZclBenchmarkEncode ( uint8*                      pu8Data,
+                                           teZCL_ZCLAttributeType      eType,
+                                           uint8*                      pu8Host,
+                                           uint16                      u16HostSize );
+PRIVATE bool_t APP_bZclBenchmarkIsString ( teZCL_ZCLAttributeType      eType );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+/* Every type ZCIF encodes */
+PRIVATE const tsZclBenchmarkType asZclBenchmarkTypes[] =
+{
+    { E_ZCL_GINT8,          1 },
+    { E_ZCL_GINT16,         2 },
+    { E_ZCL_GINT24,         3 },
+    { E_ZCL_GINT32,         4 },
+    { E_ZCL_GINT40,         5 },
+    { E_ZCL_GINT48,         6 },
+    { E_ZCL_GINT56,         7 },
+    { E_ZCL_GINT64,         8 },
+    { E_ZCL_BOOL,           1 },
+    { E_ZCL_BMAP8,          1 },
+    { E_ZCL_BMAP16,         2 },
+    { E_ZCL_BMAP24,         3 },
+    { E_ZCL_BMAP32,         4 },
+    { E_ZCL_BMAP40,         5 },
+    { E_ZCL_BMAP48,         6 },
+    { E_ZCL_BMAP56,         7 },
+    { E_ZCL_BMAP64,         8 },
+    { E_ZCL_UINT8,          1 },
+    { E_ZCL_UINT16,         2 },
+    { E_ZCL_UINT24,         3 },
+    { E_ZCL_UINT32,         4 },
+    { E_ZCL_UINT40,         5 },
+    { E_ZCL_UINT48,         6 },
+    { E_ZCL_UINT56,         7 },
+    { E_ZCL_UINT64,         8 },
+    { E_ZCL_INT8,           1 },
+    { E_ZCL_INT16,          2 },
+    { E_ZCL_INT24,          3 },
+    { E_ZCL_INT32,          4 },
+    { E_ZCL_INT40,          5 },
+    { E_ZCL_INT48,          6 },
+    { E_ZCL_INT56,          7 },
+    { E_ZCL_INT64,          8 },
+    { E_ZCL_ENUM8,          1 },
+    { E_ZCL_ENUM16,         2 },
+    { E_ZCL_FLOAT_SEMI,     2 },
+    { E_ZCL_FLOAT_SINGLE,   4 },
+    { E_ZCL_FLOAT_DOUBLE,   8 },
+    { E_ZCL_OSTRING,        ZCL_BENCHMARK_STRING_SIZE },
+    { E_ZCL_CSTRING,        ZCL_BENCHMARK_STRING_SIZE },
+    { E_ZCL_LOSTRING,       ZCL_BENCHMARK_LONG_STRING_SIZE },
+    { E_ZCL_LCSTRING,       ZCL_BENCHMARK_LONG_STRING_SIZE },
+    { E_ZCL_ARRAY,          ZCL_BENCHMARK_ARRAY_SIZE },
+    { E_ZCL_TOD,            4 },
+    { E_ZCL_DATE,           4 },
+    { E_ZCL_UTCT,           4 },
+    { E_ZCL_CLUSTER_ID,     2 },
+    { E_ZCL_ATTRIBUTE_ID,   2 },
+    { E_ZCL_IEEE_ADDR,      8 },
+    { E_ZCL_KEY_128,        16 }
+};
+
+/* Source values, negative so signed types sign extend */
+PRIVATE const uint8 au8ZclBenchmarkValue[16] =
+{
+    0x81, 0x92, 0xa3, 0xb4, 0xc5, 0xd6, 0xe7, 0xf8,
+    0x09, 0x1a, 0x2b, 0x3c, 0x4d, 0x5e, 0x6f, 0x70
+};
+PRIVATE const uint8 au8ZclBenchmarkString[ZCL_BENCHMARK_STRING_LENGTH] =
+{
+    'C', 'o', 'n', 't', 'r', 'o', 'l', 'B', 'r', 'i', 'd', 'g', 'e', '-', '0', '1'
+};
+
+/* Values read back, compared with the source after each type */
+PRIVATE uint64    au64ZclBenchmarkRead[2];
+PRIVATE uint16    au16ZclBenchmarkArray[ZCL_BENCHMARK_ARRAY_ELEMENTS];
+PRIVATE uint8     au8ZclBenchmarkStringRead[ZCL_BENCHMARK_STRING_LENGTH];
+/* The value as sent to the host and as encoded back from it */
+PRIVATE uint8     au8ZclBenchmarkHost[2 * ZCL_BENCHMARK_STRING_SIZE];
+PRIVATE uint8     au8ZclBenchmarkEncoded[ZCL_BENCHMARK_RECORD_HEADER + 2 * ZCL_BENCHMARK_STRING_SIZE];
+
+PRIVATE uint8     au8ZclBenchmarkResult[ZCL_BENCHMARK_RESULT_HEADER +
+                                        ( sizeof ( asZclBenchmarkTypes ) / sizeof ( asZclBenchmarkTypes[0] ) ) *
+                                        ZCL_BENCHMARK_RESULT_RECORD + 1];
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_vZclBenchmarkRun
+ *
+ * DESCRIPTION:
+ * Times u16Iterations passes of each serialisation path in core cycles,
+ * checks every value reads back as written and encodes back from the host
+ * as ZCIF wrote it, and sends E_SL_MSG_ZCL_BENCHMARK_RESULT: status,
+ * iterations, core clock in Hz, header write and read cycles, type count,
+ * then per type its ZCL type, encoded record bytes and write, read, forward
+ * and encode cycles. Cycles are totals over all iterations
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PUBLIC void APP_vZclBenchmarkRun ( uint16    u16Iterations )
+{
+    PDUM_thAPduInstance     hAPduInst;
+    tsZCL_HeaderParams      sHeader;
+    tsZclBenchmarkCycles    sCycles;
+    uint32                  u32HeaderWrite  =  0;
+    uint32                  u32HeaderRead   =  0;
+    uint32                  u32Start;
+    uint16                  u16Length       =  0;
+    uint16                  u16HeaderSize   =  0;
+    uint8                   u8Status        =  ZCL_BENCHMARK_STATUS_OK;
+    uint8                   u8Types         =  0;
+    uint8                   u8TypeStatus;
+    uint16                  i;
+
+    if ( ( u16Iterations == 0 ) || ( u16Iterations > ZCL_BENCHMARK_MAX_ITERATIONS ) )
+    {
+        u16Iterations =  ( u16Iterations == 0 ) ? ZCL_BENCHMARK_DEFAULT_ITERATIONS : ZCL_BENCHMARK_MAX_ITERATIONS;
+    }
+
+    CoreDebug->DEMCR |=  CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |=  DWT_CTRL_CYCCNTENA_Msk;
+
+    /* Leaves room for the ZCL header and the records after it */
+    u16Length =  ZCL_BENCHMARK_RESULT_HEADER;
+    hAPduInst =  hZCL_AllocateAPduInstance ( );
+    if ( hAPduInst == PDUM_INVALID_HANDLE )
+    {
+        u8Status =  ZCL_BENCHMARK_STATUS_NO_BUFFER;
+    }
+    else
+    {
+        u32Start =  DWT->CYCCNT;
+        for ( i = 0; i < u16Iterations; i++ )
+        {
+            u16HeaderSize =  u16ZCL_WriteCommandHeader ( hAPduInst,
+                                                         eFRAME_TYPE_COMMAND_IS_SPECIFIC_TO_A_CLUSTER,
+                                                         TRUE,
+                                                         ZCL_BENCHMARK_MANUFACTURER,
+                                                         TRUE,
+                                                         TRUE,
+                                                         ( uint8 ) i,
+                                                         ZCL_BENCHMARK_COMMAND );
+        }
+        u32HeaderWrite =  DWT->CYCCNT - u32Start;
+
+        /* ZCIF reads no further than the payload size of the APDU */
+        PDUM_eAPduInstanceSetPayloadSize ( hAPduInst, u16HeaderSize );
+
+        u32Start =  DWT->CYCCNT;
+        for ( i = 0; i < u16Iterations; i++ )
+        {
+            u16ZCL_ReadCommandHeader ( hAPduInst, &sHeader );
+        }
+        u32HeaderRead =  DWT->CYCCNT - u32Start;
+
+        if ( ( sHeader.u16ManufacturerCode != ZCL_BENCHMARK_MANUFACTURER ) ||
+             ( sHeader.u8CommandIdentifier != ZCL_BENCHMARK_COMMAND ) )
+        {
+            u8Status =  ZCL_BENCHMARK_STATUS_DECODE_MISMATCH;
+        }
+
+        for ( i = 0; i < ZCL_BENCHMARK_TYPES; i++ )
+        {
+            u8TypeStatus =  APP_u8ZclBenchmarkType ( hAPduInst, &asZclBenchmarkTypes[i], u16Iterations, &sCycles );
+            if ( u8TypeStatus != ZCL_BENCHMARK_STATUS_OK )
+            {
+                /* The first failure is reported */
+                if ( u8Status == ZCL_BENCHMARK_STATUS_OK )
+                {
+                    u8Status =  u8TypeStatus;
+                }
+                vLog_Printf ( TRACE_ZCL_BENCHMARK, LOG_DEBUG, "\nZCL benchmark type 0x%02x status %d",
+                              asZclBenchmarkTypes[i].eType, u8TypeStatus );
+            }
+            ZNC_BUF_U8_UPD  ( &au8ZclBenchmarkResult[ u16Length ], asZclBenchmarkTypes[i].eType,                                    u16Length );
+            ZNC_BUF_U8_UPD  ( &au8ZclBenchmarkResult[ u16Length ], ZCL_BENCHMARK_RECORD_HEADER + asZclBenchmarkTypes[i].u8Size,    u16Length );
+            ZNC_BUF_U32_UPD ( &au8ZclBenchmarkResult[ u16Length ], sCycles.u32WriteCycles,                                          u16Length );
+            ZNC_BUF_U32_UPD ( &au8ZclBenchmarkResult[ u16Length ], sCycles.u32ReadCycles,                                           u16Length );
+            ZNC_BUF_U32_UPD ( &au8ZclBenchmarkResult[ u16Length ], sCycles.u32ForwardCycles,                                        u16Length );
+            ZNC_BUF_U32_UPD ( &au8ZclBenchmarkResult[ u16Length ], sCycles.u32EncodeCycles,                                         u16Length );
+            u8Types++;
+        }
+        PDUM_eAPduFreeAPduInstance ( hAPduInst );
+    }
+
+    vLog_Printf ( TRACE_ZCL_BENCHMARK, LOG_DEBUG, "\nZCL benchmark %d x%d: header %d/%d cycles, %d types",
+                  u8Status, u16Iterations, u32HeaderWrite, u32HeaderRead, u8Types );
+
+    i =  0;
+    ZNC_BUF_U8_UPD  ( &au8ZclBenchmarkResult[ i ], u8Status,          i );
+    ZNC_BUF_U16_UPD ( &au8ZclBenchmarkResult[ i ], u16Iterations,     i );
+    ZNC_BUF_U32_UPD ( &au8ZclBenchmarkResult[ i ], SystemCoreClock,   i );
+    ZNC_BUF_U32_UPD ( &au8ZclBenchmarkResult[ i ], u32HeaderWrite,    i );
+    ZNC_BUF_U32_UPD ( &au8ZclBenchmarkResult[ i ], u32HeaderRead,     i );
+    ZNC_BUF_U8_UPD  ( &au8ZclBenchmarkResult[ i ], u8Types,           i );
+    vSL_WriteMessage ( E_SL_MSG_ZCL_BENCHMARK_RESULT,
+                       u16Length,
+                       au8ZclBenchmarkResult,
+                       0 );
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/****************************************************************************
+ *
+ * NAME: APP_u8ZclBenchmarkType
+ *
+ * DESCRIPTION:
+ * Times writing an attribute record of one type into the APDU, reading it
+ * back, forwarding the value read to the host and encoding the host bytes
+ * again
+ *
+ * RETURNS:
+ * ZCL_BENCHMARK_STATUS_OK when the value reads back as written and encodes
+ * back to the bytes ZCIF wrote
+ *
+ ****************************************************************************/
+PRIVATE uint8 APP_u8ZclBenchmarkType ( PDUM_thAPduInstance         hAPduInst,
+                                       const tsZclBenchmarkType*   psType,
+                                       uint16                      u16Iterations,
+                                       tsZclBenchmarkCycles*       psCycles )
+{
+    uint32    u32Start;
+    uint16    u16Size   =  0;
+    uint16    u16HostSize;
+    uint16    i;
+    bool_t    bMatch;
+
+    /* A type that fails part way still reports every count */
+    memset ( psCycles, 0, sizeof ( tsZclBenchmarkCycles ) );
+    PDUM_eAPduInstanceSetPayloadSize ( hAPduInst, ZCL_BENCHMARK_RECORD_HEADER + psType->u8Size );
+    memset ( au64ZclBenchmarkRead,       0, sizeof ( au64ZclBenchmarkRead ) );
+    memset ( au16ZclBenchmarkArray,      0, sizeof ( au16ZclBenchmarkArray ) );
+    memset ( au8ZclBenchmarkStringRead,  0, sizeof ( au8ZclBenchmarkStringRead ) );
+    memset ( au8ZclBenchmarkEncoded,     0, sizeof ( au8ZclBenchmarkEncoded ) );
+
+    u32Start =  DWT->CYCCNT;
+    for ( i = 0; i < u16Iterations; i++ )
+    {
+        u16Size =  APP_u16ZclBenchmarkWrite ( hAPduInst, psType->eType );
+    }
+    psCycles->u32WriteCycles =  DWT->CYCCNT - u32Start;
+    bMatch =  ( u16Size == ( ZCL_BENCHMARK_RECORD_HEADER + psType->u8Size ) );
+
+    u32Start =  DWT->CYCCNT;
+    for ( i = 0; i < u16Iterations; i++ )
+    {
+        u16Size =  APP_u16ZclBenchmarkRead ( hAPduInst, psType->eType );
+    }
+    psCycles->u32ReadCycles =  DWT->CYCCNT - u32Start;
+    bMatch &=  ( u16Size == ( ZCL_BENCHMARK_RECORD_HEADER + psType->u8Size ) );
+
+    if ( APP_bZclBenchmarkIsString ( psType->eType ) )
+    {
+        bMatch &=  ( 0 == memcmp ( au8ZclBenchmarkStringRead, au8ZclBenchmarkString, ZCL_BENCHMARK_STRING_LENGTH ) );
+    }
+    else if ( psType->eType == E_ZCL_ARRAY )
+    {
+        for ( i = 0; i < ZCL_BENCHMARK_ARRAY_ELEMENTS; i++ )
+        {
+            bMatch &=  ( 0 == memcmp ( &au16ZclBenchmarkArray[i], au8ZclBenchmarkValue, sizeof ( uint16 ) ) );
+        }
+    }
+    else
+    {
+        /* Little endian, so the low bytes of what was read are those written */
+        bMatch &=  ( 0 == memcmp ( au64ZclBenchmarkRead, au8ZclBenchmarkValue, psType->u8Size ) );
+    }
+    if ( !bMatch )
+    {
+        return ZCL_BENCHMARK_STATUS_DECODE_MISMATCH;
+    }
+
+    u16HostSize =  0;
+    u32Start    =  DWT->CYCCNT;
+    for ( i = 0; i < u16Iterations; i++ )
+    {
+        u16HostSize =  APP_u16ZclBenchmarkForward ( au8ZclBenchmarkHost, psType );
+    }
+    psCycles->u32ForwardCycles =  DWT->CYCCNT - u32Start;
+
+    u32Start =  DWT->CYCCNT;
+    for ( i = 0; i < u16Iterations; i++ )
+    {
+        u16Size =  APP_u16ZclBenchmarkEncode ( au8ZclBenchmarkEncoded, psType->eType, au8ZclBenchmarkHost, u16HostSize );
+    }
+    psCycles->u32EncodeCycles =  DWT->CYCCNT - u32Start;
+
+    /* The host writing back what it was sent puts the same bytes on air */
+    if ( ( u16Size != ( ZCL_BENCHMARK_RECORD_HEADER + psType->u8Size ) ) ||
+         ( 0 != memcmp ( &au8ZclBenchmarkEncoded[ ZCL_BENCHMARK_RECORD_HEADER ],
+                         ( uint8* ) PDUM_pvAPduInstanceGetPayload ( hAPduInst ) + ZCL_BENCHMARK_RECORD_HEADER,
+                         psType->u8Size ) ) )
+    {
+        return ZCL_BENCHMARK_STATUS_ENCODE_MISMATCH;
+    }
+
+    return ZCL_BENCHMARK_STATUS_OK;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u16ZclBenchmarkWrite
+ *
+ * DESCRIPTION:
+ * Writes the attribute record into the APDU with the ZCIF functions, as a
+ * read attributes response or report is built
+ *
+ * RETURNS:
+ * Bytes written
+ *
+ ****************************************************************************/
+PRIVATE uint16 APP_u16ZclBenchmarkWrite ( PDUM_thAPduInstance         hAPduInst,
+                                          teZCL_ZCLAttributeType      eType )
+{
+    tsZCL_LongOctetString    sString;
+    uint16                   u16AttributeId =  ZCL_BENCHMARK_ATTRIBUTE_ID;
+    uint16                   u16Elements    =  ZCL_BENCHMARK_ARRAY_ELEMENTS;
+    uint8                    u8Type         =  eType;
+    uint8                    u8ElementType  =  E_ZCL_UINT16;
+    uint16                   u16Pos         =  0;
+    uint16                   i;
+
+    u16Pos +=  u16ZCL_APduInstanceWriteNBO ( hAPduInst, u16Pos, E_ZCL_ATTRIBUTE_ID, &u16AttributeId );
+    u16Pos +=  u16ZCL_APduInstanceWriteNBO ( hAPduInst, u16Pos, E_ZCL_UINT8,        &u8Type );
+
+    if ( APP_bZclBenchmarkIsString ( eType ) )
+    {
+        /* The short strings share the layout of the long ones up to the length */
+        if ( ( eType == E_ZCL_OSTRING ) || ( eType == E_ZCL_CSTRING ) )
+        {
+            ( ( tsZCL_OctetString* ) &sString )->u8MaxLength =  ZCL_BENCHMARK_STRING_LENGTH;
+            ( ( tsZCL_OctetString* ) &sString )->u8Length    =  ZCL_BENCHMARK_STRING_LENGTH;
+            ( ( tsZCL_OctetString* ) &sString )->pu8Data     =  ( uint8* ) au8ZclBenchmarkString;
+        }
+        else
+        {
+            sString.u16MaxLength =  ZCL_BENCHMARK_STRING_LENGTH;
+            sString.u16Length    =  ZCL_BENCHMARK_STRING_LENGTH;
+            sString.pu8Data      =  ( uint8* ) au8ZclBenchmarkString;
+        }
+        u16Pos +=  u16ZCL_APduInstanceWriteStringNBO ( hAPduInst, u16Pos, eType, &sString );
+    }
+    else if ( eType == E_ZCL_ARRAY )
+    {
+        /* ZCIF has no array type, the elements go one at a time */
+        u16Pos +=  u16ZCL_APduInstanceWriteNBO ( hAPduInst, u16Pos, E_ZCL_UINT8,  &u8ElementType );
+        u16Pos +=  u16ZCL_APduInstanceWriteNBO ( hAPduInst, u16Pos, E_ZCL_UINT16, &u16Elements );
+        for ( i = 0; i < ZCL_BENCHMARK_ARRAY_ELEMENTS; i++ )
+        {
+            u16Pos +=  u16ZCL_APduInstanceWriteNBO ( hAPduInst, u16Pos, E_ZCL_UINT16, ( void* ) au8ZclBenchmarkValue );
+        }
+    }
+    else
+    {
+        u16Pos +=  u16ZCL_APduInstanceWriteNBO ( hAPduInst, u16Pos, eType, ( void* ) au8ZclBenchmarkValue );
+    }
+
+    return u16Pos;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u16ZclBenchmarkRead
+ *
+ * DESCRIPTION:
+ * Reads the attribute record back from the APDU with the ZCIF functions,
+ * as a received read attributes response or report is parsed
+ *
+ * RETURNS:
+ * Bytes read
+ *
+ ****************************************************************************/
+PRIVATE uint16 APP_u16ZclBenchmarkRead ( PDUM_thAPduInstance         hAPduInst,
+                                         teZCL_ZCLAttributeType      eType )
+{
+    tsZCL_LongOctetString    sString;
+    uint16                   u16AttributeId;
+    uint16                   u16Elements;
+    uint8                    u8Type;
+    uint8                    u8ElementType;
+    uint16                   u16Pos         =  0;
+    uint16                   i;
+
+    u16Pos +=  u16ZCL_APduInstanceReadNBO ( hAPduInst, u16Pos, E_ZCL_ATTRIBUTE_ID, &u16AttributeId );
+    u16Pos +=  u16ZCL_APduInstanceReadNBO ( hAPduInst, u16Pos, E_ZCL_UINT8,        &u8Type );
+
+    if ( APP_bZclBenchmarkIsString ( eType ) )
+    {
+        if ( ( eType == E_ZCL_OSTRING ) || ( eType == E_ZCL_CSTRING ) )
+        {
+            ( ( tsZCL_OctetString* ) &sString )->u8MaxLength =  ZCL_BENCHMARK_STRING_LENGTH;
+            ( ( tsZCL_OctetString* ) &sString )->pu8Data     =  au8ZclBenchmarkStringRead;
+        }
+        else
+        {
+            sString.u16MaxLength =  ZCL_BENCHMARK_STRING_LENGTH;
+            sString.pu8Data      =  au8ZclBenchmarkStringRead;
+        }
+        u16Pos +=  u16ZCL_APduInstanceReadStringNBO ( hAPduInst, u16Pos, eType, &sString );
+    }
+    else if ( eType == E_ZCL_ARRAY )
+    {
+        u16Pos +=  u16ZCL_APduInstanceReadNBO ( hAPduInst, u16Pos, E_ZCL_UINT8,  &u8ElementType );
+        u16Pos +=  u16ZCL_APduInstanceReadNBO ( hAPduInst, u16Pos, E_ZCL_UINT16, &u16Elements );
+        for ( i = 0; ( i < u16Elements ) && ( i < ZCL_BENCHMARK_ARRAY_ELEMENTS ); i++ )
+        {
+            u16Pos +=  u16ZCL_APduInstanceReadNBO ( hAPduInst, u16Pos, E_ZCL_UINT16, &au16ZclBenchmarkArray[i] );
+        }
+    }
+    else
+    {
+        u16Pos +=  u16ZCL_APduInstanceReadNBO ( hAPduInst, u16Pos, eType, au64ZclBenchmarkRead );
+    }
+
+    return u16Pos;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u16ZclBenchmarkForward
+ *
+ * DESCRIPTION:
+ * Writes the value read back as the host gets it in a report, with
+ * APP_u16ZncReadDataPattern, and the length ahead of strings as the host
+ * sends them back. Types the bridge does not forward are given in the ZCL
+ * size, most significant byte first, as the host would write them
+ *
+ * RETURNS:
+ * Host bytes
+ *
+ ****************************************************************************/
+PRIVATE uint16 APP_u16ZclBenchmarkForward ( uint8*                      pu8Host,
+                                            const tsZclBenchmarkType*   psType )
+{
+    tsZCL_LongOctetString    sString;
+    uint16                   u16Size;
+    uint16                   i;
+
+    if ( ( psType->eType == E_ZCL_OSTRING ) || ( psType->eType == E_ZCL_CSTRING ) )
+    {
+        ( ( tsZCL_OctetString* ) &sString )->u8Length =  ZCL_BENCHMARK_STRING_LENGTH;
+        ( ( tsZCL_OctetString* ) &sString )->pu8Data  =  au8ZclBenchmarkStringRead;
+        pu8Host[0] =  ZCL_BENCHMARK_STRING_LENGTH;
+        return 1 + APP_u16ZncReadDataPattern ( &pu8Host[1], psType->eType, &sString, ZCL_BENCHMARK_STRING_LENGTH );
+    }
+    if ( APP_bZclBenchmarkIsString ( psType->eType ) )
+    {
+        sString.u16Length =  ZCL_BENCHMARK_STRING_LENGTH;
+        sString.pu8Data   =  au8ZclBenchmarkStringRead;
+        u16Size =  0;
+        ZNC_BUF_U16_UPD ( &pu8Host[0], ZCL_BENCHMARK_STRING_LENGTH, u16Size );
+        return u16Size + APP_u16ZncReadDataPattern ( &pu8Host[u16Size], psType->eType, &sString, ZCL_BENCHMARK_STRING_LENGTH );
+    }
+    if ( psType->eType == E_ZCL_ARRAY )
+    {
+        u16Size =  0;
+        ZNC_BUF_U8_UPD  ( &pu8Host[ u16Size ], E_ZCL_UINT16,                   u16Size );
+        ZNC_BUF_U16_UPD ( &pu8Host[ u16Size ], ZCL_BENCHMARK_ARRAY_ELEMENTS,   u16Size );
+        for ( i = 0; i < ZCL_BENCHMARK_ARRAY_ELEMENTS; i++ )
+        {
+            u16Size +=  APP_u16ZncReadDataPattern ( &pu8Host[ u16Size ], E_ZCL_UINT16, &au16ZclBenchmarkArray[i], 1 );
+        }
+        return u16Size;
+    }
+
+    u16Size =  APP_u16ZncReadDataPattern ( pu8Host, psType->eType, au64ZclBenchmarkRead, 1 );
+    if ( u16Size == 0 )
+    {
+        u16Size =  psType->u8Size;
+        for ( i = 0; i < u16Size; i++ )
+        {
+            /* Keys go as they are on air */
+            pu8Host[i] =  ( ( uint8* ) au64ZclBenchmarkRead ) [ ( psType->eType == E_ZCL_KEY_128 ) ? i : u16Size - 1 - i ];
+        }
+    }
+
+    return u16Size;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_u16ZclBenchmarkEncode
+ *
+ * DESCRIPTION:
+ * Encodes the value from host bytes as APP_eSendWriteAttributesRequest
+ * does, with APP_u16ZncWriteDataPattern, array elements one at a time
+ *
+ * RETURNS:
+ * Bytes encoded
+ *
+ ****************************************************************************/
+PRIVATE uint16 APP_u16ZclBenchmarkEncode ( uint8*                      pu8Data,
+                                           teZCL_ZCLAttributeType      eType,
+                                           uint8*                      pu8Host,
+                                           uint16                      u16HostSize )
+{
+    uint16    u16Offset  =  0;
+    uint16    i;
+
+    ZNC_BUF_U16_UPD ( &pu8Data[ u16Offset ], ZCL_BENCHMARK_ATTRIBUTE_ID,   u16Offset );
+    ZNC_BUF_U8_UPD  ( &pu8Data[ u16Offset ], eType,                        u16Offset );
+
+    if ( eType == E_ZCL_ARRAY )
+    {
+        u16Offset +=  APP_u16ZncWriteDataPattern ( &pu8Data[ u16Offset ], E_ZCL_UINT8,  &pu8Host[0], sizeof ( uint8 ) );
+        u16Offset +=  APP_u16ZncWriteDataPattern ( &pu8Data[ u16Offset ], E_ZCL_UINT16, &pu8Host[1], sizeof ( uint16 ) );
+        for ( i = 3; i < u16HostSize; i += sizeof ( uint16 ) )
+        {
+            u16Offset +=  APP_u16ZncWriteDataPattern ( &pu8Data[ u16Offset ], E_ZCL_UINT16, &pu8Host[i], sizeof ( uint16 ) );
+        }
+    }
+    else
+    {
+        u16Offset +=  APP_u16ZncWriteDataPattern ( &pu8Data[ u16Offset ], eType, pu8Host, u16HostSize );
+    }
+
+    return u16Offset;
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_bZclBenchmarkIsString
+ *
+ * DESCRIPTION:
+ * Whether the type is one of the four ZCL string types
+ *
+ * RETURNS:
+ * TRUE for a string type
+ *
+ ****************************************************************************/
+PRIVATE bool_t APP_bZclBenchmarkIsString ( teZCL_ZCLAttributeType      eType )
+{
+    return ( ( eType == E_ZCL_OSTRING )  ||
+             ( eType == E_ZCL_CSTRING )  ||
+             ( eType == E_ZCL_LOSTRING ) ||
+             ( eType == E_ZCL_LCSTRING ) );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -89,6 +89,34 @@
 
 #include "app.h"
 
+#ifdef APS_QUEUE
+#include "app_aps_queue.h"
+#endif
+#ifdef CHILD_QUEUE
+#include "app_child_queue.h"
+#endif
+
+#ifdef REPORT_FILTER
+#include "app_report_filter.h"
+#endif
+#ifdef ATTRIBUTE_CACHE
+#include "app_attribute_cache.h"
+#endif
+#ifdef DEVICE_INTERVIEW
+#include "app_device_interview.h"
+#endif
+
+#ifdef OTA_FLEET
+#include "app_ota_fleet.h"
+#endif
+#include "app_ota_server.h"
+#ifdef OTA_STORE
+#include "app_ota_store.h"
+#endif
+#ifdef STACK_WATERMARK
+#include "app_stack_watermark.h"
+#endif
+
 #ifdef DEBUG_ZCL
 #define TRACE_ZCL                     TRUE
 #else
@@ -105,9 +133,27 @@
 /***        Macro Definitions                                             ***/
 /****************************************************************************/
 #define ALIGN(n, v)     ( ((uint32)(v) + ((n) - 1)) & (~((n) - 1)) )
+
+/* APP_tsZncAttributeType u8Format: ZCL encoding in the top bits, bytes on air
+ * (prefix excluded for strings) in the low bits */
+#define APP_ZNC_TYPE_SIZE_MASK      0x1F
+#define APP_ZNC_TYPE_KIND_MASK      0xE0
+#define APP_ZNC_TYPE_NONE           0x00    /* not encoded by the bridge */
+#define APP_ZNC_TYPE_SWAP           0x20    /* low bytes of the host value, reversed */
+#define APP_ZNC_TYPE_COPY           0x40    /* host bytes as they are */
+#define APP_ZNC_TYPE_STRING8        0x60    /* 8 bit length then data */
+#define APP_ZNC_TYPE_STRING16       0x80    /* 16 bit length then data */
+
+#define APP_ZNC_SWAP(n)             ( APP_ZNC_TYPE_SWAP | (n) )
 /****************************************************************************/
 /***        Type Definitions                                              ***/
 /****************************************************************************/
+/* How a ZCL data type travels over the serial link and over the air */
+typedef struct
+{
+    uint8    u8HostSize;    /* bytes per element on the serial link, 0 if not forwarded */
+    uint8    u8Format;      /* APP_ZNC_TYPE_ kind | bytes on air */
+} APP_tsZncAttributeType;
 
 
 
@@ -125,6 +171,9 @@ PRIVATE  teZCL_Status APP_ZCL_eCLD_ThermostatCommandHandler(ZPS_tsAfEvent
 #ifdef FULL_FUNC_DEVICE
 PRIVATE void APP_ZCL_cbZllUtilityCallback ( tsZCL_CallBackEvent*    psEvent );
 #endif
+PRIVATE void APP_vZncSwapBytes ( uint8*          pu8Dst,
+                                 const uint8*    pu8Src,
+                                 uint8           u8Width );
 
 teZCL_Status eApp_ZLO_RegisterEndpoint ( tfpZCL_ZCLCallBackFunction    fptr );
 void vAPP_ZCL_DeviceSpecific_Init ( void );
@@ -154,6 +203,76 @@ tsZllEndpointInfoTable       sEndpointTable;
 tsZllGroupInfoTable          sGroupTable;
 #endif
 
+/* Indexed by teZCL_ZCLAttributeType, types not listed are neither forwarded
+ * nor encoded. Host sizes are those the serial link protocol has always used:
+ * 24 bit types travel as 32 bit and 56 bit types as 64 bit */
+PRIVATE const APP_tsZncAttributeType asZncAttributeTypes [ 256 ] =
+{
+    [ E_ZCL_GINT8 ]          =  { 1,  APP_ZNC_SWAP ( 1 ) },
+    [ E_ZCL_GINT16 ]         =  { 2,  APP_ZNC_SWAP ( 2 ) },
+    [ E_ZCL_GINT24 ]         =  { 0,  APP_ZNC_SWAP ( 3 ) },
+    [ E_ZCL_GINT32 ]         =  { 0,  APP_ZNC_SWAP ( 4 ) },
+    [ E_ZCL_GINT40 ]         =  { 0,  APP_ZNC_SWAP ( 5 ) },
+    [ E_ZCL_GINT48 ]         =  { 0,  APP_ZNC_SWAP ( 6 ) },
+    [ E_ZCL_GINT56 ]         =  { 0,  APP_ZNC_SWAP ( 7 ) },
+    [ E_ZCL_GINT64 ]         =  { 0,  APP_ZNC_SWAP ( 8 ) },
+
+    [ E_ZCL_BOOL ]           =  { 1,  APP_ZNC_SWAP ( 1 ) },
+
+    [ E_ZCL_BMAP8 ]          =  { 1,  APP_ZNC_SWAP ( 1 ) },
+    [ E_ZCL_BMAP16 ]         =  { 2,  APP_ZNC_SWAP ( 2 ) },
+    [ E_ZCL_BMAP24 ]         =  { 0,  APP_ZNC_SWAP ( 3 ) },
+    [ E_ZCL_BMAP32 ]         =  { 4,  APP_ZNC_SWAP ( 4 ) },
+    [ E_ZCL_BMAP40 ]         =  { 0,  APP_ZNC_SWAP ( 5 ) },
+    [ E_ZCL_BMAP48 ]         =  { 0,  APP_ZNC_SWAP ( 6 ) },
+    [ E_ZCL_BMAP56 ]         =  { 0,  APP_ZNC_SWAP ( 7 ) },
+    [ E_ZCL_BMAP64 ]         =  { 0,  APP_ZNC_SWAP ( 8 ) },
+
+    [ E_ZCL_UINT8 ]          =  { 1,  APP_ZNC_SWAP ( 1 ) },
+    [ E_ZCL_UINT16 ]         =  { 2,  APP_ZNC_SWAP ( 2 ) },
+    [ E_ZCL_UINT24 ]         =  { 4,  APP_ZNC_SWAP ( 3 ) },
+    [ E_ZCL_UINT32 ]         =  { 4,  APP_ZNC_SWAP ( 4 ) },
+    [ E_ZCL_UINT40 ]         =  { 5,  APP_ZNC_SWAP ( 5 ) },
+    [ E_ZCL_UINT48 ]         =  { 6,  APP_ZNC_SWAP ( 6 ) },
+    [ E_ZCL_UINT56 ]         =  { 8,  APP_ZNC_SWAP ( 7 ) },
+    [ E_ZCL_UINT64 ]         =  { 8,  APP_ZNC_SWAP ( 8 ) },
+
+    [ E_ZCL_INT8 ]           =  { 1,  APP_ZNC_SWAP ( 1 ) },
+    [ E_ZCL_INT16 ]          =  { 2,  APP_ZNC_SWAP ( 2 ) },
+    [ E_ZCL_INT24 ]          =  { 4,  APP_ZNC_SWAP ( 3 ) },
+    [ E_ZCL_INT32 ]          =  { 0,  APP_ZNC_SWAP ( 4 ) },
+    [ E_ZCL_INT40 ]          =  { 0,  APP_ZNC_SWAP ( 5 ) },
+    [ E_ZCL_INT48 ]          =  { 0,  APP_ZNC_SWAP ( 6 ) },
+    [ E_ZCL_INT56 ]          =  { 0,  APP_ZNC_SWAP ( 7 ) },
+    [ E_ZCL_INT64 ]          =  { 0,  APP_ZNC_SWAP ( 8 ) },
+
+    [ E_ZCL_ENUM8 ]          =  { 1,  APP_ZNC_SWAP ( 1 ) },
+    [ E_ZCL_ENUM16 ]         =  { 2,  APP_ZNC_SWAP ( 2 ) },
+
+    [ E_ZCL_FLOAT_SEMI ]     =  { 0,  APP_ZNC_SWAP ( 2 ) },
+    [ E_ZCL_FLOAT_SINGLE ]   =  { 4,  APP_ZNC_SWAP ( 4 ) },
+    [ E_ZCL_FLOAT_DOUBLE ]   =  { 0,  APP_ZNC_SWAP ( 8 ) },
+
+    [ E_ZCL_OSTRING ]        =  { 1,  APP_ZNC_TYPE_STRING8 },
+    [ E_ZCL_CSTRING ]        =  { 1,  APP_ZNC_TYPE_STRING8 },
+    [ E_ZCL_LOSTRING ]       =  { 2,  APP_ZNC_TYPE_STRING16 },
+    [ E_ZCL_LCSTRING ]       =  { 2,  APP_ZNC_TYPE_STRING16 },
+
+    /* Forwarded as a list of uint16, never written */
+    [ E_ZCL_STRUCT ]         =  { 2,  APP_ZNC_TYPE_NONE },
+
+    [ E_ZCL_TOD ]            =  { 4,  APP_ZNC_SWAP ( 4 ) },
+    [ E_ZCL_DATE ]           =  { 4,  APP_ZNC_SWAP ( 4 ) },
+    [ E_ZCL_UTCT ]           =  { 4,  APP_ZNC_SWAP ( 4 ) },
+
+    [ E_ZCL_CLUSTER_ID ]     =  { 2,  APP_ZNC_SWAP ( 2 ) },
+    [ E_ZCL_ATTRIBUTE_ID ]   =  { 2,  APP_ZNC_SWAP ( 2 ) },
+    [ E_ZCL_BACNET_OID ]     =  { 4,  APP_ZNC_SWAP ( 4 ) },
+
+    [ E_ZCL_IEEE_ADDR ]      =  { 8,  APP_ZNC_SWAP ( 8 ) },
+    [ E_ZCL_KEY_128 ]        =  { 0,  APP_ZNC_TYPE_COPY | E_ZCL_KEY_128_SIZE },
+};
+
 /****************************************************************************/
 /***        Exported Functions                                            ***/
 /****************************************************************************/
@@ -264,7 +383,11 @@ void APP_vHandleZclEvents ( ZPS_tsAfEvent*    psStackEvent )
 
         case ZPS_EVENT_APS_DATA_INDICATION:
             if (sZllState.u8RawMode == RAW_MODE_HYBRID)
-                    Znc_vSendDataIndicationToHost(psStackEvent, au8LinkTxBuffer);
+            {
+                Znc_vSendDataIndicationToHost(psStackEvent, au8LinkTxBuffer);
+                /* Don't let the endpoint callback send it a second time */
+                bDataIndicationForwarded =  TRUE;
+            }
 
             vLog_Printf(TRACE_ZCL,LOG_DEBUG, "\nDATA: SEP=%d DEP=%d Profile=%04x Cluster=%04x \n",
                     psStackEvent->uEvent.sApsDataIndEvent.u8SrcEndpoint,
@@ -275,6 +398,15 @@ void APP_vHandleZclEvents ( ZPS_tsAfEvent*    psStackEvent )
             break;
 
         case ZPS_EVENT_APS_DATA_CONFIRM:
+#ifdef APS_QUEUE
+            APP_vApsQueueConfirm ( psStackEvent->uEvent.sApsDataConfirmEvent.u8SequenceNum );
+#endif
+#ifdef CHILD_QUEUE
+            APP_vChildQueueDataConfirm ( &psStackEvent->uEvent.sApsDataConfirmEvent );
+#endif
+#ifdef OTA_FLEET
+            APP_vOtaFleetDataConfirm ( );
+#endif
         	vLog_Printf(1,LOG_DEBUG, "\nCFM: SEP=%d DEP=%d Status=%d \n",
 					psStackEvent->uEvent.sApsDataConfirmEvent.u8SrcEndpoint,
 					psStackEvent->uEvent.sApsDataConfirmEvent.u8DstEndpoint,
@@ -350,6 +482,7 @@ void APP_vHandleZclEvents ( ZPS_tsAfEvent*    psStackEvent )
     sCallBackEvent.eEventType = E_ZCL_CBET_ZIGBEE_EVENT;
     sCallBackEvent.pZPSevent = psStackEvent;
     vZCL_EventHandler(&sCallBackEvent);
+    bDataIndicationForwarded =  FALSE;
 
 }
 
@@ -447,11 +580,12 @@ PRIVATE void APP_ZCL_cbEndpointCallback ( tsZCL_CallBackEvent*    psEvent )
     uint16                 u16Length =  0;
     uint8                  au8LinkTxBuffer[256];
     uint8     				u8LinkQuality;
-    u8LinkQuality=psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8LinkQuality;
+    /* Timer events, such as the OTA page request enabling the ms timer, come without a stack event */
+    u8LinkQuality =  ( psEvent->pZPSevent != NULL ) ? psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8LinkQuality : 0;
 
     u16Length =  0;
 
-    if (sZllState.u8RawMode == RAW_MODE_ON){
+    if ( ( sZllState.u8RawMode == RAW_MODE_ON ) && ( psEvent->pZPSevent != NULL ) ){
         ZPS_tsAfEvent* psStackEvent = psEvent->pZPSevent;
         if (tmpSqn!=(psEvent->u8TransactionSequenceNumber+psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr))
         {
@@ -482,9 +616,21 @@ PRIVATE void APP_ZCL_cbEndpointCallback ( tsZCL_CallBackEvent*    psEvent )
     	}
         break;
 
+#ifdef DEVICE_INTERVIEW
+        case E_ZCL_CBET_READ_ATTRIBUTES_RESPONSE:
+            /* After the individual attribute events of the same frame */
+            APP_vDeviceInterviewZclResponse ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr,
+                                              psEvent->u8TransactionSequenceNumber,
+                                              psEvent->pZPSevent->uEvent.sApsDataIndEvent.u16ClusterId,
+                                              TRUE );
+            break;
+
+#endif
         case E_ZCL_CBET_LOCK_MUTEX:
         case E_ZCL_CBET_UNLOCK_MUTEX:
+#ifndef DEVICE_INTERVIEW
         case E_ZCL_CBET_READ_ATTRIBUTES_RESPONSE:
+#endif
         case E_ZCL_CBET_TIMER:
         case E_ZCL_CBET_ZIGBEE_EVENT:
             //vLog_Printf(TRACE_ZCL, "EP EVT:No action\r\n");
@@ -511,6 +657,12 @@ PRIVATE void APP_ZCL_cbEndpointCallback ( tsZCL_CallBackEvent*    psEvent )
         case E_ZCL_CBET_DEFAULT_RESPONSE:
         {
             vLog_Printf ( TRACE_ZCL, LOG_DEBUG, " (E_ZCL_CBET_DEFAULT_RESPONSE)" );
+#ifdef DEVICE_INTERVIEW
+            APP_vDeviceInterviewZclResponse ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr,
+                                              psEvent->u8TransactionSequenceNumber,
+                                              psEvent->pZPSevent->uEvent.sApsDataIndEvent.u16ClusterId,
+                                              ( psEvent->uMessage.sDefaultResponse.u8StatusCode == E_ZCL_CMDS_SUCCESS ) );
+#endif
 
             if( psEvent->psClusterInstance != NULL )
             {
@@ -534,7 +686,6 @@ PRIVATE void APP_ZCL_cbEndpointCallback ( tsZCL_CallBackEvent*    psEvent )
         {
             uint16    u16SizeOfAttribute = 0;
             uint8     u16Elements =  0;
-            uint16    i =  0;
             switch ( psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType )
             {
             case(E_ZCL_OSTRING):
@@ -593,84 +744,70 @@ PRIVATE void APP_ZCL_cbEndpointCallback ( tsZCL_CallBackEvent*    psEvent )
 
 				ZNC_BUF_U8_UPD  ( &au8LinkTxBuffer [u16Length],  psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType,  u16Length );
 				ZNC_BUF_U16_UPD ( &au8LinkTxBuffer [u16Length],  u16SizeOfAttribute,                                                 u16Length );
-				if ( u16SizeOfAttribute !=  0 )
-				{
-					while ( i <  u16Elements )
-					{
-						vLog_Printf(TRACE_ZB_CONTROLBRIDGE_TASK,LOG_DEBUG,"\nElement : %d\n",i);
-						if( ( psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType ==  E_ZCL_OSTRING ) ||
-							( psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType ==  E_ZCL_CSTRING ) )
-						{
-							tsZCL_OctetString sString = *( ( tsZCL_OctetString* ) psEvent->uMessage.sIndividualAttributeResponse.pvAttributeData );
-							ZNC_BUF_U8_UPD  ( &au8LinkTxBuffer [u16Length],   ( ( uint8* ) sString.pu8Data )[i],    u16Length );
-						}
-						else if ( ( psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType ==  E_ZCL_LOSTRING ) ||
-								  ( psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType ==  E_ZCL_LCSTRING ) )
-						{
-							tsZCL_LongOctetString sString =  *( ( tsZCL_LongOctetString* ) psEvent->uMessage.sIndividualAttributeResponse.pvAttributeData );
-							ZNC_BUF_U8_UPD  ( &au8LinkTxBuffer [u16Length],   ( ( uint8* ) sString.pu8Data )[i],    u16Length );
-						}
-						else if ( ( psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType ==  E_ZCL_FLOAT_SINGLE ) ||
-								( psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType ==  E_ZCL_FLOAT_DOUBLE ) ||
-								( psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType ==  E_ZCL_UINT32 )||
-								( psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType ==  E_ZCL_INT24 )||
-								( psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType ==  E_ZCL_UINT24 ))
-						{
-							uint32    u32value =  *( ( uint32* ) psEvent->uMessage.sIndividualAttributeResponse.pvAttributeData );
-							ZNC_BUF_U32_UPD  ( &au8LinkTxBuffer [u16Length],   u32value,    u16Length );
-
-
-						}else if ( psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType ==  E_ZCL_UINT48  )
-						{
-							App_u16BufferReadNBO ( &au8LinkTxBuffer [u16Length],  "z",  psEvent->uMessage.sIndividualAttributeResponse.pvAttributeData);
-							u16Length += 6;
-
-
-						}
-						else if ( u16SizeOfAttribute / u16Elements == sizeof(uint8) )
-						{
-							vLog_Printf(TRACE_ZB_CONTROLBRIDGE_TASK,LOG_DEBUG,"uint8\n",i);
-							uint8    u8value =  *( ( uint8* ) psEvent->uMessage.sIndividualAttributeResponse.pvAttributeData );
-							ZNC_BUF_U8_UPD  ( &au8LinkTxBuffer [u16Length],   u8value,    u16Length );
-						}
-
-						else if ( u16SizeOfAttribute / u16Elements == sizeof(uint16) )
-						{
-
-							if (psEvent->uMessage.sIndividualAttributeResponse.pvAttributeData!=NULL)
-							{
-								App_u16BufferReadNBO ( &au8LinkTxBuffer [u16Length],  "h",  psEvent->uMessage.sIndividualAttributeResponse.pvAttributeData);
-								u16Length += sizeof(uint16);
-							}
-							vLog_Printf(TRACE_ZB_CONTROLBRIDGE_TASK,LOG_DEBUG,"uint16\n",i);
-						}
-
-						else if ( u16SizeOfAttribute / u16Elements == sizeof(uint32) )
-						{
-							App_u16BufferReadNBO ( &au8LinkTxBuffer [u16Length],  "w",  psEvent->uMessage.sIndividualAttributeResponse.pvAttributeData);
-							u16Length += sizeof(uint32);
-						}
-						else if ( u16SizeOfAttribute / u16Elements == sizeof(uint64) )
-						{
-							App_u16BufferReadNBO ( &au8LinkTxBuffer [u16Length],  "l",  psEvent->uMessage.sIndividualAttributeResponse.pvAttributeData);
-							u16Length += sizeof(uint64);
-						}
-
-						i++;
-					}
-				}
+				u16Length +=  APP_u16ZncReadDataPattern ( &au8LinkTxBuffer [u16Length],
+				                                         psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType,
+				                                         psEvent->uMessage.sIndividualAttributeResponse.pvAttributeData,
+				                                         u16Elements );
            // }
 
+#ifdef ATTRIBUTE_CACHE
+            /* Type, size and value follow the 9 bytes of sequence number,
+             * address, endpoint, cluster, attribute and status above */
+            if ( ( psEvent->eEventType != E_ZCL_CBET_WRITE_ATTRIBUTES_RESPONSE ) &&
+                 ( psEvent->uMessage.sIndividualAttributeResponse.eAttributeStatus == E_ZCL_CMDS_SUCCESS ) )
+            {
+                tsZCL_HeaderParams    sZCL_HeaderParams;
+
+                u16ZCL_ReadCommandHeader ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.hAPduInst, &sZCL_HeaderParams );
+                if ( !sZCL_HeaderParams.bManufacturerSpecific )
+                {
+                    APP_vAttributeCacheStore ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr,
+                                               psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8SrcEndpoint,
+                                               psEvent->pZPSevent->uEvent.sApsDataIndEvent.u16ClusterId,
+                                               psEvent->uMessage.sIndividualAttributeResponse.u16AttributeEnum,
+                                               &au8LinkTxBuffer[9],
+                                               u16Length - 9,
+                                               u8LinkQuality );
+                }
+            }
+#endif
+#ifdef DEVICE_INTERVIEW
+            /* Attribute, status, type, size and value follow the 6 bytes of
+             * sequence number, address, endpoint and cluster above */
+            if ( psEvent->eEventType == E_ZCL_CBET_READ_INDIVIDUAL_ATTRIBUTE_RESPONSE )
+            {
+                APP_vDeviceInterviewAttribute ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr,
+                                                psEvent->u8TransactionSequenceNumber,
+                                                psEvent->pZPSevent->uEvent.sApsDataIndEvent.u16ClusterId,
+                                                &au8LinkTxBuffer[6],
+                                                u16Length - 6 );
+            }
+#endif
+
             if((psEvent->eEventType == E_ZCL_CBET_READ_INDIVIDUAL_ATTRIBUTE_RESPONSE))
                 vSL_WriteMessage ( E_SL_MSG_READ_ATTRIBUTE_RESPONSE,
                                    u16Length,
                                    au8LinkTxBuffer,
                                    u8LinkQuality );
             else if((psEvent->eEventType == E_ZCL_CBET_REPORT_INDIVIDUAL_ATTRIBUTE))
+            {
+#ifdef REPORT_FILTER
+                /* Value starts after the 12 byte header built above */
+                if ( APP_bReportFilterForward ( psEvent->u8TransactionSequenceNumber,
+                                                psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr,
+                                                psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8SrcEndpoint,
+                                                psEvent->pZPSevent->uEvent.sApsDataIndEvent.u16ClusterId,
+                                                psEvent->uMessage.sIndividualAttributeResponse.u16AttributeEnum,
+                                                psEvent->uMessage.sIndividualAttributeResponse.eAttributeDataType,
+                                                &au8LinkTxBuffer[12],
+                                                u16Length - 12,
+                                                u8LinkQuality ) )
+#endif
                 vSL_WriteMessage ( E_SL_MSG_REPORT_IND_ATTR_RESPONSE,
                                    u16Length,
                                    au8LinkTxBuffer,
                                    u8LinkQuality );
+            }
             else if((psEvent->eEventType == E_ZCL_CBET_WRITE_ATTRIBUTES_RESPONSE))
                 vSL_WriteMessage ( E_SL_MSG_WRITE_ATTRIBUTE_RESPONSE,
                                    u16Length,
@@ -949,10 +1086,36 @@ PRIVATE void APP_ZCL_cbEndpointCallback ( tsZCL_CallBackEvent*    psEvent )
 							vLog_Printf ( TRACE_ZCL, LOG_DEBUG, "bPageReqRespSpacing: %02x\r\n", psCallBackMessage->sPageReqServerParams.bPageReqRespSpacing);
 							vLog_Printf ( TRACE_ZCL, LOG_DEBUG, "sReceiveEventAddress: %08x\r\n", psCallBackMessage->sPageReqServerParams.sReceiveEventAddress );
 							vLog_Printf ( TRACE_ZCL, LOG_DEBUG, "u16DataSent: %08x\r\n", psCallBackMessage->sPageReqServerParams.u16DataSent );
-
+                            psCallBackMessage->uMessage.sImagePageRequestPayload.u8MaxDataSize =
+                                APP_u8OtaServerBlockSize ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr,
+                                                           psCallBackMessage->uMessage.sImagePageRequestPayload.u8MaxDataSize );
+#ifdef OTA_FLEET
+                            APP_vOtaFleetPageRequest ( psEvent, psCallBackMessage );
+#endif
+                            /* The payload is not a block request: the cluster sends the
+                             * page as timed block requests, which come back as their own
+                             * E_CLD_OTA_COMMAND_BLOCK_REQUEST events */
                         }
+                        break;
+
                         case E_CLD_OTA_COMMAND_BLOCK_REQUEST:
                         {
+                            /* Never ask the host for more than a single frame to this client can carry */
+                            psCallBackMessage->uMessage.sBlockRequestPayload.u8MaxDataSize =
+                                APP_u8OtaServerBlockSize ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr,
+                                                           psCallBackMessage->uMessage.sBlockRequestPayload.u8MaxDataSize );
+#ifdef OTA_STORE
+                            if ( APP_bOtaStoreBlockRequest ( psEvent, psCallBackMessage ) )
+                            {
+                                break;
+                            }
+#endif
+#ifdef OTA_FLEET
+                            if ( APP_bOtaFleetBlockRequest ( psEvent, psCallBackMessage ) )
+                            {
+                                break;
+                            }
+#endif
 
                             vLog_Printf ( TRACE_ZCL, LOG_DEBUG, "E_CLD_OTA_COMMAND_BLOCK_REQUEST\r\n" );
                             vLog_Printf ( TRACE_ZCL, LOG_DEBUG, "SrcAddress: %04x\r\n", psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr );
@@ -997,6 +1160,10 @@ PRIVATE void APP_ZCL_cbEndpointCallback ( tsZCL_CallBackEvent*    psEvent )
                             vLog_Printf ( TRACE_ZCL, LOG_DEBUG, "ImageType: %04x\r\n", psCallBackMessage->uMessage.sUpgradeEndRequestPayload.u16ImageType );
                             vLog_Printf ( TRACE_ZCL, LOG_DEBUG, "ManufacturerCode: %04x\r\n", psCallBackMessage->uMessage.sUpgradeEndRequestPayload.u16ManufacturerCode );
                             vLog_Printf ( TRACE_ZCL, LOG_DEBUG, "Status: %02x\r\n", psCallBackMessage->uMessage.sUpgradeEndRequestPayload.u8Status );
+#ifdef OTA_FLEET
+                            APP_vOtaFleetUpgradeEnd ( psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr,
+                                                      psCallBackMessage->uMessage.sUpgradeEndRequestPayload.u8Status );
+#endif
 
                             ZNC_BUF_U8_UPD   ( &au8LinkTxBuffer [u16Length],          psEvent->pZPSevent->uEvent.sApsDataIndEvent.u8SrcAddrMode,                    u16Length );
                             ZNC_BUF_U16_UPD  ( &au8LinkTxBuffer [u16Length],  psEvent->pZPSevent->uEvent.sApsDataIndEvent.uSrcAddress.u16Addr,              u16Length );
@@ -1012,6 +1179,16 @@ PRIVATE void APP_ZCL_cbEndpointCallback ( tsZCL_CallBackEvent*    psEvent )
                         }
                         break;
 
+#ifdef OTA_FLEET
+                        case E_CLD_OTA_INTERNAL_COMMAND_CO_PROCESSOR_IMAGE_BLOCK_REQUEST:
+                        {
+                            /* Pages of host held images are streamed by app_ota_fleet.c, stop
+                             * the cluster repeating its own single client page session */
+                            psCallBackMessage->sPageReqServerParams.sPageReq.u16PageSize =  0;
+                        }
+                        break;
+#endif
+
                         default:
                         {
                             /* Do nothing */
@@ -1527,75 +1704,22 @@ teZCL_Status eApp_ZLO_RegisterEndpoint ( tfpZCL_ZCLCallBackFunction    fptr )
  * NAME: APP_u16GetAttributeActualSize
  *
  * DESCRIPTION:
- *
+ * Bytes the serial link uses for u16NumberOfItems elements of a ZCL type
  *
  * RETURNS:
- * void
+ * uint16, 0 for types not forwarded to the host
  *
  ****************************************************************************/
 
 PUBLIC uint16 APP_u16GetAttributeActualSize ( uint32    u32Type,
                                               uint16    u16NumberOfItems )
 {
-    uint16    u16Size =  0;
-
-    switch(u32Type)
+    if ( u32Type >= ( sizeof ( asZncAttributeTypes ) / sizeof ( asZncAttributeTypes[0] ) ) )
     {
-        case(E_ZCL_GINT8):
-        case(E_ZCL_UINT8):
-        case(E_ZCL_INT8):
-        case(E_ZCL_ENUM8):
-        case(E_ZCL_BMAP8):
-        case(E_ZCL_BOOL):
-        case(E_ZCL_OSTRING):
-        case(E_ZCL_CSTRING):
-           u16Size = sizeof(uint8);
-        break;
-
-        case(E_ZCL_LOSTRING):
-        case(E_ZCL_LCSTRING):
-        case(E_ZCL_STRUCT):
-        case (E_ZCL_INT16):
-        case (E_ZCL_UINT16):
-        case (E_ZCL_ENUM16):
-        case (E_ZCL_BMAP16): //RAJOUT FRED : https://github.com/fairecasoimeme/ZiGate/issues/167
-        case(E_ZCL_GINT16): //RAJOUT FRED : https://github.com/fairecasoimeme/ZiGate/issues/244
-        case (E_ZCL_CLUSTER_ID):
-        case (E_ZCL_ATTRIBUTE_ID):
-           u16Size = sizeof(uint16);
-        break;
-
-
-        case E_ZCL_UINT24:
-        case E_ZCL_UINT32:
-        case E_ZCL_TOD:
-        case E_ZCL_DATE:
-        case E_ZCL_UTCT:
-        case E_ZCL_BACNET_OID:
-        case E_ZCL_INT24:
-        case E_ZCL_FLOAT_SINGLE:
-        case E_ZCL_BMAP32:
-           u16Size = sizeof(uint32);
-        break;
-
-        case E_ZCL_UINT40:
-        	u16Size = 5;
-        	break;
-        case E_ZCL_UINT48:
-        	u16Size = 6;
-        	break;
-        case E_ZCL_UINT56:
-        case E_ZCL_UINT64:
-        case E_ZCL_IEEE_ADDR:
-           u16Size = sizeof(uint64);
-        break;
-
-        default:
-           u16Size = 0;
-        break;
+        return 0;
     }
 
-    return ( u16Size * u16NumberOfItems );
+    return ( asZncAttributeTypes [ u32Type ].u8HostSize * u16NumberOfItems );
 }
 
 
@@ -1604,10 +1728,12 @@ PUBLIC uint16 APP_u16GetAttributeActualSize ( uint32    u32Type,
  * NAME: APP_u16ZncWriteDataPattern
  *
  * DESCRIPTION:
- *
+ * Encodes a value received from the host, most significant byte first, as
+ * ZCL puts it on air. u32Size is the number of host bytes at pu8Struct; when
+ * it is larger than the ZCL type the low bytes are used.
  *
  * RETURNS:
- * void
+ * uint16, bytes written at pu8Data, 0 if the type cannot be encoded
  *
  ****************************************************************************/
 PUBLIC uint16 APP_u16ZncWriteDataPattern ( uint8*                    pu8Data,
@@ -1615,200 +1741,110 @@ PUBLIC uint16 APP_u16ZncWriteDataPattern ( uint8*                    pu8Data,
                                            uint8*                    pu8Struct,
                                            uint32                    u32Size )
 {
-    switch ( eAttributeDataType )
-    {
-        /* 8 bit integer value */
-        case(E_ZCL_GINT8):
-        case(E_ZCL_UINT8):
-        case(E_ZCL_INT8):
-        case(E_ZCL_ENUM8):
-        case(E_ZCL_BMAP8):
-        case(E_ZCL_BOOL):
-        {
-            *( uint8 * ) pu8Data =  *pu8Struct++;
-            break;
-        }
+    /* The enum is a byte with short enums, wider without */
+    uint32    u32Type =  eAttributeDataType;
+    uint8     u8Format;
+    uint8     u8Width;
+    uint16    u16Length;
 
-        /* 16 bit integer value */
-        case(E_ZCL_GINT16):
-        case(E_ZCL_UINT16):
-        case(E_ZCL_ENUM16):
-        case(E_ZCL_INT16):
-        case(E_ZCL_CLUSTER_ID):
-        case(E_ZCL_ATTRIBUTE_ID):
-        case(E_ZCL_BMAP16):
-        case(E_ZCL_FLOAT_SEMI):
-        {
-            uint16 u16Val;
-            u16Val = (*pu8Struct++) << 8;
-            u16Val |= (*pu8Struct++);
-            // Unsafe due to alignment issues - replaced by memcpy
-            //*(uint16 *)(pu8Struct) = u16Val;
-            memcpy(pu8Data, &u16Val, sizeof(uint16));
-            break;
-        }
-        /* 32 bit integer value */
-        case(E_ZCL_UINT32):
-        case(E_ZCL_INT32):
-        case(E_ZCL_GINT32):
-        case(E_ZCL_BMAP32):
-        case(E_ZCL_UTCT):
-        case(E_ZCL_TOD):
-        case(E_ZCL_DATE):
-        case(E_ZCL_FLOAT_SINGLE):
-        {
-        	uint32 u32Val;
-            u32Val = (*pu8Struct++) << 24;
-			u32Val |= (*pu8Struct++) << 16;
-			u32Val |= (*pu8Struct++) << 8;
-			u32Val |= (*pu8Struct++);
-            memcpy(pu8Data, &u32Val, sizeof(uint32));
-            break;
-        }
-        /* 64 bit integer value */
-        case(E_ZCL_GINT64):
-        case(E_ZCL_UINT64):
-        case(E_ZCL_INT64):
-        case(E_ZCL_BMAP64):
-        case(E_ZCL_IEEE_ADDR):
-        case(E_ZCL_FLOAT_DOUBLE):
-        {
-        	uint64 u64Val;
-            u64Val = (uint64)(*pu8Struct++) << 56;
-			u64Val |= (uint64)(*pu8Struct++) << 48;
-			u64Val |= (uint64)(*pu8Struct++) << 40;
-			u64Val |= (uint64)(*pu8Struct++) << 32;
-			u64Val |= (uint64)(*pu8Struct++) << 24;
-			u64Val |= (uint64)(*pu8Struct++) << 16;
-			u64Val |= (uint64)(*pu8Struct++) << 8;
-			u64Val |= (uint32)(*pu8Struct++);
-            memcpy(pu8Data, &u64Val, sizeof(uint64));
-            break;
-        }
+    if ( u32Type >= ( sizeof ( asZncAttributeTypes ) / sizeof ( asZncAttributeTypes[0] ) ) )
+    {
+        return 0;
+    }
+    u8Format =  asZncAttributeTypes [ u32Type ].u8Format;
+    u8Width  =  u8Format & APP_ZNC_TYPE_SIZE_MASK;
 
-        /* 24-bit stored as 32 bit integer value */
-        case(E_ZCL_GINT24):
-        case(E_ZCL_UINT24):
-        case(E_ZCL_INT24):
-        case(E_ZCL_BMAP24):
-        {
-        	uint32 u32Val;
-            u32Val = (*pu8Struct) << 16;
-            u32Val |= (*pu8Struct++)   << 8;
-            u32Val |= (*pu8Struct++);
-            // account for signed-ness
-            if(eAttributeDataType == E_ZCL_INT24)
+    switch ( u8Format & APP_ZNC_TYPE_KIND_MASK )
+    {
+        case APP_ZNC_TYPE_SWAP:
+            if ( u32Size > u8Width )
             {
-                // sign extend if top bit set
-                if(*pu8Struct &0x80)
-                {
-                    u32Val |= (0xff << 24);
-                }
+                pu8Struct +=  u32Size - u8Width;
             }
-            u32Val = u32Val << 8;
-            memcpy(pu8Data, &u32Val , sizeof(uint32)-1);
-            // increment ptr to keep size calculation correct
-            pu8Struct++;
-            break;
-        }
+            APP_vZncSwapBytes ( pu8Data, pu8Struct, u8Width );
+            return u8Width;
 
-        /* 40-bit stored as 64 bit integer value */
-        case(E_ZCL_GINT40):
-        case(E_ZCL_UINT40):
-        case(E_ZCL_INT40):
-        case(E_ZCL_BMAP40):
-        {
-        	uint64 u64Val;
-            u64Val = (uint64)(*pu8Struct) << 32;
-            u64Val |= (uint64)(*pu8Struct++) << 24;
-			u64Val |= (uint64)(*pu8Struct++) << 16;
-			u64Val |= (uint64)(*pu8Struct++) << 8;
-			u64Val |= (uint64)(*pu8Struct++);
-            // account for signed-ness
-            if(eAttributeDataType == E_ZCL_INT40)
+        case APP_ZNC_TYPE_COPY:
+            memcpy ( pu8Data, pu8Struct, u8Width );
+            return u8Width;
+
+        case APP_ZNC_TYPE_STRING8:
+            u16Length =  1 + pu8Struct [ 0 ];
+            if ( u32Size < u16Length )
             {
-                // sign extend if top bit set
-                if(*pu8Struct &0x80)
-                {
-                    u64Val |= ((uint64)(0xffffff) << 40);
-                }
+                return 0;
             }
-            memcpy(pu8Data, &u64Val, sizeof(uint64));
-            // increment ptr to keep size calculation correct
-            pu8Struct++;
-            break;
-        }
+            memcpy ( pu8Data, pu8Struct, u16Length );
+            return u16Length;
 
-        /* 48-bit stored as 64 bit integer value */
-        case(E_ZCL_GINT48):
-        case(E_ZCL_UINT48):
-        case(E_ZCL_INT48):
-        case(E_ZCL_BMAP48):
-        {
-        	uint64 u64Val;
-            u64Val = (uint64)(*pu8Struct) << 40;
-			u64Val |= (uint64)(*pu8Struct++) << 32;
-			u64Val |= (uint64)(*pu8Struct++) << 24;
-			u64Val |= (uint64)(*pu8Struct++) << 16;
-			u64Val |= (uint64)(*pu8Struct++) << 8;
-			u64Val |= (uint64)(*pu8Struct++);
-            // account for signed-ness
-            if(eAttributeDataType == E_ZCL_INT48)
+        case APP_ZNC_TYPE_STRING16:
+            if ( u32Size < 2 )
             {
-                // sign extend if top bit set
-                if(*pu8Struct &0x80)
-                {
-                    u64Val |= ((uint64)(0xffff) << 48);
-                }
+                return 0;
             }
-            memcpy(pu8Data, &u64Val, sizeof(uint64));
-            // increment ptr to keep size calculation correct
-            pu8Struct++;
-            break;
-        }
-
-        /* 56-bit stored as 64 bit integer value */
-        case(E_ZCL_GINT56):
-        case(E_ZCL_UINT56):
-        case(E_ZCL_INT56):
-        case(E_ZCL_BMAP56):
-        {
-        	uint64 u64Val;
-            u64Val = (uint64)(*pu8Struct) << 48;
-			u64Val |= (uint64)(*pu8Struct++) << 40;
-			u64Val |= (uint64)(*pu8Struct++) << 32;
-			u64Val |= (uint64)(*pu8Struct++) << 24;
-			u64Val |= (uint64)(*pu8Struct++) << 16;
-			u64Val |= (uint64)(*pu8Struct++) << 8;
-			u64Val |= (uint64)(*pu8Struct++);
-            // account for signed-ness
-            if(eAttributeDataType == E_ZCL_INT56)
+            u16Length =  2 + ZNC_RTN_U16 ( pu8Struct, 0 );
+            if ( u32Size < u16Length )
             {
-                // sign extend if top bit set
-                if(*pu8Data &0x80)
-                {
-                    u64Val |= ((uint64)(0xff) << 56);
-                }
+                return 0;
             }
-            memcpy(pu8Data, &u64Val, sizeof(uint64));
-            // increment ptr to keep size calculation correct
-            pu8Struct++;
-            break;
-        }
-        case(E_ZCL_KEY_128):
-            memcpy(pu8Data, pu8Struct, E_ZCL_KEY_128_SIZE);
-            // increment ptr to keep size calculation correct
-            pu8Struct += E_ZCL_KEY_128_SIZE;
-            break;
-        case (E_ZCL_NULL):
-        // unrecognised
+            pu8Data [ 0 ] =  pu8Struct [ 1 ];
+            pu8Data [ 1 ] =  pu8Struct [ 0 ];
+            memcpy ( &pu8Data [ 2 ], &pu8Struct [ 2 ], u16Length - 2 );
+            return u16Length;
+
         default:
-        {
             return 0;
-        }
     }
+}
+
+
+/****************************************************************************
+ *
+ * NAME: APP_u16ZncReadDataPattern
+ *
+ * DESCRIPTION:
+ * Writes u16Elements elements of a decoded attribute value for the host,
+ * most significant byte first, in APP_u16GetAttributeActualSize bytes each.
+ * Strings are passed as their tsZCL_OctetString / tsZCL_LongOctetString and
+ * u16Elements is their length.
+ *
+ * RETURNS:
+ * uint16, bytes written at pu8Data
+ *
+ ****************************************************************************/
+PUBLIC uint16 APP_u16ZncReadDataPattern ( uint8*                    pu8Data,
+                                          teZCL_ZCLAttributeType    eAttributeDataType,
+                                          void*                     pvValue,
+                                          uint16                    u16Elements )
+{
+    const APP_tsZncAttributeType*    psType;
+    uint32                           u32Type =  eAttributeDataType;
+    uint16                           i;
 
-    return (uint16)( u32Size);
+    if ( ( pvValue == NULL ) ||
+         ( u32Type >= ( sizeof ( asZncAttributeTypes ) / sizeof ( asZncAttributeTypes[0] ) ) ) )
+    {
+        return 0;
+    }
+    psType =  &asZncAttributeTypes [ u32Type ];
+
+    switch ( psType->u8Format & APP_ZNC_TYPE_KIND_MASK )
+    {
+        case APP_ZNC_TYPE_STRING8:
+            memcpy ( pu8Data, ( ( tsZCL_OctetString* ) pvValue )->pu8Data, u16Elements );
+            return u16Elements;
+
+        case APP_ZNC_TYPE_STRING16:
+            memcpy ( pu8Data, ( ( tsZCL_LongOctetString* ) pvValue )->pu8Data, u16Elements );
+            return u16Elements;
+
+        default:
+            for ( i = 0; i < u16Elements; i++ )
+            {
+                APP_vZncSwapBytes ( &pu8Data [ i * psType->u8HostSize ], pvValue, psType->u8HostSize );
+            }
+            return ( psType->u8HostSize * u16Elements );
+    }
 }
 
 
@@ -1829,13 +1865,32 @@ PUBLIC void APP_vBdbCallback(BDB_tsBdbEvent *psBdbEvent)
 
     vLog_Printf ( TRACE_ZCL,LOG_DEBUG, "Got bdb event %d\n", psBdbEvent->eEventType);
 
-
+#ifdef STACK_WATERMARK
+    if ( psBdbEvent->eEventType != BDB_EVENT_ZPSAF )
+    {
+        APP_vStackWatermarkEnter ( STACK_WATERMARK_KIND_BDB_EVENT, psBdbEvent->eEventType );
+    }
+    else if ( psBdbEvent->uEventData.sZpsAfEvent.u8EndPoint ==  0 )
+    {
+        APP_vStackWatermarkEnter ( STACK_WATERMARK_KIND_STACK_EVENT,
+                                   psBdbEvent->uEventData.sZpsAfEvent.sStackEvent.eType );
+    }
+    else
+    {
+        APP_vStackWatermarkEnter ( STACK_WATERMARK_KIND_ZCL_EVENT,
+                                   psBdbEvent->uEventData.sZpsAfEvent.sStackEvent.eType );
+    }
+#endif
 
     switch(psBdbEvent->eEventType)
     {
         case BDB_EVENT_NONE:
             break;
         case BDB_EVENT_ZPSAF:                // Use with BDB_tsZpsAfEvent
+            if ( psBdbEvent->uEventData.sZpsAfEvent.sStackEvent.eType == ZPS_EVENT_APS_DATA_INDICATION )
+            {
+                APP_vApsFragmentationRxIndication ( &psBdbEvent->uEventData.sZpsAfEvent.sStackEvent.uEvent.sApsDataIndEvent );
+            }
             if ( psBdbEvent->uEventData.sZpsAfEvent.u8EndPoint ==  0 )
             {
                 APP_vHandleStackEvents ( &psBdbEvent->uEventData.sZpsAfEvent.sStackEvent );
@@ -1882,6 +1937,58 @@ PUBLIC void APP_vBdbCallback(BDB_tsBdbEvent *psBdbEvent)
         default:
             break;
     }
+#ifdef STACK_WATERMARK
+    APP_vStackWatermarkExit ( );
+#endif
+}
+
+/****************************************************************************
+ *
+ * NAME: APP_vZncSwapBytes
+ *
+ * DESCRIPTION:
+ * Copies u8Width bytes in reverse order, the widths of native integers with
+ * a single byte reverse
+ *
+ * RETURNS:
+ * void
+ *
+ ****************************************************************************/
+PRIVATE void APP_vZncSwapBytes ( uint8*          pu8Dst,
+                                 const uint8*    pu8Src,
+                                 uint8           u8Width )
+{
+    uint16    u16Val;
+    uint32    u32Val;
+    uint64    u64Val;
+
+    switch ( u8Width )
+    {
+        case sizeof ( uint16 ):
+            memcpy ( &u16Val, pu8Src, sizeof ( uint16 ) );
+            u16Val =  __builtin_bswap16 ( u16Val );
+            memcpy ( pu8Dst, &u16Val, sizeof ( uint16 ) );
+            break;
+
+        case sizeof ( uint32 ):
+            memcpy ( &u32Val, pu8Src, sizeof ( uint32 ) );
+            u32Val =  __builtin_bswap32 ( u32Val );
+            memcpy ( pu8Dst, &u32Val, sizeof ( uint32 ) );
+            break;
+
+        case sizeof ( uint64 ):
+            memcpy ( &u64Val, pu8Src, sizeof ( uint64 ) );
+            u64Val =  __builtin_bswap64 ( u64Val );
+            memcpy ( pu8Dst, &u64Val, sizeof ( uint64 ) );
+            break;
+
+        default:
+            while ( u8Width-- )
+            {
+                *pu8Dst++ =  pu8Src [ u8Width ];
+            }
+            break;
+    }
 }
 
 PUBLIC uint16 App_u16BufferReadNBO ( uint8         *pu8Struct,
@@ -1930,8 +2037,8 @@ PUBLIC uint16 App_u16BufferReadNBO ( uint8         *pu8Struct,
 			u64Val |= (uint64) *( uint8* )pvData++ << 16;
 			u64Val |= (uint64) *( uint8* )pvData++ << 8;
 			u64Val |= (uint64) *( uint8* )pvData++;
-			(uint64) *( uint8* )pvData++;
-			(uint64) *( uint8* )pvData++;
+			/* skip the two bytes that pad the value to 64 bits */
+			pvData += 2;
 			/*
 			 *  align to long long word (64 bit) boundary
 			 *  but relative to structure start
@@ -178,7 +178,9 @@
 #define CLD_OTA
 #define OTA_SERVER
 #define OTA_PAGE_REQUEST_SUPPORT
-#define OTA_MAX_BLOCK_SIZE                                    64
+/* Ceiling only: blocks are sized per destination to fit one APS frame,
+ * see APP_u8OtaServerBlockLimit */
+#define OTA_MAX_BLOCK_SIZE                                    80
 #define OTA_TIME_INTERVAL_BETWEEN_RETRIES                     5
 //#define OTA_COPY_MAC_ADDRESS
 #define OTA_MAX_IMAGES_PER_ENDPOINT                           1
@@ -0,0 +1,144 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          fuzz_replay.c
+ *
+ * DESCRIPTION:        Runs fuzz target inputs once each without libFuzzer:
+ *                     the corpus in make check, and crash reproducers with
+ *                     any compiler. Arguments are files or directories of
+ *                     them; the exit status is non-zero if one can't be read.
+ *
+ ****************************************************************************
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <dirent.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* libFuzzer's default -max_len */
+#define REPLAY_MAX_INPUT                4096
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+int LLVMFuzzerTestOneInput ( const uint8_t*    pu8Data,
+                             size_t            uSize );
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE uint8_t    au8ReplayInput[REPLAY_MAX_INPUT];
+PRIVATE uint32     u32ReplayRuns;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE bool_t bReplayFile ( const char*    pcPath )
+{
+    FILE*     psFile =  fopen ( pcPath, "rb" );
+    size_t    uSize;
+
+    if ( psFile == NULL )
+    {
+        fprintf ( stderr, "%s: can't open\n", pcPath );
+        return FALSE;
+    }
+    uSize =  fread ( au8ReplayInput, 1, sizeof ( au8ReplayInput ), psFile );
+    fclose ( psFile );
+    LLVMFuzzerTestOneInput ( au8ReplayInput, uSize );
+    u32ReplayRuns++;
+    return TRUE;
+}
+
+PRIVATE bool_t bReplayPath ( const char*    pcPath )
+{
+    DIR*              psDir =  opendir ( pcPath );
+    struct dirent*    psEntry;
+    char              acPath[1024];
+    bool_t            bOk   =  TRUE;
+
+    if ( psDir == NULL )
+    {
+        return bReplayFile ( pcPath );
+    }
+    while ( ( psEntry = readdir ( psDir ) ) != NULL )
+    {
+        if ( psEntry->d_name[0] == '.' )
+        {
+            continue;
+        }
+        snprintf ( acPath, sizeof ( acPath ), "%s/%s", pcPath, psEntry->d_name );
+        bOk &=  bReplayFile ( acPath );
+    }
+    closedir ( psDir );
+    return bOk;
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( int      argc,
+           char*    argv[] )
+{
+    struct timespec    sStart;
+    struct timespec    sEnd;
+    double             dSeconds;
+    bool_t             bOk =  TRUE;
+    int                i;
+
+    clock_gettime ( CLOCK_MONOTONIC, &sStart );
+    for ( i = 1; i < argc; i++ )
+    {
+        bOk &=  bReplayPath ( argv[i] );
+    }
+    clock_gettime ( CLOCK_MONOTONIC, &sEnd );
+    dSeconds =  ( double ) ( sEnd.tv_sec - sStart.tv_sec ) + ( ( double ) ( sEnd.tv_nsec - sStart.tv_nsec ) / 1e9 );
+
+    printf ( "  %u inputs replayed, %.0f execs/s\n",
+             ( unsigned ) u32ReplayRuns,
+             ( dSeconds > 0 ) ? ( u32ReplayRuns / dSeconds ) : 0.0 );
+    return bOk ? 0 : 1;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
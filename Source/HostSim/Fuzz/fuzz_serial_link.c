@@ -0,0 +1,143 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          fuzz_serial_link.c
+ *
+ * DESCRIPTION:        libFuzzer target for the serial command path: every
+ *                     input byte goes through APP_vProcessIncomingSerialCommands,
+ *                     so bSL_ReadMessage decodes it and each frame it accepts
+ *                     reaches the command handlers, then the host runs long
+ *                     enough for queued requests and replies to go out.
+ *
+ *                     The first input byte picks the mode. Even, the rest
+ *                     is a message type and payload that the harness frames
+ *                     with the right length, CRC and escapes, so that the
+ *                     handlers see mutated payloads. Odd, the rest is fed
+ *                     as it is, which exercises the decoder itself.
+ *
+ ****************************************************************************
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "zps_apl_af.h"
+#include "SerialLink.h"
+#include "app_Znc_cmds.h"
+#include "host_sim.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Type and length bytes of a framed input */
+#define FUZZ_FRAMED_HEADER              3
+
+/* Long enough for the queues to drain and the replies to be written */
+#define FUZZ_RUN_MS                     5
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* Feeds a byte, escaped as the host library sends payload bytes */
+PRIVATE void vFuzzPutEscaped ( uint8    u8Byte )
+{
+    if ( u8Byte < 0x10 )
+    {
+        APP_vProcessIncomingSerialCommands ( SL_ESC_CHAR );
+        u8Byte ^=  0x10;
+    }
+    APP_vProcessIncomingSerialCommands ( u8Byte );
+}
+
+PRIVATE void vFuzzFramed ( const uint8*    pu8Data,
+                           size_t          uSize )
+{
+    uint16    u16Type   =  ( uint16 ) ( ( pu8Data[0] << 8 ) | pu8Data[1] );
+    uint16    u16Length =  ( uint16 ) ( uSize - 2 );
+    uint16    i;
+
+    if ( uSize > ( 2 + 0xFFFF ) )
+    {
+        return;
+    }
+    APP_vProcessIncomingSerialCommands ( SL_START_CHAR );
+    vFuzzPutEscaped ( ( uint8 ) ( u16Type >> 8 ) );
+    vFuzzPutEscaped ( ( uint8 ) u16Type );
+    vFuzzPutEscaped ( ( uint8 ) ( u16Length >> 8 ) );
+    vFuzzPutEscaped ( ( uint8 ) u16Length );
+    vFuzzPutEscaped ( u8SL_CalculateCRC ( u16Type, u16Length, ( uint8* ) &pu8Data[2] ) );
+    for ( i = 0; i < u16Length; i++ )
+    {
+        vFuzzPutEscaped ( pu8Data[2 + i] );
+    }
+    APP_vProcessIncomingSerialCommands ( SL_END_CHAR );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int LLVMFuzzerTestOneInput ( const uint8_t*    pu8Data,
+                             size_t            uSize )
+{
+    size_t    i;
+
+    if ( uSize == 0 )
+    {
+        return 0;
+    }
+    HOST_vInit ( );
+    if ( ( pu8Data[0] & 1 ) == 0 )
+    {
+        if ( uSize >= FUZZ_FRAMED_HEADER )
+        {
+            vFuzzFramed ( &pu8Data[1], uSize - 1 );
+        }
+    }
+    else
+    {
+        for ( i = 1; i < uSize; i++ )
+        {
+            APP_vProcessIncomingSerialCommands ( pu8Data[i] );
+        }
+        /* Ends any frame left open so that the next input starts afresh */
+        APP_vProcessIncomingSerialCommands ( SL_END_CHAR );
+    }
+    HOST_vRun ( FUZZ_RUN_MS );
+    HOST_vSerialFlush ( );
+    return 0;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
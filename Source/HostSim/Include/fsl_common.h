@@ -0,0 +1,73 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          fsl_common.h
+ *
+ * DESCRIPTION:        The SDK header, with the cycle counter and debug
+ *                     registers the ZCL benchmark programs moved from their
+ *                     Cortex-M addresses to host variables. Once enabled,
+ *                     CYCCNT runs from CLOCK_MONOTONIC at SystemCoreClock,
+ *                     so cycle counts are host time in core clock units:
+ *                     comparable between runs on one host, not with the
+ *                     target.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef HOST_FSL_COMMON_H_
+#define HOST_FSL_COMMON_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include_next "fsl_common.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#undef DWT
+#undef CoreDebug
+#define DWT                             ( HOST_psDwt ( ) )
+#define CoreDebug                       ( &HOST_sCoreDebug )
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+extern DWT_Type          HOST_sDwt;
+extern CoreDebug_Type    HOST_sCoreDebug;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+/* The DWT registers, CYCCNT brought up to date when it is enabled */
+extern DWT_Type* HOST_psDwt ( void );
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* HOST_FSL_COMMON_H_ */
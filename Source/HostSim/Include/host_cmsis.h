@@ -0,0 +1,62 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          host_cmsis.h
+ *
+ * DESCRIPTION:        Forced include for host builds. The SDK headers pull in
+ *                     the GCC CMSIS intrinsics, whose interrupt enable and
+ *                     disable helpers are Cortex-M instructions; they are
+ *                     renamed out of the way here and replaced by no-ops.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef HOST_CMSIS_H_
+#define HOST_CMSIS_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <stdint.h>
+
+#define __enable_irq                    __host_arm_enable_irq
+#define __disable_irq                   __host_arm_disable_irq
+#include "cmsis_gcc.h"
+#undef __enable_irq
+#undef __disable_irq
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+static inline void __enable_irq ( void ) { }
+static inline void __disable_irq ( void ) { }
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* HOST_CMSIS_H_ */
@@ -0,0 +1,213 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          host_sim.h
+ *
+ * DESCRIPTION:        Host build of the control bridge application. The
+ *                     application sources, ZCIF and the ZCL clusters are
+ *                     compiled for the host and linked against stand-ins for
+ *                     the stack libraries: an APS data service that records
+ *                     every request and confirms it when told to, a PDU
+ *                     manager with the firmware's pool sizes, RAM backed PDM
+ *                     records, a simulated millisecond clock and a serial
+ *                     port that captures the frames the firmware writes.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef HOST_SIM_H_
+#define HOST_SIM_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include "zps_apl_af.h"
+#include "zps_apl_aib.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Stack resources of ControlBridge_Coord_GpProxy.zpscfg */
+#define HOST_ZPS_MAX_APSDE_REQ          5
+#define HOST_ZPS_MAX_APSDE_ACK_REQ      3
+#define HOST_ZPS_NUM_NPDUS              25
+#define HOST_APDU_ZDP_SIZE              200
+#define HOST_APDU_ZDP_INSTANCES         6
+#define HOST_ZPS_APS_WINDOW_SIZE        8
+#define HOST_ZPS_BINDING_TABLE_SIZE     5
+
+/* Binding entries a test can ask for with HOST_vSetBindingTableSize, more
+ * than fit in one E_SL_MSG_PDM_GET_BINDING_TABLE reply */
+#define HOST_BINDING_TABLE_MAX          32
+
+/* Largest unfragmented ASDU to any destination, secured, no source route */
+#define HOST_ZPS_MAX_PAYLOAD            82
+
+/* Data requests remembered for inspection; later ones are counted only */
+#define HOST_DATA_REQ_LOG_SIZE          1024
+#define HOST_DATA_REQ_MAX_PAYLOAD       HOST_APDU_ZDP_SIZE
+
+/* Frames written by the firmware waiting to be read by a test; the
+ * longest is the ZCL benchmark result, a record for each ZCL type */
+#define HOST_SERIAL_TX_FRAMES           512
+#define HOST_SERIAL_MAX_PAYLOAD         1024
+
+/* Bytes of host commands waiting to be read by the firmware, room for a
+ * 200 command burst written at once */
+#define HOST_SERIAL_RX_SIZE             8192
+
+/* Raw bytes written by the firmware kept since the last flush */
+#define HOST_SERIAL_TX_RAW_SIZE         8192
+
+/* Words of the region __StackLimit and _vStackTop bound on host builds */
+#define HOST_STACK_WORDS                4096
+
+/* Internal flash emulated by host_flash.c: the OTA storage area, then the
+ * PDM segments host_pdm.c keeps its records in, and the time charged for a
+ * page erase and for programming one 128 bit word */
+#define HOST_FLASH_PAGE_SIZE            512
+#define HOST_FLASH_PAGES                512
+#define HOST_FLASH_PDM_PAGES            63
+#define HOST_FLASH_ALL_PAGES            ( HOST_FLASH_PAGES + HOST_FLASH_PDM_PAGES )
+#define HOST_FLASH_ERASE_US             2000
+#define HOST_FLASH_PROGRAM_WORD_US      25
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint32    u32TimeMs;
+    uint8     u8ApsSeqNum;
+    uint8     u8DstAddrMode;
+    uint16    u16DstAddr;
+    uint64    u64DstAddr;
+    uint8     u8DstEndpoint;
+    uint8     u8SrcEndpoint;
+    uint16    u16ClusterId;
+    uint16    u16ProfileId;
+    bool_t    bAck;
+    bool_t    bConfirmed;
+    uint16    u16PayloadLength;
+    uint8     au8Payload[HOST_DATA_REQ_MAX_PAYLOAD];
+} tsHostDataReq;
+
+typedef struct
+{
+    uint32    u32TimeMs;
+    uint16    u16Type;
+    uint16    u16Length;
+    bool_t    bCrcOk;
+    uint8     au8Payload[HOST_SERIAL_MAX_PAYLOAD];
+} tsHostSerialFrame;
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+/* host_flash.c */
+extern uint8     au8HostFlash[HOST_FLASH_ALL_PAGES * HOST_FLASH_PAGE_SIZE];
+
+/* host_platform.c */
+extern uint32    au32HostStack[HOST_STACK_WORDS];
+extern uint32    u32HostResets;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+/* host_start.c */
+PUBLIC void HOST_vInit ( void );
+PUBLIC void HOST_vStep ( void );
+PUBLIC void HOST_vRun ( uint32    u32Ms );
+
+/* host_platform.c */
+PUBLIC void HOST_vAdvanceTime ( uint32    u32Ms );
+PUBLIC uint32 HOST_u32TimeMs ( void );
+PUBLIC void HOST_vSerialWrite ( uint16    u16Type,
+                                uint16    u16Length,
+                                const uint8*    pu8Payload );
+PUBLIC bool_t HOST_bSerialRead ( tsHostSerialFrame*    psFrame );
+PUBLIC bool_t HOST_bSerialFind ( uint16    u16Type,
+                                 tsHostSerialFrame*    psFrame );
+PUBLIC void HOST_vSerialFlush ( void );
+PUBLIC uint32 HOST_u32SerialRxPending ( void );
+PUBLIC uint32 HOST_u32SerialTxRaw ( uint8*    pu8Buffer,
+                                    uint32    u32MaxLength );
+
+/* host_flash.c */
+PUBLIC void HOST_vFlashInit ( void );
+PUBLIC uint32 HOST_u32FlashPage ( const void*    pvAddress );
+PUBLIC uint32 HOST_u32FlashEraseCount ( uint32    u32Page );
+PUBLIC uint32 HOST_u32FlashBusyUs ( void );
+PUBLIC void HOST_vFlashPowerFail ( uint32    u32Operations );
+PUBLIC bool_t HOST_bFlashPowerLost ( void );
+PUBLIC void HOST_vFlashPowerRestore ( void );
+
+/* host_pdm.c */
+PUBLIC uint32 HOST_u32PdmSaves ( void );
+PUBLIC uint32 HOST_u32PdmCompactions ( void );
+PUBLIC uint32 HOST_u32PdmCompactionUs ( void );
+PUBLIC uint32 HOST_u32PdmCompactionMaxUs ( void );
+PUBLIC uint32 HOST_u32PdmReadBytes ( void );
+PUBLIC uint32 HOST_u32PdmWriteBytes ( void );
+
+/* host_zps.c */
+PUBLIC void HOST_vZpsInit ( void );
+PUBLIC uint32 HOST_u32DataReqCount ( void );
+PUBLIC tsHostDataReq* HOST_psDataReq ( uint32    u32Index );
+PUBLIC tsHostDataReq* HOST_psDataReqBySeq ( uint8    u8ApsSeqNum );
+PUBLIC uint8 HOST_u8DataReqPending ( void );
+PUBLIC uint32 HOST_u32DataReqRefused ( void );
+PUBLIC bool_t HOST_bDataConfirm ( uint8    u8ApsSeqNum,
+                                  uint8    u8Status );
+PUBLIC bool_t HOST_bDataConfirmOldest ( uint8    u8Status );
+PUBLIC void HOST_vDataIndication ( uint16    u16SrcAddr,
+                                   uint8     u8SrcEndpoint,
+                                   uint8     u8DstEndpoint,
+                                   uint16    u16ClusterId,
+                                   uint16    u16ProfileId,
+                                   const uint8*    pu8Payload,
+                                   uint16    u16Length );
+PUBLIC void HOST_vStackEvent ( uint8    u8Endpoint,
+                               ZPS_tsAfEvent*    psStackEvent );
+PUBLIC void HOST_vAddDevice ( uint16    u16NwkAddr,
+                              uint64    u64IeeeAddr,
+                              bool_t    bSleepyChild );
+PUBLIC void HOST_vSetMaxPayload ( uint16    u16Addr,
+                                  uint8     u8MaxPayload );
+PUBLIC ZPS_tsAplApsmeBindingTable* HOST_psBindingTable ( void );
+PUBLIC void HOST_vSetBindingTableSize ( uint32    u32Size );
+
+/* host_pdum.c */
+PUBLIC uint8 HOST_u8ApduFree ( void );
+PUBLIC uint8 HOST_u8ApduPeak ( void );
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* HOST_SIM_H_ */
@@ -0,0 +1,90 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          host_test.h
+ *
+ * DESCRIPTION:        Checks for the host tests. A failed check prints where
+ *                     it failed and the test carries on; HOST_TEST_END makes
+ *                     the process exit non-zero if any check failed.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <stdio.h>
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define HOST_CHECK(COND)                                                       \
+    do {                                                                       \
+        u32HostChecks++;                                                       \
+        if ( !( COND ) )                                                       \
+        {                                                                      \
+            u32HostFailures++;                                                 \
+            printf ( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #COND ); \
+        }                                                                      \
+    } while ( 0 )
+
+#define HOST_CHECK_EQUAL(ACTUAL, EXPECTED)                                     \
+    do {                                                                       \
+        long long    i64Actual   = ( long long ) ( ACTUAL );                   \
+        long long    i64Expected = ( long long ) ( EXPECTED );                 \
+        u32HostChecks++;                                                       \
+        if ( i64Actual != i64Expected )                                        \
+        {                                                                      \
+            u32HostFailures++;                                                 \
+            printf ( "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, \
+                     #ACTUAL, i64Actual, i64Expected );                        \
+        }                                                                      \
+    } while ( 0 )
+
+#define HOST_TEST(NAME)                                                        \
+    printf ( "%s\n", #NAME );                                                  \
+    NAME ( )
+
+#define HOST_TEST_END()                                                        \
+    printf ( "%u checks, %u failed\n", ( unsigned ) u32HostChecks,            \
+             ( unsigned ) u32HostFailures );                                   \
+    return ( u32HostFailures == 0 ) ? 0 : 1
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+static unsigned int    u32HostChecks;
+static unsigned int    u32HostFailures;
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* HOST_TEST_H_ */
@@ -0,0 +1,81 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          zps_gen.h
+ *
+ * DESCRIPTION:        Stand-in for the header ZPSConfig generates from
+ *                     ControlBridge_Coord_GpProxy.zpscfg, the default
+ *                     firmware configuration, limited to what the
+ *                     application sources use
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+#ifndef _ZPS_GEN_H
+#define _ZPS_GEN_H
+
+/****************************************************************************/
+/***        Include Files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define ZPS_NWK_OPT_ALL
+#define ZPS_NODE_CONTROLBRIDGE
+
+/* Profile 'ZDP' */
+#define ZDP_PROFILE_ID                      (0x0000)
+
+/* Profile 'ZLO' */
+#define ZLO_PROFILE_ID                      (0x0104)
+
+/* Node 'ControlBridge' */
+/* Endpoints */
+#define CONTROLBRIDGE_ZDO_ENDPOINT          (0)
+#define CONTROLBRIDGE_ZLO_ENDPOINT          (1)
+/* Registered by eApp_ZLO_RegisterEndpoint in every build */
+#define CONTROLBRIDGE_LIVOLO_ENDPOINT       (8)
+
+/* Table Sizes */
+#define ZPS_NEIGHBOUR_TABLE_SIZE            (26)
+#define ZPS_ADDRESS_MAP_TABLE_SIZE          (10)
+#define ZPS_ROUTING_TABLE_SIZE              (255)
+#define ZPS_MAC_ADDRESS_TABLE_SIZE          (36)
+#define ZPS_CHILD_TABLE_SIZE                (10)
+
+/****************************************************************************/
+/***        External Variables                                            ***/
+/****************************************************************************/
+extern void *g_pvApl;
+
+/****************************************************************************/
+/****************************************************************************/
+/****************************************************************************/
+
+#endif /* _ZPS_GEN_H */
@@ -0,0 +1,1188 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          coordinator_sim.c
+ *
+ * DESCRIPTION:        Mesh load simulator on the host build: app_Znc_cmds.c,
+ *                     the event handlers, ZCIF and the ZCL clusters run
+ *                     against the HostSim stand-ins for ZPS, PDUM and PDM.
+ *                     Scripted devices send attribute reports and OTA block
+ *                     requests as APS data indications, the data requests
+ *                     the firmware makes are confirmed after an air time,
+ *                     and a SerialLink host sends On/Off commands and
+ *                     answers block requests. With a rejoin window every
+ *                     device announces once within it and answers the ZDP
+ *                     and Basic requests sent to it, while the host
+ *                     interviews it with active endpoint and simple
+ *                     descriptor requests as Tools/CoordinatorSim.py does
+ *                     and the firmware runs its own interview. APDU use is
+ *                     the allocator's high-water mark within each ms.
+ *                     For each network size it reports UART throughput,
+ *                     pool and queue use with exhaustion, latency
+ *                     percentiles per message and host CPU time per event
+ *                     type.
+ *
+ *                     Latency counts the serial link at UART_BAUD_RATE both
+ *                     ways and the firmware's own queueing; the firmware
+ *                     runs in no time, its CPU cost is the host figure,
+ *                     only comparable between event types. Runs are
+ *                     deterministic for a given seed.
+ *
+ *                     Usage:
+ *                     coordinator_sim [-n 50,100,200] [-d seconds]
+ *                                     [-i report interval s] [-c commands/s]
+ *                                     [-o OTA clients] [-a air time ms]
+ *                                     [-j rejoin window s] [-s seed]
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "zcl.h"
+#include "pdum_nwk.h"
+#include "OnOff.h"
+#include "OTA.h"
+#include "SerialLink.h"
+#include "Basic.h"
+#include "app_aps_queue.h"
+#include "app_device_interview.h"
+#include "app_ota_server.h"
+#include "host_sim.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define SIM_ADDR_BASE                   0x1000
+#define SIM_IEEE_BASE                   0x00158D0000100000ULL
+#define SIM_ENDPOINT                    1
+#define SIM_MAX_DEVICES                 4000
+#define SIM_MAX_SIZES                   8
+
+#define SIM_PROFILE_HA                  0x0104
+#define SIM_CLUSTER_BASIC               0x0000
+#define SIM_CLUSTER_ONOFF               0x0006
+#define SIM_CLUSTER_OTA                 0x0019
+#define SIM_CLUSTER_TEMPERATURE         0x0402
+
+/* OTA image the clients fetch, as test_ota_block_size.c asks for it */
+#define SIM_OTA_MANUFACTURER            0x1037
+#define SIM_OTA_IMAGE_TYPE              0x0001
+#define SIM_OTA_FILE_VERSION            0x00000002
+#define SIM_OTA_IMAGE_SIZE              0x30000
+#define SIM_OTA_BLOCK_SIZE              64
+#define SIM_OTA_RETRY_MS                50
+
+/* Data size and status fields of a block response ASDU */
+#define SIM_RSP_STATUS                  3
+#define SIM_RSP_DATA_SIZE               16
+
+/* Data requests waiting for their confirm, more than the stack has handles */
+#define SIM_CONFIRMS                    64
+
+/* Requests a device has yet to answer, the bytes of each kept, and the time
+ * it takes to answer once the request is on the air */
+#define SIM_ANSWERS                     256
+#define SIM_ANSWER_REQUEST              16
+#define SIM_TURNAROUND_MS               15
+
+/* Temperature sensor the devices describe themselves as */
+#define SIM_DEVICE_ID                   0x0302
+#define SIM_MODEL                       "sim.temp"
+
+/* SerialLink frames a byte below 0x10 is escaped in, start and end bytes */
+#define SIM_SL_ESCAPE_BELOW             0x10
+#define SIM_SL_FRAMING                  2
+#define SIM_SL_HEADER                   5
+
+#define SIM_UART_US( BYTES )            ( ( uint64 ) ( BYTES ) * 10 * 1000000 / UART_BAUD_RATE )
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+    E_SIM_LATENCY_REPORT,
+    E_SIM_LATENCY_COMMAND,
+    E_SIM_LATENCY_BLOCK_REQUEST,
+    E_SIM_LATENCY_BLOCK,
+    E_SIM_LATENCY_ANNOUNCE,
+    E_SIM_LATENCY_ZDP_RESPONSE,
+    E_SIM_LATENCY_HOST_INTERVIEW,
+    E_SIM_LATENCY_FIRMWARE_INTERVIEW,
+    E_SIM_LATENCY_TYPES
+} teSimLatency;
+
+typedef enum
+{
+    E_SIM_CPU_REPORT,
+    E_SIM_CPU_BLOCK_REQUEST,
+    E_SIM_CPU_CONFIRM,
+    E_SIM_CPU_ANNOUNCE,
+    E_SIM_CPU_ZDP_RESPONSE,
+    E_SIM_CPU_READ_RESPONSE,
+    E_SIM_CPU_MAIN_LOOP,
+    E_SIM_CPU_TYPES
+} teSimCpu;
+
+typedef enum
+{
+    E_SIM_GAUGE_APDU,
+    E_SIM_GAUGE_NPDU,
+    E_SIM_GAUGE_DATA_REQ,
+    E_SIM_GAUGE_APS_QUEUE,
+    E_SIM_GAUGE_SERIAL_RX,
+    E_SIM_GAUGES
+} teSimGauge;
+
+/* Host interview of an announced device */
+typedef enum
+{
+    E_SIM_INTERVIEW_NONE,
+    E_SIM_INTERVIEW_ACTIVE_EP,
+    E_SIM_INTERVIEW_SIMPLE_DESC,
+    E_SIM_INTERVIEW_DONE
+} teSimInterview;
+
+typedef struct
+{
+    uint32    u32Count;
+    uint32    u32Size;
+    uint32*   pu32Us;
+} tsSimSamples;
+
+/* Start times waiting for the message that ends them, oldest first */
+typedef struct
+{
+    uint32    u32Head;
+    uint32    u32Tail;
+    uint64    au64Us[1024];
+} tsSimFifo;
+
+typedef struct
+{
+    uint32    u32Limit;
+    uint32    u32Peak;
+    uint64    u64Sum;
+    uint32    u32Full;
+} tsSimGauge;
+
+typedef struct
+{
+    uint32    u32NextReportMs;
+    uint8     u8Seq;
+    /* OTA clients only */
+    bool_t    bOtaClient;
+    bool_t    bOtaWaiting;
+    uint32    u32OtaNextMs;
+    uint32    u32OtaOffset;
+    uint64    u64OtaRequestUs;
+    /* Rejoin only */
+    bool_t    bAnnounced;
+    uint32    u32AnnounceMs;
+    uint64    u64ZdpSentUs;
+    uint8     u8HostInterview;
+} tsSimDevice;
+
+typedef struct
+{
+    uint8     u8ApsSeqNum;
+    uint32    u32DueMs;
+} tsSimConfirm;
+
+typedef struct
+{
+    uint32    u32DueMs;
+    uint16    u16Device;
+    uint16    u16ClusterId;
+    uint16    u16ProfileId;
+    uint8     u8Length;
+    uint8     au8Request[SIM_ANSWER_REQUEST];
+} tsSimAnswer;
+
+typedef struct
+{
+    uint32    u32Sizes[SIM_MAX_SIZES];
+    uint8     u8Sizes;
+    uint32    u32DurationMs;
+    uint32    u32ReportIntervalMs;
+    uint32    u32CommandsPerKs;
+    uint32    u32OtaClients;
+    uint32    u32AirTimeMs;
+    uint32    u32RejoinMs;
+    uint32    u32Seed;
+} tsSimOptions;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE const char*     apcSimLatencyName[E_SIM_LATENCY_TYPES] =
+{
+    "REPORT_IND_ATTR_RESPONSE", "STATUS (host command)", "BLOCK_REQUEST", "OTA block round trip",
+    "DEVICE_ANNOUNCE", "ZDP response", "host interview", "DEVICE_INTERVIEW_RESULT"
+};
+PRIVATE const char*     apcSimCpuName[E_SIM_CPU_TYPES] =
+{
+    "report", "block_request", "data_confirm", "announce", "zdp_response", "read_response", "main_loop_ms"
+};
+PRIVATE const char*     apcSimGaugeName[E_SIM_GAUGES] =
+{
+    "APDU", "NPDU", "stack data req", "APS queue", "serial rx bytes"
+};
+
+PRIVATE tsSimOptions    sSimOptions;
+PRIVATE uint32          u32SimRandom;
+PRIVATE uint32          u32SimNowMs;
+/* Host clock at the start of the run, frames are timed from it */
+PRIVATE uint32          u32SimBaseMs;
+PRIVATE uint32          u32SimDevices;
+PRIVATE tsSimDevice*    psSimDevices;
+
+PRIVATE tsSimSamples    asSimLatency[E_SIM_LATENCY_TYPES];
+PRIVATE tsSimFifo       sSimReportFifo;
+PRIVATE tsSimFifo       sSimCommandFifo;
+PRIVATE tsSimGauge      asSimGauge[E_SIM_GAUGES];
+PRIVATE uint32          au32SimCpuCount[E_SIM_CPU_TYPES];
+PRIVATE uint64          au64SimCpuNs[E_SIM_CPU_TYPES];
+
+PRIVATE tsSimConfirm    asSimConfirm[SIM_CONFIRMS];
+PRIVATE uint32          u32SimConfirmHead;
+PRIVATE uint32          u32SimConfirmTail;
+PRIVATE uint32          u32SimDataReqSeen;
+
+PRIVATE tsSimAnswer     asSimAnswer[SIM_ANSWERS];
+PRIVATE uint32          u32SimAnswerHead;
+PRIVATE uint32          u32SimAnswerTail;
+PRIVATE uint32          u32SimAnnounced;
+PRIVATE uint32          u32SimHostInterviews;
+PRIVATE uint32          u32SimFirmwareComplete;
+PRIVATE uint32          u32SimFirmwareFailed;
+PRIVATE uint32          u32SimUnanswered;
+
+/* UART to the host: time the line is free again, bytes and busy time */
+PRIVATE uint64          u64SimTxLineFreeUs;
+PRIVATE uint64          u64SimTxBytes;
+PRIVATE uint64          u64SimTxBusyUs;
+PRIVATE uint64          u64SimRxBytes;
+PRIVATE uint32          u32SimDropped;
+PRIVATE uint32          u32SimFrames;
+PRIVATE uint32          u32SimBlocks;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* xorshift32, the same sequence on every host */
+PRIVATE uint32 u32SimRand ( uint32    u32Range )
+{
+    u32SimRandom ^=  u32SimRandom << 13;
+    u32SimRandom ^=  u32SimRandom >> 17;
+    u32SimRandom ^=  u32SimRandom << 5;
+    return u32SimRandom % u32Range;
+}
+
+PRIVATE uint64 u64SimCpuNs ( void )
+{
+    struct timespec    sTime;
+
+    clock_gettime ( CLOCK_PROCESS_CPUTIME_ID, &sTime );
+    return ( uint64 ) sTime.tv_sec * 1000000000ULL + sTime.tv_nsec;
+}
+
+PRIVATE void vSimCpu ( teSimCpu    eType,
+                       uint64      u64StartNs )
+{
+    au32SimCpuCount[eType]++;
+    au64SimCpuNs[eType] +=  u64SimCpuNs ( ) - u64StartNs;
+}
+
+PRIVATE void vSimSample ( teSimLatency    eType,
+                          uint64          u64Us )
+{
+    tsSimSamples*    psSamples =  &asSimLatency[eType];
+
+    if ( psSamples->u32Count == psSamples->u32Size )
+    {
+        psSamples->u32Size =  psSamples->u32Size ? 2 * psSamples->u32Size : 1024;
+        psSamples->pu32Us  =  realloc ( psSamples->pu32Us, psSamples->u32Size * sizeof ( uint32 ) );
+    }
+    psSamples->pu32Us[psSamples->u32Count++] =  ( uint32 ) u64Us;
+}
+
+PRIVATE void vSimPush ( tsSimFifo*    psFifo,
+                        uint64        u64Us )
+{
+    if ( psFifo->u32Head - psFifo->u32Tail < sizeof ( psFifo->au64Us ) / sizeof ( uint64 ) )
+    {
+        psFifo->au64Us[psFifo->u32Head++ % ( sizeof ( psFifo->au64Us ) / sizeof ( uint64 ) )] =  u64Us;
+    }
+}
+
+/* Ends the oldest start time with a message delivered at u64Us */
+PRIVATE void vSimPop ( tsSimFifo*      psFifo,
+                       teSimLatency    eType,
+                       uint64          u64Us )
+{
+    if ( psFifo->u32Tail != psFifo->u32Head )
+    {
+        vSimSample ( eType, u64Us - psFifo->au64Us[psFifo->u32Tail++ % ( sizeof ( psFifo->au64Us ) / sizeof ( uint64 ) )] );
+    }
+}
+
+/* Bytes on the wire for a frame with the given header and payload */
+PRIVATE uint32 u32SimFrameBytes ( uint16          u16Type,
+                                  uint16          u16Length,
+                                  const uint8*    pu8Payload )
+{
+    uint8     au8Header[SIM_SL_HEADER];
+    uint32    u32Bytes =  SIM_SL_FRAMING + SIM_SL_HEADER + u16Length;
+    uint16    i;
+
+    au8Header[0] =  ( uint8 ) ( u16Type >> 8 );
+    au8Header[1] =  ( uint8 ) u16Type;
+    au8Header[2] =  ( uint8 ) ( u16Length >> 8 );
+    au8Header[3] =  ( uint8 ) u16Length;
+    au8Header[4] =  u8SL_CalculateCRC ( u16Type, u16Length, ( uint8* ) pu8Payload );
+    for ( i = 0; i < SIM_SL_HEADER; i++ )
+    {
+        u32Bytes +=  ( au8Header[i] < SIM_SL_ESCAPE_BELOW );
+    }
+    for ( i = 0; ( i < u16Length ) && ( i < HOST_SERIAL_MAX_PAYLOAD ); i++ )
+    {
+        u32Bytes +=  ( pu8Payload[i] < SIM_SL_ESCAPE_BELOW );
+    }
+    return u32Bytes;
+}
+
+PRIVATE void vSimHostWrite ( uint16          u16Type,
+                             uint16          u16Length,
+                             const uint8*    pu8Payload )
+{
+    u64SimRxBytes +=  u32SimFrameBytes ( u16Type, u16Length, pu8Payload );
+    HOST_vSerialWrite ( u16Type, u16Length, pu8Payload );
+    vSimPush ( &sSimCommandFifo, ( uint64 ) u32SimNowMs * 1000 );
+}
+
+PRIVATE void vSimReport ( uint16    u16Device )
+{
+    tsSimDevice*    psDevice =  &psSimDevices[u16Device];
+    int16           i16Value =  ( int16 ) ( 1500 + u32SimRand ( 1000 ) );
+    uint8           au8Report[] =
+    {
+        0x18, 0x00, E_ZCL_REPORT_ATTRIBUTES,
+        0x00, 0x00,                     /* attribute */
+        E_ZCL_INT16,
+        0x00, 0x00                      /* value */
+    };
+    uint64          u64Start;
+
+    au8Report[1] =  psDevice->u8Seq++;
+    au8Report[6] =  ( uint8 ) i16Value;
+    au8Report[7] =  ( uint8 ) ( i16Value >> 8 );
+    if ( HOST_u8ApduFree ( ) == 0 )
+    {
+        u32SimDropped++;
+        return;
+    }
+    vSimPush ( &sSimReportFifo, ( uint64 ) u32SimNowMs * 1000 );
+    u64Start =  u64SimCpuNs ( );
+    HOST_vDataIndication ( SIM_ADDR_BASE + u16Device, SIM_ENDPOINT, SIM_ENDPOINT,
+                           SIM_CLUSTER_TEMPERATURE, SIM_PROFILE_HA, au8Report, sizeof ( au8Report ) );
+    vSimCpu ( E_SIM_CPU_REPORT, u64Start );
+}
+
+PRIVATE void vSimBlockRequest ( uint16    u16Device )
+{
+    tsSimDevice*    psDevice =  &psSimDevices[u16Device];
+    uint8           au8Request[] =
+    {
+        0x01, 0x00, E_CLD_OTA_COMMAND_BLOCK_REQUEST,
+        0x00,                           /* field control */
+        ( uint8 ) SIM_OTA_MANUFACTURER, ( uint8 ) ( SIM_OTA_MANUFACTURER >> 8 ),
+        ( uint8 ) SIM_OTA_IMAGE_TYPE, ( uint8 ) ( SIM_OTA_IMAGE_TYPE >> 8 ),
+        ( uint8 ) SIM_OTA_FILE_VERSION, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,         /* file offset */
+        SIM_OTA_BLOCK_SIZE
+    };
+    uint64          u64Start;
+
+    au8Request[1]  =  psDevice->u8Seq++;
+    au8Request[12] =  ( uint8 ) psDevice->u32OtaOffset;
+    au8Request[13] =  ( uint8 ) ( psDevice->u32OtaOffset >> 8 );
+    au8Request[14] =  ( uint8 ) ( psDevice->u32OtaOffset >> 16 );
+    au8Request[15] =  ( uint8 ) ( psDevice->u32OtaOffset >> 24 );
+    if ( HOST_u8ApduFree ( ) == 0 )
+    {
+        u32SimDropped++;
+        psDevice->u32OtaNextMs =  u32SimNowMs + SIM_OTA_RETRY_MS;
+        return;
+    }
+    psDevice->bOtaWaiting     =  TRUE;
+    psDevice->u64OtaRequestUs =  ( uint64 ) u32SimNowMs * 1000;
+    u64Start =  u64SimCpuNs ( );
+    HOST_vDataIndication ( SIM_ADDR_BASE + u16Device, SIM_ENDPOINT, SIM_ENDPOINT,
+                           SIM_CLUSTER_OTA, SIM_PROFILE_HA, au8Request, sizeof ( au8Request ) );
+    vSimCpu ( E_SIM_CPU_BLOCK_REQUEST, u64Start );
+}
+
+/* Host answer to E_SL_MSG_BLOCK_REQUEST with the block asked for */
+PRIVATE void vSimBlockSend ( const uint8*    pu8Request )
+{
+    uint8     au8Send[20 + 255];
+    uint8     u8Size =  pu8Request[29];
+    uint16    i;
+
+    memset ( au8Send, 0, sizeof ( au8Send ) );
+    au8Send[0]  =  E_ZCL_AM_SHORT;
+    au8Send[1]  =  pu8Request[5];
+    au8Send[2]  =  pu8Request[6];
+    au8Send[3]  =  SIM_ENDPOINT;
+    au8Send[4]  =  pu8Request[1];
+    au8Send[5]  =  pu8Request[0];
+    au8Send[6]  =  OTA_STATUS_SUCCESS;
+    memcpy ( &au8Send[7],  &pu8Request[15], 4 );     /* offset */
+    memcpy ( &au8Send[11], &pu8Request[19], 4 );     /* file version */
+    memcpy ( &au8Send[15], &pu8Request[23], 2 );     /* image type */
+    memcpy ( &au8Send[17], &pu8Request[25], 2 );     /* manufacturer */
+    au8Send[19] =  u8Size;
+    for ( i = 0; i < u8Size; i++ )
+    {
+        au8Send[20 + i] =  ( uint8 ) i;
+    }
+    vSimHostWrite ( E_SL_MSG_BLOCK_SEND, 20 + u8Size, au8Send );
+}
+
+PRIVATE void vSimAnnounce ( uint16    u16Device )
+{
+    tsSimDevice*    psDevice =  &psSimDevices[u16Device];
+    uint16          u16Addr  =  SIM_ADDR_BASE + u16Device;
+    uint64          u64Ieee  =  SIM_IEEE_BASE + u16Device;
+    uint8           au8Announce[12];
+    uint64          u64Start;
+    uint8           i;
+
+    psDevice->bAnnounced =  TRUE;
+    if ( HOST_u8ApduFree ( ) == 0 )
+    {
+        u32SimDropped++;
+        return;
+    }
+    au8Announce[0] =  psDevice->u8Seq++;
+    au8Announce[1] =  ( uint8 ) u16Addr;
+    au8Announce[2] =  ( uint8 ) ( u16Addr >> 8 );
+    for ( i = 0; i < 8; i++ )
+    {
+        au8Announce[3 + i] =  ( uint8 ) ( u64Ieee >> ( 8 * i ) );
+    }
+    au8Announce[11] =  0x8E;                    /* router, mains, rx on */
+    psDevice->u64ZdpSentUs    =  0;
+    psDevice->u8HostInterview =  E_SIM_INTERVIEW_NONE;
+    psDevice->u32AnnounceMs   =  u32SimNowMs;
+    u32SimAnnounced++;
+    u64Start =  u64SimCpuNs ( );
+    HOST_vDataIndication ( u16Addr, 0, 0, ZPS_ZDP_DEVICE_ANNCE_REQ_CLUSTER_ID, 0, au8Announce, sizeof ( au8Announce ) );
+    vSimCpu ( E_SIM_CPU_ANNOUNCE, u64Start );
+}
+
+/* Keeps a ZDP or Basic read request to a device for its answer */
+PRIVATE void vSimAnswerLater ( tsHostDataReq*    psReq,
+                               uint16            u16Device )
+{
+    tsSimAnswer*    psAnswer;
+
+    if ( ( psReq->u16ProfileId != 0 ) &&
+         ( ( psReq->u16ClusterId != SIM_CLUSTER_BASIC ) || ( psReq->u16PayloadLength < 3 ) ||
+           ( psReq->au8Payload[2] != E_ZCL_READ_ATTRIBUTES ) ) )
+    {
+        return;
+    }
+    if ( u32SimAnswerHead - u32SimAnswerTail == SIM_ANSWERS )
+    {
+        u32SimUnanswered++;
+        return;
+    }
+    psAnswer =  &asSimAnswer[u32SimAnswerHead++ % SIM_ANSWERS];
+    psAnswer->u32DueMs     =  u32SimNowMs + sSimOptions.u32AirTimeMs + SIM_TURNAROUND_MS;
+    psAnswer->u16Device    =  u16Device;
+    psAnswer->u16ClusterId =  psReq->u16ClusterId;
+    psAnswer->u16ProfileId =  psReq->u16ProfileId;
+    psAnswer->u8Length     =  ( psReq->u16PayloadLength < SIM_ANSWER_REQUEST ) ? psReq->u16PayloadLength : SIM_ANSWER_REQUEST;
+    memcpy ( psAnswer->au8Request, psReq->au8Payload, psAnswer->u8Length );
+}
+
+/* Node descriptor, active endpoint and simple descriptor responses, little
+ * endian as on the air */
+PRIVATE void vSimZdpResponse ( tsSimAnswer*    psAnswer )
+{
+    uint16          u16Addr =  SIM_ADDR_BASE + psAnswer->u16Device;
+    uint8           au8Response[32];
+    uint16          u16Length =  0;
+    uint16          u16Cluster;
+    uint64          u64Start;
+
+    au8Response[u16Length++] =  psAnswer->au8Request[0];
+    au8Response[u16Length++] =  ZPS_E_SUCCESS;
+    au8Response[u16Length++] =  ( uint8 ) u16Addr;
+    au8Response[u16Length++] =  ( uint8 ) ( u16Addr >> 8 );
+    switch ( psAnswer->u16ClusterId )
+    {
+        case ZPS_ZDP_NODE_DESC_REQ_CLUSTER_ID:
+        {
+            const uint8    au8NodeDesc[] =
+            {
+                0x01, 0x40,                                     /* router */
+                0x8E,
+                ( uint8 ) SIM_OTA_MANUFACTURER, ( uint8 ) ( SIM_OTA_MANUFACTURER >> 8 ),
+                0x52,
+                0x80, 0x00,                                     /* max rx */
+                0x00, 0x2C,                                     /* server mask */
+                0x80, 0x00,                                     /* max tx */
+                0x00
+            };
+
+            u16Cluster =  ZPS_ZDP_NODE_DESC_RSP_CLUSTER_ID;
+            memcpy ( &au8Response[u16Length], au8NodeDesc, sizeof ( au8NodeDesc ) );
+            u16Length +=  sizeof ( au8NodeDesc );
+        }
+        break;
+
+        case ZPS_ZDP_ACTIVE_EP_REQ_CLUSTER_ID:
+            u16Cluster =  ZPS_ZDP_ACTIVE_EP_RSP_CLUSTER_ID;
+            au8Response[u16Length++] =  1;
+            au8Response[u16Length++] =  SIM_ENDPOINT;
+        break;
+
+        case ZPS_ZDP_SIMPLE_DESC_REQ_CLUSTER_ID:
+        {
+            const uint8    au8SimpleDesc[] =
+            {
+                SIM_ENDPOINT,
+                ( uint8 ) SIM_PROFILE_HA, ( uint8 ) ( SIM_PROFILE_HA >> 8 ),
+                ( uint8 ) SIM_DEVICE_ID, ( uint8 ) ( SIM_DEVICE_ID >> 8 ),
+                0x00,
+                2,
+                ( uint8 ) SIM_CLUSTER_BASIC, ( uint8 ) ( SIM_CLUSTER_BASIC >> 8 ),
+                ( uint8 ) SIM_CLUSTER_TEMPERATURE, ( uint8 ) ( SIM_CLUSTER_TEMPERATURE >> 8 ),
+                1,
+                ( uint8 ) SIM_CLUSTER_OTA, ( uint8 ) ( SIM_CLUSTER_OTA >> 8 )
+            };
+
+            u16Cluster =  ZPS_ZDP_SIMPLE_DESC_RSP_CLUSTER_ID;
+            if ( ( psAnswer->u8Length < 4 ) || ( psAnswer->au8Request[3] != SIM_ENDPOINT ) )
+            {
+                au8Response[1]           =  ZPS_APL_ZDP_E_INVALID_EP;
+                au8Response[u16Length++] =  0;
+                break;
+            }
+            au8Response[u16Length++] =  sizeof ( au8SimpleDesc );
+            memcpy ( &au8Response[u16Length], au8SimpleDesc, sizeof ( au8SimpleDesc ) );
+            u16Length +=  sizeof ( au8SimpleDesc );
+        }
+        break;
+
+        default:
+        return;
+    }
+    psSimDevices[psAnswer->u16Device].u64ZdpSentUs =  ( uint64 ) u32SimNowMs * 1000;
+    u64Start =  u64SimCpuNs ( );
+    HOST_vDataIndication ( u16Addr, 0, 0, u16Cluster, 0, au8Response, u16Length );
+    vSimCpu ( E_SIM_CPU_ZDP_RESPONSE, u64Start );
+}
+
+/* Basic read response: manufacturer and model, every other attribute
+ * unsupported */
+PRIVATE void vSimReadResponse ( tsSimAnswer*    psAnswer )
+{
+    uint8           au8Response[64];
+    uint16          u16Length =  0;
+    uint16          u16Attribute;
+    const char*     pcValue;
+    uint64          u64Start;
+    uint8           i;
+
+    au8Response[u16Length++] =  0x18;
+    au8Response[u16Length++] =  psAnswer->au8Request[1];
+    au8Response[u16Length++] =  E_ZCL_READ_ATTRIBUTES_RESPONSE;
+    for ( i = 3; ( i + 1 ) < psAnswer->u8Length; i += 2 )
+    {
+        u16Attribute =  psAnswer->au8Request[i] | ( psAnswer->au8Request[i + 1] << 8 );
+        au8Response[u16Length++] =  psAnswer->au8Request[i];
+        au8Response[u16Length++] =  psAnswer->au8Request[i + 1];
+        pcValue =  ( u16Attribute == E_CLD_BAS_ATTR_ID_MODEL_IDENTIFIER ) ? SIM_MODEL :
+                   ( u16Attribute == E_CLD_BAS_ATTR_ID_MANUFACTURER_NAME ) ? "NXP" : NULL;
+        if ( pcValue == NULL )
+        {
+            au8Response[u16Length++] =  E_ZCL_CMDS_UNSUPPORTED_ATTRIBUTE;
+            continue;
+        }
+        au8Response[u16Length++] =  E_ZCL_CMDS_SUCCESS;
+        au8Response[u16Length++] =  E_ZCL_CSTRING;
+        au8Response[u16Length++] =  ( uint8 ) strlen ( pcValue );
+        memcpy ( &au8Response[u16Length], pcValue, strlen ( pcValue ) );
+        u16Length +=  strlen ( pcValue );
+    }
+    u64Start =  u64SimCpuNs ( );
+    HOST_vDataIndication ( SIM_ADDR_BASE + psAnswer->u16Device, SIM_ENDPOINT, SIM_ENDPOINT,
+                           SIM_CLUSTER_BASIC, SIM_PROFILE_HA, au8Response, u16Length );
+    vSimCpu ( E_SIM_CPU_READ_RESPONSE, u64Start );
+}
+
+PRIVATE void vSimAnswers ( void )
+{
+    tsSimAnswer*    psAnswer;
+
+    while ( ( u32SimAnswerTail != u32SimAnswerHead ) &&
+            ( asSimAnswer[u32SimAnswerTail % SIM_ANSWERS].u32DueMs <= u32SimNowMs ) )
+    {
+        psAnswer =  &asSimAnswer[u32SimAnswerTail++ % SIM_ANSWERS];
+        if ( HOST_u8ApduFree ( ) == 0 )
+        {
+            u32SimDropped++;
+        }
+        else if ( psAnswer->u16ProfileId == 0 )
+        {
+            vSimZdpResponse ( psAnswer );
+        }
+        else
+        {
+            vSimReadResponse ( psAnswer );
+        }
+    }
+}
+
+/* Device a frame names at the offset given, big endian as the firmware
+ * writes it, or the device count if it is none of them */
+PRIVATE uint16 u16SimFrameDevice ( tsHostSerialFrame*    psFrame,
+                                   uint8                 u8Offset )
+{
+    uint16    u16Addr;
+
+    if ( psFrame->u16Length < u8Offset + 2 )
+    {
+        return ( uint16 ) u32SimDevices;
+    }
+    u16Addr =  ( psFrame->au8Payload[u8Offset] << 8 ) | psFrame->au8Payload[u8Offset + 1];
+    if ( ( u16Addr < SIM_ADDR_BASE ) || ( ( uint32 ) ( u16Addr - SIM_ADDR_BASE ) >= u32SimDevices ) )
+    {
+        return ( uint16 ) u32SimDevices;
+    }
+    return u16Addr - SIM_ADDR_BASE;
+}
+
+/* Host side of a rejoin: a ZDP response times the device's answer, and the
+ * interview moves on from the announce to the endpoints and their
+ * descriptors */
+PRIVATE void vSimHostInterview ( tsHostSerialFrame*    psFrame )
+{
+    tsSimDevice*    psDevice;
+    uint8           au8Request[3];
+    uint16          u16Device;
+
+    u16Device =  u16SimFrameDevice ( psFrame, ( psFrame->u16Type == E_SL_MSG_DEVICE_ANNOUNCE ) ? 0 : 2 );
+    if ( u16Device == u32SimDevices )
+    {
+        return;
+    }
+    psDevice =  &psSimDevices[u16Device];
+    au8Request[0] =  ( uint8 ) ( ( SIM_ADDR_BASE + u16Device ) >> 8 );
+    au8Request[1] =  ( uint8 ) ( SIM_ADDR_BASE + u16Device );
+    au8Request[2] =  SIM_ENDPOINT;
+
+    if ( psFrame->u16Type == E_SL_MSG_DEVICE_ANNOUNCE )
+    {
+        vSimSample ( E_SIM_LATENCY_ANNOUNCE, u64SimTxLineFreeUs - ( uint64 ) psDevice->u32AnnounceMs * 1000 );
+        if ( psDevice->u8HostInterview == E_SIM_INTERVIEW_NONE )
+        {
+            psDevice->u8HostInterview =  E_SIM_INTERVIEW_ACTIVE_EP;
+            vSimHostWrite ( E_SL_MSG_ACTIVE_ENDPOINT_REQUEST, 2, au8Request );
+        }
+        return;
+    }
+
+    if ( psDevice->u64ZdpSentUs != 0 )
+    {
+        vSimSample ( E_SIM_LATENCY_ZDP_RESPONSE, u64SimTxLineFreeUs - psDevice->u64ZdpSentUs );
+        psDevice->u64ZdpSentUs =  0;
+    }
+    if ( ( psFrame->u16Type == E_SL_MSG_ACTIVE_ENDPOINT_RESPONSE ) &&
+         ( psDevice->u8HostInterview == E_SIM_INTERVIEW_ACTIVE_EP ) )
+    {
+        psDevice->u8HostInterview =  E_SIM_INTERVIEW_SIMPLE_DESC;
+        vSimHostWrite ( E_SL_MSG_SIMPLE_DESCRIPTOR_REQUEST, 3, au8Request );
+    }
+    else if ( ( psFrame->u16Type == E_SL_MSG_SIMPLE_DESCRIPTOR_RESPONSE ) &&
+              ( psDevice->u8HostInterview == E_SIM_INTERVIEW_SIMPLE_DESC ) )
+    {
+        psDevice->u8HostInterview =  E_SIM_INTERVIEW_DONE;
+        vSimSample ( E_SIM_LATENCY_HOST_INTERVIEW, u64SimTxLineFreeUs - ( uint64 ) psDevice->u32AnnounceMs * 1000 );
+        u32SimHostInterviews++;
+    }
+}
+
+/* Summary section of the firmware's own interview of an announced device */
+PRIVATE void vSimInterviewResult ( tsHostSerialFrame*    psFrame )
+{
+    uint16    u16Device =  u16SimFrameDevice ( psFrame, 0 );
+
+    if ( ( u16Device == u32SimDevices ) || ( psFrame->u16Length < 13 ) ||
+         ( psFrame->au8Payload[2] != DEVICE_INTERVIEW_SECTION_SUMMARY ) )
+    {
+        return;
+    }
+    vSimSample ( E_SIM_LATENCY_FIRMWARE_INTERVIEW,
+                 u64SimTxLineFreeUs - ( uint64 ) psSimDevices[u16Device].u32AnnounceMs * 1000 );
+    if ( psFrame->au8Payload[12] == DEVICE_INTERVIEW_STATUS_COMPLETE )
+    {
+        u32SimFirmwareComplete++;
+    }
+    else
+    {
+        u32SimFirmwareFailed++;
+    }
+}
+
+/* Times each frame on the UART and lets the host act on it */
+PRIVATE void vSimReadFrames ( void )
+{
+    tsHostSerialFrame    sFrame;
+    uint32               u32Bytes;
+    uint64               u64Start;
+    uint16               u16Device;
+
+    while ( HOST_bSerialRead ( &sFrame ) )
+    {
+        u32Bytes =  u32SimFrameBytes ( sFrame.u16Type, sFrame.u16Length, sFrame.au8Payload );
+        u64Start =  ( uint64 ) ( sFrame.u32TimeMs - u32SimBaseMs ) * 1000;
+        if ( u64SimTxLineFreeUs > u64Start )
+        {
+            u64Start =  u64SimTxLineFreeUs;
+        }
+        u64SimTxLineFreeUs =  u64Start + SIM_UART_US ( u32Bytes );
+        u64SimTxBusyUs     +=  SIM_UART_US ( u32Bytes );
+        u64SimTxBytes      +=  u32Bytes;
+        u32SimFrames++;
+
+        switch ( sFrame.u16Type )
+        {
+            case E_SL_MSG_REPORT_IND_ATTR_RESPONSE:
+                vSimPop ( &sSimReportFifo, E_SIM_LATENCY_REPORT, u64SimTxLineFreeUs );
+            break;
+
+            case E_SL_MSG_STATUS:
+                vSimPop ( &sSimCommandFifo, E_SIM_LATENCY_COMMAND, u64SimTxLineFreeUs );
+            break;
+
+            case E_SL_MSG_BLOCK_REQUEST:
+                /* Timed from the request of the client named, others may
+                 * be waiting on the same fetch */
+                u16Device =  ( ( sFrame.au8Payload[5] << 8 ) | sFrame.au8Payload[6] ) - SIM_ADDR_BASE;
+                if ( ( u16Device < u32SimDevices ) && psSimDevices[u16Device].bOtaWaiting )
+                {
+                    vSimSample ( E_SIM_LATENCY_BLOCK_REQUEST, u64SimTxLineFreeUs - psSimDevices[u16Device].u64OtaRequestUs );
+                }
+                vSimBlockSend ( sFrame.au8Payload );
+            break;
+
+            case E_SL_MSG_DEVICE_ANNOUNCE:
+            case E_SL_MSG_NODE_DESCRIPTOR_RESPONSE:
+            case E_SL_MSG_ACTIVE_ENDPOINT_RESPONSE:
+            case E_SL_MSG_SIMPLE_DESCRIPTOR_RESPONSE:
+                vSimHostInterview ( &sFrame );
+            break;
+
+            case E_SL_MSG_DEVICE_INTERVIEW_RESULT:
+                vSimInterviewResult ( &sFrame );
+            break;
+
+            default:
+            break;
+        }
+    }
+}
+
+/* Schedules the confirm of every new data request and the answer of a
+ * device to a ZDP or Basic read request, and moves an OTA client on once
+ * its block response is on the air */
+PRIVATE void vSimDataRequests ( void )
+{
+    tsHostDataReq*    psReq;
+    tsSimDevice*      psDevice;
+    uint16            u16Device;
+
+    while ( u32SimDataReqSeen < HOST_u32DataReqCount ( ) )
+    {
+        psReq =  HOST_psDataReq ( u32SimDataReqSeen++ );
+        if ( psReq == NULL )
+        {
+            continue;
+        }
+        if ( u32SimConfirmHead - u32SimConfirmTail < SIM_CONFIRMS )
+        {
+            asSimConfirm[u32SimConfirmHead % SIM_CONFIRMS].u8ApsSeqNum =  psReq->u8ApsSeqNum;
+            asSimConfirm[u32SimConfirmHead % SIM_CONFIRMS].u32DueMs    =  u32SimNowMs + sSimOptions.u32AirTimeMs;
+            u32SimConfirmHead++;
+        }
+
+        u16Device =  psReq->u16DstAddr - SIM_ADDR_BASE;
+        if ( ( psReq->u8DstAddrMode != ZPS_E_ADDR_MODE_SHORT ) || ( psReq->u16DstAddr < SIM_ADDR_BASE ) ||
+             ( u16Device >= u32SimDevices ) )
+        {
+            continue;
+        }
+        vSimAnswerLater ( psReq, u16Device );
+        if ( ( psReq->u16ClusterId != SIM_CLUSTER_OTA ) || !psSimDevices[u16Device].bOtaWaiting )
+        {
+            continue;
+        }
+        psDevice =  &psSimDevices[u16Device];
+        psDevice->bOtaWaiting  =  FALSE;
+        psDevice->u32OtaNextMs =  u32SimNowMs + sSimOptions.u32AirTimeMs;
+        if ( psReq->au8Payload[SIM_RSP_STATUS] == OTA_STATUS_SUCCESS )
+        {
+            vSimSample ( E_SIM_LATENCY_BLOCK,
+                         ( uint64 ) ( u32SimNowMs + sSimOptions.u32AirTimeMs ) * 1000 - psDevice->u64OtaRequestUs );
+            psDevice->u32OtaOffset =  ( psDevice->u32OtaOffset + psReq->au8Payload[SIM_RSP_DATA_SIZE] ) % SIM_OTA_IMAGE_SIZE;
+            u32SimBlocks++;
+        }
+        else
+        {
+            psDevice->u32OtaNextMs +=  SIM_OTA_RETRY_MS;
+        }
+    }
+}
+
+PRIVATE void vSimConfirms ( void )
+{
+    uint64    u64Start;
+
+    while ( ( u32SimConfirmTail != u32SimConfirmHead ) &&
+            ( asSimConfirm[u32SimConfirmTail % SIM_CONFIRMS].u32DueMs <= u32SimNowMs ) )
+    {
+        u64Start =  u64SimCpuNs ( );
+        HOST_bDataConfirm ( asSimConfirm[u32SimConfirmTail % SIM_CONFIRMS].u8ApsSeqNum, ZPS_E_SUCCESS );
+        vSimCpu ( E_SIM_CPU_CONFIRM, u64Start );
+        u32SimConfirmTail++;
+    }
+}
+
+PRIVATE void vSimGauge ( teSimGauge    eGauge,
+                         uint32        u32Value )
+{
+    tsSimGauge*    psGauge =  &asSimGauge[eGauge];
+
+    psGauge->u64Sum +=  u32Value;
+    if ( u32Value > psGauge->u32Peak )
+    {
+        psGauge->u32Peak =  u32Value;
+    }
+    if ( ( psGauge->u32Limit > 0 ) && ( u32Value >= psGauge->u32Limit ) )
+    {
+        psGauge->u32Full++;
+    }
+}
+
+PRIVATE int iSimCompare ( const void*    pvA,
+                          const void*    pvB )
+{
+    uint32    u32A =  *( const uint32* ) pvA;
+    uint32    u32B =  *( const uint32* ) pvB;
+
+    return ( u32A > u32B ) - ( u32A < u32B );
+}
+
+PRIVATE double dSimPercentile ( tsSimSamples*    psSamples,
+                                uint32           u32PerCent )
+{
+    uint32    u32Index =  psSamples->u32Count * u32PerCent / 100;
+
+    if ( psSamples->u32Count == 0 )
+    {
+        return 0;
+    }
+    if ( u32Index >= psSamples->u32Count )
+    {
+        u32Index =  psSamples->u32Count - 1;
+    }
+    return psSamples->pu32Us[u32Index] / 1000.0;
+}
+
+PRIVATE void vSimStart ( uint32    u32Devices )
+{
+    uint32    i;
+
+    memset ( asSimLatency, 0, sizeof ( asSimLatency ) );
+    memset ( &sSimReportFifo, 0, sizeof ( sSimReportFifo ) );
+    memset ( &sSimCommandFifo, 0, sizeof ( sSimCommandFifo ) );
+    memset ( asSimGauge, 0, sizeof ( asSimGauge ) );
+    memset ( au32SimCpuCount, 0, sizeof ( au32SimCpuCount ) );
+    memset ( au64SimCpuNs, 0, sizeof ( au64SimCpuNs ) );
+    asSimGauge[E_SIM_GAUGE_APDU].u32Limit      =  HOST_APDU_ZDP_INSTANCES;
+    asSimGauge[E_SIM_GAUGE_NPDU].u32Limit      =  HOST_ZPS_NUM_NPDUS;
+    asSimGauge[E_SIM_GAUGE_DATA_REQ].u32Limit  =  HOST_ZPS_MAX_APSDE_REQ;
+    asSimGauge[E_SIM_GAUGE_APS_QUEUE].u32Limit =  APS_QUEUE_SIZE;
+    u32SimConfirmHead  =  0;
+    u32SimConfirmTail  =  0;
+    u32SimAnswerHead   =  0;
+    u32SimAnswerTail   =  0;
+    u32SimAnnounced         =  0;
+    u32SimHostInterviews    =  0;
+    u32SimFirmwareComplete  =  0;
+    u32SimFirmwareFailed    =  0;
+    u32SimUnanswered        =  0;
+    u64SimTxLineFreeUs =  0;
+    u64SimTxBytes      =  0;
+    u64SimTxBusyUs     =  0;
+    u64SimRxBytes      =  0;
+    u32SimDropped      =  0;
+    u32SimFrames       =  0;
+    u32SimBlocks       =  0;
+    u32SimNowMs        =  0;
+    u32SimRandom       =  sSimOptions.u32Seed ? sSimOptions.u32Seed : 1;
+
+    HOST_vInit ( );
+    vAppInitOTA ( );
+    u32SimDataReqSeen =  HOST_u32DataReqCount ( );
+    u32SimBaseMs      =  HOST_u32TimeMs ( );
+
+    u32SimDevices =  u32Devices;
+    psSimDevices  =  calloc ( u32Devices, sizeof ( tsSimDevice ) );
+    for ( i = 0; i < u32Devices; i++ )
+    {
+        HOST_vAddDevice ( SIM_ADDR_BASE + i, SIM_IEEE_BASE + i, FALSE );
+        psSimDevices[i].u32NextReportMs =  u32SimRand ( sSimOptions.u32ReportIntervalMs );
+        psSimDevices[i].u8Seq           =  ( uint8 ) u32SimRand ( 256 );
+        if ( i < sSimOptions.u32OtaClients )
+        {
+            psSimDevices[i].bOtaClient   =  TRUE;
+            psSimDevices[i].u32OtaNextMs =  u32SimRand ( 1000 );
+        }
+        if ( sSimOptions.u32RejoinMs > 0 )
+        {
+            psSimDevices[i].u32AnnounceMs =  u32SimRand ( sSimOptions.u32RejoinMs );
+        }
+        else
+        {
+            psSimDevices[i].bAnnounced =  TRUE;
+        }
+    }
+}
+
+PRIVATE void vSimRun ( void )
+{
+    tsSimDevice*    psDevice;
+    uint8           au8OnOff[6];
+    uint64          u64Start;
+    uint32          u32Refused =  HOST_u32DataReqRefused ( );
+    uint32          i;
+
+    for ( u32SimNowMs = 0; u32SimNowMs < sSimOptions.u32DurationMs; u32SimNowMs++ )
+    {
+        vSimConfirms ( );
+        vSimAnswers ( );
+
+        for ( i = 0; i < u32SimDevices; i++ )
+        {
+            psDevice =  &psSimDevices[i];
+            if ( !psDevice->bAnnounced && ( psDevice->u32AnnounceMs <= u32SimNowMs ) )
+            {
+                vSimAnnounce ( ( uint16 ) i );
+            }
+            if ( psDevice->u32NextReportMs <= u32SimNowMs )
+            {
+                vSimReport ( ( uint16 ) i );
+                psDevice->u32NextReportMs +=  sSimOptions.u32ReportIntervalMs / 2 +
+                                              u32SimRand ( sSimOptions.u32ReportIntervalMs );
+            }
+            if ( psDevice->bOtaClient && !psDevice->bOtaWaiting && ( psDevice->u32OtaNextMs <= u32SimNowMs ) )
+            {
+                vSimBlockRequest ( ( uint16 ) i );
+            }
+        }
+
+        /* Commands per 1000 s are the chance in a million of one this ms */
+        if ( u32SimRand ( 1000000 ) < sSimOptions.u32CommandsPerKs )
+        {
+            i =  SIM_ADDR_BASE + u32SimRand ( u32SimDevices );
+            au8OnOff[0] =  E_ZCL_AM_SHORT;
+            au8OnOff[1] =  ( uint8 ) ( i >> 8 );
+            au8OnOff[2] =  ( uint8 ) i;
+            au8OnOff[3] =  SIM_ENDPOINT;
+            au8OnOff[4] =  SIM_ENDPOINT;
+            au8OnOff[5] =  E_CLD_ONOFF_CMD_TOGGLE;
+            vSimHostWrite ( E_SL_MSG_ONOFF_NOEFFECTS, sizeof ( au8OnOff ), au8OnOff );
+        }
+
+        u64Start =  u64SimCpuNs ( );
+        HOST_vRun ( 1 );
+        vSimCpu ( E_SIM_CPU_MAIN_LOOP, u64Start );
+
+        vSimReadFrames ( );
+        vSimDataRequests ( );
+
+        vSimGauge ( E_SIM_GAUGE_APDU,       HOST_u8ApduPeak ( ) );
+        vSimGauge ( E_SIM_GAUGE_NPDU,       PDUM_u8GetNpduUse ( ) );
+        vSimGauge ( E_SIM_GAUGE_DATA_REQ,   HOST_u8DataReqPending ( ) );
+        vSimGauge ( E_SIM_GAUGE_APS_QUEUE,  APP_u8ApsQueueDepth ( ) );
+        vSimGauge ( E_SIM_GAUGE_SERIAL_RX,  HOST_u32SerialRxPending ( ) );
+    }
+    u32Refused =  HOST_u32DataReqRefused ( ) - u32Refused;
+
+    printf ( "\n%u devices, %u s\n", ( unsigned ) u32SimDevices, ( unsigned ) ( sSimOptions.u32DurationMs / 1000 ) );
+    printf ( "  UART to host   %7.0f bytes/s  %5.1f%% of the link, %u frames\n",
+             u64SimTxBytes * 1000.0 / sSimOptions.u32DurationMs,
+             u64SimTxBusyUs / ( 10.0 * sSimOptions.u32DurationMs ), ( unsigned ) u32SimFrames );
+    printf ( "  UART from host %7.0f bytes/s  %5.1f%% of the link\n",
+             u64SimRxBytes * 1000.0 / sSimOptions.u32DurationMs,
+             SIM_UART_US ( u64SimRxBytes ) / ( 10.0 * sSimOptions.u32DurationMs ) );
+    printf ( "  OTA blocks     %u sent\n", ( unsigned ) u32SimBlocks );
+    printf ( "  %-16s %6s %6s %6s %8s\n", "queue/pool", "size", "peak", "mean", "full ms" );
+    for ( i = 0; i < E_SIM_GAUGES; i++ )
+    {
+        if ( asSimGauge[i].u32Limit > 0 )
+        {
+            printf ( "  %-16s %6u %6u %6.1f %8u\n", apcSimGaugeName[i], ( unsigned ) asSimGauge[i].u32Limit,
+                     ( unsigned ) asSimGauge[i].u32Peak, ( double ) asSimGauge[i].u64Sum / sSimOptions.u32DurationMs,
+                     ( unsigned ) asSimGauge[i].u32Full );
+        }
+        else
+        {
+            printf ( "  %-16s %6s %6u %6.1f\n", apcSimGaugeName[i], "-",
+                     ( unsigned ) asSimGauge[i].u32Peak, ( double ) asSimGauge[i].u64Sum / sSimOptions.u32DurationMs );
+        }
+    }
+    printf ( "  indications lost to APDU exhaustion %u, data requests refused %u\n",
+             ( unsigned ) u32SimDropped, ( unsigned ) u32Refused );
+    if ( sSimOptions.u32RejoinMs > 0 )
+    {
+        printf ( "  rejoin          %u announced, %u host interviews done, firmware interviews %u complete,"
+                 " %u incomplete, %u not reported, %u requests unanswered\n",
+                 ( unsigned ) u32SimAnnounced, ( unsigned ) u32SimHostInterviews, ( unsigned ) u32SimFirmwareComplete,
+                 ( unsigned ) u32SimFirmwareFailed,
+                 ( unsigned ) ( u32SimAnnounced - u32SimFirmwareComplete - u32SimFirmwareFailed ),
+                 ( unsigned ) u32SimUnanswered );
+    }
+    printf ( "  %-28s %7s %8s %8s %8s %8s\n", "latency ms", "count", "p50", "p90", "p99", "max" );
+    for ( i = 0; i < E_SIM_LATENCY_TYPES; i++ )
+    {
+        qsort ( asSimLatency[i].pu32Us, asSimLatency[i].u32Count, sizeof ( uint32 ), iSimCompare );
+        printf ( "  %-28s %7u %8.1f %8.1f %8.1f %8.1f\n", apcSimLatencyName[i], ( unsigned ) asSimLatency[i].u32Count,
+                 dSimPercentile ( &asSimLatency[i], 50 ), dSimPercentile ( &asSimLatency[i], 90 ),
+                 dSimPercentile ( &asSimLatency[i], 99 ), dSimPercentile ( &asSimLatency[i], 100 ) );
+        free ( asSimLatency[i].pu32Us );
+    }
+    printf ( "  %-16s %8s %10s %9s\n", "host CPU", "events", "ms", "us/event" );
+    for ( i = 0; i < E_SIM_CPU_TYPES; i++ )
+    {
+        printf ( "  %-16s %8u %10.1f %9.2f\n", apcSimCpuName[i], ( unsigned ) au32SimCpuCount[i], au64SimCpuNs[i] / 1e6,
+                 au32SimCpuCount[i] ? au64SimCpuNs[i] / 1e3 / au32SimCpuCount[i] : 0.0 );
+    }
+    free ( psSimDevices );
+}
+
+PRIVATE void vSimUsage ( void )
+{
+    fprintf ( stderr, "usage: coordinator_sim [-n 50,100,200] [-d seconds] [-i report interval s]\n"
+                      "                       [-c commands/s] [-o OTA clients] [-a air time ms]\n"
+                      "                       [-j rejoin window s] [-s seed]\n" );
+    exit ( 2 );
+}
+
+/****************************************************************************/
+/***        Main                                                          ***/
+/****************************************************************************/
+
+int main ( int      argc,
+           char*    argv[] )
+{
+    char*     pcSize;
+    uint8     i;
+    int       iArg;
+
+    sSimOptions.u32Sizes[0]         =  50;
+    sSimOptions.u32Sizes[1]         =  100;
+    sSimOptions.u32Sizes[2]         =  200;
+    sSimOptions.u8Sizes             =  3;
+    sSimOptions.u32DurationMs       =  60000;
+    sSimOptions.u32ReportIntervalMs =  10000;
+    sSimOptions.u32CommandsPerKs    =  1000;
+    sSimOptions.u32OtaClients       =  0;
+    sSimOptions.u32AirTimeMs        =  10;
+    sSimOptions.u32RejoinMs         =  0;
+    sSimOptions.u32Seed             =  1;
+
+    for ( iArg = 1; iArg < argc; iArg++ )
+    {
+        if ( ( argv[iArg][0] != '-' ) || ( argv[iArg][1] == '\0' ) || ( argv[iArg][2] != '\0' ) || ( iArg + 1 == argc ) )
+        {
+            vSimUsage ( );
+        }
+        switch ( argv[iArg++][1] )
+        {
+            case 'n':
+                sSimOptions.u8Sizes =  0;
+                for ( pcSize = strtok ( argv[iArg], "," ); pcSize != NULL; pcSize = strtok ( NULL, "," ) )
+                {
+                    if ( sSimOptions.u8Sizes == SIM_MAX_SIZES )
+                    {
+                        vSimUsage ( );
+                    }
+                    sSimOptions.u32Sizes[sSimOptions.u8Sizes++] =  strtoul ( pcSize, NULL, 0 );
+                }
+            break;
+            case 'd': sSimOptions.u32DurationMs       =  strtoul ( argv[iArg], NULL, 0 ) * 1000; break;
+            case 'i': sSimOptions.u32ReportIntervalMs =  strtod ( argv[iArg], NULL ) * 1000;     break;
+            case 'c': sSimOptions.u32CommandsPerKs    =  strtod ( argv[iArg], NULL ) * 1000;     break;
+            case 'o': sSimOptions.u32OtaClients       =  strtoul ( argv[iArg], NULL, 0 );        break;
+            case 'a': sSimOptions.u32AirTimeMs        =  strtoul ( argv[iArg], NULL, 0 );        break;
+            case 'j': sSimOptions.u32RejoinMs         =  strtod ( argv[iArg], NULL ) * 1000;     break;
+            case 's': sSimOptions.u32Seed             =  strtoul ( argv[iArg], NULL, 0 );        break;
+            default:  vSimUsage ( );                                                              break;
+        }
+    }
+
+    for ( i = 0; i < sSimOptions.u8Sizes; i++ )
+    {
+        if ( ( sSimOptions.u32Sizes[i] == 0 ) || ( sSimOptions.u32Sizes[i] > SIM_MAX_DEVICES ) ||
+             ( sSimOptions.u32ReportIntervalMs == 0 ) || ( sSimOptions.u32DurationMs == 0 ) )
+        {
+            vSimUsage ( );
+        }
+        vSimStart ( sSimOptions.u32Sizes[i] );
+        vSimRun ( );
+    }
+    return 0;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
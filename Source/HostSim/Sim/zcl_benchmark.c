@@ -0,0 +1,286 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          zcl_benchmark.c
+ *
+ * DESCRIPTION:        Runs the ZCL serialisation benchmark on the host as
+ *                     the host asks for it over the serial link, and
+ *                     writes the result as JSON in the layout SerialLink.py
+ *                     writes a node's in, with types named by their ZCL
+ *                     type code. Each run is repeated and every path keeps
+ *                     its fewest cycles, so that scheduling noise does not
+ *                     count against it. Cycles are host time at the core
+ *                     clock, only comparable between runs on one host;
+ *                     Tools/ZclBenchmarkBaseline.py compares them.
+ *
+ *                     Usage:
+ *                     zcl_benchmark [-n iterations] [-r repeats]
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SerialLink.h"
+#include "app_zcl_benchmark.h"
+#include "host_sim.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Offsets into the E_SL_MSG_ZCL_BENCHMARK_RESULT payload */
+#define BENCH_RESULT_STATUS             0
+#define BENCH_RESULT_ITERATIONS         1
+#define BENCH_RESULT_CLOCK              3
+#define BENCH_RESULT_HEADER_WRITE       7
+#define BENCH_RESULT_HEADER_READ        11
+#define BENCH_RESULT_TYPES              15
+#define BENCH_RESULT_RECORDS            16
+
+/* Each per type record: type, encoded bytes and the cycles of each path */
+#define BENCH_RECORD_TYPE               0
+#define BENCH_RECORD_BYTES              1
+#define BENCH_RECORD_CYCLES             2
+#define BENCH_RECORD_SIZE               18
+
+#define BENCH_PATHS                     4
+#define BENCH_MAX_TYPES                 64
+
+/* Frame control, manufacturer code, sequence number and command */
+#define BENCH_HEADER_BYTES              5
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint8     u8Type;
+    uint8     u8Bytes;
+    uint32    au32Cycles[BENCH_PATHS];
+} tsBenchType;
+
+typedef struct
+{
+    uint8          u8Status;
+    uint16         u16Iterations;
+    uint32         u32Clock;
+    uint32         u32HeaderWrite;
+    uint32         u32HeaderRead;
+    uint8          u8Types;
+    tsBenchType    asTypes[BENCH_MAX_TYPES];
+} tsBenchResult;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE const char*    apcBenchStatus[] =  { "ok", "no buffer", "read back differs", "encoded back differs" };
+PRIVATE const char*    apcBenchPaths[BENCH_PATHS] =  { "write", "read", "forward", "encode" };
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE uint32 u32BenchGet ( const uint8*    pu8Payload )
+{
+    return ( ( uint32 ) pu8Payload[0] << 24 ) | ( ( uint32 ) pu8Payload[1] << 16 ) |
+           ( ( uint32 ) pu8Payload[2] << 8 ) | pu8Payload[3];
+}
+
+PRIVATE uint32 u32BenchMin ( uint32    u32Now,
+                             uint32    u32Best )
+{
+    return ( u32Now < u32Best ) ? u32Now : u32Best;
+}
+
+/* Runs the benchmark once and folds it into psResult, keeping the fewest
+ * cycles of every path; FALSE when no result came back */
+PRIVATE bool_t bBenchRun ( uint16           u16Iterations,
+                           bool_t           bFirst,
+                           tsBenchResult*   psResult )
+{
+    tsHostSerialFrame    sFrame;
+    tsBenchType*         psType;
+    const uint8*         pu8Record;
+    uint8                au8Payload[2];
+    uint8                i;
+    uint8                j;
+
+    HOST_vInit ( );
+    HOST_vRun ( 10 );
+    HOST_vSerialFlush ( );
+
+    au8Payload[0] =  ( uint8 ) ( u16Iterations >> 8 );
+    au8Payload[1] =  ( uint8 ) u16Iterations;
+    HOST_vSerialWrite ( E_SL_MSG_ZCL_BENCHMARK, sizeof ( au8Payload ), au8Payload );
+    HOST_vRun ( 100 );
+    if ( !HOST_bSerialFind ( E_SL_MSG_ZCL_BENCHMARK_RESULT, &sFrame ) || !sFrame.bCrcOk ||
+         ( sFrame.u16Length < BENCH_RESULT_RECORDS + 1 ) ||
+         ( sFrame.au8Payload[BENCH_RESULT_TYPES] > BENCH_MAX_TYPES ) ||
+         ( sFrame.u16Length < BENCH_RESULT_RECORDS + sFrame.au8Payload[BENCH_RESULT_TYPES] * BENCH_RECORD_SIZE + 1 ) )
+    {
+        return FALSE;
+    }
+
+    if ( bFirst )
+    {
+        memset ( psResult, 0, sizeof ( tsBenchResult ) );
+        psResult->u8Status       =  sFrame.au8Payload[BENCH_RESULT_STATUS];
+        psResult->u16Iterations  =  ( sFrame.au8Payload[BENCH_RESULT_ITERATIONS] << 8 ) |
+                                    sFrame.au8Payload[BENCH_RESULT_ITERATIONS + 1];
+        psResult->u32Clock       =  u32BenchGet ( &sFrame.au8Payload[BENCH_RESULT_CLOCK] );
+        psResult->u32HeaderWrite =  0xFFFFFFFF;
+        psResult->u32HeaderRead  =  0xFFFFFFFF;
+        psResult->u8Types        =  sFrame.au8Payload[BENCH_RESULT_TYPES];
+    }
+    else if ( psResult->u8Status == ZCL_BENCHMARK_STATUS_OK )
+    {
+        psResult->u8Status =  sFrame.au8Payload[BENCH_RESULT_STATUS];
+    }
+
+    psResult->u32HeaderWrite =  u32BenchMin ( u32BenchGet ( &sFrame.au8Payload[BENCH_RESULT_HEADER_WRITE] ),
+                                              psResult->u32HeaderWrite );
+    psResult->u32HeaderRead  =  u32BenchMin ( u32BenchGet ( &sFrame.au8Payload[BENCH_RESULT_HEADER_READ] ),
+                                              psResult->u32HeaderRead );
+    for ( i = 0; i < psResult->u8Types; i++ )
+    {
+        psType    =  &psResult->asTypes[i];
+        pu8Record =  &sFrame.au8Payload[BENCH_RESULT_RECORDS + i * BENCH_RECORD_SIZE];
+        if ( bFirst )
+        {
+            psType->u8Type  =  pu8Record[BENCH_RECORD_TYPE];
+            psType->u8Bytes =  pu8Record[BENCH_RECORD_BYTES];
+            for ( j = 0; j < BENCH_PATHS; j++ )
+            {
+                psType->au32Cycles[j] =  0xFFFFFFFF;
+            }
+        }
+        for ( j = 0; j < BENCH_PATHS; j++ )
+        {
+            psType->au32Cycles[j] =  u32BenchMin ( u32BenchGet ( &pu8Record[BENCH_RECORD_CYCLES + 4 * j] ),
+                                                   psType->au32Cycles[j] );
+        }
+    }
+    return TRUE;
+}
+
+/* The result as SerialLink.py's RunZclBenchmark returns it, cycles per operation */
+PRIVATE void vBenchWrite ( tsBenchResult*    psResult )
+{
+    double    dIterations =  psResult->u16Iterations;
+    uint8     i;
+    uint8     j;
+
+    printf ( "{\n" );
+    printf ( " \"clock_hz\": %u,\n", psResult->u32Clock );
+    printf ( " \"header\": {\n" );
+    printf ( "  \"bytes\": %u,\n", BENCH_HEADER_BYTES );
+    printf ( "  \"read\": %.2f,\n", psResult->u32HeaderRead / dIterations );
+    printf ( "  \"write\": %.2f\n", psResult->u32HeaderWrite / dIterations );
+    printf ( " },\n" );
+    printf ( " \"iterations\": %u,\n", psResult->u16Iterations );
+    if ( psResult->u8Status < ( sizeof ( apcBenchStatus ) / sizeof ( apcBenchStatus[0] ) ) )
+    {
+        printf ( " \"status\": \"%s\",\n", apcBenchStatus[psResult->u8Status] );
+    }
+    else
+    {
+        printf ( " \"status\": \"status %u\",\n", psResult->u8Status );
+    }
+    printf ( " \"types\": {\n" );
+    for ( i = 0; i < psResult->u8Types; i++ )
+    {
+        printf ( "  \"0x%02x\": {\n", psResult->asTypes[i].u8Type );
+        printf ( "   \"bytes\": %u,\n", psResult->asTypes[i].u8Bytes );
+        for ( j = 0; j < BENCH_PATHS; j++ )
+        {
+            printf ( "   \"%s\": %.2f,\n", apcBenchPaths[j], psResult->asTypes[i].au32Cycles[j] / dIterations );
+        }
+        printf ( "   \"type\": %u\n", psResult->asTypes[i].u8Type );
+        printf ( "  }%s\n", ( i + 1 < psResult->u8Types ) ? "," : "" );
+    }
+    printf ( " }\n" );
+    printf ( "}\n" );
+}
+
+PRIVATE void vBenchUsage ( void )
+{
+    fprintf ( stderr, "usage: zcl_benchmark [-n iterations] [-r repeats]\n" );
+    exit ( 2 );
+}
+
+/****************************************************************************/
+/***        Main                                                          ***/
+/****************************************************************************/
+
+int main ( int      argc,
+           char*    argv[] )
+{
+    tsBenchResult    sResult;
+    uint32           u32Iterations =  ZCL_BENCHMARK_MAX_ITERATIONS;
+    uint32           u32Repeats    =  20;
+    uint32           i;
+    int              iArg;
+
+    for ( iArg = 1; iArg < argc; iArg++ )
+    {
+        if ( ( argv[iArg][0] != '-' ) || ( argv[iArg][1] == '\0' ) || ( argv[iArg][2] != '\0' ) || ( iArg + 1 == argc ) )
+        {
+            vBenchUsage ( );
+        }
+        switch ( argv[iArg++][1] )
+        {
+            case 'n': u32Iterations =  strtoul ( argv[iArg], NULL, 0 ); break;
+            case 'r': u32Repeats    =  strtoul ( argv[iArg], NULL, 0 ); break;
+            default:  vBenchUsage ( );                                   break;
+        }
+    }
+    if ( ( u32Iterations == 0 ) || ( u32Iterations > ZCL_BENCHMARK_MAX_ITERATIONS ) || ( u32Repeats == 0 ) )
+    {
+        vBenchUsage ( );
+    }
+
+    for ( i = 0; i < u32Repeats; i++ )
+    {
+        if ( !bBenchRun ( ( uint16 ) u32Iterations, ( i == 0 ), &sResult ) )
+        {
+            fprintf ( stderr, "zcl_benchmark: no result from run %u\n", i + 1 );
+            return 1;
+        }
+    }
+    vBenchWrite ( &sResult );
+    return ( sResult.u8Status == ZCL_BENCHMARK_STATUS_OK ) ? 0 : 1;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,239 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          host_flash.c
+ *
+ * DESCRIPTION:        Internal flash for host builds: the OTA storage area
+ *                     the linker leaves between the application and the
+ *                     PDM, then the PDM segments, held in RAM and
+ *                     programmed a page at a time.
+ *                     Erases and programs keep to the target's rules, are
+ *                     charged a busy time, are counted per page and can be
+ *                     cut short by an injected loss of power.
+ *
+ ****************************************************************************
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stdint.h>
+#include <string.h>
+#include "fsl_flash.h"
+#include "host_sim.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Flash is programmed in 128 bit words, each once between erases */
+#define HOST_FLASH_WORD_SIZE            16
+
+#define HOST_STRING( x )                HOST_STRING_( x )
+#define HOST_STRING_( x )               #x
+
+#if ( HOST_FLASH_PAGE_SIZE != FLASH_PAGE_SIZE )
+#error HOST_FLASH_PAGE_SIZE does not match the flash driver
+#endif
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+PUBLIC uint8    au8HostFlash[HOST_FLASH_ALL_PAGES * HOST_FLASH_PAGE_SIZE] __attribute__ ( ( aligned ( HOST_FLASH_PAGE_SIZE ) ) );
+
+/* Linker script symbols: the storage area is the start of the emulated flash */
+__asm__ ( ".globl INT_STORAGE_END\n"
+          ".set INT_STORAGE_END, au8HostFlash\n"
+          ".globl INT_STORAGE_SIZE\n"
+          ".set INT_STORAGE_SIZE, " HOST_STRING ( HOST_FLASH_PAGES ) " * " HOST_STRING ( HOST_FLASH_PAGE_SIZE ) "\n" );
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE uint32    au32HostFlashErases[HOST_FLASH_ALL_PAGES];
+PRIVATE uint32    u32HostFlashBusyUs;
+PRIVATE uint32    u32HostFlashPowerFail;
+PRIVATE bool_t    bHostFlashPowerLost;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* Counts an operation towards an injected power failure */
+PRIVATE bool_t HOST_bFlashPowerFails ( void )
+{
+    if ( u32HostFlashPowerFail == 0 )
+    {
+        return FALSE;
+    }
+    if ( --u32HostFlashPowerFail == 0 )
+    {
+        bHostFlashPowerLost =  TRUE;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/* Erased flash, no wear and power on; the busy time runs on, as the
+ * timestamps built from it do */
+PUBLIC void HOST_vFlashInit ( void )
+{
+    memset ( au8HostFlash, 0xFF, sizeof ( au8HostFlash ) );
+    memset ( au32HostFlashErases, 0, sizeof ( au32HostFlashErases ) );
+    u32HostFlashPowerFail =  0;
+    bHostFlashPowerLost   =  FALSE;
+}
+
+/* Page of the emulated flash holding an address, or HOST_FLASH_ALL_PAGES */
+PUBLIC uint32 HOST_u32FlashPage ( const void*    pvAddress )
+{
+    uintptr_t    uOffset =  ( uintptr_t ) pvAddress - ( uintptr_t ) au8HostFlash;
+
+    if ( ( uintptr_t ) pvAddress < ( uintptr_t ) au8HostFlash )
+    {
+        return HOST_FLASH_ALL_PAGES;
+    }
+    return ( uOffset < sizeof ( au8HostFlash ) ) ? ( uint32 ) ( uOffset / HOST_FLASH_PAGE_SIZE ) : HOST_FLASH_ALL_PAGES;
+}
+
+PUBLIC uint32 HOST_u32FlashEraseCount ( uint32    u32Page )
+{
+    return ( u32Page < HOST_FLASH_ALL_PAGES ) ? au32HostFlashErases[u32Page] : 0;
+}
+
+/* Microseconds the flash has been busy since the process started */
+PUBLIC uint32 HOST_u32FlashBusyUs ( void )
+{
+    return u32HostFlashBusyUs;
+}
+
+/* The supply fails part way through the u32Operations'th erase or program
+ * from now, and every later one fails until HOST_vFlashPowerRestore; 0
+ * cancels an injection still pending */
+PUBLIC void HOST_vFlashPowerFail ( uint32    u32Operations )
+{
+    u32HostFlashPowerFail =  u32Operations;
+}
+
+PUBLIC bool_t HOST_bFlashPowerLost ( void )
+{
+    return bHostFlashPowerLost;
+}
+
+PUBLIC void HOST_vFlashPowerRestore ( void )
+{
+    u32HostFlashPowerFail =  0;
+    bHostFlashPowerLost   =  FALSE;
+}
+
+/* Flash driver: page numbers count from address 0, the emulated pages sit
+ * where the host linked au8HostFlash. A cut erase leaves the first half of
+ * the page erased and the rest as it was. */
+PUBLIC int FLASH_ErasePages ( FLASH_Type*    pFLASH,
+                              uint32_t       u32StartPage,
+                              uint32_t       u32PageCount )
+{
+    uint8*    pu8Page =  ( uint8* ) ( ( uintptr_t ) u32StartPage * HOST_FLASH_PAGE_SIZE );
+    uint32    u32Page =  HOST_u32FlashPage ( pu8Page );
+
+    if ( ( u32Page + u32PageCount ) > HOST_FLASH_ALL_PAGES )
+    {
+        return kStatus_FLASH_Error;
+    }
+    for ( ; u32PageCount > 0; u32PageCount--, u32Page++, pu8Page += HOST_FLASH_PAGE_SIZE )
+    {
+        if ( bHostFlashPowerLost )
+        {
+            return kStatus_FLASH_Fail;
+        }
+        au32HostFlashErases[u32Page]++;
+        u32HostFlashBusyUs +=  HOST_FLASH_ERASE_US;
+        if ( HOST_bFlashPowerFails ( ) )
+        {
+            memset ( pu8Page, 0xFF, HOST_FLASH_PAGE_SIZE / 2 );
+            return kStatus_FLASH_Fail;
+        }
+        memset ( pu8Page, 0xFF, HOST_FLASH_PAGE_SIZE );
+    }
+    return kStatus_FLASH_Success;
+}
+
+/* Words not erased since they were last programmed are refused, as the
+ * target's ECC would make them unreadable. A cut program leaves the first
+ * half of the words written. */
+PUBLIC int FLASH_Program ( FLASH_Type*    pFLASH,
+                           uint32_t*      pu32Start,
+                           uint32_t*      pu32Src,
+                           uint32_t       u32Length )
+{
+    uint8*          pu8Dst   =  ( uint8* ) pu32Start;
+    const uint8*    pu8Src   =  ( const uint8* ) pu32Src;
+    uint32          u32Words =  u32Length / HOST_FLASH_WORD_SIZE;
+    uint32          u32Write =  u32Words;
+    uint32          i;
+
+    if ( ( ( ( uintptr_t ) pu8Dst % HOST_FLASH_WORD_SIZE ) != 0 ) ||
+         ( ( u32Length % HOST_FLASH_WORD_SIZE ) != 0 ) )
+    {
+        return kStatus_FLASH_AlignmentError;
+    }
+    if ( ( u32Length == 0 ) ||
+         ( HOST_u32FlashPage ( pu8Dst ) == HOST_FLASH_ALL_PAGES ) ||
+         ( HOST_u32FlashPage ( pu8Dst + u32Length - 1 ) == HOST_FLASH_ALL_PAGES ) )
+    {
+        return kStatus_FLASH_InvalidArgument;
+    }
+    if ( bHostFlashPowerLost )
+    {
+        return kStatus_FLASH_Fail;
+    }
+    for ( i = 0; i < u32Length; i++ )
+    {
+        if ( pu8Dst[i] != 0xFF )
+        {
+            return kStatus_FLASH_EccError;
+        }
+    }
+
+    u32HostFlashBusyUs +=  u32Words * HOST_FLASH_PROGRAM_WORD_US;
+    if ( HOST_bFlashPowerFails ( ) )
+    {
+        u32Write =  u32Words / 2;
+    }
+    memcpy ( pu8Dst, pu8Src, u32Write * HOST_FLASH_WORD_SIZE );
+    return ( u32Write == u32Words ) ? kStatus_FLASH_Success : kStatus_FLASH_Fail;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,746 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          host_pdm.c
+ *
+ * DESCRIPTION:        Persistent data manager for host builds: records are
+ *                     appended to a log in the PDM segments of the emulated
+ *                     flash, so saves cost erase and program time, wear the
+ *                     pages and can be cut by a loss of power. When the log
+ *                     runs out of erased pages the oldest one is compacted:
+ *                     its live records are copied to the head, then it is
+ *                     erased. PDM_eInitialise rebuilds the record index from
+ *                     the flash as the library does at boot. The binary is
+ *                     linked with the firmware's --wrap=PDM_eSaveRecordData
+ *                     so saves pass through the PDM telemetry first.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stdint.h>
+#include <string.h>
+#include "PDM.h"
+#include "PDM_IDs.h"
+#include "fsl_flash.h"
+#include "host_sim.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define HOST_PDM_MAX_RECORDS            64
+
+/* Flash is programmed in 128 bit words. Each page of the log starts with a
+ * header word, the rest carries records, which run on across pages. */
+#define HOST_PDM_WORD_SIZE              16
+#define HOST_PDM_PAGE_WORDS             ( ( HOST_FLASH_PAGE_SIZE / HOST_PDM_WORD_SIZE ) - 1 )
+#define HOST_PDM_LOG_WORDS              ( HOST_FLASH_PDM_PAGES * HOST_PDM_PAGE_WORDS )
+#define HOST_PDM_RECORD_WORDS( u16Length )    ( 1 + ( ( ( uint32 ) ( u16Length ) + HOST_PDM_WORD_SIZE - 1 ) / HOST_PDM_WORD_SIZE ) )
+
+#define HOST_PDM_PAGE_MAGIC             0x50444D50
+#define HOST_PDM_RECORD_MAGIC           0x5244
+#define HOST_PDM_NO_RECORD              0xFFFF
+
+/* Record flags */
+#define HOST_PDM_DELETED                0x0001
+
+
+#if ( HOST_FLASH_PDM_PAGES != PDM_NUM_SEGMENTS )
+#error HOST_FLASH_PDM_PAGES does not match the PDM segments
+#endif
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+/* First word of a page of the log. Pages follow each other round the PDM
+ * segments with consecutive sequence numbers. */
+typedef struct
+{
+    uint32    u32Magic;
+    uint32    u32Sequence;
+    uint32    u32SequenceCheck;
+    uint16    u16FirstRecord;     /* Word of the first record starting in the page */
+    uint16    u16Reserved;
+} tsHostPdmPage;
+
+/* First word of a record, the data follows in as many words as it takes */
+typedef struct
+{
+    uint16    u16Magic;
+    uint16    u16Id;
+    uint16    u16Length;
+    uint16    u16Flags;
+    uint32    u32Check;
+    uint32    u32Reserved;
+} tsHostPdmRecordHeader;
+
+/* Index entry: where the latest copy of a record is in the log */
+typedef struct
+{
+    bool_t    bUsed;
+    uint16    u16Id;
+    uint16    u16Length;
+    uint32    u32Word;
+} tsHostPdmRecord;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsHostPdmRecord    asHostPdmRecords[HOST_PDM_MAX_RECORDS];
+
+/* The log: its oldest page, how many pages it has and the next word to
+ * program. The head is at the start of a page only once the newest one is
+ * full, the page it points at is opened by the next write. */
+PRIVATE uint32             u32HostPdmTail;
+PRIVATE uint32             u32HostPdmPages;
+PRIVATE uint32             u32HostPdmHead;
+PRIVATE uint32             u32HostPdmSequence;
+
+PRIVATE uint32             u32HostPdmSaves;
+PRIVATE uint32             u32HostPdmReadBytes;
+PRIVATE uint32             u32HostPdmWriteBytes;
+PRIVATE uint32             u32HostPdmCompactions;
+PRIVATE uint32             u32HostPdmCompactionUs;
+PRIVATE uint32             u32HostPdmCompactionMaxUs;
+
+/* A record as it is programmed: header word, then the data padded with
+ * erased bytes to whole words */
+PRIVATE uint8              au8HostPdmStage[HOST_PDM_RECORD_WORDS ( 0xFFFF ) * HOST_PDM_WORD_SIZE] __attribute__ ( ( aligned ( 4 ) ) );
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE uint8* HOST_pu8PdmPage ( uint32    u32Page )
+{
+    return &au8HostFlash[( HOST_FLASH_PAGES + u32Page ) * HOST_FLASH_PAGE_SIZE];
+}
+
+PRIVATE uint8* HOST_pu8PdmWord ( uint32    u32Word )
+{
+    return HOST_pu8PdmPage ( u32Word / HOST_PDM_PAGE_WORDS ) + ( 1 + ( u32Word % HOST_PDM_PAGE_WORDS ) ) * HOST_PDM_WORD_SIZE;
+}
+
+PRIVATE bool_t HOST_bPdmBlank ( const uint8*    pu8Data,
+                                uint32          u32Length )
+{
+    while ( u32Length-- > 0 )
+    {
+        if ( *pu8Data++ != 0xFF )
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+PRIVATE bool_t HOST_bPdmErase ( uint32    u32Page )
+{
+    return ( FLASH_ErasePages ( FLASH, ( uint32 ) ( ( uintptr_t ) HOST_pu8PdmPage ( u32Page ) / HOST_FLASH_PAGE_SIZE ), 1 ) == kStatus_FLASH_Success );
+}
+
+/* Header of a page of the log, or NULL if the page doesn't hold a valid one */
+PRIVATE const tsHostPdmPage* HOST_psPdmPage ( uint32    u32Page )
+{
+    const tsHostPdmPage*    psPage =  ( const tsHostPdmPage* ) HOST_pu8PdmPage ( u32Page );
+
+    if ( ( psPage->u32Magic != HOST_PDM_PAGE_MAGIC ) || ( psPage->u32SequenceCheck != ~psPage->u32Sequence ) )
+    {
+        return NULL;
+    }
+    return psPage;
+}
+
+/* Reads data that may run on across pages */
+PRIVATE void HOST_vPdmRead ( uint32    u32Word,
+                             uint8*    pu8Data,
+                             uint32    u32Length )
+{
+    uint32    u32Chunk;
+
+    while ( u32Length > 0 )
+    {
+        u32Chunk =  ( u32Length < HOST_PDM_WORD_SIZE ) ? u32Length : HOST_PDM_WORD_SIZE;
+        memcpy ( pu8Data, HOST_pu8PdmWord ( u32Word ), u32Chunk );
+        pu8Data   +=  u32Chunk;
+        u32Length -=  u32Chunk;
+        u32Word    =  ( u32Word + 1 ) % HOST_PDM_LOG_WORDS;
+    }
+}
+
+/* FNV-1a over the header fields and the data, so that a record cut short
+ * by a loss of power is not taken for a good one */
+PRIVATE uint32 HOST_u32PdmCheck ( const tsHostPdmRecordHeader*    psHeader,
+                                  const uint8*                    pu8Data )
+{
+    uint32    u32Check =  2166136261u;
+    uint8     au8Fields[6];
+    uint32    i;
+
+    memcpy ( au8Fields, &psHeader->u16Id, sizeof ( au8Fields ) );
+    for ( i = 0; i < sizeof ( au8Fields ); i++ )
+    {
+        u32Check =  ( u32Check ^ au8Fields[i] ) * 16777619u;
+    }
+    for ( i = 0; i < psHeader->u16Length; i++ )
+    {
+        u32Check =  ( u32Check ^ pu8Data[i] ) * 16777619u;
+    }
+    return u32Check;
+}
+
+/* Words that can be programmed before the head reaches the oldest page */
+PRIVATE uint32 HOST_u32PdmFreeWords ( void )
+{
+    uint32    u32InPage =  u32HostPdmHead % HOST_PDM_PAGE_WORDS;
+
+    return ( ( HOST_FLASH_PDM_PAGES - u32HostPdmPages ) * HOST_PDM_PAGE_WORDS ) +
+           ( ( u32InPage == 0 ) ? 0 : ( HOST_PDM_PAGE_WORDS - u32InPage ) );
+}
+
+PRIVATE tsHostPdmRecord* HOST_psPdmFind ( uint16    u16IdValue )
+{
+    uint8    i;
+
+    for ( i = 0; i < HOST_PDM_MAX_RECORDS; i++ )
+    {
+        if ( asHostPdmRecords[i].bUsed && ( asHostPdmRecords[i].u16Id == u16IdValue ) )
+        {
+            return &asHostPdmRecords[i];
+        }
+    }
+    return NULL;
+}
+
+PRIVATE tsHostPdmRecord* HOST_psPdmFree ( void )
+{
+    uint8    i;
+
+    for ( i = 0; i < HOST_PDM_MAX_RECORDS; i++ )
+    {
+        if ( !asHostPdmRecords[i].bUsed )
+        {
+            return &asHostPdmRecords[i];
+        }
+    }
+    return NULL;
+}
+
+/* Opens the page at the head with a header saying where its first record
+ * starts, u32Continued words in if a record runs on into it. A page left
+ * part written by a loss of power is erased first. */
+PRIVATE bool_t HOST_bPdmOpenPage ( uint32    u32Continued )
+{
+    uint32           u32Page =  u32HostPdmHead / HOST_PDM_PAGE_WORDS;
+    tsHostPdmPage    sPage;
+
+    if ( u32HostPdmPages == HOST_FLASH_PDM_PAGES )
+    {
+        return FALSE;
+    }
+    if ( !HOST_bPdmBlank ( HOST_pu8PdmPage ( u32Page ), HOST_FLASH_PAGE_SIZE ) && !HOST_bPdmErase ( u32Page ) )
+    {
+        return FALSE;
+    }
+
+    sPage.u32Magic         =  HOST_PDM_PAGE_MAGIC;
+    sPage.u32Sequence      =  u32HostPdmSequence + 1;
+    sPage.u32SequenceCheck =  ~sPage.u32Sequence;
+    sPage.u16FirstRecord   =  ( u32Continued < HOST_PDM_PAGE_WORDS ) ? ( uint16 ) u32Continued : HOST_PDM_NO_RECORD;
+    sPage.u16Reserved      =  0xFFFF;
+    if ( FLASH_Program ( FLASH, ( uint32* ) HOST_pu8PdmPage ( u32Page ), ( uint32* ) &sPage, sizeof ( sPage ) ) != kStatus_FLASH_Success )
+    {
+        return FALSE;
+    }
+    if ( u32HostPdmPages == 0 )
+    {
+        u32HostPdmTail =  u32Page;
+    }
+    u32HostPdmPages++;
+    u32HostPdmSequence++;
+    return TRUE;
+}
+
+/* Programs the staged record at the head, a page at a time */
+PRIVATE bool_t HOST_bPdmProgram ( uint32    u32Words )
+{
+    uint32    u32Done =  0;
+    uint32    u32Chunk;
+
+    while ( u32Done < u32Words )
+    {
+        if ( ( ( u32HostPdmHead % HOST_PDM_PAGE_WORDS ) == 0 ) &&
+             !HOST_bPdmOpenPage ( ( u32Done == 0 ) ? 0 : ( u32Words - u32Done ) ) )
+        {
+            return FALSE;
+        }
+        u32Chunk =  HOST_PDM_PAGE_WORDS - ( u32HostPdmHead % HOST_PDM_PAGE_WORDS );
+        if ( u32Chunk > ( u32Words - u32Done ) )
+        {
+            u32Chunk =  u32Words - u32Done;
+        }
+        if ( FLASH_Program ( FLASH,
+                             ( uint32* ) HOST_pu8PdmWord ( u32HostPdmHead ),
+                             ( uint32* ) &au8HostPdmStage[u32Done * HOST_PDM_WORD_SIZE],
+                             u32Chunk * HOST_PDM_WORD_SIZE ) != kStatus_FLASH_Success )
+        {
+            return FALSE;
+        }
+        u32HostPdmHead =  ( u32HostPdmHead + u32Chunk ) % HOST_PDM_LOG_WORDS;
+        u32Done        +=  u32Chunk;
+    }
+    return TRUE;
+}
+
+/* Appends the record whose data is staged and points its index entry at it */
+PRIVATE bool_t HOST_bPdmAppend ( uint16              u16Id,
+                                 uint16              u16Length,
+                                 uint16              u16Flags,
+                                 tsHostPdmRecord*    psRecord )
+{
+    tsHostPdmRecordHeader*    psHeader =  ( tsHostPdmRecordHeader* ) au8HostPdmStage;
+    uint32                    u32Words =  HOST_PDM_RECORD_WORDS ( u16Length );
+    uint32                    u32Word  =  u32HostPdmHead;
+
+    memset ( &au8HostPdmStage[HOST_PDM_WORD_SIZE + u16Length], 0xFF, ( u32Words * HOST_PDM_WORD_SIZE ) - HOST_PDM_WORD_SIZE - u16Length );
+    psHeader->u16Magic    =  HOST_PDM_RECORD_MAGIC;
+    psHeader->u16Id       =  u16Id;
+    psHeader->u16Length   =  u16Length;
+    psHeader->u16Flags    =  u16Flags;
+    psHeader->u32Reserved =  0xFFFFFFFF;
+    psHeader->u32Check    =  HOST_u32PdmCheck ( psHeader, &au8HostPdmStage[HOST_PDM_WORD_SIZE] );
+    if ( !HOST_bPdmProgram ( u32Words ) )
+    {
+        return FALSE;
+    }
+    if ( psRecord != NULL )
+    {
+        psRecord->bUsed     =  TRUE;
+        psRecord->u16Id     =  u16Id;
+        psRecord->u16Length =  u16Length;
+        psRecord->u32Word   =  u32Word;
+    }
+    return TRUE;
+}
+
+/* Words of the largest live record, or of a new one if larger */
+PRIVATE uint32 HOST_u32PdmLargest ( uint32    u32Words )
+{
+    uint32    u32Record;
+    uint8     i;
+
+    for ( i = 0; i < HOST_PDM_MAX_RECORDS; i++ )
+    {
+        u32Record =  HOST_PDM_RECORD_WORDS ( asHostPdmRecords[i].u16Length );
+        if ( asHostPdmRecords[i].bUsed && ( u32Record > u32Words ) )
+        {
+            u32Words =  u32Record;
+        }
+    }
+    return u32Words;
+}
+
+/* Erased words kept ahead of the head once a record is written. Compacting
+ * a page copies out the records starting in it, at most a page less a word
+ * and the largest record, and the one after it may need as much again. */
+PRIVATE uint32 HOST_u32PdmHeadroom ( uint32    u32Words )
+{
+    return 2 * ( HOST_u32PdmLargest ( u32Words ) + HOST_PDM_PAGE_WORDS );
+}
+
+/* Compacts the oldest pages until u32Words fit ahead of the head with the
+ * headroom left: the records starting in a page are copied to the head,
+ * then it is erased */
+PRIVATE bool_t HOST_bPdmMakeRoom ( uint32    u32Words )
+{
+    uint32    u32Needed  =  u32Words + HOST_u32PdmHeadroom ( u32Words );
+    uint32    u32StartUs =  HOST_u32FlashBusyUs ( );
+    uint32    u32Copy;
+    uint32    u32Us;
+    uint8     i;
+
+    if ( HOST_u32PdmFreeWords ( ) >= u32Needed )
+    {
+        return TRUE;
+    }
+    while ( HOST_u32PdmFreeWords ( ) < u32Needed )
+    {
+        u32Copy =  0;
+        for ( i = 0; i < HOST_PDM_MAX_RECORDS; i++ )
+        {
+            if ( asHostPdmRecords[i].bUsed && ( ( asHostPdmRecords[i].u32Word / HOST_PDM_PAGE_WORDS ) == u32HostPdmTail ) )
+            {
+                u32Copy +=  HOST_PDM_RECORD_WORDS ( asHostPdmRecords[i].u16Length );
+            }
+        }
+        if ( ( u32HostPdmPages <= 1 ) || ( u32Copy > HOST_u32PdmFreeWords ( ) ) )
+        {
+            return FALSE;
+        }
+
+        for ( i = 0; i < HOST_PDM_MAX_RECORDS; i++ )
+        {
+            if ( asHostPdmRecords[i].bUsed && ( ( asHostPdmRecords[i].u32Word / HOST_PDM_PAGE_WORDS ) == u32HostPdmTail ) )
+            {
+                HOST_vPdmRead ( ( asHostPdmRecords[i].u32Word + 1 ) % HOST_PDM_LOG_WORDS,
+                                &au8HostPdmStage[HOST_PDM_WORD_SIZE],
+                                asHostPdmRecords[i].u16Length );
+                if ( !HOST_bPdmAppend ( asHostPdmRecords[i].u16Id, asHostPdmRecords[i].u16Length, 0, &asHostPdmRecords[i] ) )
+                {
+                    return FALSE;
+                }
+            }
+        }
+        if ( !HOST_bPdmErase ( u32HostPdmTail ) )
+        {
+            return FALSE;
+        }
+        u32HostPdmTail =  ( u32HostPdmTail + 1 ) % HOST_FLASH_PDM_PAGES;
+        u32HostPdmPages--;
+    }
+
+    u32Us =  HOST_u32FlashBusyUs ( ) - u32StartUs;
+    u32HostPdmCompactions++;
+    u32HostPdmCompactionUs +=  u32Us;
+    if ( u32Us > u32HostPdmCompactionMaxUs )
+    {
+        u32HostPdmCompactionMaxUs =  u32Us;
+    }
+    return TRUE;
+}
+
+/* Whether a record of u32Words, replacing psRecord if not NULL, leaves room
+ * for the headroom */
+PRIVATE bool_t HOST_bPdmFits ( uint32                    u32Words,
+                               const tsHostPdmRecord*    psRecord )
+{
+    uint32    u32Live =  u32Words;
+    uint8     i;
+
+    for ( i = 0; i < HOST_PDM_MAX_RECORDS; i++ )
+    {
+        if ( asHostPdmRecords[i].bUsed && ( &asHostPdmRecords[i] != psRecord ) )
+        {
+            u32Live +=  HOST_PDM_RECORD_WORDS ( asHostPdmRecords[i].u16Length );
+        }
+    }
+    return ( ( u32Live + HOST_u32PdmHeadroom ( u32Words ) ) <= HOST_PDM_LOG_WORDS );
+}
+
+/* Offset from the start of the log of the first record starting in its
+ * u32Index'th page or after it */
+PRIVATE uint32 HOST_u32PdmFirstRecord ( uint32    u32Index )
+{
+    const tsHostPdmPage*    psPage;
+
+    for ( ; u32Index < u32HostPdmPages; u32Index++ )
+    {
+        psPage =  HOST_psPdmPage ( ( u32HostPdmTail + u32Index ) % HOST_FLASH_PDM_PAGES );
+        if ( psPage->u16FirstRecord != HOST_PDM_NO_RECORD )
+        {
+            return ( u32Index * HOST_PDM_PAGE_WORDS ) + psPage->u16FirstRecord;
+        }
+    }
+    return u32HostPdmPages * HOST_PDM_PAGE_WORDS;
+}
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+/* Boot: the log starts at the valid page with the lowest sequence and runs
+ * on through the pages whose sequences follow. Its records are replayed in
+ * order, the last copy of each wins; a record cut short ends what is read
+ * of its page, and the head moves past anything left programmed. */
+PUBLIC PDM_teStatus PDM_eInitialise ( uint16_t                       u16StartSegment,
+                                      uint8_t                        u8NumberOfSegments,
+                                      PDM_tpfvSystemEventCallback    fpvPDM_SystemEventCallback )
+{
+    const tsHostPdmPage*            psPage;
+    const tsHostPdmPage*            psTail =  NULL;
+    tsHostPdmRecordHeader           sHeader;
+    tsHostPdmRecord*                psRecord;
+    PDM_teStatus                    eStatus =  PDM_E_STATUS_OK;
+    uint32                          u32End;
+    uint32                          u32Offset;
+    uint32                          u32Valid =  0;
+    uint32                          u32Words;
+    uint32                          u32Page;
+
+    if ( u8NumberOfSegments != HOST_FLASH_PDM_PAGES )
+    {
+        return PDM_E_STATUS_INVLD_PARAM;
+    }
+    memset ( asHostPdmRecords, 0, sizeof ( asHostPdmRecords ) );
+    u32HostPdmTail            =  0;
+    u32HostPdmPages           =  0;
+    u32HostPdmHead            =  0;
+    u32HostPdmSequence        =  0;
+    u32HostPdmSaves           =  0;
+    u32HostPdmReadBytes       =  0;
+    u32HostPdmWriteBytes      =  0;
+    u32HostPdmCompactions     =  0;
+    u32HostPdmCompactionUs    =  0;
+    u32HostPdmCompactionMaxUs =  0;
+
+    for ( u32Page = 0; u32Page < HOST_FLASH_PDM_PAGES; u32Page++ )
+    {
+        psPage =  HOST_psPdmPage ( u32Page );
+        if ( ( psPage != NULL ) && ( ( psTail == NULL ) || ( psPage->u32Sequence < psTail->u32Sequence ) ) )
+        {
+            psTail         =  psPage;
+            u32HostPdmTail =  u32Page;
+        }
+    }
+    if ( psTail == NULL )
+    {
+        return PDM_E_STATUS_OK;
+    }
+    u32HostPdmSequence =  psTail->u32Sequence;
+    u32HostPdmPages    =  1;
+    while ( u32HostPdmPages < HOST_FLASH_PDM_PAGES )
+    {
+        psPage =  HOST_psPdmPage ( ( u32HostPdmTail + u32HostPdmPages ) % HOST_FLASH_PDM_PAGES );
+        if ( ( psPage == NULL ) || ( psPage->u32Sequence != ( u32HostPdmSequence + 1 ) ) )
+        {
+            break;
+        }
+        u32HostPdmPages++;
+        u32HostPdmSequence++;
+    }
+
+    u32End    =  u32HostPdmPages * HOST_PDM_PAGE_WORDS;
+    u32Offset =  HOST_u32PdmFirstRecord ( 0 );
+    while ( u32Offset < u32End )
+    {
+        HOST_vPdmRead ( ( u32HostPdmTail * HOST_PDM_PAGE_WORDS + u32Offset ) % HOST_PDM_LOG_WORDS,
+                        ( uint8* ) &sHeader, sizeof ( sHeader ) );
+        u32Words =  HOST_PDM_RECORD_WORDS ( sHeader.u16Length );
+        if ( ( sHeader.u16Magic == HOST_PDM_RECORD_MAGIC ) && ( ( u32Offset + u32Words ) <= u32End ) )
+        {
+            HOST_vPdmRead ( ( u32HostPdmTail * HOST_PDM_PAGE_WORDS + u32Offset + 1 ) % HOST_PDM_LOG_WORDS,
+                            au8HostPdmStage, sHeader.u16Length );
+        }
+        if ( ( sHeader.u16Magic != HOST_PDM_RECORD_MAGIC ) || ( ( u32Offset + u32Words ) > u32End ) ||
+             ( sHeader.u32Check != HOST_u32PdmCheck ( &sHeader, au8HostPdmStage ) ) )
+        {
+            /* Nothing more in this page that can be read */
+            u32Offset =  HOST_u32PdmFirstRecord ( ( u32Offset / HOST_PDM_PAGE_WORDS ) + 1 );
+            continue;
+        }
+
+        psRecord =  HOST_psPdmFind ( sHeader.u16Id );
+        if ( ( sHeader.u16Flags & HOST_PDM_DELETED ) != 0 )
+        {
+            if ( psRecord != NULL )
+            {
+                psRecord->bUsed =  FALSE;
+            }
+        }
+        else
+        {
+            if ( psRecord == NULL )
+            {
+                psRecord =  HOST_psPdmFree ( );
+            }
+            if ( psRecord != NULL )
+            {
+                psRecord->bUsed     =  TRUE;
+                psRecord->u16Id     =  sHeader.u16Id;
+                psRecord->u16Length =  sHeader.u16Length;
+                psRecord->u32Word   =  ( u32HostPdmTail * HOST_PDM_PAGE_WORDS + u32Offset ) % HOST_PDM_LOG_WORDS;
+            }
+        }
+        u32Offset +=  u32Words;
+        u32Valid   =  u32Offset;
+    }
+
+    /* Writing goes on after the last good record if it ends part way into
+     * the newest page and the rest of that page is erased, else in a new
+     * page after it */
+    u32HostPdmHead =  ( u32HostPdmTail * HOST_PDM_PAGE_WORDS + u32Valid ) % HOST_PDM_LOG_WORDS;
+    if ( u32Valid < u32End )
+    {
+        if ( ( ( u32Valid / HOST_PDM_PAGE_WORDS ) != ( u32HostPdmPages - 1 ) ) ||
+             ( ( u32Valid % HOST_PDM_PAGE_WORDS ) == 0 ) ||
+             !HOST_bPdmBlank ( HOST_pu8PdmWord ( u32HostPdmHead ), ( u32End - u32Valid ) * HOST_PDM_WORD_SIZE ) )
+        {
+            u32HostPdmHead =  ( ( u32HostPdmTail + u32HostPdmPages ) % HOST_FLASH_PDM_PAGES ) * HOST_PDM_PAGE_WORDS;
+        }
+        if ( !HOST_bPdmBlank ( HOST_pu8PdmWord ( ( u32HostPdmTail * HOST_PDM_PAGE_WORDS + u32Valid ) % HOST_PDM_LOG_WORDS ),
+                               ( HOST_PDM_PAGE_WORDS - ( u32Valid % HOST_PDM_PAGE_WORDS ) ) * HOST_PDM_WORD_SIZE ) )
+        {
+            eStatus =  PDM_E_STATUS_RECOVERED;
+        }
+    }
+    return eStatus;
+}
+
+PUBLIC PDM_teStatus PDM_eSaveRecordData ( uint16_t    u16IdValue,
+                                          void*       pvDataBuffer,
+                                          uint16_t    u16Datalength )
+{
+    tsHostPdmRecord*    psRecord =  HOST_psPdmFind ( u16IdValue );
+    uint32              u32Words =  HOST_PDM_RECORD_WORDS ( u16Datalength );
+
+    if ( psRecord == NULL )
+    {
+        psRecord =  HOST_psPdmFree ( );
+        if ( psRecord == NULL )
+        {
+            return PDM_E_STATUS_PDM_FULL;
+        }
+        psRecord->u16Length =  0;
+    }
+    if ( !HOST_bPdmFits ( u32Words, psRecord->bUsed ? psRecord : NULL ) )
+    {
+        return PDM_E_STATUS_PDM_FULL;
+    }
+    if ( !HOST_bPdmMakeRoom ( u32Words ) )
+    {
+        return PDM_E_STATUS_NOT_SAVED;
+    }
+
+    memcpy ( &au8HostPdmStage[HOST_PDM_WORD_SIZE], pvDataBuffer, u16Datalength );
+    if ( !HOST_bPdmAppend ( u16IdValue, u16Datalength, 0, psRecord ) )
+    {
+        return PDM_E_STATUS_NOT_SAVED;
+    }
+    u32HostPdmSaves++;
+    u32HostPdmWriteBytes +=  u32Words * HOST_PDM_WORD_SIZE;
+    return PDM_E_STATUS_OK;
+}
+
+PUBLIC PDM_teStatus PDM_eReadDataFromRecord ( uint16_t     u16IdValue,
+                                              void*        pvDataBuffer,
+                                              uint16_t     u16DataBufferLength,
+                                              uint16_t*    pu16DataBytesRead )
+{
+    tsHostPdmRecord*    psRecord =  HOST_psPdmFind ( u16IdValue );
+    uint16              u16Length;
+
+    *pu16DataBytesRead =  0;
+    if ( psRecord == NULL )
+    {
+        return PDM_E_STATUS_INVLD_PARAM;
+    }
+    u16Length =  ( psRecord->u16Length < u16DataBufferLength ) ? psRecord->u16Length : u16DataBufferLength;
+    HOST_vPdmRead ( ( psRecord->u32Word + 1 ) % HOST_PDM_LOG_WORDS, pvDataBuffer, u16Length );
+    u32HostPdmReadBytes +=  u16Length;
+    *pu16DataBytesRead   =  u16Length;
+    return PDM_E_STATUS_OK;
+}
+
+PUBLIC bool_t PDM_bDoesDataExist ( uint16_t     u16IdValue,
+                                   uint16_t*    pu16DataLength )
+{
+    tsHostPdmRecord*    psRecord =  HOST_psPdmFind ( u16IdValue );
+
+    *pu16DataLength =  ( psRecord != NULL ) ? psRecord->u16Length : 0;
+    return ( psRecord != NULL );
+}
+
+/* The deletion is a record of its own, older copies may still be in flash */
+PUBLIC void PDM_vDeleteDataRecord ( uint16_t    u16IdValue )
+{
+    tsHostPdmRecord*    psRecord =  HOST_psPdmFind ( u16IdValue );
+
+    if ( ( psRecord != NULL ) && HOST_bPdmMakeRoom ( HOST_PDM_RECORD_WORDS ( 0 ) ) &&
+         HOST_bPdmAppend ( u16IdValue, 0, HOST_PDM_DELETED, NULL ) )
+    {
+        psRecord->bUsed =  FALSE;
+    }
+}
+
+PUBLIC void PDM_vDeleteAllDataRecords ( void )
+{
+    uint32    u32Page;
+
+    for ( u32Page = 0; u32Page < HOST_FLASH_PDM_PAGES; u32Page++ )
+    {
+        if ( !HOST_bPdmBlank ( HOST_pu8PdmPage ( u32Page ), HOST_FLASH_PAGE_SIZE ) )
+        {
+            HOST_bPdmErase ( u32Page );
+        }
+    }
+    PDM_eInitialise ( PDM_START_SEGMENT, PDM_NUM_SEGMENTS, NULL );
+}
+
+/* Each erase of a PDM page counts as wear of its segment */
+PUBLIC PDM_teStatus PDM_eGetSegmentWearCount ( uint8_t      u8SegmentIndex,
+                                               uint32_t*    pu32WearCount )
+{
+    if ( u8SegmentIndex >= HOST_FLASH_PDM_PAGES )
+    {
+        *pu32WearCount =  0;
+        return PDM_E_STATUS_INVLD_PARAM;
+    }
+    *pu32WearCount =  HOST_u32FlashEraseCount ( HOST_FLASH_PAGES + u8SegmentIndex );
+    return PDM_E_STATUS_OK;
+}
+
+/* Records saved since PDM_eInitialise, copies made by compaction aside */
+PUBLIC uint32 HOST_u32PdmSaves ( void )
+{
+    return u32HostPdmSaves;
+}
+
+/* Compactions since PDM_eInitialise and the flash time they took */
+PUBLIC uint32 HOST_u32PdmCompactions ( void )
+{
+    return u32HostPdmCompactions;
+}
+
+PUBLIC uint32 HOST_u32PdmCompactionUs ( void )
+{
+    return u32HostPdmCompactionUs;
+}
+
+PUBLIC uint32 HOST_u32PdmCompactionMaxUs ( void )
+{
+    return u32HostPdmCompactionMaxUs;
+}
+
+/* Record data bytes read since PDM_eInitialise */
+PUBLIC uint32 HOST_u32PdmReadBytes ( void )
+{
+    return u32HostPdmReadBytes;
+}
+
+/* Flash bytes saves wrote since PDM_eInitialise, record headers and padding
+ * included, compaction copies aside */
+PUBLIC uint32 HOST_u32PdmWriteBytes ( void )
+{
+    return u32HostPdmWriteBytes;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,219 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          host_pdum.c
+ *
+ * DESCRIPTION:        PDU manager for host builds: the apduZDP pool with the
+ *                     firmware's instance count and size, laid out like the
+ *                     pool PDUMConfig generates so that u8GetApduUsed counts
+ *                     it the same way, a high-water mark of the pool kept
+ *                     by the allocator itself, and an NPDU use count kept
+ *                     by the APS data service
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stdarg.h>
+#include <string.h>
+#include "pdum_apl.h"
+#include "pdum_nwk.h"
+#include "pdum_gen.h"
+#include "zps_apl_af.h"
+#include "zps_struct.h"
+#include "host_sim.h"
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+PUBLIC uint8    u8HostNpduUse;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE uint8    au8ApduZdpStorage[HOST_APDU_ZDP_INSTANCES][HOST_APDU_ZDP_SIZE];
+PRIVATE pdum_tsAPduInstance    asApduZdpInstances[HOST_APDU_ZDP_INSTANCES];
+PRIVATE uint8    u8HostApduPeak;
+
+PUBLIC const struct pdum_tsAPdu_tag pdum_apduZDP =
+{
+    asApduZdpInstances,
+    0,
+    HOST_APDU_ZDP_SIZE,
+    HOST_APDU_ZDP_INSTANCES
+};
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+PUBLIC void PDUM_vInit ( void )
+{
+    uint8    i;
+
+    for ( i = 0; i < HOST_APDU_ZDP_INSTANCES; i++ )
+    {
+        asApduZdpInstances[i].au8Storage            =  au8ApduZdpStorage[i];
+        asApduZdpInstances[i].u16Size               =  0;
+        asApduZdpInstances[i].u16NextAPduInstIdx    =  0;
+        asApduZdpInstances[i].u16APduIdx            =  0;
+    }
+    u8HostNpduUse  =  0;
+    u8HostApduPeak =  0;
+}
+
+PUBLIC PDUM_thAPduInstance PDUM_hAPduAllocateAPduInstance ( PDUM_thAPdu    hAPdu )
+{
+    uint16    i;
+
+    for ( i = 0; i < hAPdu->u16NumInstances; i++ )
+    {
+        if ( hAPdu->psAPduInstances[i].u16NextAPduInstIdx != PDUM_ALLOC_IDX )
+        {
+            hAPdu->psAPduInstances[i].u16NextAPduInstIdx =  PDUM_ALLOC_IDX;
+            hAPdu->psAPduInstances[i].u16Size            =  0;
+            if ( hAPdu == apduZDP && u8GetApduUsed ( apduZDP ) > u8HostApduPeak )
+            {
+                u8HostApduPeak =  u8GetApduUsed ( apduZDP );
+            }
+            return &hAPdu->psAPduInstances[i];
+        }
+    }
+    return PDUM_INVALID_HANDLE;
+}
+
+PUBLIC PDUM_teStatus PDUM_eAPduFreeAPduInstance ( PDUM_thAPduInstance    hAPduInst )
+{
+    pdum_tsAPduInstance*    psInst = ( pdum_tsAPduInstance* ) hAPduInst;
+
+    if ( psInst == PDUM_INVALID_HANDLE )
+    {
+        return PDUM_E_INVALID_HANDLE;
+    }
+    if ( psInst->u16NextAPduInstIdx != PDUM_ALLOC_IDX )
+    {
+        return PDUM_E_APDU_INSTANCE_ALREADY_FREE;
+    }
+    psInst->u16NextAPduInstIdx =  0;
+    return PDUM_E_OK;
+}
+
+PUBLIC void* PDUM_pvAPduInstanceGetPayload ( PDUM_thAPduInstance    hAPduInst )
+{
+    return hAPduInst->au8Storage;
+}
+
+PUBLIC uint16 PDUM_u16APduInstanceGetPayloadSize ( PDUM_thAPduInstance    hAPduInst )
+{
+    return hAPduInst->u16Size;
+}
+
+PUBLIC PDUM_teStatus PDUM_eAPduInstanceSetPayloadSize ( PDUM_thAPduInstance    hAPduInst,
+                                                        uint16                 u16Size )
+{
+    if ( u16Size > HOST_APDU_ZDP_SIZE )
+    {
+        return PDUM_E_APDU_INSTANCE_TOO_BIG;
+    }
+    ( ( pdum_tsAPduInstance* ) hAPduInst )->u16Size =  u16Size;
+    return PDUM_E_OK;
+}
+
+PUBLIC PDUM_thAPdu PDUM_thAPduInstanceGetApdu ( PDUM_thAPduInstance    hAPduInst )
+{
+    return &pdum_apduZDP;
+}
+
+PUBLIC uint16 PDUM_u16APduGetSize ( PDUM_thAPdu    hAPdu )
+{
+    return hAPdu->u16Size;
+}
+
+/* Writes b, h, w and l fields in network (big endian) byte order */
+PUBLIC uint16 PDUM_u16APduInstanceWriteNBO ( PDUM_thAPduInstance    hAPduInst,
+                                             uint16                 u16Pos,
+                                             const char*            szFormat,
+                                             ... )
+{
+    pdum_tsAPduInstance*    psInst = ( pdum_tsAPduInstance* ) hAPduInst;
+    uint8*                  pu8Out = &psInst->au8Storage[u16Pos];
+    uint16                  u16Written = 0;
+    uint64                  u64Value;
+    uint8                   u8Size;
+    va_list                 ap;
+
+    va_start ( ap, szFormat );
+    for ( ; *szFormat != '\0'; szFormat++ )
+    {
+        switch ( *szFormat )
+        {
+            case 'b': u8Size = 1; u64Value = ( uint8 ) va_arg ( ap, unsigned int ); break;
+            case 'h': u8Size = 2; u64Value = ( uint16 ) va_arg ( ap, unsigned int ); break;
+            case 'w': u8Size = 4; u64Value = va_arg ( ap, uint32 ); break;
+            case 'l': u8Size = 8; u64Value = va_arg ( ap, uint64 ); break;
+            default:  u8Size = 0; u64Value = 0; break;
+        }
+        while ( u8Size-- > 0 )
+        {
+            pu8Out[u16Written++] = ( uint8 ) ( u64Value >> ( 8 * u8Size ) );
+        }
+    }
+    va_end ( ap );
+
+    if ( u16Pos + u16Written > psInst->u16Size )
+    {
+        psInst->u16Size =  u16Pos + u16Written;
+    }
+    return u16Written;
+}
+
+PUBLIC uint8 PDUM_u8GetNpduUse ( void )
+{
+    return u8HostNpduUse;
+}
+
+PUBLIC uint8 HOST_u8ApduFree ( void )
+{
+    return HOST_APDU_ZDP_INSTANCES - u8GetApduUsed ( apduZDP );
+}
+
+/* Most apduZDP instances held at once since the last call; the mark restarts
+ * from the current use so that each caller's interval is measured on its own */
+PUBLIC uint8 HOST_u8ApduPeak ( void )
+{
+    uint8    u8Peak =  u8HostApduPeak;
+
+    u8HostApduPeak =  u8GetApduUsed ( apduZDP );
+    return u8Peak;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,623 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          host_platform.c
+ *
+ * DESCRIPTION:        Platform services for host builds: a simulated
+ *                     millisecond clock, the UART, the framework memory,
+ *                     OS and power calls, and inert stand-ins for the
+ *                     OTA, security and radio drivers. Host commands
+ *                     are released to the firmware at the baud rate; frames
+ *                     the firmware writes are decoded and kept for tests.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <malloc.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dbg.h"
+#include "fsl_os_abstraction.h"
+#include "MemManager.h"
+#include "Messaging.h"
+#include "FunctionLib.h"
+#include "pwrm.h"
+#include "RNG_Interface.h"
+#include "TimersManager.h"
+#include "fsl_flash.h"
+#include "fsl_aes.h"
+#include "fsl_reset.h"
+#include "clock_config.h"
+#include "SecLib.h"
+#include "OtaSupport.h"
+#include "AppApi.h"
+#include "bdb_api.h"
+#include "bdb_DeviceCommissioning.h"
+#include "app_uart.h"
+#include "SerialLink.h"
+#include "host_sim.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Ten bit times per byte, counted in thousandths of a byte per ms */
+#define HOST_UART_MILLIBYTES_PER_MS    ( UART_BAUD_RATE / 10 )
+
+#define HOST_STRING( x )               HOST_STRING_( x )
+#define HOST_STRING_( x )              #x
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+    E_HOST_TX_IDLE,
+    E_HOST_TX_HEADER,
+    E_HOST_TX_PAYLOAD
+} teHostTxState;
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+PUBLIC tsBDB     sBDB;
+PUBLIC uint32    u32HostResets;
+
+/* Linker script symbols */
+PUBLIC uint32    _flash_start;
+PUBLIC uint8     _FlsOtaHeader[256] __attribute__ ( ( aligned ( 4 ) ) );
+PUBLIC uint8     _FlsLinkKey[16] __attribute__ ( ( aligned ( 4 ) ) );
+PUBLIC uint8     FlsZcCert[48] __attribute__ ( ( aligned ( 4 ) ) );
+
+/* Core clock and the registers fsl_common.h redirects to the host */
+PUBLIC uint32_t          SystemCoreClock =  BOARD_BOOTCLOCKRUN_CORE_CLOCK;
+PUBLIC DWT_Type          HOST_sDwt;
+PUBLIC CoreDebug_Type    HOST_sCoreDebug;
+
+/* The stack the watermark measures; __StackLimit and _vStackTop bound it */
+PUBLIC uint32    au32HostStack[HOST_STACK_WORDS] __attribute__ ( ( aligned ( 16 ) ) );
+__asm__ ( ".globl __StackLimit\n"
+          ".set __StackLimit, au32HostStack\n"
+          ".globl _vStackTop\n"
+          ".set _vStackTop, au32HostStack + 4 * " HOST_STRING ( HOST_STACK_WORDS ) "\n" );
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE uint32               u32HostTimeMs;
+PRIVATE uint32               u32HostRand =  0x12345678;
+PRIVATE uint32               au32HostPlme[16];
+
+/* Host to firmware */
+PRIVATE uint8                au8HostRx[HOST_SERIAL_RX_SIZE];
+PRIVATE uint32               u32HostRxHead;
+PRIVATE uint32               u32HostRxTail;
+PRIVATE uint32               u32HostRxCredit;
+
+/* Firmware to host */
+PRIVATE tsHostSerialFrame    asHostTxFrames[HOST_SERIAL_TX_FRAMES];
+PRIVATE uint32               u32HostTxHead;
+PRIVATE uint32               u32HostTxTail;
+PRIVATE teHostTxState        eHostTxState =  E_HOST_TX_IDLE;
+PRIVATE bool_t               bHostTxEscape;
+PRIVATE uint8                au8HostTxHeader[5];
+PRIVATE uint16               u16HostTxCount;
+PRIVATE tsHostSerialFrame    sHostTxFrame;
+PRIVATE uint8                au8HostTxRaw[HOST_SERIAL_TX_RAW_SIZE];
+PRIVATE uint32               u32HostTxRaw;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE void HOST_vRxPut ( bool_t    bSpecialCharacter,
+                           uint8     u8Data )
+{
+    if ( !bSpecialCharacter && ( u8Data < 0x10 ) )
+    {
+        au8HostRx[u32HostRxHead++ % HOST_SERIAL_RX_SIZE] =  SL_ESC_CHAR;
+        u8Data ^= 0x10;
+    }
+    au8HostRx[u32HostRxHead++ % HOST_SERIAL_RX_SIZE] =  u8Data;
+}
+
+PRIVATE void HOST_vTxFrameDone ( void )
+{
+    uint16    u16Stored;
+
+    sHostTxFrame.u32TimeMs =  u32HostTimeMs;
+    u16Stored =  ( sHostTxFrame.u16Length < HOST_SERIAL_MAX_PAYLOAD ) ? sHostTxFrame.u16Length : HOST_SERIAL_MAX_PAYLOAD;
+    sHostTxFrame.bCrcOk =  ( u16HostTxCount == sHostTxFrame.u16Length ) &&
+                           ( u16Stored == sHostTxFrame.u16Length ) &&
+                           ( u8SL_CalculateCRC ( sHostTxFrame.u16Type,
+                                                 sHostTxFrame.u16Length,
+                                                 sHostTxFrame.au8Payload ) == au8HostTxHeader[4] );
+    if ( u32HostTxHead - u32HostTxTail < HOST_SERIAL_TX_FRAMES )
+    {
+        asHostTxFrames[u32HostTxHead++ % HOST_SERIAL_TX_FRAMES] =  sHostTxFrame;
+    }
+}
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+PUBLIC void HOST_vAdvanceTime ( uint32    u32Ms )
+{
+    u32HostTimeMs +=  u32Ms;
+    /* The line is idle when nothing is queued, no credit builds up */
+    if ( u32HostRxTail == u32HostRxHead )
+    {
+        u32HostRxCredit =  0;
+    }
+    else
+    {
+        u32HostRxCredit += u32Ms * HOST_UART_MILLIBYTES_PER_MS;
+    }
+}
+
+PUBLIC uint32 HOST_u32TimeMs ( void )
+{
+    return u32HostTimeMs;
+}
+
+/* CYCCNT counts host time at the core clock, wrapping as the target's does */
+PUBLIC DWT_Type* HOST_psDwt ( void )
+{
+    struct timespec    sNow;
+
+    if ( ( HOST_sCoreDebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk ) &&
+         ( HOST_sDwt.CTRL & DWT_CTRL_CYCCNTENA_Msk ) )
+    {
+        clock_gettime ( CLOCK_MONOTONIC, &sNow );
+        HOST_sDwt.CYCCNT =  ( uint32 ) ( ( uint64 ) sNow.tv_sec * SystemCoreClock +
+                                         ( uint64 ) sNow.tv_nsec * SystemCoreClock / 1000000000ULL );
+    }
+    return &HOST_sDwt;
+}
+
+/* Queues a host command, framed and escaped as the host library sends it */
+PUBLIC void HOST_vSerialWrite ( uint16          u16Type,
+                                uint16          u16Length,
+                                const uint8*    pu8Payload )
+{
+    uint16    n;
+
+    HOST_vRxPut ( TRUE,  SL_START_CHAR );
+    HOST_vRxPut ( FALSE, ( uint8 ) ( u16Type >> 8 ) );
+    HOST_vRxPut ( FALSE, ( uint8 ) u16Type );
+    HOST_vRxPut ( FALSE, ( uint8 ) ( u16Length >> 8 ) );
+    HOST_vRxPut ( FALSE, ( uint8 ) u16Length );
+    HOST_vRxPut ( FALSE, u8SL_CalculateCRC ( u16Type, u16Length, ( uint8* ) pu8Payload ) );
+    for ( n = 0; n < u16Length; n++ )
+    {
+        HOST_vRxPut ( FALSE, pu8Payload[n] );
+    }
+    HOST_vRxPut ( TRUE,  SL_END_CHAR );
+}
+
+PUBLIC uint32 HOST_u32SerialRxPending ( void )
+{
+    return u32HostRxHead - u32HostRxTail;
+}
+
+PUBLIC bool_t HOST_bSerialRead ( tsHostSerialFrame*    psFrame )
+{
+    if ( u32HostTxTail == u32HostTxHead )
+    {
+        return FALSE;
+    }
+    *psFrame =  asHostTxFrames[u32HostTxTail++ % HOST_SERIAL_TX_FRAMES];
+    return TRUE;
+}
+
+/* Reads frames up to and including the first of the given type */
+PUBLIC bool_t HOST_bSerialFind ( uint16                u16Type,
+                                 tsHostSerialFrame*    psFrame )
+{
+    while ( HOST_bSerialRead ( psFrame ) )
+    {
+        if ( psFrame->u16Type == u16Type )
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+PUBLIC void HOST_vSerialFlush ( void )
+{
+    u32HostTxTail =  u32HostTxHead;
+    u32HostTxRaw  =  0;
+}
+
+PUBLIC uint32 HOST_u32SerialTxRaw ( uint8*    pu8Buffer,
+                                    uint32    u32MaxLength )
+{
+    uint32    u32Length =  ( u32HostTxRaw < u32MaxLength ) ? u32HostTxRaw : u32MaxLength;
+
+    memcpy ( pu8Buffer, au8HostTxRaw, u32Length );
+    return u32Length;
+}
+
+/* UART */
+PUBLIC bool_t UART_bBufferReceive ( uint8*    pu8Data )
+{
+    if ( ( u32HostRxTail == u32HostRxHead ) || ( u32HostRxCredit < 1000 ) )
+    {
+        return FALSE;
+    }
+    u32HostRxCredit -= 1000;
+    *pu8Data =  au8HostRx[u32HostRxTail++ % HOST_SERIAL_RX_SIZE];
+    return TRUE;
+}
+
+PUBLIC bool_t UART_bTxReady ( void )
+{
+    return TRUE;
+}
+
+PUBLIC void UART_vTxChar ( uint8    u8Char )
+{
+    if ( u32HostTxRaw < HOST_SERIAL_TX_RAW_SIZE )
+    {
+        au8HostTxRaw[u32HostTxRaw++] =  u8Char;
+    }
+
+    if ( u8Char == SL_START_CHAR )
+    {
+        eHostTxState   =  E_HOST_TX_HEADER;
+        bHostTxEscape  =  FALSE;
+        u16HostTxCount =  0;
+        return;
+    }
+    if ( u8Char == SL_END_CHAR )
+    {
+        if ( eHostTxState != E_HOST_TX_IDLE )
+        {
+            HOST_vTxFrameDone ( );
+        }
+        eHostTxState =  E_HOST_TX_IDLE;
+        return;
+    }
+    if ( u8Char == SL_ESC_CHAR )
+    {
+        bHostTxEscape =  TRUE;
+        return;
+    }
+    if ( bHostTxEscape )
+    {
+        u8Char ^= 0x10;
+        bHostTxEscape =  FALSE;
+    }
+
+    switch ( eHostTxState )
+    {
+        case E_HOST_TX_HEADER:
+            au8HostTxHeader[u16HostTxCount++] =  u8Char;
+            if ( u16HostTxCount == sizeof ( au8HostTxHeader ) )
+            {
+                sHostTxFrame.u16Type   =  ( au8HostTxHeader[0] << 8 ) | au8HostTxHeader[1];
+                sHostTxFrame.u16Length =  ( au8HostTxHeader[2] << 8 ) | au8HostTxHeader[3];
+                u16HostTxCount =  0;
+                eHostTxState   =  E_HOST_TX_PAYLOAD;
+            }
+        break;
+
+        case E_HOST_TX_PAYLOAD:
+            if ( u16HostTxCount < HOST_SERIAL_MAX_PAYLOAD )
+            {
+                sHostTxFrame.au8Payload[u16HostTxCount] =  u8Char;
+            }
+            u16HostTxCount++;
+        break;
+
+        default:
+        break;
+    }
+}
+
+/* Clock and timers */
+PUBLIC void OSA_TimeInit ( void )
+{
+}
+
+PUBLIC uint32_t OSA_TimeGetMsec ( void )
+{
+    return u32HostTimeMs;
+}
+
+/* Flash busy time counts here but not on the millisecond clock, so that
+ * code timing itself sees what the flash costs without timers moving */
+PUBLIC uint64_t TMR_GetTimestamp ( void )
+{
+    return ( ( uint64_t ) u32HostTimeMs * 1000 ) + HOST_u32FlashBusyUs ( );
+}
+
+/* OS abstraction, memory and power */
+PUBLIC void OSA_InterruptDisable ( void )
+{
+}
+
+PUBLIC void OSA_InterruptEnable ( void )
+{
+}
+
+PUBLIC void OSA_InterruptEnableRestricted ( uint32_t*    pu32OldIntLevel )
+{
+    *pu32OldIntLevel =  0;
+}
+
+PUBLIC void OSA_InterruptEnableRestore ( uint32_t*    pu32OldIntLevel )
+{
+}
+
+/* Buffers carry a list header in front, as pool blocks do: the messaging
+ * queues link a message through the header before it */
+PUBLIC void* MEM_BufferAllocWithId ( uint32_t    numBytes,
+                                     uint8_t     poolId,
+                                     void*       pCaller )
+{
+    listHeader_t*    psHeader =  malloc ( sizeof ( listHeader_t ) + numBytes );
+
+    if ( psHeader == NULL )
+    {
+        return NULL;
+    }
+    psHeader->pParentPool =  NULL;
+    return psHeader + 1;
+}
+
+PUBLIC memStatus_t MEM_BufferFree ( void*    buffer )
+{
+    if ( buffer != NULL )
+    {
+        free ( ( listHeader_t* ) buffer - 1 );
+    }
+    return MEM_SUCCESS_c;
+}
+
+PUBLIC uint16_t MEM_BufferGetSize ( void*    buffer )
+{
+    return ( uint16_t ) ( malloc_usable_size ( ( listHeader_t* ) buffer - 1 ) - sizeof ( listHeader_t ) );
+}
+
+PUBLIC void FLib_MemCpy ( void*          pDst,
+                          const void*    pSrc,
+                          uint32_t       cBytes )
+{
+    memmove ( pDst, pSrc, cBytes );
+}
+
+PUBLIC PWRM_teStatus PWRM_eStartActivity ( void )
+{
+    return PWRM_E_OK;
+}
+
+PUBLIC PWRM_teStatus PWRM_eFinishActivity ( void )
+{
+    return PWRM_E_OK;
+}
+
+PUBLIC uint32_t RND_u32GetRand ( uint32_t    u32Min,
+                                 uint32_t    u32Max )
+{
+    u32HostRand =  u32HostRand * 1103515245 + 12345;
+    if ( u32Max <= u32Min )
+    {
+        return u32Min;
+    }
+    return u32Min + ( ( u32HostRand >> 8 ) % ( u32Max - u32Min ) );
+}
+
+PUBLIC void RESET_SystemReset ( void )
+{
+    u32HostResets++;
+}
+
+/* Debug output is dropped, the tests read the serial frames instead */
+PUBLIC int DbgConsole_Printf ( const char*    fmt_s,
+                               ... )
+{
+    return 0;
+}
+
+PUBLIC void DBG_vInit ( tsDBG_FunctionTbl*    psFunctionTbl )
+{
+}
+
+/* OTA: the client side keeps nothing */
+PUBLIC otaResult_t OTA_ClientInit ( void )
+{
+    return gOtaSuccess_c;
+}
+
+PUBLIC otaResult_t OTA_PushImageChunkBlocking ( uint8_t*     pData,
+                                                uint16_t     length,
+                                                uint32_t*    pImageOffset,
+                                                uint32_t*    pImageLength )
+{
+    return gOtaSuccess_c;
+}
+
+PUBLIC otaResult_t OTA_PullImageChunk ( uint8_t*     pData,
+                                        uint16_t     length,
+                                        uint32_t*    pImageOffset )
+{
+    memset ( pData, 0xff, length );
+    return gOtaSuccess_c;
+}
+
+PUBLIC otaResult_t OTA_CommitImage ( uint8_t*    pBitmap )
+{
+    return gOtaSuccess_c;
+}
+
+PUBLIC void OTA_SetNewImageFlag ( void )
+{
+}
+
+PUBLIC void OTA_CancelImage ( void )
+{
+}
+
+PUBLIC otaImageAuthResult_t OTA_ImageAuthenticate ( void )
+{
+    return gOtaImageAuthPass_c;
+}
+
+/* Security: the stand-ins keep the data flowing but do not encrypt */
+PUBLIC void SHA256_Init ( void*    pContext )
+{
+}
+
+PUBLIC void SHA256_HashUpdate ( void*             pContext,
+                                const uint8_t*    pData,
+                                uint32_t          numBytes )
+{
+}
+
+PUBLIC void SHA256_HashFinish ( void*       pContext,
+                                uint8_t*    pOutput )
+{
+    memset ( pOutput, 0, 32 );
+}
+
+PUBLIC void* SHA256_AllocCtx ( void )
+{
+    return malloc ( 128 );
+}
+
+PUBLIC void SHA256_FreeCtx ( void*    pContext )
+{
+    free ( pContext );
+}
+
+PUBLIC status_t AES_SetKey ( AES_Type*         base,
+                             const uint8_t*    key,
+                             size_t            keySize )
+{
+    return kStatus_Success;
+}
+
+PUBLIC status_t AES_EncryptEcb ( AES_Type*         base,
+                                 const uint8_t*    plaintext,
+                                 uint8_t*          ciphertext,
+                                 size_t            size )
+{
+    memmove ( ciphertext, plaintext, size );
+    return kStatus_Success;
+}
+
+PUBLIC void AESSW_vMMOBlockUpdate ( AESSW_Block_u*    puHash,
+                                    AESSW_Block_u*    puBlock )
+{
+}
+
+PUBLIC void AESSW_vMMOFinalUpdate ( AESSW_Block_u*    puHash,
+                                    uint8_t*          pu8Data,
+                                    int               iDataLen,
+                                    int               iFinalLen )
+{
+}
+
+PUBLIC void vACI_OptimisedCcmStar ( bool_t          bEncrypt,
+                                    uint8_t         u8M,
+                                    uint8_t         u8alength,
+                                    uint8_t         u8mlength,
+                                    tuAES_Block*    puNonce,
+                                    uint8_t*        pu8aData,
+                                    uint8_t*        pu8mData,
+                                    uint8_t*        pu8ChecksumData,
+                                    bool_t*         pbChecksumVerify )
+{
+    if ( pbChecksumVerify != NULL )
+    {
+        *pbChecksumVerify =  TRUE;
+    }
+}
+
+PUBLIC bool_t bACI_WriteKey ( tsReg128*    psKeyData )
+{
+    return TRUE;
+}
+
+PUBLIC void vSwipeEndian ( AESSW_Block_u*    puBlock,
+                           tsReg128*         psReg,
+                           bool_t            bBlockToReg )
+{
+    if ( bBlockToReg )
+    {
+        memcpy ( psReg, puBlock, sizeof ( tsReg128 ) );
+    }
+    else
+    {
+        memcpy ( puBlock, psReg, sizeof ( tsReg128 ) );
+    }
+}
+
+/* Radio */
+PUBLIC PHY_Enum_e eAppApiPlmeGet ( PHY_PibAttr_e    ePhyPibAttribute,
+                                   uint32*          pu32PhyPibValue )
+{
+    *pu32PhyPibValue =  au32HostPlme[ePhyPibAttribute % 16];
+    return PHY_ENUM_SUCCESS;
+}
+
+PUBLIC PHY_Enum_e eAppApiPlmeSet ( PHY_PibAttr_e    ePhyPibAttribute,
+                                   uint32           u32PhyPibValue )
+{
+    au32HostPlme[ePhyPibAttribute % 16] =  u32PhyPibValue;
+    return PHY_ENUM_SUCCESS;
+}
+
+/* Base device behaviour */
+PUBLIC void BDB_vZclEventHandler ( tsBDB_ZCLEvent*    psEvent )
+{
+}
+
+PUBLIC BDB_teStatus BDB_eNfStartNwkFormation ( void )
+{
+    return BDB_E_SUCCESS;
+}
+
+PUBLIC BDB_teStatus BDB_eOutOfBandCommissionGetDataEncrypted ( BDB_tsOobWriteDataToAuthenticate*    psSrcCredentials,
+                                                               uint8*                               pu8ReturnAuthData,
+                                                               uint16*                              pu16ReturnAuthDataLen )
+{
+    *pu16ReturnAuthDataLen =  0;
+    return BDB_E_FAILURE;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
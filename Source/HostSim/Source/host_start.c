@@ -0,0 +1,282 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          host_start.c
+ *
+ * DESCRIPTION:        Start up and main loop of the host build. Follows
+ *                     app_start.c: the same initialisation order, the same
+ *                     tasks on each pass of the loop and the same 100ms tick,
+ *                     less the hardware set up. The node comes up as a
+ *                     coordinator already running on its network.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "pdum_apl.h"
+#include "pdum_gen.h"
+#include "PDM.h"
+#include "PDM_IDs.h"
+#include "dbg.h"
+#include "zps_gen.h"
+#include "zps_apl_af.h"
+#include "ZTimer.h"
+#include "zQueue.h"
+#include "bdb_api.h"
+#include "SerialLink.h"
+#include "app_Znc_cmds.h"
+#include "app_common.h"
+#include "app_events.h"
+#include "zcl_common.h"
+#include "app_zcl_event_handler.h"
+#include "app_aps_queue.h"
+#include "app_child_queue.h"
+#include "app_report_filter.h"
+#include "app_attribute_cache.h"
+#include "app_device_interview.h"
+#include "app_device_snapshot.h"
+#include "app_pdm_telemetry.h"
+#include "app_ota_fleet.h"
+#include "app_channel_quality.h"
+#include "app_stack_watermark.h"
+#include "host_sim.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define HOST_NUM_TMRS                   4
+#define HOST_BDB_QUEUE_SIZE             2
+#define HOST_APP_QUEUE_SIZE             8
+
+/* Passes of the main loop run for each simulated millisecond; each pass
+ * takes one received byte, so this has to keep up with the UART */
+#define HOST_PASSES_PER_MS              16
+
+/* Attribute control bytes handed to clusters created without any */
+#define HOST_SPARE_CONTROL_BITS         64
+
+/****************************************************************************/
+/***        Local Function Prototypes                                     ***/
+/****************************************************************************/
+PRIVATE void HOST_cbTimerZclTick ( void*    pvParam );
+PRIVATE void HOST_cbToggleLED ( void*    pvParam );
+PRIVATE bool_t HOST_bProfileWideCommandSupportedForCluster ( uint16    u16ClusterId );
+PRIVATE bool_t HOST_bManufacturerCodeSupported ( uint16    u16ManufacturerCode );
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+/* Shared with the application as app_start.c defines them */
+PUBLIC tszQueue          APP_msgBdbEvents;
+PUBLIC tszQueue          APP_msgAppEvents;
+PUBLIC tsZllState        sZllState;
+PUBLIC tsLedState        s_sLedState;
+PUBLIC bool_t            bLedActivate;
+PUBLIC uint8_t           bPowerCEFCC;
+PUBLIC bool_t            bCtrlFlow;
+PUBLIC uint8             u8IdTimer;
+PUBLIC uint8             u8TmrToggleLED;
+PUBLIC uint8             u8HaModeTimer;
+PUBLIC uint8             u8TickTimer;
+PUBLIC uint8             u8JoinedDevice;
+PUBLIC uint8             au8LinkRxBuffer[270];
+PUBLIC ZTIMER_tsTimer    asTimers[HOST_NUM_TMRS + BDB_ZTIMER_STORAGE];
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE uint8            au8HostSpareControlBits[HOST_SPARE_CONTROL_BITS];
+PRIVATE uint16           u16HostSpareControlBitsUsed;
+PRIVATE tsZCL_EndPointDefinition    sHostUnregisteredEndPoint;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+PUBLIC void HOST_vInit ( void )
+{
+    memset ( &sZllState, 0, sizeof ( sZllState ) );
+    sZllState.eNodeState   =  E_RUNNING;
+    sZllState.u8DeviceType =  0;
+    sZllState.u8MyChannel  =  11;
+
+    ZTIMER_eInit ( asTimers, sizeof ( asTimers ) / sizeof ( ZTIMER_tsTimer ) );
+    ZTIMER_eOpen ( &u8TickTimer,    HOST_cbTimerZclTick,         NULL,                      ZTIMER_FLAG_PREVENT_SLEEP );
+    ZTIMER_eOpen ( &u8IdTimer,      APP_vIdentifyEffectEnd,      NULL,                      ZTIMER_FLAG_PREVENT_SLEEP );
+    ZTIMER_eOpen ( &u8TmrToggleLED, HOST_cbToggleLED,            &s_sLedState,              ZTIMER_FLAG_PREVENT_SLEEP );
+    ZTIMER_eOpen ( &u8HaModeTimer,  App_TransportKeyCallback,    &u64CallbackMacAddress,    ZTIMER_FLAG_PREVENT_SLEEP );
+    ZQ_vQueueCreate ( &APP_msgBdbEvents, HOST_BDB_QUEUE_SIZE, sizeof ( BDB_tsZpsAfEvent ), NULL );
+    ZQ_vQueueCreate ( &APP_msgAppEvents, HOST_APP_QUEUE_SIZE, sizeof ( APP_tsEvent ),      NULL );
+    vZCL_RegisterHandleGeneralCmdCallBack ( HOST_bProfileWideCommandSupportedForCluster );
+    vZCL_RegisterCheckForManufCodeCallBack ( HOST_bManufacturerCodeSupported );
+
+    HOST_vFlashInit ( );
+    PDM_eInitialise ( PDM_START_SEGMENT, PDM_NUM_SEGMENTS, NULL );
+    PDUM_vInit ( );
+    HOST_vZpsInit ( );
+    APP_vApsQueueInit ( );
+    APP_vChildQueueInit ( );
+    APP_vReportFilterInit ( );
+    APP_vAttributeCacheInit ( );
+    APP_vDeviceInterviewInit ( );
+    APP_vDeviceSnapshotInit ( );
+    APP_vPdmTelemetryInit ( 0 );
+
+    sBDB.sAttrib.bbdbNodeIsOnANetwork =  TRUE;
+    u16HostSpareControlBitsUsed       =  0;
+    APP_ZCL_vInitialise ( );
+
+    ZTIMER_eStart ( u8TickTimer, ZCL_TICK_TIME );
+    HOST_vSerialFlush ( );
+}
+
+/* One pass of the main loop, without the stack and BDB tasks */
+PUBLIC void HOST_vStep ( void )
+{
+    APP_vHandleAppEvents ( );
+    APP_vProcessRxData ( );
+    APP_vChildQueueService ( );
+    APP_vApsQueueService ( );
+    ZTIMER_vTask ( );
+}
+
+PUBLIC void HOST_vRun ( uint32    u32Ms )
+{
+    uint8    i;
+
+    while ( u32Ms-- > 0 )
+    {
+        for ( i = 0; i < HOST_PASSES_PER_MS; i++ )
+        {
+            HOST_vStep ( );
+        }
+        HOST_vAdvanceTime ( 1 );
+    }
+}
+
+/* The Livolo endpoint is registered with only the Basic cluster created and
+ * the integrity check reads the other cluster definitions through NULL before
+ * rejecting them. That reads flash on the target but faults here; the result
+ * is the same rejection, the ZLO endpoint registered next shares the device. */
+PUBLIC teZCL_Status __wrap_eZLO_RegisterControlBridgeEndPointLivolo ( uint8                         u8EndPointIdentifier,
+                                                                      tfpZCL_ZCLCallBackFunction    cbCallBack,
+                                                                      tsZLO_ControlBridgeDevice*    psDeviceInfo )
+{
+    return E_ZCL_ERR_CLUSTER_NULL;
+}
+
+/* The OTA server and metering client are created with no attribute control
+ * bits, and the endpoint search reads the definitions of records not yet
+ * registered. Both go through NULL into the boot ROM on the target but fault
+ * here, so such instances get their own bytes and empty records point at the
+ * reserved endpoint 0, which matches nothing, before eZCL_Register runs. */
+extern teZCL_Status __real_eZCL_Register ( tsZCL_EndPointDefinition*    psEndPointDefinition );
+PUBLIC teZCL_Status __wrap_eZCL_Register ( tsZCL_EndPointDefinition*    psEndPointDefinition )
+{
+    tsZCL_ClusterInstance*    psClusterInstance;
+    uint16                    u16Attributes;
+    uint16                    i;
+
+    for ( i = 0; i < psEndPointDefinition->u16NumberOfClusters; i++ )
+    {
+        psClusterInstance =  &psEndPointDefinition->psClusterInstance[i];
+        if ( ( psClusterInstance->pu8AttributeControlBits == NULL ) && ( psClusterInstance->psClusterDefinition != NULL ) )
+        {
+            u16Attributes =  psClusterInstance->psClusterDefinition->u16NumberOfAttributes;
+            if ( ( u16HostSpareControlBitsUsed + u16Attributes ) > HOST_SPARE_CONTROL_BITS )
+            {
+                return E_ZCL_ERR_INSUFFICIENT_SPACE;
+            }
+            psClusterInstance->pu8AttributeControlBits =  &au8HostSpareControlBits[u16HostSpareControlBitsUsed];
+            u16HostSpareControlBitsUsed                +=  u16Attributes;
+        }
+    }
+    for ( i = 0; i < psZCL_Common->u8NumberOfEndpoints; i++ )
+    {
+        if ( psZCL_Common->psZCL_EndPointRecord[i].psEndPointDefinition == NULL )
+        {
+            psZCL_Common->psZCL_EndPointRecord[i].psEndPointDefinition =  &sHostUnregisteredEndPoint;
+        }
+    }
+    return __real_eZCL_Register ( psEndPointDefinition );
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* APP_cbTimerZclTick less the heartbeat and the periodic LQI and routing
+ * requests, which would add traffic the tests do not expect */
+PRIVATE void HOST_cbTimerZclTick ( void*    pvParam )
+{
+    static uint8           u8Tick100Ms =  9;
+    tsZCL_CallBackEvent    sCallBackEvent;
+
+    ZTIMER_eStart ( u8TickTimer, ZTIMER_TIME_MSEC ( 100 ) );
+    eZCL_Update100mS ( );
+
+    APP_vApsQueueTick ( );
+    APP_vChildQueueTick ( );
+    APP_vReportFilterTick ( );
+    APP_vAttributeCacheTick ( );
+    APP_vDeviceInterviewTick ( );
+    APP_vOtaFleetTick ( );
+    APP_vChannelQualityTick ( );
+    APP_vStackWatermarkTick ( );
+
+    u8Tick100Ms++;
+    if ( u8Tick100Ms > 9 )
+    {
+        u8Tick100Ms =  0;
+        sControlBridge.sTimeServerCluster.utctTime++;
+        sCallBackEvent.pZPSevent  =  NULL;
+        sCallBackEvent.eEventType =  E_ZCL_CBET_TIMER;
+        vZCL_EventHandler ( &sCallBackEvent );
+    }
+}
+
+PRIVATE void HOST_cbToggleLED ( void*    pvParam )
+{
+}
+
+PRIVATE bool_t HOST_bProfileWideCommandSupportedForCluster ( uint16    u16ClusterId )
+{
+    return ( u16ClusterId == MEASUREMENT_AND_SENSING_CLUSTER_ID_OCCUPANCY_SENSING );
+}
+
+PRIVATE bool_t HOST_bManufacturerCodeSupported ( uint16    u16ManufacturerCode )
+{
+    return TRUE;
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
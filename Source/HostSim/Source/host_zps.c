@@ -0,0 +1,1267 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          host_zps.c
+ *
+ * DESCRIPTION:        ZigBee PRO stack stand-in for host builds. Data
+ *                     requests are numbered from the APS counter like the
+ *                     stack does, refused once the simultaneous request and
+ *                     APS ack handles of the zpscfg are taken, recorded with
+ *                     their payload and held until a test confirms them.
+ *                     The NIB has the tables of the zpscfg, empty until a
+ *                     test adds devices; ZDO services succeed without
+ *                     effect. ZDP frames indicated by a test are unpacked
+ *                     for the announce and descriptor responses the
+ *                     firmware decodes.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zps_gen.h"
+#include "pdum_apl.h"
+#include "pdum_gen.h"
+#include "zps_apl_af.h"
+#include "zps_apl_aib.h"
+#include "zps_apl_zdo.h"
+#include "zps_apl_zdp.h"
+#include "zps_nwk_pub.h"
+#include "zps_nwk_nib.h"
+#include "zps_nwk_sec.h"
+#include "zps_struct.h"
+#include "bdb_api.h"
+#include "host_sim.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define HOST_SEC_MAT_SETS               2
+#define HOST_COORDINATOR_IEEE_ADDR      0x00158D0000000001ULL
+#define HOST_EXT_PAN_ID                 0x00158D0000000001ULL
+#define HOST_PAN_ID                     0x1A62
+#define HOST_CHANNEL                    15
+
+/* Holds every group zcl_options.h lets the Groups cluster create */
+#define HOST_GROUP_TABLE_SIZE           16
+
+/* Destinations given their own payload limit by HOST_vSetMaxPayload */
+#define HOST_PAYLOAD_LIMITS             8
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+/* A data request the stack holds a handle for until it is confirmed */
+typedef struct
+{
+    bool_t    bUsed;
+    bool_t    bAck;
+    uint32    u32LogIndex;
+} tsHostPending;
+
+/* Payload limit to one destination, as source routes and security shrink it */
+typedef struct
+{
+    bool_t    bUsed;
+    uint16    u16Addr;
+    uint8     u8MaxPayload;
+} tsHostPayloadLimit;
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+extern uint8    u8HostNpduUse;
+
+uint32                 sZpsIntStore;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE zps_tsApl                  sHostApl;
+PRIVATE ZPS_tsNwkNib               sHostNib;
+PRIVATE ZPS_tsAplAib               sHostAib;
+PRIVATE ZPS_tsAplAfNodeDescriptor  sHostNodeDescriptor;
+PRIVATE zps_tsDcfmRecord           sHostDcfmRecord;
+
+PRIVATE ZPS_tsNwkActvNtEntry       asHostNtActv[ZPS_NEIGHBOUR_TABLE_SIZE];
+PRIVATE ZPS_tsNwkRtEntry           asHostRt[ZPS_ROUTING_TABLE_SIZE];
+PRIVATE ZPS_tsNwkSecMaterialSet    asHostSecMatSet[HOST_SEC_MAT_SETS];
+PRIVATE uint16                     au16HostAddrMapNwk[ZPS_ADDRESS_MAP_TABLE_SIZE];
+PRIVATE uint16                     au16HostAddrLookup[ZPS_ADDRESS_MAP_TABLE_SIZE];
+PRIVATE uint64                     au64HostMacTable[ZPS_MAC_ADDRESS_TABLE_SIZE];
+PRIVATE ZPS_tsAplApsmeGroupTableEntry    asHostGroupTableEntries[HOST_GROUP_TABLE_SIZE];
+PRIVATE ZPS_tsAplApsmeAIBGroupTable      sHostGroupTable =  { asHostGroupTableEntries, HOST_GROUP_TABLE_SIZE };
+PRIVATE ZPS_tsAplApsmeBindingTableStoreEntry    asHostBindingEntries[HOST_BINDING_TABLE_MAX];
+PRIVATE ZPS_tsAplApsmeBindingTable       sHostBindingTable =  { asHostBindingEntries, HOST_ZPS_BINDING_TABLE_SIZE };
+PRIVATE ZPS_tsAplApsmeBindingTableType   sHostBindingTableType =  { NULL, &sHostBindingTable };
+
+PRIVATE tsHostDataReq              asHostDataReqs[HOST_DATA_REQ_LOG_SIZE];
+PRIVATE uint32                     u32HostDataReqCount;
+PRIVATE uint32                     u32HostDataReqRefused;
+PRIVATE tsHostPending              asHostPending[HOST_ZPS_MAX_APSDE_REQ];
+PRIVATE tsHostPayloadLimit         asHostPayloadLimits[HOST_PAYLOAD_LIMITS];
+
+PUBLIC void*    g_pvApl =  &sHostApl;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE uint8 HOST_u8Pending ( bool_t    bAckOnly )
+{
+    uint8    u8Count = 0;
+    uint8    i;
+
+    for ( i = 0; i < HOST_ZPS_MAX_APSDE_REQ; i++ )
+    {
+        if ( asHostPending[i].bUsed && ( !bAckOnly || asHostPending[i].bAck ) )
+        {
+            u8Count++;
+        }
+    }
+    return u8Count;
+}
+
+/* Takes a handle, numbers the frame from the APS counter and records it. On
+ * success the APDU belongs to the stack and is released, on failure it stays
+ * with the caller as with the stack libraries. */
+PRIVATE ZPS_teStatus HOST_eDataReq ( PDUM_thAPduInstance    hAPduInst,
+                                     uint8                  u8DstAddrMode,
+                                     uint16                 u16DstAddr,
+                                     uint64                 u64DstAddr,
+                                     uint8                  u8DstEndpoint,
+                                     uint8                  u8SrcEndpoint,
+                                     uint16                 u16ClusterId,
+                                     uint16                 u16ProfileId,
+                                     bool_t                 bAck,
+                                     uint8*                 pu8ApsSeqNum )
+{
+    tsHostDataReq*    psReq;
+    uint16            u16Length;
+    uint8             i;
+
+    if ( HOST_u8Pending ( FALSE ) >= HOST_ZPS_MAX_APSDE_REQ )
+    {
+        u32HostDataReqRefused++;
+        return ZPS_XS_E_NO_FREE_SIM_DATA_REQ;
+    }
+    if ( bAck && ( HOST_u8Pending ( TRUE ) >= HOST_ZPS_MAX_APSDE_ACK_REQ ) )
+    {
+        u32HostDataReqRefused++;
+        return ZPS_XS_E_NO_FREE_APS_ACK;
+    }
+
+    psReq =  &asHostDataReqs[u32HostDataReqCount % HOST_DATA_REQ_LOG_SIZE];
+    memset ( psReq, 0, sizeof ( tsHostDataReq ) );
+    psReq->u32TimeMs       =  HOST_u32TimeMs ( );
+    psReq->u8ApsSeqNum     =  sHostApl.sApsContext.u8SeqNum++;
+    psReq->u8DstAddrMode   =  u8DstAddrMode;
+    psReq->u16DstAddr      =  u16DstAddr;
+    psReq->u64DstAddr      =  u64DstAddr;
+    psReq->u8DstEndpoint   =  u8DstEndpoint;
+    psReq->u8SrcEndpoint   =  u8SrcEndpoint;
+    psReq->u16ClusterId    =  u16ClusterId;
+    psReq->u16ProfileId    =  u16ProfileId;
+    psReq->bAck            =  bAck;
+
+    if ( hAPduInst != PDUM_INVALID_HANDLE )
+    {
+        u16Length =  PDUM_u16APduInstanceGetPayloadSize ( hAPduInst );
+        if ( u16Length > HOST_DATA_REQ_MAX_PAYLOAD )
+        {
+            u16Length =  HOST_DATA_REQ_MAX_PAYLOAD;
+        }
+        memcpy ( psReq->au8Payload, PDUM_pvAPduInstanceGetPayload ( hAPduInst ), u16Length );
+        psReq->u16PayloadLength =  u16Length;
+        PDUM_eAPduFreeAPduInstance ( hAPduInst );
+    }
+
+    for ( i = 0; i < HOST_ZPS_MAX_APSDE_REQ; i++ )
+    {
+        if ( !asHostPending[i].bUsed )
+        {
+            asHostPending[i].bUsed          =  TRUE;
+            asHostPending[i].bAck           =  bAck;
+            asHostPending[i].u32LogIndex    =  u32HostDataReqCount;
+            break;
+        }
+    }
+    u32HostDataReqCount++;
+    u8HostNpduUse++;
+
+    sHostDcfmRecord.u8SeqNum   =  psReq->u8ApsSeqNum;
+    sHostDcfmRecord.u8SrcEp    =  u8SrcEndpoint;
+    sHostDcfmRecord.u8DstEp    =  u8DstEndpoint;
+
+    if ( pu8ApsSeqNum != NULL )
+    {
+        *pu8ApsSeqNum =  psReq->u8ApsSeqNum;
+    }
+    return ZPS_E_SUCCESS;
+}
+
+/* A ZDP request is an APS frame to endpoint 0 carrying its own ZDP sequence
+ * number first */
+PRIVATE ZPS_teStatus HOST_eZdpReq ( PDUM_thAPduInstance    hAPduInst,
+                                    ZPS_tuAddress          uDstAddr,
+                                    bool                   bExtAddr,
+                                    uint16                 u16ClusterId,
+                                    uint8*                 pu8SeqNumber )
+{
+    uint8    u8ZdpSeqNum =  sHostApl.sZdpContext.u8ZdpSeqNum;
+
+    if ( hAPduInst == PDUM_INVALID_HANDLE )
+    {
+        return ZPS_APL_APS_E_INVALID_PARAMETER;
+    }
+    PDUM_u16APduInstanceWriteNBO ( hAPduInst, 0, "b", u8ZdpSeqNum );
+
+    if ( HOST_eDataReq ( hAPduInst,
+                         bExtAddr ? ZPS_E_ADDR_MODE_IEEE : ZPS_E_ADDR_MODE_SHORT,
+                         bExtAddr ? 0 : uDstAddr.u16Addr,
+                         bExtAddr ? uDstAddr.u64Addr : 0,
+                         0,
+                         0,
+                         u16ClusterId,
+                         ZDP_PROFILE_ID,
+                         FALSE,
+                         NULL ) != ZPS_E_SUCCESS )
+    {
+        return ZPS_XS_E_NO_FREE_SIM_DATA_REQ;
+    }
+
+    sHostApl.sZdpContext.u8ZdpSeqNum++;
+    if ( pu8SeqNumber != NULL )
+    {
+        *pu8SeqNumber =  u8ZdpSeqNum;
+    }
+    return ZPS_E_SUCCESS;
+}
+
+PRIVATE void HOST_vDispatch ( uint8             u8Endpoint,
+                              ZPS_tsAfEvent*    psStackEvent )
+{
+    BDB_tsBdbEvent    sBdbEvent;
+
+    memset ( &sBdbEvent, 0, sizeof ( BDB_tsBdbEvent ) );
+    sBdbEvent.eEventType                              =  BDB_EVENT_ZPSAF;
+    sBdbEvent.uEventData.sZpsAfEvent.u8EndPoint       =  u8Endpoint;
+    sBdbEvent.uEventData.sZpsAfEvent.sStackEvent      =  *psStackEvent;
+    APP_vBdbCallback ( &sBdbEvent );
+}
+
+/* ZDP fields are little endian over the air */
+PRIVATE uint16 HOST_u16ZdpRead16 ( const uint8*    pu8Frame,
+                                   uint16*         pu16Pos )
+{
+    uint16    u16Value =  pu8Frame[*pu16Pos] | ( pu8Frame[*pu16Pos + 1] << 8 );
+
+    *pu16Pos +=  2;
+    return u16Value;
+}
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+PUBLIC void HOST_vZpsInit ( void )
+{
+    memset ( &sHostApl, 0, sizeof ( sHostApl ) );
+    memset ( &sHostNib, 0, sizeof ( sHostNib ) );
+    memset ( &sHostAib, 0, sizeof ( sHostAib ) );
+    memset ( asHostNtActv, 0, sizeof ( asHostNtActv ) );
+    memset ( asHostRt, 0, sizeof ( asHostRt ) );
+    memset ( asHostSecMatSet, 0, sizeof ( asHostSecMatSet ) );
+    memset ( au16HostAddrLookup, 0, sizeof ( au16HostAddrLookup ) );
+    memset ( au64HostMacTable, 0, sizeof ( au64HostMacTable ) );
+    memset ( asHostPending, 0, sizeof ( asHostPending ) );
+    memset ( asHostPayloadLimits, 0, sizeof ( asHostPayloadLimits ) );
+    memset ( asHostGroupTableEntries, 0, sizeof ( asHostGroupTableEntries ) );
+    memset ( asHostBindingEntries, 0, sizeof ( asHostBindingEntries ) );
+    memset ( au16HostAddrMapNwk, 0xff, sizeof ( au16HostAddrMapNwk ) );
+
+    sHostNib.sTblSize.u16NtActv             =  ZPS_NEIGHBOUR_TABLE_SIZE;
+    sHostNib.sTblSize.u16Rt                 =  ZPS_ROUTING_TABLE_SIZE;
+    sHostNib.sTblSize.u16AddrMap            =  ZPS_ADDRESS_MAP_TABLE_SIZE;
+    sHostNib.sTblSize.u8SecMatSet           =  HOST_SEC_MAT_SETS;
+    sHostNib.sTblSize.u8ChildTable          =  ZPS_CHILD_TABLE_SIZE;
+    sHostNib.sTblSize.u16MacAddTableSize    =  ZPS_MAC_ADDRESS_TABLE_SIZE;
+    sHostNib.sTbl.psNtActv                  =  asHostNtActv;
+    sHostNib.sTbl.psRt                      =  asHostRt;
+    sHostNib.sTbl.psSecMatSet               =  asHostSecMatSet;
+    sHostNib.sTbl.pu16AddrMapNwk            =  au16HostAddrMapNwk;
+    sHostNib.sTbl.pu16AddrLookup            =  au16HostAddrLookup;
+    sHostNib.sTbl.pu64AddrExtAddrMap        =  au64HostMacTable;
+    sHostNib.sPersist.u64ExtPanId           =  HOST_EXT_PAN_ID;
+    sHostNib.sPersist.u16VsPanId            =  HOST_PAN_ID;
+    sHostNib.sPersist.u8VsChannel           =  HOST_CHANNEL;
+    sHostNib.u16ManagerAddr                 =  0x0000;
+
+    sHostApl.psNib                                   =  &sHostNib;
+    sHostApl.psAib                                   =  &sHostAib;
+    sHostAib.psAplApsmeGroupTable                    =  &sHostGroupTable;
+    sHostAib.psAplApsmeAibBindingTable               =  &sHostBindingTableType;
+    sHostBindingTable.u32SizeOfBindingTable          =  HOST_ZPS_BINDING_TABLE_SIZE;
+    sHostAib.u8ApsMaxWindowSize                      =  HOST_ZPS_APS_WINDOW_SIZE;
+    sHostApl.sAfContext.psNodeDescriptor             =  &sHostNodeDescriptor;
+    sHostApl.sApsContext.sDcfmRecordPool.psDcfmRecords  =  &sHostDcfmRecord;
+    sHostApl.sApsContext.sDcfmRecordPool.u8NumRecords   =  1;
+
+    u32HostDataReqCount      =  0;
+    u32HostDataReqRefused    =  0;
+    u8HostNpduUse            =  0;
+}
+
+PUBLIC ZPS_tsAplApsmeBindingTable* HOST_psBindingTable ( void )
+{
+    return &sHostBindingTable;
+}
+
+/* Grows or shrinks the binding table up to HOST_BINDING_TABLE_MAX entries */
+PUBLIC void HOST_vSetBindingTableSize ( uint32    u32Size )
+{
+    sHostBindingTable.u32SizeOfBindingTable =  ( u32Size < HOST_BINDING_TABLE_MAX ) ? u32Size : HOST_BINDING_TABLE_MAX;
+}
+
+PUBLIC uint32 HOST_u32DataReqCount ( void )
+{
+    return u32HostDataReqCount;
+}
+
+PUBLIC tsHostDataReq* HOST_psDataReq ( uint32    u32Index )
+{
+    if ( ( u32Index >= u32HostDataReqCount ) ||
+         ( ( u32HostDataReqCount - u32Index ) > HOST_DATA_REQ_LOG_SIZE ) )
+    {
+        return NULL;
+    }
+    return &asHostDataReqs[u32Index % HOST_DATA_REQ_LOG_SIZE];
+}
+
+/* The latest request with that APS counter, the counter wraps at 256 */
+PUBLIC tsHostDataReq* HOST_psDataReqBySeq ( uint8    u8ApsSeqNum )
+{
+    uint32    u32Index =  u32HostDataReqCount;
+
+    while ( u32Index-- > 0 )
+    {
+        tsHostDataReq*    psReq =  HOST_psDataReq ( u32Index );
+
+        if ( psReq == NULL )
+        {
+            break;
+        }
+        if ( psReq->u8ApsSeqNum == u8ApsSeqNum )
+        {
+            return psReq;
+        }
+    }
+    return NULL;
+}
+
+PUBLIC uint8 HOST_u8DataReqPending ( void )
+{
+    return HOST_u8Pending ( FALSE );
+}
+
+PUBLIC uint32 HOST_u32DataReqRefused ( void )
+{
+    return u32HostDataReqRefused;
+}
+
+/* Releases the handle of a pending request and passes its confirm to the
+ * application as the stack does */
+PUBLIC bool_t HOST_bDataConfirm ( uint8    u8ApsSeqNum,
+                                  uint8    u8Status )
+{
+    ZPS_tsAfEvent     sStackEvent;
+    tsHostDataReq*    psReq;
+    uint8             i;
+
+    for ( i = 0; i < HOST_ZPS_MAX_APSDE_REQ; i++ )
+    {
+        psReq =  &asHostDataReqs[asHostPending[i].u32LogIndex % HOST_DATA_REQ_LOG_SIZE];
+        if ( asHostPending[i].bUsed && ( psReq->u8ApsSeqNum == u8ApsSeqNum ) )
+        {
+            break;
+        }
+    }
+    if ( i == HOST_ZPS_MAX_APSDE_REQ )
+    {
+        return FALSE;
+    }
+
+    asHostPending[i].bUsed =  FALSE;
+    psReq->bConfirmed      =  TRUE;
+    u8HostNpduUse--;
+
+    memset ( &sStackEvent, 0, sizeof ( sStackEvent ) );
+    sStackEvent.eType                                        =  ZPS_EVENT_APS_DATA_CONFIRM;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8Status         =  u8Status;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8SrcEndpoint    =  psReq->u8SrcEndpoint;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8DstEndpoint    =  psReq->u8DstEndpoint;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8DstAddrMode    =  psReq->u8DstAddrMode;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8SequenceNum    =  psReq->u8ApsSeqNum;
+    if ( psReq->u8DstAddrMode == ZPS_E_ADDR_MODE_IEEE )
+    {
+        sStackEvent.uEvent.sApsDataConfirmEvent.uDstAddr.u64Addr =  psReq->u64DstAddr;
+    }
+    else
+    {
+        sStackEvent.uEvent.sApsDataConfirmEvent.uDstAddr.u16Addr =  psReq->u16DstAddr;
+    }
+    HOST_vDispatch ( psReq->u8SrcEndpoint, &sStackEvent );
+    return TRUE;
+}
+
+/* Confirms the request waiting longest, FALSE when none waits */
+PUBLIC bool_t HOST_bDataConfirmOldest ( uint8    u8Status )
+{
+    uint32    u32Oldest =  0xffffffff;
+    uint8     u8Oldest  =  HOST_ZPS_MAX_APSDE_REQ;
+    uint8     i;
+
+    for ( i = 0; i < HOST_ZPS_MAX_APSDE_REQ; i++ )
+    {
+        if ( asHostPending[i].bUsed && ( asHostPending[i].u32LogIndex < u32Oldest ) )
+        {
+            u32Oldest =  asHostPending[i].u32LogIndex;
+            u8Oldest  =  i;
+        }
+    }
+    if ( u8Oldest == HOST_ZPS_MAX_APSDE_REQ )
+    {
+        return FALSE;
+    }
+    return HOST_bDataConfirm ( asHostDataReqs[u32Oldest % HOST_DATA_REQ_LOG_SIZE].u8ApsSeqNum, u8Status );
+}
+
+/* Delivers a frame from a remote node to one of the local endpoints. The
+ * APDU is released by the ZCL once it has parsed it. */
+PUBLIC void HOST_vDataIndication ( uint16          u16SrcAddr,
+                                   uint8           u8SrcEndpoint,
+                                   uint8           u8DstEndpoint,
+                                   uint16          u16ClusterId,
+                                   uint16          u16ProfileId,
+                                   const uint8*    pu8Payload,
+                                   uint16          u16Length )
+{
+    ZPS_tsAfEvent          sStackEvent;
+    PDUM_thAPduInstance    hAPduInst;
+
+    hAPduInst =  PDUM_hAPduAllocateAPduInstance ( apduZDP );
+    if ( hAPduInst == PDUM_INVALID_HANDLE )
+    {
+        return;
+    }
+    memcpy ( PDUM_pvAPduInstanceGetPayload ( hAPduInst ), pu8Payload, u16Length );
+    PDUM_eAPduInstanceSetPayloadSize ( hAPduInst, u16Length );
+
+    memset ( &sStackEvent, 0, sizeof ( sStackEvent ) );
+    sStackEvent.eType                                        =  ZPS_EVENT_APS_DATA_INDICATION;
+    sStackEvent.uEvent.sApsDataIndEvent.uDstAddress.u16Addr  =  0x0000;
+    sStackEvent.uEvent.sApsDataIndEvent.uSrcAddress.u16Addr  =  u16SrcAddr;
+    sStackEvent.uEvent.sApsDataIndEvent.hAPduInst            =  hAPduInst;
+    sStackEvent.uEvent.sApsDataIndEvent.u32RxTime            =  HOST_u32TimeMs ( );
+    sStackEvent.uEvent.sApsDataIndEvent.u16ProfileId         =  u16ProfileId;
+    sStackEvent.uEvent.sApsDataIndEvent.u16ClusterId         =  u16ClusterId;
+    sStackEvent.uEvent.sApsDataIndEvent.u8DstAddrMode        =  ZPS_E_ADDR_MODE_SHORT;
+    sStackEvent.uEvent.sApsDataIndEvent.u8DstEndpoint        =  u8DstEndpoint;
+    sStackEvent.uEvent.sApsDataIndEvent.u8SrcAddrMode        =  ZPS_E_ADDR_MODE_SHORT;
+    sStackEvent.uEvent.sApsDataIndEvent.u8SrcEndpoint        =  u8SrcEndpoint;
+    sStackEvent.uEvent.sApsDataIndEvent.eStatus              =  ZPS_E_SUCCESS;
+    sStackEvent.uEvent.sApsDataIndEvent.eSecurityStatus      =  ZPS_APL_APS_E_SECURED_NWK_KEY;
+    sStackEvent.uEvent.sApsDataIndEvent.u8LinkQuality        =  200;
+    HOST_vDispatch ( u8DstEndpoint, &sStackEvent );
+}
+
+PUBLIC void HOST_vStackEvent ( uint8             u8Endpoint,
+                               ZPS_tsAfEvent*    psStackEvent )
+{
+    HOST_vDispatch ( u8Endpoint, psStackEvent );
+}
+
+/* Puts a node in the address map and, for neighbours, in the neighbour
+ * table; a sleepy child is an end device neighbour with its receiver off */
+PUBLIC void HOST_vAddDevice ( uint16    u16NwkAddr,
+                              uint64    u64IeeeAddr,
+                              bool_t    bSleepyChild )
+{
+    uint16    i;
+
+    for ( i = 0; i < ZPS_ADDRESS_MAP_TABLE_SIZE; i++ )
+    {
+        if ( ( au16HostAddrMapNwk[i] == 0xffff ) || ( au16HostAddrMapNwk[i] == u16NwkAddr ) )
+        {
+            au16HostAddrMapNwk[i]   =  u16NwkAddr;
+            au16HostAddrLookup[i]   =  i;
+            au64HostMacTable[i]     =  u64IeeeAddr;
+            break;
+        }
+    }
+
+    if ( bSleepyChild )
+    {
+        for ( i = 0; i < ZPS_NEIGHBOUR_TABLE_SIZE; i++ )
+        {
+            if ( !asHostNtActv[i].uAncAttrs.bfBitfields.u1Used )
+            {
+                asHostNtActv[i].u16NwkAddr                             =  u16NwkAddr;
+                asHostNtActv[i].u16Lookup                              =  i;
+                asHostNtActv[i].u8LinkQuality                          =  200;
+                asHostNtActv[i].uAncAttrs.bfBitfields.u1Used           =  1;
+                asHostNtActv[i].uAncAttrs.bfBitfields.u1DeviceType     =  0;
+                asHostNtActv[i].uAncAttrs.bfBitfields.u1RxOnWhenIdle   =  0;
+                asHostNtActv[i].uAncAttrs.bfBitfields.u2Relationship   =  ZPS_NWK_NT_AP_RELATIONSHIP_CHILD;
+                break;
+            }
+        }
+    }
+}
+
+/* Gives one destination a smaller (or larger) unfragmented payload than
+ * HOST_ZPS_MAX_PAYLOAD, as a source route or APS security would */
+PUBLIC void HOST_vSetMaxPayload ( uint16    u16Addr,
+                                  uint8     u8MaxPayload )
+{
+    uint8    i;
+
+    for ( i = 0; i < HOST_PAYLOAD_LIMITS; i++ )
+    {
+        if ( !asHostPayloadLimits[i].bUsed || ( asHostPayloadLimits[i].u16Addr == u16Addr ) )
+        {
+            asHostPayloadLimits[i].bUsed        =  TRUE;
+            asHostPayloadLimits[i].u16Addr      =  u16Addr;
+            asHostPayloadLimits[i].u8MaxPayload =  u8MaxPayload;
+            break;
+        }
+    }
+}
+
+/****************************************************************************/
+/***        Stack handles and NIB access                                  ***/
+/****************************************************************************/
+
+PUBLIC void* ZPS_pvAplZdoGetAplHandle ( void )
+{
+    return &sHostApl;
+}
+
+PUBLIC void* zps_pvAplZdoGetNwkHandle ( void*    pvApl )
+{
+    return &sHostNib;
+}
+
+PUBLIC void* ZPS_pvNwkGetHandle ( void )
+{
+    return &sHostNib;
+}
+
+PUBLIC ZPS_tsNwkNib* ZPS_psNwkNibGetHandle ( void*    pvNwk )
+{
+    return &sHostNib;
+}
+
+PUBLIC ZPS_tsNwkNib* zps_psAplZdoGetNib ( void*    pvApl )
+{
+    return &sHostNib;
+}
+
+PUBLIC ZPS_tsAplAib* zps_psAplAibGetAib ( void*    pvApl )
+{
+    return &sHostAib;
+}
+
+PUBLIC uint64 ZPS_u64NwkNibGetExtAddr ( void*    pvNwk )
+{
+    return HOST_COORDINATOR_IEEE_ADDR;
+}
+
+PUBLIC uint16 ZPS_u16NwkNibGetNwkAddr ( void*    pvNwk )
+{
+    return 0x0000;
+}
+
+PUBLIC uint64 ZPS_u64NwkNibGetMappedIeeeAddr ( void*     pvNwk,
+                                               uint16    u16Location )
+{
+    return ( u16Location < ZPS_MAC_ADDRESS_TABLE_SIZE ) ? au64HostMacTable[u16Location] : 0;
+}
+
+PUBLIC uint64 ZPS_u64NwkNibFindExtAddr ( void*     pvNwk,
+                                         uint16    u16NwkAddr )
+{
+    uint16    i;
+
+    if ( u16NwkAddr == 0x0000 )
+    {
+        return HOST_COORDINATOR_IEEE_ADDR;
+    }
+    for ( i = 0; i < ZPS_ADDRESS_MAP_TABLE_SIZE; i++ )
+    {
+        if ( au16HostAddrMapNwk[i] == u16NwkAddr )
+        {
+            return au64HostMacTable[au16HostAddrLookup[i]];
+        }
+    }
+    return ZPS_NWK_NULL_EXT_ADDR;
+}
+
+PUBLIC uint16 ZPS_u16NwkNibFindNwkAddr ( void*     pvNwk,
+                                         uint64    u64ExtAddr )
+{
+    uint16    i;
+
+    if ( u64ExtAddr == HOST_COORDINATOR_IEEE_ADDR )
+    {
+        return 0x0000;
+    }
+    for ( i = 0; i < ZPS_ADDRESS_MAP_TABLE_SIZE; i++ )
+    {
+        if ( ( au16HostAddrMapNwk[i] != 0xffff ) && ( au64HostMacTable[au16HostAddrLookup[i]] == u64ExtAddr ) )
+        {
+            return au16HostAddrMapNwk[i];
+        }
+    }
+    return ZPS_NWK_INVALID_NWK_ADDR;
+}
+
+PUBLIC uint64 ZPS_u64NwkNibGetEpid ( void*    pvNwk )
+{
+    return sHostNib.sPersist.u64ExtPanId;
+}
+
+PUBLIC uint16 ZPS_u16NwkNibGetMacPanId ( void*    pvNwk )
+{
+    return sHostNib.sPersist.u16VsPanId;
+}
+
+PUBLIC void ZPS_vNwkNibSetChannel ( void*    pvNwk,
+                                    uint8    u8Channel )
+{
+    sHostNib.sPersist.u8VsChannel =  u8Channel;
+}
+
+PUBLIC bool_t ZPS_vNwkGetPermitJoiningStatus ( void*    pvNwk )
+{
+    return FALSE;
+}
+
+PUBLIC void ZPS_vNwkSetDeviceType ( void*                  pvNwk,
+                                    ZPS_teNwkDeviceType    eNwkDeviceType )
+{
+}
+
+PUBLIC uint8 ZPS_u8NwkManagerState ( void )
+{
+    return 0;
+}
+
+PUBLIC void* ZPS_pvNwkSecGetNetworkKey ( void*    pvNwk )
+{
+    return asHostSecMatSet[0].au8Key;
+}
+
+PUBLIC uint64 zps_u64NwkLibFromPayload ( uint8*    pu8Buffer )
+{
+    uint64    u64Value =  0;
+    uint8     i;
+
+    for ( i = 0; i < sizeof ( uint64 ); i++ )
+    {
+        u64Value |=  ( uint64 ) pu8Buffer[i] << ( 8 * i );
+    }
+    return u64Value;
+}
+
+PUBLIC void* zps_vGetZpsMutex ( void )
+{
+    return NULL;
+}
+
+PUBLIC uint8 ZPS_u8GrabMutexLock ( void*      hMutex,
+                                   uint32*    psIntStore )
+{
+    return 0;
+}
+
+PUBLIC uint8 ZPS_u8ReleaseMutexLock ( void*      hMutex,
+                                      uint32*    psIntStore )
+{
+    return 0;
+}
+
+PUBLIC uint8 ZPS_eEnterCriticalSection ( void*      hMutex,
+                                         uint32*    psIntStore )
+{
+    return 0;
+}
+
+PUBLIC uint8 ZPS_eExitCriticalSection ( void*      hMutex,
+                                        uint32*    psIntStore )
+{
+    return 0;
+}
+
+PUBLIC void MAC_vInitBbcTxTries ( uint8    u8Tries )
+{
+}
+
+/****************************************************************************/
+/***        APS data service                                              ***/
+/****************************************************************************/
+
+PUBLIC ZPS_teStatus zps_eAplAfUnicastDataReq ( void*                  pvApl,
+                                               PDUM_thAPduInstance    hAPduInst,
+                                               uint32                 u32ClId_DstEp_SrcEp,
+                                               uint16                 u16DestAddr,
+                                               uint16                 u16SecMd_Radius,
+                                               uint8*                 pu8SeqNum )
+{
+    return HOST_eDataReq ( hAPduInst, ZPS_E_ADDR_MODE_SHORT, u16DestAddr, 0,
+                           ( uint8 ) ( u32ClId_DstEp_SrcEp >> 8 ), ( uint8 ) u32ClId_DstEp_SrcEp,
+                           ( uint16 ) ( u32ClId_DstEp_SrcEp >> 16 ), ZLO_PROFILE_ID, FALSE, pu8SeqNum );
+}
+
+PUBLIC ZPS_teStatus zps_eAplAfUnicastAckDataReq ( void*                  pvApl,
+                                                  PDUM_thAPduInstance    hAPduInst,
+                                                  uint32                 u32ClId_DstEp_SrcEp,
+                                                  uint16                 u16DestAddr,
+                                                  uint16                 u16SecMd_Radius,
+                                                  uint8*                 pu8SeqNum )
+{
+    return HOST_eDataReq ( hAPduInst, ZPS_E_ADDR_MODE_SHORT, u16DestAddr, 0,
+                           ( uint8 ) ( u32ClId_DstEp_SrcEp >> 8 ), ( uint8 ) u32ClId_DstEp_SrcEp,
+                           ( uint16 ) ( u32ClId_DstEp_SrcEp >> 16 ), ZLO_PROFILE_ID, TRUE, pu8SeqNum );
+}
+
+PUBLIC ZPS_teStatus zps_eAplAfUnicastIeeeDataReq ( void*                  pvApl,
+                                                   PDUM_thAPduInstance    hAPduInst,
+                                                   uint32                 u32ClId_DstEp_SrcEp,
+                                                   uint64*                pu64DestAddr,
+                                                   uint16                 u16SecMd_Radius,
+                                                   uint8*                 pu8SeqNum )
+{
+    return HOST_eDataReq ( hAPduInst, ZPS_E_ADDR_MODE_IEEE, 0, *pu64DestAddr,
+                           ( uint8 ) ( u32ClId_DstEp_SrcEp >> 8 ), ( uint8 ) u32ClId_DstEp_SrcEp,
+                           ( uint16 ) ( u32ClId_DstEp_SrcEp >> 16 ), ZLO_PROFILE_ID, FALSE, pu8SeqNum );
+}
+
+PUBLIC ZPS_teStatus zps_eAplAfUnicastIeeeAckDataReq ( void*                  pvApl,
+                                                      PDUM_thAPduInstance    hAPduInst,
+                                                      uint32                 u32ClId_DstEp_SrcEp,
+                                                      uint64*                pu64DestAddr,
+                                                      uint16                 u16SecMd_Radius,
+                                                      uint8*                 pu8SeqNum )
+{
+    return HOST_eDataReq ( hAPduInst, ZPS_E_ADDR_MODE_IEEE, 0, *pu64DestAddr,
+                           ( uint8 ) ( u32ClId_DstEp_SrcEp >> 8 ), ( uint8 ) u32ClId_DstEp_SrcEp,
+                           ( uint16 ) ( u32ClId_DstEp_SrcEp >> 16 ), ZLO_PROFILE_ID, TRUE, pu8SeqNum );
+}
+
+PUBLIC ZPS_teStatus zps_eAplAfGroupDataReq ( void*                  pvApl,
+                                             PDUM_thAPduInstance    hAPduInst,
+                                             uint32                 u32ClId_SrcEp,
+                                             uint16                 u16DstGroupAddr,
+                                             uint16                 u16SecMd_Radius,
+                                             uint8*                 pu8SeqNum )
+{
+    return HOST_eDataReq ( hAPduInst, ZPS_E_ADDR_MODE_GROUP, u16DstGroupAddr, 0,
+                           0, ( uint8 ) u32ClId_SrcEp,
+                           ( uint16 ) ( u32ClId_SrcEp >> 16 ), ZLO_PROFILE_ID, FALSE, pu8SeqNum );
+}
+
+PUBLIC ZPS_teStatus zps_eAplAfBroadcastDataReq ( void*                       pvApl,
+                                                 PDUM_thAPduInstance         hAPduInst,
+                                                 uint32                      u32ClId_DstEp_SrcEp,
+                                                 ZPS_teAplAfBroadcastMode    eBroadcastMode,
+                                                 uint16                      u16SecMd_Radius,
+                                                 uint8*                      pu8SeqNum )
+{
+    return HOST_eDataReq ( hAPduInst, ZPS_E_ADDR_MODE_SHORT, 0xfffc + eBroadcastMode, 0,
+                           ( uint8 ) ( u32ClId_DstEp_SrcEp >> 8 ), ( uint8 ) u32ClId_DstEp_SrcEp,
+                           ( uint16 ) ( u32ClId_DstEp_SrcEp >> 16 ), ZLO_PROFILE_ID, FALSE, pu8SeqNum );
+}
+
+PUBLIC ZPS_teStatus zps_eAplAfBoundDataReq ( void*                  pvApl,
+                                             PDUM_thAPduInstance    hAPduInst,
+                                             uint32                 u32ClId_SrcEp,
+                                             uint16                 u16SecMd_Radius,
+                                             uint8*                 pu8SeqNum )
+{
+    return HOST_eDataReq ( hAPduInst, ZPS_E_ADDR_MODE_BOUND, 0, 0,
+                           0, ( uint8 ) u32ClId_SrcEp,
+                           ( uint16 ) ( u32ClId_SrcEp >> 16 ), ZLO_PROFILE_ID, FALSE, pu8SeqNum );
+}
+
+PUBLIC ZPS_teStatus zps_eAplAfBoundAckDataReq ( void*                  pvApl,
+                                                PDUM_thAPduInstance    hAPduInst,
+                                                uint32                 u32ClId_SrcEp,
+                                                uint16                 u16SecMd_Radius,
+                                                uint8*                 pu8SeqNum )
+{
+    return HOST_eDataReq ( hAPduInst, ZPS_E_ADDR_MODE_BOUND, 0, 0,
+                           0, ( uint8 ) u32ClId_SrcEp,
+                           ( uint16 ) ( u32ClId_SrcEp >> 16 ), ZLO_PROFILE_ID, TRUE, pu8SeqNum );
+}
+
+PUBLIC ZPS_teStatus zps_eAplAfBoundDataReqNonBlocking ( void*                  pvApl,
+                                                        PDUM_thAPduInstance    hAPduInst,
+                                                        uint32                 u32ClId_SrcEp,
+                                                        uint16                 u16SecMd_Radius,
+                                                        bool                   bAckReq )
+{
+    return HOST_eDataReq ( hAPduInst, ZPS_E_ADDR_MODE_BOUND, 0, 0,
+                           0, ( uint8 ) u32ClId_SrcEp,
+                           ( uint16 ) ( u32ClId_SrcEp >> 16 ), ZLO_PROFILE_ID, bAckReq, NULL );
+}
+
+PUBLIC ZPS_teStatus zps_eAplAfApsdeDataReq ( void*                      pvApl,
+                                             PDUM_thAPduInstance        hAPduInst,
+                                             ZPS_tsAfProfileDataReq*    psProfileDataReq,
+                                             uint8*                     pu8SeqNum,
+                                             uint8                      eTxOptions )
+{
+    bool_t    bIeee =  ( psProfileDataReq->eDstAddrMode == ZPS_E_ADDR_MODE_IEEE ) ||
+                       ( psProfileDataReq->eDstAddrMode == ZPS_E_ADDR_MODE_IEEE_NO_ACK );
+    bool_t    bAck  =  ( psProfileDataReq->eDstAddrMode == ZPS_E_ADDR_MODE_SHORT ) ||
+                       ( psProfileDataReq->eDstAddrMode == ZPS_E_ADDR_MODE_IEEE ) ||
+                       ( psProfileDataReq->eDstAddrMode == ZPS_E_ADDR_MODE_BOUND );
+
+    return HOST_eDataReq ( hAPduInst,
+                           bIeee ? ZPS_E_ADDR_MODE_IEEE : psProfileDataReq->eDstAddrMode,
+                           bIeee ? 0 : psProfileDataReq->uDstAddr.u16Addr,
+                           bIeee ? psProfileDataReq->uDstAddr.u64Addr : 0,
+                           psProfileDataReq->u8DstEp, psProfileDataReq->u8SrcEp,
+                           psProfileDataReq->u16ClusterId, psProfileDataReq->u16ProfileId,
+                           bAck, pu8SeqNum );
+}
+
+/* Inter-PAN frames bypass the APS and its handles */
+PUBLIC ZPS_teStatus zps_eAplAfInterPanDataReq ( void*                     pvApl,
+                                                PDUM_thAPduInstance       hAPduInst,
+                                                uint32                    u32ClId_ProfId,
+                                                ZPS_tsInterPanAddress*    psDstAddr,
+                                                uint8                     u8Handle )
+{
+    PDUM_eAPduFreeAPduInstance ( hAPduInst );
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplAfGetSimpleDescriptor ( void*                           pvApl,
+                                                    uint8                           u8Endpoint,
+                                                    ZPS_tsAplAfSimpleDescriptor*    psDesc )
+{
+    memset ( psDesc, 0, sizeof ( ZPS_tsAplAfSimpleDescriptor ) );
+    psDesc->u16ApplicationProfileId =  ZLO_PROFILE_ID;
+    psDesc->u8Endpoint              =  u8Endpoint;
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC uint8 ZPS_u8AplGetMaxPayloadSize ( void*     pvApl,
+                                          uint16    u16Addr )
+{
+    uint8    i;
+
+    for ( i = 0; i < HOST_PAYLOAD_LIMITS; i++ )
+    {
+        if ( asHostPayloadLimits[i].bUsed && ( asHostPayloadLimits[i].u16Addr == u16Addr ) )
+        {
+            return asHostPayloadLimits[i].u8MaxPayload;
+        }
+    }
+    return HOST_ZPS_MAX_PAYLOAD;
+}
+
+PUBLIC bool_t ZPS_bAplDoesDeviceSupportFragmentation ( void*    pvApl )
+{
+    return TRUE;
+}
+
+PUBLIC bool_t zps_bIsFragmentationEngineActive ( void*    pvApl )
+{
+    return FALSE;
+}
+
+/****************************************************************************/
+/***        ZDP requests                                                  ***/
+/****************************************************************************/
+
+PUBLIC ZPS_teStatus zps_eAplZdpNwkAddrRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                bool bExtAddr, uint8* pu8SeqNumber, ZPS_tsAplZdpNwkAddrReq* psReq )
+{
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_NWK_ADDR_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpIeeeAddrRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                 bool bExtAddr, uint8* pu8SeqNumber, ZPS_tsAplZdpIeeeAddrReq* psReq )
+{
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_IEEE_ADDR_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpNodeDescRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                 bool bExtAddr, uint8* pu8SeqNumber, ZPS_tsAplZdpNodeDescReq* psReq )
+{
+    PDUM_u16APduInstanceWriteNBO ( hAPduInst, 1, "h", psReq->u16NwkAddrOfInterest );
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_NODE_DESC_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpPowerDescRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                  bool bExtAddr, uint8* pu8SeqNumber, ZPS_tsAplZdpPowerDescReq* psReq )
+{
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_POWER_DESC_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpSimpleDescRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                   bool bExtAddr, uint8* pu8SeqNumber, ZPS_tsAplZdpSimpleDescReq* psReq )
+{
+    PDUM_u16APduInstanceWriteNBO ( hAPduInst, 1, "hb", psReq->u16NwkAddrOfInterest, psReq->u8EndPoint );
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_SIMPLE_DESC_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpActiveEpRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                 bool bExtAddr, uint8* pu8SeqNumber, ZPS_tsAplZdpActiveEpReq* psReq )
+{
+    PDUM_u16APduInstanceWriteNBO ( hAPduInst, 1, "h", psReq->u16NwkAddrOfInterest );
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_ACTIVE_EP_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpMatchDescRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                  bool bExtAddr, uint8* pu8SeqNumber, ZPS_tsAplZdpMatchDescReq* psReq )
+{
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_MATCH_DESC_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpBindUnbindRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                   bool bExtAddr, uint8* pu8SeqNumber, bool bBindReq,
+                                                   ZPS_tsAplZdpBindUnbindReq* psReq )
+{
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr,
+                          bBindReq ? ZPS_ZDP_BIND_REQ_CLUSTER_ID : ZPS_ZDP_UNBIND_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpMgmtLqiRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                bool bExtAddr, uint8* pu8SeqNumber, ZPS_tsAplZdpMgmtLqiReq* psReq )
+{
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_MGMT_LQI_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpMgmtRtgRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                bool bExtAddr, uint8* pu8SeqNumber, ZPS_tsAplZdpMgmtRtgReq* psReq )
+{
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_MGMT_RTG_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpMgmtLeaveRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                  bool bExtAddr, uint8* pu8SeqNumber, ZPS_tsAplZdpMgmtLeaveReq* psReq )
+{
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_MGMT_LEAVE_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpMgmtPermitJoiningRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                          bool bExtAddr, uint8* pu8SeqNumber,
+                                                          ZPS_tsAplZdpMgmtPermitJoiningReq* psReq )
+{
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_MGMT_PERMIT_JOINING_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpMgmtNwkUpdateRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst, ZPS_tuAddress uDstAddr,
+                                                      bool bExtAddr, uint8* pu8SeqNumber,
+                                                      ZPS_tsAplZdpMgmtNwkUpdateReq* psReq )
+{
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, bExtAddr, ZPS_ZDP_MGMT_NWK_UPDATE_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdpSystemServerDiscoveryRequest ( void* pvApl, PDUM_thAPduInstance hAPduInst,
+                                                              uint8* pu8SeqNumber,
+                                                              ZPS_tsAplZdpSystemServerDiscoveryReq* psReq )
+{
+    ZPS_tuAddress    uDstAddr;
+
+    uDstAddr.u16Addr =  0xfffd;
+    return HOST_eZdpReq ( hAPduInst, uDstAddr, FALSE, ZPS_ZDP_SYSTEM_SERVER_DISCOVERY_REQ_CLUSTER_ID, pu8SeqNumber );
+}
+
+PUBLIC bool zps_bAplZdpUnpackResponse ( ZPS_tsAfEvent*       psZdoServerEvent,
+                                        ZPS_tsAfZdpEvent*    psReturnStruct )
+{
+    PDUM_thAPduInstance    hAPduInst =  psZdoServerEvent->uEvent.sApsDataIndEvent.hAPduInst;
+    const uint8*           pu8Frame  =  hAPduInst->au8Storage;
+    uint16                 u16Size   =  hAPduInst->u16Size;
+    uint16                 u16Pos    =  1;
+    uint8                  i;
+
+    memset ( psReturnStruct, 0, sizeof ( ZPS_tsAfZdpEvent ) );
+    psReturnStruct->u16ClusterId =  psZdoServerEvent->uEvent.sApsDataIndEvent.u16ClusterId;
+    psReturnStruct->u8SequNumber =  pu8Frame[0];
+
+    switch ( psReturnStruct->u16ClusterId )
+    {
+        case ZPS_ZDP_DEVICE_ANNCE_REQ_CLUSTER_ID:
+        {
+            ZPS_tsAplZdpDeviceAnnceReq*    psAnnce =  &psReturnStruct->uZdpData.sDeviceAnnce;
+
+            if ( u16Size < 12 )
+            {
+                return FALSE;
+            }
+            psAnnce->u16NwkAddr =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+            for ( i = 0; i < 8; i++ )
+            {
+                psAnnce->u64IeeeAddr |=  ( uint64 ) pu8Frame[u16Pos++] << ( 8 * i );
+            }
+            psAnnce->u8Capability =  pu8Frame[u16Pos];
+            return TRUE;
+        }
+
+        case ZPS_ZDP_NODE_DESC_RSP_CLUSTER_ID:
+        {
+            ZPS_tsAplZdpNodeDescRsp*    psRsp =  &psReturnStruct->uZdpData.sNodeDescRsp;
+
+            if ( u16Size < 4 )
+            {
+                return FALSE;
+            }
+            psRsp->u8Status             =  pu8Frame[u16Pos++];
+            psRsp->u16NwkAddrOfInterest =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+            if ( psRsp->u8Status == ZPS_E_SUCCESS && u16Size >= 17 )
+            {
+                psRsp->sNodeDescriptor.uBitUnion.u16Value      =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+                psRsp->sNodeDescriptor.u8MacFlags              =  pu8Frame[u16Pos++];
+                psRsp->sNodeDescriptor.u16ManufacturerCode     =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+                psRsp->sNodeDescriptor.u8MaxBufferSize         =  pu8Frame[u16Pos++];
+                psRsp->sNodeDescriptor.u16MaxRxSize            =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+                psRsp->sNodeDescriptor.u16ServerMask           =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+                psRsp->sNodeDescriptor.u16MaxTxSize            =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+                psRsp->sNodeDescriptor.u8DescriptorCapability  =  pu8Frame[u16Pos];
+            }
+            return TRUE;
+        }
+
+        case ZPS_ZDP_ACTIVE_EP_RSP_CLUSTER_ID:
+        {
+            ZPS_tsAplZdpActiveEpRsp*    psRsp =  &psReturnStruct->uZdpData.sActiveEpRsp;
+
+            if ( u16Size < 5 )
+            {
+                return FALSE;
+            }
+            psRsp->u8Status             =  pu8Frame[u16Pos++];
+            psRsp->u16NwkAddrOfInterest =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+            psRsp->u8ActiveEpCount      =  pu8Frame[u16Pos++];
+            if ( psRsp->u8ActiveEpCount > sizeof ( psReturnStruct->uLists.au8Data ) ||
+                 u16Pos + psRsp->u8ActiveEpCount > u16Size )
+            {
+                return FALSE;
+            }
+            memcpy ( psReturnStruct->uLists.au8Data, &pu8Frame[u16Pos], psRsp->u8ActiveEpCount );
+            psRsp->pu8ActiveEpList =  psReturnStruct->uLists.au8Data;
+            return TRUE;
+        }
+
+        case ZPS_ZDP_SIMPLE_DESC_RSP_CLUSTER_ID:
+        {
+            ZPS_tsAplZdpSimpleDescRsp*     psRsp  =  &psReturnStruct->uZdpData.sSimpleDescRsp;
+            ZPS_tsAplZdpSimpleDescType*    psDesc =  &psRsp->sSimpleDescriptor;
+            uint8                          u8MaxClusters =  sizeof ( psReturnStruct->uLists.au16Data ) / sizeof ( uint16 );
+            uint8                          u8Clusters;
+
+            if ( u16Size < 5 )
+            {
+                return FALSE;
+            }
+            psRsp->u8Status             =  pu8Frame[u16Pos++];
+            psRsp->u16NwkAddrOfInterest =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+            psRsp->u8Length             =  pu8Frame[u16Pos++];
+            if ( psRsp->u8Status != ZPS_E_SUCCESS )
+            {
+                return TRUE;
+            }
+            if ( u16Pos + 7 > u16Size )
+            {
+                return FALSE;
+            }
+            psDesc->u8Endpoint              =  pu8Frame[u16Pos++];
+            psDesc->u16ApplicationProfileId =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+            psDesc->u16DeviceId             =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+            psDesc->uBitUnion.u8Value       =  pu8Frame[u16Pos++];
+            psDesc->u8InClusterCount        =  pu8Frame[u16Pos++];
+            if ( psDesc->u8InClusterCount > u8MaxClusters || u16Pos + 2 * psDesc->u8InClusterCount + 1 > u16Size )
+            {
+                return FALSE;
+            }
+            for ( u8Clusters = 0; u8Clusters < psDesc->u8InClusterCount; u8Clusters++ )
+            {
+                psReturnStruct->uLists.au16Data[u8Clusters] =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+            }
+            psDesc->u8OutClusterCount =  pu8Frame[u16Pos++];
+            if ( u8Clusters + psDesc->u8OutClusterCount > u8MaxClusters || u16Pos + 2 * psDesc->u8OutClusterCount > u16Size )
+            {
+                return FALSE;
+            }
+            for ( i = 0; i < psDesc->u8OutClusterCount; i++ )
+            {
+                psReturnStruct->uLists.au16Data[u8Clusters + i] =  HOST_u16ZdpRead16 ( pu8Frame, &u16Pos );
+            }
+            psDesc->pu16InClusterList  =  &psReturnStruct->uLists.au16Data[0];
+            psDesc->pu16OutClusterList =  &psReturnStruct->uLists.au16Data[u8Clusters];
+            return TRUE;
+        }
+
+        default:
+            return FALSE;
+    }
+}
+
+/****************************************************************************/
+/***        ZDO, AIB and security services                                ***/
+/****************************************************************************/
+
+PUBLIC ZPS_teStatus zps_eAplZdoBind ( void* pvApl, uint32 u32ClId_SrcEp, uint8 u8DstEp, uint16 u16DstNwkAddr, uint64 u64DstIeeeAddr )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdoUnbind ( void* pvApl, uint32 u32ClId_SrcEp, uint8 u8DstEp, uint16 u16DstNwkAddr, uint64 u64DstIeeeAddr )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdoGroupEndpointAdd ( void* pvApl, uint16 u16GroupAddr, uint8 u8DstEndpoint )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdoGroupEndpointRemove ( void* pvApl, uint16 u16GroupAddr, uint8 u8DstEndpoint )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdoGroupAllEndpointRemove ( void* pvApl, uint8 u8DstEndpoint )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdoPermitJoining ( void* pvApl, uint8 u8PermitDuration )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdoManyToOneRouteRequest ( void* pvApl, bool bCacheRoute, uint8 u8Radius )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdoLeaveNetwork ( void* pvApl, uint64 u64Addr, bool bRemoveChildren, bool bRejoin )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdoRemoveDeviceReq ( void* pvApl, uint64 u64ParentAddr, uint64 u64ChildAddr )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdoTransportNwkKey ( void* pvApl, uint8 u8DstAddrMode, ZPS_tuAddress uDstAddress,
+                                                 uint8 au8Key[ZPS_SEC_KEY_LENGTH], uint8 u8KeySeqNum,
+                                                 bool bUseParent, uint64 u64ParentAddr )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdoAddReplaceLinkKey ( void* pvApl, uint64 u64IeeeAddr, uint8 au8Key[ZPS_SEC_KEY_LENGTH],
+                                                   ZPS_teApsLinkKeyType eKeyType )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplZdoAddReplaceInstallCodes ( void* pvApl, uint64 u64IeeeAddr, uint8 au8Key[ZPS_SEC_KEY_LENGTH],
+                                                        uint8 u8Size, ZPS_teApsLinkKeyType eKeyType )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_vAplSecSetInitialSecurityState ( void* pvApl, ZPS_teZdoNwkKeyState eState, uint8* pu8Key,
+                                                         uint8 u8KeySeqNum, ZPS_teApsLinkKeyType eKeyType )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_bAplZdoTrustCenterSetDevicePermissions ( void* pvApl, uint64 u64DeviceAddr,
+                                                                 ZPS_teDevicePermissions u8DevicePermissions )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_bAplZdoTrustCenterGetDevicePermissions ( void* pvApl, uint64 u64DeviceAddr,
+                                                                 ZPS_teDevicePermissions* pu8DevicePermissions )
+{
+    *pu8DevicePermissions =  0;
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplAibSetApsTrustCenterAddress ( void* pvApl, uint64 u64TcAddress )
+{
+    sHostAib.u64ApsTrustCenterAddress =  u64TcAddress;
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplAibSetApsUseExtendedPanId ( void* pvApl, uint64 u64UseExtPanId )
+{
+    sHostAib.u64ApsUseExtendedPanid =  u64UseExtPanId;
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC ZPS_teStatus zps_eAplAibSetApsChannelMask ( void* pvApl, uint32 u32ChannelMask )
+{
+    return ZPS_E_SUCCESS;
+}
+
+PUBLIC void zps_vSetZdoDeviceType ( void* pvApl, uint8 u8DeviceType )
+{
+}
+
+PUBLIC void zps_vSaveAllZpsRecords ( void* pvApl )
+{
+}
+
+PUBLIC void ZPS_vTCSetCallback ( void* pvFn )
+{
+}
+
+PUBLIC void zps_pvAesGetKeyFromInstallCode ( uint8* pu8installCode, uint16 u16installCodeLength,
+                                             AESSW_Block_u* puresult )
+{
+    memset ( puresult, 0, sizeof ( AESSW_Block_u ) );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,335 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_aps_fragment.c
+ *
+ * DESCRIPTION:        Raw APS data and APS fragmentation: the length checks of
+ *                     the raw APS command, the fragmentation counters of the
+ *                     0x8534 report and the time the host takes to move a
+ *                     kilobyte in fragmented and in single frame transfers.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zcl.h"
+#include "SerialLink.h"
+#include "app_common.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_DST_ADDR                   0x3000
+#define TEST_FRAGMENTED_LENGTH          150
+#define TEST_TRANSFER_BYTES             1024
+
+/* Airtime of one frame on air, a fragmented ASDU takes one per block */
+#define TEST_FRAME_AIRTIME_MS           10
+
+/* Offsets into the 0x8534 payload */
+#define TEST_INFO_SUPPORTED             0
+#define TEST_INFO_WINDOW                2
+#define TEST_INFO_APDU_SIZE             3
+#define TEST_INFO_TX_COUNT              8
+#define TEST_INFO_TX_BYTES              12
+#define TEST_INFO_TX_TOO_LONG           16
+#define TEST_INFO_RX_COUNT              20
+#define TEST_INFO_RX_BYTES              24
+#define TEST_INFO_RX_LARGEST            28
+
+#define TEST_U16( PAYLOAD, OFFSET )     ( ( ( PAYLOAD )[OFFSET] << 8 ) | ( PAYLOAD )[( OFFSET ) + 1] )
+#define TEST_U32( PAYLOAD, OFFSET )     ( ( ( uint32 ) TEST_U16 ( PAYLOAD, OFFSET ) << 16 ) | TEST_U16 ( PAYLOAD, ( OFFSET ) + 2 ) )
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* Raw APS data to a short address; the declared length may differ from the
+ * bytes that follow it */
+PRIVATE void vSendRawAps ( uint8     u8AddrMode,
+                           uint16    u16Addr,
+                           uint8     u8DeclaredLength,
+                           uint16    u16Length )
+{
+    uint8     au8Payload[12 + 255];
+    uint16    i;
+
+    au8Payload[0]  =  u8AddrMode;
+    au8Payload[1]  =  ( uint8 ) ( u16Addr >> 8 );
+    au8Payload[2]  =  ( uint8 ) u16Addr;
+    au8Payload[3]  =  1;
+    au8Payload[4]  =  1;
+    au8Payload[5]  =  0xfc;
+    au8Payload[6]  =  0x00;
+    au8Payload[7]  =  0x01;
+    au8Payload[8]  =  0x04;
+    au8Payload[9]  =  0;
+    au8Payload[10] =  0;
+    au8Payload[11] =  u8DeclaredLength;
+    for ( i = 0; i < u16Length; i++ )
+    {
+        au8Payload[12 + i] =  ( uint8 ) i;
+    }
+    HOST_vSerialWrite ( E_SL_MSG_SEND_RAW_APS_DATA_PACKET, 12 + u16Length, au8Payload );
+}
+
+/* Status of the last raw APS command, 0xff if none came back */
+PRIVATE uint8 u8RawApsStatus ( void )
+{
+    tsHostSerialFrame    sFrame;
+
+    HOST_vRun ( 50 );
+    while ( HOST_bSerialFind ( E_SL_MSG_STATUS, &sFrame ) )
+    {
+        if ( ( TEST_U16 ( sFrame.au8Payload, 2 ) == E_SL_MSG_SEND_RAW_APS_DATA_PACKET ) &&
+             ( sFrame.au8Payload[4] != 3 ) )
+        {
+            return sFrame.au8Payload[0];
+        }
+    }
+    return 0xff;
+}
+
+PRIVATE bool_t bGetInfo ( bool_t                bClear,
+                          tsHostSerialFrame*    psFrame )
+{
+    uint8    u8Clear =  bClear ? 1 : 0;
+
+    HOST_vSerialFlush ( );
+    HOST_vSerialWrite ( E_SL_MSG_GET_APS_FRAGMENTATION_INFO, 1, &u8Clear );
+    HOST_vRun ( 10 );
+    return HOST_bSerialFind ( E_SL_MSG_APS_FRAGMENTATION_INFO_RESPONSE, psFrame );
+}
+
+/* Moves a transfer in ASDUs of at most the given size, one at a time, each
+ * confirmed after the airtime of the frames it takes. Returns the time the
+ * transfer took, the data requests it made and the serial bytes both ways. */
+PRIVATE uint32 u32Transfer ( uint16     u16AsduSize,
+                             uint32*    pu32Requests,
+                             uint32*    pu32SerialBytes )
+{
+    tsHostSerialFrame    sFrame;
+    uint32               u32Start     =  HOST_u32TimeMs ( );
+    uint32               u32First     =  HOST_u32DataReqCount ( );
+    uint32               u32Left      =  TEST_TRANSFER_BYTES;
+    uint32               u32Bytes     =  0;
+    uint32               u32Pending;
+    uint32               u32Count;
+    uint8                au8Raw[HOST_SERIAL_TX_RAW_SIZE];
+    uint16               u16Length;
+    uint16               u16Frames;
+    tsHostDataReq*       psReq;
+
+    while ( u32Left > 0 )
+    {
+        u16Length =  ( u32Left < u16AsduSize ) ? ( uint16 ) u32Left : u16AsduSize;
+        u16Frames =  ( u16Length + HOST_ZPS_MAX_PAYLOAD - 1 ) / HOST_ZPS_MAX_PAYLOAD;
+        u32Left  -=  u16Length;
+
+        HOST_vSerialFlush ( );
+        u32Pending =  HOST_u32SerialRxPending ( );
+        vSendRawAps ( ZPS_E_ADDR_MODE_SHORT, TEST_DST_ADDR, ( uint8 ) u16Length, u16Length );
+        u32Bytes  +=  HOST_u32SerialRxPending ( ) - u32Pending;
+
+        u32Count =  HOST_u32DataReqCount ( );
+        while ( HOST_u32DataReqCount ( ) == u32Count )
+        {
+            HOST_vRun ( 1 );
+        }
+        psReq =  HOST_psDataReq ( u32Count );
+        HOST_vRun ( u16Frames * TEST_FRAME_AIRTIME_MS );
+        HOST_bDataConfirm ( psReq->u8ApsSeqNum, ZPS_E_SUCCESS );
+        do
+        {
+            HOST_vRun ( 1 );
+        } while ( !HOST_bSerialFind ( E_SL_MSG_APS_DATA_CONFIRM, &sFrame ) );
+        u32Bytes +=  HOST_u32SerialTxRaw ( au8Raw, sizeof ( au8Raw ) );
+    }
+
+    *pu32Requests    =  HOST_u32DataReqCount ( ) - u32First;
+    *pu32SerialBytes =  u32Bytes;
+    return HOST_u32TimeMs ( ) - u32Start;
+}
+
+/* A payload that needs fragmenting goes to the stack whole as one request
+ * and is counted with its length */
+PRIVATE void vFragmentedUnicastIsCounted ( void )
+{
+    tsHostSerialFrame    sFrame;
+    tsHostDataReq*       psReq;
+
+    HOST_vInit ( );
+    HOST_CHECK ( bGetInfo ( TRUE, &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_INFO_SUPPORTED], 1 );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_INFO_WINDOW], HOST_ZPS_APS_WINDOW_SIZE );
+    HOST_CHECK_EQUAL ( TEST_U16 ( sFrame.au8Payload, TEST_INFO_APDU_SIZE ), HOST_APDU_ZDP_SIZE );
+
+    vSendRawAps ( ZPS_E_ADDR_MODE_SHORT, TEST_DST_ADDR, HOST_ZPS_MAX_PAYLOAD, HOST_ZPS_MAX_PAYLOAD );
+    HOST_CHECK_EQUAL ( u8RawApsStatus ( ), E_SL_MSG_STATUS_SUCCESS );
+    vSendRawAps ( ZPS_E_ADDR_MODE_SHORT, TEST_DST_ADDR, TEST_FRAGMENTED_LENGTH, TEST_FRAGMENTED_LENGTH );
+    HOST_CHECK_EQUAL ( u8RawApsStatus ( ), E_SL_MSG_STATUS_SUCCESS );
+    vSendRawAps ( ZPS_E_ADDR_MODE_SHORT, TEST_DST_ADDR, HOST_APDU_ZDP_SIZE, HOST_APDU_ZDP_SIZE );
+    HOST_CHECK_EQUAL ( u8RawApsStatus ( ), E_SL_MSG_STATUS_SUCCESS );
+
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 3 );
+    psReq =  HOST_psDataReq ( 1 );
+    HOST_CHECK_EQUAL ( psReq->u16PayloadLength, TEST_FRAGMENTED_LENGTH );
+    HOST_CHECK ( psReq->bAck );
+    HOST_CHECK_EQUAL ( psReq->au8Payload[TEST_FRAGMENTED_LENGTH - 1], ( uint8 ) ( TEST_FRAGMENTED_LENGTH - 1 ) );
+    HOST_CHECK_EQUAL ( HOST_psDataReq ( 2 )->u16PayloadLength, HOST_APDU_ZDP_SIZE );
+
+    HOST_CHECK ( bGetInfo ( FALSE, &sFrame ) );
+    HOST_CHECK_EQUAL ( TEST_U32 ( sFrame.au8Payload, TEST_INFO_TX_COUNT ), 2 );
+    HOST_CHECK_EQUAL ( TEST_U32 ( sFrame.au8Payload, TEST_INFO_TX_BYTES ), TEST_FRAGMENTED_LENGTH + HOST_APDU_ZDP_SIZE );
+    HOST_CHECK_EQUAL ( TEST_U32 ( sFrame.au8Payload, TEST_INFO_TX_TOO_LONG ), 0 );
+}
+
+/* Fragmentation needs acknowledged unicast, anything else is refused before
+ * an APDU is taken; lengths the frame or the APDU cannot hold are refused */
+PRIVATE void vLengthsAreChecked ( void )
+{
+    tsHostSerialFrame    sFrame;
+    uint8                u8ApduFree;
+
+    HOST_vInit ( );
+    HOST_CHECK ( bGetInfo ( TRUE, &sFrame ) );
+    u8ApduFree =  HOST_u8ApduFree ( );
+
+    vSendRawAps ( ZPS_E_ADDR_MODE_GROUP, 0x0001, TEST_FRAGMENTED_LENGTH, TEST_FRAGMENTED_LENGTH );
+    HOST_CHECK_EQUAL ( u8RawApsStatus ( ), ZPS_APL_APS_E_ASDU_TOO_LONG );
+    vSendRawAps ( ZPS_E_ADDR_MODE_SHORT_NO_ACK, TEST_DST_ADDR, TEST_FRAGMENTED_LENGTH, TEST_FRAGMENTED_LENGTH );
+    HOST_CHECK_EQUAL ( u8RawApsStatus ( ), ZPS_APL_APS_E_ASDU_TOO_LONG );
+    vSendRawAps ( ZPS_E_ADDR_MODE_GROUP, 0x0001, HOST_ZPS_MAX_PAYLOAD, HOST_ZPS_MAX_PAYLOAD );
+    HOST_CHECK_EQUAL ( u8RawApsStatus ( ), E_SL_MSG_STATUS_SUCCESS );
+
+    vSendRawAps ( ZPS_E_ADDR_MODE_SHORT, TEST_DST_ADDR, TEST_FRAGMENTED_LENGTH, TEST_FRAGMENTED_LENGTH - 1 );
+    HOST_CHECK_EQUAL ( u8RawApsStatus ( ), E_SL_MSG_STATUS_INCORRECT_PARAMETERS );
+    vSendRawAps ( ZPS_E_ADDR_MODE_SHORT, TEST_DST_ADDR, HOST_APDU_ZDP_SIZE + 1, HOST_APDU_ZDP_SIZE + 1 );
+    HOST_CHECK_EQUAL ( u8RawApsStatus ( ), E_ZCL_ERR_ZBUFFER_FAIL );
+
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 1 );
+    HOST_CHECK_EQUAL ( HOST_u8ApduFree ( ), u8ApduFree );
+    HOST_CHECK ( bGetInfo ( FALSE, &sFrame ) );
+    HOST_CHECK_EQUAL ( TEST_U32 ( sFrame.au8Payload, TEST_INFO_TX_TOO_LONG ), 2 );
+    HOST_CHECK_EQUAL ( TEST_U32 ( sFrame.au8Payload, TEST_INFO_TX_COUNT ), 0 );
+}
+
+/* Indications longer than one frame were reassembled and reach a host in
+ * hybrid raw mode whole; the report clears the counters when asked */
+PRIVATE void vReassembledIndicationIsCounted ( void )
+{
+    tsHostSerialFrame    sFrame;
+    uint8                au8Data[TEST_FRAGMENTED_LENGTH];
+    uint16               i;
+    uint8                u8RawMode =  RAW_MODE_HYBRID;
+
+    HOST_vInit ( );
+    HOST_CHECK ( bGetInfo ( TRUE, &sFrame ) );
+    HOST_vAddDevice ( TEST_DST_ADDR, 0x00158D0000300000ULL, FALSE );
+    HOST_vSerialWrite ( E_SL_MSG_SET_RAWMODE, 1, &u8RawMode );
+    HOST_vRun ( 10 );
+    for ( i = 0; i < sizeof ( au8Data ); i++ )
+    {
+        au8Data[i] =  ( uint8 ) ( 0xff - i );
+    }
+    HOST_vSerialFlush ( );
+    HOST_vDataIndication ( TEST_DST_ADDR, 1, 1, 0xfc00, 0x0104, au8Data, HOST_ZPS_MAX_PAYLOAD );
+    HOST_vDataIndication ( TEST_DST_ADDR, 1, 1, 0xfc00, 0x0104, au8Data, sizeof ( au8Data ) );
+    HOST_vRun ( 10 );
+
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_DATA_INDICATION, &sFrame ) );
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_DATA_INDICATION, &sFrame ) );
+    HOST_CHECK ( sFrame.bCrcOk );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[sFrame.u16Length - 2], au8Data[sizeof ( au8Data ) - 1] );
+
+    HOST_CHECK ( bGetInfo ( TRUE, &sFrame ) );
+    HOST_CHECK_EQUAL ( TEST_U32 ( sFrame.au8Payload, TEST_INFO_RX_COUNT ), 1 );
+    HOST_CHECK_EQUAL ( TEST_U32 ( sFrame.au8Payload, TEST_INFO_RX_BYTES ), sizeof ( au8Data ) );
+    HOST_CHECK_EQUAL ( TEST_U16 ( sFrame.au8Payload, TEST_INFO_RX_LARGEST ), sizeof ( au8Data ) );
+
+    HOST_CHECK ( bGetInfo ( FALSE, &sFrame ) );
+    HOST_CHECK_EQUAL ( TEST_U32 ( sFrame.au8Payload, TEST_INFO_RX_COUNT ), 0 );
+    HOST_CHECK_EQUAL ( TEST_U16 ( sFrame.au8Payload, TEST_INFO_RX_LARGEST ), 0 );
+
+    u8RawMode =  RAW_MODE_OFF;
+    HOST_vSerialWrite ( E_SL_MSG_SET_RAWMODE, 1, &u8RawMode );
+    HOST_vRun ( 10 );
+}
+
+/* A kilobyte in ASDUs of the apduZDP size against ASDUs that fit one frame.
+ * Both spend the same airtime per frame, so what is saved is the per
+ * transaction cost: serial framing, status and confirm messages and the
+ * round trip from one confirm to the next request. */
+PRIVATE void vThroughputPerKilobyte ( void )
+{
+    uint32    u32FragmentedMs;
+    uint32    u32FragmentedRequests;
+    uint32    u32FragmentedBytes;
+    uint32    u32SingleMs;
+    uint32    u32SingleRequests;
+    uint32    u32SingleBytes;
+
+    HOST_vInit ( );
+    u32FragmentedMs =  u32Transfer ( HOST_APDU_ZDP_SIZE, &u32FragmentedRequests, &u32FragmentedBytes );
+    HOST_vInit ( );
+    u32SingleMs     =  u32Transfer ( HOST_ZPS_MAX_PAYLOAD, &u32SingleRequests, &u32SingleBytes );
+
+    printf ( "  %u bytes in %u byte ASDUs: %u requests, %u serial bytes, %u ms\n",
+             TEST_TRANSFER_BYTES, HOST_APDU_ZDP_SIZE, ( unsigned ) u32FragmentedRequests,
+             ( unsigned ) u32FragmentedBytes, ( unsigned ) u32FragmentedMs );
+    printf ( "  %u bytes in %u byte ASDUs: %u requests, %u serial bytes, %u ms\n",
+             TEST_TRANSFER_BYTES, HOST_ZPS_MAX_PAYLOAD, ( unsigned ) u32SingleRequests,
+             ( unsigned ) u32SingleBytes, ( unsigned ) u32SingleMs );
+
+    HOST_CHECK_EQUAL ( u32FragmentedRequests, ( TEST_TRANSFER_BYTES + HOST_APDU_ZDP_SIZE - 1 ) / HOST_APDU_ZDP_SIZE );
+    HOST_CHECK_EQUAL ( u32SingleRequests, ( TEST_TRANSFER_BYTES + HOST_ZPS_MAX_PAYLOAD - 1 ) / HOST_ZPS_MAX_PAYLOAD );
+    HOST_CHECK ( u32FragmentedBytes < u32SingleBytes );
+    HOST_CHECK ( u32FragmentedMs < u32SingleMs );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vFragmentedUnicastIsCounted );
+    HOST_TEST ( vLengthsAreChecked );
+    HOST_TEST ( vReassembledIndicationIsCounted );
+    HOST_TEST ( vThroughputPerKilobyte );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
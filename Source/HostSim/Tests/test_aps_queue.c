@@ -0,0 +1,343 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_aps_queue.c
+ *
+ * DESCRIPTION:        APS admission queue: a 200 command burst from a host
+ *                     that keeps to the window the queue gives it, confirms
+ *                     matched on the APS counter and the opt in queue depth
+ *                     byte of the status message.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zcl.h"
+#include "SerialLink.h"
+#include "app_aps_queue.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_BURST_COMMANDS             200
+#define TEST_BURST_DEVICES              20
+
+/* Time from a data request to its confirm for a unicast to a router */
+#define TEST_AIRTIME_MS                 10
+
+/* Commands the host keeps unconfirmed, no more than the queue holds */
+#define TEST_HOST_WINDOW                APS_QUEUE_SIZE
+
+#define TEST_BURST_TIMEOUT_MS           10000
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE void vSendOnOff ( uint8     u8AddrMode,
+                          uint16    u16Addr )
+{
+    uint8    au8Payload[6];
+
+    au8Payload[0] =  u8AddrMode;
+    au8Payload[1] =  ( uint8 ) ( u16Addr >> 8 );
+    au8Payload[2] =  ( uint8 ) u16Addr;
+    au8Payload[3] =  1;
+    au8Payload[4] =  1;
+    au8Payload[5] =  2;
+    HOST_vSerialWrite ( E_SL_MSG_ONOFF_NOEFFECTS, sizeof ( au8Payload ), au8Payload );
+}
+
+/* Confirms every request that has been on air for the airtime */
+PRIVATE void vConfirmDue ( void )
+{
+    tsHostDataReq*    psReq;
+    uint32            i;
+
+    for ( i = 0; i < HOST_u32DataReqCount ( ); i++ )
+    {
+        psReq =  HOST_psDataReq ( i );
+        if ( ( psReq != NULL ) && !psReq->bConfirmed &&
+             ( ( HOST_u32TimeMs ( ) - psReq->u32TimeMs ) >= TEST_AIRTIME_MS ) )
+        {
+            HOST_bDataConfirm ( psReq->u8ApsSeqNum, ZPS_E_SUCCESS );
+        }
+    }
+}
+
+/* Length of the status message for the next command of a type */
+PRIVATE uint16 u16StatusLength ( uint16    u16Type )
+{
+    tsHostSerialFrame    sFrame;
+
+    HOST_vRun ( 5 );
+    while ( HOST_bSerialFind ( E_SL_MSG_STATUS, &sFrame ) )
+    {
+        if ( ( ( sFrame.au8Payload[2] << 8 ) | sFrame.au8Payload[3] ) == u16Type )
+        {
+            return sFrame.u16Length;
+        }
+    }
+    return 0;
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* The host paces itself on the confirms it sees, so the queue is never full
+ * and the stack is never asked for more than it has */
+PRIVATE void vBurstDrainsWithoutResourceFailures ( void )
+{
+    tsHostSerialFrame    sFrame;
+    uint32               u32Sent      =  0;
+    uint32               u32Confirmed =  0;
+    uint32               u32Statuses  =  0;
+    uint32               u32Queued    =  0;
+    uint32               u32Failed    =  0;
+    uint32               u32Start;
+    uint8                u8MinApduFree =  0xff;
+    uint32               i;
+
+    HOST_vInit ( );
+    for ( i = 0; i < TEST_BURST_DEVICES; i++ )
+    {
+        HOST_vAddDevice ( 0x1000 + i, 0x00158D0000100000ULL + i, FALSE );
+    }
+    u32Start =  HOST_u32TimeMs ( );
+
+    while ( ( u32Confirmed < TEST_BURST_COMMANDS ) &&
+            ( ( HOST_u32TimeMs ( ) - u32Start ) < TEST_BURST_TIMEOUT_MS ) )
+    {
+        while ( ( u32Sent < TEST_BURST_COMMANDS ) && ( ( u32Sent - u32Confirmed ) < TEST_HOST_WINDOW ) )
+        {
+            vSendOnOff ( E_ZCL_AM_SHORT, 0x1000 + ( u32Sent % TEST_BURST_DEVICES ) );
+            u32Sent++;
+        }
+
+        HOST_vRun ( 1 );
+        vConfirmDue ( );
+        if ( HOST_u8ApduFree ( ) < u8MinApduFree )
+        {
+            u8MinApduFree =  HOST_u8ApduFree ( );
+        }
+
+        while ( HOST_bSerialRead ( &sFrame ) )
+        {
+            if ( sFrame.u16Type == E_SL_MSG_STATUS )
+            {
+                /* A queued command reports again once it is sent */
+                if ( sFrame.au8Payload[4] == APS_QUEUE_REQUEST_QUEUED )
+                {
+                    u32Queued++;
+                }
+                else
+                {
+                    u32Statuses++;
+                }
+                if ( sFrame.au8Payload[0] != E_SL_MSG_STATUS_SUCCESS )
+                {
+                    u32Failed++;
+                }
+            }
+            else if ( ( sFrame.u16Type == E_SL_MSG_APS_DATA_CONFIRM ) ||
+                      ( sFrame.u16Type == E_SL_MSG_APS_DATA_CONFIRM_FAILED ) )
+            {
+                u32Confirmed++;
+            }
+        }
+    }
+
+    printf ( "  %u commands drained in %u ms, %u queued, %u requests refused, lowest free APDUs %u\n",
+             ( unsigned ) u32Confirmed, ( unsigned ) ( HOST_u32TimeMs ( ) - u32Start ),
+             ( unsigned ) u32Queued, ( unsigned ) HOST_u32DataReqRefused ( ), ( unsigned ) u8MinApduFree );
+
+    HOST_CHECK_EQUAL ( u32Statuses, TEST_BURST_COMMANDS );
+    HOST_CHECK_EQUAL ( u32Failed, 0 );
+    HOST_CHECK_EQUAL ( u32Confirmed, TEST_BURST_COMMANDS );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), TEST_BURST_COMMANDS );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqRefused ( ), 0 );
+    HOST_CHECK ( u8MinApduFree > 0 );
+    HOST_CHECK_EQUAL ( APP_u8ApsQueueDepth ( ), 0 );
+    /* Acked requests on air at a time bound the drain from below */
+    HOST_CHECK ( ( HOST_u32TimeMs ( ) - u32Start ) < ( 2 * TEST_BURST_COMMANDS * TEST_AIRTIME_MS / APS_QUEUE_MAX_ACK_IN_FLIGHT ) );
+}
+
+/* The host writes the whole burst at once: what the queue can't hold is
+ * refused busy for the host to send again, and the rest drains */
+PRIVATE void vUnpacedBurstIsRefusedBusyAndDrains ( void )
+{
+    tsHostSerialFrame    sFrame;
+    uint32               u32Busy      =  0;
+    uint32               u32Admitted  =  0;
+    uint32               u32Confirmed =  0;
+    uint32               u32Start;
+    uint32               i;
+
+    HOST_vInit ( );
+    for ( i = 0; i < TEST_BURST_DEVICES; i++ )
+    {
+        HOST_vAddDevice ( 0x1000 + i, 0x00158D0000100000ULL + i, FALSE );
+    }
+    for ( i = 0; i < TEST_BURST_COMMANDS; i++ )
+    {
+        vSendOnOff ( E_ZCL_AM_SHORT, 0x1000 + ( i % TEST_BURST_DEVICES ) );
+    }
+    u32Start =  HOST_u32TimeMs ( );
+
+    while ( ( ( HOST_u32SerialRxPending ( ) > 0 ) || ( APP_u8ApsQueueDepth ( ) > 0 ) ||
+              ( u32Confirmed < u32Admitted ) ) &&
+            ( ( HOST_u32TimeMs ( ) - u32Start ) < TEST_BURST_TIMEOUT_MS ) )
+    {
+        HOST_vRun ( 1 );
+        vConfirmDue ( );
+        while ( HOST_bSerialRead ( &sFrame ) )
+        {
+            if ( ( sFrame.u16Type == E_SL_MSG_STATUS ) && ( sFrame.au8Payload[4] != APS_QUEUE_REQUEST_QUEUED ) )
+            {
+                if ( sFrame.au8Payload[0] == E_SL_MSG_STATUS_BUSY )
+                {
+                    u32Busy++;
+                }
+                else if ( sFrame.au8Payload[0] == E_SL_MSG_STATUS_SUCCESS )
+                {
+                    u32Admitted++;
+                }
+            }
+            else if ( ( sFrame.u16Type == E_SL_MSG_APS_DATA_CONFIRM ) ||
+                      ( sFrame.u16Type == E_SL_MSG_APS_DATA_CONFIRM_FAILED ) )
+            {
+                u32Confirmed++;
+            }
+        }
+    }
+
+    printf ( "  %u commands back to back: %u sent, %u refused busy, drained in %u ms\n",
+             ( unsigned ) TEST_BURST_COMMANDS, ( unsigned ) u32Admitted, ( unsigned ) u32Busy,
+             ( unsigned ) ( HOST_u32TimeMs ( ) - u32Start ) );
+
+    HOST_CHECK ( u32Busy > 0 );
+    HOST_CHECK_EQUAL ( u32Admitted + u32Busy, TEST_BURST_COMMANDS );
+    HOST_CHECK_EQUAL ( u32Confirmed, u32Admitted );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), u32Admitted );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqRefused ( ), 0 );
+    HOST_CHECK_EQUAL ( APP_u8ApsQueueDepth ( ), 0 );
+}
+
+/* A confirm for a frame the queue did not send leaves its slots alone */
+PRIVATE void vForeignConfirmIsIgnored ( void )
+{
+    ZPS_tsAfEvent    sStackEvent;
+    uint8            i;
+
+    HOST_vInit ( );
+    for ( i = 0; i <= APS_QUEUE_MAX_IN_FLIGHT; i++ )
+    {
+        vSendOnOff ( E_ZCL_AM_SHORT_NO_ACK, 0x2000 + i );
+    }
+    HOST_vRun ( 20 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), APS_QUEUE_MAX_IN_FLIGHT );
+    HOST_CHECK_EQUAL ( APP_u8ApsQueueDepth ( ), 1 );
+
+    memset ( &sStackEvent, 0, sizeof ( sStackEvent ) );
+    sStackEvent.eType                                      =  ZPS_EVENT_APS_DATA_CONFIRM;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8SrcEndpoint  =  1;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8DstEndpoint  =  1;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8DstAddrMode  =  ZPS_E_ADDR_MODE_SHORT;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8SequenceNum  =  HOST_psDataReq ( 0 )->u8ApsSeqNum + 100;
+    HOST_vStackEvent ( 1, &sStackEvent );
+    HOST_vRun ( 5 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), APS_QUEUE_MAX_IN_FLIGHT );
+    HOST_CHECK_EQUAL ( APP_u8ApsQueueDepth ( ), 1 );
+
+    HOST_CHECK ( HOST_bDataConfirm ( HOST_psDataReq ( 2 )->u8ApsSeqNum, ZPS_E_SUCCESS ) );
+    HOST_vRun ( 5 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), APS_QUEUE_MAX_IN_FLIGHT + 1 );
+    HOST_CHECK_EQUAL ( APP_u8ApsQueueDepth ( ), 0 );
+}
+
+/* Requests never confirmed give their slots up one by one */
+PRIVATE void vUnconfirmedRequestsExpire ( void )
+{
+    uint8    i;
+
+    HOST_vInit ( );
+    for ( i = 0; i <= APS_QUEUE_MAX_IN_FLIGHT; i++ )
+    {
+        vSendOnOff ( E_ZCL_AM_SHORT_NO_ACK, 0x2000 + i );
+    }
+    HOST_vRun ( APS_QUEUE_IN_FLIGHT_TIMEOUT * 100 - 200 );
+    HOST_CHECK_EQUAL ( APP_u8ApsQueueDepth ( ), 1 );
+    HOST_vRun ( 400 );
+    HOST_CHECK_EQUAL ( APP_u8ApsQueueDepth ( ), 0 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), APS_QUEUE_MAX_IN_FLIGHT + 1 );
+}
+
+/* Hosts that never ask see the status message of the original length */
+PRIVATE void vDepthIsReportedOnRequest ( void )
+{
+    uint8     u8Enable =  1;
+    uint16    u16Plain;
+
+    HOST_vInit ( );
+    vSendOnOff ( E_ZCL_AM_SHORT_NO_ACK, 0x2000 );
+    u16Plain =  u16StatusLength ( E_SL_MSG_ONOFF_NOEFFECTS );
+    HOST_CHECK_EQUAL ( u16Plain, 9 );
+
+    HOST_vSerialWrite ( E_SL_MSG_APS_QUEUE_REPORT_DEPTH, 1, &u8Enable );
+    HOST_CHECK_EQUAL ( u16StatusLength ( E_SL_MSG_APS_QUEUE_REPORT_DEPTH ), u16Plain + 1 );
+    vSendOnOff ( E_ZCL_AM_SHORT_NO_ACK, 0x2000 );
+    HOST_CHECK_EQUAL ( u16StatusLength ( E_SL_MSG_ONOFF_NOEFFECTS ), u16Plain + 1 );
+
+    u8Enable =  0;
+    HOST_vSerialWrite ( E_SL_MSG_APS_QUEUE_REPORT_DEPTH, 1, &u8Enable );
+    HOST_CHECK_EQUAL ( u16StatusLength ( E_SL_MSG_APS_QUEUE_REPORT_DEPTH ), u16Plain );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vBurstDrainsWithoutResourceFailures );
+    HOST_TEST ( vUnpacedBurstIsRefusedBusyAndDrains );
+    HOST_TEST ( vForeignConfirmIsIgnored );
+    HOST_TEST ( vUnconfirmedRequestsExpire );
+    HOST_TEST ( vDepthIsReportedOnRequest );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,574 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_attribute_cache.c
+ *
+ * DESCRIPTION:        Attribute cache records: a read attribute response
+ *                     from a device is kept as the host received it, and a
+ *                     later host read is answered from the cache with the
+ *                     same attribute record, without going on air, until
+ *                     the host writes to the cluster. The start-up
+ *                     interview of Tools/AttributeCacheSim.py is then run
+ *                     through the cache against virtual devices, with the
+ *                     cache off, with its default rule and with state
+ *                     clusters cached for a few seconds, counting the
+ *                     radio transactions it avoids.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zcl.h"
+#include "zps_apl_af.h"
+#include "zps_apl_zdp.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "app_attribute_cache.h"
+#include "app_device_interview.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_ADDR                       0x4000
+#define TEST_IEEE_ADDR                  0x00158D0000400000ULL
+#define TEST_ENDPOINT                   1
+#define TEST_CLUSTER                    0x0000
+#define TEST_ATTRIBUTE                  0x0005
+
+/* Offsets into the 0x8100 payload */
+#define TEST_RESPONSE_SEQ               0
+#define TEST_RESPONSE_ATTRIBUTE         6
+#define TEST_RESPONSE_STATUS            8
+#define TEST_RESPONSE_TYPE              9
+#define TEST_RESPONSE_SIZE              10
+#define TEST_RESPONSE_VALUE             12
+
+/* Offset into the 0x8000 payload, and its value for a ZCL request sent */
+#define TEST_STATUS_REQUEST             4
+#define TEST_REQUEST_SENT_ZCL           1
+
+/* Start-up interview: every integration reads every device when the host
+ * starts, the host starting TEST_STARTS times over a day */
+#define TEST_DEVICES                    8
+#define TEST_DEVICE_ADDR                0x5000
+#define TEST_DEVICE_IEEE_ADDR           0x00158D0000500000ULL
+#define TEST_INTEGRATIONS               3
+#define TEST_STARTS                     5
+
+/* Cache clock, in 100ms ticks: integrations read a few devices a second */
+#define TEST_DEVICE_TICKS               3
+#define TEST_START_TICKS                ( 86400UL * 10 / TEST_STARTS )
+
+/* Lifetime of On/Off and Level values for the state rules, in seconds */
+#define TEST_STATE_TTL                  5
+
+/* Receiver on when idle, mains powered router */
+#define TEST_CAPABILITY                 0x8e
+
+/* Polls of the main loop for the coordinator's own interview to finish */
+#define TEST_INTERVIEW_ROUNDS           1000
+
+/* Offsets into the 0x8126 payload */
+#define TEST_STATS_HELD                 1
+#define TEST_STATS_HITS                 3
+#define TEST_STATS_EVICTED              19
+#define TEST_STATS_INVALIDATED          23
+#define TEST_STATS_SIZE                 27
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+    E_TEST_RULES_OFF,
+    E_TEST_RULES_DEFAULT,
+    E_TEST_RULES_STATE
+} teTestRules;
+
+/* One read of an integration's interview */
+typedef struct
+{
+    uint16    u16ClusterId;
+    uint8     u8Attributes;
+    uint16    au16Attributes[2];
+} tsTestRead;
+
+typedef struct
+{
+    uint32    u32Reads;
+    uint32    u32OnAir;
+    uint32    u32Interview;
+    uint8     au8Stats[TEST_STATS_SIZE];
+} tsTestInterviewRun;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+/* Read attributes response: model identifier "lumi.s1" */
+PRIVATE uint8    au8ModelResponse[] = { 0x18, 0x21, 0x01, 0x05, 0x00, 0x00, E_ZCL_CSTRING, 0x07,
+                                        'l', 'u', 'm', 'i', '.', 's', '1' };
+
+/* What each integration reads of every device when it starts, as in
+ * Tools/AttributeCacheSim.py */
+PRIVATE const tsTestRead    asTestInterview[] =
+{
+    { 0x0000, 2, { 0x0004, 0x0005 } },      /* manufacturer and model */
+    { 0x0000, 1, { 0x0007 } },              /* power source */
+    { 0x0000, 2, { 0x0001, 0x4000 } },      /* application version and software build */
+    { 0x0006, 1, { 0x0000 } },
+    { 0x0008, 1, { 0x0000 } },
+};
+
+PRIVATE const char*         apcTestRules[] = { "off", "default", "state" };
+
+/* Data requests already confirmed and answered */
+PRIVATE uint32              u32TestAnswered;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE void vStart ( void )
+{
+    HOST_vInit ( );
+    HOST_vAddDevice ( TEST_ADDR, TEST_IEEE_ADDR, FALSE );
+    HOST_vRun ( 10 );
+    HOST_vSerialFlush ( );
+}
+
+PRIVATE void vReadAttribute ( void )
+{
+    uint8    au8Payload[14];
+
+    au8Payload[0]  =  E_ZCL_AM_SHORT;
+    au8Payload[1]  =  ( uint8 ) ( TEST_ADDR >> 8 );
+    au8Payload[2]  =  ( uint8 ) TEST_ADDR;
+    au8Payload[3]  =  1;
+    au8Payload[4]  =  TEST_ENDPOINT;
+    au8Payload[5]  =  ( uint8 ) ( TEST_CLUSTER >> 8 );
+    au8Payload[6]  =  ( uint8 ) TEST_CLUSTER;
+    au8Payload[7]  =  0;
+    au8Payload[8]  =  0;
+    au8Payload[9]  =  0;
+    au8Payload[10] =  0;
+    au8Payload[11] =  1;
+    au8Payload[12] =  ( uint8 ) ( TEST_ATTRIBUTE >> 8 );
+    au8Payload[13] =  ( uint8 ) TEST_ATTRIBUTE;
+    HOST_vSerialWrite ( E_SL_MSG_READ_ATTRIBUTE_REQUEST, sizeof ( au8Payload ), au8Payload );
+    HOST_vRun ( 5 );
+}
+
+/* Whether the host read went on air or was served from the cache */
+PRIVATE uint8 u8ReadRequestStatus ( void )
+{
+    tsHostSerialFrame    sFrame;
+
+    while ( HOST_bSerialFind ( E_SL_MSG_STATUS, &sFrame ) )
+    {
+        if ( ( ( sFrame.au8Payload[2] << 8 ) | sFrame.au8Payload[3] ) == E_SL_MSG_READ_ATTRIBUTE_REQUEST )
+        {
+            return sFrame.au8Payload[TEST_STATUS_REQUEST];
+        }
+    }
+    return 0xff;
+}
+
+/* Answers a read as the device would: every attribute supported, strings
+ * for the Basic identifiers and a byte derived from the device otherwise */
+PRIVATE void vDeviceReadResponse ( tsHostDataReq*    psReq )
+{
+    uint8     au8Response[64];
+    uint16    u16Length =  0;
+    uint16    u16Attribute;
+    uint16    i;
+
+    au8Response[u16Length++] =  0x18;
+    au8Response[u16Length++] =  psReq->au8Payload[1];
+    au8Response[u16Length++] =  E_ZCL_READ_ATTRIBUTES_RESPONSE;
+    for ( i = 3; ( i + 1 ) < psReq->u16PayloadLength; i += 2 )
+    {
+        u16Attribute =  psReq->au8Payload[i] | ( psReq->au8Payload[i + 1] << 8 );
+        au8Response[u16Length++] =  psReq->au8Payload[i];
+        au8Response[u16Length++] =  psReq->au8Payload[i + 1];
+        au8Response[u16Length++] =  E_ZCL_CMDS_SUCCESS;
+        if ( ( psReq->u16ClusterId == 0x0000 ) &&
+             ( ( u16Attribute == 0x0004 ) || ( u16Attribute == 0x0005 ) || ( u16Attribute == 0x4000 ) ) )
+        {
+            au8Response[u16Length++] =  E_ZCL_CSTRING;
+            au8Response[u16Length++] =  4;
+            au8Response[u16Length++] =  'd';
+            au8Response[u16Length++] =  'e';
+            au8Response[u16Length++] =  'v';
+            au8Response[u16Length++] =  ( uint8 ) ( '0' + ( psReq->u16DstAddr - TEST_DEVICE_ADDR ) );
+        }
+        else
+        {
+            au8Response[u16Length++] =  E_ZCL_UINT8;
+            au8Response[u16Length++] =  ( uint8 ) ( psReq->u16DstAddr + u16Attribute );
+        }
+    }
+    HOST_vDataIndication ( psReq->u16DstAddr, psReq->u8DstEndpoint, psReq->u8SrcEndpoint,
+                           psReq->u16ClusterId, 0x0104, au8Response, u16Length );
+}
+
+/* Answers the coordinator's own interview: one endpoint with Basic */
+PRIVATE void vDeviceZdpResponse ( tsHostDataReq*    psReq )
+{
+    ZPS_tsAfZdpEvent    sEvent;
+
+    memset ( &sEvent, 0, sizeof ( sEvent ) );
+    sEvent.u8SequNumber =  psReq->au8Payload[0];
+    switch ( psReq->u16ClusterId )
+    {
+        case ZPS_ZDP_NODE_DESC_REQ_CLUSTER_ID:
+            sEvent.u16ClusterId =  ZPS_ZDP_NODE_DESC_RSP_CLUSTER_ID;
+            sEvent.uZdpData.sNodeDescRsp.sNodeDescriptor.u16ManufacturerCode =  0x1037;
+            break;
+
+        case ZPS_ZDP_ACTIVE_EP_REQ_CLUSTER_ID:
+            sEvent.u16ClusterId                          =  ZPS_ZDP_ACTIVE_EP_RSP_CLUSTER_ID;
+            sEvent.uZdpData.sActiveEpRsp.u8ActiveEpCount =  1;
+            sEvent.uLists.au8Data[0]                     =  TEST_ENDPOINT;
+            break;
+
+        case ZPS_ZDP_SIMPLE_DESC_REQ_CLUSTER_ID:
+        {
+            ZPS_tsAplZdpSimpleDescType*    psSimpleDesc =  &sEvent.uZdpData.sSimpleDescRsp.sSimpleDescriptor;
+
+            sEvent.u16ClusterId                     =  ZPS_ZDP_SIMPLE_DESC_RSP_CLUSTER_ID;
+            psSimpleDesc->u8Endpoint                =  TEST_ENDPOINT;
+            psSimpleDesc->u16ApplicationProfileId   =  0x0104;
+            psSimpleDesc->u8InClusterCount          =  1;
+            sEvent.uLists.au16Data[0]               =  0x0000;
+        }
+        break;
+
+        default:
+            return;
+    }
+    APP_vDeviceInterviewZdpResponse ( psReq->u16DstAddr, &sEvent );
+}
+
+/* Confirms and answers every request made since the last call */
+PRIVATE uint32 u32Answer ( void )
+{
+    tsHostDataReq*    psReq;
+    uint32            u32Sent =  0;
+
+    while ( u32TestAnswered < HOST_u32DataReqCount ( ) )
+    {
+        psReq =  HOST_psDataReq ( u32TestAnswered++ );
+        HOST_bDataConfirm ( psReq->u8ApsSeqNum, ZPS_E_SUCCESS );
+        if ( psReq->u16ProfileId == 0 )
+        {
+            vDeviceZdpResponse ( psReq );
+        }
+        else if ( psReq->au8Payload[2] == E_ZCL_READ_ATTRIBUTES )
+        {
+            vDeviceReadResponse ( psReq );
+        }
+        u32Sent++;
+        HOST_vRun ( 1 );
+    }
+    return u32Sent;
+}
+
+/* One read of an integration, returning the requests it put on air; the
+ * host gets a successful record of every attribute either way */
+PRIVATE uint32 u32HostRead ( uint16               u16Addr,
+                             const tsTestRead*    psRead )
+{
+    uint8                au8Payload[12 + 2 * 2];
+    tsHostSerialFrame    sFrame;
+    uint32               u32Sent;
+    uint16               u16Length =  0;
+    uint8                u8Records =  0;
+    uint8                i;
+
+    ZNC_BUF_U8_UPD  ( &au8Payload[ u16Length ], E_ZCL_AM_SHORT,          u16Length );
+    ZNC_BUF_U16_UPD ( &au8Payload[ u16Length ], u16Addr,                 u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Payload[ u16Length ], 1,                       u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Payload[ u16Length ], TEST_ENDPOINT,           u16Length );
+    ZNC_BUF_U16_UPD ( &au8Payload[ u16Length ], psRead->u16ClusterId,    u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Payload[ u16Length ], 0,                       u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Payload[ u16Length ], 0,                       u16Length );
+    ZNC_BUF_U16_UPD ( &au8Payload[ u16Length ], 0,                       u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Payload[ u16Length ], psRead->u8Attributes,    u16Length );
+    for ( i = 0; i < psRead->u8Attributes; i++ )
+    {
+        ZNC_BUF_U16_UPD ( &au8Payload[ u16Length ], psRead->au16Attributes[i],    u16Length );
+    }
+    HOST_vSerialFlush ( );
+    HOST_vSerialWrite ( E_SL_MSG_READ_ATTRIBUTE_REQUEST, u16Length, au8Payload );
+    HOST_vRun ( 5 );
+    u32Sent =  u32Answer ( );
+    HOST_vRun ( 5 );
+
+    while ( HOST_bSerialFind ( E_SL_MSG_READ_ATTRIBUTE_RESPONSE, &sFrame ) )
+    {
+        HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_RESPONSE_STATUS], E_ZCL_CMDS_SUCCESS );
+        u8Records++;
+    }
+    HOST_CHECK_EQUAL ( u8Records, psRead->u8Attributes );
+    return u32Sent;
+}
+
+/* A device resets and announces itself; the coordinator interviews it,
+ * answered until its result reaches the host */
+PRIVATE uint32 u32Announce ( uint16    u16Device )
+{
+    tsHostSerialFrame    sFrame;
+    uint16               u16Addr  =  TEST_DEVICE_ADDR + u16Device;
+    uint64               u64Ieee  =  TEST_DEVICE_IEEE_ADDR + u16Device;
+    uint8                au8Announce[12];
+    uint32               u32Sent  =  0;
+    uint16               u16Round;
+    uint8                i;
+
+    au8Announce[0] =  ( uint8 ) u16Device;
+    au8Announce[1] =  ( uint8 ) u16Addr;
+    au8Announce[2] =  ( uint8 ) ( u16Addr >> 8 );
+    for ( i = 0; i < 8; i++ )
+    {
+        au8Announce[3 + i] =  ( uint8 ) ( u64Ieee >> ( 8 * i ) );
+    }
+    au8Announce[11] =  TEST_CAPABILITY;
+    HOST_vSerialFlush ( );
+    HOST_vDataIndication ( u16Addr, 0, 0, ZPS_ZDP_DEVICE_ANNCE_REQ_CLUSTER_ID, 0, au8Announce, sizeof ( au8Announce ) );
+    for ( u16Round = 0;
+          ( u16Round < TEST_INTERVIEW_ROUNDS ) && !HOST_bSerialFind ( E_SL_MSG_DEVICE_INTERVIEW_RESULT, &sFrame );
+          u16Round++ )
+    {
+        HOST_vRun ( 10 );
+        u32Sent +=  u32Answer ( );
+    }
+    HOST_CHECK ( u16Round < TEST_INTERVIEW_ROUNDS );
+    HOST_vSerialFlush ( );
+    return u32Sent;
+}
+
+/* Moves the cache's clock only, the hours between starts would take too
+ * long to run through the main loop */
+PRIVATE void vTicks ( uint32    u32Ticks )
+{
+    while ( u32Ticks-- > 0 )
+    {
+        APP_vAttributeCacheTick ( );
+    }
+}
+
+PRIVATE void vSetRule ( uint8     u8Index,
+                        uint16    u16ClusterId,
+                        uint32    u32Ttl )
+{
+    uint8     au8Rule[ATTRIBUTE_CACHE_RULE_LENGTH];
+    uint16    u16Length =  0;
+
+    ZNC_BUF_U8_UPD  ( &au8Rule[ u16Length ], u8Index,         u16Length );
+    ZNC_BUF_U16_UPD ( &au8Rule[ u16Length ], u16ClusterId,    u16Length );
+    ZNC_BUF_U32_UPD ( &au8Rule[ u16Length ], u32Ttl,          u16Length );
+    HOST_CHECK_EQUAL ( APP_u8AttributeCacheSetRule ( au8Rule, u16Length ), E_SL_MSG_STATUS_SUCCESS );
+}
+
+/* Every integration interviews every device at each start; after every
+ * other start, one device resets and announces itself */
+PRIVATE void vInterviewRun ( teTestRules            eRules,
+                             tsTestInterviewRun*    psRun )
+{
+    uint16    u16Device;
+    uint8     u8Start;
+    uint8     u8Integration;
+    uint8     i;
+    uint8     r;
+
+    memset ( psRun, 0, sizeof ( tsTestInterviewRun ) );
+    HOST_vInit ( );
+    for ( i = 0; i < TEST_DEVICES; i++ )
+    {
+        HOST_vAddDevice ( TEST_DEVICE_ADDR + i, TEST_DEVICE_IEEE_ADDR + i, FALSE );
+    }
+    HOST_vRun ( 10 );
+    u32TestAnswered =  HOST_u32DataReqCount ( );
+
+    switch ( eRules )
+    {
+        case E_TEST_RULES_OFF:
+            vSetRule ( ATTRIBUTE_CACHE_CLEAR_ALL, 0, 0 );
+        break;
+
+        case E_TEST_RULES_STATE:
+            vSetRule ( 1, 0x0006, TEST_STATE_TTL );
+            vSetRule ( 2, 0x0008, TEST_STATE_TTL );
+        break;
+
+        default:
+        break;
+    }
+    APP_u16AttributeCacheGetStats ( psRun->au8Stats, TRUE );
+
+    for ( u8Start = 0; u8Start < TEST_STARTS; u8Start++ )
+    {
+        for ( u8Integration = 0; u8Integration < TEST_INTEGRATIONS; u8Integration++ )
+        {
+            for ( i = 0; i < TEST_DEVICES; i++ )
+            {
+                u16Device =  ( i + u8Integration * 3 ) % TEST_DEVICES;
+                for ( r = 0; r < sizeof ( asTestInterview ) / sizeof ( tsTestRead ); r++ )
+                {
+                    psRun->u32OnAir +=  u32HostRead ( TEST_DEVICE_ADDR + u16Device, &asTestInterview[r] );
+                    psRun->u32Reads++;
+                }
+                vTicks ( TEST_DEVICE_TICKS );
+            }
+        }
+        vTicks ( TEST_START_TICKS );
+        if ( ( u8Start + 1 < TEST_STARTS ) && ( ( u8Start % 2 ) == 0 ) )
+        {
+            psRun->u32Interview +=  u32Announce ( u8Start );
+        }
+    }
+    APP_u16AttributeCacheGetStats ( psRun->au8Stats, FALSE );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* The response sent from the cache carries the record the device sent,
+ * from the attribute identifier to the end of the value */
+PRIVATE void vReadServedFromCache ( void )
+{
+    tsHostSerialFrame    sAir;
+    tsHostSerialFrame    sCached;
+    uint32               u32DataReqs;
+
+    vStart ( );
+    HOST_vDataIndication ( TEST_ADDR, TEST_ENDPOINT, 1, TEST_CLUSTER, 0x0104,
+                           au8ModelResponse, sizeof ( au8ModelResponse ) );
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_READ_ATTRIBUTE_RESPONSE, &sAir ) );
+    HOST_CHECK ( sAir.bCrcOk );
+    HOST_CHECK_EQUAL ( sAir.au8Payload[TEST_RESPONSE_TYPE], E_ZCL_CSTRING );
+    HOST_CHECK_EQUAL ( ( sAir.au8Payload[TEST_RESPONSE_SIZE] << 8 ) | sAir.au8Payload[TEST_RESPONSE_SIZE + 1], 7 );
+    HOST_CHECK ( memcmp ( &sAir.au8Payload[TEST_RESPONSE_VALUE], "lumi.s1", 7 ) == 0 );
+
+    u32DataReqs =  HOST_u32DataReqCount ( );
+    vReadAttribute ( );
+    HOST_CHECK_EQUAL ( u8ReadRequestStatus ( ), ATTRIBUTE_CACHE_REQUEST_SERVED );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), u32DataReqs );
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_READ_ATTRIBUTE_RESPONSE, &sCached ) );
+    HOST_CHECK ( sCached.bCrcOk );
+    HOST_CHECK_EQUAL ( sCached.u16Length, sAir.u16Length );
+    HOST_CHECK_EQUAL ( ( sCached.au8Payload[TEST_RESPONSE_ATTRIBUTE] << 8 ) | sCached.au8Payload[TEST_RESPONSE_ATTRIBUTE + 1],
+                       TEST_ATTRIBUTE );
+    HOST_CHECK_EQUAL ( sCached.au8Payload[TEST_RESPONSE_STATUS], E_ZCL_CMDS_SUCCESS );
+    HOST_CHECK_EQUAL ( sCached.au8Payload[TEST_RESPONSE_TYPE], E_ZCL_CSTRING );
+    HOST_CHECK ( memcmp ( &sCached.au8Payload[TEST_RESPONSE_ATTRIBUTE], &sAir.au8Payload[TEST_RESPONSE_ATTRIBUTE],
+                          sAir.u16Length - TEST_RESPONSE_ATTRIBUTE ) == 0 );
+}
+
+/* A failed read is not kept, so the next read goes on air */
+PRIVATE void vFailedReadNotCached ( void )
+{
+    uint8     au8Unsupported[] = { 0x18, 0x22, 0x01, 0x05, 0x00, E_ZCL_CMDS_UNSUPPORTED_ATTRIBUTE };
+    uint32    u32DataReqs;
+
+    vStart ( );
+    HOST_vDataIndication ( TEST_ADDR, TEST_ENDPOINT, 1, TEST_CLUSTER, 0x0104,
+                           au8Unsupported, sizeof ( au8Unsupported ) );
+    HOST_vSerialFlush ( );
+    u32DataReqs =  HOST_u32DataReqCount ( );
+    vReadAttribute ( );
+    HOST_CHECK_EQUAL ( u8ReadRequestStatus ( ), TEST_REQUEST_SENT_ZCL );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), u32DataReqs + 1 );
+}
+
+/* The host writing to the cluster drops what the cache holds of it */
+PRIVATE void vInvalidatedByWrite ( void )
+{
+    uint32    u32DataReqs;
+
+    vStart ( );
+    HOST_vDataIndication ( TEST_ADDR, TEST_ENDPOINT, 1, TEST_CLUSTER, 0x0104,
+                           au8ModelResponse, sizeof ( au8ModelResponse ) );
+    APP_vAttributeCacheInvalidate ( TEST_ADDR, TEST_ENDPOINT, TEST_CLUSTER );
+    HOST_vSerialFlush ( );
+    u32DataReqs =  HOST_u32DataReqCount ( );
+    vReadAttribute ( );
+    HOST_CHECK_EQUAL ( u8ReadRequestStatus ( ), TEST_REQUEST_SENT_ZCL );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), u32DataReqs + 1 );
+}
+
+/* The start-up interview through the cache: radio transactions avoided
+ * for each rule set, every read still answered in full */
+PRIVATE void vStartupInterview ( void )
+{
+    tsTestInterviewRun    asRun[E_TEST_RULES_STATE + 1];
+    uint8                 i;
+
+    for ( i = E_TEST_RULES_OFF; i <= E_TEST_RULES_STATE; i++ )
+    {
+        vInterviewRun ( ( teTestRules ) i, &asRun[i] );
+        HOST_CHECK_EQUAL ( asRun[i].u32Reads, TEST_STARTS * TEST_INTEGRATIONS * TEST_DEVICES *
+                                              ( sizeof ( asTestInterview ) / sizeof ( tsTestRead ) ) );
+        HOST_CHECK_EQUAL ( asRun[i].u32OnAir + ZNC_RTN_U32 ( asRun[i].au8Stats, TEST_STATS_HITS ), asRun[i].u32Reads );
+        printf ( "  %-8s %4u host reads, %4u on air, %3u%% avoided, %2u for the coordinator's interviews,"
+                 " %2u held, %u evicted, %u invalidated\n",
+                 apcTestRules[i], ( unsigned ) asRun[i].u32Reads, ( unsigned ) asRun[i].u32OnAir,
+                 ( unsigned ) ( 100 * ( asRun[i].u32Reads - asRun[i].u32OnAir ) / asRun[i].u32Reads ),
+                 ( unsigned ) asRun[i].u32Interview,
+                 asRun[i].au8Stats[TEST_STATS_HELD],
+                 ( unsigned ) ZNC_RTN_U32 ( asRun[i].au8Stats, TEST_STATS_EVICTED ),
+                 ( unsigned ) ZNC_RTN_U32 ( asRun[i].au8Stats, TEST_STATS_INVALIDATED ) );
+    }
+    HOST_CHECK_EQUAL ( asRun[E_TEST_RULES_OFF].u32OnAir, asRun[E_TEST_RULES_OFF].u32Reads );
+    HOST_CHECK ( asRun[E_TEST_RULES_DEFAULT].u32OnAir * 2 < asRun[E_TEST_RULES_DEFAULT].u32Reads );
+    HOST_CHECK ( asRun[E_TEST_RULES_STATE].u32OnAir < asRun[E_TEST_RULES_DEFAULT].u32OnAir );
+    HOST_CHECK_EQUAL ( ZNC_RTN_U32 ( asRun[E_TEST_RULES_DEFAULT].au8Stats, TEST_STATS_EVICTED ), 0 );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vReadServedFromCache );
+    HOST_TEST ( vFailedReadNotCached );
+    HOST_TEST ( vInvalidatedByWrite );
+    HOST_TEST ( vStartupInterview );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,322 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_beacon_filter.c
+ *
+ * DESCRIPTION:        Beacon filter lists: 500 beacons per channel replayed
+ *                     through the stack's beacon handler, with the filter
+ *                     installed by app_beacon_filter.c, looked up in its
+ *                     hash table, and with the same filter registered
+ *                     directly, which the handler walks as it always did.
+ *                     Black and white list verdicts must agree beacon for
+ *                     beacon; the time each takes is reported.
+ ****************************************************************************
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include <time.h>
+#include "mac_sap.h"
+#include "appZpsBeaconHandler.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "app_beacon_filter.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_BEACONS                    BEACON_FILTER_BENCHMARK_BEACONS
+#define TEST_NETWORKS                   BEACON_FILTER_BENCHMARK_NETWORKS
+#define TEST_REPLAYS                    20
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint64    u64Ns;
+    uint32    u32Passed;
+    uint32    u32Mismatches;
+} tsTestReplay;
+
+/****************************************************************************/
+/***        Imported Variables                                            ***/
+/****************************************************************************/
+/* appZpsBeaconHandler.c */
+extern tsBeaconFilterType*    psBeaconFilter;
+extern uint64 zps_u64NwkLibFromPayload ( uint8*    pu8Buffer );
+extern PUBLIC bool_t ZPS_bAppPassBeaconToHigherLayer ( MAC_MlmeDcfmInd_s*    psBeaconIndication );
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE uint64                  au64TestEpid[BEACON_FILTER_MAX_EPIDS];
+PRIVATE uint8                   u8TestListSize;
+/* The same filter as the one installed, registered by the test itself */
+PRIVATE tsBeaconFilterType      sTestWalkFilter;
+PRIVATE MAC_MlmeDcfmInd_s       asTestBeacon[TEST_NETWORKS];
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE uint64 u64Ns ( void )
+{
+    struct timespec    sNow;
+
+    clock_gettime ( CLOCK_MONOTONIC, &sNow );
+    return ( ( uint64 ) sNow.tv_sec * 1000000000ULL ) + ( uint64 ) sNow.tv_nsec;
+}
+
+/* A ZigBee PRO beacon of one of the networks heard on a channel */
+PRIVATE uint64 u64Beacon ( MAC_MlmeDcfmInd_s*    psIndication,
+                           uint8                 u8Channel,
+                           uint8                 u8Network )
+{
+    MAC_MlmeIndBeacon_s*    psBeacon =  &psIndication->uParam.sIndBeacon;
+    uint32                  u32Seed  =  ( ( ( uint32 ) u8Channel << 8 ) | u8Network ) * 2654435761UL;
+    uint8                   i;
+
+    memset ( psIndication, 0, sizeof ( MAC_MlmeDcfmInd_s ) );
+    psBeacon->sPANdescriptor.sCoord.u16PanId    =  ( uint16 ) ( u32Seed >> 16 );
+    psBeacon->sPANdescriptor.u8LogicalChan      =  u8Channel;
+    psBeacon->sPANdescriptor.u8LinkQuality      =  ( uint8 ) ( 40 + ( u8Network * 37 ) % 200 );
+    psBeacon->sPANdescriptor.u16SuperframeSpec  =  ( u8Network & 1 ) ? BF_ASSOC_PERMIT_MASK : 0;
+    psBeacon->u8SDUlength                       =  15;
+    /* Protocol ID 0, ZigBee PRO stack profile, protocol version 2, router
+     * and end device capacity at depth 0 */
+    psBeacon->u8SDU[0]                          =  0x00;
+    psBeacon->u8SDU[1]                          =  0x22;
+    psBeacon->u8SDU[2]                          =  0x84;
+    for ( i = 0; i < sizeof ( uint64 ); i++ )
+    {
+        psBeacon->u8SDU[3 + i] =  ( uint8 ) ( u32Seed >> ( ( i & 3 ) * 8 ) ) ^ ( uint8 ) ( i * 0x5B );
+    }
+    memset ( &psBeacon->u8SDU[11], 0xFF, 4 );
+    return zps_u64NwkLibFromPayload ( BF_BCN_PL_EXT_PAN_ID_PTR ( psBeacon->u8SDU ) );
+}
+
+/* Lists u8Size networks, every third one not heard at all */
+PRIVATE void vList ( uint8    u8Size )
+{
+    MAC_MlmeDcfmInd_s    sIndication;
+    uint8                i;
+
+    u8TestListSize =  u8Size;
+    for ( i = 0; i < u8Size; i++ )
+    {
+        au64TestEpid[i] =  u64Beacon ( &sIndication,
+                                       BEACON_FILTER_FIRST_CHANNEL + ( i % BEACON_FILTER_CHANNELS ),
+                                       ( i % 3 == 2 ) ? ( uint8 ) ( TEST_NETWORKS + i ) : ( uint8 ) ( i % TEST_NETWORKS ) );
+    }
+}
+
+/* Installs the list through E_SL_MSG_BEACON_FILTER, which hashes it */
+PRIVATE void vInstall ( uint16    u16FilterMap,
+                        uint8     u8Lqi )
+{
+    uint8                au8Command[8 + BEACON_FILTER_MAX_EPIDS * sizeof ( uint64 )];
+    tsHostSerialFrame    sFrame;
+    uint16               u16Length =  0;
+    uint8                i;
+
+    ZNC_BUF_U8_UPD  ( &au8Command[ u16Length ], BEACON_FILTER_OP_SET,   u16Length );
+    ZNC_BUF_U16_UPD ( &au8Command[ u16Length ], u16FilterMap,           u16Length );
+    ZNC_BUF_U16_UPD ( &au8Command[ u16Length ], 0,                      u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Command[ u16Length ], u8Lqi,                  u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Command[ u16Length ], 0,                      u16Length );
+    ZNC_BUF_U8_UPD  ( &au8Command[ u16Length ], u8TestListSize,         u16Length );
+    for ( i = 0; i < u8TestListSize; i++ )
+    {
+        ZNC_BUF_U64_UPD ( &au8Command[ u16Length ], au64TestEpid[i],    u16Length );
+    }
+    HOST_vSerialFlush ( );
+    APP_vBeaconFilterCommand ( au8Command, u16Length );
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_BEACON_FILTER_RESPONSE, &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[1], BEACON_FILTER_STATUS_OK );
+
+    memset ( &sTestWalkFilter, 0, sizeof ( sTestWalkFilter ) );
+    sTestWalkFilter.u16FilterMap        =  u16FilterMap;
+    sTestWalkFilter.u8Lqi               =  u8Lqi;
+    sTestWalkFilter.u8ListSize          =  u8TestListSize;
+    sTestWalkFilter.pu64ExtendPanIdList =  au64TestEpid;
+}
+
+/* Whether the list holds the network, looked for one by one */
+PRIVATE bool_t bListed ( uint64    u64ExtendedPanId )
+{
+    uint8    i;
+
+    for ( i = 0; i < u8TestListSize; i++ )
+    {
+        if ( au64TestEpid[i] == u64ExtendedPanId )
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* Every channel's beacons through the handler with the filter it was
+ * given; with the walk, each verdict is also checked against the list */
+PRIVATE void vReplay ( bool_t           bWalk,
+                       uint16           u16FilterMap,
+                       uint8            u8Lqi,
+                       tsTestReplay*    psReplay )
+{
+    uint64                u64Start;
+    uint64                u64Epid;
+    bool_t                bExpected;
+    bool_t                bPassed;
+    uint16                n;
+    uint8                 u8Channel;
+
+    memset ( psReplay, 0, sizeof ( tsTestReplay ) );
+    vInstall ( u16FilterMap, u8Lqi );
+    if ( bWalk )
+    {
+        ZPS_bAppAddBeaconFilter ( &sTestWalkFilter );
+    }
+
+    for ( u8Channel = BEACON_FILTER_FIRST_CHANNEL; u8Channel < ( BEACON_FILTER_FIRST_CHANNEL + BEACON_FILTER_CHANNELS ); u8Channel++ )
+    {
+        for ( n = 0; n < TEST_NETWORKS; n++ )
+        {
+            u64Epid   =  u64Beacon ( &asTestBeacon[n], u8Channel, ( uint8 ) n );
+            bExpected =  ( bListed ( u64Epid ) == ( ( u16FilterMap & BF_BITMAP_WHITELIST ) != 0 ) ) &&
+                         ( ( ( u16FilterMap & BF_BITMAP_LQI ) == 0 ) ||
+                           ( asTestBeacon[n].uParam.sIndBeacon.sPANdescriptor.u8LinkQuality >= u8Lqi ) );
+            if ( ZPS_bAppPassBeaconToHigherLayer ( &asTestBeacon[n] ) != bExpected )
+            {
+                psReplay->u32Mismatches++;
+            }
+        }
+
+        u64Start =  u64Ns ( );
+        for ( n = 0; n < TEST_BEACONS; n++ )
+        {
+            bPassed =  ZPS_bAppPassBeaconToHigherLayer ( &asTestBeacon[n % TEST_NETWORKS] );
+            psReplay->u32Passed +=  bPassed;
+        }
+        psReplay->u64Ns +=  u64Ns ( ) - u64Start;
+    }
+}
+
+PRIVATE void vCompare ( const char*    pcName,
+                        uint16         u16FilterMap,
+                        uint8          u8Lqi )
+{
+    tsTestReplay    sTable;
+    tsTestReplay    sWalk;
+    uint64          u64TableNs =  0;
+    uint64          u64WalkNs  =  0;
+    uint8           i;
+
+    for ( i = 0; i < TEST_REPLAYS; i++ )
+    {
+        vReplay ( FALSE, u16FilterMap, u8Lqi, &sTable );
+        vReplay ( TRUE, u16FilterMap, u8Lqi, &sWalk );
+        u64TableNs +=  sTable.u64Ns;
+        u64WalkNs  +=  sWalk.u64Ns;
+        HOST_CHECK_EQUAL ( sTable.u32Mismatches, 0 );
+        HOST_CHECK_EQUAL ( sWalk.u32Mismatches, 0 );
+        HOST_CHECK_EQUAL ( sTable.u32Passed, sWalk.u32Passed );
+    }
+    HOST_CHECK ( sTable.u32Passed > 0 );
+    HOST_CHECK ( sTable.u32Passed < BEACON_FILTER_CHANNELS * TEST_BEACONS );
+
+    printf ( "  %s, %2u listed: %5u of %u passed, table %4u ns, list walk %4u ns per beacon\n",
+             pcName, u8TestListSize, ( unsigned ) sTable.u32Passed, BEACON_FILTER_CHANNELS * TEST_BEACONS,
+             ( unsigned ) ( u64TableNs / ( ( uint64 ) TEST_REPLAYS * BEACON_FILTER_CHANNELS * TEST_BEACONS ) ),
+             ( unsigned ) ( u64WalkNs / ( ( uint64 ) TEST_REPLAYS * BEACON_FILTER_CHANNELS * TEST_BEACONS ) ) );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* The installed filter is the one the handler looks up; another filter is
+ * left to the walk */
+PRIVATE void vLookupOnlyForInstalled ( void )
+{
+    bool_t    bIsListed;
+
+    HOST_vInit ( );
+    vList ( 4 );
+    vInstall ( BF_BITMAP_BLACKLIST, 0 );
+    HOST_CHECK ( psBeaconFilter != NULL );
+    HOST_CHECK ( APP_bBeaconFilterListed ( psBeaconFilter, au64TestEpid[1], &bIsListed ) );
+    HOST_CHECK ( bIsListed );
+    HOST_CHECK ( APP_bBeaconFilterListed ( psBeaconFilter, au64TestEpid[1] + 1, &bIsListed ) );
+    HOST_CHECK ( !bIsListed );
+    HOST_CHECK ( !APP_bBeaconFilterListed ( &sTestWalkFilter, au64TestEpid[1], &bIsListed ) );
+}
+
+PRIVATE void vBlackList ( void )
+{
+    HOST_vInit ( );
+    vList ( 1 );
+    vCompare ( "black list", BF_BITMAP_BLACKLIST, 0 );
+    vList ( 8 );
+    vCompare ( "black list", BF_BITMAP_BLACKLIST, 0 );
+    vList ( BEACON_FILTER_MAX_EPIDS );
+    vCompare ( "black list", BF_BITMAP_BLACKLIST, 0 );
+    vCompare ( "black list and LQI", BF_BITMAP_BLACKLIST | BF_BITMAP_LQI, 60 );
+}
+
+PRIVATE void vWhiteList ( void )
+{
+    HOST_vInit ( );
+    vList ( 1 );
+    vCompare ( "white list", BF_BITMAP_WHITELIST, 0 );
+    vList ( 8 );
+    vCompare ( "white list", BF_BITMAP_WHITELIST, 0 );
+    vList ( BEACON_FILTER_MAX_EPIDS );
+    vCompare ( "white list", BF_BITMAP_WHITELIST, 0 );
+    vCompare ( "white list and LQI", BF_BITMAP_WHITELIST | BF_BITMAP_LQI, 60 );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vLookupOnlyForInstalled );
+    HOST_TEST ( vBlackList );
+    HOST_TEST ( vWhiteList );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
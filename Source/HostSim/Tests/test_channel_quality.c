@@ -0,0 +1,330 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_channel_quality.c
+ *
+ * DESCRIPTION:        Channel ranking through E_SL_MSG_CHANNEL_QUALITY:
+ *                     how ties are broken, the margin CHANGE needs before
+ *                     it moves the network, the halving of the frame
+ *                     counters at CHANNEL_QUALITY_COUNTER_LIMIT and the
+ *                     narrowing of a formation channel mask. Energy scans
+ *                     and data confirms are fed straight to
+ *                     app_channel_quality.c.
+ ****************************************************************************
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zps_apl_af.h"
+#include "zps_apl_zdo.h"
+#include "zps_apl_zdp.h"
+#include "zps_nwk_nib.h"
+#include "bdb_api.h"
+#include "app_common.h"
+#include "SerialLink.h"
+#include "app_channel_quality.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_CURRENT_CHANNEL            15
+#define TEST_OTHER_CHANNEL              20
+#define TEST_CHANNEL( CHANNEL )         ( 1UL << ( CHANNEL ) )
+
+/* E_SL_MSG_CHANNEL_QUALITY_RESPONSE report layout */
+#define TEST_REPORT_CURRENT             2
+#define TEST_REPORT_BEST                3
+#define TEST_REPORT_CURRENT_DELIVERY    4
+#define TEST_REPORT_BEST_DELIVERY       6
+#define TEST_REPORT_CHANNELS            9
+#define TEST_REPORT_CHANNEL_SIZE        11
+#define TEST_REPORT_SENT                3
+#define TEST_REPORT_NO_ACK              5
+#define TEST_REPORT_BUSY                7
+#define TEST_REPORT_DELIVERY            9
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsHostSerialFrame    sTestReport;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* Runs an operation, returning the status of its response */
+PRIVATE uint8 u8Command ( uint8     u8Operation,
+                          uint8     u8Channel,
+                          uint32    u32ChannelMask )
+{
+    uint8                au8Command[6];
+    tsHostSerialFrame    sFrame;
+    uint16               u16Length =  0;
+
+    ZNC_BUF_U8_UPD  ( &au8Command[ u16Length ], u8Operation,       u16Length );
+    if ( u8Operation == CHANNEL_QUALITY_OP_CHANGE )
+    {
+        ZNC_BUF_U8_UPD  ( &au8Command[ u16Length ], u8Channel,     u16Length );
+    }
+    ZNC_BUF_U32_UPD ( &au8Command[ u16Length ], u32ChannelMask,    u16Length );
+    HOST_vSerialFlush ( );
+    APP_vChannelQualityCommand ( au8Command, u16Length );
+    if ( !HOST_bSerialFind ( E_SL_MSG_CHANNEL_QUALITY_RESPONSE, &sFrame ) )
+    {
+        return 0xFF;
+    }
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[0], u8Operation );
+    if ( u8Operation == CHANNEL_QUALITY_OP_REPORT )
+    {
+        memcpy ( &sTestReport, &sFrame, sizeof ( sTestReport ) );
+    }
+    return sFrame.au8Payload[1];
+}
+
+/* Best ranked channel in a mask, as reported */
+PRIVATE uint8 u8Best ( uint32    u32ChannelMask )
+{
+    HOST_CHECK_EQUAL ( u8Command ( CHANNEL_QUALITY_OP_REPORT, 0, u32ChannelMask ), CHANNEL_QUALITY_STATUS_OK );
+    return sTestReport.au8Payload[TEST_REPORT_BEST];
+}
+
+/* A u16 of a channel in the last report */
+PRIVATE uint16 u16Reported ( uint8    u8Channel,
+                             uint8    u8Field )
+{
+    return ZNC_RTN_U16 ( sTestReport.au8Payload,
+                         TEST_REPORT_CHANNELS +
+                         ( u8Channel - CHANNEL_QUALITY_FIRST_CHANNEL ) * TEST_REPORT_CHANNEL_SIZE +
+                         u8Field );
+}
+
+/* Forgets every channel and puts the network on TEST_CURRENT_CHANNEL */
+PRIVATE void vReset ( void )
+{
+    HOST_vInit ( );
+    ZPS_vNwkNibSetChannel ( ZPS_pvAplZdoGetNwkHandle ( ), TEST_CURRENT_CHANNEL );
+    HOST_CHECK_EQUAL ( u8Command ( CHANNEL_QUALITY_OP_RESET, 0, 0 ), CHANNEL_QUALITY_STATUS_OK );
+}
+
+/* Reports the same energy on every channel of a mask */
+PRIVATE void vEnergy ( uint32    u32ChannelMask,
+                       uint8     u8Energy )
+{
+    uint8    au8Energy[CHANNEL_QUALITY_CHANNELS];
+
+    memset ( au8Energy, u8Energy, sizeof ( au8Energy ) );
+    APP_vChannelQualityEnergyScan ( u32ChannelMask, CHANNEL_QUALITY_CHANNELS, au8Energy );
+}
+
+/* Confirms a unicast frame on the current channel */
+PRIVATE void vConfirm ( uint16    u16DstAddr,
+                        uint8     u8Status )
+{
+    ZPS_tsAfDataConfEvent    sConfirm;
+
+    memset ( &sConfirm, 0, sizeof ( sConfirm ) );
+    sConfirm.u8DstAddrMode     =  ZPS_E_ADDR_MODE_SHORT;
+    sConfirm.uDstAddr.u16Addr  =  u16DstAddr;
+    sConfirm.u8Status          =  u8Status;
+    APP_vChannelQualityDataConfirm ( &sConfirm );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* Equal delivery goes to the channel the network is on, then to the lower
+ * channel; only strictly better delivery moves the pick */
+PRIVATE void vBestTieBreak ( void )
+{
+    vReset ( );
+    vEnergy ( CHANNEL_QUALITY_ALL_CHANNELS, 0x40 );
+
+    HOST_CHECK_EQUAL ( u8Best ( CHANNEL_QUALITY_ALL_CHANNELS ), TEST_CURRENT_CHANNEL );
+    HOST_CHECK_EQUAL ( ZNC_RTN_U16 ( sTestReport.au8Payload, TEST_REPORT_CURRENT_DELIVERY ),
+                       ZNC_RTN_U16 ( sTestReport.au8Payload, TEST_REPORT_BEST_DELIVERY ) );
+    HOST_CHECK_EQUAL ( u8Best ( TEST_CHANNEL ( 11 ) | TEST_CHANNEL ( TEST_CURRENT_CHANNEL ) ), TEST_CURRENT_CHANNEL );
+    HOST_CHECK_EQUAL ( u8Best ( TEST_CHANNEL ( 12 ) | TEST_CHANNEL ( TEST_OTHER_CHANNEL ) ), 12 );
+    HOST_CHECK_EQUAL ( u8Best ( TEST_CHANNEL ( 26 ) | TEST_CHANNEL ( TEST_OTHER_CHANNEL ) ), TEST_OTHER_CHANNEL );
+
+    ZPS_vNwkNibSetChannel ( ZPS_pvAplZdoGetNwkHandle ( ), TEST_OTHER_CHANNEL );
+    HOST_CHECK_EQUAL ( u8Best ( CHANNEL_QUALITY_ALL_CHANNELS ), TEST_OTHER_CHANNEL );
+    HOST_CHECK_EQUAL ( sTestReport.au8Payload[TEST_REPORT_CURRENT], TEST_OTHER_CHANNEL );
+    ZPS_vNwkNibSetChannel ( ZPS_pvAplZdoGetNwkHandle ( ), TEST_CURRENT_CHANNEL );
+
+    /* A second, quieter scan of a higher channel makes it strictly better */
+    vEnergy ( TEST_CHANNEL ( 25 ), 0 );
+    HOST_CHECK_EQUAL ( u8Best ( CHANNEL_QUALITY_ALL_CHANNELS ), 25 );
+    HOST_CHECK ( ZNC_RTN_U16 ( sTestReport.au8Payload, TEST_REPORT_BEST_DELIVERY ) >
+                 ZNC_RTN_U16 ( sTestReport.au8Payload, TEST_REPORT_CURRENT_DELIVERY ) );
+    HOST_CHECK_EQUAL ( u8Best ( CHANNEL_QUALITY_ALL_CHANNELS & ~TEST_CHANNEL ( 25 ) ), TEST_CURRENT_CHANNEL );
+}
+
+/* CHANGE to the best channel needs CHANNEL_QUALITY_CHANGE_MARGIN better
+ * delivery: 1000 against 950 moves the network, against 951 it does not */
+PRIVATE void vChangeMargin ( void )
+{
+    uint32    u32Mask =  TEST_CHANNEL ( TEST_CURRENT_CHANNEL ) | TEST_CHANNEL ( TEST_OTHER_CHANNEL );
+    uint32    u32Requests;
+    uint8     i;
+
+    vReset ( );
+    vEnergy ( u32Mask, 0 );
+    HOST_CHECK_EQUAL ( u8Command ( CHANNEL_QUALITY_OP_CHANGE, 0, u32Mask ), CHANNEL_QUALITY_STATUS_NO_BETTER );
+
+    /* 20 frames, 2 lost: ( 18 * 1000 + 1000 * 20 ) / 40 */
+    for ( i = 0; i < 20; i++ )
+    {
+        vConfirm ( 0x1234, ( i < 2 ) ? ZPS_APL_APS_E_NO_ACK : ZPS_E_SUCCESS );
+    }
+    HOST_CHECK_EQUAL ( u8Best ( u32Mask ), TEST_OTHER_CHANNEL );
+    HOST_CHECK_EQUAL ( ZNC_RTN_U16 ( sTestReport.au8Payload, TEST_REPORT_CURRENT_DELIVERY ), 950 );
+    HOST_CHECK_EQUAL ( ZNC_RTN_U16 ( sTestReport.au8Payload, TEST_REPORT_BEST_DELIVERY ), 950 + CHANNEL_QUALITY_CHANGE_MARGIN );
+
+    u32Requests =  HOST_u32DataReqCount ( );
+    HOST_CHECK_EQUAL ( u8Command ( CHANNEL_QUALITY_OP_CHANGE, 0, u32Mask ), CHANNEL_QUALITY_STATUS_OK );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), u32Requests + 1 );
+    HOST_CHECK_EQUAL ( HOST_psDataReq ( u32Requests )->u16ClusterId, ZPS_ZDP_MGMT_NWK_UPDATE_REQ_CLUSTER_ID );
+    HOST_CHECK_EQUAL ( HOST_psDataReq ( u32Requests )->u16DstAddr, 0xFFFD );
+
+    /* One more delivered frame: ( 19 * 1000 + 1000 * 20 ) / 41 */
+    vConfirm ( 0x1234, ZPS_E_SUCCESS );
+    HOST_CHECK_EQUAL ( u8Best ( u32Mask ), TEST_OTHER_CHANNEL );
+    HOST_CHECK_EQUAL ( ZNC_RTN_U16 ( sTestReport.au8Payload, TEST_REPORT_CURRENT_DELIVERY ), 951 );
+    u32Requests =  HOST_u32DataReqCount ( );
+    HOST_CHECK_EQUAL ( u8Command ( CHANNEL_QUALITY_OP_CHANGE, 0, u32Mask ), CHANNEL_QUALITY_STATUS_NO_BETTER );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), u32Requests );
+
+    /* A named channel is not held to the margin, but needs a network */
+    HOST_CHECK_EQUAL ( u8Command ( CHANNEL_QUALITY_OP_CHANGE, 12, 0 ), CHANNEL_QUALITY_STATUS_OK );
+    sBDB.sAttrib.bbdbNodeIsOnANetwork =  FALSE;
+    HOST_CHECK_EQUAL ( u8Command ( CHANNEL_QUALITY_OP_CHANGE, 12, 0 ), CHANNEL_QUALITY_STATUS_NO_NETWORK );
+    sBDB.sAttrib.bbdbNodeIsOnANetwork =  TRUE;
+}
+
+/* Reaching CHANNEL_QUALITY_COUNTER_LIMIT frames halves all three counters
+ * together, so the delivery ratio survives the ageing */
+PRIVATE void vCounterHalving ( void )
+{
+    uint16    u16NoAck =  0;
+    uint16    u16Busy  =  0;
+    uint16    u16Delivery;
+    uint16    i;
+
+    vReset ( );
+    for ( i = 0; i < CHANNEL_QUALITY_COUNTER_LIMIT - 1; i++ )
+    {
+        switch ( i % 8 )
+        {
+            case 0:
+                vConfirm ( 0x1234, 0xE9 );
+                u16NoAck++;
+            break;
+
+            case 1:
+                vConfirm ( 0x1234, ZPS_APL_APS_E_NO_ACK );
+                u16NoAck++;
+            break;
+
+            case 2:
+                vConfirm ( 0x1234, 0xE1 );
+                u16Busy++;
+            break;
+
+            default:
+                vConfirm ( 0x1234, ZPS_E_SUCCESS );
+            break;
+        }
+    }
+    /* Neither broadcasts nor other failures say anything of the channel */
+    vConfirm ( 0xFFFD, ZPS_E_SUCCESS );
+    vConfirm ( 0x1234, ZPS_NWK_ENUM_ROUTE_ERROR );
+
+    HOST_CHECK_EQUAL ( u8Best ( CHANNEL_QUALITY_ALL_CHANNELS ), TEST_CURRENT_CHANNEL );
+    HOST_CHECK_EQUAL ( u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_SENT ), CHANNEL_QUALITY_COUNTER_LIMIT - 1 );
+    HOST_CHECK_EQUAL ( u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_NO_ACK ), u16NoAck );
+    HOST_CHECK_EQUAL ( u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_BUSY ), u16Busy );
+    u16Delivery =  u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_DELIVERY );
+
+    vConfirm ( 0x1234, ZPS_E_SUCCESS );
+    HOST_CHECK_EQUAL ( u8Best ( CHANNEL_QUALITY_ALL_CHANNELS ), TEST_CURRENT_CHANNEL );
+    HOST_CHECK_EQUAL ( u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_SENT ), CHANNEL_QUALITY_COUNTER_LIMIT >> 1 );
+    HOST_CHECK_EQUAL ( u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_NO_ACK ), u16NoAck >> 1 );
+    HOST_CHECK_EQUAL ( u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_BUSY ), u16Busy >> 1 );
+    HOST_CHECK ( u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_DELIVERY ) + 1 >= u16Delivery );
+    HOST_CHECK ( u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_DELIVERY ) <= u16Delivery + 1 );
+    printf ( "  %u frames, %u lost, %u busy: delivery %u per mille, halved to %u, %u, %u: %u per mille\n",
+             CHANNEL_QUALITY_COUNTER_LIMIT, u16NoAck, u16Busy, u16Delivery,
+             u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_SENT ),
+             u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_NO_ACK ),
+             u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_BUSY ),
+             u16Reported ( TEST_CURRENT_CHANNEL, TEST_REPORT_DELIVERY ) );
+}
+
+/* Formation keeps its mask until a channel in it has history, and is then
+ * narrowed to the best ranked channel of the mask */
+PRIVATE void vPreferredMask ( void )
+{
+    uint32    u32Mask =  TEST_CHANNEL ( 11 ) | TEST_CHANNEL ( TEST_CURRENT_CHANNEL ) | TEST_CHANNEL ( TEST_OTHER_CHANNEL );
+
+    vReset ( );
+    HOST_CHECK_EQUAL ( APP_u32ChannelQualityPreferred ( u32Mask ), u32Mask );
+    HOST_CHECK_EQUAL ( APP_u32ChannelQualityPreferred ( CHANNEL_QUALITY_ALL_CHANNELS ), CHANNEL_QUALITY_ALL_CHANNELS );
+
+    vEnergy ( TEST_CHANNEL ( TEST_OTHER_CHANNEL ), 0 );
+    HOST_CHECK_EQUAL ( APP_u32ChannelQualityPreferred ( u32Mask ), TEST_CHANNEL ( TEST_OTHER_CHANNEL ) );
+    HOST_CHECK_EQUAL ( APP_u32ChannelQualityPreferred ( TEST_CHANNEL ( 25 ) | TEST_CHANNEL ( 26 ) ),
+                       TEST_CHANNEL ( 25 ) | TEST_CHANNEL ( 26 ) );
+
+    /* A loud scan of channel 11 is history too, but ranks below the rest */
+    vEnergy ( TEST_CHANNEL ( 11 ), 0xFF );
+    HOST_CHECK_EQUAL ( APP_u32ChannelQualityPreferred ( TEST_CHANNEL ( 11 ) | TEST_CHANNEL ( 12 ) ), TEST_CHANNEL ( 12 ) );
+    HOST_CHECK_EQUAL ( APP_u32ChannelQualityPreferred ( u32Mask ), TEST_CHANNEL ( TEST_OTHER_CHANNEL ) );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vBestTieBreak );
+    HOST_TEST ( vChangeMargin );
+    HOST_TEST ( vCounterHalving );
+    HOST_TEST ( vPreferredMask );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
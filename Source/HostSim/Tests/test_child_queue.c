@@ -0,0 +1,510 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_child_queue.c
+ *
+ * DESCRIPTION:        Commands held for a sleepy child: one at the parent
+ *                     at a time, whether released straight to the stack or
+ *                     through the APS queue, the next one released only by
+ *                     the confirm of the frame of the one before, a frame
+ *                     the parent dropped handed to it again, and a command
+ *                     whose confirm never comes reported expired. Then
+ *                     sleepy children polling every 1s to 5min, this node
+ *                     their parent, taking commands from a host over half
+ *                     an hour: how many are delivered and how many expire,
+ *                     per poll interval, with the default and a long
+ *                     expiry.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stdio.h>
+#include <string.h>
+#include "zcl.h"
+#include "SerialLink.h"
+#include "app_aps_queue.h"
+#include "app_child_queue.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_CHILD                      0x5000
+#define TEST_CHILD_IEEE_ADDR            0x00158D0000500000ULL
+#define TEST_ROUTER                     0x2000
+
+/* Status of a frame the parent dropped, the child not having polled */
+#define TEST_TRANSACTION_EXPIRED        0xF0
+
+/* Offsets into the E_SL_MSG_CHILD_QUEUE_STATS payload */
+#define TEST_STATS_HELD                 5
+#define TEST_STATS_DELIVERED            9
+#define TEST_STATS_EXPIRED              13
+#define TEST_STATS_REARMED              21
+#define TEST_STATS_FULL                 25
+#define TEST_STATS_CHILDREN             4
+#define TEST_STATS_HEADER               29
+
+/* Offsets into each child of the E_SL_MSG_CHILD_QUEUE_STATS payload */
+#define TEST_STATS_CHILD_ADDR           0
+#define TEST_STATS_CHILD_DELIVERED      3
+#define TEST_STATS_CHILD_EXPIRED        5
+#define TEST_STATS_CHILD_COALESCED      7
+#define TEST_STATS_CHILD_REARMED        9
+#define TEST_STATS_CHILD_LATENCY_MEAN   11
+#define TEST_STATS_CHILD_LATENCY_MAX    13
+#define TEST_STATS_CHILD                15
+
+/* Status of a frame the child polled for but never acknowledged */
+#define TEST_MAC_NO_ACK                 0xE9
+
+/* Mixed poll rates: children per poll interval, the host's commands to
+ * each, a third of them repeating the previous one, and the parent */
+#define TEST_MIXED_ADDR                 0x6000
+#define TEST_MIXED_IEEE_ADDR            0x00158D0000600000ULL
+#define TEST_MIXED_PER_CLASS            2
+#define TEST_MIXED_CLASSES              5
+#define TEST_MIXED_CHILDREN             ( TEST_MIXED_PER_CLASS * TEST_MIXED_CLASSES )
+#define TEST_MIXED_DURATION_MS          1800000
+#define TEST_MIXED_GAP_MIN_MS           30000
+#define TEST_MIXED_GAP_MAX_MS           150000
+#define TEST_MIXED_REPEAT               333         /* per 1000 commands */
+#define TEST_MIXED_LOSS                 20          /* per 1000 frames handed over */
+#define TEST_MIXED_STEP_MS              10
+#define TEST_INDIRECT_HOLD_MS           7680
+#define TEST_FAST_POLL_MS               250
+#define TEST_FAST_POLL_WINDOW_MS        1000
+#define TEST_LONG_EXPIRY                600
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint32    u32PollMs;
+    uint32    u32NextPollMs;
+    uint32    u32FastUntilMs;
+    uint32    u32NextCommandMs;
+    uint32    u32SentMs;                /* when the frame at the parent was handed over */
+    uint32    u32Random;                /* the child's own commands, the same whatever the expiry */
+    uint16    u16Addr;
+    uint16    u16Commands;
+    uint8     u8ApsSeqNum;
+    uint8     u8Command;
+    bool_t    bAtParent;
+} tsTestChild;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE const uint32    au32TestPollMs[TEST_MIXED_CLASSES] =  { 1000, 5000, 30000, 60000, 300000 };
+PRIVATE tsTestChild     asTestChildren[TEST_MIXED_CHILDREN];
+PRIVATE uint32          u32TestRandom;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE void vStart ( void )
+{
+    HOST_vInit ( );
+    HOST_vAddDevice ( TEST_CHILD, TEST_CHILD_IEEE_ADDR, TRUE );
+    HOST_vRun ( 10 );
+    HOST_vSerialFlush ( );
+}
+
+PRIVATE void vSendOnOff ( uint16    u16Addr,
+                          uint8     u8Command )
+{
+    uint8    au8Payload[6];
+
+    au8Payload[0] =  E_ZCL_AM_SHORT;
+    au8Payload[1] =  ( uint8 ) ( u16Addr >> 8 );
+    au8Payload[2] =  ( uint8 ) u16Addr;
+    au8Payload[3] =  1;
+    au8Payload[4] =  1;
+    au8Payload[5] =  u8Command;
+    HOST_vSerialWrite ( E_SL_MSG_ONOFF_NOEFFECTS, sizeof ( au8Payload ), au8Payload );
+    HOST_vRun ( 5 );
+}
+
+/* A confirm of another frame to the child, as a ZDP request the host sent
+ * it directly would get */
+PRIVATE void vForeignConfirm ( uint8    u8ApsSeqNum )
+{
+    ZPS_tsAfEvent    sStackEvent;
+
+    memset ( &sStackEvent, 0, sizeof ( sStackEvent ) );
+    sStackEvent.eType                                         =  ZPS_EVENT_APS_DATA_CONFIRM;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8SrcEndpoint     =  1;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8DstEndpoint     =  1;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8DstAddrMode     =  ZPS_E_ADDR_MODE_SHORT;
+    sStackEvent.uEvent.sApsDataConfirmEvent.uDstAddr.u16Addr  =  TEST_CHILD;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8SequenceNum     =  u8ApsSeqNum;
+    sStackEvent.uEvent.sApsDataConfirmEvent.u8Status          =  ZPS_E_SUCCESS;
+    HOST_vStackEvent ( 1, &sStackEvent );
+    HOST_vRun ( 5 );
+}
+
+PRIVATE uint32 u32Stat ( uint8    u8Offset )
+{
+    uint8    au8Stats[64];
+
+    APP_u16ChildQueueGetStats ( au8Stats, sizeof ( au8Stats ), FALSE );
+    return ( ( uint32 ) au8Stats[u8Offset] << 24 ) | ( ( uint32 ) au8Stats[u8Offset + 1] << 16 ) |
+           ( ( uint32 ) au8Stats[u8Offset + 2] << 8 ) | au8Stats[u8Offset + 3];
+}
+
+PRIVATE uint32 u32Between ( uint32*    pu32Random,
+                            uint32     u32Min,
+                            uint32     u32Max )
+{
+    *pu32Random =  *pu32Random * 1103515245UL + 12345UL;
+    return u32Min + ( ( *pu32Random >> 8 ) % ( u32Max - u32Min + 1 ) );
+}
+
+/* The child's poll after u32NowMs: every 250ms for a second after it took
+ * a frame, else on its own interval */
+PRIVATE void vNextPoll ( tsTestChild*    psChild,
+                         uint32          u32NowMs )
+{
+    if ( u32NowMs < psChild->u32FastUntilMs )
+    {
+        psChild->u32NextPollMs =  u32NowMs + TEST_FAST_POLL_MS;
+    }
+    else
+    {
+        psChild->u32NextPollMs +=  psChild->u32PollMs;
+        if ( psChild->u32NextPollMs <= u32NowMs )
+        {
+            psChild->u32NextPollMs =  u32NowMs + psChild->u32PollMs;
+        }
+    }
+}
+
+/* Plays the parent: takes each frame for a child into its indirect queue,
+ * hands it over on the child's poll, or drops it after 7.68s */
+PRIVATE void vParent ( uint32*    pu32Seen )
+{
+    tsHostDataReq*    psReq;
+    tsTestChild*      psChild;
+    uint32            u32NowMs =  HOST_u32TimeMs ( );
+    uint8             i;
+
+    for ( ; *pu32Seen < HOST_u32DataReqCount ( ); ( *pu32Seen )++ )
+    {
+        psReq =  HOST_psDataReq ( *pu32Seen );
+        for ( i = 0; i < TEST_MIXED_CHILDREN; i++ )
+        {
+            psChild =  &asTestChildren[i];
+            if ( psChild->u16Addr == psReq->u16DstAddr )
+            {
+                /* One command at the parent per child at any time */
+                HOST_CHECK ( !psChild->bAtParent );
+                psChild->bAtParent      =  TRUE;
+                psChild->u8ApsSeqNum    =  psReq->u8ApsSeqNum;
+                psChild->u32SentMs      =  u32NowMs;
+            }
+        }
+    }
+
+    for ( i = 0; i < TEST_MIXED_CHILDREN; i++ )
+    {
+        psChild =  &asTestChildren[i];
+        if ( psChild->u32NextPollMs <= u32NowMs )
+        {
+            if ( psChild->bAtParent )
+            {
+                psChild->bAtParent =  FALSE;
+                if ( u32Between ( &u32TestRandom, 0, 999 ) < TEST_MIXED_LOSS )
+                {
+                    HOST_bDataConfirm ( psChild->u8ApsSeqNum, TEST_MAC_NO_ACK );
+                }
+                else
+                {
+                    psChild->u32FastUntilMs =  u32NowMs + TEST_FAST_POLL_WINDOW_MS;
+                    HOST_bDataConfirm ( psChild->u8ApsSeqNum, ZPS_E_SUCCESS );
+                }
+            }
+            vNextPoll ( psChild, u32NowMs );
+        }
+        if ( psChild->bAtParent && ( ( u32NowMs - psChild->u32SentMs ) >= TEST_INDIRECT_HOLD_MS ) )
+        {
+            psChild->bAtParent =  FALSE;
+            HOST_bDataConfirm ( psChild->u8ApsSeqNum, TEST_TRANSACTION_EXPIRED );
+        }
+    }
+}
+
+/* Half an hour of host commands to children of every poll interval with
+ * the given expiry, then long enough for all of them to settle */
+PRIVATE void vMixedRun ( uint16    u16Expiry )
+{
+    tsTestChild*    psChild;
+    uint32          u32EndMs;
+    uint32          u32Seen =  0;
+    uint8           au8Expiry[2];
+    uint8           au8Payload[6];
+    uint8           i;
+
+    HOST_vInit ( );
+    au8Expiry[0] =  ( uint8 ) ( u16Expiry >> 8 );
+    au8Expiry[1] =  ( uint8 ) u16Expiry;
+    HOST_CHECK_EQUAL ( APP_u8ChildQueueSetExpiry ( au8Expiry, sizeof ( au8Expiry ) ), E_SL_MSG_STATUS_SUCCESS );
+
+    u32TestRandom =  1;
+    memset ( asTestChildren, 0, sizeof ( asTestChildren ) );
+    for ( i = 0; i < TEST_MIXED_CHILDREN; i++ )
+    {
+        psChild                     =  &asTestChildren[i];
+        psChild->u16Addr            =  TEST_MIXED_ADDR + i;
+        psChild->u32Random          =  i + 1;
+        psChild->u32PollMs          =  au32TestPollMs[i / TEST_MIXED_PER_CLASS];
+        psChild->u32NextPollMs      =  HOST_u32TimeMs ( ) + u32Between ( &psChild->u32Random, 1, psChild->u32PollMs );
+        psChild->u32NextCommandMs   =  HOST_u32TimeMs ( ) + u32Between ( &psChild->u32Random, 0, TEST_MIXED_GAP_MAX_MS );
+        psChild->u8Command          =  ( uint8 ) u32Between ( &psChild->u32Random, 0, 2 );
+        HOST_vAddDevice ( psChild->u16Addr, TEST_MIXED_IEEE_ADDR + i, TRUE );
+    }
+
+    u32EndMs =  HOST_u32TimeMs ( ) + TEST_MIXED_DURATION_MS;
+    while ( HOST_u32TimeMs ( ) < u32EndMs + ( uint32 ) u16Expiry * 1000 + 30000 )
+    {
+        for ( i = 0; i < TEST_MIXED_CHILDREN; i++ )
+        {
+            psChild =  &asTestChildren[i];
+            if ( ( HOST_u32TimeMs ( ) < u32EndMs ) && ( psChild->u32NextCommandMs <= HOST_u32TimeMs ( ) ) )
+            {
+                if ( u32Between ( &psChild->u32Random, 0, 999 ) >= TEST_MIXED_REPEAT )
+                {
+                    psChild->u8Command =  ( uint8 ) u32Between ( &psChild->u32Random, 0, 2 );
+                }
+                au8Payload[0] =  E_ZCL_AM_SHORT;
+                au8Payload[1] =  ( uint8 ) ( psChild->u16Addr >> 8 );
+                au8Payload[2] =  ( uint8 ) psChild->u16Addr;
+                au8Payload[3] =  1;
+                au8Payload[4] =  1;
+                au8Payload[5] =  psChild->u8Command;
+                HOST_vSerialWrite ( E_SL_MSG_ONOFF_NOEFFECTS, sizeof ( au8Payload ), au8Payload );
+                psChild->u16Commands++;
+                psChild->u32NextCommandMs +=  u32Between ( &psChild->u32Random, TEST_MIXED_GAP_MIN_MS, TEST_MIXED_GAP_MAX_MS );
+            }
+        }
+        HOST_vRun ( TEST_MIXED_STEP_MS );
+        vParent ( &u32Seen );
+        HOST_vSerialFlush ( );
+    }
+}
+
+/* Per poll interval: commands the host sent, and of them delivered,
+ * expired, merged into one held and re-armed at the parent, with the mean
+ * and longest latency of those delivered. Returns the commands expired. */
+PRIVATE uint32 u32MixedReport ( uint16    u16Expiry )
+{
+    uint8     au8Stats[TEST_STATS_HEADER + TEST_MIXED_CHILDREN * TEST_STATS_CHILD + 1];
+    uint8*    pu8Child;
+    uint32    u32Commands;
+    uint32    u32Delivered;
+    uint32    u32Expired;
+    uint32    u32Coalesced;
+    uint32    u32Rearmed;
+    uint32    u32LatencySum;
+    uint32    u32LatencyMax;
+    uint32    u32Value;
+    uint16    u16Addr;
+    uint8     c;
+    uint8     i;
+
+    APP_u16ChildQueueGetStats ( au8Stats, sizeof ( au8Stats ), FALSE );
+    HOST_CHECK_EQUAL ( au8Stats[TEST_STATS_CHILDREN], TEST_MIXED_CHILDREN );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_FULL ), 0 );
+    /* Every command held was delivered or reported expired */
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_DELIVERED ) + u32Stat ( TEST_STATS_EXPIRED ), u32Stat ( TEST_STATS_HELD ) );
+
+    for ( c = 0; c < TEST_MIXED_CLASSES; c++ )
+    {
+        u32Commands   =  0;
+        u32Delivered  =  0;
+        u32Expired    =  0;
+        u32Coalesced  =  0;
+        u32Rearmed    =  0;
+        u32LatencySum =  0;
+        u32LatencyMax =  0;
+        for ( i = 0; i < TEST_MIXED_CHILDREN; i++ )
+        {
+            /* Children are reported in the order they were first sent a command */
+            pu8Child =  &au8Stats[TEST_STATS_HEADER + i * TEST_STATS_CHILD];
+            u16Addr  =  ( uint16 ) ( ( pu8Child[TEST_STATS_CHILD_ADDR] << 8 ) | pu8Child[TEST_STATS_CHILD_ADDR + 1] );
+            HOST_CHECK ( ( u16Addr >= TEST_MIXED_ADDR ) && ( u16Addr < TEST_MIXED_ADDR + TEST_MIXED_CHILDREN ) );
+            if ( asTestChildren[u16Addr - TEST_MIXED_ADDR].u32PollMs != au32TestPollMs[c] )
+            {
+                continue;
+            }
+            u32Commands   +=  asTestChildren[u16Addr - TEST_MIXED_ADDR].u16Commands;
+            u32Value       =  ( pu8Child[TEST_STATS_CHILD_DELIVERED] << 8 ) | pu8Child[TEST_STATS_CHILD_DELIVERED + 1];
+            u32Delivered  +=  u32Value;
+            u32LatencySum +=  u32Value * ( ( pu8Child[TEST_STATS_CHILD_LATENCY_MEAN] << 8 ) |
+                                           pu8Child[TEST_STATS_CHILD_LATENCY_MEAN + 1] );
+            u32Value       =  ( pu8Child[TEST_STATS_CHILD_LATENCY_MAX] << 8 ) | pu8Child[TEST_STATS_CHILD_LATENCY_MAX + 1];
+            u32LatencyMax  =  ( u32Value > u32LatencyMax ) ? u32Value : u32LatencyMax;
+            u32Expired    +=  ( pu8Child[TEST_STATS_CHILD_EXPIRED] << 8 ) | pu8Child[TEST_STATS_CHILD_EXPIRED + 1];
+            u32Coalesced  +=  ( pu8Child[TEST_STATS_CHILD_COALESCED] << 8 ) | pu8Child[TEST_STATS_CHILD_COALESCED + 1];
+            u32Rearmed    +=  ( pu8Child[TEST_STATS_CHILD_REARMED] << 8 ) | pu8Child[TEST_STATS_CHILD_REARMED + 1];
+        }
+        /* Each command sent was held and settled, or merged into one held */
+        HOST_CHECK_EQUAL ( u32Delivered + u32Expired + u32Coalesced, u32Commands );
+        /* A child polling within the parent's hold gets every one */
+        if ( au32TestPollMs[c] < TEST_INDIRECT_HOLD_MS )
+        {
+            HOST_CHECK_EQUAL ( u32Expired, 0 );
+        }
+        printf ( "  expiry %3us, poll %3us: %3u commands, %3u delivered, %3u expired, %3u coalesced, %3u re-armed, latency %5.1f s mean, %5.1f s worst\n",
+                 u16Expiry, au32TestPollMs[c] / 1000, u32Commands, u32Delivered, u32Expired, u32Coalesced, u32Rearmed,
+                 ( u32Delivered > 0 ) ? u32LatencySum / 10.0 / u32Delivered : 0.0, u32LatencyMax / 10.0 );
+    }
+    return u32Stat ( TEST_STATS_EXPIRED );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* The second command waits for the confirm of the first one's frame */
+PRIVATE void vDirectReleaseMatchesOwnConfirm ( void )
+{
+    vStart ( );
+    vSendOnOff ( TEST_CHILD, 0 );
+    vSendOnOff ( TEST_CHILD, 1 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 1 );
+    HOST_CHECK_EQUAL ( HOST_psDataReq ( 0 )->u16DstAddr, TEST_CHILD );
+
+    vForeignConfirm ( HOST_psDataReq ( 0 )->u8ApsSeqNum + 100 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 1 );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_DELIVERED ), 0 );
+
+    HOST_CHECK ( HOST_bDataConfirm ( HOST_psDataReq ( 0 )->u8ApsSeqNum, ZPS_E_SUCCESS ) );
+    HOST_vRun ( 5 );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_DELIVERED ), 1 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 2 );
+    HOST_CHECK_EQUAL ( HOST_psDataReq ( 1 )->au8Payload[2], 1 );
+}
+
+/* A command the APS queue holds on release is tracked by the counter of
+ * the frame the APS queue sends it in, not by any frame to the child */
+PRIVATE void vQueuedReleaseMatchesOwnConfirm ( void )
+{
+    uint8    i;
+
+    vStart ( );
+    for ( i = 0; i < APS_QUEUE_MAX_ACK_IN_FLIGHT; i++ )
+    {
+        vSendOnOff ( TEST_ROUTER + i, 0 );
+    }
+    vSendOnOff ( TEST_CHILD, 0 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), APS_QUEUE_MAX_ACK_IN_FLIGHT );
+    HOST_CHECK_EQUAL ( APP_u8ApsQueueDepth ( ), 1 );
+
+    vForeignConfirm ( HOST_psDataReq ( 0 )->u8ApsSeqNum + 100 );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_DELIVERED ), 0 );
+
+    HOST_CHECK ( HOST_bDataConfirm ( HOST_psDataReq ( 0 )->u8ApsSeqNum, ZPS_E_SUCCESS ) );
+    HOST_vRun ( 5 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), APS_QUEUE_MAX_ACK_IN_FLIGHT + 1 );
+    HOST_CHECK_EQUAL ( HOST_psDataReq ( APS_QUEUE_MAX_ACK_IN_FLIGHT )->u16DstAddr, TEST_CHILD );
+
+    vForeignConfirm ( HOST_psDataReq ( APS_QUEUE_MAX_ACK_IN_FLIGHT )->u8ApsSeqNum + 100 );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_DELIVERED ), 0 );
+
+    HOST_CHECK ( HOST_bDataConfirm ( HOST_psDataReq ( APS_QUEUE_MAX_ACK_IN_FLIGHT )->u8ApsSeqNum, ZPS_E_SUCCESS ) );
+    HOST_vRun ( 5 );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_DELIVERED ), 1 );
+}
+
+/* A frame the parent dropped goes to it again */
+PRIVATE void vFailedConfirmResends ( void )
+{
+    vStart ( );
+    vSendOnOff ( TEST_CHILD, 0 );
+    HOST_CHECK ( HOST_bDataConfirm ( HOST_psDataReq ( 0 )->u8ApsSeqNum, TEST_TRANSACTION_EXPIRED ) );
+    HOST_vRun ( 5 );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_REARMED ), 1 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 2 );
+    HOST_CHECK_EQUAL ( HOST_psDataReq ( 1 )->u16DstAddr, TEST_CHILD );
+}
+
+/* Without a confirm the frame may have reached the child: the host is told
+ * the command expired and it is not sent again */
+PRIVATE void vUnconfirmedCommandExpires ( void )
+{
+    tsHostSerialFrame    sFrame;
+
+    vStart ( );
+    vSendOnOff ( TEST_CHILD, 0 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 1 );
+    HOST_vRun ( CHILD_QUEUE_CONFIRM_TIMEOUT * 100 + 1000 );
+
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_CHILD_QUEUE_EXPIRED, &sFrame ) );
+    HOST_CHECK_EQUAL ( ( sFrame.au8Payload[0] << 8 ) | sFrame.au8Payload[1], TEST_CHILD );
+    HOST_CHECK_EQUAL ( ( sFrame.au8Payload[2] << 8 ) | sFrame.au8Payload[3], E_SL_MSG_ONOFF_NOEFFECTS );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_EXPIRED ), 1 );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_REARMED ), 0 );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 1 );
+}
+
+/* Children polling every 1s to 5min with commands from the host: the
+ * fast pollers get all of theirs, the slow ones theirs within the expiry */
+PRIVATE void vMixedPollRates ( void )
+{
+    uint32    u32Expired;
+
+    vMixedRun ( CHILD_QUEUE_DEFAULT_EXPIRY );
+    u32Expired =  u32MixedReport ( CHILD_QUEUE_DEFAULT_EXPIRY );
+    vMixedRun ( TEST_LONG_EXPIRY );
+    HOST_CHECK ( u32MixedReport ( TEST_LONG_EXPIRY ) < u32Expired );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vDirectReleaseMatchesOwnConfirm );
+    HOST_TEST ( vQueuedReleaseMatchesOwnConfirm );
+    HOST_TEST ( vFailedConfirmResends );
+    HOST_TEST ( vUnconfirmedCommandExpires );
+    HOST_TEST ( vMixedPollRates );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,257 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_command_lengths.c
+ *
+ * DESCRIPTION:        Regression tests for the host supplied counts and
+ *                     lengths the serial fuzz target overran buffers with:
+ *                     each is refused with INCORRECT_PARAMETERS at one past
+ *                     its limit and accepted at the limit, and the binding
+ *                     table reply carries only the entries that fit it.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zcl.h"
+#include "OTA.h"
+#include "zps_apl_aib.h"
+#include "SerialLink.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_DST_ADDR                   0x4000
+#define TEST_DST_IEEE                   0x00158D0000400000ULL
+
+/* Records a read report config request holds on the stack */
+#define TEST_REPORT_CONFIG_RECORDS      8
+
+/* Scene name bytes add scene copies before sending */
+#define TEST_SCENE_NAME_MAX             16
+
+/* Bytes of an extended address binding in the 0x8052 reply */
+#define TEST_BINDING_ENTRY_SIZE         13
+
+#define TEST_U16( PAYLOAD, OFFSET )     ( ( ( PAYLOAD )[OFFSET] << 8 ) | ( PAYLOAD )[( OFFSET ) + 1] )
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* Short address mode to the test device, endpoint 1 to endpoint 1 */
+PRIVATE uint16 u16Address ( uint8*    pu8Payload )
+{
+    pu8Payload[0] =  E_ZCL_AM_SHORT;
+    pu8Payload[1] =  ( uint8 ) ( TEST_DST_ADDR >> 8 );
+    pu8Payload[2] =  ( uint8 ) TEST_DST_ADDR;
+    pu8Payload[3] =  1;
+    pu8Payload[4] =  1;
+    return 5;
+}
+
+/* Status of a command once the UART has passed it on, 0xff if none came
+ * back */
+PRIVATE uint8 u8CommandStatus ( uint16    u16Type )
+{
+    tsHostSerialFrame    sFrame;
+
+    while ( HOST_u32SerialRxPending ( ) > 0 )
+    {
+        HOST_vRun ( 1 );
+    }
+    HOST_vRun ( 10 );
+    while ( HOST_bSerialFind ( E_SL_MSG_STATUS, &sFrame ) )
+    {
+        if ( TEST_U16 ( sFrame.au8Payload, 2 ) == u16Type )
+        {
+            return sFrame.au8Payload[0];
+        }
+    }
+    return 0xff;
+}
+
+/* A request declaring u8Count records, carrying u8Records */
+PRIVATE uint8 u8ReadReportConfig ( uint8    u8Count,
+                                   uint8    u8Records )
+{
+    uint8     au8Payload[12 + ( 3 * 0xff )];
+    uint16    u16Length =  u16Address ( au8Payload );
+    uint8     i;
+
+    au8Payload[u16Length++] =  0x00;
+    au8Payload[u16Length++] =  0x06;
+    au8Payload[u16Length++] =  0;
+    au8Payload[u16Length++] =  u8Count;
+    au8Payload[u16Length++] =  0;
+    au8Payload[u16Length++] =  0;
+    au8Payload[u16Length++] =  0;
+    for ( i = 0; i < u8Records; i++ )
+    {
+        au8Payload[u16Length++] =  0;
+        au8Payload[u16Length++] =  0;
+        au8Payload[u16Length++] =  i;
+    }
+    HOST_vSerialFlush ( );
+    HOST_vSerialWrite ( E_SL_MSG_READ_REPORT_CONFIG_REQUEST, u16Length, au8Payload );
+    return u8CommandStatus ( E_SL_MSG_READ_REPORT_CONFIG_REQUEST );
+}
+
+PRIVATE uint8 u8AddScene ( uint8    u8NameLength )
+{
+    uint8     au8Payload[12 + 0xff];
+    uint16    u16Length =  u16Address ( au8Payload );
+    uint8     i;
+
+    au8Payload[u16Length++] =  0x00;
+    au8Payload[u16Length++] =  0x01;
+    au8Payload[u16Length++] =  1;
+    au8Payload[u16Length++] =  0;
+    au8Payload[u16Length++] =  10;
+    au8Payload[u16Length++] =  u8NameLength;
+    au8Payload[u16Length++] =  u8NameLength;
+    for ( i = 0; i < u8NameLength; i++ )
+    {
+        au8Payload[u16Length++] =  'a' + ( i % 26 );
+    }
+    HOST_vSerialFlush ( );
+    HOST_vSerialWrite ( E_SL_MSG_ADD_SCENE, u16Length, au8Payload );
+    return u8CommandStatus ( E_SL_MSG_ADD_SCENE );
+}
+
+/* A successful block response declaring u8DataSize bytes, carrying u8Sent */
+PRIVATE uint8 u8BlockSend ( uint8    u8DataSize,
+                            uint8    u8Sent )
+{
+    uint8     au8Payload[20 + 0xff];
+    uint16    u16Length =  u16Address ( au8Payload );
+
+    memset ( &au8Payload[u16Length], 0, sizeof ( au8Payload ) - u16Length );
+    au8Payload[5]  =  1;
+    au8Payload[6]  =  OTA_STATUS_SUCCESS;
+    au8Payload[19] =  u8DataSize;
+    HOST_vSerialFlush ( );
+    HOST_vSerialWrite ( E_SL_MSG_BLOCK_SEND, 20 + u8Sent, au8Payload );
+    return u8CommandStatus ( E_SL_MSG_BLOCK_SEND );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+PRIVATE void vReadReportConfigCountIsChecked ( void )
+{
+    HOST_vInit ( );
+    HOST_vAddDevice ( TEST_DST_ADDR, TEST_DST_IEEE, FALSE );
+    HOST_CHECK_EQUAL ( u8ReadReportConfig ( TEST_REPORT_CONFIG_RECORDS + 1, TEST_REPORT_CONFIG_RECORDS + 1 ),
+                       E_SL_MSG_STATUS_INCORRECT_PARAMETERS );
+    HOST_CHECK_EQUAL ( u8ReadReportConfig ( 0xff, TEST_REPORT_CONFIG_RECORDS ), E_SL_MSG_STATUS_INCORRECT_PARAMETERS );
+    HOST_CHECK_EQUAL ( u8ReadReportConfig ( TEST_REPORT_CONFIG_RECORDS, TEST_REPORT_CONFIG_RECORDS - 1 ),
+                       E_SL_MSG_STATUS_INCORRECT_PARAMETERS );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 0 );
+    HOST_CHECK_EQUAL ( u8ReadReportConfig ( TEST_REPORT_CONFIG_RECORDS, TEST_REPORT_CONFIG_RECORDS ), E_SL_MSG_STATUS_SUCCESS );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 1 );
+}
+
+PRIVATE void vSceneNameLengthIsChecked ( void )
+{
+    HOST_vInit ( );
+    HOST_vAddDevice ( TEST_DST_ADDR, TEST_DST_IEEE, FALSE );
+    HOST_CHECK_EQUAL ( u8AddScene ( TEST_SCENE_NAME_MAX + 1 ), E_SL_MSG_STATUS_INCORRECT_PARAMETERS );
+    HOST_CHECK_EQUAL ( u8AddScene ( 0xff ), E_SL_MSG_STATUS_INCORRECT_PARAMETERS );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 0 );
+    HOST_CHECK_EQUAL ( u8AddScene ( TEST_SCENE_NAME_MAX ), E_SL_MSG_STATUS_SUCCESS );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 1 );
+}
+
+PRIVATE void vBlockDataLengthIsChecked ( void )
+{
+    HOST_vInit ( );
+    HOST_vAddDevice ( TEST_DST_ADDR, TEST_DST_IEEE, FALSE );
+    HOST_CHECK_EQUAL ( u8BlockSend ( 32, 31 ), E_SL_MSG_STATUS_INCORRECT_PARAMETERS );
+    HOST_CHECK_EQUAL ( u8BlockSend ( 0xff, 0 ), E_SL_MSG_STATUS_INCORRECT_PARAMETERS );
+    HOST_CHECK_EQUAL ( HOST_u32DataReqCount ( ), 0 );
+}
+
+/* More bindings than fit the reply: the count byte matches the entries sent */
+PRIVATE void vBindingTableIsTruncated ( void )
+{
+    ZPS_tsAplApsmeBindingTable*    psTable;
+    tsHostSerialFrame              sFrame;
+    uint32                         i;
+
+    HOST_vInit ( );
+    HOST_vAddDevice ( TEST_DST_ADDR, TEST_DST_IEEE, FALSE );
+    HOST_vSetBindingTableSize ( HOST_BINDING_TABLE_MAX );
+    psTable =  HOST_psBindingTable ( );
+    for ( i = 0; i < psTable->u32SizeOfBindingTable; i++ )
+    {
+        psTable->pvAplApsmeBindingTableEntryForSpSrcAddr[i].u8DstAddrMode          =  ZPS_E_ADDR_MODE_IEEE;
+        psTable->pvAplApsmeBindingTableEntryForSpSrcAddr[i].u16NwkAddrResolved     =  TEST_DST_ADDR;
+        psTable->pvAplApsmeBindingTableEntryForSpSrcAddr[i].u8SourceEndpoint       =  1;
+        psTable->pvAplApsmeBindingTableEntryForSpSrcAddr[i].u8DestinationEndPoint  =  1;
+        psTable->pvAplApsmeBindingTableEntryForSpSrcAddr[i].u16ClusterId           =  ( uint16 ) i;
+    }
+
+    HOST_vSerialFlush ( );
+    HOST_vSerialWrite ( E_SL_MSG_PDM_GET_BINDING_TABLE, 0, NULL );
+    HOST_vRun ( 10 );
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_PDM_GET_BINDING_TABLE_LIST, &sFrame ) );
+    HOST_CHECK ( sFrame.bCrcOk );
+    printf ( "  %u of %u bindings in a %u byte reply\n",
+             sFrame.au8Payload[0], ( unsigned ) psTable->u32SizeOfBindingTable, sFrame.u16Length );
+
+    HOST_CHECK ( sFrame.au8Payload[0] > 0 );
+    HOST_CHECK ( sFrame.au8Payload[0] < psTable->u32SizeOfBindingTable );
+    /* Count byte, the entries and the link quality */
+    HOST_CHECK_EQUAL ( sFrame.u16Length, 1 + ( sFrame.au8Payload[0] * TEST_BINDING_ENTRY_SIZE ) + 1 );
+    HOST_CHECK_EQUAL ( TEST_U16 ( sFrame.au8Payload, 1 + ( ( sFrame.au8Payload[0] - 1 ) * TEST_BINDING_ENTRY_SIZE ) + 11 ),
+                       sFrame.au8Payload[0] - 1 );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vReadReportConfigCountIsChecked );
+    HOST_TEST ( vSceneNameLengthIsChecked );
+    HOST_TEST ( vBlockDataLengthIsChecked );
+    HOST_TEST ( vBindingTableIsTruncated );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,605 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_device_interview.c
+ *
+ * DESCRIPTION:        Device interview run to completion: descriptor
+ *                     responses handed to the interview as the event
+ *                     handler does, Basic read responses over the air, and
+ *                     the attribute sections of the result carrying each
+ *                     record from its attribute identifier on. Then virtual
+ *                     devices of the kinds in Tools/InterviewSim.py
+ *                     announce themselves and answer over the air only
+ *                     when they poll, quickly within their wake window and
+ *                     slowly after it, losing frames both ways; the success
+ *                     rate and time to the result are reported per kind.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zps_apl_af.h"
+#include "zps_apl_zdp.h"
+#include "zcl.h"
+#include "Basic.h"
+#include "SerialLink.h"
+#include "app_device_interview.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_ADDR                       0x4000
+#define TEST_IEEE_ADDR                  0x00158D0000400000ULL
+#define TEST_ENDPOINT                   1
+
+/* Receiver on when idle, mains powered router */
+#define TEST_CAPABILITY                 0x8e
+
+/* Enough exchanges for every request of an interview */
+#define TEST_MAX_ROUNDS                 16
+
+/* Offsets into the 0x8127 payload */
+#define TEST_RESULT_SECTION             2
+#define TEST_SUMMARY_STATUS             12
+#define TEST_RECORD_ATTRIBUTE           3
+#define TEST_RECORD_STATUS              5
+#define TEST_RECORD_TYPE                6
+#define TEST_RECORD_SIZE                7
+#define TEST_RECORD_VALUE               9
+#define TEST_SUMMARY_DURATION           13
+#define TEST_SUMMARY_REQUESTS           15
+
+/* Wake windows: every device announces itself at time 0, then polls its
+ * parent every TEST_FAST_POLL_MS for its window and slowly after it */
+#define TEST_KIND_DEVICES               40
+#define TEST_SLEEPY_ADDR                0x6000
+#define TEST_SLEEPY_IEEE_ADDR           0x00158D0000600000ULL
+#define TEST_SLEEPY_CAPABILITY          0x80
+#define TEST_FAST_POLL_MS               250
+#define TEST_INDIRECT_HOLD_MS           7680
+#define TEST_CONFIRM_MS                 10
+#define TEST_ROUND_TRIP_MS              50
+
+/* Frames lost each way, per mille */
+#define TEST_LOSS                       20
+
+/* MAC statuses of a frame the child never polled for, or never acked */
+#define TEST_MAC_TRANSACTION_EXPIRED    0xF0
+#define TEST_MAC_NO_ACK                 0xE9
+
+/* Longer than any interview may last */
+#define TEST_WAKE_LIMIT_MS              ( DEVICE_INTERVIEW_MAX_DURATION * 100 + 10000 )
+#define TEST_EVENTS                     16
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    const char*    pcName;
+    uint32         u32WindowMinMs;
+    uint32         u32WindowMaxMs;
+    uint32         u32PollMinMs;            /* 0 keeps the receiver on */
+    uint32         u32PollMaxMs;
+    uint8          u8EndpointsMin;
+    uint8          u8EndpointsMax;
+} tsTestKind;
+
+typedef struct
+{
+    uint16    u16Addr;
+    uint32    u32WindowMs;
+    uint32    u32PollMs;
+    uint32    u32PhaseMs;
+    uint8     u8Endpoints;
+} tsTestDevice;
+
+/* A confirm or a response due from the device */
+typedef struct
+{
+    bool_t    bUsed;
+    bool_t    bResponse;
+    uint8     u8Status;
+    uint32    u32DueMs;
+    uint32    u32Request;               /* index in the data request log */
+} tsTestEvent;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+/* Device kinds of Tools/InterviewSim.py: fast poll window, slow poll
+ * interval and endpoint ranges */
+PRIVATE const tsTestKind    asTestKinds[] =
+{
+    { "router",      0,     0,     0,      0,       1, 2 },
+    { "sensor",      5000,  15000, 20000,  60000,   1, 2 },
+    { "button",      2000,  6000,  300000, 3600000, 1, 3 },
+    { "thermostat",  10000, 30000, 5000,   10000,   1, 1 },
+    { "lock",        5000,  10000, 2000,   5000,    1, 1 },
+};
+
+PRIVATE tsTestEvent         asTestEvents[TEST_EVENTS];
+PRIVATE uint32              u32TestRandom;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE void vZdpResponse ( tsHostDataReq*    psReq )
+{
+    ZPS_tsAfZdpEvent    sEvent;
+
+    memset ( &sEvent, 0, sizeof ( sEvent ) );
+    sEvent.u8SequNumber =  psReq->au8Payload[0];
+    switch ( psReq->u16ClusterId )
+    {
+        case ZPS_ZDP_NODE_DESC_REQ_CLUSTER_ID:
+            sEvent.u16ClusterId =  ZPS_ZDP_NODE_DESC_RSP_CLUSTER_ID;
+            sEvent.uZdpData.sNodeDescRsp.sNodeDescriptor.u16ManufacturerCode =  0x115f;
+            break;
+
+        case ZPS_ZDP_ACTIVE_EP_REQ_CLUSTER_ID:
+            sEvent.u16ClusterId                          =  ZPS_ZDP_ACTIVE_EP_RSP_CLUSTER_ID;
+            sEvent.uZdpData.sActiveEpRsp.u8ActiveEpCount =  1;
+            sEvent.uLists.au8Data[0]                     =  TEST_ENDPOINT;
+            break;
+
+        case ZPS_ZDP_SIMPLE_DESC_REQ_CLUSTER_ID:
+        {
+            ZPS_tsAplZdpSimpleDescType*    psSimpleDesc =  &sEvent.uZdpData.sSimpleDescRsp.sSimpleDescriptor;
+
+            sEvent.u16ClusterId                     =  ZPS_ZDP_SIMPLE_DESC_RSP_CLUSTER_ID;
+            psSimpleDesc->u8Endpoint                =  TEST_ENDPOINT;
+            psSimpleDesc->u16ApplicationProfileId   =  0x0104;
+            psSimpleDesc->u8InClusterCount          =  1;
+            sEvent.uLists.au16Data[0]               =  GENERAL_CLUSTER_ID_BASIC;
+        }
+        break;
+
+        default:
+            return;
+    }
+    APP_vDeviceInterviewZdpResponse ( TEST_ADDR, &sEvent );
+}
+
+/* Answers a Basic read: the model identifier, every other attribute
+ * unsupported */
+PRIVATE void vBasicResponse ( tsHostDataReq*    psReq )
+{
+    uint8     au8Response[64];
+    uint16    u16Length =  0;
+    uint16    u16Attribute;
+    uint16    i;
+
+    au8Response[u16Length++] =  0x18;
+    au8Response[u16Length++] =  psReq->au8Payload[1];
+    au8Response[u16Length++] =  E_ZCL_READ_ATTRIBUTES_RESPONSE;
+    for ( i = 3; ( i + 1 ) < psReq->u16PayloadLength; i += 2 )
+    {
+        u16Attribute =  psReq->au8Payload[i] | ( psReq->au8Payload[i + 1] << 8 );
+        au8Response[u16Length++] =  psReq->au8Payload[i];
+        au8Response[u16Length++] =  psReq->au8Payload[i + 1];
+        if ( u16Attribute == E_CLD_BAS_ATTR_ID_MODEL_IDENTIFIER )
+        {
+            au8Response[u16Length++] =  E_ZCL_CMDS_SUCCESS;
+            au8Response[u16Length++] =  E_ZCL_CSTRING;
+            au8Response[u16Length++] =  7;
+            memcpy ( &au8Response[u16Length], "lumi.s1", 7 );
+            u16Length +=  7;
+        }
+        else
+        {
+            au8Response[u16Length++] =  E_ZCL_CMDS_UNSUPPORTED_ATTRIBUTE;
+        }
+    }
+    HOST_vDataIndication ( psReq->u16DstAddr, psReq->u8DstEndpoint, 1, GENERAL_CLUSTER_ID_BASIC, 0x0104,
+                           au8Response, u16Length );
+}
+
+/* Node descriptor, active endpoint and simple descriptor responses as
+ * sent over the air, little endian; endpoint 1 has Basic */
+PRIVATE void vZdpFrame ( tsHostDataReq*    psReq,
+                         tsTestDevice*     psDevice )
+{
+    const uint8    au8NodeDesc[] = { 0x02, 0x40, 0x80, 0x37, 0x10, 0x52, 0x50, 0x00, 0x00, 0x00, 0x50, 0x00, 0x00 };
+    uint8          au8Response[32];
+    uint16         u16Length =  0;
+    uint16         u16Cluster;
+    uint8          i;
+
+    au8Response[u16Length++] =  psReq->au8Payload[0];
+    au8Response[u16Length++] =  ZPS_E_SUCCESS;
+    au8Response[u16Length++] =  ( uint8 ) psDevice->u16Addr;
+    au8Response[u16Length++] =  ( uint8 ) ( psDevice->u16Addr >> 8 );
+    switch ( psReq->u16ClusterId )
+    {
+        case ZPS_ZDP_NODE_DESC_REQ_CLUSTER_ID:
+            u16Cluster =  ZPS_ZDP_NODE_DESC_RSP_CLUSTER_ID;
+            memcpy ( &au8Response[u16Length], au8NodeDesc, sizeof ( au8NodeDesc ) );
+            u16Length +=  sizeof ( au8NodeDesc );
+        break;
+
+        case ZPS_ZDP_ACTIVE_EP_REQ_CLUSTER_ID:
+            u16Cluster =  ZPS_ZDP_ACTIVE_EP_RSP_CLUSTER_ID;
+            au8Response[u16Length++] =  psDevice->u8Endpoints;
+            for ( i = 1; i <= psDevice->u8Endpoints; i++ )
+            {
+                au8Response[u16Length++] =  i;
+            }
+        break;
+
+        case ZPS_ZDP_SIMPLE_DESC_REQ_CLUSTER_ID:
+            u16Cluster =  ZPS_ZDP_SIMPLE_DESC_RSP_CLUSTER_ID;
+            au8Response[u16Length++] =  ( psReq->au8Payload[3] == 1 ) ? 10 : 8;
+            au8Response[u16Length++] =  psReq->au8Payload[3];
+            au8Response[u16Length++] =  0x04;
+            au8Response[u16Length++] =  0x01;
+            au8Response[u16Length++] =  0x00;
+            au8Response[u16Length++] =  0x01;
+            au8Response[u16Length++] =  0x00;
+            if ( psReq->au8Payload[3] == 1 )
+            {
+                au8Response[u16Length++] =  2;
+                au8Response[u16Length++] =  ( uint8 ) GENERAL_CLUSTER_ID_BASIC;
+                au8Response[u16Length++] =  ( uint8 ) ( GENERAL_CLUSTER_ID_BASIC >> 8 );
+            }
+            else
+            {
+                au8Response[u16Length++] =  1;
+            }
+            au8Response[u16Length++] =  0x06;
+            au8Response[u16Length++] =  0x00;
+            au8Response[u16Length++] =  0;
+        break;
+
+        default:
+        return;
+    }
+    HOST_vDataIndication ( psDevice->u16Addr, 0, 0, u16Cluster, 0, au8Response, u16Length );
+}
+
+PRIVATE uint32 u32Between ( uint32    u32Min,
+                            uint32    u32Max )
+{
+    u32TestRandom =  u32TestRandom * 1103515245UL + 12345UL;
+    return u32Min + ( ( u32TestRandom >> 8 ) % ( u32Max - u32Min + 1 ) );
+}
+
+/* When the device next polls its parent, in ms since it announced */
+PRIVATE uint32 u32NextPoll ( tsTestDevice*    psDevice,
+                             uint32           u32NowMs )
+{
+    uint32    u32SlowMs =  psDevice->u32WindowMs + psDevice->u32PhaseMs;
+
+    if ( u32NowMs < psDevice->u32WindowMs )
+    {
+        return ( u32NowMs / TEST_FAST_POLL_MS + 1 ) * TEST_FAST_POLL_MS;
+    }
+    if ( u32NowMs < u32SlowMs )
+    {
+        return u32SlowMs;
+    }
+    return u32SlowMs + ( ( u32NowMs - u32SlowMs ) / psDevice->u32PollMs + 1 ) * psDevice->u32PollMs;
+}
+
+PRIVATE void vEvent ( uint32    u32DueMs,
+                      uint32    u32Request,
+                      bool_t    bResponse,
+                      uint8     u8Status )
+{
+    uint8    i;
+
+    for ( i = 0; i < TEST_EVENTS; i++ )
+    {
+        if ( !asTestEvents[i].bUsed )
+        {
+            asTestEvents[i].bUsed      =  TRUE;
+            asTestEvents[i].bResponse  =  bResponse;
+            asTestEvents[i].u8Status   =  u8Status;
+            asTestEvents[i].u32DueMs   =  u32DueMs;
+            asTestEvents[i].u32Request =  u32Request;
+            return;
+        }
+    }
+    HOST_CHECK ( FALSE );
+}
+
+/* What becomes of a request: held at the parent until the device polls,
+ * expired when that is beyond the indirect hold, and lost either way */
+PRIVATE void vDeviceRequest ( tsTestDevice*    psDevice,
+                              uint32           u32Request,
+                              uint32           u32NowMs )
+{
+    uint32    u32DeliveredMs =  u32NowMs + TEST_CONFIRM_MS;
+
+    if ( psDevice->u32PollMs != 0 )
+    {
+        u32DeliveredMs =  u32NextPoll ( psDevice, u32NowMs );
+        if ( u32DeliveredMs - u32NowMs > TEST_INDIRECT_HOLD_MS )
+        {
+            vEvent ( u32NowMs + TEST_INDIRECT_HOLD_MS, u32Request, FALSE, TEST_MAC_TRANSACTION_EXPIRED );
+            return;
+        }
+    }
+    if ( u32Between ( 0, 999 ) < TEST_LOSS )
+    {
+        vEvent ( u32DeliveredMs, u32Request, FALSE, TEST_MAC_NO_ACK );
+        return;
+    }
+    vEvent ( u32DeliveredMs, u32Request, FALSE, ZPS_E_SUCCESS );
+    if ( u32Between ( 0, 999 ) >= TEST_LOSS )
+    {
+        vEvent ( u32DeliveredMs + TEST_ROUND_TRIP_MS, u32Request, TRUE, 0 );
+    }
+}
+
+PRIVATE void vDeviceEvents ( tsTestDevice*    psDevice,
+                             uint32           u32NowMs )
+{
+    tsHostDataReq*    psReq;
+    uint8             i;
+
+    for ( i = 0; i < TEST_EVENTS; i++ )
+    {
+        if ( !asTestEvents[i].bUsed || ( asTestEvents[i].u32DueMs > u32NowMs ) )
+        {
+            continue;
+        }
+        asTestEvents[i].bUsed =  FALSE;
+        psReq =  HOST_psDataReq ( asTestEvents[i].u32Request );
+        if ( !asTestEvents[i].bResponse )
+        {
+            HOST_bDataConfirm ( psReq->u8ApsSeqNum, asTestEvents[i].u8Status );
+        }
+        else if ( psReq->u16ProfileId == 0 )
+        {
+            vZdpFrame ( psReq, psDevice );
+        }
+        else if ( psReq->au8Payload[2] == E_ZCL_READ_ATTRIBUTES )
+        {
+            vBasicResponse ( psReq );
+        }
+    }
+}
+
+/* Announces the device and runs the main loop until the interview result,
+ * returning its summary; what is still held for the device is then
+ * confirmed as expired */
+PRIVATE bool_t bWakeInterview ( tsTestDevice*         psDevice,
+                                uint64                u64IeeeAddr,
+                                tsHostSerialFrame*    psSummary )
+{
+    uint8     au8Announce[12];
+    uint32    u32StartMs;
+    uint32    u32NowMs =  0;
+    uint32    u32Seen;
+    bool_t    bResult  =  FALSE;
+    uint8     i;
+
+    memset ( asTestEvents, 0, sizeof ( asTestEvents ) );
+    HOST_vAddDevice ( psDevice->u16Addr, u64IeeeAddr, psDevice->u32PollMs != 0 );
+    au8Announce[0] =  ( uint8 ) u64IeeeAddr;
+    au8Announce[1] =  ( uint8 ) psDevice->u16Addr;
+    au8Announce[2] =  ( uint8 ) ( psDevice->u16Addr >> 8 );
+    for ( i = 0; i < 8; i++ )
+    {
+        au8Announce[3 + i] =  ( uint8 ) ( u64IeeeAddr >> ( 8 * i ) );
+    }
+    au8Announce[11] =  ( psDevice->u32PollMs == 0 ) ? TEST_CAPABILITY : TEST_SLEEPY_CAPABILITY;
+
+    HOST_vSerialFlush ( );
+    u32Seen    =  HOST_u32DataReqCount ( );
+    u32StartMs =  HOST_u32TimeMs ( );
+    HOST_vDataIndication ( psDevice->u16Addr, 0, 0, ZPS_ZDP_DEVICE_ANNCE_REQ_CLUSTER_ID, 0, au8Announce, sizeof ( au8Announce ) );
+    while ( !bResult && ( u32NowMs < TEST_WAKE_LIMIT_MS ) )
+    {
+        HOST_vRun ( 1 );
+        u32NowMs =  HOST_u32TimeMs ( ) - u32StartMs;
+        while ( u32Seen < HOST_u32DataReqCount ( ) )
+        {
+            vDeviceRequest ( psDevice, u32Seen++, u32NowMs );
+        }
+        vDeviceEvents ( psDevice, u32NowMs );
+        bResult =  HOST_bSerialFind ( E_SL_MSG_DEVICE_INTERVIEW_RESULT, psSummary );
+    }
+    for ( i = 0; i < TEST_EVENTS; i++ )
+    {
+        if ( asTestEvents[i].bUsed && !asTestEvents[i].bResponse )
+        {
+            HOST_bDataConfirm ( HOST_psDataReq ( asTestEvents[i].u32Request )->u8ApsSeqNum, TEST_MAC_TRANSACTION_EXPIRED );
+        }
+    }
+    HOST_vRun ( 1 );
+    return bResult;
+}
+
+/* Confirms and answers each request the interview makes, as it makes them */
+PRIVATE void vAnswerRequests ( uint32    u32First )
+{
+    tsHostDataReq*    psReq;
+    uint32            u32Next  =  u32First;
+    uint8             u8Round;
+
+    for ( u8Round = 0; ( u8Round < TEST_MAX_ROUNDS ) && ( u32Next < HOST_u32DataReqCount ( ) ); u8Round++ )
+    {
+        psReq =  HOST_psDataReq ( u32Next++ );
+        HOST_bDataConfirm ( psReq->u8ApsSeqNum, ZPS_E_SUCCESS );
+        if ( psReq->u16ProfileId == 0 )
+        {
+            vZdpResponse ( psReq );
+        }
+        else if ( psReq->u16ClusterId == GENERAL_CLUSTER_ID_BASIC )
+        {
+            vBasicResponse ( psReq );
+        }
+        HOST_vRun ( 1 );
+    }
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* The attribute section is the record of the read attribute response,
+ * from the attribute identifier to the end of the value */
+PRIVATE void vAttributeRecordsInResult ( void )
+{
+    tsHostSerialFrame    sFrame;
+    uint32               u32First;
+    uint8                u8Records =  0;
+    bool_t               bModel    =  FALSE;
+
+    HOST_vInit ( );
+    HOST_vAddDevice ( TEST_ADDR, TEST_IEEE_ADDR, FALSE );
+    HOST_vRun ( 10 );
+    HOST_vSerialFlush ( );
+
+    u32First =  HOST_u32DataReqCount ( );
+    HOST_CHECK ( APP_bDeviceInterviewStart ( TEST_ADDR, TEST_IEEE_ADDR, TEST_CAPABILITY ) );
+    vAnswerRequests ( u32First );
+
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_DEVICE_INTERVIEW_RESULT, &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_RESULT_SECTION], DEVICE_INTERVIEW_SECTION_SUMMARY );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_SUMMARY_STATUS], DEVICE_INTERVIEW_STATUS_COMPLETE );
+
+    while ( HOST_bSerialFind ( E_SL_MSG_DEVICE_INTERVIEW_RESULT, &sFrame ) )
+    {
+        if ( sFrame.au8Payload[TEST_RESULT_SECTION] != DEVICE_INTERVIEW_SECTION_ATTRIBUTE )
+        {
+            continue;
+        }
+        u8Records++;
+        if ( ( ( sFrame.au8Payload[TEST_RECORD_ATTRIBUTE] << 8 ) | sFrame.au8Payload[TEST_RECORD_ATTRIBUTE + 1] ) ==
+             E_CLD_BAS_ATTR_ID_MODEL_IDENTIFIER )
+        {
+            bModel =  TRUE;
+            HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_RECORD_STATUS], E_ZCL_CMDS_SUCCESS );
+            HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_RECORD_TYPE], E_ZCL_CSTRING );
+            HOST_CHECK_EQUAL ( ( sFrame.au8Payload[TEST_RECORD_SIZE] << 8 ) | sFrame.au8Payload[TEST_RECORD_SIZE + 1], 7 );
+            HOST_CHECK ( memcmp ( &sFrame.au8Payload[TEST_RECORD_VALUE], "lumi.s1", 7 ) == 0 );
+            HOST_CHECK_EQUAL ( sFrame.u16Length, TEST_RECORD_VALUE + 7 + 1 );
+        }
+        else
+        {
+            HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_RECORD_STATUS], E_ZCL_CMDS_UNSUPPORTED_ATTRIBUTE );
+        }
+    }
+    HOST_CHECK ( bModel );
+    HOST_CHECK_EQUAL ( u8Records, 6 );
+}
+
+/* Devices of each kind, each with its own window, polls and endpoints:
+ * every interview ends in a summary within DEVICE_INTERVIEW_MAX_DURATION,
+ * and a device awake throughout is always interviewed in full */
+PRIVATE void vWakeWindows ( void )
+{
+    tsHostSerialFrame    sSummary;
+    tsTestDevice         sDevice;
+    const tsTestKind*    psKind;
+    uint32               u32TotalMs;
+    uint32               u32WorstMs;
+    uint32               u32DurationMs;
+    uint32               u32Requests;
+    uint16               u16Complete;
+    uint16               u16Incomplete;
+    uint16               u16Timeout;
+    uint16               n;
+    uint8                k;
+
+    u32TestRandom =  1;
+    for ( k = 0; k < sizeof ( asTestKinds ) / sizeof ( tsTestKind ); k++ )
+    {
+        psKind        =  &asTestKinds[k];
+        u32TotalMs    =  0;
+        u32WorstMs    =  0;
+        u32Requests   =  0;
+        u16Complete   =  0;
+        u16Incomplete =  0;
+        u16Timeout    =  0;
+        HOST_vInit ( );
+        for ( n = 0; n < TEST_KIND_DEVICES; n++ )
+        {
+            sDevice.u16Addr      =  TEST_SLEEPY_ADDR + ( k << 8 ) + n;
+            sDevice.u32WindowMs  =  u32Between ( psKind->u32WindowMinMs, psKind->u32WindowMaxMs );
+            sDevice.u32PollMs    =  u32Between ( psKind->u32PollMinMs, psKind->u32PollMaxMs );
+            sDevice.u32PhaseMs   =  ( sDevice.u32PollMs != 0 ) ? u32Between ( 0, sDevice.u32PollMs - 1 ) : 0;
+            sDevice.u8Endpoints  =  ( uint8 ) u32Between ( psKind->u8EndpointsMin, psKind->u8EndpointsMax );
+
+            HOST_CHECK ( bWakeInterview ( &sDevice, TEST_SLEEPY_IEEE_ADDR + sDevice.u16Addr, &sSummary ) );
+            HOST_CHECK_EQUAL ( sSummary.au8Payload[TEST_RESULT_SECTION], DEVICE_INTERVIEW_SECTION_SUMMARY );
+            u32DurationMs =  100 * ( ( sSummary.au8Payload[TEST_SUMMARY_DURATION] << 8 ) |
+                                     sSummary.au8Payload[TEST_SUMMARY_DURATION + 1] );
+            HOST_CHECK ( u32DurationMs <= DEVICE_INTERVIEW_MAX_DURATION * 100 );
+            u32Requests +=  sSummary.au8Payload[TEST_SUMMARY_REQUESTS];
+            switch ( sSummary.au8Payload[TEST_SUMMARY_STATUS] )
+            {
+                case DEVICE_INTERVIEW_STATUS_COMPLETE:
+                    u16Complete++;
+                    u32TotalMs +=  u32DurationMs;
+                    u32WorstMs  =  ( u32DurationMs > u32WorstMs ) ? u32DurationMs : u32WorstMs;
+                break;
+
+                case DEVICE_INTERVIEW_STATUS_INCOMPLETE:
+                    u16Incomplete++;
+                break;
+
+                default:
+                    u16Timeout++;
+                break;
+            }
+        }
+        if ( psKind->u32PollMaxMs == 0 )
+        {
+            HOST_CHECK_EQUAL ( u16Complete, TEST_KIND_DEVICES );
+        }
+        printf ( "  %-10s %3u%% complete in %4.1f s mean, %4.1f s worst, %4.1f requests, %2u incomplete, %2u timed out\n",
+                 psKind->pcName, 100 * u16Complete / TEST_KIND_DEVICES,
+                 ( u16Complete > 0 ) ? u32TotalMs / 1000.0 / u16Complete : 0.0, u32WorstMs / 1000.0,
+                 ( double ) u32Requests / TEST_KIND_DEVICES, u16Incomplete, u16Timeout );
+    }
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vAttributeRecordsInResult );
+    HOST_TEST ( vWakeWindows );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
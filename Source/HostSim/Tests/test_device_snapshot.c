@@ -0,0 +1,346 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_device_snapshot.c
+ *
+ * DESCRIPTION:        Device table snapshot: records merged from the stack
+ *                     tables, the CRC over the headers and records of all
+ *                     frames, diffs from a base generation and removed
+ *                     devices.
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "pdum_apl.h"
+#include "zps_apl.h"
+#include "zps_apl_af.h"
+#include "zps_nwk_nib.h"
+#include "zps_struct.h"
+#include "SerialLink.h"
+#include "app_device_snapshot.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_IEEE_BASE                  0x00158D0000500000ULL
+#define TEST_NWK_BASE                   0x5000
+
+/* Offsets into the 0x8055 payload */
+#define TEST_SNAP_MODE                  1
+#define TEST_SNAP_GENERATION            2
+#define TEST_SNAP_BASE                  6
+#define TEST_SNAP_FRAME_INDEX           10
+#define TEST_SNAP_FRAME_COUNT           11
+#define TEST_SNAP_TOTAL                 12
+#define TEST_SNAP_IN_FRAME              14
+#define TEST_SNAP_RECORDS               15
+
+#define TEST_MAX_RECORDS                40
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint8     u8Mode;
+    uint8     u8Frames;
+    uint16    u16Total;
+    uint16    u16Records;
+    uint32    u32Generation;
+    uint32    u32Base;
+    bool_t    bCrcOk;
+    uint8     au8Records[TEST_MAX_RECORDS][DEVICE_SNAPSHOT_RECORD_LENGTH];
+} tsTestSnapshot;
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+extern ZPS_NwkDevice    tmpNtActv[200];
+extern uint8            u8SizeTmpNtActv;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* Reference CRC-16/CCITT-FALSE, bit by bit */
+PRIVATE uint16 u16CrcUpdate ( uint16          u16Crc,
+                              const uint8*    pu8Data,
+                              uint16          u16Length )
+{
+    uint8    i;
+
+    while ( u16Length-- > 0 )
+    {
+        u16Crc ^=  ( uint16 ) ( *pu8Data++ ) << 8;
+        for ( i = 0; i < 8; i++ )
+        {
+            u16Crc =  ( u16Crc & 0x8000 ) ? ( uint16 ) ( ( u16Crc << 1 ) ^ 0x1021 ) : ( uint16 ) ( u16Crc << 1 );
+        }
+    }
+    return u16Crc;
+}
+
+PRIVATE uint32 u32Read32 ( const uint8*    pu8Data )
+{
+    return ( ( uint32 ) pu8Data[0] << 24 ) | ( ( uint32 ) pu8Data[1] << 16 ) |
+           ( ( uint32 ) pu8Data[2] << 8 ) | pu8Data[3];
+}
+
+PRIVATE uint64 u64Read64 ( const uint8*    pu8Data )
+{
+    return ( ( uint64 ) u32Read32 ( pu8Data ) << 32 ) | u32Read32 ( &pu8Data[4] );
+}
+
+PRIVATE void vDiscovered ( uint8    u8Count )
+{
+    uint8    i;
+
+    for ( i = 0; i < u8Count; i++ )
+    {
+        tmpNtActv[i].u16ShortAddr    =  TEST_NWK_BASE + i;
+        tmpNtActv[i].u64IEEEAddr     =  TEST_IEEE_BASE + i;
+        tmpNtActv[i].u8LinkQuality   =  100 + i;
+        tmpNtActv[i].u8Type          =  ( i & 1 ) ? 1 : 2;
+    }
+    u8SizeTmpNtActv =  u8Count;
+}
+
+/* Requests a snapshot over the serial link and gathers its frames */
+PRIVATE void vSnapshot ( uint32    u32BaseGeneration,
+                         tsTestSnapshot*    psSnap )
+{
+    tsHostSerialFrame    sFrame;
+    uint8                au8Base[4];
+    uint16               u16Crc  =  0xFFFF;
+    uint16               u16Length;
+    uint8                u8InFrame;
+    uint8                i;
+
+    memset ( psSnap, 0, sizeof ( tsTestSnapshot ) );
+    au8Base[0] =  ( uint8 ) ( u32BaseGeneration >> 24 );
+    au8Base[1] =  ( uint8 ) ( u32BaseGeneration >> 16 );
+    au8Base[2] =  ( uint8 ) ( u32BaseGeneration >> 8 );
+    au8Base[3] =  ( uint8 ) u32BaseGeneration;
+    HOST_vSerialFlush ( );
+    HOST_vSerialWrite ( E_SL_MSG_GET_DEVICE_SNAPSHOT, ( u32BaseGeneration != 0 ) ? 4 : 0, au8Base );
+    HOST_vRun ( 20 );
+
+    while ( HOST_bSerialFind ( E_SL_MSG_DEVICE_SNAPSHOT_FRAME, &sFrame ) )
+    {
+        HOST_CHECK ( sFrame.bCrcOk );
+        HOST_CHECK_EQUAL ( sFrame.au8Payload[0], DEVICE_SNAPSHOT_VERSION );
+        HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_SNAP_FRAME_INDEX], psSnap->u8Frames );
+        psSnap->u8Mode          =  sFrame.au8Payload[TEST_SNAP_MODE];
+        psSnap->u32Generation   =  u32Read32 ( &sFrame.au8Payload[TEST_SNAP_GENERATION] );
+        psSnap->u32Base         =  u32Read32 ( &sFrame.au8Payload[TEST_SNAP_BASE] );
+        psSnap->u16Total        =  ( sFrame.au8Payload[TEST_SNAP_TOTAL] << 8 ) | sFrame.au8Payload[TEST_SNAP_TOTAL + 1];
+        psSnap->u8Frames++;
+
+        u8InFrame =  sFrame.au8Payload[TEST_SNAP_IN_FRAME];
+        for ( i = 0; ( i < u8InFrame ) && ( psSnap->u16Records < TEST_MAX_RECORDS ); i++ )
+        {
+            memcpy ( psSnap->au8Records[psSnap->u16Records++],
+                     &sFrame.au8Payload[TEST_SNAP_RECORDS + i * DEVICE_SNAPSHOT_RECORD_LENGTH],
+                     DEVICE_SNAPSHOT_RECORD_LENGTH );
+        }
+        /* Payload length excludes the trailing link quality byte */
+        u16Length =  TEST_SNAP_RECORDS + u8InFrame * DEVICE_SNAPSHOT_RECORD_LENGTH;
+        u16Crc    =  u16CrcUpdate ( u16Crc, sFrame.au8Payload, u16Length );
+        if ( sFrame.au8Payload[TEST_SNAP_FRAME_INDEX] == sFrame.au8Payload[TEST_SNAP_FRAME_COUNT] - 1 )
+        {
+            HOST_CHECK_EQUAL ( sFrame.u16Length, u16Length + 3 );
+            psSnap->bCrcOk =  ( ( ( sFrame.au8Payload[u16Length] << 8 ) | sFrame.au8Payload[u16Length + 1] ) == u16Crc );
+        }
+        else
+        {
+            HOST_CHECK_EQUAL ( sFrame.u16Length, u16Length + 1 );
+        }
+    }
+}
+
+/* Index of the record for an IEEE address, or -1 */
+PRIVATE int iFind ( tsTestSnapshot*    psSnap,
+                    uint64    u64IeeeAddr )
+{
+    uint16    i;
+
+    for ( i = 0; i < psSnap->u16Records; i++ )
+    {
+        if ( u64Read64 ( psSnap->au8Records[i] ) == u64IeeeAddr )
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* The reference CRC is the CCITT-FALSE check value */
+PRIVATE void vReferenceCrc ( void )
+{
+    HOST_CHECK_EQUAL ( u16CrcUpdate ( 0xFFFF, ( const uint8* ) "123456789", 9 ), 0x29B1 );
+}
+
+/* No devices: still one frame with a generation and the CRC of nothing */
+PRIVATE void vEmptyTable ( void )
+{
+    tsTestSnapshot    sSnap;
+
+    HOST_vInit ( );
+    vDiscovered ( 0 );
+    vSnapshot ( 0, &sSnap );
+    HOST_CHECK_EQUAL ( sSnap.u8Frames, 1 );
+    HOST_CHECK_EQUAL ( sSnap.u16Total, 0 );
+    HOST_CHECK_EQUAL ( sSnap.u8Mode, DEVICE_SNAPSHOT_MODE_FULL );
+    HOST_CHECK ( sSnap.bCrcOk );
+}
+
+/* Records from several frames, sources merged into one record per device */
+PRIVATE void vFullSnapshot ( void )
+{
+    tsTestSnapshot    sSnap;
+    int               iRecord;
+
+    HOST_vInit ( );
+    vDiscovered ( 20 );
+    HOST_vAddDevice ( TEST_NWK_BASE + 3, TEST_IEEE_BASE + 3, TRUE );
+    vSnapshot ( 0, &sSnap );
+
+    HOST_CHECK_EQUAL ( sSnap.u8Frames, 2 );
+    HOST_CHECK_EQUAL ( sSnap.u16Total, 20 );
+    HOST_CHECK_EQUAL ( sSnap.u16Records, 20 );
+    HOST_CHECK_EQUAL ( sSnap.u8Mode, DEVICE_SNAPSHOT_MODE_FULL );
+    HOST_CHECK_EQUAL ( sSnap.u32Base, 0 );
+    HOST_CHECK ( ( sSnap.u32Generation >> 16 ) != 0 );
+    HOST_CHECK ( sSnap.bCrcOk );
+
+    iRecord =  iFind ( &sSnap, TEST_IEEE_BASE + 3 );
+    HOST_CHECK ( iRecord >= 0 );
+    if ( iRecord >= 0 )
+    {
+        HOST_CHECK_EQUAL ( ( sSnap.au8Records[iRecord][8] << 8 ) | sSnap.au8Records[iRecord][9], TEST_NWK_BASE + 3 );
+        HOST_CHECK_EQUAL ( sSnap.au8Records[iRecord][10],
+                           DEVICE_SNAPSHOT_FLAG_NEIGHBOUR | DEVICE_SNAPSHOT_FLAG_ADDRESS_MAP |
+                           DEVICE_SNAPSHOT_FLAG_DISCOVERED | DEVICE_SNAPSHOT_FLAG_ROUTER );
+        /* Best link quality of the sources */
+        HOST_CHECK_EQUAL ( sSnap.au8Records[iRecord][11], 200 );
+    }
+    iRecord =  iFind ( &sSnap, TEST_IEEE_BASE + 4 );
+    HOST_CHECK ( ( iRecord >= 0 ) && ( sSnap.au8Records[iRecord][10] == DEVICE_SNAPSHOT_FLAG_DISCOVERED ) );
+}
+
+/* A diff carries only what changed after the base, removals included */
+PRIVATE void vDiffFromBase ( void )
+{
+    tsTestSnapshot    sSnap;
+    uint32            u32Generation;
+    int               iRecord;
+
+    HOST_vInit ( );
+    vDiscovered ( 5 );
+    vSnapshot ( 0, &sSnap );
+    u32Generation =  sSnap.u32Generation;
+
+    /* Nothing changed; link quality alone does not count */
+    tmpNtActv[0].u8LinkQuality =  10;
+    vSnapshot ( u32Generation, &sSnap );
+    HOST_CHECK_EQUAL ( sSnap.u8Mode, DEVICE_SNAPSHOT_MODE_DIFF );
+    HOST_CHECK_EQUAL ( sSnap.u32Base, u32Generation );
+    HOST_CHECK_EQUAL ( sSnap.u32Generation, u32Generation );
+    HOST_CHECK_EQUAL ( sSnap.u16Total, 0 );
+    HOST_CHECK ( sSnap.bCrcOk );
+
+    /* Device 4 leaves, device 5 joins, device 2 gets a new address */
+    vDiscovered ( 6 );
+    tmpNtActv[4] =  tmpNtActv[5];
+    u8SizeTmpNtActv =  5;
+    tmpNtActv[2].u16ShortAddr =  0x7002;
+    vSnapshot ( u32Generation, &sSnap );
+    HOST_CHECK_EQUAL ( sSnap.u8Mode, DEVICE_SNAPSHOT_MODE_DIFF );
+    HOST_CHECK_EQUAL ( sSnap.u32Generation, u32Generation + 1 );
+    HOST_CHECK_EQUAL ( sSnap.u16Records, 3 );
+    HOST_CHECK ( sSnap.bCrcOk );
+    iRecord =  iFind ( &sSnap, TEST_IEEE_BASE + 4 );
+    HOST_CHECK ( ( iRecord >= 0 ) && ( sSnap.au8Records[iRecord][10] == DEVICE_SNAPSHOT_FLAG_REMOVED ) );
+    iRecord =  iFind ( &sSnap, TEST_IEEE_BASE + 2 );
+    HOST_CHECK ( ( iRecord >= 0 ) && ( sSnap.au8Records[iRecord][9] == 0x02 ) );
+    HOST_CHECK ( iFind ( &sSnap, TEST_IEEE_BASE + 5 ) >= 0 );
+
+    /* A full snapshot leaves the removed device out */
+    vSnapshot ( 0, &sSnap );
+    HOST_CHECK_EQUAL ( sSnap.u16Records, 5 );
+    HOST_CHECK ( iFind ( &sSnap, TEST_IEEE_BASE + 4 ) < 0 );
+}
+
+/* A base from another epoch or the future gives a full snapshot */
+PRIVATE void vUnknownBaseIsFull ( void )
+{
+    tsTestSnapshot    sSnap;
+    uint32            u32Generation;
+
+    HOST_vInit ( );
+    vDiscovered ( 3 );
+    vSnapshot ( 0, &sSnap );
+    u32Generation =  sSnap.u32Generation;
+
+    vSnapshot ( u32Generation ^ 0x00010000, &sSnap );
+    HOST_CHECK_EQUAL ( sSnap.u8Mode, DEVICE_SNAPSHOT_MODE_FULL );
+    HOST_CHECK_EQUAL ( sSnap.u32Base, 0 );
+    HOST_CHECK_EQUAL ( sSnap.u16Records, 3 );
+
+    vSnapshot ( u32Generation + 1, &sSnap );
+    HOST_CHECK_EQUAL ( sSnap.u8Mode, DEVICE_SNAPSHOT_MODE_FULL );
+    HOST_CHECK_EQUAL ( sSnap.u16Records, 3 );
+    HOST_CHECK ( sSnap.bCrcOk );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vReferenceCrc );
+    HOST_TEST ( vEmptyTable );
+    HOST_TEST ( vFullSnapshot );
+    HOST_TEST ( vDiffFromBase );
+    HOST_TEST ( vUnknownBaseIsFull );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
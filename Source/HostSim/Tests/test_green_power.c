@@ -0,0 +1,437 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_green_power.c
+ *
+ * DESCRIPTION:        Green Power table persistence and translation table
+ *                     index. app_green_power.c is compiled into this test as
+ *                     the combo variant; the GP cluster calls it makes are
+ *                     stubbed below. With both tables full it reports the
+ *                     host time of a commissioning and of the translation
+ *                     lookup each GPDF makes, and the PDM flash bytes one
+ *                     commissioning writes.
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "gp.h"
+#include "PDM.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/* Not provided by the application for the combo variant */
+PUBLIC uint8 app_u8GetDeviceEndpoint ( void );
+tsGP_GpToZclCommandInfo    asGpToZclLevelControlCmdInfo[] =
+{
+    { E_GP_ZGP_LEVEL_CONTROL_SWITCH, E_GP_OFF,    0x00, 1, 0x0006, 0x00, { 0 } },
+    { E_GP_ZGP_LEVEL_CONTROL_SWITCH, E_GP_ON,     0x01, 1, 0x0006, 0x00, { 0 } },
+    { E_GP_ZGP_LEVEL_CONTROL_SWITCH, E_GP_TOGGLE, 0x02, 1, 0x0006, 0x00, { 0 } },
+};
+
+#include "app_green_power.c"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_SRC_ID                     0x01020304
+
+/* Commissionings and GPDF lookups timed with full tables */
+#define TEST_COMMISSIONINGS             1000
+#define TEST_LOOKUPS                    100000
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+PUBLIC uint8 app_u8GetDeviceEndpoint ( void )
+{
+    return 1;
+}
+
+PUBLIC teZCL_Status eGP_RegisterComboBasicEndPoint ( uint8                          u8EndPointIdentifier,
+                                                     tfpZCL_ZCLCallBackFunction     cbCallBack,
+                                                     tsGP_GreenPowerDevice*         psDeviceInfo,
+                                                     uint16                         u16ProfileId,
+                                                     tsGP_TranslationTableEntry*    psTranslationTableEntry )
+{
+    return E_ZCL_SUCCESS;
+}
+
+PUBLIC void vGP_RestorePersistedData ( tsGP_ZgppProxySinkTable*     psZgpsProxySinkTable,
+                                       teGP_ResetToDefaultConfig    eSetToDefault )
+{
+}
+
+PUBLIC teZCL_Status eGP_ProxyCommissioningMode ( uint8                                 u8SourceEndPointId,
+                                                 uint8                                 u8DestEndPointId,
+                                                 tsZCL_Address                         sDestinationAddress,
+                                                 teGP_GreenPowerProxyCommissionMode    eGreenPowerProxyCommissionMode )
+{
+    return E_ZCL_SUCCESS;
+}
+
+/* Source id rules of the cluster's bGP_CheckGPDAddressMatch; the tests only
+ * use application id 0 */
+PUBLIC bool_t bGP_CheckGPDAddressMatch ( uint8                  u8GPTableAppIdSrc,
+                                         uint8                  u8AppIdDst,
+                                         tuGP_ZgpdDeviceAddr*   sGPTableAddrSrc,
+                                         tuGP_ZgpdDeviceAddr*   sAddrDst )
+{
+    return ( u8GPTableAppIdSrc == u8AppIdDst ) &&
+           ( ( sGPTableAddrSrc->u32ZgpdSrcId == sAddrDst->u32ZgpdSrcId ) ||
+             ( sGPTableAddrSrc->u32ZgpdSrcId == 0xFFFFFFFF ) );
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE uint64 u64Ns ( void )
+{
+    struct timespec    sNow;
+
+    clock_gettime ( CLOCK_MONOTONIC, &sNow );
+    return ( uint64 ) sNow.tv_sec * 1000000000ULL + sNow.tv_nsec;
+}
+
+PRIVATE uint32 u32Writes ( void )
+{
+    return HOST_u32PdmSaves ( );
+}
+
+PRIVATE bool_t bExists ( uint16    u16Id )
+{
+    uint16    u16Length;
+
+    return PDM_bDoesDataExist ( u16Id, &u16Length );
+}
+
+PRIVATE void vEvent ( teGP_GreenPowerCallBackEventType    eEvent,
+                      void*                               pvMessage )
+{
+    tsGP_GreenPowerCallBackMessage    sMessage;
+
+    memset ( &sMessage, 0, sizeof ( sMessage ) );
+    sMessage.eEventType                     =  eEvent;
+    sMessage.uMessage.psZgpsProxySinkTable  =  pvMessage;
+    vHandleGreenPowerEvent ( &sMessage );
+}
+
+PRIVATE void vPersist ( void )
+{
+    vEvent ( E_GP_PERSIST_SINK_PROXY_TABLE, NULL );
+}
+
+PRIVATE void vOccupy ( uint8     u8Index,
+                       uint32    u32SrcId )
+{
+    tsGP_ZgppProxySinkTable*    psEntry =  &sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[u8Index];
+
+    memset ( psEntry, 0, sizeof ( tsGP_ZgppProxySinkTable ) );
+    psEntry->bProxyTableEntryOccupied   =  TRUE;
+    psEntry->uZgpdDeviceAddr.u32ZgpdSrcId =  u32SrcId;
+}
+
+/* Commissioning a GPD adds its translation table entry */
+PRIVATE teZCL_Status eCommission ( uint32    u32SrcId )
+{
+    tsGP_ZgpCommissionIndication    sIndication;
+
+    memset ( &sIndication, 0, sizeof ( sIndication ) );
+    sIndication.uZgpdDeviceAddr.u32ZgpdSrcId =  u32SrcId;
+    vEvent ( E_GP_COMMISSION_DATA_INDICATION, &sIndication );
+    return sIndication.eStatus;
+}
+
+PRIVATE void vDecommission ( uint32    u32SrcId )
+{
+    tsGP_ZgpDecommissionIndication    sIndication;
+
+    memset ( &sIndication, 0, sizeof ( sIndication ) );
+    sIndication.uZgpdDeviceAddr.u32ZgpdSrcId =  u32SrcId;
+    vEvent ( E_GP_DECOMM_CMD_RCVD, &sIndication );
+}
+
+/* Slot of a GPD's translation entry found through the index, or -1 */
+PRIVATE int iTranslation ( uint32    u32SrcId )
+{
+    tuGP_ZgpdDeviceAddr    uAddr;
+    uint8                  u8Index;
+
+    memset ( &uAddr, 0, sizeof ( uAddr ) );
+    uAddr.u32ZgpdSrcId =  u32SrcId;
+    return ( psApp_GPGetTranslationTable ( 0, &u8Index, &uAddr ) != NULL ) ? u8Index : -1;
+}
+
+PRIVATE uint8 u8TranslationsUsed ( void )
+{
+    uint8    u8Used =  0;
+    uint8    i;
+
+    for ( i = 0; i < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; i++ )
+    {
+        u8Used +=  ( u32GpTransUsed >> i ) & 1;
+    }
+    return u8Used;
+}
+
+PRIVATE void vReset ( void )
+{
+    PDM_vDeleteAllDataRecords ( );
+    vAPP_GP_ResetData ( );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* Only the entries that changed are written; freed entries are deleted */
+PRIVATE void vPersistWritesChangedEntries ( void )
+{
+    uint32    u32Before;
+
+    vReset ( );
+    vOccupy ( 2, TEST_SRC_ID );
+    u32Before =  u32Writes ( );
+    vPersist ( );
+    HOST_CHECK_EQUAL ( u32Writes ( ) - u32Before, 2 );
+    HOST_CHECK ( bExists ( PDM_ID_APP_CLD_GP_RESTORE_INFO ) );
+    HOST_CHECK ( bExists ( PDM_ID_APP_CLD_GP_SINK_PROXY_ENTRY + 2 ) );
+    HOST_CHECK ( !bExists ( PDM_ID_APP_CLD_GP_SINK_PROXY_ENTRY + 1 ) );
+    HOST_CHECK ( !bExists ( PDM_ID_APP_CLD_GP_SINK_PROXY_TABLE ) );
+
+    u32Before =  u32Writes ( );
+    vPersist ( );
+    HOST_CHECK_EQUAL ( u32Writes ( ) - u32Before, 0 );
+
+    sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[2].u32ZgpdSecFrameCounter++;
+    u32Before =  u32Writes ( );
+    vPersist ( );
+    HOST_CHECK_EQUAL ( u32Writes ( ) - u32Before, 1 );
+
+    memset ( &sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[2], 0, sizeof ( tsGP_ZgppProxySinkTable ) );
+    u32Before =  u32Writes ( );
+    vPersist ( );
+    HOST_CHECK_EQUAL ( u32Writes ( ) - u32Before, 0 );
+    HOST_CHECK ( !bExists ( PDM_ID_APP_CLD_GP_SINK_PROXY_ENTRY + 2 ) );
+}
+
+/* Nothing is written before the tables have been loaded (staged boot) */
+PRIVATE void vNoPersistBeforeLoad ( void )
+{
+    uint32    u32Before;
+
+    vReset ( );
+    bGpPdmLoaded =  FALSE;
+    vOccupy ( 0, TEST_SRC_ID );
+    u32Before =  u32Writes ( );
+    vPersist ( );
+    HOST_CHECK_EQUAL ( u32Writes ( ) - u32Before, 0 );
+    bGpPdmLoaded =  TRUE;
+}
+
+/* The per entry records restore both tables and rebuild the index */
+PRIVATE void vLoadRestoresEntries ( void )
+{
+    tsGP_ZgppProxySinkTable    sSaved;
+    uint32                     u32Before;
+
+    vReset ( );
+    vOccupy ( 4, TEST_SRC_ID );
+    HOST_CHECK_EQUAL ( eCommission ( TEST_SRC_ID ), E_ZCL_SUCCESS );
+    vPersist ( );
+    sSaved =  sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[4];
+
+    memset ( &sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable, 0,
+             sizeof ( sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable ) );
+    memset ( &sGP_PDM_Data, 0, sizeof ( sGP_PDM_Data ) );
+    vApp_GPTransIndexRebuild ( );
+    HOST_CHECK_EQUAL ( iTranslation ( TEST_SRC_ID ), -1 );
+
+    vAPP_GP_LoadPDMData ( );
+    HOST_CHECK ( memcmp ( &sSaved, &sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[4],
+                          sizeof ( sSaved ) ) == 0 );
+    HOST_CHECK_EQUAL ( iTranslation ( TEST_SRC_ID ), 0 );
+    HOST_CHECK_EQUAL ( sGP_PDM_Data.u32RestoreGPPDMInfo & PDM_VALID_BITS, GP_PDM_DATA_VALID );
+
+    /* Restored contents are not rewritten */
+    u32Before =  u32Writes ( );
+    vPersist ( );
+    HOST_CHECK_EQUAL ( u32Writes ( ) - u32Before, 0 );
+}
+
+/* Whole table records of earlier builds become per entry records */
+PRIVATE void vLegacyRecordsMigrate ( void )
+{
+    tsGP_ZgppProxySinkTable    asTable[GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES];
+    tsGP_PDM_Data              sLegacy;
+
+    vReset ( );
+    memset ( asTable, 0, sizeof ( asTable ) );
+    asTable[1].bProxyTableEntryOccupied      =  TRUE;
+    asTable[1].uZgpdDeviceAddr.u32ZgpdSrcId  =  TEST_SRC_ID;
+    memset ( &sLegacy, 0, sizeof ( sLegacy ) );
+    sLegacy.u32RestoreGPPDMInfo                                 =  GP_PDM_DATA_VALID;
+    sLegacy.asGpTranslationTable[3].uZgpdDeviceAddr.u32ZgpdSrcId =  TEST_SRC_ID;
+    PDM_eSaveRecordData ( PDM_ID_APP_CLD_GP_SINK_PROXY_TABLE, asTable, sizeof ( asTable ) );
+    PDM_eSaveRecordData ( PDM_ID_APP_CLD_GP_TRANS_TABLE, &sLegacy, sizeof ( sLegacy ) );
+
+    vAPP_GP_LoadPDMData ( );
+    HOST_CHECK ( !bExists ( PDM_ID_APP_CLD_GP_SINK_PROXY_TABLE ) );
+    HOST_CHECK ( !bExists ( PDM_ID_APP_CLD_GP_TRANS_TABLE ) );
+    HOST_CHECK ( bExists ( PDM_ID_APP_CLD_GP_RESTORE_INFO ) );
+    HOST_CHECK ( bExists ( PDM_ID_APP_CLD_GP_SINK_PROXY_ENTRY + 1 ) );
+    HOST_CHECK ( bExists ( PDM_ID_APP_CLD_GP_TRANS_ENTRY + 3 ) );
+    HOST_CHECK ( !bExists ( PDM_ID_APP_CLD_GP_TRANS_ENTRY + 0 ) );
+    HOST_CHECK_EQUAL ( sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[1].uZgpdDeviceAddr.u32ZgpdSrcId,
+                       TEST_SRC_ID );
+    HOST_CHECK_EQUAL ( iTranslation ( TEST_SRC_ID ), 3 );
+}
+
+/* Recommissioning replaces a GPD's entry, decommissioning clears it and a
+ * full table refuses new GPDs */
+PRIVATE void vTranslationIndex ( void )
+{
+    uint8    i;
+
+    vReset ( );
+    HOST_CHECK_EQUAL ( eCommission ( TEST_SRC_ID ), E_ZCL_SUCCESS );
+    HOST_CHECK_EQUAL ( eCommission ( TEST_SRC_ID + 1 ), E_ZCL_SUCCESS );
+    HOST_CHECK_EQUAL ( eCommission ( TEST_SRC_ID ), E_ZCL_SUCCESS );
+    HOST_CHECK_EQUAL ( u8TranslationsUsed ( ), 2 );
+    HOST_CHECK ( iTranslation ( TEST_SRC_ID ) >= 0 );
+    HOST_CHECK ( iTranslation ( TEST_SRC_ID + 1 ) >= 0 );
+    HOST_CHECK_EQUAL ( iTranslation ( TEST_SRC_ID + 2 ), -1 );
+
+    vDecommission ( TEST_SRC_ID );
+    HOST_CHECK_EQUAL ( iTranslation ( TEST_SRC_ID ), -1 );
+    HOST_CHECK ( iTranslation ( TEST_SRC_ID + 1 ) >= 0 );
+    HOST_CHECK_EQUAL ( u8TranslationsUsed ( ), 1 );
+
+    for ( i = 0; i < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES - 1; i++ )
+    {
+        HOST_CHECK_EQUAL ( eCommission ( TEST_SRC_ID + 10 + i ), E_ZCL_SUCCESS );
+    }
+    HOST_CHECK_EQUAL ( u8TranslationsUsed ( ), GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES );
+    HOST_CHECK_EQUAL ( eCommission ( TEST_SRC_ID + 20 ), E_ZCL_FAIL );
+
+    /* An entry for every source id matches any lookup */
+    sGP_PDM_Data.asGpTranslationTable[0].uZgpdDeviceAddr.u32ZgpdSrcId =  0xFFFFFFFF;
+    vApp_GPTransIndexUpdate ( 0 );
+    HOST_CHECK_EQUAL ( iTranslation ( TEST_SRC_ID + 20 ), 0 );
+}
+
+/* With every other slot of both tables taken, a GPD is commissioned into
+ * the last ones and persisted, then decommissioned again; GPDFs from the
+ * last GPD and from an unknown one are looked up in between */
+PRIVATE void vFullTableCost ( void )
+{
+    volatile int    iFound =  0;
+    uint64          u64Commission =  0;
+    uint64          u64Start;
+    uint32          u32Bytes =  0;
+    uint32          u32Before;
+    uint32          u32LastId =  TEST_SRC_ID + GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES - 1;
+    uint32          i;
+
+    vReset ( );
+    for ( i = 0; i < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES - 1; i++ )
+    {
+        HOST_CHECK_EQUAL ( eCommission ( TEST_SRC_ID + i ), E_ZCL_SUCCESS );
+    }
+    for ( i = 0; i < GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES - 1; i++ )
+    {
+        vOccupy ( i, TEST_SRC_ID + i );
+    }
+    vPersist ( );
+
+    for ( i = 0; i < TEST_COMMISSIONINGS; i++ )
+    {
+        vOccupy ( GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES - 1, u32LastId );
+        u32Before =  HOST_u32PdmWriteBytes ( );
+        u64Start  =  u64Ns ( );
+        HOST_CHECK_EQUAL ( eCommission ( u32LastId ), E_ZCL_SUCCESS );
+        u64Commission +=  u64Ns ( ) - u64Start;
+        vPersist ( );
+        u32Bytes +=  HOST_u32PdmWriteBytes ( ) - u32Before;
+
+        vDecommission ( u32LastId );
+        memset ( &sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES - 1],
+                 0, sizeof ( tsGP_ZgppProxySinkTable ) );
+        vPersist ( );
+    }
+    HOST_CHECK_EQUAL ( u8TranslationsUsed ( ), GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES - 1 );
+
+    /* A commissioning writes its own entries, not either whole table */
+    HOST_CHECK ( u32Bytes / TEST_COMMISSIONINGS <
+                 sizeof ( sGP_PDM_Data ) + sizeof ( sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable ) );
+
+    HOST_CHECK_EQUAL ( eCommission ( u32LastId ), E_ZCL_SUCCESS );
+    HOST_CHECK_EQUAL ( u8TranslationsUsed ( ), GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES );
+    u64Start =  u64Ns ( );
+    for ( i = 0; i < TEST_LOOKUPS; i++ )
+    {
+        iFound +=  iTranslation ( u32LastId );
+    }
+    printf ( "  %u translation entries, %u sink entries: commissioning %.0f ns, %u flash bytes written\n",
+             GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES, GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES,
+             ( double ) u64Commission / TEST_COMMISSIONINGS, u32Bytes / TEST_COMMISSIONINGS );
+    printf ( "  GPDF lookup: %.1f ns for the last GPD, ", ( double ) ( u64Ns ( ) - u64Start ) / TEST_LOOKUPS );
+
+    u64Start =  u64Ns ( );
+    for ( i = 0; i < TEST_LOOKUPS; i++ )
+    {
+        iFound +=  iTranslation ( TEST_SRC_ID - 1 );
+    }
+    printf ( "%.1f ns for an unknown one\n", ( double ) ( u64Ns ( ) - u64Start ) / TEST_LOOKUPS );
+    HOST_CHECK_EQUAL ( iFound, TEST_LOOKUPS * ( iTranslation ( u32LastId ) - 1 ) );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vPersistWritesChangedEntries );
+    HOST_TEST ( vNoPersistBeforeLoad );
+    HOST_TEST ( vLoadRestoresEntries );
+    HOST_TEST ( vLegacyRecordsMigrate );
+    HOST_TEST ( vTranslationIndex );
+    HOST_TEST ( vFullTableCost );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,290 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_ota_block_size.c
+ *
+ * DESCRIPTION:        OTA block sizes per destination: the limit derived
+ *                     from the stack payload size, the size given to block
+ *                     requests, host blocks trimmed to it and the counters of
+ *                     E_SL_MSG_GET_OTA_BLOCK_SIZE
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zcl.h"
+#include "zcl_options.h"
+#include "SerialLink.h"
+#include "app_ota_server.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_CLIENT                     0x4100
+#define TEST_FAR_CLIENT                 0x4200
+#define TEST_ENDPOINT                   1
+
+#define TEST_OTA_CLUSTER                0x0019
+#define TEST_BLOCK_REQUEST              0x03
+#define TEST_BLOCK_RESPONSE             0x05
+
+/* Offsets into the 0x8501 and 0x805A payloads */
+#define TEST_REQ_MAX_DATA_SIZE          29
+#define TEST_BS_MAX_PAYLOAD             2
+#define TEST_BS_SIZE                    3
+#define TEST_BS_CEILING                 4
+#define TEST_BS_SIZED                   5
+#define TEST_BS_REDUCED                 9
+#define TEST_BS_SMALLEST                13
+#define TEST_BS_LARGEST                 14
+
+/* Data size field of a block response ASDU */
+#define TEST_RSP_DATA_SIZE              16
+
+#define TEST_U16( PAYLOAD, OFFSET )     ( ( ( PAYLOAD )[OFFSET] << 8 ) | ( PAYLOAD )[( OFFSET ) + 1] )
+#define TEST_U32( PAYLOAD, OFFSET )     ( ( ( uint32 ) TEST_U16 ( PAYLOAD, OFFSET ) << 16 ) | TEST_U16 ( PAYLOAD, ( OFFSET ) + 2 ) )
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE uint8    u8TestBlock;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* Image block request from a client, each for the next block so that none
+ * joins a host fetch still outstanding; the server forwards it to the host */
+PRIVATE void vBlockRequest ( uint16    u16Addr,
+                             uint8     u8MaxDataSize )
+{
+    uint8    au8Request[] =
+    {
+        0x01, 0x10, TEST_BLOCK_REQUEST,
+        0x00,                           /* field control */
+        0x37, 0x10,                     /* manufacturer */
+        0x01, 0x00,                     /* image type */
+        0x02, 0x00, 0x00, 0x00,         /* file version */
+        0x00, 0x01, 0x00, 0x00,         /* file offset */
+        0x00                            /* max data size */
+    };
+
+    au8Request[14] =  ++u8TestBlock;
+    au8Request[sizeof ( au8Request ) - 1] =  u8MaxDataSize;
+    HOST_vDataIndication ( u16Addr, TEST_ENDPOINT, TEST_ENDPOINT, TEST_OTA_CLUSTER, 0x0104,
+                           au8Request, sizeof ( au8Request ) );
+    HOST_vRun ( 20 );
+}
+
+/* Max data size the host was asked for, 0 if no request came through */
+PRIVATE uint8 u8ForwardedSize ( void )
+{
+    tsHostSerialFrame    sFrame;
+
+    return HOST_bSerialFind ( E_SL_MSG_BLOCK_REQUEST, &sFrame ) ? sFrame.au8Payload[TEST_REQ_MAX_DATA_SIZE] : 0;
+}
+
+/* Host answer with a block of u8Size bytes */
+PRIVATE void vBlockSend ( uint16    u16Addr,
+                          uint8     u8Size )
+{
+    uint8     au8Send[20 + 255];
+    uint16    i;
+
+    memset ( au8Send, 0, sizeof ( au8Send ) );
+    au8Send[0]  =  E_ZCL_AM_SHORT;
+    au8Send[1]  =  ( uint8 ) ( u16Addr >> 8 );
+    au8Send[2]  =  ( uint8 ) u16Addr;
+    au8Send[3]  =  TEST_ENDPOINT;
+    au8Send[4]  =  TEST_ENDPOINT;
+    au8Send[5]  =  0x10;
+    au8Send[10] =  0x01;
+    au8Send[14] =  0x02;
+    au8Send[16] =  0x01;
+    au8Send[17] =  0x10;
+    au8Send[18] =  0x37;
+    au8Send[19] =  u8Size;
+    for ( i = 0; i < u8Size; i++ )
+    {
+        au8Send[20 + i] =  ( uint8 ) i;
+    }
+    HOST_vSerialWrite ( E_SL_MSG_BLOCK_SEND, 20 + u8Size, au8Send );
+    HOST_vRun ( 20 );
+}
+
+/* Requests the block size report for an address */
+PRIVATE bool_t bBlockSizeReport ( uint16    u16Addr,
+                                  uint8     u8Options,
+                                  tsHostSerialFrame*    psFrame )
+{
+    uint8    au8Request[3];
+
+    au8Request[0] =  ( uint8 ) ( u16Addr >> 8 );
+    au8Request[1] =  ( uint8 ) u16Addr;
+    au8Request[2] =  u8Options;
+    HOST_vSerialFlush ( );
+    HOST_vSerialWrite ( E_SL_MSG_GET_OTA_BLOCK_SIZE, sizeof ( au8Request ), au8Request );
+    HOST_vRun ( 20 );
+    return HOST_bSerialFind ( E_SL_MSG_OTA_BLOCK_SIZE, psFrame );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* The limit is the payload to the destination less the response header,
+ * between 1 and the OTA_MAX_BLOCK_SIZE ceiling */
+PRIVATE void vBlockLimit ( void )
+{
+    HOST_vInit ( );
+    HOST_CHECK_EQUAL ( APP_u8OtaServerBlockLimit ( TEST_CLIENT ), HOST_ZPS_MAX_PAYLOAD - OTA_BLOCK_RESPONSE_OVERHEAD );
+
+    /* Two relays and APS security */
+    HOST_vSetMaxPayload ( TEST_CLIENT, 56 );
+    HOST_CHECK_EQUAL ( APP_u8OtaServerBlockLimit ( TEST_CLIENT ), 56 - OTA_BLOCK_RESPONSE_OVERHEAD );
+    HOST_vSetMaxPayload ( TEST_CLIENT, OTA_BLOCK_RESPONSE_OVERHEAD + 1 );
+    HOST_CHECK_EQUAL ( APP_u8OtaServerBlockLimit ( TEST_CLIENT ), 1 );
+
+    /* More room than the buffers hold */
+    HOST_vSetMaxPayload ( TEST_CLIENT, OTA_BLOCK_RESPONSE_OVERHEAD + OTA_MAX_BLOCK_SIZE );
+    HOST_CHECK_EQUAL ( APP_u8OtaServerBlockLimit ( TEST_CLIENT ), OTA_MAX_BLOCK_SIZE );
+    HOST_vSetMaxPayload ( TEST_CLIENT, 255 );
+    HOST_CHECK_EQUAL ( APP_u8OtaServerBlockLimit ( TEST_CLIENT ), OTA_MAX_BLOCK_SIZE );
+
+    /* No room reported: the ceiling, left to APS fragmentation */
+    HOST_vSetMaxPayload ( TEST_CLIENT, OTA_BLOCK_RESPONSE_OVERHEAD );
+    HOST_CHECK_EQUAL ( APP_u8OtaServerBlockLimit ( TEST_CLIENT ), OTA_MAX_BLOCK_SIZE );
+    HOST_vSetMaxPayload ( TEST_CLIENT, 0 );
+    HOST_CHECK_EQUAL ( APP_u8OtaServerBlockLimit ( TEST_CLIENT ), OTA_MAX_BLOCK_SIZE );
+
+    /* Other destinations keep their own limit */
+    HOST_CHECK_EQUAL ( APP_u8OtaServerBlockLimit ( TEST_FAR_CLIENT ), HOST_ZPS_MAX_PAYLOAD - OTA_BLOCK_RESPONSE_OVERHEAD );
+}
+
+/* Block requests get the smaller of the asked size and the limit; the
+ * host is asked for that size */
+PRIVATE void vBlockRequestSized ( void )
+{
+    uint8    u8Far =  48 - OTA_BLOCK_RESPONSE_OVERHEAD;
+
+    HOST_vInit ( );
+    vAppInitOTA ( );
+    HOST_vAddDevice ( TEST_CLIENT, 0x00158D0000410000ULL, FALSE );
+    HOST_vAddDevice ( TEST_FAR_CLIENT, 0x00158D0000420000ULL, FALSE );
+    HOST_vSetMaxPayload ( TEST_FAR_CLIENT, 48 );
+
+    vBlockRequest ( TEST_CLIENT, 64 );
+    HOST_CHECK_EQUAL ( u8ForwardedSize ( ), 64 );
+    vBlockRequest ( TEST_CLIENT, 80 );
+    HOST_CHECK_EQUAL ( u8ForwardedSize ( ), HOST_ZPS_MAX_PAYLOAD - OTA_BLOCK_RESPONSE_OVERHEAD );
+    vBlockRequest ( TEST_FAR_CLIENT, 64 );
+    HOST_CHECK_EQUAL ( u8ForwardedSize ( ), u8Far );
+    vBlockRequest ( TEST_FAR_CLIENT, 16 );
+    HOST_CHECK_EQUAL ( u8ForwardedSize ( ), 16 );
+}
+
+/* A host block larger than one frame to the client is trimmed */
+PRIVATE void vHostBlockTrimmed ( void )
+{
+    tsHostDataReq*    psReq;
+    uint8             u8Far =  48 - OTA_BLOCK_RESPONSE_OVERHEAD;
+
+    HOST_vInit ( );
+    vAppInitOTA ( );
+    HOST_vAddDevice ( TEST_FAR_CLIENT, 0x00158D0000420000ULL, FALSE );
+    HOST_vSetMaxPayload ( TEST_FAR_CLIENT, 48 );
+
+    vBlockSend ( TEST_FAR_CLIENT, 64 );
+    psReq =  HOST_psDataReq ( HOST_u32DataReqCount ( ) - 1 );
+    HOST_CHECK ( psReq != NULL );
+    if ( psReq != NULL )
+    {
+        HOST_CHECK_EQUAL ( psReq->u16ClusterId, TEST_OTA_CLUSTER );
+        HOST_CHECK_EQUAL ( psReq->au8Payload[2], TEST_BLOCK_RESPONSE );
+        HOST_CHECK_EQUAL ( psReq->au8Payload[TEST_RSP_DATA_SIZE], u8Far );
+        HOST_CHECK_EQUAL ( psReq->u16PayloadLength, 48 );
+        HOST_CHECK ( psReq->u16PayloadLength <= ZPS_u8AplGetMaxPayloadSize ( NULL, TEST_FAR_CLIENT ) );
+        HOST_CHECK_EQUAL ( psReq->au8Payload[TEST_RSP_DATA_SIZE + u8Far], u8Far - 1 );
+    }
+
+    /* Blocks that fit go out untouched */
+    vBlockSend ( TEST_FAR_CLIENT, 20 );
+    psReq =  HOST_psDataReq ( HOST_u32DataReqCount ( ) - 1 );
+    HOST_CHECK ( ( psReq != NULL ) && ( psReq->au8Payload[TEST_RSP_DATA_SIZE] == 20 ) );
+}
+
+/* Requests sized, requests reduced and the range, cleared on request */
+PRIVATE void vBlockSizeReport ( void )
+{
+    tsHostSerialFrame    sFrame;
+
+    HOST_vInit ( );
+    vAppInitOTA ( );
+    HOST_vAddDevice ( TEST_CLIENT, 0x00158D0000410000ULL, FALSE );
+    HOST_vSetMaxPayload ( TEST_CLIENT, 60 );
+    HOST_CHECK ( bBlockSizeReport ( TEST_CLIENT, 0x01, &sFrame ) );
+    vBlockRequest ( TEST_CLIENT, 32 );
+    vBlockRequest ( TEST_CLIENT, 64 );
+    vBlockRequest ( TEST_CLIENT, 80 );
+
+    HOST_CHECK ( bBlockSizeReport ( TEST_CLIENT, 0x01, &sFrame ) );
+    HOST_CHECK_EQUAL ( TEST_U16 ( sFrame.au8Payload, 0 ), TEST_CLIENT );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_BS_MAX_PAYLOAD], 60 );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_BS_SIZE], 60 - OTA_BLOCK_RESPONSE_OVERHEAD );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_BS_CEILING], OTA_MAX_BLOCK_SIZE );
+    HOST_CHECK_EQUAL ( TEST_U32 ( sFrame.au8Payload, TEST_BS_SIZED ), 3 );
+    HOST_CHECK_EQUAL ( TEST_U32 ( sFrame.au8Payload, TEST_BS_REDUCED ), 2 );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_BS_SMALLEST], 32 );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_BS_LARGEST], 60 - OTA_BLOCK_RESPONSE_OVERHEAD );
+
+    HOST_CHECK ( bBlockSizeReport ( TEST_FAR_CLIENT, 0, &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_BS_MAX_PAYLOAD], HOST_ZPS_MAX_PAYLOAD );
+    HOST_CHECK_EQUAL ( TEST_U32 ( sFrame.au8Payload, TEST_BS_SIZED ), 0 );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_BS_SMALLEST], 0 );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vBlockLimit );
+    HOST_TEST ( vBlockRequestSized );
+    HOST_TEST ( vHostBlockTrimmed );
+    HOST_TEST ( vBlockSizeReport );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
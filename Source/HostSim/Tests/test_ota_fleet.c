@@ -0,0 +1,572 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_ota_fleet.c
+ *
+ * DESCRIPTION:        1, 8 and 32 clients downloading the same image held by
+ *                     the host, through the OTA cluster and app_ota_fleet.c:
+ *                     block request clients with the shared block cache and
+ *                     with every block fetched for its own client, then page
+ *                     request clients streamed from the tick. Reports the
+ *                     time until the last client has the image, the UART
+ *                     bytes both ways and the airtime of the OTA frames.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zcl.h"
+#include "OTA.h"
+#include "SerialLink.h"
+#include "app_ota_server.h"
+#include "app_ota_fleet.h"
+#include "app_aps_queue.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_CLIENT_BASE                0x5000
+#define TEST_IEEE_BASE                  0x00158D0000500000ULL
+#define TEST_ENDPOINT                   1
+
+#define TEST_OTA_CLUSTER                0x0019
+#define TEST_PAGE_REQUEST               0x04
+#define TEST_BLOCK_REQUEST              0x03
+#define TEST_BLOCK_RESPONSE             0x05
+
+#define TEST_MANUFACTURER               0x1037
+#define TEST_IMAGE_TYPE                 0x0001
+#define TEST_FILE_VERSION               0x00000002
+
+#define TEST_IMAGE_SIZE                 4096
+#define TEST_BLOCK_SIZE                 64
+#define TEST_BLOCKS                     ( TEST_IMAGE_SIZE / TEST_BLOCK_SIZE )
+#define TEST_PAGE_SIZE                  1024
+
+/* Clients start this far apart, wait this long after a block before asking
+ * for the next one, and ask again when nothing came for the timeout */
+#define TEST_STAGGER_MS                 5
+#define TEST_CLIENT_DELAY_MS            50
+#define TEST_CLIENT_TIMEOUT_MS          5000
+#define TEST_PAGE_SPACING_MS            OTA_PAGE_REQ_RESPONSE_SPACING
+#define TEST_RUN_LIMIT_MS               300000
+
+/* Block requests the host holds, answered one at a time: the next is sent
+ * once the last one's status is back, again after the delay if busy */
+#define TEST_HOST_QUEUE                 64
+#define TEST_HOST_BUSY_DELAY_MS         10
+
+/* Secured unicast on air: PHY 6, MAC 11, NWK 8 plus 18 of security and
+ * APS 8 bytes around the ZCL frame, at 32 us a byte */
+#define TEST_AIR_OVERHEAD               51
+#define TEST_AIR_US_PER_BYTE            32
+
+/* Start, type, length, CRC and end around a serial payload */
+#define TEST_UART_OVERHEAD              7
+
+/* Offsets into the 0x8501 payload and into a block response ASDU */
+#define TEST_REQ_LENGTH                 31
+#define TEST_REQ_TSN                    0
+#define TEST_REQ_ADDRESS                5
+#define TEST_REQ_OFFSET                 15
+#define TEST_REQ_IMAGE                  19
+#define TEST_REQ_MAX_DATA_SIZE          29
+#define TEST_RSP_STATUS                 3
+#define TEST_RSP_OFFSET                 12
+#define TEST_RSP_DATA_SIZE              16
+
+/* Offsets into the E_SL_MSG_STATUS payload */
+#define TEST_STATUS_TYPE                2
+#define TEST_STATUS_SENT                4
+
+/* Offsets into the E_SL_MSG_OTA_FLEET_STATS summary */
+#define TEST_STATS_CACHE_HITS           15
+#define TEST_STATS_COALESCED            19
+
+#define TEST_U16( PAYLOAD, OFFSET )     ( ( ( PAYLOAD )[OFFSET] << 8 ) | ( PAYLOAD )[( OFFSET ) + 1] )
+#define TEST_U32( PAYLOAD, OFFSET )     ( ( ( uint32 ) TEST_U16 ( PAYLOAD, OFFSET ) << 16 ) | TEST_U16 ( PAYLOAD, ( OFFSET ) + 2 ) )
+#define TEST_LE32( PAYLOAD, OFFSET )    ( ( uint32 ) ( PAYLOAD )[OFFSET] |                      \
+                                          ( ( uint32 ) ( PAYLOAD )[( OFFSET ) + 1] << 8 ) |     \
+                                          ( ( uint32 ) ( PAYLOAD )[( OFFSET ) + 2] << 16 ) |    \
+                                          ( ( uint32 ) ( PAYLOAD )[( OFFSET ) + 3] << 24 ) )
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+    E_TEST_BLOCKS_SHARED,
+    E_TEST_BLOCKS_PER_CLIENT,
+    E_TEST_PAGES
+} teTestMode;
+
+typedef struct
+{
+    uint32    u32Offset;
+    uint32    u32PageEnd;
+    uint32    u32NextMs;
+    uint32    u32LastMs;
+    uint32    u32DoneMs;
+    uint8     u8Tsn;
+    bool_t    bWaiting;
+} tsTestClient;
+
+typedef struct
+{
+    uint8     au8Request[TEST_HOST_QUEUE][TEST_REQ_LENGTH];
+    uint32    u32RetryMs;
+    uint8     u8Head;
+    uint8     u8Count;
+    bool_t    bSent;
+} tsTestHost;
+
+typedef struct
+{
+    uint32    u32Ms;
+    uint32    u32UartBytes;
+    uint32    u32AirUs;
+    uint32    u32HostFetches;
+    uint32    u32CacheHits;
+    uint32    u32Coalesced;
+    uint32    u32Corrupt;
+    uint32    u32MaxPerTick;
+    uint8     u8Complete;
+} tsTestRun;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE uint8           au8TestImage[TEST_IMAGE_SIZE];
+PRIVATE tsTestClient    asTestClient[OTA_FLEET_MAX_CLIENTS];
+PRIVATE tsTestHost      sTestHost;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE void vPut32 ( uint8*    pu8Buffer,
+                      uint32    u32Value )
+{
+    pu8Buffer[0] =  ( uint8 ) ( u32Value >> 24 );
+    pu8Buffer[1] =  ( uint8 ) ( u32Value >> 16 );
+    pu8Buffer[2] =  ( uint8 ) ( u32Value >> 8 );
+    pu8Buffer[3] =  ( uint8 ) u32Value;
+}
+
+/* Sends the client's next block request or, in page mode, a request for
+ * the page holding its next block; returns the ZCL frame length */
+PRIVATE uint16 u16ClientRequest ( uint8         u8Client,
+                                  teTestMode    eMode )
+{
+    tsTestClient*    psClient =  &asTestClient[u8Client];
+    uint8            au8Request[] =
+    {
+        0x01, 0x00, TEST_BLOCK_REQUEST,
+        0x00,                           /* field control */
+        ( uint8 ) TEST_MANUFACTURER, ( uint8 ) ( TEST_MANUFACTURER >> 8 ),
+        ( uint8 ) TEST_IMAGE_TYPE, ( uint8 ) ( TEST_IMAGE_TYPE >> 8 ),
+        ( uint8 ) TEST_FILE_VERSION, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,         /* file offset */
+        TEST_BLOCK_SIZE,                /* max data size */
+        0x00, 0x00,                     /* page size */
+        0x00, 0x00                      /* response spacing */
+    };
+    uint16           u16Length =  17;
+
+    au8Request[1]  =  psClient->u8Tsn++;
+    /* As before the fleet: each client on an image of its own, nothing shared */
+    if ( eMode == E_TEST_BLOCKS_PER_CLIENT )
+    {
+        au8Request[6] =  ( uint8 ) ( TEST_IMAGE_TYPE + u8Client );
+    }
+    au8Request[12] =  ( uint8 ) psClient->u32Offset;
+    au8Request[13] =  ( uint8 ) ( psClient->u32Offset >> 8 );
+    au8Request[14] =  ( uint8 ) ( psClient->u32Offset >> 16 );
+    if ( eMode == E_TEST_PAGES )
+    {
+        psClient->u32PageEnd =  psClient->u32Offset + TEST_PAGE_SIZE;
+        if ( psClient->u32PageEnd > TEST_IMAGE_SIZE )
+        {
+            psClient->u32PageEnd =  TEST_IMAGE_SIZE;
+        }
+        au8Request[2]  =  TEST_PAGE_REQUEST;
+        au8Request[17] =  ( uint8 ) ( psClient->u32PageEnd - psClient->u32Offset );
+        au8Request[18] =  ( uint8 ) ( ( psClient->u32PageEnd - psClient->u32Offset ) >> 8 );
+        au8Request[19] =  ( uint8 ) TEST_PAGE_SPACING_MS;
+        au8Request[20] =  ( uint8 ) ( TEST_PAGE_SPACING_MS >> 8 );
+        u16Length      =  sizeof ( au8Request );
+    }
+    HOST_vDataIndication ( TEST_CLIENT_BASE + u8Client, TEST_ENDPOINT, TEST_ENDPOINT, TEST_OTA_CLUSTER, 0x0104,
+                           au8Request, u16Length );
+    psClient->bWaiting  =  TRUE;
+    psClient->u32LastMs =  HOST_u32TimeMs ( );
+    return u16Length;
+}
+
+/* Answers a forwarded block request from the image, returning the length
+ * of the E_SL_MSG_BLOCK_SEND payload */
+PRIVATE uint16 u16HostBlockSend ( const uint8*    pu8Request )
+{
+    uint8     au8Send[20 + 255];
+    uint32    u32Offset =  TEST_U32 ( pu8Request, TEST_REQ_OFFSET );
+    uint8     u8Size    =  pu8Request[TEST_REQ_MAX_DATA_SIZE];
+
+    if ( u32Offset >= TEST_IMAGE_SIZE )
+    {
+        return 0;
+    }
+    if ( u8Size > ( TEST_IMAGE_SIZE - u32Offset ) )
+    {
+        u8Size =  ( uint8 ) ( TEST_IMAGE_SIZE - u32Offset );
+    }
+    memset ( au8Send, 0, sizeof ( au8Send ) );
+    au8Send[0]  =  E_ZCL_AM_SHORT;
+    au8Send[1]  =  pu8Request[TEST_REQ_ADDRESS];
+    au8Send[2]  =  pu8Request[TEST_REQ_ADDRESS + 1];
+    au8Send[3]  =  TEST_ENDPOINT;
+    au8Send[4]  =  TEST_ENDPOINT;
+    au8Send[5]  =  pu8Request[TEST_REQ_TSN];
+    vPut32 ( &au8Send[7], u32Offset );
+    /* File version, image type and manufacturer as asked */
+    memcpy ( &au8Send[11], &pu8Request[TEST_REQ_IMAGE], 8 );
+    au8Send[19] =  u8Size;
+    memcpy ( &au8Send[20], &au8TestImage[u32Offset], u8Size );
+    HOST_vSerialWrite ( E_SL_MSG_BLOCK_SEND, 20 + u8Size, au8Send );
+    return 20 + u8Size;
+}
+
+/* Takes the firmware's frames as the host does: block requests are queued,
+ * the status of a block send moves the queue on, then the next block send
+ * goes if there is one due. A send the APS queue holds has its status
+ * once it has been carried out. */
+PRIVATE void vHostService ( tsTestRun*    psRun )
+{
+    tsHostSerialFrame    sFrame;
+    uint8                u8Tail;
+
+    while ( HOST_bSerialRead ( &sFrame ) )
+    {
+        psRun->u32UartBytes +=  TEST_UART_OVERHEAD + sFrame.u16Length;
+        if ( ( sFrame.u16Type == E_SL_MSG_BLOCK_REQUEST ) &&
+             ( sFrame.u16Length >= TEST_REQ_LENGTH ) &&
+             ( sTestHost.u8Count < TEST_HOST_QUEUE ) )
+        {
+            u8Tail =  ( sTestHost.u8Head + sTestHost.u8Count ) % TEST_HOST_QUEUE;
+            memcpy ( sTestHost.au8Request[u8Tail], sFrame.au8Payload, TEST_REQ_LENGTH );
+            sTestHost.u8Count++;
+            psRun->u32HostFetches++;
+        }
+        else if ( ( sFrame.u16Type == E_SL_MSG_STATUS ) &&
+                  ( TEST_U16 ( sFrame.au8Payload, TEST_STATUS_TYPE ) == E_SL_MSG_BLOCK_SEND ) &&
+                  ( sFrame.au8Payload[TEST_STATUS_SENT] != APS_QUEUE_REQUEST_QUEUED ) &&
+                  sTestHost.bSent )
+        {
+            sTestHost.bSent =  FALSE;
+            if ( sFrame.au8Payload[0] == E_SL_MSG_STATUS_BUSY )
+            {
+                sTestHost.u32RetryMs =  HOST_u32TimeMs ( ) + TEST_HOST_BUSY_DELAY_MS;
+            }
+            else
+            {
+                sTestHost.u8Head =  ( sTestHost.u8Head + 1 ) % TEST_HOST_QUEUE;
+                sTestHost.u8Count--;
+            }
+        }
+    }
+
+    if ( !sTestHost.bSent &&
+         ( sTestHost.u8Count > 0 ) &&
+         ( ( int32 ) ( HOST_u32TimeMs ( ) - sTestHost.u32RetryMs ) >= 0 ) )
+    {
+        psRun->u32UartBytes +=  TEST_UART_OVERHEAD + u16HostBlockSend ( sTestHost.au8Request[sTestHost.u8Head] );
+        sTestHost.bSent =  TRUE;
+    }
+}
+
+/* Confirms a data request and, for a block response, moves its client on;
+ * returns TRUE for a block response */
+PRIVATE bool_t bTakeResponse ( tsHostDataReq*    psReq,
+                               teTestMode        eMode,
+                               tsTestRun*        psRun )
+{
+    tsTestClient*    psClient;
+    uint32           u32Offset;
+    uint8            u8Size;
+    uint32           u32Now =  HOST_u32TimeMs ( );
+
+    HOST_bDataConfirm ( psReq->u8ApsSeqNum, ZPS_E_SUCCESS );
+    if ( ( psReq->u16ClusterId != TEST_OTA_CLUSTER ) ||
+         ( psReq->au8Payload[2] != TEST_BLOCK_RESPONSE ) ||
+         ( psReq->au8Payload[TEST_RSP_STATUS] != OTA_STATUS_SUCCESS ) ||
+         ( psReq->u16DstAddr < TEST_CLIENT_BASE ) ||
+         ( psReq->u16DstAddr >= ( TEST_CLIENT_BASE + OTA_FLEET_MAX_CLIENTS ) ) )
+    {
+        return FALSE;
+    }
+    psRun->u32AirUs +=  ( psReq->u16PayloadLength + TEST_AIR_OVERHEAD ) * TEST_AIR_US_PER_BYTE;
+
+    psClient  =  &asTestClient[psReq->u16DstAddr - TEST_CLIENT_BASE];
+    u32Offset =  TEST_LE32 ( psReq->au8Payload, TEST_RSP_OFFSET );
+    u8Size    =  psReq->au8Payload[TEST_RSP_DATA_SIZE];
+    if ( ( u32Offset != psClient->u32Offset ) ||
+         ( ( u32Offset + u8Size ) > TEST_IMAGE_SIZE ) )
+    {
+        return TRUE;
+    }
+    if ( memcmp ( &psReq->au8Payload[TEST_RSP_DATA_SIZE + 1], &au8TestImage[u32Offset], u8Size ) != 0 )
+    {
+        psRun->u32Corrupt++;
+    }
+    psClient->u32Offset +=  u8Size;
+    psClient->u32LastMs  =  u32Now;
+    if ( ( eMode != E_TEST_PAGES ) || ( psClient->u32Offset >= psClient->u32PageEnd ) )
+    {
+        psClient->bWaiting  =  FALSE;
+        psClient->u32NextMs =  u32Now + TEST_CLIENT_DELAY_MS;
+    }
+    if ( psClient->u32Offset >= TEST_IMAGE_SIZE )
+    {
+        psClient->u32DoneMs =  u32Now;
+        psRun->u8Complete++;
+    }
+    return TRUE;
+}
+
+/* Reads the fleet's cache hits and coalesced requests, u8Options as for
+ * E_SL_MSG_GET_OTA_FLEET_STATS */
+PRIVATE void vReadStats ( tsTestRun*    psRun,
+                          uint8         u8Options )
+{
+    tsHostSerialFrame    sFrame;
+    uint32               i;
+
+    HOST_vSerialFlush ( );
+    HOST_vSerialWrite ( E_SL_MSG_GET_OTA_FLEET_STATS, 1, &u8Options );
+    for ( i = 0; i < 200; i++ )
+    {
+        HOST_vRun ( 1 );
+        if ( HOST_bSerialFind ( E_SL_MSG_OTA_FLEET_STATS, &sFrame ) &&
+             ( sFrame.au8Payload[0] == OTA_FLEET_SECTION_SUMMARY ) )
+        {
+            psRun->u32CacheHits   =  TEST_U32 ( sFrame.au8Payload, TEST_STATS_CACHE_HITS );
+            psRun->u32Coalesced   =  TEST_U32 ( sFrame.au8Payload, TEST_STATS_COALESCED );
+            return;
+        }
+    }
+}
+
+/* Runs u8Clients downloads to the end, or to the run limit */
+PRIVATE void vRunFleet ( uint8         u8Clients,
+                         teTestMode    eMode,
+                         tsTestRun*    psRun )
+{
+    tsHostDataReq*       psReq;
+    uint32               u32Start;
+    uint32               u32Now;
+    uint32               u32Seen;
+    uint32               u32Tick      =  0;
+    uint32               u32TickCount =  0;
+    uint8                i;
+
+    memset ( psRun, 0, sizeof ( tsTestRun ) );
+    memset ( asTestClient, 0, sizeof ( asTestClient ) );
+    memset ( &sTestHost, 0, sizeof ( sTestHost ) );
+    HOST_vInit ( );
+    vAppInitOTA ( );
+    /* The fleet outlives HOST_vInit, as it would a stack restart */
+    APP_vOtaFleetReset ( );
+    vReadStats ( psRun, OTA_FLEET_OPTION_RESET );
+
+    u32Start =  HOST_u32TimeMs ( );
+    for ( i = 0; i < u8Clients; i++ )
+    {
+        HOST_vAddDevice ( TEST_CLIENT_BASE + i, TEST_IEEE_BASE + i, FALSE );
+        asTestClient[i].u32NextMs =  u32Start + ( i * TEST_STAGGER_MS );
+    }
+    u32Seen =  HOST_u32DataReqCount ( );
+
+    while ( ( psRun->u8Complete < u8Clients ) &&
+            ( ( HOST_u32TimeMs ( ) - u32Start ) < TEST_RUN_LIMIT_MS ) )
+    {
+        u32Now =  HOST_u32TimeMs ( );
+        for ( i = 0; i < u8Clients; i++ )
+        {
+            if ( ( asTestClient[i].u32Offset < TEST_IMAGE_SIZE ) &&
+                 ( ( !asTestClient[i].bWaiting && ( ( int32 ) ( u32Now - asTestClient[i].u32NextMs ) >= 0 ) ) ||
+                   ( asTestClient[i].bWaiting && ( ( u32Now - asTestClient[i].u32LastMs ) > TEST_CLIENT_TIMEOUT_MS ) ) ) )
+            {
+                psRun->u32AirUs +=  ( u16ClientRequest ( i, eMode ) + TEST_AIR_OVERHEAD ) * TEST_AIR_US_PER_BYTE;
+            }
+        }
+        HOST_vRun ( 1 );
+
+        vHostService ( psRun );
+
+        if ( ( HOST_u32TimeMs ( ) / 100 ) != u32Tick )
+        {
+            u32Tick      =  HOST_u32TimeMs ( ) / 100;
+            u32TickCount =  0;
+        }
+        for ( ; u32Seen < HOST_u32DataReqCount ( ); u32Seen++ )
+        {
+            psReq =  HOST_psDataReq ( u32Seen );
+            if ( ( psReq != NULL ) && bTakeResponse ( psReq, eMode, psRun ) )
+            {
+                u32TickCount++;
+            }
+        }
+        if ( u32TickCount > psRun->u32MaxPerTick )
+        {
+            psRun->u32MaxPerTick =  u32TickCount;
+        }
+    }
+
+    for ( i = 0; i < u8Clients; i++ )
+    {
+        if ( ( asTestClient[i].u32DoneMs - u32Start ) > psRun->u32Ms )
+        {
+            psRun->u32Ms =  asTestClient[i].u32DoneMs - u32Start;
+        }
+    }
+    vReadStats ( psRun, 0 );
+}
+
+PRIVATE void vPrintRun ( uint8         u8Clients,
+                         const char*   pcMode,
+                         tsTestRun*    psRun )
+{
+    printf ( "  %2u clients, %-12s %6u ms, %6u UART bytes, %7u us airtime, %4u host fetches, %4u cache hits, %4u coalesced\n",
+             ( unsigned ) u8Clients,
+             pcMode,
+             ( unsigned ) psRun->u32Ms,
+             ( unsigned ) psRun->u32UartBytes,
+             ( unsigned ) psRun->u32AirUs,
+             ( unsigned ) psRun->u32HostFetches,
+             ( unsigned ) psRun->u32CacheHits,
+             ( unsigned ) psRun->u32Coalesced );
+}
+
+PRIVATE void vMakeImage ( void )
+{
+    uint32    i;
+
+    for ( i = 0; i < TEST_IMAGE_SIZE; i++ )
+    {
+        au8TestImage[i] =  ( uint8 ) ( ( i * 13 ) ^ ( i >> 8 ) );
+    }
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* Block request clients: with the cache the host sends each block once,
+ * the other clients are cache hits or wait on the fetch already made.
+ * Without it every client's block crosses the UART. Air traffic is the
+ * same either way, no client has to ask twice. */
+PRIVATE void vBlockClients ( void )
+{
+    tsTestRun    sShared;
+    tsTestRun    sPerClient;
+    uint8        au8Clients[] =  { 1, 8, OTA_FLEET_MAX_CLIENTS };
+    uint8        i;
+
+    vMakeImage ( );
+    for ( i = 0; i < ( sizeof ( au8Clients ) / sizeof ( au8Clients[0] ) ); i++ )
+    {
+        vRunFleet ( au8Clients[i], E_TEST_BLOCKS_SHARED, &sShared );
+        vRunFleet ( au8Clients[i], E_TEST_BLOCKS_PER_CLIENT, &sPerClient );
+        vPrintRun ( au8Clients[i], "shared:", &sShared );
+        vPrintRun ( au8Clients[i], "per client:", &sPerClient );
+
+        HOST_CHECK_EQUAL ( sShared.u8Complete, au8Clients[i] );
+        HOST_CHECK_EQUAL ( sPerClient.u8Complete, au8Clients[i] );
+        HOST_CHECK_EQUAL ( sShared.u32Corrupt, 0 );
+        HOST_CHECK_EQUAL ( sPerClient.u32Corrupt, 0 );
+
+        HOST_CHECK_EQUAL ( sPerClient.u32HostFetches, au8Clients[i] * TEST_BLOCKS );
+        HOST_CHECK_EQUAL ( sShared.u32HostFetches, TEST_BLOCKS );
+        HOST_CHECK_EQUAL ( sShared.u32AirUs, sPerClient.u32AirUs );
+        if ( au8Clients[i] > 1 )
+        {
+            HOST_CHECK ( sShared.u32CacheHits > 0 );
+            HOST_CHECK ( sShared.u32Coalesced > 0 );
+            HOST_CHECK ( sShared.u32UartBytes < sPerClient.u32UartBytes );
+            HOST_CHECK ( sShared.u32Ms <= sPerClient.u32Ms );
+        }
+    }
+}
+
+/* Page request clients: every block of every page arrives, in order and
+ * intact, the host is asked for each block once, and the tick sends
+ * at most OTA_FLEET_PAGE_BLOCKS_PER_TICK. Blocks waiting on a host fetch
+ * leave when it is answered rather than on the tick, so a 100 ms window
+ * may carry one tick's fetched blocks and the next tick's own. */
+PRIVATE void vPageClients ( void )
+{
+    tsTestRun    sRun;
+    uint8        au8Clients[] =  { 1, 8, OTA_FLEET_MAX_CLIENTS };
+    uint8        i;
+
+    vMakeImage ( );
+    for ( i = 0; i < ( sizeof ( au8Clients ) / sizeof ( au8Clients[0] ) ); i++ )
+    {
+        vRunFleet ( au8Clients[i], E_TEST_PAGES, &sRun );
+        vPrintRun ( au8Clients[i], "pages:", &sRun );
+        printf ( "  %2u clients, at most %u blocks in 100 ms, %u blocks/s on average\n",
+                 ( unsigned ) au8Clients[i],
+                 ( unsigned ) sRun.u32MaxPerTick,
+                 ( unsigned ) ( ( sRun.u32Ms > 0 ) ? ( ( au8Clients[i] * TEST_BLOCKS * 1000 ) / sRun.u32Ms ) : 0 ) );
+
+        HOST_CHECK_EQUAL ( sRun.u8Complete, au8Clients[i] );
+        HOST_CHECK_EQUAL ( sRun.u32Corrupt, 0 );
+        HOST_CHECK_EQUAL ( sRun.u32HostFetches, TEST_BLOCKS );
+        HOST_CHECK ( sRun.u32MaxPerTick <= ( 2 * OTA_FLEET_PAGE_BLOCKS_PER_TICK ) );
+        HOST_CHECK ( ( au8Clients[i] * TEST_BLOCKS * 100 ) <= ( ( sRun.u32Ms + 100 ) * OTA_FLEET_PAGE_BLOCKS_PER_TICK ) );
+    }
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vBlockClients );
+    HOST_TEST ( vPageClients );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
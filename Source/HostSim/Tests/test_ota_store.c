@@ -0,0 +1,459 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_ota_store.c
+ *
+ * DESCRIPTION:        OTA store on the emulated internal flash: upload rate
+ *                     over the UART and time spent programming, the stored
+ *                     copy and page wear, blocks served from flash against
+ *                     blocks fetched from the host, and an upload cut by a
+ *                     loss of power.
+ *
+ ****************************************************************************
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include <time.h>
+#include "zcl.h"
+#include "OTA.h"
+#include "SerialLink.h"
+#include "app_ota_server.h"
+#include "app_ota_store.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_CLIENT                     0x4100
+#define TEST_ENDPOINT                   1
+
+#define TEST_OTA_CLUSTER                0x0019
+#define TEST_BLOCK_REQUEST              0x03
+#define TEST_BLOCK_RESPONSE             0x05
+
+#define TEST_MANUFACTURER               0x1037
+#define TEST_IMAGE_TYPE                 0x0001
+#define TEST_FILE_VERSION               0x00000002
+
+/* Not a whole number of pages, so that the last one is padded */
+#define TEST_IMAGE_SIZE                 ( 48 * 1024 + 100 )
+#define TEST_BLOCKS                     64
+#define TEST_BLOCK_SIZE                 64
+
+/* Slot 0 starts after the pages left to the OTA cluster */
+#define TEST_SLOT_PAGE                  OTA_STORE_RESERVED_PAGES
+#define TEST_IMAGE_PAGES                ( ( TEST_IMAGE_SIZE + HOST_FLASH_PAGE_SIZE - 1 ) / HOST_FLASH_PAGE_SIZE )
+
+/* Offsets into the E_SL_MSG_OTA_STORE_RESPONSE and 0x8501 payloads */
+#define TEST_RSP_STATUS                 1
+#define TEST_RSP_VALUE                  3
+#define TEST_REQ_OFFSET                 15
+#define TEST_REQ_MAX_DATA_SIZE          29
+
+/* Data size field of a block response ASDU */
+#define TEST_RSP_DATA_SIZE              16
+
+#define TEST_U16( PAYLOAD, OFFSET )     ( ( ( PAYLOAD )[OFFSET] << 8 ) | ( PAYLOAD )[( OFFSET ) + 1] )
+#define TEST_U32( PAYLOAD, OFFSET )     ( ( ( uint32 ) TEST_U16 ( PAYLOAD, OFFSET ) << 16 ) | TEST_U16 ( PAYLOAD, ( OFFSET ) + 2 ) )
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint32    u32Ms;
+    uint32    u32FlashUs;
+    uint32    u32ReportedUs;
+    uint32    u32SerialBytes;
+    uint8     u8Status;
+} tsTestUpload;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE uint8    au8TestImage[TEST_IMAGE_SIZE];
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE void vPut32 ( uint8*    pu8Buffer,
+                      uint32    u32Value )
+{
+    pu8Buffer[0] =  ( uint8 ) ( u32Value >> 24 );
+    pu8Buffer[1] =  ( uint8 ) ( u32Value >> 16 );
+    pu8Buffer[2] =  ( uint8 ) ( u32Value >> 8 );
+    pu8Buffer[3] =  ( uint8 ) u32Value;
+}
+
+PRIVATE uint64 u64Ns ( void )
+{
+    struct timespec    sNow;
+
+    clock_gettime ( CLOCK_MONOTONIC, &sNow );
+    return ( ( uint64 ) sNow.tv_sec * 1000000000ULL ) + ( uint64 ) sNow.tv_nsec;
+}
+
+/* An OTA file with a minimal header and a counting body */
+PRIVATE void vMakeImage ( void )
+{
+    uint32    i;
+
+    for ( i = 0; i < TEST_IMAGE_SIZE; i++ )
+    {
+        au8TestImage[i] =  ( uint8 ) ( i * 7 );
+    }
+    memset ( au8TestImage, 0, OTA_MIN_HEADER_SIZE );
+    au8TestImage[0]  =  0x1E;                   /* file identifier */
+    au8TestImage[1]  =  0xF1;
+    au8TestImage[2]  =  0xEE;
+    au8TestImage[3]  =  0x0B;
+    au8TestImage[4]  =  0x00;                   /* header version */
+    au8TestImage[5]  =  0x01;
+    au8TestImage[6]  =  OTA_MIN_HEADER_SIZE;    /* header length */
+    au8TestImage[10] =  ( uint8 ) TEST_MANUFACTURER;
+    au8TestImage[11] =  ( uint8 ) ( TEST_MANUFACTURER >> 8 );
+    au8TestImage[12] =  ( uint8 ) TEST_IMAGE_TYPE;
+    au8TestImage[14] =  ( uint8 ) TEST_FILE_VERSION;
+    au8TestImage[18] =  0x02;                   /* stack version */
+    au8TestImage[52] =  ( uint8 ) TEST_IMAGE_SIZE;
+    au8TestImage[53] =  ( uint8 ) ( TEST_IMAGE_SIZE >> 8 );
+    au8TestImage[54] =  ( uint8 ) ( TEST_IMAGE_SIZE >> 16 );
+}
+
+/* Sends a store operation and waits for its response, which is copied out */
+PRIVATE bool_t bStoreCommand ( const uint8*    pu8Command,
+                               uint16          u16Length,
+                               tsHostSerialFrame*    psFrame )
+{
+    uint32    i;
+
+    HOST_vSerialFlush ( );
+    HOST_vSerialWrite ( E_SL_MSG_OTA_STORE, u16Length, pu8Command );
+    for ( i = 0; i < 200; i++ )
+    {
+        HOST_vRun ( 1 );
+        if ( HOST_bSerialFind ( E_SL_MSG_OTA_STORE_RESPONSE, psFrame ) )
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* Begins, writes in u16Chunk byte pieces and commits the test image; the
+ * status is that of the first operation to fail, or of the commit */
+PRIVATE void vUpload ( uint8     u8Slot,
+                       uint16    u16Chunk,
+                       tsTestUpload*    psUpload )
+{
+    tsHostSerialFrame    sFrame;
+    uint8                au8Command[6 + OTA_STORE_CHUNK_MAX];
+    uint32               u32StartMs =  HOST_u32TimeMs ( );
+    uint32               u32StartUs =  HOST_u32FlashBusyUs ( );
+    uint32               u32Offset;
+    uint16               u16Length;
+
+    memset ( psUpload, 0, sizeof ( tsTestUpload ) );
+    memset ( au8Command, 0, sizeof ( au8Command ) );
+    au8Command[0] =  OTA_STORE_OP_BEGIN;
+    au8Command[1] =  u8Slot;
+    vPut32 ( &au8Command[2], TEST_IMAGE_SIZE );
+    /* The host SHA-256 stand-in digests everything to zeros */
+    u16Length =  6 + 32;
+    psUpload->u32SerialBytes +=  u16Length;
+    if ( !bStoreCommand ( au8Command, u16Length, &sFrame ) ||
+         ( ( psUpload->u8Status = sFrame.au8Payload[TEST_RSP_STATUS] ) != OTA_STORE_STATUS_OK ) )
+    {
+        return;
+    }
+
+    for ( u32Offset = 0; u32Offset < TEST_IMAGE_SIZE; u32Offset += u16Length )
+    {
+        u16Length =  ( ( TEST_IMAGE_SIZE - u32Offset ) < u16Chunk ) ? ( uint16 ) ( TEST_IMAGE_SIZE - u32Offset ) : u16Chunk;
+        au8Command[0] =  OTA_STORE_OP_WRITE;
+        vPut32 ( &au8Command[2], u32Offset );
+        memcpy ( &au8Command[6], &au8TestImage[u32Offset], u16Length );
+        psUpload->u32SerialBytes +=  6 + u16Length;
+        if ( !bStoreCommand ( au8Command, 6 + u16Length, &sFrame ) )
+        {
+            psUpload->u8Status =  0xFF;
+            return;
+        }
+        psUpload->u8Status =  sFrame.au8Payload[TEST_RSP_STATUS];
+        if ( psUpload->u8Status != OTA_STORE_STATUS_OK )
+        {
+            return;
+        }
+    }
+
+    au8Command[0] =  OTA_STORE_OP_COMMIT;
+    psUpload->u32SerialBytes +=  2;
+    if ( !bStoreCommand ( au8Command, 2, &sFrame ) )
+    {
+        psUpload->u8Status =  0xFF;
+        return;
+    }
+    psUpload->u8Status      =  sFrame.au8Payload[TEST_RSP_STATUS];
+    psUpload->u32ReportedUs =  TEST_U32 ( sFrame.au8Payload, TEST_RSP_VALUE );
+    psUpload->u32Ms         =  HOST_u32TimeMs ( ) - u32StartMs;
+    psUpload->u32FlashUs    =  HOST_u32FlashBusyUs ( ) - u32StartUs;
+}
+
+PRIVATE void vSelect ( uint8    u8Slot )
+{
+    tsHostSerialFrame    sFrame;
+    uint8                au8Command[2] =  { OTA_STORE_OP_SELECT, u8Slot };
+
+    HOST_CHECK ( bStoreCommand ( au8Command, sizeof ( au8Command ), &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_RSP_STATUS], OTA_STORE_STATUS_OK );
+}
+
+/* Image block request from the client for a block of the test image */
+PRIVATE void vBlockRequest ( uint32    u32Offset )
+{
+    uint8    au8Request[] =
+    {
+        0x01, 0x10, TEST_BLOCK_REQUEST,
+        0x00,                           /* field control */
+        ( uint8 ) TEST_MANUFACTURER, ( uint8 ) ( TEST_MANUFACTURER >> 8 ),
+        ( uint8 ) TEST_IMAGE_TYPE, ( uint8 ) ( TEST_IMAGE_TYPE >> 8 ),
+        ( uint8 ) TEST_FILE_VERSION, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,         /* file offset */
+        TEST_BLOCK_SIZE                 /* max data size */
+    };
+
+    au8Request[12] =  ( uint8 ) u32Offset;
+    au8Request[13] =  ( uint8 ) ( u32Offset >> 8 );
+    au8Request[14] =  ( uint8 ) ( u32Offset >> 16 );
+    HOST_vDataIndication ( TEST_CLIENT, TEST_ENDPOINT, TEST_ENDPOINT, TEST_OTA_CLUSTER, 0x0104,
+                           au8Request, sizeof ( au8Request ) );
+}
+
+/* Answers a forwarded block request from the test image */
+PRIVATE void vHostBlockSend ( tsHostSerialFrame*    psFrame )
+{
+    uint8     au8Send[20 + 255];
+    uint32    u32Offset =  TEST_U32 ( psFrame->au8Payload, TEST_REQ_OFFSET );
+    uint8     u8Size    =  psFrame->au8Payload[TEST_REQ_MAX_DATA_SIZE];
+
+    memset ( au8Send, 0, sizeof ( au8Send ) );
+    au8Send[0]  =  E_ZCL_AM_SHORT;
+    au8Send[1]  =  ( uint8 ) ( TEST_CLIENT >> 8 );
+    au8Send[2]  =  ( uint8 ) TEST_CLIENT;
+    au8Send[3]  =  TEST_ENDPOINT;
+    au8Send[4]  =  TEST_ENDPOINT;
+    au8Send[5]  =  0x10;
+    vPut32 ( &au8Send[7], u32Offset );
+    vPut32 ( &au8Send[11], TEST_FILE_VERSION );
+    au8Send[15] =  ( uint8 ) ( TEST_IMAGE_TYPE >> 8 );
+    au8Send[16] =  ( uint8 ) TEST_IMAGE_TYPE;
+    au8Send[17] =  ( uint8 ) ( TEST_MANUFACTURER >> 8 );
+    au8Send[18] =  ( uint8 ) TEST_MANUFACTURER;
+    au8Send[19] =  u8Size;
+    memcpy ( &au8Send[20], &au8TestImage[u32Offset], u8Size );
+    HOST_vSerialWrite ( E_SL_MSG_BLOCK_SEND, 20 + u8Size, au8Send );
+}
+
+/* Requests a block and runs until its response goes on air, answering
+ * requests forwarded to the host, and confirms it; the block must match
+ * the image */
+PRIVATE bool_t bServeBlock ( uint32    u32Offset,
+                             uint32*   pu32Ms )
+{
+    tsHostSerialFrame    sFrame;
+    tsHostDataReq*       psReq;
+    uint32               u32Count =  HOST_u32DataReqCount ( );
+    uint32               u32Start =  HOST_u32TimeMs ( );
+    uint32               i;
+
+    HOST_vSerialFlush ( );
+    vBlockRequest ( u32Offset );
+    for ( i = 0; ( i < 1000 ) && ( HOST_u32DataReqCount ( ) == u32Count ); i++ )
+    {
+        if ( HOST_bSerialFind ( E_SL_MSG_BLOCK_REQUEST, &sFrame ) )
+        {
+            vHostBlockSend ( &sFrame );
+        }
+        HOST_vRun ( 1 );
+    }
+    *pu32Ms =  HOST_u32TimeMs ( ) - u32Start;
+
+    psReq =  HOST_psDataReq ( u32Count );
+    if ( ( psReq == NULL ) ||
+         ( psReq->u16ClusterId != TEST_OTA_CLUSTER ) ||
+         ( psReq->au8Payload[2] != TEST_BLOCK_RESPONSE ) )
+    {
+        return FALSE;
+    }
+    HOST_bDataConfirm ( psReq->u8ApsSeqNum, ZPS_E_SUCCESS );
+    return ( ( psReq->au8Payload[TEST_RSP_DATA_SIZE] == TEST_BLOCK_SIZE ) &&
+             ( memcmp ( &psReq->au8Payload[TEST_RSP_DATA_SIZE + 1], &au8TestImage[u32Offset], TEST_BLOCK_SIZE ) == 0 ) );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* The image lands in slot 0 page by page, each page erased once; the
+ * programming time the store reports is the flash busy time. Larger
+ * chunks carry less framing per image byte. */
+PRIVATE void vUploadRate ( void )
+{
+    tsTestUpload    sUpload;
+    uint16          au16Chunk[] =  { 64, OTA_STORE_CHUNK_MAX };
+    uint32          u32Page;
+    uint8           i;
+
+    vMakeImage ( );
+    for ( i = 0; i < ( sizeof ( au16Chunk ) / sizeof ( au16Chunk[0] ) ); i++ )
+    {
+        HOST_vInit ( );
+        vAppInitOTA ( );
+        vUpload ( 0, au16Chunk[i], &sUpload );
+        HOST_CHECK_EQUAL ( sUpload.u8Status, OTA_STORE_STATUS_OK );
+        HOST_CHECK_EQUAL ( sUpload.u32ReportedUs,
+                           TEST_IMAGE_PAGES * ( HOST_FLASH_ERASE_US + ( HOST_FLASH_PAGE_SIZE / 16 ) * HOST_FLASH_PROGRAM_WORD_US ) );
+        /* The flash also saves the store's record in the PDM */
+        HOST_CHECK ( sUpload.u32FlashUs > sUpload.u32ReportedUs );
+        HOST_CHECK ( memcmp ( &au8HostFlash[TEST_SLOT_PAGE * HOST_FLASH_PAGE_SIZE], au8TestImage, TEST_IMAGE_SIZE ) == 0 );
+        for ( u32Page = 0; u32Page < HOST_FLASH_PAGES; u32Page++ )
+        {
+            HOST_CHECK_EQUAL ( HOST_u32FlashEraseCount ( u32Page ),
+                               ( ( u32Page >= TEST_SLOT_PAGE ) && ( u32Page < ( TEST_SLOT_PAGE + TEST_IMAGE_PAGES ) ) ) ? 1 : 0 );
+        }
+        printf ( "  %u byte image in %u byte chunks: %u serial bytes, %u ms, %u bytes/s, %u us programming %u pages\n",
+                 ( unsigned ) TEST_IMAGE_SIZE,
+                 ( unsigned ) au16Chunk[i],
+                 ( unsigned ) sUpload.u32SerialBytes,
+                 ( unsigned ) sUpload.u32Ms,
+                 ( unsigned ) ( ( sUpload.u32Ms > 0 ) ? ( ( uint64 ) TEST_IMAGE_SIZE * 1000 / sUpload.u32Ms ) : 0 ),
+                 ( unsigned ) sUpload.u32ReportedUs,
+                 ( unsigned ) TEST_IMAGE_PAGES );
+    }
+}
+
+/* Blocks of the stored image are answered as the request arrives; with
+ * the store deselected each one waits for a round trip over the UART */
+PRIVATE void vServeLatency ( void )
+{
+    tsTestUpload    sUpload;
+    uint64          u64StartNs;
+    uint64          u64FlashNs;
+    uint32          u32FlashMs =  0;
+    uint32          u32HostMs  =  0;
+    uint32          u32Ms;
+    uint32          i;
+
+    vMakeImage ( );
+    HOST_vInit ( );
+    vAppInitOTA ( );
+    HOST_vAddDevice ( TEST_CLIENT, 0x00158D0000410000ULL, FALSE );
+    vUpload ( 0, OTA_STORE_CHUNK_MAX, &sUpload );
+    HOST_CHECK_EQUAL ( sUpload.u8Status, OTA_STORE_STATUS_OK );
+
+    u64StartNs =  u64Ns ( );
+    for ( i = 0; i < TEST_BLOCKS; i++ )
+    {
+        HOST_CHECK ( bServeBlock ( i * TEST_BLOCK_SIZE, &u32Ms ) );
+        u32FlashMs +=  u32Ms;
+    }
+    u64FlashNs =  u64Ns ( ) - u64StartNs;
+    HOST_CHECK ( ( u32FlashMs / TEST_BLOCKS ) <= 1 );
+
+    vSelect ( OTA_STORE_SLOT_NONE );
+    for ( i = 0; i < TEST_BLOCKS; i++ )
+    {
+        HOST_CHECK ( bServeBlock ( ( TEST_BLOCKS + i ) * TEST_BLOCK_SIZE, &u32Ms ) );
+        u32HostMs +=  u32Ms;
+    }
+    HOST_CHECK ( u32HostMs > u32FlashMs );
+
+    printf ( "  %u byte blocks from flash: %u ms for %u, %u ns of host CPU each; via the host: %u ms for %u\n",
+             ( unsigned ) TEST_BLOCK_SIZE,
+             ( unsigned ) u32FlashMs,
+             ( unsigned ) TEST_BLOCKS,
+             ( unsigned ) ( u64FlashNs / TEST_BLOCKS ),
+             ( unsigned ) u32HostMs,
+             ( unsigned ) TEST_BLOCKS );
+}
+
+/* Power lost while a page is programmed fails the upload and leaves the
+ * slot empty and unserved; once power is back the upload goes through */
+PRIVATE void vPowerLoss ( void )
+{
+    tsTestUpload         sUpload;
+    tsHostSerialFrame    sFrame;
+    uint8                au8Select[2] =  { OTA_STORE_OP_SELECT, 0 };
+
+    vMakeImage ( );
+    HOST_vInit ( );
+    vAppInitOTA ( );
+
+    /* The tenth page's program, after its erase and the two programs that
+     * open the PDM log and save the store's record */
+    HOST_vFlashPowerFail ( 22 );
+    vUpload ( 0, OTA_STORE_CHUNK_MAX, &sUpload );
+    HOST_CHECK_EQUAL ( sUpload.u8Status, OTA_STORE_STATUS_FLASH_ERROR );
+    HOST_CHECK ( HOST_bFlashPowerLost ( ) );
+    HOST_CHECK_EQUAL ( HOST_u32FlashEraseCount ( TEST_SLOT_PAGE + 9 ), 1 );
+    HOST_CHECK_EQUAL ( HOST_u32FlashEraseCount ( TEST_SLOT_PAGE + 10 ), 0 );
+    HOST_CHECK ( memcmp ( &au8HostFlash[( TEST_SLOT_PAGE + 9 ) * HOST_FLASH_PAGE_SIZE],
+                          &au8TestImage[9 * HOST_FLASH_PAGE_SIZE],
+                          HOST_FLASH_PAGE_SIZE ) != 0 );
+    HOST_CHECK ( bStoreCommand ( au8Select, sizeof ( au8Select ), &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_RSP_STATUS], OTA_STORE_STATUS_BAD_STATE );
+
+    HOST_vFlashPowerRestore ( );
+    vUpload ( 0, OTA_STORE_CHUNK_MAX, &sUpload );
+    HOST_CHECK_EQUAL ( sUpload.u8Status, OTA_STORE_STATUS_OK );
+    HOST_CHECK_EQUAL ( HOST_u32FlashEraseCount ( TEST_SLOT_PAGE + 9 ), 2 );
+    HOST_CHECK ( memcmp ( &au8HostFlash[TEST_SLOT_PAGE * HOST_FLASH_PAGE_SIZE], au8TestImage, TEST_IMAGE_SIZE ) == 0 );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vUploadRate );
+    HOST_TEST ( vServeLatency );
+    HOST_TEST ( vPowerLoss );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
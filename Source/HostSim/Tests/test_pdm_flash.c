@@ -0,0 +1,364 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_pdm_flash.c
+ *
+ * DESCRIPTION:        PDM on the emulated flash: a burst of coordinator
+ *                     saves (the address map, the key table and Green Power
+ *                     entries) timed per save, with the compactions and the
+ *                     erases of every segment it causes, and the same burst
+ *                     cut by a loss of power at points spread through it,
+ *                     each followed by a boot that has to find every record
+ *                     as it was last saved.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stdlib.h>
+#include <string.h>
+#include "PDM.h"
+#include "PDM_IDs.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* A 200 device coordinator: its address map, the key table in eight
+ * records of 25 devices and a Green Power entry per device commissioned */
+#define TEST_ADDRESS_MAP_ID             0x7100
+#define TEST_ADDRESS_MAP_LENGTH         ( 200 * 10 )
+#define TEST_KEY_TABLE_ID               0x7200
+#define TEST_KEY_TABLE_RECORDS          8
+#define TEST_KEY_TABLE_LENGTH           ( 25 * 24 )
+#define TEST_GP_ENTRY_ID                0x7300
+#define TEST_GP_ENTRIES                 32
+#define TEST_GP_ENTRY_LENGTH            40
+
+#define TEST_RECORDS                    ( 1 + TEST_KEY_TABLE_RECORDS + TEST_GP_ENTRIES )
+#define TEST_BURST_SAVES                2000
+
+/* Power is cut after this many flash operations, then every
+ * TEST_CUT_STEP more, so that the cuts land in saves and compactions */
+#define TEST_CUT_FIRST                  1
+#define TEST_CUT_STEP                   37
+#define TEST_CUTS                       60
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint16    u16Id;
+    uint16    u16Length;
+    uint32    u32Generation;
+} tsTestRecord;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE tsTestRecord    asTestRecords[TEST_RECORDS];
+PRIVATE uint32          au32TestLatencyUs[TEST_BURST_SAVES];
+PRIVATE uint32          u32TestRandom;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE void vRecordsInit ( void )
+{
+    uint8    i;
+
+    asTestRecords[0].u16Id     =  TEST_ADDRESS_MAP_ID;
+    asTestRecords[0].u16Length =  TEST_ADDRESS_MAP_LENGTH;
+    for ( i = 0; i < TEST_KEY_TABLE_RECORDS; i++ )
+    {
+        asTestRecords[1 + i].u16Id     =  TEST_KEY_TABLE_ID + i;
+        asTestRecords[1 + i].u16Length =  TEST_KEY_TABLE_LENGTH;
+    }
+    for ( i = 0; i < TEST_GP_ENTRIES; i++ )
+    {
+        asTestRecords[1 + TEST_KEY_TABLE_RECORDS + i].u16Id     =  TEST_GP_ENTRY_ID + i;
+        asTestRecords[1 + TEST_KEY_TABLE_RECORDS + i].u16Length =  TEST_GP_ENTRY_LENGTH;
+    }
+    for ( i = 0; i < TEST_RECORDS; i++ )
+    {
+        asTestRecords[i].u32Generation =  0;
+    }
+    u32TestRandom =  1;
+}
+
+/* The content of a record at a generation */
+PRIVATE void vFill ( const tsTestRecord*    psRecord,
+                     uint32                 u32Generation,
+                     uint8*                 pu8Data )
+{
+    uint16    i;
+
+    memcpy ( pu8Data, &u32Generation, sizeof ( u32Generation ) );
+    for ( i = sizeof ( u32Generation ); i < psRecord->u16Length; i++ )
+    {
+        pu8Data[i] =  ( uint8 ) ( psRecord->u16Id + u32Generation * 7 + i );
+    }
+}
+
+/* Most saves are Green Power frame counters, one in ten a key table record
+ * as a device joins, one in fifty the address map */
+PRIVATE tsTestRecord* psNextRecord ( void )
+{
+    uint32    u32Pick;
+
+    u32TestRandom =  ( u32TestRandom * 1103515245 ) + 12345;
+    u32Pick       =  ( u32TestRandom >> 16 ) % 50;
+    if ( u32Pick == 0 )
+    {
+        return &asTestRecords[0];
+    }
+    if ( u32Pick <= 5 )
+    {
+        return &asTestRecords[1 + ( u32Pick + ( u32TestRandom >> 8 ) ) % TEST_KEY_TABLE_RECORDS];
+    }
+    return &asTestRecords[1 + TEST_KEY_TABLE_RECORDS + ( u32TestRandom >> 8 ) % TEST_GP_ENTRIES];
+}
+
+PRIVATE PDM_teStatus eSave ( tsTestRecord*    psRecord,
+                             uint32           u32Generation )
+{
+    uint8    au8Data[TEST_ADDRESS_MAP_LENGTH];
+
+    vFill ( psRecord, u32Generation, au8Data );
+    return PDM_eSaveRecordData ( psRecord->u16Id, au8Data, psRecord->u16Length );
+}
+
+/* Whether a record reads back as it was at a generation */
+PRIVATE bool_t bReads ( const tsTestRecord*    psRecord,
+                        uint32                 u32Generation )
+{
+    uint8     au8Expected[TEST_ADDRESS_MAP_LENGTH];
+    uint8     au8Data[TEST_ADDRESS_MAP_LENGTH];
+    uint16    u16Read;
+
+    vFill ( psRecord, u32Generation, au8Expected );
+    return ( PDM_eReadDataFromRecord ( psRecord->u16Id, au8Data, sizeof ( au8Data ), &u16Read ) == PDM_E_STATUS_OK ) &&
+           ( u16Read == psRecord->u16Length ) &&
+           ( memcmp ( au8Data, au8Expected, u16Read ) == 0 );
+}
+
+PRIVATE void vSaveAll ( void )
+{
+    uint8    i;
+
+    for ( i = 0; i < TEST_RECORDS; i++ )
+    {
+        asTestRecords[i].u32Generation++;
+        HOST_CHECK_EQUAL ( eSave ( &asTestRecords[i], asTestRecords[i].u32Generation ), PDM_E_STATUS_OK );
+    }
+}
+
+PRIVATE bool_t bAllRead ( void )
+{
+    uint8    i;
+
+    for ( i = 0; i < TEST_RECORDS; i++ )
+    {
+        if ( !bReads ( &asTestRecords[i], asTestRecords[i].u32Generation ) )
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+PRIVATE int iCompare ( const void*    pvA,
+                       const void*    pvB )
+{
+    uint32    u32A =  *( const uint32* ) pvA;
+    uint32    u32B =  *( const uint32* ) pvB;
+
+    return ( u32A > u32B ) - ( u32A < u32B );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* Save latency percentiles, compaction pauses and the wear of each page */
+PRIVATE void vSaveBurst ( void )
+{
+    tsTestRecord*    psRecord;
+    uint32           u32StartUs;
+    uint32           u32Erases;
+    uint32           u32EraseMin =  0xFFFFFFFF;
+    uint32           u32EraseMax =  0;
+    uint32           u32EraseSum =  0;
+    uint32           u32Failed   =  0;
+    uint32           i;
+
+    HOST_vInit ( );
+    vRecordsInit ( );
+    vSaveAll ( );
+    for ( i = 0; i < TEST_BURST_SAVES; i++ )
+    {
+        psRecord   =  psNextRecord ( );
+        psRecord->u32Generation++;
+        u32StartUs =  HOST_u32FlashBusyUs ( );
+        if ( eSave ( psRecord, psRecord->u32Generation ) != PDM_E_STATUS_OK )
+        {
+            u32Failed++;
+        }
+        au32TestLatencyUs[i] =  HOST_u32FlashBusyUs ( ) - u32StartUs;
+    }
+    for ( i = 0; i < HOST_FLASH_PDM_PAGES; i++ )
+    {
+        u32Erases    =  HOST_u32FlashEraseCount ( HOST_FLASH_PAGES + i );
+        u32EraseSum +=  u32Erases;
+        u32EraseMin  =  ( u32Erases < u32EraseMin ) ? u32Erases : u32EraseMin;
+        u32EraseMax  =  ( u32Erases > u32EraseMax ) ? u32Erases : u32EraseMax;
+    }
+    qsort ( au32TestLatencyUs, TEST_BURST_SAVES, sizeof ( uint32 ), iCompare );
+
+    printf ( "  %u saves: p50 %u us, p99 %u us, max %u us\n",
+             ( unsigned ) TEST_BURST_SAVES,
+             ( unsigned ) au32TestLatencyUs[TEST_BURST_SAVES / 2],
+             ( unsigned ) au32TestLatencyUs[( TEST_BURST_SAVES * 99 ) / 100],
+             ( unsigned ) au32TestLatencyUs[TEST_BURST_SAVES - 1] );
+    printf ( "  %u compactions, %u us in all, longest %u us\n",
+             ( unsigned ) HOST_u32PdmCompactions ( ),
+             ( unsigned ) HOST_u32PdmCompactionUs ( ),
+             ( unsigned ) HOST_u32PdmCompactionMaxUs ( ) );
+    printf ( "  %u page erases over %u pages, %u to %u each\n",
+             ( unsigned ) u32EraseSum, ( unsigned ) HOST_FLASH_PDM_PAGES,
+             ( unsigned ) u32EraseMin, ( unsigned ) u32EraseMax );
+
+    HOST_CHECK_EQUAL ( u32Failed, 0 );
+    HOST_CHECK ( bAllRead ( ) );
+    HOST_CHECK ( HOST_u32PdmCompactions ( ) > 0 );
+    HOST_CHECK ( u32EraseSum >= HOST_u32PdmCompactions ( ) );
+    /* The log goes round the segments, so they wear evenly */
+    HOST_CHECK ( ( u32EraseMax - u32EraseMin ) <= 1 );
+    /* Most saves only program, the slowest ones compact */
+    HOST_CHECK ( au32TestLatencyUs[TEST_BURST_SAVES / 2] < HOST_FLASH_ERASE_US );
+    HOST_CHECK ( au32TestLatencyUs[TEST_BURST_SAVES - 1] >= HOST_FLASH_ERASE_US );
+    HOST_CHECK ( au32TestLatencyUs[TEST_BURST_SAVES - 1] >= HOST_u32PdmCompactionMaxUs ( ) );
+
+    /* What the boot finds is what was saved */
+    HOST_CHECK_EQUAL ( PDM_eInitialise ( PDM_START_SEGMENT, PDM_NUM_SEGMENTS, NULL ), PDM_E_STATUS_OK );
+    HOST_CHECK ( bAllRead ( ) );
+}
+
+/* Power lost part way through the burst: the boot after it finds every
+ * record as last saved, the one being saved either old or new, and the
+ * PDM goes on saving */
+PRIVATE void vPowerLossInBurst ( void )
+{
+    tsTestRecord*    psRecord  =  NULL;
+    PDM_teStatus     eStatus;
+    uint32           u32Cut;
+    uint32           u32Recovered =  0;
+    uint32           u32NewKept   =  0;
+    uint32           u32Intact    =  0;
+    uint32           u32Saves;
+    uint8            i;
+
+    for ( u32Cut = TEST_CUT_FIRST; u32Cut < ( TEST_CUT_FIRST + TEST_CUTS * TEST_CUT_STEP ); u32Cut += TEST_CUT_STEP )
+    {
+        HOST_vInit ( );
+        vRecordsInit ( );
+        vSaveAll ( );
+
+        HOST_vFlashPowerFail ( u32Cut );
+        for ( u32Saves = 0; u32Saves < TEST_BURST_SAVES; u32Saves++ )
+        {
+            psRecord =  psNextRecord ( );
+            if ( eSave ( psRecord, psRecord->u32Generation + 1 ) != PDM_E_STATUS_OK )
+            {
+                break;
+            }
+            psRecord->u32Generation++;
+        }
+        HOST_CHECK ( HOST_bFlashPowerLost ( ) );
+
+        HOST_vFlashPowerRestore ( );
+        eStatus =  PDM_eInitialise ( PDM_START_SEGMENT, PDM_NUM_SEGMENTS, NULL );
+        HOST_CHECK ( ( eStatus == PDM_E_STATUS_OK ) || ( eStatus == PDM_E_STATUS_RECOVERED ) );
+        if ( eStatus == PDM_E_STATUS_RECOVERED )
+        {
+            u32Recovered++;
+        }
+
+        /* The save cut short may have made it to flash whole */
+        if ( bReads ( psRecord, psRecord->u32Generation + 1 ) )
+        {
+            psRecord->u32Generation++;
+            u32NewKept++;
+        }
+        if ( bAllRead ( ) )
+        {
+            u32Intact++;
+        }
+        else
+        {
+            for ( i = 0; i < TEST_RECORDS; i++ )
+            {
+                if ( !bReads ( &asTestRecords[i], asTestRecords[i].u32Generation ) )
+                {
+                    printf ( "  cut at %u: record %04x lost generation %u\n",
+                             ( unsigned ) u32Cut, asTestRecords[i].u16Id, ( unsigned ) asTestRecords[i].u32Generation );
+                }
+            }
+        }
+
+        /* Saves carry on after the boot and survive the next one */
+        vSaveAll ( );
+        HOST_CHECK_EQUAL ( PDM_eInitialise ( PDM_START_SEGMENT, PDM_NUM_SEGMENTS, NULL ), PDM_E_STATUS_OK );
+        HOST_CHECK ( bAllRead ( ) );
+    }
+
+    printf ( "  %u cuts: %u booted with all records intact, %u over a torn write, %u kept the save in progress\n",
+             ( unsigned ) TEST_CUTS, ( unsigned ) u32Intact, ( unsigned ) u32Recovered, ( unsigned ) u32NewKept );
+    HOST_CHECK_EQUAL ( u32Intact, TEST_CUTS );
+    HOST_CHECK ( u32Recovered > 0 );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vSaveBurst );
+    HOST_TEST ( vPowerLossInBurst );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
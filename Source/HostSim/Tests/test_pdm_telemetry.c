@@ -0,0 +1,439 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_pdm_telemetry.c
+ *
+ * DESCRIPTION:        PDM save telemetry: command and background saves, the
+ *                     per record counters and their overflow entry, the wear
+ *                     counts and the reset option of E_SL_MSG_GET_PDM_TELEMETRY.
+ *                     Save latencies come from the flash time host_flash.c
+ *                     charges, HOST_FLASH_PROGRAM_WORD_US a word and
+ *                     HOST_FLASH_ERASE_US an erase, which TMR_GetTimestamp
+ *                     counts, so each lands in a known histogram bucket
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "PDM.h"
+#include "PDM_IDs.h"
+#include "SerialLink.h"
+#include "app_pdm_telemetry.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Offsets into the summary frame */
+#define TEST_SUM_SAVES                  2
+#define TEST_SUM_IN_COMMAND             6
+#define TEST_SUM_IDLE                   10
+#define TEST_SUM_FAILED                 14
+#define TEST_SUM_BYTES                  18
+#define TEST_SUM_ERASES                 34
+#define TEST_SUM_WEAR_TOTAL             38
+#define TEST_SUM_SEGMENTS               50
+#define TEST_SUM_RECORDS                51
+#define TEST_SUM_BUCKETS                56
+#define TEST_SUM_LATENCY                57
+
+/* Offsets into the wear and record frames */
+#define TEST_LIST_FIRST                 1
+#define TEST_LIST_COUNT                 2
+#define TEST_LIST_TOTAL                 3
+#define TEST_LIST_ENTRIES               4
+
+#define TEST_RECORD_BASE                0x7000
+
+/* Two words each, enough to fill the PDM segments twice over */
+#define TEST_WEAR_SAVES                 2000
+
+/* Record sizes whose saves program 3, 14, 31, 62 and 124 words: one per
+ * bucket from 0 to 4 */
+#define TEST_LATENCY_SIZES              { 1, 208, 464, 944, 1900 }
+#define TEST_LATENCY_LARGEST            1900
+
+/* Saves after the first compaction, which lands in a bucket of its own */
+#define TEST_LATENCY_AFTER_ERASE        10
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint8     au8Summary[HOST_SERIAL_MAX_PAYLOAD];
+    uint8     u8WearFrames;
+    uint32    u32WearSum;
+    uint8     u8RecordFrames;
+    uint8     u8Records;
+    uint16    au16RecordId[PDM_TELEMETRY_MAX_RECORDS];
+    uint32    au32RecordSaves[PDM_TELEMETRY_MAX_RECORDS];
+    uint32    au32RecordBytes[PDM_TELEMETRY_MAX_RECORDS];
+} tsTestTelemetry;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE uint32 u32Read32 ( const uint8*    pu8Data )
+{
+    return ( ( uint32 ) pu8Data[0] << 24 ) | ( ( uint32 ) pu8Data[1] << 16 ) |
+           ( ( uint32 ) pu8Data[2] << 8 ) | pu8Data[3];
+}
+
+/* Requests the telemetry over the serial link and gathers its frames */
+PRIVATE void vTelemetry ( uint8    u8Options,
+                          tsTestTelemetry*    psTelemetry )
+{
+    tsHostSerialFrame    sFrame;
+    uint8*               pu8Entry;
+    uint8                i;
+
+    memset ( psTelemetry, 0, sizeof ( tsTestTelemetry ) );
+    HOST_vSerialFlush ( );
+    HOST_vSerialWrite ( E_SL_MSG_GET_PDM_TELEMETRY, 1, &u8Options );
+    HOST_vRun ( 20 );
+
+    while ( HOST_bSerialFind ( E_SL_MSG_PDM_TELEMETRY, &sFrame ) )
+    {
+        HOST_CHECK ( sFrame.bCrcOk );
+        switch ( sFrame.au8Payload[0] )
+        {
+            case PDM_TELEMETRY_SECTION_SUMMARY:
+                HOST_CHECK_EQUAL ( sFrame.au8Payload[1], PDM_TELEMETRY_VERSION );
+                memcpy ( psTelemetry->au8Summary, sFrame.au8Payload, sizeof ( psTelemetry->au8Summary ) );
+                break;
+
+            case PDM_TELEMETRY_SECTION_WEAR:
+                HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_LIST_TOTAL], PDM_NUM_SEGMENTS );
+                for ( i = 0; i < sFrame.au8Payload[TEST_LIST_COUNT]; i++ )
+                {
+                    psTelemetry->u32WearSum +=  u32Read32 ( &sFrame.au8Payload[TEST_LIST_ENTRIES + i * 4] );
+                }
+                psTelemetry->u8WearFrames++;
+                break;
+
+            case PDM_TELEMETRY_SECTION_RECORDS:
+                HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_LIST_FIRST], psTelemetry->u8Records );
+                HOST_CHECK ( sFrame.au8Payload[TEST_LIST_COUNT] <= PDM_TELEMETRY_RECORDS_PER_FRAME );
+                for ( i = 0; i < sFrame.au8Payload[TEST_LIST_COUNT]; i++ )
+                {
+                    pu8Entry =  &sFrame.au8Payload[TEST_LIST_ENTRIES + i * 10];
+                    psTelemetry->au16RecordId[psTelemetry->u8Records]    =  ( pu8Entry[0] << 8 ) | pu8Entry[1];
+                    psTelemetry->au32RecordSaves[psTelemetry->u8Records] =  u32Read32 ( &pu8Entry[2] );
+                    psTelemetry->au32RecordBytes[psTelemetry->u8Records] =  u32Read32 ( &pu8Entry[6] );
+                    psTelemetry->u8Records++;
+                }
+                psTelemetry->u8RecordFrames++;
+                break;
+
+            default:
+                HOST_CHECK ( FALSE );
+                break;
+        }
+    }
+}
+
+/* Bucket a save of u32DurationUs belongs in: under
+ * PDM_TELEMETRY_LATENCY_BASE_US, then one more for each doubling */
+PRIVATE uint8 u8Bucket ( uint32    u32DurationUs )
+{
+    uint8    u8Bucket =  0;
+
+    while ( ( u32DurationUs >= ( ( uint32 ) PDM_TELEMETRY_LATENCY_BASE_US << u8Bucket ) ) &&
+            ( u8Bucket < ( PDM_TELEMETRY_LATENCY_BUCKETS - 1 ) ) )
+    {
+        u8Bucket++;
+    }
+    return u8Bucket;
+}
+
+/* Saves a record and returns the flash time it took */
+PRIVATE uint32 u32TimedSave ( uint16    u16RecordId,
+                              uint8*    pu8Data,
+                              uint16    u16Length )
+{
+    uint32    u32Before =  HOST_u32FlashBusyUs ( );
+
+    HOST_CHECK_EQUAL ( PDM_eSaveRecordData ( u16RecordId, pu8Data, u16Length ), PDM_E_STATUS_OK );
+    return HOST_u32FlashBusyUs ( ) - u32Before;
+}
+
+/* Index of a record ID in the reported list, or -1 */
+PRIVATE int iRecord ( tsTestTelemetry*    psTelemetry,
+                      uint16    u16RecordId )
+{
+    uint8    i;
+
+    for ( i = 0; i < psTelemetry->u8Records; i++ )
+    {
+        if ( psTelemetry->au16RecordId[i] == u16RecordId )
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Starts from cleared counters, whatever the application saved at init */
+PRIVATE void vStart ( void )
+{
+    tsTestTelemetry    sTelemetry;
+
+    HOST_vInit ( );
+    vTelemetry ( PDM_TELEMETRY_OPTION_RESET, &sTelemetry );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* Saves from a command handler and from elsewhere are told apart */
+PRIVATE void vCommandAndIdleSaves ( void )
+{
+    tsTestTelemetry    sTelemetry;
+    uint8              au8Data[12];
+    uint8              u8RawMode =  1;
+    uint16             u16ZllLength;
+    int                iZll;
+    int                iOwn;
+
+    vStart ( );
+    HOST_vSerialWrite ( E_SL_MSG_SET_RAWMODE, 1, &u8RawMode );
+    HOST_vRun ( 20 );
+    memset ( au8Data, 0, sizeof ( au8Data ) );
+    PDM_eSaveRecordData ( TEST_RECORD_BASE, au8Data, sizeof ( au8Data ) );
+    PDM_eSaveRecordData ( TEST_RECORD_BASE, au8Data, 4 );
+    PDM_bDoesDataExist ( PDM_ID_APP_ZLL_CMSSION, &u16ZllLength );
+
+    vTelemetry ( 0, &sTelemetry );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_SAVES] ), 3 );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_IN_COMMAND] ), 1 );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_IDLE] ), 2 );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_FAILED] ), 0 );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_BYTES] ), u16ZllLength + 16 );
+    HOST_CHECK_EQUAL ( sTelemetry.au8Summary[TEST_SUM_RECORDS], 2 );
+    HOST_CHECK_EQUAL ( sTelemetry.u8Records, 2 );
+    HOST_CHECK_EQUAL ( sTelemetry.u8RecordFrames, 1 );
+
+    iZll =  iRecord ( &sTelemetry, PDM_ID_APP_ZLL_CMSSION );
+    iOwn =  iRecord ( &sTelemetry, TEST_RECORD_BASE );
+    HOST_CHECK ( ( iZll >= 0 ) && ( iOwn >= 0 ) );
+    if ( ( iZll >= 0 ) && ( iOwn >= 0 ) )
+    {
+        HOST_CHECK_EQUAL ( sTelemetry.au32RecordSaves[iZll], 1 );
+        HOST_CHECK_EQUAL ( sTelemetry.au32RecordBytes[iZll], u16ZllLength );
+        HOST_CHECK_EQUAL ( sTelemetry.au32RecordSaves[iOwn], 2 );
+        HOST_CHECK_EQUAL ( sTelemetry.au32RecordBytes[iOwn], 16 );
+    }
+
+    /* Saves of a word or two program well under the first bound */
+    HOST_CHECK_EQUAL ( sTelemetry.au8Summary[TEST_SUM_BUCKETS], PDM_TELEMETRY_LATENCY_BUCKETS );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_LATENCY] ), 3 );
+}
+
+/* The reset option clears the counters once they have been reported */
+PRIVATE void vResetOption ( void )
+{
+    tsTestTelemetry    sTelemetry;
+    uint8              u8Data =  0;
+
+    vStart ( );
+    PDM_eSaveRecordData ( TEST_RECORD_BASE, &u8Data, 1 );
+    vTelemetry ( PDM_TELEMETRY_OPTION_RESET, &sTelemetry );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_SAVES] ), 1 );
+    HOST_CHECK_EQUAL ( sTelemetry.u8Records, 1 );
+
+    vTelemetry ( 0, &sTelemetry );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_SAVES] ), 0 );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_ERASES] ), 0 );
+    HOST_CHECK_EQUAL ( sTelemetry.au8Summary[TEST_SUM_RECORDS], 0 );
+    /* The record list is still sent, empty */
+    HOST_CHECK_EQUAL ( sTelemetry.u8RecordFrames, 1 );
+    HOST_CHECK_EQUAL ( sTelemetry.u8Records, 0 );
+}
+
+/* Wear counts of every segment are listed and add up to the summary */
+PRIVATE void vWearCounts ( void )
+{
+    tsTestTelemetry    sTelemetry;
+    uint8              u8Data =  0;
+    uint32             u32Erases =  0;
+    uint16             i;
+
+    vStart ( );
+    for ( i = 0; i < TEST_WEAR_SAVES; i++ )
+    {
+        PDM_eSaveRecordData ( TEST_RECORD_BASE, &u8Data, 1 );
+    }
+    for ( i = 0; i < PDM_NUM_SEGMENTS; i++ )
+    {
+        u32Erases +=  HOST_u32FlashEraseCount ( HOST_FLASH_PAGES + i );
+    }
+    vTelemetry ( 0, &sTelemetry );
+    HOST_CHECK_EQUAL ( sTelemetry.au8Summary[TEST_SUM_SEGMENTS], PDM_NUM_SEGMENTS );
+    HOST_CHECK_EQUAL ( sTelemetry.u8WearFrames,
+                       ( PDM_NUM_SEGMENTS + PDM_TELEMETRY_SEGMENTS_PER_FRAME - 1 ) / PDM_TELEMETRY_SEGMENTS_PER_FRAME );
+    HOST_CHECK_EQUAL ( sTelemetry.u32WearSum, u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_WEAR_TOTAL] ) );
+    /* Saves enough to go round the log erase the pages compaction frees */
+    HOST_CHECK ( u32Erases > 0 );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_ERASES] ), u32Erases );
+}
+
+/* Record IDs beyond the table share the overflow entry, the list spans
+ * several frames */
+PRIVATE void vRecordOverflow ( void )
+{
+    tsTestTelemetry    sTelemetry;
+    uint8              u8Data =  0;
+    uint16             i;
+    int                iOther;
+
+    vStart ( );
+    for ( i = 0; i < PDM_TELEMETRY_MAX_RECORDS + 3; i++ )
+    {
+        PDM_eSaveRecordData ( TEST_RECORD_BASE + i, &u8Data, 1 );
+    }
+    vTelemetry ( 0, &sTelemetry );
+    HOST_CHECK_EQUAL ( sTelemetry.au8Summary[TEST_SUM_RECORDS], PDM_TELEMETRY_MAX_RECORDS );
+    HOST_CHECK_EQUAL ( sTelemetry.u8Records, PDM_TELEMETRY_MAX_RECORDS );
+    HOST_CHECK_EQUAL ( sTelemetry.u8RecordFrames,
+                       ( PDM_TELEMETRY_MAX_RECORDS + PDM_TELEMETRY_RECORDS_PER_FRAME - 1 ) / PDM_TELEMETRY_RECORDS_PER_FRAME );
+    HOST_CHECK ( iRecord ( &sTelemetry, TEST_RECORD_BASE ) >= 0 );
+
+    iOther =  iRecord ( &sTelemetry, PDM_TELEMETRY_OTHER_RECORD_ID );
+    HOST_CHECK ( iOther >= 0 );
+    if ( iOther >= 0 )
+    {
+        HOST_CHECK_EQUAL ( sTelemetry.au32RecordSaves[iOther], 4 );
+    }
+}
+
+/* A save the PDM refuses is counted as failed */
+PRIVATE void vFailedSave ( void )
+{
+    tsTestTelemetry    sTelemetry;
+    uint8              u8Data =  0;
+    uint16             i;
+    uint32             u32Refused =  0;
+
+    vStart ( );
+    for ( i = 0; i < 100; i++ )
+    {
+        if ( PDM_eSaveRecordData ( TEST_RECORD_BASE + i, &u8Data, 1 ) != PDM_E_STATUS_OK )
+        {
+            u32Refused++;
+        }
+    }
+    HOST_CHECK ( u32Refused > 0 );
+    vTelemetry ( 0, &sTelemetry );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_SAVES] ), 100 );
+    HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_FAILED] ), u32Refused );
+}
+
+/* Saves sized to program a known number of flash words land one in each
+ * of the first buckets, and the save that has to erase a page first lands
+ * past the erase time; the histogram matches the flash time of every save */
+PRIVATE void vLatencyBuckets ( void )
+{
+    static uint8       au8Data[TEST_LATENCY_LARGEST];
+    tsTestTelemetry    sTelemetry;
+    uint16             au16Sizes[] =  TEST_LATENCY_SIZES;
+    uint32             au32Expected[PDM_TELEMETRY_LATENCY_BUCKETS];
+    uint32             u32DurationUs;
+    uint32             u32EraseUs =  0;
+    uint32             u32Compactions;
+    uint32             u32Saves   =  0;
+    uint16             u16After   =  0;
+    uint8              i;
+
+    vStart ( );
+    memset ( au32Expected, 0, sizeof ( au32Expected ) );
+    memset ( au8Data, 0, sizeof ( au8Data ) );
+    for ( i = 0; i < ( sizeof ( au16Sizes ) / sizeof ( au16Sizes[0] ) ); i++ )
+    {
+        u32DurationUs =  u32TimedSave ( TEST_RECORD_BASE + i, au8Data, au16Sizes[i] );
+        HOST_CHECK_EQUAL ( u8Bucket ( u32DurationUs ), i );
+        HOST_CHECK_EQUAL ( u32DurationUs % HOST_FLASH_PROGRAM_WORD_US, 0 );
+        au32Expected[u8Bucket ( u32DurationUs )]++;
+    }
+
+    /* Rewriting one small record goes round the log until compaction erases
+     * a page */
+    u32Compactions =  HOST_u32PdmCompactions ( );
+    while ( u16After < TEST_LATENCY_AFTER_ERASE )
+    {
+        u32DurationUs =  u32TimedSave ( TEST_RECORD_BASE, au8Data, 1 );
+        au32Expected[u8Bucket ( u32DurationUs )]++;
+        u32Saves++;
+        if ( HOST_u32PdmCompactions ( ) != u32Compactions )
+        {
+            u32Compactions =  HOST_u32PdmCompactions ( );
+            u32EraseUs     =  ( u32EraseUs > u32DurationUs ) ? u32EraseUs : u32DurationUs;
+        }
+        if ( u32EraseUs > 0 )
+        {
+            u16After++;
+        }
+        if ( u32Saves > TEST_WEAR_SAVES )
+        {
+            break;
+        }
+    }
+    HOST_CHECK ( u32EraseUs >= HOST_FLASH_ERASE_US );
+    HOST_CHECK ( u8Bucket ( u32EraseUs ) >= u8Bucket ( HOST_FLASH_ERASE_US ) );
+
+    vTelemetry ( 0, &sTelemetry );
+    HOST_CHECK_EQUAL ( sTelemetry.au8Summary[TEST_SUM_BUCKETS], PDM_TELEMETRY_LATENCY_BUCKETS );
+    for ( i = 0; i < PDM_TELEMETRY_LATENCY_BUCKETS; i++ )
+    {
+        HOST_CHECK_EQUAL ( u32Read32 ( &sTelemetry.au8Summary[TEST_SUM_LATENCY + 4 * i] ), au32Expected[i] );
+    }
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vCommandAndIdleSaves );
+    HOST_TEST ( vResetOption );
+    HOST_TEST ( vWearCounts );
+    HOST_TEST ( vRecordOverflow );
+    HOST_TEST ( vFailedSave );
+    HOST_TEST ( vLatencyBuckets );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
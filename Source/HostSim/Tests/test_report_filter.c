@@ -0,0 +1,316 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_report_filter.c
+ *
+ * DESCRIPTION:        Attribute report filter decisions: duplicates, the
+ *                     change threshold for signed, unsigned and 64 bit
+ *                     integers, values that are not integers, and the held
+ *                     back value sent when the minimum interval is over.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zcl.h"
+#include "SerialLink.h"
+#include "app_report_filter.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_ADDR                       0x4000
+#define TEST_ENDPOINT                   1
+#define TEST_CLUSTER                    0x0402
+#define TEST_ATTRIBUTE                  0x0000
+#define TEST_LINK_QUALITY               0x80
+
+/* Offsets into the 0x8102 payload */
+#define TEST_REPORT_SEQ                 0
+#define TEST_REPORT_TYPE                9
+#define TEST_REPORT_SIZE                10
+#define TEST_REPORT_VALUE               12
+
+/* Offsets into the 0x8124 payload */
+#define TEST_STATS_SUPPRESSED_RATE      14
+#define TEST_STATS_FLUSHED              26
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE void vSetRule ( uint16    u16DuplicateWindow,
+                        uint16    u16MinInterval,
+                        uint32    u32Threshold )
+{
+    uint8    au8Rule[REPORT_FILTER_RULE_LENGTH];
+    uint8    au8Stats[32];
+
+    au8Rule[0]  =  0;
+    au8Rule[1]  =  ( uint8 ) ( TEST_ADDR >> 8 );
+    au8Rule[2]  =  ( uint8 ) TEST_ADDR;
+    au8Rule[3]  =  REPORT_FILTER_ANY_ENDPOINT;
+    au8Rule[4]  =  ( uint8 ) ( TEST_CLUSTER >> 8 );
+    au8Rule[5]  =  ( uint8 ) TEST_CLUSTER;
+    au8Rule[6]  =  ( uint8 ) ( REPORT_FILTER_ANY_ATTRIBUTE >> 8 );
+    au8Rule[7]  =  ( uint8 ) REPORT_FILTER_ANY_ATTRIBUTE;
+    au8Rule[8]  =  ( uint8 ) ( u16DuplicateWindow >> 8 );
+    au8Rule[9]  =  ( uint8 ) u16DuplicateWindow;
+    au8Rule[10] =  ( uint8 ) ( u16MinInterval >> 8 );
+    au8Rule[11] =  ( uint8 ) u16MinInterval;
+    au8Rule[12] =  ( uint8 ) ( u32Threshold >> 24 );
+    au8Rule[13] =  ( uint8 ) ( u32Threshold >> 16 );
+    au8Rule[14] =  ( uint8 ) ( u32Threshold >> 8 );
+    au8Rule[15] =  ( uint8 ) u32Threshold;
+
+    HOST_vInit ( );
+    APP_u8ReportFilterSetRule ( au8Rule, sizeof ( au8Rule ) );
+    APP_u16ReportFilterGetStats ( au8Stats, TRUE );
+    HOST_vSerialFlush ( );
+}
+
+/* A report of a big endian value of up to 64 bits */
+PRIVATE bool_t bReport ( uint8     u8SeqNum,
+                         uint8     u8DataType,
+                         uint64    u64Value,
+                         uint8     u8Size )
+{
+    uint8    au8Value[8];
+    uint8    i;
+
+    for ( i = 0; i < u8Size; i++ )
+    {
+        au8Value[i] =  ( uint8 ) ( u64Value >> ( 8 * ( u8Size - 1 - i ) ) );
+    }
+    return APP_bReportFilterForward ( u8SeqNum, TEST_ADDR, TEST_ENDPOINT, TEST_CLUSTER, TEST_ATTRIBUTE,
+                                      u8DataType, au8Value, u8Size, TEST_LINK_QUALITY );
+}
+
+PRIVATE void vTicks ( uint16    u16Ticks )
+{
+    while ( u16Ticks-- > 0 )
+    {
+        APP_vReportFilterTick ( );
+    }
+}
+
+PRIVATE uint32 u32Stat ( uint8    u8Offset )
+{
+    uint8    au8Stats[32];
+
+    APP_u16ReportFilterGetStats ( au8Stats, FALSE );
+    return ( ( uint32 ) au8Stats[u8Offset] << 24 ) | ( ( uint32 ) au8Stats[u8Offset + 1] << 16 ) |
+           ( ( uint32 ) au8Stats[u8Offset + 2] << 8 ) | au8Stats[u8Offset + 3];
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+PRIVATE void vUnmatchedReportsPass ( void )
+{
+    uint8    u8Value =  1;
+
+    vSetRule ( 10, 10, 0 );
+    HOST_CHECK ( APP_bReportFilterForward ( 1, TEST_ADDR + 1, TEST_ENDPOINT, TEST_CLUSTER, TEST_ATTRIBUTE,
+                                            E_ZCL_UINT8, &u8Value, 1, TEST_LINK_QUALITY ) );
+    HOST_CHECK ( APP_bReportFilterForward ( 2, TEST_ADDR + 1, TEST_ENDPOINT, TEST_CLUSTER, TEST_ATTRIBUTE,
+                                            E_ZCL_UINT8, &u8Value, 1, TEST_LINK_QUALITY ) );
+}
+
+PRIVATE void vDuplicatesWaitForTheWindow ( void )
+{
+    vSetRule ( 10, 0, 0 );
+    HOST_CHECK ( bReport ( 1, E_ZCL_INT16, 2150, 2 ) );
+    vTicks ( 9 );
+    HOST_CHECK ( !bReport ( 2, E_ZCL_INT16, 2150, 2 ) );
+    vTicks ( 1 );
+    HOST_CHECK ( bReport ( 3, E_ZCL_INT16, 2150, 2 ) );
+    /* Without a minimum interval any change goes straight through */
+    HOST_CHECK ( bReport ( 4, E_ZCL_INT16, 2151, 2 ) );
+}
+
+/* Signed values compare as signed, unsigned ones as unsigned */
+PRIVATE void vThresholdKeepsTheSign ( void )
+{
+    vSetRule ( 0, 100, 5 );
+    HOST_CHECK ( bReport ( 1, E_ZCL_INT8, 0xff, 1 ) );
+    HOST_CHECK ( !bReport ( 2, E_ZCL_INT8, 0x01, 1 ) );
+    HOST_CHECK ( bReport ( 3, E_ZCL_INT8, 0x80, 1 ) );
+
+    vSetRule ( 0, 100, 5 );
+    HOST_CHECK ( bReport ( 1, E_ZCL_UINT8, 0xff, 1 ) );
+    HOST_CHECK ( bReport ( 2, E_ZCL_UINT8, 0x01, 1 ) );
+
+    vSetRule ( 0, 100, 5 );
+    HOST_CHECK ( bReport ( 1, E_ZCL_INT24, 0xfffffe, 3 ) );
+    HOST_CHECK ( !bReport ( 2, E_ZCL_INT24, 0x000002, 3 ) );
+}
+
+/* All 64 bits take part without overflowing the comparison */
+PRIVATE void vWideIntegers ( void )
+{
+    vSetRule ( 0, 100, 5 );
+    HOST_CHECK ( bReport ( 1, E_ZCL_UINT64, 0xfffffffffffffffeULL, 8 ) );
+    HOST_CHECK ( !bReport ( 2, E_ZCL_UINT64, 0xffffffffffffffffULL, 8 ) );
+    HOST_CHECK ( bReport ( 3, E_ZCL_UINT64, 0x7fffffffffffffffULL, 8 ) );
+
+    vSetRule ( 0, 100, 5 );
+    HOST_CHECK ( bReport ( 1, E_ZCL_INT64, 0x8000000000000000ULL, 8 ) );
+    HOST_CHECK ( bReport ( 2, E_ZCL_INT64, 0x7fffffffffffffffULL, 8 ) );
+    HOST_CHECK ( !bReport ( 3, E_ZCL_INT64, 0x7ffffffffffffffcULL, 8 ) );
+
+    vSetRule ( 0, 100, 5 );
+    HOST_CHECK ( bReport ( 1, E_ZCL_UINT48, 0xffffffffffffULL, 6 ) );
+    HOST_CHECK ( !bReport ( 2, E_ZCL_UINT48, 0xfffffffffffbULL, 6 ) );
+}
+
+/* Only the hash decides for values that are not integers of 8 bytes or
+ * fewer, so every change goes through */
+PRIVATE void vOtherValuesForwardOnChange ( void )
+{
+    uint8    au8Value[16];
+
+    vSetRule ( 0, 100, 1000 );
+    memset ( au8Value, 0x11, sizeof ( au8Value ) );
+    HOST_CHECK ( APP_bReportFilterForward ( 1, TEST_ADDR, TEST_ENDPOINT, TEST_CLUSTER, TEST_ATTRIBUTE,
+                                            E_ZCL_OSTRING, au8Value, sizeof ( au8Value ), TEST_LINK_QUALITY ) );
+    HOST_CHECK ( !APP_bReportFilterForward ( 2, TEST_ADDR, TEST_ENDPOINT, TEST_CLUSTER, TEST_ATTRIBUTE,
+                                             E_ZCL_OSTRING, au8Value, sizeof ( au8Value ), TEST_LINK_QUALITY ) );
+    au8Value[15] =  0x12;
+    HOST_CHECK ( APP_bReportFilterForward ( 3, TEST_ADDR, TEST_ENDPOINT, TEST_CLUSTER, TEST_ATTRIBUTE,
+                                            E_ZCL_OSTRING, au8Value, sizeof ( au8Value ), TEST_LINK_QUALITY ) );
+
+    /* An integer type with more bytes than any integer can have */
+    au8Value[15] =  0x13;
+    HOST_CHECK ( APP_bReportFilterForward ( 4, TEST_ADDR, TEST_ENDPOINT, TEST_CLUSTER, TEST_ATTRIBUTE,
+                                            E_ZCL_UINT64, au8Value, 12, TEST_LINK_QUALITY ) );
+    au8Value[0] =  0x10;
+    HOST_CHECK ( APP_bReportFilterForward ( 5, TEST_ADDR, TEST_ENDPOINT, TEST_CLUSTER, TEST_ATTRIBUTE,
+                                            E_ZCL_UINT64, au8Value, 12, TEST_LINK_QUALITY ) );
+
+    vSetRule ( 0, 100, 1000 );
+    HOST_CHECK ( bReport ( 1, E_ZCL_FLOAT_SEMI, 0x3c00, 2 ) );
+    HOST_CHECK ( bReport ( 2, E_ZCL_FLOAT_SEMI, 0x3c01, 2 ) );
+}
+
+/* The last change held back reaches the host once the interval is over,
+ * as the report it came in */
+PRIVATE void vHeldBackValueIsFlushed ( void )
+{
+    tsHostSerialFrame    sFrame;
+
+    vSetRule ( 0, 10, 5 );
+    HOST_CHECK ( bReport ( 1, E_ZCL_INT16, 2150, 2 ) );
+    HOST_CHECK ( !bReport ( 2, E_ZCL_INT16, 2152, 2 ) );
+    HOST_CHECK ( !bReport ( 3, E_ZCL_INT16, 2153, 2 ) );
+    vTicks ( 9 );
+    HOST_CHECK ( !HOST_bSerialFind ( E_SL_MSG_REPORT_IND_ATTR_RESPONSE, &sFrame ) );
+    vTicks ( 1 );
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_REPORT_IND_ATTR_RESPONSE, &sFrame ) );
+    HOST_CHECK ( sFrame.bCrcOk );
+    HOST_CHECK_EQUAL ( sFrame.u16Length, TEST_REPORT_VALUE + 2 + 1 );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_REPORT_SEQ], 3 );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_REPORT_TYPE], E_ZCL_INT16 );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_REPORT_SIZE + 1], 2 );
+    HOST_CHECK_EQUAL ( ( sFrame.au8Payload[TEST_REPORT_VALUE] << 8 ) | sFrame.au8Payload[TEST_REPORT_VALUE + 1], 2153 );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_REPORT_VALUE + 2], TEST_LINK_QUALITY );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_SUPPRESSED_RATE ), 2 );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_FLUSHED ), 1 );
+
+    /* What was flushed is now the value the host has */
+    HOST_CHECK ( !bReport ( 4, E_ZCL_INT16, 2153, 2 ) );
+    HOST_CHECK ( !bReport ( 5, E_ZCL_INT16, 2158, 2 ) );
+    HOST_CHECK ( bReport ( 6, E_ZCL_INT16, 2159, 2 ) );
+    vTicks ( 20 );
+    HOST_CHECK ( !HOST_bSerialFind ( E_SL_MSG_REPORT_IND_ATTR_RESPONSE, &sFrame ) );
+}
+
+/* Nothing is flushed when the value went back to what the host has */
+PRIVATE void vReturnToForwardedValueCancelsFlush ( void )
+{
+    tsHostSerialFrame    sFrame;
+
+    vSetRule ( 0, 10, 5 );
+    HOST_CHECK ( bReport ( 1, E_ZCL_UINT16, 500, 2 ) );
+    HOST_CHECK ( !bReport ( 2, E_ZCL_UINT16, 503, 2 ) );
+    HOST_CHECK ( !bReport ( 3, E_ZCL_UINT16, 500, 2 ) );
+    vTicks ( 20 );
+    HOST_CHECK ( !HOST_bSerialFind ( E_SL_MSG_REPORT_IND_ATTR_RESPONSE, &sFrame ) );
+    HOST_CHECK_EQUAL ( u32Stat ( TEST_STATS_FLUSHED ), 0 );
+}
+
+/* A report through the ZCL reaches the filter with its value and is sent
+ * or held back accordingly */
+PRIVATE void vReportsFromTheAir ( void )
+{
+    tsHostSerialFrame    sFrame;
+    uint8                au8Report[] = { 0x18, 0x01, 0x0a, 0x00, 0x00, E_ZCL_INT16, 0x66, 0x08 };
+
+    vSetRule ( 0, 10, 5 );
+    HOST_vAddDevice ( TEST_ADDR, 0x00158D0000400000ULL, FALSE );
+    HOST_vDataIndication ( TEST_ADDR, TEST_ENDPOINT, 1, TEST_CLUSTER, 0x0104, au8Report, sizeof ( au8Report ) );
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_REPORT_IND_ATTR_RESPONSE, &sFrame ) );
+    HOST_CHECK_EQUAL ( ( sFrame.au8Payload[TEST_REPORT_VALUE] << 8 ) | sFrame.au8Payload[TEST_REPORT_VALUE + 1], 0x0866 );
+
+    au8Report[1] =  0x02;
+    au8Report[6] =  0x68;
+    HOST_vDataIndication ( TEST_ADDR, TEST_ENDPOINT, 1, TEST_CLUSTER, 0x0104, au8Report, sizeof ( au8Report ) );
+    HOST_CHECK ( !HOST_bSerialFind ( E_SL_MSG_REPORT_IND_ATTR_RESPONSE, &sFrame ) );
+    /* First tick a second after start, then every 100ms */
+    HOST_vRun ( 2000 );
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_REPORT_IND_ATTR_RESPONSE, &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_REPORT_SEQ], 0x02 );
+    HOST_CHECK_EQUAL ( ( sFrame.au8Payload[TEST_REPORT_VALUE] << 8 ) | sFrame.au8Payload[TEST_REPORT_VALUE + 1], 0x0868 );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vUnmatchedReportsPass );
+    HOST_TEST ( vDuplicatesWaitForTheWindow );
+    HOST_TEST ( vThresholdKeepsTheSign );
+    HOST_TEST ( vWideIntegers );
+    HOST_TEST ( vOtherValuesForwardOnChange );
+    HOST_TEST ( vHeldBackValueIsFlushed );
+    HOST_TEST ( vReturnToForwardedValueCancelsFlush );
+    HOST_TEST ( vReportsFromTheAir );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,424 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_serial_link.c
+ *
+ * DESCRIPTION:        Serial link framing: a message written from segments
+ *                     with vSL_WriteMessageVector is byte for byte the frame
+ *                     vSL_WriteMessage writes from one contiguous buffer,
+ *                     checksum and escaping included. Then the cost of a
+ *                     data indication sent both ways: header and payload
+ *                     copied into one buffer for vSL_WriteMessage as before,
+ *                     against the header and the APDU payload handed to
+ *                     vSL_WriteMessageVector, timed with clock_gettime and
+ *                     with the peak stack found by app_stack_watermark.c.
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include "SerialLink.h"
+#include "app_stack_watermark.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_MAX_PAYLOAD                255
+#define TEST_MESSAGE_TYPE               0x8002
+
+/* Worst case frame: every byte escaped, plus start and end characters */
+#define TEST_MAX_FRAME                  ( 2 + 2 * ( 5 + TEST_MAX_PAYLOAD + 1 ) )
+
+/* Data indication header with short addresses, and the buffer the callers
+ * of Znc_vSendDataIndicationToHost build it in */
+#define TEST_INDICATION_HEADER          13
+#define TEST_LINK_TX_BUFFER             256
+
+/* Indications written between flushes of the captured bytes, and batches
+ * timed for each payload size */
+#define TEST_BATCH                      32
+#define TEST_BATCHES                    2000
+
+/* Main loop passes to paint the whole stack, or to sweep all of it */
+#define TEST_PASSES                     ( HOST_STACK_WORDS / STACK_WATERMARK_WORDS_PER_IDLE + 8 )
+
+/* Offset of the peak in the STACK_WATERMARK_OP_REPORT response */
+#define TEST_REPORT_PEAK                4
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+    E_TEST_PATTERN_MIXED,
+    E_TEST_PATTERN_ESCAPED,
+    E_TEST_PATTERN_FRAMING,
+    E_TEST_PATTERN_COUNT
+} teTestPattern;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE ucontext_t      sTestMainContext;
+PRIVATE ucontext_t      sTestStackContext;
+PRIVATE void            ( *pfTestScenario ) ( void );
+
+/* The indication the writers send: its header fields and APDU payload */
+PRIVATE uint8           au8TestHeader[TEST_INDICATION_HEADER];
+PRIVATE uint8           au8TestApdu[TEST_MAX_PAYLOAD];
+PRIVATE uint16          u16TestApduLength;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE void vFill ( uint8*           pu8Data,
+                     uint16           u16Length,
+                     teTestPattern    ePattern )
+{
+    uint16    i;
+
+    for ( i = 0; i < u16Length; i++ )
+    {
+        switch ( ePattern )
+        {
+            case E_TEST_PATTERN_ESCAPED:
+                /* Every byte below 0x10 goes out escaped */
+                pu8Data[i] =  ( uint8 ) ( i & 0x0f );
+            break;
+
+            case E_TEST_PATTERN_FRAMING:
+                /* Start, escape and end characters inside the payload */
+                pu8Data[i] =  ( i & 1 ) ? SL_END_CHAR : SL_START_CHAR;
+            break;
+
+            default:
+                pu8Data[i] =  ( uint8 ) ( i * 37 + 11 );
+            break;
+        }
+    }
+}
+
+/* Raw bytes of one message written the contiguous way */
+PRIVATE uint32 u32WriteContiguous ( const uint8*    pu8Data,
+                                    uint16          u16Length,
+                                    uint8           u8LinkQuality,
+                                    uint8*          pu8Frame )
+{
+    uint8    au8Buffer[TEST_MAX_PAYLOAD + 1];
+
+    memcpy ( au8Buffer, pu8Data, u16Length );
+    HOST_vSerialFlush ( );
+    vSL_WriteMessage ( TEST_MESSAGE_TYPE, u16Length, au8Buffer, u8LinkQuality );
+    return HOST_u32SerialTxRaw ( pu8Frame, TEST_MAX_FRAME );
+}
+
+/* Raw bytes of the same message written from up to three segments split at
+ * the given offsets; equal offsets give empty segments */
+PRIVATE uint32 u32WriteSegments ( const uint8*    pu8Data,
+                                  uint16          u16Length,
+                                  uint16          u16Split1,
+                                  uint16          u16Split2,
+                                  uint8           u8LinkQuality,
+                                  uint8*          pu8Frame )
+{
+    tsSL_Segment    asSegments[3];
+
+    asSegments[0].pu8Data   =  pu8Data;
+    asSegments[0].u16Length =  u16Split1;
+    asSegments[1].pu8Data   =  pu8Data + u16Split1;
+    asSegments[1].u16Length =  u16Split2 - u16Split1;
+    asSegments[2].pu8Data   =  pu8Data + u16Split2;
+    asSegments[2].u16Length =  u16Length - u16Split2;
+
+    HOST_vSerialFlush ( );
+    vSL_WriteMessageVector ( TEST_MESSAGE_TYPE, 3, asSegments, u8LinkQuality );
+    return HOST_u32SerialTxRaw ( pu8Frame, TEST_MAX_FRAME );
+}
+
+PRIVATE uint64 u64Ns ( void )
+{
+    struct timespec    sNow;
+
+    clock_gettime ( CLOCK_MONOTONIC, &sNow );
+    return ( ( uint64 ) sNow.tv_sec * 1000000000ULL ) + ( uint64 ) sNow.tv_nsec;
+}
+
+/* The indication as it was sent: header and payload copied into the
+ * caller's buffer a byte at a time, then written from there */
+PRIVATE __attribute__ ( ( noinline ) ) void vIndicationCopy ( void )
+{
+    uint8     au8LinkTxBuffer[TEST_LINK_TX_BUFFER];
+    uint16    u16Length =  0;
+    uint16    i;
+
+    for ( i = 0; i < TEST_INDICATION_HEADER; i++ )
+    {
+        au8LinkTxBuffer[u16Length++] =  au8TestHeader[i];
+    }
+    for ( i = 0; i < u16TestApduLength; i++ )
+    {
+        au8LinkTxBuffer[u16Length++] =  au8TestApdu[i];
+    }
+    vSL_WriteMessage ( E_SL_MSG_DATA_INDICATION, u16Length, au8LinkTxBuffer, 0xC8 );
+}
+
+/* The indication as it is sent now: the header, then the payload from the
+ * APDU in place */
+PRIVATE __attribute__ ( ( noinline ) ) void vIndicationVector ( void )
+{
+    uint8           au8Header[TEST_INDICATION_HEADER];
+    tsSL_Segment    asSegments[2];
+
+    memcpy ( au8Header, au8TestHeader, TEST_INDICATION_HEADER );
+    asSegments[0].pu8Data   =  au8Header;
+    asSegments[0].u16Length =  TEST_INDICATION_HEADER;
+    asSegments[1].pu8Data   =  au8TestApdu;
+    asSegments[1].u16Length =  u16TestApduLength;
+    vSL_WriteMessageVector ( E_SL_MSG_DATA_INDICATION, 2, asSegments, 0xC8 );
+}
+
+PRIVATE void vOnStackEntry ( void )
+{
+    pfTestScenario ( );
+}
+
+/* Runs a scenario on the measured stack, each from the same frame */
+PRIVATE void vOnStack ( void    ( *pfScenario ) ( void ) )
+{
+    pfTestScenario =  pfScenario;
+    getcontext ( &sTestStackContext );
+    sTestStackContext.uc_stack.ss_sp   =  au32HostStack;
+    sTestStackContext.uc_stack.ss_size =  sizeof ( au32HostStack );
+    sTestStackContext.uc_link          =  &sTestMainContext;
+    makecontext ( &sTestStackContext, vOnStackEntry, 0 );
+    swapcontext ( &sTestMainContext, &sTestStackContext );
+}
+
+/* Passes of the main loop with nothing else running */
+PRIVATE void vIdle ( void )
+{
+    uint16    i;
+
+    for ( i = 0; i < TEST_PASSES; i++ )
+    {
+        APP_vStackWatermarkIdle ( );
+    }
+}
+
+/* Bytes of stack below the top a writer reached: the stack is painted,
+ * the writer run, then the sweep finds the deepest word it touched. The
+ * caller's buffer is only written part way, which the check made when a
+ * handler returns would stop short of. */
+PRIVATE uint16 u16PeakStack ( void    ( *pfWriter ) ( void ) )
+{
+    tsHostSerialFrame    sFrame;
+    uint8                au8Command[2] =  { STACK_WATERMARK_OP_REPORT, STACK_WATERMARK_OPTION_RESET };
+
+    APP_vStackWatermarkInit ( );
+    vOnStack ( vIdle );
+    vOnStack ( pfWriter );
+    vOnStack ( vIdle );
+
+    HOST_vSerialFlush ( );
+    APP_vStackWatermarkCommand ( au8Command, sizeof ( au8Command ) );
+    if ( !HOST_bSerialFind ( E_SL_MSG_STACK_WATERMARK_RESPONSE, &sFrame ) )
+    {
+        return 0;
+    }
+    return ( uint16 ) ( ( sFrame.au8Payload[TEST_REPORT_PEAK] << 8 ) | sFrame.au8Payload[TEST_REPORT_PEAK + 1] );
+}
+
+/* Nanoseconds a writer takes per indication, captured bytes flushed
+ * outside the timing */
+PRIVATE uint32 u32WriteNs ( void    ( *pfWriter ) ( void ) )
+{
+    uint64    u64Total =  0;
+    uint64    u64Start;
+    uint32    i;
+    uint8     j;
+
+    for ( i = 0; i < TEST_BATCHES; i++ )
+    {
+        HOST_vSerialFlush ( );
+        u64Start =  u64Ns ( );
+        for ( j = 0; j < TEST_BATCH; j++ )
+        {
+            pfWriter ( );
+        }
+        u64Total +=  u64Ns ( ) - u64Start;
+    }
+    return ( uint32 ) ( u64Total / ( ( uint64 ) TEST_BATCHES * TEST_BATCH ) );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* Every length, split and payload pattern gives the same frame both ways */
+PRIVATE void vVectorMatchesContiguous ( void )
+{
+    static const uint16    au16Lengths[] = { 0, 1, 15, 16, 17, 82, 200, TEST_MAX_PAYLOAD - 1 };
+    static const uint8     au8LinkQualities[] = { 0x00, SL_ESC_CHAR, 0xff };
+    uint8                  au8Data[TEST_MAX_PAYLOAD];
+    uint8                  au8Contiguous[TEST_MAX_FRAME];
+    uint8                  au8Vector[TEST_MAX_FRAME];
+    uint32                 u32Contiguous;
+    uint32                 u32Vector;
+    uint32                 u32Mismatches =  0;
+    uint32                 u32Frames     =  0;
+    uint16                 u16Length;
+    uint16                 u16Split1;
+    uint16                 u16Split2;
+    uint8                  i;
+    uint8                  j;
+    uint8                  k;
+
+    HOST_vInit ( );
+    for ( i = 0; i < sizeof ( au16Lengths ) / sizeof ( au16Lengths[0] ); i++ )
+    {
+        u16Length =  au16Lengths[i];
+        for ( j = 0; j < E_TEST_PATTERN_COUNT; j++ )
+        {
+            vFill ( au8Data, u16Length, ( teTestPattern ) j );
+            for ( k = 0; k < sizeof ( au8LinkQualities ); k++ )
+            {
+                u32Contiguous =  u32WriteContiguous ( au8Data, u16Length, au8LinkQualities[k], au8Contiguous );
+
+                /* Header and payload as the data indication splits them,
+                 * then three way with an empty segment in the middle */
+                for ( u16Split1 = 0; u16Split1 <= u16Length; u16Split1 +=  ( u16Length / 3 ) + 1 )
+                {
+                    u16Split2 =  u16Split1 + ( u16Length - u16Split1 ) / 2;
+                    u32Vector =  u32WriteSegments ( au8Data, u16Length, u16Split1, u16Split1,
+                                                    au8LinkQualities[k], au8Vector );
+                    if ( ( u32Vector != u32Contiguous ) || memcmp ( au8Vector, au8Contiguous, u32Vector ) )
+                    {
+                        u32Mismatches++;
+                    }
+                    u32Vector =  u32WriteSegments ( au8Data, u16Length, u16Split1, u16Split2,
+                                                    au8LinkQualities[k], au8Vector );
+                    if ( ( u32Vector != u32Contiguous ) || memcmp ( au8Vector, au8Contiguous, u32Vector ) )
+                    {
+                        u32Mismatches++;
+                    }
+                    u32Frames +=  2;
+                }
+            }
+        }
+    }
+
+    printf ( "  %u segmented frames compared\n", ( unsigned ) u32Frames );
+    HOST_CHECK_EQUAL ( u32Mismatches, 0 );
+}
+
+/* The checksum sent is the one the host recomputes over the payload and the
+ * link quality byte that ends it */
+PRIVATE void vVectorChecksumIsValid ( void )
+{
+    tsHostSerialFrame    sFrame;
+    uint8                au8Data[200];
+    uint8                au8Frame[TEST_MAX_FRAME];
+    uint8                au8Expected[sizeof ( au8Data ) + 1];
+
+    HOST_vInit ( );
+    vFill ( au8Data, sizeof ( au8Data ), E_TEST_PATTERN_MIXED );
+    memcpy ( au8Expected, au8Data, sizeof ( au8Data ) );
+    au8Expected[sizeof ( au8Data )] =  0x42;
+
+    u32WriteSegments ( au8Data, sizeof ( au8Data ), 17, 17, 0x42, au8Frame );
+    HOST_CHECK ( HOST_bSerialFind ( TEST_MESSAGE_TYPE, &sFrame ) );
+    HOST_CHECK ( sFrame.bCrcOk );
+    HOST_CHECK_EQUAL ( sFrame.u16Length, sizeof ( au8Expected ) );
+    HOST_CHECK_EQUAL ( memcmp ( sFrame.au8Payload, au8Expected, sizeof ( au8Expected ) ), 0 );
+}
+
+/* 50 and 100 byte indications both ways: the same frame, the time each
+ * takes and the stack each needs */
+PRIVATE void vIndicationCost ( void )
+{
+    static const uint16    au16Lengths[] = { 50, 100 };
+    uint8                  au8Copy[TEST_MAX_FRAME];
+    uint8                  au8Vector[TEST_MAX_FRAME];
+    uint32                 u32Copy;
+    uint32                 u32Vector;
+    uint16                 u16CopyStack;
+    uint16                 u16VectorStack;
+    uint8                  i;
+
+    HOST_vInit ( );
+    vFill ( au8TestHeader, TEST_INDICATION_HEADER, E_TEST_PATTERN_MIXED );
+    for ( i = 0; i < sizeof ( au16Lengths ) / sizeof ( au16Lengths[0] ); i++ )
+    {
+        u16TestApduLength =  au16Lengths[i] - TEST_INDICATION_HEADER;
+        vFill ( au8TestApdu, u16TestApduLength, E_TEST_PATTERN_MIXED );
+
+        HOST_vSerialFlush ( );
+        vIndicationCopy ( );
+        u32Copy =  HOST_u32SerialTxRaw ( au8Copy, sizeof ( au8Copy ) );
+        HOST_vSerialFlush ( );
+        vIndicationVector ( );
+        u32Vector =  HOST_u32SerialTxRaw ( au8Vector, sizeof ( au8Vector ) );
+        HOST_CHECK_EQUAL ( u32Vector, u32Copy );
+        HOST_CHECK_EQUAL ( memcmp ( au8Vector, au8Copy, u32Copy ), 0 );
+
+        u16CopyStack   =  u16PeakStack ( vIndicationCopy );
+        u16VectorStack =  u16PeakStack ( vIndicationVector );
+        HOST_CHECK ( u16CopyStack > 0 );
+        HOST_CHECK ( u16VectorStack > 0 );
+        HOST_CHECK ( u16VectorStack < u16CopyStack );
+
+        printf ( "  %3u byte indication: copy and write %4u ns, %4u stack bytes; vector %4u ns, %4u stack bytes\n",
+                 au16Lengths[i],
+                 ( unsigned ) u32WriteNs ( vIndicationCopy ), u16CopyStack,
+                 ( unsigned ) u32WriteNs ( vIndicationVector ), u16VectorStack );
+    }
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vVectorMatchesContiguous );
+    HOST_TEST ( vVectorChecksumIsValid );
+    HOST_TEST ( vIndicationCost );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
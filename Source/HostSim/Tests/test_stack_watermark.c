@@ -0,0 +1,433 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_stack_watermark.c
+ *
+ * DESCRIPTION:        Stack high-water attribution: each scenario runs on
+ *                     au32HostStack, the stack __StackLimit and _vStackTop
+ *                     bound, so that painting, the checks as handlers
+ *                     return and the sweep all see the words it used. A
+ *                     new mark is credited to the handler that set it and
+ *                     the tasks around it, use between handlers is found
+ *                     by the sweep unattributed, and a repaint lets a
+ *                     shallower handler be measured.
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <stdint.h>
+#include <string.h>
+#include <ucontext.h>
+#include "SerialLink.h"
+#include "app_stack_watermark.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Bytes used by each scenario, each well clear of the last */
+#define TEST_DEEP                       1024
+#define TEST_DEEPER                     2048
+#define TEST_DEEPEST                    3072
+#define TEST_SHALLOW                    512
+
+/* Frames, saved registers and the word alignment below a buffer */
+#define TEST_DEPTH_SLACK                128
+
+/* Main loop passes to paint the whole stack, then to sweep all of it */
+#define TEST_PASSES                     ( 2 * HOST_STACK_WORDS / STACK_WATERMARK_WORDS_PER_IDLE + 8 )
+
+#define TEST_COMMAND_ID                 0x0049
+#define TEST_STACK_EVENT_ID             0x0001
+
+/* Offsets into the STACK_WATERMARK_OP_REPORT response */
+#define TEST_REPORT_SIZE                2
+#define TEST_REPORT_PEAK                4
+#define TEST_REPORT_PEAK_KIND           6
+#define TEST_REPORT_PEAK_ID             7
+#define TEST_REPORT_DEPTH               9
+#define TEST_REPORT_SWEEPS              11
+#define TEST_REPORT_REPAINTS            13
+#define TEST_REPORT_UNATTRIBUTED        15
+#define TEST_REPORT_OVERFLOW            17
+#define TEST_REPORT_COUNT               18
+#define TEST_REPORT_HANDLERS            19
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint16    u16Size;
+    uint16    u16Peak;
+    uint8     u8PeakKind;
+    uint16    u16PeakId;
+    uint16    u16Depth;
+    uint16    u16Sweeps;
+    uint16    u16Repaints;
+    uint16    u16Unattributed;
+    uint8     u8Overflow;
+    uint8     u8Count;
+    uint8     au8Handlers[STACK_WATERMARK_HANDLERS * 7];
+} tsTestReport;
+
+/****************************************************************************/
+/***        Local Variables                                               ***/
+/****************************************************************************/
+PRIVATE ucontext_t    sTestMainContext;
+PRIVATE ucontext_t    sTestStackContext;
+PRIVATE void          ( *pfTestScenario ) ( void );
+
+/* Depth of the lowest byte the last vUse touched */
+PRIVATE uint16        u16TestUsed;
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE uint16 u16Read16 ( const uint8*    pu8Data )
+{
+    return ( uint16 ) ( ( pu8Data[0] << 8 ) | pu8Data[1] );
+}
+
+PRIVATE void vOnStackEntry ( void )
+{
+    pfTestScenario ( );
+}
+
+/* Runs a scenario on the measured stack, each from the same frame */
+PRIVATE void vOnStack ( void    ( *pfScenario ) ( void ) )
+{
+    pfTestScenario =  pfScenario;
+    getcontext ( &sTestStackContext );
+    sTestStackContext.uc_stack.ss_sp   =  au32HostStack;
+    sTestStackContext.uc_stack.ss_size =  sizeof ( au32HostStack );
+    sTestStackContext.uc_link          =  &sTestMainContext;
+    makecontext ( &sTestStackContext, vOnStackEntry, 0 );
+    swapcontext ( &sTestMainContext, &sTestStackContext );
+}
+
+/* Writes every byte of a buffer of the given size on the stack */
+#define TEST_USE( NAME, SIZE )                                                 \
+    PRIVATE __attribute__ ( ( noinline ) ) void NAME ( void )                  \
+    {                                                                          \
+        volatile uint8    au8Buffer[SIZE] __attribute__ ( ( aligned ( 4 ) ) ); \
+        uint16            i;                                                   \
+                                                                               \
+        for ( i = 0; i < SIZE; i++ )                                           \
+        {                                                                      \
+            au8Buffer[i] =  ( uint8 ) ( i | 1 );                               \
+        }                                                                      \
+        u16TestUsed =  ( uint16 ) ( ( uintptr_t ) &au32HostStack[HOST_STACK_WORDS] - \
+                                    ( uintptr_t ) &au8Buffer[0] );             \
+    }
+
+TEST_USE ( vUseDeep,     TEST_DEEP )
+TEST_USE ( vUseDeeper,   TEST_DEEPER )
+TEST_USE ( vUseDeepest,  TEST_DEEPEST )
+TEST_USE ( vUseShallow,  TEST_SHALLOW )
+
+/* Passes of the main loop with nothing else running */
+PRIVATE void vIdle ( void )
+{
+    uint16    i;
+
+    for ( i = 0; i < TEST_PASSES; i++ )
+    {
+        APP_vStackWatermarkIdle ( );
+    }
+}
+
+/* A host command run by the serial task */
+PRIVATE void vCommand ( void )
+{
+    APP_vStackWatermarkEnter ( STACK_WATERMARK_KIND_TASK, STACK_WATERMARK_TASK_SERIAL );
+    APP_vStackWatermarkEnter ( STACK_WATERMARK_KIND_COMMAND, TEST_COMMAND_ID );
+    vUseDeep ( );
+    APP_vStackWatermarkExit ( );
+    APP_vStackWatermarkExit ( );
+}
+
+/* A stack event run by the ZPS task, deeper than the command */
+PRIVATE void vStackEvent ( void )
+{
+    APP_vStackWatermarkEnter ( STACK_WATERMARK_KIND_TASK, STACK_WATERMARK_TASK_ZPS );
+    APP_vStackWatermarkEnter ( STACK_WATERMARK_KIND_STACK_EVENT, TEST_STACK_EVENT_ID );
+    vUseDeeper ( );
+    APP_vStackWatermarkExit ( );
+    APP_vStackWatermarkExit ( );
+}
+
+/* The application event task, shallower than both */
+PRIVATE void vAppEvents ( void )
+{
+    APP_vStackWatermarkEnter ( STACK_WATERMARK_KIND_TASK, STACK_WATERMARK_TASK_APP_EVENTS );
+    vUseShallow ( );
+    APP_vStackWatermarkExit ( );
+}
+
+/* Use outside any task, found by the sweep that follows */
+PRIVATE void vUntracked ( void )
+{
+    vUseDeepest ( );
+    vIdle ( );
+}
+
+PRIVATE void vReport ( uint8    u8Options,
+                       tsTestReport*    psReport )
+{
+    tsHostSerialFrame    sFrame;
+    uint8                au8Command[2];
+
+    memset ( psReport, 0, sizeof ( tsTestReport ) );
+    au8Command[0] =  STACK_WATERMARK_OP_REPORT;
+    au8Command[1] =  u8Options;
+    HOST_vSerialFlush ( );
+    APP_vStackWatermarkCommand ( au8Command, sizeof ( au8Command ) );
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_STACK_WATERMARK_RESPONSE, &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[0], STACK_WATERMARK_OP_REPORT );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[1], STACK_WATERMARK_STATUS_OK );
+    /* Then the link quality byte the serial link appends */
+    HOST_CHECK_EQUAL ( sFrame.u16Length, TEST_REPORT_HANDLERS + sFrame.au8Payload[TEST_REPORT_COUNT] * 7 + 1 );
+
+    psReport->u16Size         =  u16Read16 ( &sFrame.au8Payload[TEST_REPORT_SIZE] );
+    psReport->u16Peak         =  u16Read16 ( &sFrame.au8Payload[TEST_REPORT_PEAK] );
+    psReport->u8PeakKind      =  sFrame.au8Payload[TEST_REPORT_PEAK_KIND];
+    psReport->u16PeakId       =  u16Read16 ( &sFrame.au8Payload[TEST_REPORT_PEAK_ID] );
+    psReport->u16Depth        =  u16Read16 ( &sFrame.au8Payload[TEST_REPORT_DEPTH] );
+    psReport->u16Sweeps       =  u16Read16 ( &sFrame.au8Payload[TEST_REPORT_SWEEPS] );
+    psReport->u16Repaints     =  u16Read16 ( &sFrame.au8Payload[TEST_REPORT_REPAINTS] );
+    psReport->u16Unattributed =  u16Read16 ( &sFrame.au8Payload[TEST_REPORT_UNATTRIBUTED] );
+    psReport->u8Overflow      =  sFrame.au8Payload[TEST_REPORT_OVERFLOW];
+    psReport->u8Count         =  sFrame.au8Payload[TEST_REPORT_COUNT];
+    memcpy ( psReport->au8Handlers, &sFrame.au8Payload[TEST_REPORT_HANDLERS], psReport->u8Count * 7 );
+}
+
+/* Finds a task or handler in a report, returning its peak and marks */
+PRIVATE bool_t bHandler ( tsTestReport*    psReport,
+                          uint8     u8Kind,
+                          uint16    u16Id,
+                          uint16*   pu16Peak,
+                          uint16*   pu16Marks )
+{
+    uint8*    pu8Entry;
+    uint8     i;
+
+    for ( i = 0; i < psReport->u8Count; i++ )
+    {
+        pu8Entry =  &psReport->au8Handlers[i * 7];
+        if ( ( pu8Entry[0] == u8Kind ) && ( u16Read16 ( &pu8Entry[1] ) == u16Id ) )
+        {
+            *pu16Peak  =  u16Read16 ( &pu8Entry[3] );
+            *pu16Marks =  u16Read16 ( &pu8Entry[5] );
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* The peak reported for a buffer reaches its lowest byte and not far past */
+PRIVATE bool_t bNear ( uint16    u16Peak,
+                       uint16    u16Used )
+{
+    return ( u16Peak >= u16Used ) && ( u16Peak < u16Used + TEST_DEPTH_SLACK );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* Painting covers the stack, and nothing is measured until it has */
+PRIVATE void vTestPaint ( void )
+{
+    tsTestReport    sReport;
+
+    HOST_vInit ( );
+    APP_vStackWatermarkInit ( );
+
+    vOnStack ( vCommand );
+    vReport ( 0, &sReport );
+    HOST_CHECK_EQUAL ( sReport.u16Size, sizeof ( au32HostStack ) );
+    HOST_CHECK_EQUAL ( sReport.u16Repaints, 0 );
+    HOST_CHECK_EQUAL ( sReport.u16Peak, 0 );
+    HOST_CHECK_EQUAL ( sReport.u8PeakKind, STACK_WATERMARK_KIND_NONE );
+    HOST_CHECK_EQUAL ( sReport.u8Count, 0 );
+
+    /* Nothing is painted from a frame off the measured stack */
+    vIdle ( );
+    vReport ( 0, &sReport );
+    HOST_CHECK_EQUAL ( sReport.u16Repaints, 0 );
+    HOST_CHECK ( au32HostStack[0] != STACK_WATERMARK_PATTERN );
+
+    vOnStack ( vIdle );
+    vReport ( 0, &sReport );
+    HOST_CHECK_EQUAL ( sReport.u16Repaints, 1 );
+    HOST_CHECK ( sReport.u16Sweeps > 0 );
+    HOST_CHECK_EQUAL ( sReport.u16Unattributed, 0 );
+    HOST_CHECK_EQUAL ( sReport.u16Peak, 0 );
+    HOST_CHECK_EQUAL ( sReport.u8Overflow, FALSE );
+    HOST_CHECK ( au32HostStack[0] == STACK_WATERMARK_PATTERN );
+}
+
+/* A new mark goes to the innermost handler, and to the task around it */
+PRIVATE void vTestAttribution ( void )
+{
+    tsTestReport    sReport;
+    uint16          u16Command;
+    uint16          u16StackEvent;
+    uint16          u16Peak;
+    uint16          u16Marks;
+
+    vOnStack ( vCommand );
+    u16Command =  u16TestUsed;
+    vReport ( 0, &sReport );
+    HOST_CHECK ( bNear ( sReport.u16Peak, u16Command ) );
+    HOST_CHECK_EQUAL ( sReport.u16Depth, sReport.u16Peak );
+    HOST_CHECK_EQUAL ( sReport.u8PeakKind, STACK_WATERMARK_KIND_COMMAND );
+    HOST_CHECK_EQUAL ( sReport.u16PeakId, TEST_COMMAND_ID );
+    HOST_CHECK_EQUAL ( sReport.u8Count, 2 );
+    HOST_CHECK ( bHandler ( &sReport, STACK_WATERMARK_KIND_COMMAND, TEST_COMMAND_ID, &u16Peak, &u16Marks ) );
+    HOST_CHECK_EQUAL ( u16Peak, sReport.u16Peak );
+    HOST_CHECK_EQUAL ( u16Marks, 1 );
+    HOST_CHECK ( bHandler ( &sReport, STACK_WATERMARK_KIND_TASK, STACK_WATERMARK_TASK_SERIAL, &u16Peak, &u16Marks ) );
+    HOST_CHECK_EQUAL ( u16Peak, sReport.u16Peak );
+    HOST_CHECK_EQUAL ( u16Marks, 1 );
+
+    /* The same depth again sets no new mark */
+    vOnStack ( vCommand );
+    vReport ( 0, &sReport );
+    HOST_CHECK ( bHandler ( &sReport, STACK_WATERMARK_KIND_COMMAND, TEST_COMMAND_ID, &u16Peak, &u16Marks ) );
+    HOST_CHECK_EQUAL ( u16Marks, 1 );
+
+    /* Deeper, under another task, takes the peak and leaves the command's */
+    vOnStack ( vStackEvent );
+    u16StackEvent =  u16TestUsed;
+    HOST_CHECK ( u16StackEvent > u16Command );
+    vReport ( 0, &sReport );
+    HOST_CHECK ( bNear ( sReport.u16Peak, u16StackEvent ) );
+    HOST_CHECK_EQUAL ( sReport.u8PeakKind, STACK_WATERMARK_KIND_STACK_EVENT );
+    HOST_CHECK_EQUAL ( sReport.u16PeakId, TEST_STACK_EVENT_ID );
+    HOST_CHECK_EQUAL ( sReport.u8Count, 4 );
+    HOST_CHECK ( bHandler ( &sReport, STACK_WATERMARK_KIND_TASK, STACK_WATERMARK_TASK_ZPS, &u16Peak, &u16Marks ) );
+    HOST_CHECK_EQUAL ( u16Peak, sReport.u16Peak );
+    HOST_CHECK ( bHandler ( &sReport, STACK_WATERMARK_KIND_COMMAND, TEST_COMMAND_ID, &u16Peak, &u16Marks ) );
+    HOST_CHECK ( bNear ( u16Peak, u16Command ) );
+    HOST_CHECK ( u16Peak < sReport.u16Peak );
+
+    /* Shallower than the mark, the application event task goes unmeasured */
+    vOnStack ( vAppEvents );
+    vReport ( 0, &sReport );
+    HOST_CHECK_EQUAL ( sReport.u8Count, 4 );
+    HOST_CHECK ( !bHandler ( &sReport, STACK_WATERMARK_KIND_TASK, STACK_WATERMARK_TASK_APP_EVENTS, &u16Peak, &u16Marks ) );
+    HOST_CHECK_EQUAL ( sReport.u16Unattributed, 0 );
+}
+
+/* Use outside any task is found by the sweep and attributed to none */
+PRIVATE void vTestSweep ( void )
+{
+    tsTestReport    sReport;
+    uint16          u16Peak;
+    uint16          u16Marks;
+
+    vOnStack ( vUntracked );
+    vReport ( 0, &sReport );
+    HOST_CHECK_EQUAL ( sReport.u16Unattributed, 1 );
+    HOST_CHECK ( bNear ( sReport.u16Peak, u16TestUsed ) );
+    HOST_CHECK_EQUAL ( sReport.u16Depth, sReport.u16Peak );
+    HOST_CHECK_EQUAL ( sReport.u8PeakKind, STACK_WATERMARK_KIND_NONE );
+    HOST_CHECK_EQUAL ( sReport.u16PeakId, 0 );
+    HOST_CHECK_EQUAL ( sReport.u8Count, 4 );
+    HOST_CHECK_EQUAL ( sReport.u8Overflow, FALSE );
+
+    /* Nothing below the new mark, the stack event sets none */
+    vOnStack ( vStackEvent );
+    vReport ( 0, &sReport );
+    HOST_CHECK ( bHandler ( &sReport, STACK_WATERMARK_KIND_STACK_EVENT, TEST_STACK_EVENT_ID, &u16Peak, &u16Marks ) );
+    HOST_CHECK_EQUAL ( u16Marks, 1 );
+}
+
+/* After a repaint a handler shallower than the peak is measured */
+PRIVATE void vTestRepaint ( void )
+{
+    tsTestReport         sReport;
+    tsHostSerialFrame    sFrame;
+    uint8                u8Operation =  STACK_WATERMARK_OP_REPAINT;
+    uint16               u16Peak;
+    uint16               u16Marks;
+    uint16               u16Deepest;
+
+    vReport ( 0, &sReport );
+    u16Deepest =  sReport.u16Peak;
+
+    HOST_vSerialFlush ( );
+    APP_vStackWatermarkCommand ( &u8Operation, 1 );
+    HOST_CHECK ( HOST_bSerialFind ( E_SL_MSG_STACK_WATERMARK_RESPONSE, &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[0], STACK_WATERMARK_OP_REPAINT );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[1], STACK_WATERMARK_STATUS_OK );
+
+    vOnStack ( vIdle );
+    vOnStack ( vAppEvents );
+    vReport ( 0, &sReport );
+    HOST_CHECK_EQUAL ( sReport.u16Repaints, 2 );
+    HOST_CHECK_EQUAL ( sReport.u16Peak, u16Deepest );
+    HOST_CHECK_EQUAL ( sReport.u8PeakKind, STACK_WATERMARK_KIND_NONE );
+    HOST_CHECK ( bNear ( sReport.u16Depth, u16TestUsed ) );
+    HOST_CHECK_EQUAL ( sReport.u8Count, 5 );
+    HOST_CHECK ( bHandler ( &sReport, STACK_WATERMARK_KIND_TASK, STACK_WATERMARK_TASK_APP_EVENTS, &u16Peak, &u16Marks ) );
+    HOST_CHECK ( bNear ( u16Peak, u16TestUsed ) );
+    HOST_CHECK_EQUAL ( u16Marks, 1 );
+
+    /* The reset option clears the peaks once reported */
+    vReport ( STACK_WATERMARK_OPTION_RESET, &sReport );
+    HOST_CHECK_EQUAL ( sReport.u8Count, 5 );
+    vReport ( 0, &sReport );
+    HOST_CHECK_EQUAL ( sReport.u8Count, 0 );
+    HOST_CHECK_EQUAL ( sReport.u16Peak, 0 );
+    HOST_CHECK_EQUAL ( sReport.u8PeakKind, STACK_WATERMARK_KIND_NONE );
+    HOST_CHECK_EQUAL ( sReport.u16Depth, 0 );
+}
+
+/****************************************************************************/
+/***        Main                                                          ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vTestPaint );
+    HOST_TEST ( vTestAttribution );
+    HOST_TEST ( vTestSweep );
+    HOST_TEST ( vTestRepaint );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -0,0 +1,340 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_staged_boot.c
+ *
+ * DESCRIPTION:        Boot with full ZLL and Green Power tables, restoring
+ *                     them before E_SL_MSG_PDM_LOADED as without STAGED_BOOT
+ *                     and after it as with STAGED_BOOT, timing the first
+ *                     frame and counting the PDM bytes read before it.
+ *                     app_staged_boot.c and app_green_power.c are compiled
+ *                     into this test with both tables enabled; the GP
+ *                     cluster calls are stubbed below.
+ ****************************************************************************
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include <time.h>
+#include "gp.h"
+#include "PDM.h"
+#include "SerialLink.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/* Not provided by the application for the combo variant */
+PUBLIC uint8 app_u8GetDeviceEndpoint ( void );
+tsGP_GpToZclCommandInfo    asGpToZclLevelControlCmdInfo[] =
+{
+    { E_GP_ZGP_LEVEL_CONTROL_SWITCH, E_GP_OFF,    0x00, 1, 0x0006, 0x00, { 0 } },
+    { E_GP_ZGP_LEVEL_CONTROL_SWITCH, E_GP_ON,     0x01, 1, 0x0006, 0x00, { 0 } },
+    { E_GP_ZGP_LEVEL_CONTROL_SWITCH, E_GP_TOGGLE, 0x02, 1, 0x0006, 0x00, { 0 } },
+};
+
+#include "app_green_power.c"
+#include "app_staged_boot.c"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TEST_SRC_ID                     0x01020300
+#define TEST_BOOTS                      2000
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+    uint64    u64FirstFrameNs;
+    uint64    u64RestoredNs;
+    uint32    u32FirstFrameBytes;
+    uint32    u32RestoredBytes;
+} tsBootCost;
+
+/****************************************************************************/
+/***        Exported Variables                                            ***/
+/****************************************************************************/
+/* Defined by app_zcl_event_handler.c in full function device builds */
+PUBLIC tsZllEndpointInfoTable    sEndpointTable;
+PUBLIC tsZllGroupInfoTable       sGroupTable;
+
+/****************************************************************************/
+/***        Exported Functions                                            ***/
+/****************************************************************************/
+
+PUBLIC uint8 app_u8GetDeviceEndpoint ( void )
+{
+    return 1;
+}
+
+PUBLIC teZCL_Status eGP_RegisterComboBasicEndPoint ( uint8                          u8EndPointIdentifier,
+                                                     tfpZCL_ZCLCallBackFunction     cbCallBack,
+                                                     tsGP_GreenPowerDevice*         psDeviceInfo,
+                                                     uint16                         u16ProfileId,
+                                                     tsGP_TranslationTableEntry*    psTranslationTableEntry )
+{
+    return E_ZCL_SUCCESS;
+}
+
+PUBLIC void vGP_RestorePersistedData ( tsGP_ZgppProxySinkTable*     psZgpsProxySinkTable,
+                                       teGP_ResetToDefaultConfig    eSetToDefault )
+{
+}
+
+PUBLIC teZCL_Status eGP_ProxyCommissioningMode ( uint8                                 u8SourceEndPointId,
+                                                 uint8                                 u8DestEndPointId,
+                                                 tsZCL_Address                         sDestinationAddress,
+                                                 teGP_GreenPowerProxyCommissionMode    eGreenPowerProxyCommissionMode )
+{
+    return E_ZCL_SUCCESS;
+}
+
+PUBLIC bool_t bGP_CheckGPDAddressMatch ( uint8                  u8GPTableAppIdSrc,
+                                         uint8                  u8AppIdDst,
+                                         tuGP_ZgpdDeviceAddr*   sGPTableAddrSrc,
+                                         tuGP_ZgpdDeviceAddr*   sAddrDst )
+{
+    return ( u8GPTableAppIdSrc == u8AppIdDst ) &&
+           ( sGPTableAddrSrc->u32ZgpdSrcId == sAddrDst->u32ZgpdSrcId );
+}
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+PRIVATE uint64 u64Ns ( void )
+{
+    struct timespec    sNow;
+
+    clock_gettime ( CLOCK_MONOTONIC, &sNow );
+    return ( ( uint64 ) sNow.tv_sec * 1000000000ULL ) + ( uint64 ) sNow.tv_nsec;
+}
+
+PRIVATE void vGpEvent ( teGP_GreenPowerCallBackEventType    eEvent,
+                        void*                               pvMessage )
+{
+    tsGP_GreenPowerCallBackMessage    sMessage;
+
+    memset ( &sMessage, 0, sizeof ( sMessage ) );
+    sMessage.eEventType                     =  eEvent;
+    sMessage.uMessage.psZgpsProxySinkTable  =  pvMessage;
+    vHandleGreenPowerEvent ( &sMessage );
+}
+
+/* The RAM copies of every table as they are before the restore */
+PRIVATE void vClearTables ( void )
+{
+    memset ( &sEndpointTable, 0, sizeof ( sEndpointTable ) );
+    memset ( &sGroupTable, 0, sizeof ( sGroupTable ) );
+    memset ( &sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable, 0,
+             sizeof ( sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable ) );
+    memset ( &sGP_PDM_Data, 0, sizeof ( sGP_PDM_Data ) );
+    vApp_GPTransIndexRebuild ( );
+    bGpPdmLoaded =  FALSE;
+}
+
+/* Every ZLL endpoint and group record and every GP entry in use, saved */
+PRIVATE void vFillTables ( void )
+{
+    tsGP_ZgpCommissionIndication    sIndication;
+    tsGP_ZgppProxySinkTable*        psEntry;
+    uint8                           i;
+
+    PDM_vDeleteAllDataRecords ( );
+    vAPP_GP_ResetData ( );
+
+    sZllState.eNodeState =  E_RUNNING;
+    PDM_eSaveRecordData ( PDM_ID_APP_ZLL_CMSSION, &sZllState, sizeof ( sZllState ) );
+
+    sEndpointTable.u8NumRecords =  NUM_ENDPOINT_RECORDS;
+    for ( i = 0; i < NUM_ENDPOINT_RECORDS; i++ )
+    {
+        sEndpointTable.asEndpointRecords[i].u16NwkAddr    =  0x1000 + i;
+        sEndpointTable.asEndpointRecords[i].u16ProfileId  =  0xC05E;
+        sEndpointTable.asEndpointRecords[i].u16DeviceId   =  0x0100 + i;
+        sEndpointTable.asEndpointRecords[i].u8Endpoint    =  11;
+    }
+    sGroupTable.u8NumRecords =  NUM_GROUP_RECORDS;
+    for ( i = 0; i < NUM_GROUP_RECORDS; i++ )
+    {
+        sGroupTable.asGroupRecords[i].u16GroupId  =  0x4000 + i;
+    }
+    PDM_eSaveRecordData ( PDM_ID_APP_END_P_TABLE, &sEndpointTable, sizeof ( sEndpointTable ) );
+    PDM_eSaveRecordData ( PDM_ID_APP_GROUP_TABLE, &sGroupTable, sizeof ( sGroupTable ) );
+
+    for ( i = 0; i < GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES; i++ )
+    {
+        psEntry =  &sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[i];
+        psEntry->bProxyTableEntryOccupied     =  TRUE;
+        psEntry->uZgpdDeviceAddr.u32ZgpdSrcId =  TEST_SRC_ID + i;
+    }
+    for ( i = 0; i < GP_NUMBER_OF_TRANSLATION_TABLE_ENTRIES; i++ )
+    {
+        memset ( &sIndication, 0, sizeof ( sIndication ) );
+        sIndication.uZgpdDeviceAddr.u32ZgpdSrcId =  TEST_SRC_ID + i;
+        vGpEvent ( E_GP_COMMISSION_DATA_INDICATION, &sIndication );
+        HOST_CHECK_EQUAL ( sIndication.eStatus, E_ZCL_SUCCESS );
+    }
+    vGpEvent ( E_GP_PERSIST_SINK_PROXY_TABLE, NULL );
+}
+
+/* The part of vInitialiseApp from the first application record to the
+ * first frame, then the main loop passes the staged restore takes */
+PRIVATE void vBoot ( bool_t         bStaged,
+                     tsBootCost*    psCost )
+{
+    uint8     au8Values[1] =  { 0 };
+    uint16    u16DataBytesRead;
+    uint64    u64Start;
+
+    vClearTables ( );
+    PDM_eInitialise ( PDM_START_SEGMENT, PDM_NUM_SEGMENTS, NULL );
+    HOST_vSerialFlush ( );
+
+    u64Start =  u64Ns ( );
+    PDM_eReadDataFromRecord ( PDM_ID_APP_ZLL_CMSSION,
+                              &sZllState,
+                              sizeof ( tsZllState ),
+                              &u16DataBytesRead );
+    if ( !bStaged )
+    {
+        APP_vBootRestoreTables ( );
+    }
+    vSL_WriteMessage ( E_SL_MSG_PDM_LOADED, 1, au8Values, 0 );
+    psCost->u64FirstFrameNs    +=  u64Ns ( ) - u64Start;
+    psCost->u32FirstFrameBytes  =  HOST_u32PdmReadBytes ( );
+
+    if ( bStaged )
+    {
+        APP_vStagedBootInit ( );
+        while ( APP_bStagedBootRestore ( ) );
+    }
+    psCost->u64RestoredNs    +=  u64Ns ( ) - u64Start;
+    psCost->u32RestoredBytes  =  HOST_u32PdmReadBytes ( );
+}
+
+PRIVATE bool_t bTablesRestored ( void )
+{
+    uint8    i;
+
+    if ( ( sEndpointTable.u8NumRecords != NUM_ENDPOINT_RECORDS ) ||
+         ( sEndpointTable.asEndpointRecords[NUM_ENDPOINT_RECORDS - 1].u16NwkAddr != 0x1000 + NUM_ENDPOINT_RECORDS - 1 ) ||
+         ( sGroupTable.u8NumRecords != NUM_GROUP_RECORDS ) ||
+         ( sGroupTable.asGroupRecords[NUM_GROUP_RECORDS - 1].u16GroupId != 0x4000 + NUM_GROUP_RECORDS - 1 ) ||
+         !bGpPdmLoaded )
+    {
+        return FALSE;
+    }
+    for ( i = 0; i < GP_NUMBER_OF_PROXY_SINK_TABLE_ENTRIES; i++ )
+    {
+        if ( sGPDeviceInfo.sGreenPowerCustomDataStruct.asZgpsSinkProxyTable[i].uZgpdDeviceAddr.u32ZgpdSrcId != ( uint32 ) ( TEST_SRC_ID + i ) )
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* Both ways restore the same tables; staged, E_SL_MSG_PDM_LOADED goes out
+ * before them and E_SL_MSG_BOOT_TIMING after */
+PRIVATE void vStagedRestoresAfterFirstFrame ( void )
+{
+    tsBootCost           sUnstaged;
+    tsBootCost           sStaged;
+    tsHostSerialFrame    sFrame;
+
+    memset ( &sUnstaged, 0, sizeof ( sUnstaged ) );
+    memset ( &sStaged, 0, sizeof ( sStaged ) );
+    vFillTables ( );
+
+    vBoot ( FALSE, &sUnstaged );
+    HOST_CHECK ( bTablesRestored ( ) );
+    HOST_CHECK ( HOST_bSerialRead ( &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.u16Type, E_SL_MSG_PDM_LOADED );
+
+    vBoot ( TRUE, &sStaged );
+    HOST_CHECK ( bTablesRestored ( ) );
+    HOST_CHECK ( HOST_bSerialRead ( &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.u16Type, E_SL_MSG_PDM_LOADED );
+    HOST_CHECK ( HOST_bSerialRead ( &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.u16Type, E_SL_MSG_BOOT_TIMING );
+    HOST_CHECK ( !APP_bStagedBootRestore ( ) );
+
+    /* Only the ZLL state is read before the first frame */
+    HOST_CHECK_EQUAL ( sStaged.u32FirstFrameBytes, sizeof ( tsZllState ) );
+    HOST_CHECK ( sUnstaged.u32FirstFrameBytes > sStaged.u32FirstFrameBytes );
+    HOST_CHECK_EQUAL ( sStaged.u32RestoredBytes, sUnstaged.u32RestoredBytes );
+}
+
+PRIVATE void vFirstFrameTiming ( void )
+{
+    tsBootCost    sUnstaged;
+    tsBootCost    sStaged;
+    uint32        i;
+
+    memset ( &sUnstaged, 0, sizeof ( sUnstaged ) );
+    memset ( &sStaged, 0, sizeof ( sStaged ) );
+    vFillTables ( );
+    for ( i = 0; i < TEST_BOOTS; i++ )
+    {
+        vBoot ( FALSE, &sUnstaged );
+        vBoot ( TRUE, &sStaged );
+    }
+    HOST_CHECK ( bTablesRestored ( ) );
+
+    printf ( "  unstaged: first frame after %5u ns, %4u PDM bytes read before it, tables restored after %5u ns\n",
+             ( unsigned ) ( sUnstaged.u64FirstFrameNs / TEST_BOOTS ),
+             ( unsigned ) sUnstaged.u32FirstFrameBytes,
+             ( unsigned ) ( sUnstaged.u64RestoredNs / TEST_BOOTS ) );
+    printf ( "  staged:   first frame after %5u ns, %4u PDM bytes read before it, tables restored after %5u ns\n",
+             ( unsigned ) ( sStaged.u64FirstFrameNs / TEST_BOOTS ),
+             ( unsigned ) sStaged.u32FirstFrameBytes,
+             ( unsigned ) ( sStaged.u64RestoredNs / TEST_BOOTS ) );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_vInit ( );
+    HOST_TEST ( vStagedRestoresAfterFirstFrame );
+    HOST_TEST ( vFirstFrameTiming );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
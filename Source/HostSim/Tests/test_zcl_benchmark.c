@@ -0,0 +1,216 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_zcl_benchmark.c
+ *
+ * DESCRIPTION:        ZCL serialisation benchmark run on the host: every
+ *                     ZCL type ZCIF encodes written and read back through
+ *                     the PDU buffer, forwarded as a report is and encoded
+ *                     again from the host bytes, each matching what ZCIF
+ *                     wrote. CYCCNT runs from the host clock, so every
+ *                     path counts cycles; their values are left to the
+ *                     zcl_benchmark baseline.
+ *
+ ****************************************************************************
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zcl.h"
+#include "SerialLink.h"
+#include "clock_config.h"
+#include "app_zcl_benchmark.h"
+#include "host_sim.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Types in the benchmark table, every one ZCIF encodes */
+#define TEST_TYPES                      50
+
+/* Offsets into the E_SL_MSG_ZCL_BENCHMARK_RESULT payload */
+#define TEST_RESULT_STATUS              0
+#define TEST_RESULT_ITERATIONS          1
+#define TEST_RESULT_CLOCK               3
+#define TEST_RESULT_HEADER_WRITE        7
+#define TEST_RESULT_HEADER_READ         11
+#define TEST_RESULT_TYPES               15
+#define TEST_RESULT_RECORDS             16
+
+/* Offsets into each per type record, and the record size */
+#define TEST_RECORD_TYPE                0
+#define TEST_RECORD_BYTES               1
+#define TEST_RECORD_CYCLES              2
+#define TEST_RECORD_PATHS               4
+#define TEST_RECORD_SIZE                18
+
+/* Attribute identifier and type ahead of each value */
+#define TEST_RECORD_HEADER              3
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* Runs the benchmark as the host asks for it, and returns its result */
+PRIVATE bool_t bRunBenchmark ( uint16                u16Iterations,
+                               tsHostSerialFrame*    psFrame )
+{
+    uint8    au8Payload[2];
+
+    HOST_vInit ( );
+    HOST_vRun ( 10 );
+    HOST_vSerialFlush ( );
+
+    au8Payload[0] =  ( uint8 ) ( u16Iterations >> 8 );
+    au8Payload[1] =  ( uint8 ) u16Iterations;
+    HOST_vSerialWrite ( E_SL_MSG_ZCL_BENCHMARK, sizeof ( au8Payload ), au8Payload );
+    HOST_vRun ( 100 );
+    return HOST_bSerialFind ( E_SL_MSG_ZCL_BENCHMARK_RESULT, psFrame );
+}
+
+/* Big endian count in the result payload */
+PRIVATE uint32 u32Cycles ( tsHostSerialFrame*    psFrame,
+                           uint16                u16Offset )
+{
+    return ( ( uint32 ) psFrame->au8Payload[u16Offset] << 24 ) |
+           ( ( uint32 ) psFrame->au8Payload[u16Offset + 1] << 16 ) |
+           ( ( uint32 ) psFrame->au8Payload[u16Offset + 2] << 8 ) |
+           psFrame->au8Payload[u16Offset + 3];
+}
+
+/* Encoded record bytes the benchmark reports for a ZCL type */
+PRIVATE uint8 u8RecordBytes ( tsHostSerialFrame*        psFrame,
+                              teZCL_ZCLAttributeType    eType )
+{
+    uint16    u16Offset;
+
+    for ( u16Offset = TEST_RESULT_RECORDS;
+          ( u16Offset + TEST_RECORD_SIZE ) <= ( psFrame->u16Length - 1 );
+          u16Offset += TEST_RECORD_SIZE )
+    {
+        if ( psFrame->au8Payload[u16Offset + TEST_RECORD_TYPE] == eType )
+        {
+            return psFrame->au8Payload[u16Offset + TEST_RECORD_BYTES];
+        }
+    }
+    return 0;
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* Every type reads back as written and encodes back from the host bytes */
+PRIVATE void vEveryTypeRoundTrips ( void )
+{
+    tsHostSerialFrame    sFrame;
+
+    HOST_CHECK ( bRunBenchmark ( 1, &sFrame ) );
+    HOST_CHECK ( sFrame.bCrcOk );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_RESULT_STATUS], ZCL_BENCHMARK_STATUS_OK );
+    HOST_CHECK_EQUAL ( ( sFrame.au8Payload[TEST_RESULT_ITERATIONS] << 8 ) | sFrame.au8Payload[TEST_RESULT_ITERATIONS + 1], 1 );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_RESULT_TYPES], TEST_TYPES );
+    HOST_CHECK_EQUAL ( sFrame.u16Length, TEST_RESULT_RECORDS + TEST_TYPES * TEST_RECORD_SIZE + 1 );
+}
+
+/* The fixed sizes in between the power of two ones, and the variable
+ * length types with their length prefix */
+PRIVATE void vRecordSizes ( void )
+{
+    tsHostSerialFrame    sFrame;
+
+    HOST_CHECK ( bRunBenchmark ( 1, &sFrame ) );
+    HOST_CHECK_EQUAL ( u8RecordBytes ( &sFrame, E_ZCL_UINT24 ),   TEST_RECORD_HEADER + 3 );
+    HOST_CHECK_EQUAL ( u8RecordBytes ( &sFrame, E_ZCL_INT40 ),    TEST_RECORD_HEADER + 5 );
+    HOST_CHECK_EQUAL ( u8RecordBytes ( &sFrame, E_ZCL_BMAP48 ),   TEST_RECORD_HEADER + 6 );
+    HOST_CHECK_EQUAL ( u8RecordBytes ( &sFrame, E_ZCL_UINT56 ),   TEST_RECORD_HEADER + 7 );
+    HOST_CHECK_EQUAL ( u8RecordBytes ( &sFrame, E_ZCL_KEY_128 ),  TEST_RECORD_HEADER + 16 );
+    HOST_CHECK_EQUAL ( u8RecordBytes ( &sFrame, E_ZCL_CSTRING ),  TEST_RECORD_HEADER + 1 + ZCL_BENCHMARK_STRING_LENGTH );
+    HOST_CHECK_EQUAL ( u8RecordBytes ( &sFrame, E_ZCL_LOSTRING ), TEST_RECORD_HEADER + 2 + ZCL_BENCHMARK_STRING_LENGTH );
+    HOST_CHECK_EQUAL ( u8RecordBytes ( &sFrame, E_ZCL_ARRAY ),    TEST_RECORD_HEADER + 3 + 2 * ZCL_BENCHMARK_ARRAY_ELEMENTS );
+}
+
+/* No iteration count selects the default, and the core clock is reported */
+PRIVATE void vDefaultIterations ( void )
+{
+    tsHostSerialFrame    sFrame;
+
+    HOST_CHECK ( bRunBenchmark ( 0, &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_RESULT_STATUS], ZCL_BENCHMARK_STATUS_OK );
+    HOST_CHECK_EQUAL ( ( sFrame.au8Payload[TEST_RESULT_ITERATIONS] << 8 ) | sFrame.au8Payload[TEST_RESULT_ITERATIONS + 1],
+                       ZCL_BENCHMARK_DEFAULT_ITERATIONS );
+    HOST_CHECK_EQUAL ( ( ( uint32 ) sFrame.au8Payload[TEST_RESULT_CLOCK] << 24 ) |
+                       ( ( uint32 ) sFrame.au8Payload[TEST_RESULT_CLOCK + 1] << 16 ) |
+                       ( ( uint32 ) sFrame.au8Payload[TEST_RESULT_CLOCK + 2] << 8 ) |
+                       sFrame.au8Payload[TEST_RESULT_CLOCK + 3],
+                       BOARD_BOOTCLOCKRUN_CORE_CLOCK );
+}
+
+/* The header and every path of every type count cycles */
+PRIVATE void vCyclesCounted ( void )
+{
+    tsHostSerialFrame    sFrame;
+    uint16               u16Offset;
+    uint8                i;
+
+    HOST_CHECK ( bRunBenchmark ( ZCL_BENCHMARK_DEFAULT_ITERATIONS, &sFrame ) );
+    HOST_CHECK_EQUAL ( sFrame.au8Payload[TEST_RESULT_STATUS], ZCL_BENCHMARK_STATUS_OK );
+    HOST_CHECK ( u32Cycles ( &sFrame, TEST_RESULT_HEADER_WRITE ) > 0 );
+    HOST_CHECK ( u32Cycles ( &sFrame, TEST_RESULT_HEADER_READ ) > 0 );
+    for ( u16Offset = TEST_RESULT_RECORDS;
+          ( u16Offset + TEST_RECORD_SIZE ) <= ( sFrame.u16Length - 1 );
+          u16Offset += TEST_RECORD_SIZE )
+    {
+        for ( i = 0; i < TEST_RECORD_PATHS; i++ )
+        {
+            HOST_CHECK ( u32Cycles ( &sFrame, u16Offset + TEST_RECORD_CYCLES + 4 * i ) > 0 );
+        }
+    }
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vEveryTypeRoundTrips );
+    HOST_TEST ( vRecordSizes );
+    HOST_TEST ( vDefaultIterations );
+    HOST_TEST ( vCyclesCounted );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
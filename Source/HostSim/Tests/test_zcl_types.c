@@ -0,0 +1,224 @@
+/*****************************************************************************
+ *
+ * MODULE:             ZigBee Control Bridge Host Simulator
+ *
+ * COMPONENT:          test_zcl_types.c
+ *
+ * DESCRIPTION:        ZCL type table of the event handler: the bytes each
+ *                     type takes on the serial link, host values encoded
+ *                     as ZCL puts them on air, the 24 to 56 bit ones from
+ *                     their low bytes, and attribute values decoded by ZCIF
+ *                     written for the host most significant byte first.
+ *
+ ****************************************************************************
+ *
+ ****************************************************************************
+ *
+ * This software is owned by NXP B.V. and/or its supplier and is protected
+ * under applicable copyright laws. All rights are reserved. We grant You,
+ * and any third parties, a license to use this software solely and
+ * exclusively on NXP products [NXP Microcontrollers such as JN5168, JN5179].
+ * You, and any third parties must reproduce the copyright and warranty notice
+ * and any other legend of ownership on each copy or partial copy of the
+ * software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Copyright NXP B.V. 2016. All rights reserved
+ *
+ ***************************************************************************/
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <jendefs.h>
+#include <string.h>
+#include "zcl.h"
+#include "app_common.h"
+#include "host_test.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Not a ZCL type */
+#define TEST_UNKNOWN_TYPE               0x55
+
+/* Written past the encoded value, to find bytes written beyond it */
+#define TEST_GUARD                      0xA5
+
+/****************************************************************************/
+/***        Local Functions                                               ***/
+/****************************************************************************/
+
+/* Encodes host bytes and checks what goes on air, and that nothing is
+ * written after it */
+PRIVATE void vCheckWrite ( teZCL_ZCLAttributeType    eType,
+                           uint8*                    pu8Host,
+                           uint32                    u32HostSize,
+                           const uint8*              pu8Air,
+                           uint16                    u16AirSize )
+{
+    uint8    au8Data[32];
+
+    memset ( au8Data, TEST_GUARD, sizeof ( au8Data ) );
+    HOST_CHECK_EQUAL ( APP_u16ZncWriteDataPattern ( au8Data, eType, pu8Host, u32HostSize ), u16AirSize );
+    HOST_CHECK ( memcmp ( au8Data, pu8Air, u16AirSize ) == 0 );
+    HOST_CHECK_EQUAL ( au8Data[u16AirSize], TEST_GUARD );
+}
+
+/****************************************************************************/
+/***        Tests                                                         ***/
+/****************************************************************************/
+
+/* Sizes the serial link protocol has always used: 24 bit types as 32 bit,
+ * 56 bit types as 64 bit, and types not forwarded as none */
+PRIVATE void vHostSizes ( void )
+{
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_BOOL,         1 ), 1 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_UINT16,       3 ), 6 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_UINT24,       1 ), 4 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_INT24,        1 ), 4 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_UINT40,       1 ), 5 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_UINT48,       1 ), 6 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_UINT56,       1 ), 8 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_BMAP32,       1 ), 4 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_FLOAT_SINGLE, 1 ), 4 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_IEEE_ADDR,    1 ), 8 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_CSTRING,      7 ), 7 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_LOSTRING,     7 ), 14 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_STRUCT,       2 ), 4 );
+
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_GINT24,       1 ), 0 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_INT32,        1 ), 0 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( E_ZCL_KEY_128,      1 ), 0 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( TEST_UNKNOWN_TYPE,  1 ), 0 );
+    HOST_CHECK_EQUAL ( APP_u16GetAttributeActualSize ( 0x1000,             1 ), 0 );
+}
+
+/* Host values are most significant byte first; on air ZCL is least
+ * significant byte first, in the width of the type */
+PRIVATE void vPowerOfTwoEncoding ( void )
+{
+    uint8          au8U8[]          = { 0x7E };
+    uint8          au8U16[]         = { 0x12, 0x34 };
+    uint8          au8U32[]         = { 0x12, 0x34, 0x56, 0x78 };
+    uint8          au8U64[]         = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+    const uint8    au8U16Air[]      = { 0x34, 0x12 };
+    const uint8    au8U32Air[]      = { 0x78, 0x56, 0x34, 0x12 };
+    const uint8    au8U64Air[]      = { 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01 };
+
+    vCheckWrite ( E_ZCL_UINT8,       au8U8,  sizeof ( au8U8 ),  au8U8,     1 );
+    vCheckWrite ( E_ZCL_UINT16,      au8U16, sizeof ( au8U16 ), au8U16Air, 2 );
+    vCheckWrite ( E_ZCL_UINT32,      au8U32, sizeof ( au8U32 ), au8U32Air, 4 );
+    vCheckWrite ( E_ZCL_UINT64,      au8U64, sizeof ( au8U64 ), au8U64Air, 8 );
+    vCheckWrite ( E_ZCL_IEEE_ADDR,   au8U64, sizeof ( au8U64 ), au8U64Air, 8 );
+}
+
+/* 24 to 56 bit values take their low bytes: the top byte of a 24 bit value
+ * sent in 32 bits, and of a 56 bit value sent in 64 bits, is dropped */
+PRIVATE void vOddWidthEncoding ( void )
+{
+    uint8          au8U24[]         = { 0x00, 0x12, 0x34, 0x56 };
+    uint8          au8I24[]         = { 0xFF, 0xFE, 0xDC, 0xBA };
+    uint8          au8U40[]         = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+    uint8          au8U48[]         = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 };
+    uint8          au8U56[]         = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77 };
+    const uint8    au8U24Air[]      = { 0x56, 0x34, 0x12 };
+    const uint8    au8I24Air[]      = { 0xBA, 0xDC, 0xFE };
+    const uint8    au8U40Air[]      = { 0x05, 0x04, 0x03, 0x02, 0x01 };
+    const uint8    au8U48Air[]      = { 0x06, 0x05, 0x04, 0x03, 0x02, 0x01 };
+    const uint8    au8U56Air[]      = { 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11 };
+
+    vCheckWrite ( E_ZCL_UINT24, au8U24, sizeof ( au8U24 ), au8U24Air, 3 );
+    vCheckWrite ( E_ZCL_INT24,  au8I24, sizeof ( au8I24 ), au8I24Air, 3 );
+    vCheckWrite ( E_ZCL_UINT40, au8U40, sizeof ( au8U40 ), au8U40Air, 5 );
+    vCheckWrite ( E_ZCL_INT40,  au8U40, sizeof ( au8U40 ), au8U40Air, 5 );
+    vCheckWrite ( E_ZCL_UINT48, au8U48, sizeof ( au8U48 ), au8U48Air, 6 );
+    vCheckWrite ( E_ZCL_BMAP48, au8U48, sizeof ( au8U48 ), au8U48Air, 6 );
+    vCheckWrite ( E_ZCL_UINT56, au8U56, sizeof ( au8U56 ), au8U56Air, 7 );
+    vCheckWrite ( E_ZCL_INT56,  au8U56, sizeof ( au8U56 ), au8U56Air, 7 );
+}
+
+/* Strings keep their data as sent, the long ones with the length swapped;
+ * keys are copied; a string longer than the host bytes, or a type the
+ * bridge does not encode, writes nothing */
+PRIVATE void vOtherEncodings ( void )
+{
+    uint8          au8String[]      = { 0x07, 'l', 'u', 'm', 'i', '.', 's', '1' };
+    uint8          au8LongString[]  = { 0x00, 0x03, 'a', 'b', 'c' };
+    uint8          au8Key[16]       = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                        0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF };
+    const uint8    au8LongAir[]     = { 0x03, 0x00, 'a', 'b', 'c' };
+    uint8          au8Data[32];
+
+    vCheckWrite ( E_ZCL_CSTRING,  au8String,     sizeof ( au8String ),     au8String,  sizeof ( au8String ) );
+    vCheckWrite ( E_ZCL_OSTRING,  au8String,     sizeof ( au8String ),     au8String,  sizeof ( au8String ) );
+    vCheckWrite ( E_ZCL_LCSTRING, au8LongString, sizeof ( au8LongString ), au8LongAir, sizeof ( au8LongAir ) );
+    vCheckWrite ( E_ZCL_KEY_128,  au8Key,        sizeof ( au8Key ),        au8Key,     sizeof ( au8Key ) );
+
+    HOST_CHECK_EQUAL ( APP_u16ZncWriteDataPattern ( au8Data, E_ZCL_CSTRING,  au8String,     sizeof ( au8String ) - 1 ),     0 );
+    HOST_CHECK_EQUAL ( APP_u16ZncWriteDataPattern ( au8Data, E_ZCL_LOSTRING, au8LongString, sizeof ( au8LongString ) - 1 ), 0 );
+    HOST_CHECK_EQUAL ( APP_u16ZncWriteDataPattern ( au8Data, E_ZCL_LOSTRING, au8LongString, 1 ),                            0 );
+    HOST_CHECK_EQUAL ( APP_u16ZncWriteDataPattern ( au8Data, E_ZCL_STRUCT,   au8Key,        2 ),                            0 );
+    HOST_CHECK_EQUAL ( APP_u16ZncWriteDataPattern ( au8Data, TEST_UNKNOWN_TYPE, au8Key,     1 ),                            0 );
+}
+
+/* Values as ZCIF decodes them, in native words, go to the host most
+ * significant byte first in the host size of the type */
+PRIVATE void vReadForHost ( void )
+{
+    uint64               u64Value       =  0x0000000504030201ULL;
+    uint32               u32Value       =  0x00123456;
+    uint8                au8Text[]      =  { 'a', 'b', 'c' };
+    tsZCL_OctetString    sString;
+    const uint8          au8U40Host[]   =  { 0x05, 0x04, 0x03, 0x02, 0x01 };
+    const uint8          au8U24Host[]   =  { 0x00, 0x12, 0x34, 0x56 };
+    uint8                au8Data[32];
+
+    memset ( au8Data, TEST_GUARD, sizeof ( au8Data ) );
+    HOST_CHECK_EQUAL ( APP_u16ZncReadDataPattern ( au8Data, E_ZCL_UINT40, &u64Value, 1 ), 5 );
+    HOST_CHECK ( memcmp ( au8Data, au8U40Host, sizeof ( au8U40Host ) ) == 0 );
+    HOST_CHECK_EQUAL ( au8Data[5], TEST_GUARD );
+
+    memset ( au8Data, TEST_GUARD, sizeof ( au8Data ) );
+    HOST_CHECK_EQUAL ( APP_u16ZncReadDataPattern ( au8Data, E_ZCL_UINT24, &u32Value, 1 ), 4 );
+    HOST_CHECK ( memcmp ( au8Data, au8U24Host, sizeof ( au8U24Host ) ) == 0 );
+
+    sString.u8MaxLength =  sizeof ( au8Text );
+    sString.u8Length    =  sizeof ( au8Text );
+    sString.pu8Data     =  au8Text;
+    memset ( au8Data, TEST_GUARD, sizeof ( au8Data ) );
+    HOST_CHECK_EQUAL ( APP_u16ZncReadDataPattern ( au8Data, E_ZCL_CSTRING, &sString, sizeof ( au8Text ) ), 3 );
+    HOST_CHECK ( memcmp ( au8Data, au8Text, sizeof ( au8Text ) ) == 0 );
+    HOST_CHECK_EQUAL ( au8Data[3], TEST_GUARD );
+
+    HOST_CHECK_EQUAL ( APP_u16ZncReadDataPattern ( au8Data, E_ZCL_UINT8, NULL, 1 ), 0 );
+}
+
+/****************************************************************************/
+/***        Entry point                                                   ***/
+/****************************************************************************/
+
+int main ( void )
+{
+    HOST_TEST ( vHostSizes );
+    HOST_TEST ( vPowerOfTwoEncoding );
+    HOST_TEST ( vOddWidthEncoding );
+    HOST_TEST ( vOtherEncodings );
+    HOST_TEST ( vReadForHost );
+    HOST_TEST_END ( );
+}
+
+/****************************************************************************/
+/***        END OF FILE                                                   ***/
+/****************************************************************************/
@@ -557,8 +557,9 @@ typedef struct
 
 	#endif
 	#if (defined CLD_ANALOG_INPUT_BASIC) && (defined CLD_ANALOG_INPUT_BASIC_CLIENT)
-		/* Multistate Cluster - Client */
-		tsCLD_MultistateInputBasicClient sAnalogInputClientCluster;
+		/* Analog Input Cluster - Client, created with the server attribute
+		 * defaults that eCLD_AnalogInputBasicCreateAnalogInputBasic writes */
+		tsCLD_AnalogInputBasic sAnalogInputClientCluster;
 
 	#endif
 
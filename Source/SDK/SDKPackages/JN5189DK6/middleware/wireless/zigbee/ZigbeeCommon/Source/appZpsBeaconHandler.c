@@ -62,6 +62,9 @@ extern uint64 zps_u64NwkLibFromPayload(
 #ifdef APP_PROCESS_BEACON
     extern void vAPPBeaconHandler(MAC_MlmeDcfmInd_s* psBeaconIndication);
 #endif
+#ifdef APP_BEACON_FILTER_TABLES
+    extern bool_t APP_bBeaconFilterListed(tsBeaconFilterType *psFilter, uint64 u64ExtendedPanId, bool_t *pbListed);
+#endif
 tsBeaconFilterType *psBeaconFilter = NULL;
 /**************/
 /**** DATA ****/
@@ -199,27 +202,41 @@ PUBLIC bool_t ZPS_bAppPassBeaconToHigherLayer(MAC_MlmeDcfmInd_s* psBeaconIndicat
 
                 if(psBeaconFilter->u16FilterMap & (BF_BITMAP_BLACKLIST|BF_BITMAP_WHITELIST))
                 {
-                    for(u8Traverse=0; u8Traverse < psBeaconFilter->u8ListSize; u8Traverse++)
-                    {
-                        uint64 u64ExtendedPanId = zps_u64NwkLibFromPayload(BF_BCN_PL_EXT_PAN_ID_PTR(psBeaconIndication->uParam.sIndBeacon.u8SDU));
+                    uint64 u64ExtendedPanId = zps_u64NwkLibFromPayload(BF_BCN_PL_EXT_PAN_ID_PTR(psBeaconIndication->uParam.sIndBeacon.u8SDU));
+#ifdef APP_BEACON_FILTER_TABLES
+                    bool_t bListed;
 
-                        if((u64ExtendedPanId == psBeaconFilter->pu64ExtendPanIdList[u8Traverse])
-                           && psBeaconFilter->u16FilterMap & BF_BITMAP_BLACKLIST)
+                    /* One lookup in the table the application built for its filter */
+                    if(APP_bBeaconFilterListed(psBeaconFilter, u64ExtendedPanId, &bListed))
+                    {
+                        if(bListed == ((psBeaconFilter->u16FilterMap & BF_BITMAP_BLACKLIST) != 0))
                         {
-                            return FALSE;
+                            return FALSE; /* Blacklisted or not in Whitelist */
                         }
-
-                        if((u64ExtendedPanId == psBeaconFilter->pu64ExtendPanIdList[u8Traverse])
-                            && psBeaconFilter->u16FilterMap & BF_BITMAP_WHITELIST)
+                    }
+                    else
+#endif
+                    {
+                        for(u8Traverse=0; u8Traverse < psBeaconFilter->u8ListSize; u8Traverse++)
                         {
-                            break;
+                            if((u64ExtendedPanId == psBeaconFilter->pu64ExtendPanIdList[u8Traverse])
+                               && psBeaconFilter->u16FilterMap & BF_BITMAP_BLACKLIST)
+                            {
+                                return FALSE;
+                            }
+
+                            if((u64ExtendedPanId == psBeaconFilter->pu64ExtendPanIdList[u8Traverse])
+                                && psBeaconFilter->u16FilterMap & BF_BITMAP_WHITELIST)
+                            {
+                                break;
+                            }
                         }
-                    }
 
-                    if((psBeaconFilter->u16FilterMap & BF_BITMAP_WHITELIST) &&
-                    (u8Traverse == psBeaconFilter->u8ListSize))
-                    {
-                        return FALSE; /* Not in Whitelist */
+                        if((psBeaconFilter->u16FilterMap & BF_BITMAP_WHITELIST) &&
+                        (u8Traverse == psBeaconFilter->u8ListSize))
+                        {
+                            return FALSE; /* Not in Whitelist */
+                        }
                     }
                 }
 
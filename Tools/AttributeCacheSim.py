@@ -0,0 +1,240 @@
+#*****************************************************************************
+#*
+# * MODULE:             ZigBee Control Bridge
+# *
+# * COMPONENT:          AttributeCacheSim.py
+# *
+# * DESCRIPTION:        Host side model of app_attribute_cache.c behind a stub
+# *                     APS layer, counting the radio transactions a start-up
+# *                     interview by several host integrations costs with and
+# *                     without the cache. Source/HostSim/Tests/
+# *                     test_attribute_cache.c runs the same interview
+# *                     through app_attribute_cache.c itself.
+# *
+# *****************************************************************************
+import sys
+import random
+import optparse
+
+# Mirrors app_attribute_cache.h
+ATTRIBUTE_CACHE_MAX_ENTRIES = 64
+ATTRIBUTE_CACHE_MAX_RULES = 8
+ATTRIBUTE_CACHE_BASIC_TTL = 86400
+ATTRIBUTE_CACHE_ANY_CLUSTER = 0xFFFF
+ATTRIBUTE_CACHE_TICKS_PER_S = 10
+
+CLUSTER_BASIC = 0x0000
+CLUSTER_ONOFF = 0x0006
+CLUSTER_LEVEL = 0x0008
+
+# What each integration reads of every device when it starts: (cluster, [attributes]) per request
+INTERVIEW = [
+    (CLUSTER_BASIC, [0x0004, 0x0005]),      # manufacturer and model
+    (CLUSTER_BASIC, [0x0007]),              # power source
+    (CLUSTER_BASIC, [0x0001, 0x4000]),      # application version and software build
+    (CLUSTER_ONOFF, [0x0000]),
+    (CLUSTER_LEVEL, [0x0000]),
+]
+
+# Rule sets as (cluster, lifetime in seconds); the default is the one APP_vAttributeCacheInit sets
+RULES = {
+    "off"     : [],
+    "default" : [(CLUSTER_BASIC, ATTRIBUTE_CACHE_BASIC_TTL)],
+    "state"   : [(CLUSTER_BASIC, ATTRIBUTE_CACHE_BASIC_TTL), (CLUSTER_ONOFF, 5), (CLUSTER_LEVEL, 5)],
+}
+
+
+class cStubAps(object):
+    """Stands in for the APS layer and the devices behind it, counting every request sent over the air"""
+    def __init__(self):
+        self.nTransactions = 0
+
+    def Read(self, u16Addr, u8Endpoint, u16ClusterId, lAttributes):
+        self.nTransactions += 1
+        return [(u16AttributeId, "%04x:%04x:%04x" % (u16Addr, u16ClusterId, u16AttributeId))
+                for u16AttributeId in lAttributes]
+
+
+class cEntry(object):
+    def __init__(self):
+        self.u64IeeeAddr = 0
+        self.u8Endpoint = 0
+        self.u16ClusterId = 0
+        self.u16AttributeId = 0
+        self.sRecord = None
+        self.u32StoredAt = 0
+        self.u32LastUsed = 0
+        self.u32Ttl = 0
+
+
+class cAttributeCache(object):
+    """The cache of app_attribute_cache.c, in 100ms ticks as on the node"""
+    def __init__(self, lRules, nEntries):
+        self.lRules = list(lRules)[:ATTRIBUTE_CACHE_MAX_RULES]
+        self.lEntries = [cEntry() for _ in xrange(nEntries)]
+        self.u32Ticks = 0
+        self.dStats = dict.fromkeys(("hits", "misses", "stored", "expired", "evicted", "invalidated"), 0)
+
+    def Ttl(self, u16ClusterId):
+        u32Ttl = 0
+        for (u16RuleCluster, u32RuleTtl) in self.lRules:
+            if u16RuleCluster == u16ClusterId:
+                return u32RuleTtl
+            if u16RuleCluster == ATTRIBUTE_CACHE_ANY_CLUSTER:
+                u32Ttl = u32RuleTtl
+        return u32Ttl
+
+    def Find(self, u64IeeeAddr, u8Endpoint, u16ClusterId, u16AttributeId):
+        for oEntry in self.lEntries:
+            if (oEntry.u64IeeeAddr == u64IeeeAddr and oEntry.u16AttributeId == u16AttributeId and
+                    oEntry.u16ClusterId == u16ClusterId and oEntry.u8Endpoint == u8Endpoint):
+                return oEntry
+        return None
+
+    def IsFresh(self, oEntry):
+        return self.u32Ticks - oEntry.u32StoredAt < oEntry.u32Ttl
+
+    def Allocate(self):
+        oVictim = self.lEntries[0]
+        for oEntry in self.lEntries:
+            if oEntry.u64IeeeAddr == 0:
+                return oEntry
+            if not self.IsFresh(oEntry):
+                self.dStats["expired"] += 1
+                return oEntry
+            if self.u32Ticks - oEntry.u32LastUsed > self.u32Ticks - oVictim.u32LastUsed:
+                oVictim = oEntry
+        self.dStats["evicted"] += 1
+        return oVictim
+
+    def Store(self, u64IeeeAddr, u8Endpoint, u16ClusterId, u16AttributeId, sRecord):
+        u32Ttl = self.Ttl(u16ClusterId)
+        if u32Ttl == 0:
+            return
+        oEntry = self.Find(u64IeeeAddr, u8Endpoint, u16ClusterId, u16AttributeId) or self.Allocate()
+        oEntry.u64IeeeAddr = u64IeeeAddr
+        oEntry.u8Endpoint = u8Endpoint
+        oEntry.u16ClusterId = u16ClusterId
+        oEntry.u16AttributeId = u16AttributeId
+        oEntry.sRecord = sRecord
+        oEntry.u32StoredAt = self.u32Ticks
+        oEntry.u32LastUsed = self.u32Ticks
+        oEntry.u32Ttl = min(u32Ttl * ATTRIBUTE_CACHE_TICKS_PER_S, 0xFFFFFFFF)
+        self.dStats["stored"] += 1
+
+    def Lookup(self, u64IeeeAddr, u8Endpoint, u16ClusterId, lAttributes):
+        """Returns the records of every attribute when all are held and fresh, else None"""
+        if not lAttributes or self.Ttl(u16ClusterId) == 0:
+            return None
+        lEntries = [self.Find(u64IeeeAddr, u8Endpoint, u16ClusterId, u16AttributeId) for u16AttributeId in lAttributes]
+        if None in lEntries or not all(self.IsFresh(oEntry) for oEntry in lEntries):
+            self.dStats["misses"] += 1
+            return None
+        for oEntry in lEntries:
+            oEntry.u32LastUsed = self.u32Ticks
+        self.dStats["hits"] += 1
+        return [(oEntry.u16AttributeId, oEntry.sRecord) for oEntry in lEntries]
+
+    def Drop(self, u64IeeeAddr=0, u8Endpoint=0xFF, u16ClusterId=ATTRIBUTE_CACHE_ANY_CLUSTER):
+        for i in xrange(len(self.lEntries)):
+            oEntry = self.lEntries[i]
+            if (oEntry.u64IeeeAddr != 0 and u64IeeeAddr in (0, oEntry.u64IeeeAddr) and
+                    u8Endpoint in (0xFF, oEntry.u8Endpoint) and
+                    u16ClusterId in (ATTRIBUTE_CACHE_ANY_CLUSTER, oEntry.u16ClusterId)):
+                self.lEntries[i] = cEntry()
+                self.dStats["invalidated"] += 1
+
+    def Held(self):
+        return sum(1 for oEntry in self.lEntries if oEntry.u64IeeeAddr != 0)
+
+
+class cCoordinator(object):
+    """The E_SL_MSG_READ_ATTRIBUTE_REQUEST path of app_Znc_cmds.c: served from the cache when it can,
+       otherwise sent and the response stored on its way to the host"""
+    def __init__(self, oAps, oCache):
+        self.oAps = oAps
+        self.oCache = oCache
+        self.nServed = 0
+
+    def Read(self, u64IeeeAddr, u8Endpoint, u16ClusterId, lAttributes):
+        u16Addr = u64IeeeAddr & 0xFFFF
+        if self.oCache is not None:
+            lRecords = self.oCache.Lookup(u64IeeeAddr, u8Endpoint, u16ClusterId, lAttributes)
+            if lRecords is not None:
+                self.nServed += 1
+                return lRecords
+        lRecords = self.oAps.Read(u16Addr, u8Endpoint, u16ClusterId, lAttributes)
+        if self.oCache is not None:
+            for (u16AttributeId, sRecord) in lRecords:
+                self.oCache.Store(u64IeeeAddr, u8Endpoint, u16ClusterId, u16AttributeId, sRecord)
+        return lRecords
+
+    def Announce(self, u64IeeeAddr):
+        if self.oCache is not None:
+            self.oCache.Drop(u64IeeeAddr)
+
+    def Advance(self, fSeconds):
+        if self.oCache is not None:
+            self.oCache.u32Ticks += int(fSeconds * ATTRIBUTE_CACHE_TICKS_PER_S)
+
+
+def Run(oRandom, lRules, nEntries, nDevices, nIntegrations, nRestarts, fResetChance):
+    """Every integration interviews every device at start-up; the host restarts nRestarts times spread
+       over a day, and between restarts each device resets (and announces) with fResetChance.
+       Returns (radio transactions, reads answered from the cache, cache or None)"""
+    oAps = cStubAps()
+    oCache = cAttributeCache(lRules, nEntries) if lRules else None
+    oCoordinator = cCoordinator(oAps, oCache)
+    lDevices = [0x00158D0000000000 | oRandom.randint(1, 0xFFFF) << 16 | i for i in xrange(1, nDevices + 1)]
+
+    for _ in xrange(nRestarts + 1):
+        for _ in xrange(nIntegrations):
+            for u64IeeeAddr in oRandom.sample(lDevices, len(lDevices)):
+                for (u16ClusterId, lAttributes) in INTERVIEW:
+                    oCoordinator.Read(u64IeeeAddr, 1, u16ClusterId, lAttributes)
+                # Integrations read a few devices per second
+                oCoordinator.Advance(0.3)
+        oCoordinator.Advance(oRandom.uniform(600, 86400.0 / (nRestarts + 1)))
+        for u64IeeeAddr in lDevices:
+            if oRandom.random() < fResetChance:
+                oCoordinator.Announce(u64IeeeAddr)
+    return (oAps.nTransactions, oCoordinator.nServed, oCache)
+
+
+def main(argv):
+    oParser = optparse.OptionParser(usage="%prog [options] [rules...]")
+    oParser.add_option("-c", "--capacity", type="int", default=ATTRIBUTE_CACHE_MAX_ENTRIES, help="values the cache holds")
+    oParser.add_option("-d", "--devices", type="int", default=8, help="devices interviewed")
+    oParser.add_option("-i", "--integrations", type="int", default=3, help="host integrations interviewing each device")
+    oParser.add_option("-n", "--restarts", type="int", default=4, help="host restarts over the day")
+    oParser.add_option("-a", "--announce", type="float", default=0.05, help="chance a device resets between restarts")
+    oParser.add_option("-r", "--seed", type="int", default=1, help="random seed")
+    (oOptions, lArgs) = oParser.parse_args(argv)
+
+    lNames = lArgs or ["off", "default", "state"]
+    for sName in lNames:
+        if sName not in RULES:
+            oParser.error("unknown rules %s, one of %s" % (sName, ", ".join(sorted(RULES))))
+
+    print "%-8s %12s %8s %8s %6s %7s %8s %6s" % ("rules", "transactions", "avoided", "served", "held",
+                                                 "evicted", "expired", "inval")
+    nBaseline = None
+    for sName in lNames:
+        # Same devices and schedule for every rule set
+        oRandom = random.Random(oOptions.seed)
+        (nTransactions, nServed, oCache) = Run(oRandom, RULES[sName], oOptions.capacity, oOptions.devices,
+                                               oOptions.integrations, oOptions.restarts, oOptions.announce)
+        if nBaseline is None:
+            nBaseline = nTransactions + nServed
+        if oCache is None:
+            print "%-8s %12d %7d%% %8d %6s %7s %8s %6s" % (sName, nTransactions, 0, nServed, "-", "-", "-", "-")
+        else:
+            print "%-8s %12d %7d%% %8d %6d %7d %8d %6d" % (sName, nTransactions,
+                                                          100 * (nBaseline - nTransactions) // nBaseline, nServed,
+                                                          oCache.Held(), oCache.dStats["evicted"],
+                                                          oCache.dStats["expired"], oCache.dStats["invalidated"])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,202 @@
+#*****************************************************************************
+#*
+# * MODULE:             ZigBee Control Bridge
+# *
+# * COMPONENT:          ChannelQualitySim.py
+# *
+# * DESCRIPTION:        Host side simulation of the channel ranking in
+# *                     app_channel_quality.c against synthetic Wi-Fi
+# *                     interference, comparing the delivery it achieves
+# *                     with forming on the BDB primary channels
+# *
+# *****************************************************************************
+import sys
+import random
+import optparse
+
+FIRST_CHANNEL = 11
+CHANNELS = 16
+
+# Mirrors app_channel_quality.h
+CHANNEL_QUALITY_SCALE = 1000
+CHANNEL_QUALITY_UNKNOWN = 500
+CHANNEL_QUALITY_ENERGY_LOSS = 750
+CHANNEL_QUALITY_PRIOR_FRAMES = 20
+CHANNEL_QUALITY_ENERGY_WEIGHT = 2
+CHANNEL_QUALITY_CHANGE_MARGIN = 50
+
+# bdbcPrimaryChannelSet
+PRIMARY_CHANNELS = (11, 15, 20, 25)
+
+# Share of frames hitting a Wi-Fi burst that outlasts the MAC retries
+BURST_PERSISTENCE = 0.5
+
+# Interferers as (Wi-Fi channel, duty cycle, energy reading while on air, on air before formation)
+PROFILES = {
+    "quiet"     : [],
+    "home"      : [(6, 0.45, 200, True)],
+    "office"    : [(1, 0.35, 180, True), (6, 0.55, 220, True), (11, 0.40, 190, True)],
+    "europe"    : [(1, 0.30, 170, True), (5, 0.40, 190, True), (9, 0.45, 200, True), (13, 0.35, 180, True)],
+    "newap"     : [(1, 0.25, 160, True), (13, 0.70, 230, False), (9, 0.60, 210, False)],
+    "busy"      : [(1, 0.60, 160, True), (6, 0.70, 170, True), (11, 0.65, 150, True),
+                   (3, 0.25, 120, False), (13, 0.55, 200, False)],
+}
+
+
+def ZigbeeCentreMHz(u8Channel):
+    return 2405 + 5 * (u8Channel - FIRST_CHANNEL)
+
+
+def WifiOverlap(u8Channel, u8WifiChannel):
+    """Share of a Wi-Fi transmission's power falling on a Zigbee channel, flat over the
+       main lobe and tapering over the 22 MHz mask"""
+    fOffset = abs(ZigbeeCentreMHz(u8Channel) - (2407 + 5 * u8WifiChannel))
+    if fOffset <= 9:
+        return 1.0
+    if fOffset <= 15:
+        return (15 - fOffset) / 6.0
+    return 0.0
+
+
+class cChannel(object):
+    """Busy fraction of one Zigbee channel and what an energy scan of it reads"""
+    def __init__(self, u8Channel, lInterferers):
+        self.u8Channel = u8Channel
+        self.lShares = []
+        fClear = 1.0
+        for (u8WifiChannel, fDuty, u8Level) in lInterferers:
+            fOverlap = WifiOverlap(u8Channel, u8WifiChannel)
+            if fOverlap > 0:
+                self.lShares.append((fDuty * fOverlap, u8Level * fOverlap))
+                fClear *= 1.0 - fDuty * fOverlap
+        self.fBusy = 1.0 - fClear
+
+    def Delivery(self):
+        """Chance a unicast frame is acknowledged within the MAC retries"""
+        return 1.0 - self.fBusy * BURST_PERSISTENCE
+
+    def EnergyScan(self, oRandom):
+        """One ED reading, catching each interferer on or off air over the noise floor"""
+        fReading = oRandom.gauss(10, 4)
+        for (fShare, fLevel) in self.lShares:
+            if oRandom.random() < fShare:
+                fReading += fLevel
+        return int(max(0, min(255, fReading)))
+
+    def SendFrames(self, oRandom, nFrames):
+        """Returns (sent, no ack, busy) counted as APP_vChannelQualityDataConfirm would"""
+        nNoAck = 0
+        nBusy = 0
+        for _ in xrange(nFrames):
+            if oRandom.random() < self.fBusy * BURST_PERSISTENCE:
+                if oRandom.random() < 0.5:
+                    nBusy += 1
+                else:
+                    nNoAck += 1
+        return (nFrames, nNoAck, nBusy)
+
+
+class cHistory(object):
+    """The per channel record of app_channel_quality.c, integer arithmetic as on the node"""
+    def __init__(self):
+        self.u16Sent = 0
+        self.u16NoAck = 0
+        self.u16Busy = 0
+        self.u8Energy = 0
+        self.u8EnergyScans = 0
+
+    def AddEnergy(self, u8Energy):
+        if self.u8EnergyScans == 0:
+            self.u8Energy = u8Energy
+        else:
+            self.u8Energy = (self.u8Energy * (8 - CHANNEL_QUALITY_ENERGY_WEIGHT) +
+                             u8Energy * CHANNEL_QUALITY_ENERGY_WEIGHT) // 8
+        self.u8EnergyScans = min(self.u8EnergyScans + 1, 0xFF)
+
+    def AddFrames(self, nSent, nNoAck, nBusy):
+        self.u16Sent += nSent
+        self.u16NoAck += nNoAck
+        self.u16Busy += nBusy
+        while self.u16Sent >= 0x8000:
+            self.u16Sent >>= 1
+            self.u16NoAck >>= 1
+            self.u16Busy >>= 1
+
+    def Delivery(self):
+        u32Estimate = CHANNEL_QUALITY_UNKNOWN
+        if self.u8EnergyScans > 0:
+            u32Estimate = CHANNEL_QUALITY_SCALE - (self.u8Energy * CHANNEL_QUALITY_ENERGY_LOSS) // 0xFF
+        u32Delivered = self.u16Sent - self.u16NoAck - self.u16Busy
+        return ((u32Delivered * CHANNEL_QUALITY_SCALE + u32Estimate * CHANNEL_QUALITY_PRIOR_FRAMES) //
+                (self.u16Sent + CHANNEL_QUALITY_PRIOR_FRAMES))
+
+
+def Best(dHistory, u8Current):
+    """APP_u8ChannelQualityBest over all channels"""
+    u8Best = u8Current
+    u16Best = dHistory[u8Current].Delivery()
+    for u8Channel in range(FIRST_CHANNEL, FIRST_CHANNEL + CHANNELS):
+        if dHistory[u8Channel].Delivery() > u16Best:
+            u16Best = dHistory[u8Channel].Delivery()
+            u8Best = u8Channel
+    return u8Best
+
+
+def Trial(oRandom, lInterferers, nScans, nFrames):
+    """Forms on the quietest primary channel of one scan, as BDB does, then lets the history build
+       up over nScans network update scans with nFrames frames between them, with interferers
+       not on air at formation switched on.
+       Returns (formed channel, its delivery, channel the ranking moved to, its delivery)"""
+    dEarly = dict((u8Channel, cChannel(u8Channel, [t[:3] for t in lInterferers if t[3]]))
+                  for u8Channel in range(FIRST_CHANNEL, FIRST_CHANNEL + CHANNELS))
+    dChannel = dict((u8Channel, cChannel(u8Channel, [t[:3] for t in lInterferers]))
+                    for u8Channel in range(FIRST_CHANNEL, FIRST_CHANNEL + CHANNELS))
+    dHistory = dict((u8Channel, cHistory()) for u8Channel in dChannel)
+
+    u8Formed = min(PRIMARY_CHANNELS, key=lambda u8Channel: (dEarly[u8Channel].EnergyScan(oRandom), u8Channel))
+    u8Current = u8Formed
+    for _ in xrange(nScans):
+        dHistory[u8Current].AddFrames(*dChannel[u8Current].SendFrames(oRandom, nFrames))
+        for u8Channel in dChannel:
+            dHistory[u8Channel].AddEnergy(dChannel[u8Channel].EnergyScan(oRandom))
+        u8Best = Best(dHistory, u8Current)
+        if (u8Best != u8Current and
+                dHistory[u8Best].Delivery() >= dHistory[u8Current].Delivery() + CHANNEL_QUALITY_CHANGE_MARGIN):
+            u8Current = u8Best
+    return (u8Formed, dChannel[u8Formed].Delivery(), u8Current, dChannel[u8Current].Delivery())
+
+
+def main(argv):
+    oParser = optparse.OptionParser(usage="%prog [options] [profile...]")
+    oParser.add_option("-t", "--trials", type="int", default=200, help="trials per profile")
+    oParser.add_option("-s", "--scans", type="int", default=8, help="energy scans per trial")
+    oParser.add_option("-f", "--frames", type="int", default=100, help="frames sent between scans")
+    oParser.add_option("-r", "--seed", type="int", default=1, help="random seed")
+    (oOptions, lArgs) = oParser.parse_args(argv)
+
+    lProfiles = lArgs or sorted(PROFILES)
+    for sProfile in lProfiles:
+        if sProfile not in PROFILES:
+            oParser.error("unknown profile %s, one of %s" % (sProfile, ", ".join(sorted(PROFILES))))
+
+    oRandom = random.Random(oOptions.seed)
+    print "%-10s %9s %9s %8s %6s" % ("profile", "primary", "ranked", "gain", "moved")
+    for sProfile in lProfiles:
+        fFormed = 0.0
+        fRanked = 0.0
+        nMoved = 0
+        for _ in xrange(oOptions.trials):
+            (u8Formed, fFormedDelivery, u8Ranked, fRankedDelivery) = Trial(oRandom, PROFILES[sProfile],
+                                                                          oOptions.scans, oOptions.frames)
+            fFormed += fFormedDelivery
+            fRanked += fRankedDelivery
+            nMoved += u8Formed != u8Ranked
+        fFormed /= oOptions.trials
+        fRanked /= oOptions.trials
+        print "%-10s %8.2f%% %8.2f%% %+7.2f%% %5d%%" % (sProfile, 100 * fFormed, 100 * fRanked,
+                                                     100 * (fRanked - fFormed), 100 * nMoved // oOptions.trials)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,293 @@
+#*****************************************************************************
+#*
+# * MODULE:             ZigBee Control Bridge
+# *
+# * COMPONENT:          ChildQueueSim.py
+# *
+# * DESCRIPTION:        Host side simulation of commands for sleepy children,
+# *                     sent straight to the parent and retried by the host, or
+# *                     held by app_child_queue.c and handed to the parent one
+# *                     at a time until the child polls for it.
+# *                     Source/HostSim/Tests/test_child_queue.c runs the same
+# *                     poll intervals through app_child_queue.c.
+# *
+# *****************************************************************************
+import sys
+import heapq
+import random
+import optparse
+
+# Mirrors app_child_queue.h
+CHILD_QUEUE_SIZE = 16
+CHILD_QUEUE_DEFAULT_EXPIRY = 120.0
+
+# Time a frame for a sleepy child waits at its parent for the next poll
+INDIRECT_HOLD = 7.68
+# Frames the parent holds for all its sleepy children together
+INDIRECT_CAPACITY = 10
+# Poll interval, and how long it lasts, after a child received a frame
+FAST_POLL = 0.25
+FAST_POLL_WINDOW = 1.0
+# Time a host needs to see a failed or busy command and send it again
+HOST_RETRY_DELAY = 1.0
+
+# Slow poll intervals of the simulated children, seconds
+POLL_CLASSES = (1, 5, 30, 60, 300)
+
+
+class cChild(object):
+    """A sleepy child polling its parent every fPoll seconds, and quickly for a while after it
+       received a frame"""
+    def __init__(self, oRandom, nIndex, fPoll):
+        self.nIndex = nIndex
+        self.fPoll = fPoll
+        self.fPhase = oRandom.uniform(0, fPoll)
+        self.fFastUntil = -1.0
+        self.nPollGen = 0
+        # Frames waiting at the parent, oldest first
+        self.lParent = []
+        # Commands held by the control bridge, oldest first
+        self.lHeld = []
+
+    def NextPoll(self, fTime):
+        # Past the poll at fTime itself, whatever the rounding
+        nPolls = int((fTime - self.fPhase) / self.fPoll + 1e-6) + 1
+        fNext = self.fPhase + max(nPolls, 0) * self.fPoll
+        if fTime + FAST_POLL <= self.fFastUntil:
+            fNext = min(fNext, fTime + FAST_POLL)
+        return fNext
+
+
+class cCommand(object):
+    def __init__(self, oChild, nKey, fSubmitted):
+        self.oChild = oChild
+        self.nKey = nKey
+        self.fSubmitted = fSubmitted
+        self.fDeadline = None
+        self.nAttempts = 0
+        self.nSubmitted = 0
+        self.fDelivered = None
+        self.bExpired = False
+        # Commands folded into this one
+        self.lCoalesced = []
+
+
+class cNetwork(object):
+    """Event loop shared by both ways of sending; bQueue selects the control bridge queue"""
+    def __init__(self, oRandom, lChildren, bQueue, nSize, fExpiry, nRetries, fLoss):
+        self.oRandom = oRandom
+        self.nSize = nSize
+        self.lChildren = lChildren
+        self.bQueue = bQueue
+        self.fExpiry = fExpiry
+        self.nRetries = nRetries
+        self.fLoss = fLoss
+        self.lEvents = []
+        self.nSeq = 0
+        self.nParent = 0
+        self.nHeld = 0
+        self.nUart = 0
+        self.lCommands = []
+        self.lWaiting = []
+
+    def Schedule(self, fTime, sEvent, oItem, nGen=0):
+        self.nSeq += 1
+        heapq.heappush(self.lEvents, (fTime, self.nSeq, sEvent, oItem, nGen))
+
+    def SchedulePoll(self, oChild, fTime):
+        oChild.nPollGen += 1
+        self.Schedule(oChild.NextPoll(fTime), "poll", oChild, oChild.nPollGen)
+
+    def ToParent(self, fTime, oCommand):
+        """Hands a frame to the parent, False when it has no room for it"""
+        if self.nParent >= INDIRECT_CAPACITY:
+            return False
+        self.nParent += 1
+        oCommand.oChild.lParent.append(oCommand)
+        oCommand.nAttempts += 1
+        self.Schedule(fTime + INDIRECT_HOLD, "hold", oCommand, oCommand.nAttempts)
+        return True
+
+    def Submit(self, fTime, oCommand):
+        """The host sends a command over the serial link"""
+        self.nUart += 1
+        oCommand.nSubmitted += 1
+        oChild = oCommand.oChild
+        if not self.bQueue:
+            if not self.ToParent(fTime, oCommand):
+                self.Failed(fTime, oCommand)
+            return
+        for oHeld in oChild.lHeld:
+            if oHeld.nKey == oCommand.nKey and oHeld not in oChild.lParent:
+                oHeld.fDeadline = fTime + self.fExpiry
+                oHeld.lCoalesced.append(oCommand)
+                return
+        if self.nHeld >= self.nSize:
+            # Busy status, the host sends it again a few times
+            if oCommand.nSubmitted <= self.nRetries:
+                self.Schedule(fTime + HOST_RETRY_DELAY, "submit", oCommand)
+            else:
+                oCommand.bExpired = True
+            return
+        self.nHeld += 1
+        oCommand.fDeadline = fTime + self.fExpiry
+        oChild.lHeld.append(oCommand)
+        self.Release(fTime, oChild)
+
+    def Release(self, fTime, oChild):
+        """Hands the oldest held command of a child to the parent once nothing else is there for it"""
+        if oChild.lParent or not oChild.lHeld:
+            return
+        if not self.ToParent(fTime, oChild.lHeld[0]):
+            if oChild not in self.lWaiting:
+                self.lWaiting.append(oChild)
+
+    def ParentFreed(self, fTime):
+        while self.lWaiting and self.nParent < INDIRECT_CAPACITY:
+            self.Release(fTime, self.lWaiting.pop(0))
+
+    def Failed(self, fTime, oCommand):
+        """The parent gave up on a frame, or had no room for it"""
+        if self.bQueue:
+            if fTime >= oCommand.fDeadline:
+                self.Expire(oCommand)
+            else:
+                self.Release(fTime, oCommand.oChild)
+        elif oCommand.nSubmitted <= self.nRetries:
+            self.Schedule(fTime + HOST_RETRY_DELAY, "submit", oCommand)
+        else:
+            oCommand.bExpired = True
+
+    def Expire(self, oCommand):
+        oChild = oCommand.oChild
+        oChild.lHeld.remove(oCommand)
+        self.nHeld -= 1
+        for oDone in [oCommand] + oCommand.lCoalesced:
+            oDone.bExpired = True
+
+    def Poll(self, fTime, oChild):
+        if oChild.lParent:
+            oCommand = oChild.lParent.pop(0)
+            self.nParent -= 1
+            if self.oRandom.random() < self.fLoss:
+                self.Failed(fTime, oCommand)
+            else:
+                oChild.fFastUntil = fTime + FAST_POLL_WINDOW
+                for oDone in [oCommand] + oCommand.lCoalesced:
+                    oDone.fDelivered = fTime
+                if self.bQueue:
+                    oChild.lHeld.remove(oCommand)
+                    self.nHeld -= 1
+            if self.bQueue:
+                self.Release(fTime, oChild)
+            self.ParentFreed(fTime)
+        self.SchedulePoll(oChild, fTime)
+
+    def Run(self, lSubmissions, fDuration):
+        for oChild in self.lChildren:
+            self.SchedulePoll(oChild, 0.0)
+        for (fTime, oCommand) in lSubmissions:
+            self.lCommands.append(oCommand)
+            self.Schedule(fTime, "submit", oCommand)
+        fEnd = fDuration + self.fExpiry + INDIRECT_HOLD * (self.nRetries + 2)
+        while self.lEvents:
+            (fTime, _, sEvent, oItem, nGen) = heapq.heappop(self.lEvents)
+            if fTime > fEnd:
+                break
+            if sEvent == "submit":
+                self.Submit(fTime, oItem)
+            elif sEvent == "poll":
+                if nGen == oItem.nPollGen:
+                    self.Poll(fTime, oItem)
+            elif sEvent == "hold":
+                oChild = oItem.oChild
+                if oItem in oChild.lParent and nGen == oItem.nAttempts:
+                    oChild.lParent.remove(oItem)
+                    self.nParent -= 1
+                    self.Failed(fTime, oItem)
+                    self.ParentFreed(fTime)
+            # Held commands past their deadline, the control bridge tick
+            if self.bQueue:
+                for oChild in self.lChildren:
+                    for oHeld in list(oChild.lHeld):
+                        if fTime >= oHeld.fDeadline and oHeld not in oChild.lParent:
+                            self.Expire(oHeld)
+
+
+def Percentile(lValues, fRank):
+    if not lValues:
+        return 0.0
+    lSorted = sorted(lValues)
+    return lSorted[min(int(fRank * len(lSorted)), len(lSorted) - 1)]
+
+
+def main(argv):
+    oParser = optparse.OptionParser(usage="%prog [options] [poll interval...]")
+    oParser.add_option("-c", "--children", type="int", default=3, help="sleepy children per poll interval")
+    oParser.add_option("-i", "--interval", type="float", default=90.0,
+                       help="mean time between host commands to one child, seconds")
+    oParser.add_option("-s", "--repeat", type="float", default=0.3,
+                       help="share of commands repeating the previous one to the same child")
+    oParser.add_option("-t", "--duration", type="float", default=3600.0, help="simulated time, seconds")
+    oParser.add_option("-e", "--expiry", type="float", default=CHILD_QUEUE_DEFAULT_EXPIRY,
+                       help="child queue expiry, seconds")
+    oParser.add_option("-q", "--queue-size", type="int", default=CHILD_QUEUE_SIZE,
+                       help="commands the child queue holds")
+    oParser.add_option("-n", "--retries", type="int", default=3, help="host resends of a failed command")
+    oParser.add_option("-p", "--loss", type="float", default=0.02, help="frame loss on a poll")
+    oParser.add_option("-r", "--seed", type="int", default=1, help="random seed")
+    (oOptions, lArgs) = oParser.parse_args(argv)
+
+    try:
+        lClasses = [int(sArg) for sArg in lArgs] or list(POLL_CLASSES)
+    except ValueError:
+        oParser.error("poll intervals are whole seconds")
+
+    dResults = {}
+    for (sWho, bQueue) in (("host", False), ("queue", True)):
+        # The same children and commands for both
+        oRandom = random.Random(oOptions.seed)
+        lChildren = []
+        for fPoll in lClasses:
+            for _ in range(oOptions.children):
+                lChildren.append(cChild(oRandom, len(lChildren), float(fPoll)))
+        lSubmissions = []
+        for oChild in lChildren:
+            fTime = oRandom.expovariate(1.0 / oOptions.interval)
+            nKey = oRandom.randint(0, 1000)
+            while fTime < oOptions.duration:
+                if oRandom.random() >= oOptions.repeat:
+                    nKey = oRandom.randint(0, 1000)
+                lSubmissions.append((fTime, cCommand(oChild, nKey, fTime)))
+                fTime += oRandom.expovariate(1.0 / oOptions.interval)
+        oNetwork = cNetwork(random.Random(oOptions.seed + 1), lChildren, bQueue, oOptions.queue_size, oOptions.expiry,
+                            oOptions.retries, oOptions.loss)
+        oNetwork.Run(lSubmissions, oOptions.duration)
+        dResults[sWho] = oNetwork
+
+    print "%-8s %30s %30s" % ("", "host retries", "child queue")
+    print "%-8s %7s %6s %4s %5s %5s %7s %6s %4s %5s %5s" % (
+        "poll", "deliv", "cmds", "uart", "mean", "p95", "deliv", "cmds", "uart", "mean", "p95")
+    for fPoll in [float(nClass) for nClass in lClasses] + [None]:
+        lLine = []
+        for sWho in ("host", "queue"):
+            oNetwork = dResults[sWho]
+            lCommands = [oCommand for oCommand in oNetwork.lCommands
+                         if fPoll is None or oCommand.oChild.fPoll == fPoll]
+            lLatency = [oCommand.fDelivered - oCommand.fSubmitted for oCommand in lCommands
+                        if oCommand.fDelivered is not None]
+            nUart = sum(oCommand.nSubmitted for oCommand in lCommands)
+            lLine += [100.0 * len(lLatency) / max(len(lCommands), 1), len(lCommands),
+                      float(nUart) / max(len(lCommands), 1),
+                      sum(lLatency) / max(len(lLatency), 1), Percentile(lLatency, 0.95)]
+        print "%-8s %6.1f%% %6d %4.2f %4.0fs %4.0fs %6.1f%% %6d %4.2f %4.0fs %4.0fs" % tuple(
+            ["%ds" % fPoll if fPoll is not None else "all"] + lLine)
+    for sWho in ("host", "queue"):
+        oNetwork = dResults[sWho]
+        print "%-6s serial commands %d, expired %d" % (
+            sWho, oNetwork.nUart, sum(1 for oCommand in oNetwork.lCommands if oCommand.bExpired))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
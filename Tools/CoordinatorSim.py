@@ -0,0 +1,509 @@
+#*****************************************************************************
+#*
+# * MODULE:             ZigBee Control Bridge
+# *
+# * COMPONENT:          CoordinatorSim.py
+# *
+# * DESCRIPTION:        Deterministic discrete event model of the ControlBridge
+# *                     main loop under load from a large network: scripted
+# *                     devices sending reports, device announces, ZDP
+# *                     responses and OTA block requests, and a SerialLink
+# *                     host answering them. Reports UART throughput, queue
+# *                     depths, PDU exhaustion, frame latency and CPU time
+# *                     per event type for each network size. Latency runs
+# *                     from a device sending a frame to the host having the
+# *                     message, or from the host queueing a command to the
+# *                     node having received it.
+# *
+# *                     The pools, queues and link rate mirror the tree; the
+# *                     CPU costs are estimates to be replaced with figures
+# *                     measured on the node (--cost). For the firmware's
+# *                     own handlers under load, linked against the host
+# *                     stand-ins for the stack, build Build/host 'make sim'
+# *                     and run Objects/coordinator_sim.
+# *
+# *                     Runs under Python 2.7 and Python 3.
+# *
+# *****************************************************************************
+import sys
+import heapq
+import random
+import struct
+import optparse
+
+# Mirrors ControlBridge_Full.zpscfg
+NUM_NPDUS = 19
+NUM_APDUS = 10
+MAX_SIMULTANEOUS_APSDE_REQ = 5
+
+# Mirrors app_start.c
+MCPS_QUEUE_SIZE = 27
+BDB_QUEUE_SIZE = 2
+RX_QUEUE_SIZE = 150
+
+# Mirrors board/app.h
+UART_BAUD_RATE = 115200
+
+# Mirrors app_aps_queue.h
+APS_QUEUE_SIZE = 16
+APS_QUEUE_MAX_IN_FLIGHT = 4
+
+# Mirrors SerialLink.h
+E_SL_MSG_STATUS = 0x8000
+E_SL_MSG_APS_DATA_ACK = 0x8011
+E_SL_MSG_SIMPLE_DESCRIPTOR_REQUEST = 0x0043
+E_SL_MSG_SIMPLE_DESCRIPTOR_RESPONSE = 0x8043
+E_SL_MSG_ACTIVE_ENDPOINT_REQUEST = 0x0045
+E_SL_MSG_ACTIVE_ENDPOINT_RESPONSE = 0x8045
+E_SL_MSG_DEVICE_ANNOUNCE = 0x004D
+E_SL_MSG_READ_ATTRIBUTE_REQUEST = 0x0100
+E_SL_MSG_READ_ATTRIBUTE_RESPONSE = 0x8100
+E_SL_MSG_REPORT_IND_ATTR_RESPONSE = 0x8102
+E_SL_MSG_BLOCK_REQUEST = 0x8501
+E_SL_MSG_BLOCK_SEND = 0x0502
+
+# 802.15.4 at 250 kbps, with PHY, MAC, NWK (secured) and APS headers around the payload
+RADIO_US_PER_BYTE = 32
+RADIO_FRAME_OVERHEAD = 55
+RADIO_ACK_US = 352
+RADIO_CSMA_US = 1120
+
+# Time a device takes to answer a request once it is received, and the host to react
+DEVICE_TURNAROUND_US = 15000
+HOST_TURNAROUND_US = 2000
+
+OTA_BLOCK_SIZE = 64
+
+# CPU time in us on the node per unit of work, serial writes excluded as they are
+# timed from the link rate. Estimates, override with --cost name=us.
+COSTS = {
+    "loop"          : 15,       # one pass of the main loop with nothing to do
+    "zps_rx"        : 220,      # MAC indication through NWK security and APS to a stack event
+    "report"        : 160,      # ZCL parse of an attribute report
+    "read_response" : 160,
+    "announce"      : 260,      # device announce, address map and device table update
+    "zdp_response"  : 120,
+    "block_request" : 190,
+    "aps_ack"       : 70,       # APS ack or confirm for a frame the node sent
+    "host_byte"     : 2,        # serial receive, per byte
+    "host_command"  : 90,       # command decode and status
+    "aps_tx"        : 300,      # request through APS, NWK security and MAC
+}
+
+
+def SlFrameBytes(u16Type, sPayload):
+    """Bytes on the wire for a SerialLink frame, bytes below 0x10 are escaped"""
+    sBody = struct.pack(">HHB", u16Type, len(sPayload) + 1, 0) + sPayload + b"\x00"
+    return 2 + len(sBody) + sum(1 for u8Byte in bytearray(sBody) if u8Byte < 0x10)
+
+
+def RandInt(oRandom, nLow, nHigh):
+    """randint drawn the same way under Python 2 and 3, so that a seed gives the same run"""
+    return nLow + int(oRandom.random() * (nHigh - nLow + 1))
+
+
+def HostMessage(oRandom, u16Type, u16Address):
+    """Payload the node writes to the host for a message type, laid out as app_Znc_cmds.c and the
+       event handlers build it with plausible field values"""
+    u8Seq = RandInt(oRandom, 0, 255)
+    if u16Type == E_SL_MSG_STATUS:
+        return struct.pack(">BBHBBBB", 0, u8Seq, 0x0100, 1, u8Seq, 3, 2)
+    if u16Type in (E_SL_MSG_REPORT_IND_ATTR_RESPONSE, E_SL_MSG_READ_ATTRIBUTE_RESPONSE):
+        return struct.pack(">BHBHHBBHh", u8Seq, u16Address, 1, 0x0402, 0x0000, 0, 0x29, 2, RandInt(oRandom, 1500, 2500))
+    if u16Type == E_SL_MSG_DEVICE_ANNOUNCE:
+        return struct.pack(">HQBB", u16Address, 0x00158D0000000000 | oRandom.getrandbits(24), 0x8E, 0)
+    if u16Type == E_SL_MSG_ACTIVE_ENDPOINT_RESPONSE:
+        return struct.pack(">BBHBB", u8Seq, 0, u16Address, 1, 1)
+    if u16Type == E_SL_MSG_SIMPLE_DESCRIPTOR_RESPONSE:
+        return (struct.pack(">BBHBBHHBB", u8Seq, 0, u16Address, 20, 1, 0x0104, 0x0302, 1, 6) +
+                struct.pack(">6H", 0x0000, 0x0001, 0x0003, 0x0402, 0x0405, 0x0B05) +
+                struct.pack(">B2H", 2, 0x0019, 0x000A))
+    if u16Type == E_SL_MSG_BLOCK_REQUEST:
+        return struct.pack(">BBHBHQIIHHHBB", u8Seq, 1, 0x0019, 2, u16Address, 0x00158D0000000000,
+                           RandInt(oRandom, 0, 0x3FFFF) & ~0x3F, 0x01020304, 0x0101, 0x1037, 0, OTA_BLOCK_SIZE, 0)
+    if u16Type == E_SL_MSG_APS_DATA_ACK:
+        return struct.pack(">BHBBH", 0, u16Address, 1, 1, 0x0019)
+    raise ValueError("no layout for 0x%04x" % u16Type)
+
+
+def HostCommand(u16Type, u16Address):
+    """Payload the host sends for a command"""
+    if u16Type == E_SL_MSG_ACTIVE_ENDPOINT_REQUEST:
+        return struct.pack(">H", u16Address)
+    if u16Type == E_SL_MSG_SIMPLE_DESCRIPTOR_REQUEST:
+        return struct.pack(">HB", u16Address, 1)
+    if u16Type == E_SL_MSG_READ_ATTRIBUTE_REQUEST:
+        return struct.pack(">BHBBHBBHBH", 2, u16Address, 1, 1, 0x0402, 0, 0, 0, 1, 0x0000)
+    if u16Type == E_SL_MSG_BLOCK_SEND:
+        return struct.pack(">BHBBBBIIHHB", 2, u16Address, 1, 1, 0, 0, 0, 0x01020304, 0x0101, 0x1037,
+                           OTA_BLOCK_SIZE) + b"\x5A" * OTA_BLOCK_SIZE
+    raise ValueError("no layout for 0x%04x" % u16Type)
+
+
+def Percentile(lValues, fShare):
+    if not lValues:
+        return 0
+    return lValues[min(len(lValues) - 1, int(fShare * len(lValues)))]
+
+
+class cGauge(object):
+    """Time weighted occupancy of a queue or pool"""
+    def __init__(self, nLimit):
+        self.nLimit = nLimit
+        self.nValue = 0
+        self.nPeak = 0
+        self.nFull = 0
+        self.u64Area = 0
+        self.u64Since = 0
+
+    def Set(self, u64Now, nValue):
+        # The node's work is booked ahead of the event clock, keep time moving forwards
+        u64Now = max(u64Now, self.u64Since)
+        self.u64Area += self.nValue * (u64Now - self.u64Since)
+        self.u64Since = u64Now
+        self.nValue = nValue
+        self.nPeak = max(self.nPeak, nValue)
+
+    def Take(self, u64Now):
+        """Returns False, counting it, when the pool or queue is full"""
+        if self.nValue >= self.nLimit:
+            self.nFull += 1
+            return False
+        self.Set(u64Now, self.nValue + 1)
+        return True
+
+    def Give(self, u64Now):
+        self.Set(u64Now, self.nValue - 1)
+
+    def Mean(self, u64Now):
+        self.Set(u64Now, self.nValue)
+        return float(self.u64Area) / max(1, u64Now)
+
+
+class cSim(object):
+    def __init__(self, oOptions, nDevices):
+        self.oOptions = oOptions
+        self.oRandom = random.Random(oOptions.seed)
+        self.nDevices = nDevices
+        self.lEvents = []
+        self.u32Order = 0
+        self.u64Now = 0
+
+        # Node
+        self.u64CpuFree = 0
+        self.bPassScheduled = False
+        self.lMcps = []                 # (arrival, kind, address, payload bytes)
+        self.lBdb = []
+        self.lHostRx = []               # complete host commands awaiting APP_vProcessRxData
+        self.lApsQueue = []
+        self.oNpdu = cGauge(NUM_NPDUS)
+        self.oApdu = cGauge(NUM_APDUS)
+        self.oMcps = cGauge(MCPS_QUEUE_SIZE)
+        self.oBdb = cGauge(BDB_QUEUE_SIZE)
+        self.oApsQueue = cGauge(APS_QUEUE_SIZE)
+        self.oInFlight = cGauge(min(APS_QUEUE_MAX_IN_FLIGHT, MAX_SIMULTANEOUS_APSDE_REQ))
+        self.oHostRx = cGauge(RX_QUEUE_SIZE)
+
+        # Radio and serial link
+        self.u64RadioFree = 0
+        self.u64RadioBusy = 0
+        self.u64UartTxBytes = 0
+        self.u64UartTxBusy = 0
+        self.u64UartRxBytes = 0
+        self.u64UartRxFree = 0
+
+        # Host
+        self.lHostPending = []
+        self.bHostWaiting = False
+        self.oHostPending = cGauge(1 << 30)
+
+        # Results
+        self.dCpu = {}                  # event type -> [count, cpu us, uart us]
+        self.dLatency = {}              # message type -> [us]
+        self.nDropped = 0
+        self.nRefused = 0
+        self.nOtaBlocks = 0
+
+    # Event scheduling
+    def At(self, u64Time, fnEvent, *tArgs):
+        self.u32Order += 1
+        heapq.heappush(self.lEvents, (u64Time, self.u32Order, fnEvent, tArgs))
+
+    def Run(self, u64Until):
+        while self.lEvents and self.lEvents[0][0] <= u64Until:
+            (self.u64Now, _, fnEvent, tArgs) = heapq.heappop(self.lEvents)
+            fnEvent(*tArgs)
+        self.u64Now = u64Until
+
+    # Radio
+    def Air(self, nPayload):
+        """Occupies the channel for one frame, returns when it has been received"""
+        u64Start = max(self.u64Now, self.u64RadioFree) + RandInt(self.oRandom, 0, 2 * RADIO_CSMA_US)
+        u32Air = (nPayload + RADIO_FRAME_OVERHEAD) * RADIO_US_PER_BYTE + RADIO_ACK_US
+        self.u64RadioFree = u64Start + u32Air
+        self.u64RadioBusy += u32Air
+        return self.u64RadioFree
+
+    def DeviceSend(self, sKind, u16Address, nPayload, u64Origin=None):
+        self.At(self.Air(nPayload), self.MacIndication, sKind, u16Address,
+                self.u64Now if u64Origin is None else u64Origin)
+
+    def MacIndication(self, sKind, u16Address, u64Origin):
+        """A frame for the node, held in an NPDU on the MCPS queue until zps_taskZPS runs"""
+        if not self.oNpdu.Take(self.u64Now):
+            self.nDropped += 1
+            return
+        if not self.oMcps.Take(self.u64Now):
+            self.oNpdu.Give(self.u64Now)
+            self.nDropped += 1
+            return
+        self.lMcps.append((u64Origin, sKind, u16Address))
+        self.Wake()
+
+    # Node main loop
+    def Wake(self):
+        if not self.bPassScheduled:
+            self.bPassScheduled = True
+            self.At(max(self.u64Now, self.u64CpuFree), self.Pass)
+
+    def Work(self, sType, u32Cpu, lMessages=(), u16Address=0, u64Origin=None):
+        """Charges CPU time and the blocking serial writes of the messages to sType"""
+        u32Uart = 0
+        for u16Type in lMessages:
+            nBytes = SlFrameBytes(u16Type, HostMessage(self.oRandom, u16Type, u16Address))
+            u32Uart += nBytes * 10 * 1000000 // UART_BAUD_RATE
+            self.u64UartTxBytes += nBytes
+            u64Sent = self.u64CpuFree + u32Cpu + u32Uart
+            if u64Origin is not None:
+                self.dLatency.setdefault(u16Type, []).append(u64Sent - u64Origin)
+            self.At(u64Sent, self.HostReceive, u16Type, u16Address)
+        self.u64UartTxBusy += u32Uart
+        lStats = self.dCpu.setdefault(sType, [0, 0, 0])
+        lStats[0] += 1
+        lStats[1] += u32Cpu
+        lStats[2] += u32Uart
+        self.u64CpuFree += u32Cpu + u32Uart
+
+    def Pass(self):
+        """One pass of the main loop in app_start.c"""
+        self.bPassScheduled = False
+        self.u64CpuFree = max(self.u64CpuFree, self.u64Now)
+        self.Work("loop", COSTS["loop"])
+
+        # zps_taskZPS, stack events posted to the BDB queue, each taking an APDU
+        while self.lMcps and len(self.lBdb) < BDB_QUEUE_SIZE:
+            (u64Origin, sKind, u16Address) = self.lMcps.pop(0)
+            self.oMcps.Give(self.u64CpuFree)
+            self.Work("zps_rx", COSTS["zps_rx"])
+            self.oNpdu.Give(self.u64CpuFree)
+            if sKind != "aps_ack" and not self.oApdu.Take(self.u64CpuFree):
+                self.nDropped += 1
+                continue
+            self.oBdb.Take(self.u64CpuFree)
+            self.lBdb.append((u64Origin, sKind, u16Address))
+
+        # bdb_taskBDB, the application handlers
+        while self.lBdb:
+            (u64Origin, sKind, u16Address) = self.lBdb.pop(0)
+            self.oBdb.Give(self.u64CpuFree)
+            self.Handle(u64Origin, sKind, u16Address)
+            if sKind != "aps_ack":
+                self.oApdu.Give(self.u64CpuFree)
+
+        # APP_vProcessRxData
+        while self.lHostRx:
+            (u16Type, u16Address, nBytes) = self.lHostRx.pop(0)
+            for _ in range(nBytes):
+                self.oHostRx.Give(self.u64CpuFree)
+            self.Work("host_command", COSTS["host_command"] + nBytes * COSTS["host_byte"], (E_SL_MSG_STATUS,))
+            self.lApsQueue.append((u16Type, u16Address))
+            if not self.oApsQueue.Take(self.u64CpuFree):
+                self.lApsQueue.pop()
+                self.nRefused += 1
+
+        # APP_vApsQueueService
+        while self.lApsQueue and self.oInFlight.nValue < self.oInFlight.nLimit:
+            if not self.oApdu.Take(self.u64CpuFree):
+                break
+            if not self.oNpdu.Take(self.u64CpuFree):
+                self.oApdu.Give(self.u64CpuFree)
+                break
+            (u16Type, u16Address) = self.lApsQueue.pop(0)
+            self.oApsQueue.Give(self.u64CpuFree)
+            self.oInFlight.Take(self.u64CpuFree)
+            self.Work("aps_tx", COSTS["aps_tx"])
+            self.At(self.u64CpuFree, self.NodeSend, u16Type, u16Address)
+
+        if self.lMcps or self.lHostRx or (self.lApsQueue and self.oInFlight.nValue < self.oInFlight.nLimit):
+            self.Wake()
+
+    def Handle(self, u64Origin, sKind, u16Address):
+        if sKind == "report":
+            self.Work("report", COSTS["report"], (E_SL_MSG_REPORT_IND_ATTR_RESPONSE,), u16Address, u64Origin)
+        elif sKind == "read_response":
+            self.Work("read_response", COSTS["read_response"], (E_SL_MSG_READ_ATTRIBUTE_RESPONSE,), u16Address, u64Origin)
+        elif sKind == "announce":
+            self.Work("announce", COSTS["announce"], (E_SL_MSG_DEVICE_ANNOUNCE,), u16Address, u64Origin)
+        elif sKind == "active_ep":
+            self.Work("zdp_response", COSTS["zdp_response"], (E_SL_MSG_ACTIVE_ENDPOINT_RESPONSE,), u16Address, u64Origin)
+        elif sKind == "simple_desc":
+            self.Work("zdp_response", COSTS["zdp_response"], (E_SL_MSG_SIMPLE_DESCRIPTOR_RESPONSE,), u16Address, u64Origin)
+        elif sKind == "block_request":
+            self.Work("block_request", COSTS["block_request"], (E_SL_MSG_BLOCK_REQUEST,), u16Address, u64Origin)
+        elif sKind == "aps_ack":
+            self.Work("aps_ack", COSTS["aps_ack"], (E_SL_MSG_APS_DATA_ACK,), u16Address)
+            self.oApdu.Give(self.u64CpuFree)
+            self.oInFlight.Give(self.u64CpuFree)
+            self.Wake()
+
+    def NodeSend(self, u16Type, u16Address):
+        """A host command leaves the node, the NPDU is freed on the MAC confirm and the APDU on the
+           APS ack, with the device's answer following"""
+        nPayload = len(HostCommand(u16Type, u16Address))
+        u64Received = self.Air(nPayload)
+        self.At(u64Received, self.NpduFree)
+        self.At(u64Received + DEVICE_TURNAROUND_US // 4, self.DeviceSend, "aps_ack", u16Address, 5)
+        if u16Type == E_SL_MSG_ACTIVE_ENDPOINT_REQUEST:
+            self.At(u64Received + DEVICE_TURNAROUND_US, self.DeviceSend, "active_ep", u16Address, 6)
+        elif u16Type == E_SL_MSG_SIMPLE_DESCRIPTOR_REQUEST:
+            self.At(u64Received + DEVICE_TURNAROUND_US, self.DeviceSend, "simple_desc", u16Address, 32)
+        elif u16Type == E_SL_MSG_READ_ATTRIBUTE_REQUEST:
+            self.At(u64Received + DEVICE_TURNAROUND_US, self.DeviceSend, "read_response", u16Address, 12)
+        elif u16Type == E_SL_MSG_BLOCK_SEND:
+            self.nOtaBlocks += 1
+            self.At(u64Received + self.oOptions.block_delay * 1000, self.OtaRequest, u16Address)
+
+    def NpduFree(self):
+        self.oNpdu.Give(self.u64Now)
+        self.Wake()
+
+    # Host
+    def HostReceive(self, u16Type, u16Address):
+        if u16Type == E_SL_MSG_STATUS:
+            self.bHostWaiting = False
+        elif u16Type == E_SL_MSG_DEVICE_ANNOUNCE:
+            self.HostQueue(E_SL_MSG_ACTIVE_ENDPOINT_REQUEST, u16Address)
+        elif u16Type == E_SL_MSG_ACTIVE_ENDPOINT_RESPONSE:
+            self.HostQueue(E_SL_MSG_SIMPLE_DESCRIPTOR_REQUEST, u16Address)
+        elif u16Type == E_SL_MSG_BLOCK_REQUEST:
+            self.HostQueue(E_SL_MSG_BLOCK_SEND, u16Address)
+        self.HostSend()
+
+    def HostQueue(self, u16Type, u16Address):
+        self.lHostPending.append((self.u64Now, u16Type, u16Address))
+        self.oHostPending.Set(self.u64Now, len(self.lHostPending))
+
+    def HostSend(self):
+        """SerialLink.py waits for the status of one command before sending the next"""
+        if self.bHostWaiting or not self.lHostPending:
+            return
+        (u64Queued, u16Type, u16Address) = self.lHostPending.pop(0)
+        self.oHostPending.Set(self.u64Now, len(self.lHostPending))
+        self.bHostWaiting = True
+        nBytes = SlFrameBytes(u16Type, HostCommand(u16Type, u16Address))
+        u64Start = max(self.u64Now + HOST_TURNAROUND_US, self.u64UartRxFree)
+        self.u64UartRxFree = u64Start + nBytes * 10 * 1000000 // UART_BAUD_RATE
+        self.u64UartRxBytes += nBytes
+        self.dLatency.setdefault(u16Type, []).append(self.u64UartRxFree - u64Queued)
+        self.At(self.u64UartRxFree, self.NodeReceive, u16Type, u16Address, nBytes)
+
+    def NodeReceive(self, u16Type, u16Address, nBytes):
+        for _ in range(nBytes):
+            if not self.oHostRx.Take(self.u64Now):
+                self.nDropped += 1
+                return
+        self.lHostRx.append((u16Type, u16Address, nBytes))
+        self.Wake()
+
+    # Devices
+    def DeviceReport(self, u16Address):
+        self.DeviceSend("report", u16Address, 14)
+        self.At(self.u64Now + int(self.oRandom.uniform(0.9, 1.1) * self.oOptions.report_interval * 1000000),
+                self.DeviceReport, u16Address)
+
+    def Poll(self):
+        self.HostQueue(E_SL_MSG_READ_ATTRIBUTE_REQUEST, 0x1000 + RandInt(self.oRandom, 0, self.nDevices - 1))
+        self.HostSend()
+        self.At(self.u64Now + int(self.oRandom.expovariate(self.oOptions.reads) * 1000000), self.Poll)
+
+    def OtaRequest(self, u16Address):
+        self.DeviceSend("block_request", u16Address, 28)
+
+    def Start(self):
+        for i in range(self.nDevices):
+            u16Address = 0x1000 + i
+            self.At(int(self.oRandom.uniform(0, self.oOptions.report_interval) * 1000000), self.DeviceReport, u16Address)
+            if self.oOptions.rejoin:
+                self.At(int(self.oRandom.uniform(0, self.oOptions.rejoin) * 1000000),
+                        self.DeviceSend, "announce", u16Address, 12)
+        for i in range(min(self.oOptions.ota, self.nDevices)):
+            self.At(int(self.oRandom.uniform(0, 1) * 1000000), self.OtaRequest, 0x1000 + i)
+        if self.oOptions.reads > 0:
+            self.At(0, self.Poll)
+
+    def PrintReport(self, oOut):
+        u64Now = self.u64Now
+        fSeconds = u64Now / 1e6
+        oOut.write("\n%d devices, %.0f s\n" % (self.nDevices, fSeconds))
+        oOut.write("  UART to host   %7d bytes/s  %5.1f%% of the link, CPU blocked writing\n" % (
+            self.u64UartTxBytes / fSeconds, 100.0 * self.u64UartTxBusy / u64Now))
+        oOut.write("  UART from host %7d bytes/s  %5.1f%% of the link\n" % (
+            self.u64UartRxBytes / fSeconds, 100.0 * self.u64UartRxBytes * 10 / UART_BAUD_RATE / fSeconds))
+        oOut.write("  radio          %5.1f%% of air time, %d OTA blocks sent\n" % (
+            100.0 * self.u64RadioBusy / u64Now, self.nOtaBlocks))
+        oOut.write("  %-14s %6s %6s %6s %8s\n" % ("queue/pool", "size", "peak", "mean", "full"))
+        for (sName, oGauge) in (("MCPS queue", self.oMcps), ("NPDU", self.oNpdu), ("APDU", self.oApdu),
+                                ("BDB queue", self.oBdb), ("serial rx", self.oHostRx),
+                                ("APS queue", self.oApsQueue), ("APS in flight", self.oInFlight)):
+            oOut.write("  %-14s %6d %6d %6.1f %8d\n" % (sName, oGauge.nLimit, oGauge.nPeak, oGauge.Mean(u64Now), oGauge.nFull))
+        oOut.write("  %-14s %6s %6d %6.1f\n" % ("host backlog", "-", self.oHostPending.nPeak, self.oHostPending.Mean(u64Now)))
+        oOut.write("  frames lost    %d, host commands refused %d\n" % (self.nDropped, self.nRefused))
+        # Messages to the host are timed from the frame's first transmission, commands from the
+        # host being ready to send them
+        oOut.write("  %-32s %7s %8s %8s %8s %8s\n" % ("latency ms", "count", "p50", "p90", "p99", "max"))
+        dNames = dict((v, k[len("E_SL_MSG_"):]) for (k, v) in globals().items() if k.startswith("E_SL_MSG_"))
+        for u16Type in sorted(self.dLatency):
+            lValues = sorted(self.dLatency[u16Type])
+            oOut.write("  %-32s %7d %8.1f %8.1f %8.1f %8.1f\n" % (
+                dNames.get(u16Type, "0x%04x" % u16Type)[:32], len(lValues), Percentile(lValues, 0.5) / 1e3,
+                Percentile(lValues, 0.9) / 1e3, Percentile(lValues, 0.99) / 1e3, lValues[-1] / 1e3))
+        oOut.write("  %-14s %8s %10s %8s %10s %6s\n" % ("CPU", "events", "cpu ms", "us/event", "uart ms", "busy"))
+        for sType in sorted(self.dCpu, key=lambda s: -(self.dCpu[s][1] + self.dCpu[s][2])):
+            (nCount, u64Cpu, u64Uart) = self.dCpu[sType]
+            oOut.write("  %-14s %8d %10.1f %8.1f %10.1f %5.1f%%\n" % (
+                sType, nCount, u64Cpu / 1e3, float(u64Cpu) / nCount, u64Uart / 1e3,
+                100.0 * (u64Cpu + u64Uart) / u64Now))
+
+
+def main(argv):
+    oParser = optparse.OptionParser(usage="%prog [options]")
+    oParser.add_option("-n", "--devices", default="50,100,200", help="comma separated network sizes")
+    oParser.add_option("-d", "--duration", type="float", default=60, help="simulated seconds")
+    oParser.add_option("-i", "--report-interval", type="float", default=10, help="seconds between reports per device")
+    oParser.add_option("-j", "--rejoin", type="float", default=0,
+                       help="all devices announce within this many seconds and are interviewed by the host")
+    oParser.add_option("-o", "--ota", type="int", default=0, help="devices fetching an OTA image through the host")
+    oParser.add_option("-b", "--block-delay", type="int", default=0, help="ms a device waits between OTA blocks")
+    oParser.add_option("-r", "--reads", type="float", default=0, help="attribute reads per second from the host")
+    oParser.add_option("-c", "--cost", action="append", default=[], help="CPU cost override, name=us")
+    oParser.add_option("-s", "--seed", type="int", default=1, help="random seed")
+    (oOptions, lArgs) = oParser.parse_args(argv)
+    if lArgs:
+        oParser.error("unexpected arguments")
+
+    for sCost in oOptions.cost:
+        (sName, _, sValue) = sCost.partition("=")
+        if sName not in COSTS or not sValue.isdigit():
+            oParser.error("--cost takes name=us, name one of %s" % ", ".join(sorted(COSTS)))
+        COSTS[sName] = int(sValue)
+
+    for sDevices in oOptions.devices.split(","):
+        oSim = cSim(oOptions, int(sDevices))
+        oSim.Start()
+        oSim.Run(int(oOptions.duration * 1000000))
+        oSim.PrintReport(sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
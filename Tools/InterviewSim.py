@@ -0,0 +1,212 @@
+#*****************************************************************************
+#*
+# * MODULE:             ZigBee Control Bridge
+# *
+# * COMPONENT:          InterviewSim.py
+# *
+# * DESCRIPTION:        Host side simulation of the interview of newly joined
+# *                     devices, driven one request at a time by the host or
+# *                     pipelined by app_device_interview.c, against virtual
+# *                     sleepy devices with a fast poll window after joining.
+# *                     Source/HostSim/Tests/test_device_interview.c runs the
+# *                     same device kinds through app_device_interview.c.
+# *
+# *****************************************************************************
+import sys
+import heapq
+import random
+import optparse
+
+# Mirrors app_device_interview.h
+DEVICE_INTERVIEW_MAX_OUTSTANDING = 2
+DEVICE_INTERVIEW_RETRIES = 2
+DEVICE_INTERVIEW_RX_ON_TIMEOUT = 2.0
+DEVICE_INTERVIEW_SLEEPY_TIMEOUT = 8.0
+DEVICE_INTERVIEW_MAX_DURATION = 60.0
+DEVICE_INTERVIEW_BASIC_READS = 2
+
+# Time a frame for a sleepy child waits at its parent for the next poll
+INDIRECT_HOLD = 7.68
+# Poll interval inside the fast poll window
+FAST_POLL = 0.25
+# Air, stack and response time of one request
+ROUND_TRIP = 0.05
+
+# Devices as (share of the network, fast poll window range, slow poll interval range, endpoints range);
+# a slow poll of 0 keeps the receiver on
+DEVICES = {
+    "router"     : (0.30, (0, 0),   (0, 0),       (1, 2)),
+    "sensor"     : (0.30, (5, 15),  (20, 60),     (1, 2)),
+    "button"     : (0.15, (2, 6),   (300, 3600),  (1, 3)),
+    "thermostat" : (0.10, (10, 30), (5, 10),      (1, 1)),
+    "lock"       : (0.15, (5, 10),  (2, 5),       (1, 1)),
+}
+
+
+class cDevice(object):
+    """A device that announced itself at time 0, then polls its parent quickly for its wake window and
+       slowly after it; a router keeps its receiver on"""
+    def __init__(self, oRandom, sKind, fLoss):
+        (_, tWindow, tPoll, tEndpoints) = DEVICES[sKind]
+        self.sKind = sKind
+        self.bRxOn = tPoll[1] == 0
+        self.fWindow = oRandom.uniform(*tWindow)
+        self.fPoll = oRandom.uniform(*tPoll)
+        self.fPhase = oRandom.uniform(0, self.fPoll) if self.fPoll else 0
+        self.nEndpoints = oRandom.randint(*tEndpoints)
+        self.fLoss = fLoss
+        self.oRandom = oRandom
+
+    def NextPoll(self, fTime):
+        if fTime <= self.fWindow:
+            return (int(fTime / FAST_POLL) + 1) * FAST_POLL
+        nPolls = int((fTime - self.fWindow - self.fPhase) / self.fPoll) + 1
+        return self.fWindow + self.fPhase + max(nPolls, 0) * self.fPoll
+
+    def Request(self, fTime):
+        """Time the response to a request sent at fTime reaches the coordinator, or None when it is lost"""
+        if self.oRandom.random() < self.fLoss or self.oRandom.random() < self.fLoss:
+            return None
+        if self.bRxOn:
+            return fTime + ROUND_TRIP
+        fPoll = self.NextPoll(fTime)
+        if fPoll - fTime > INDIRECT_HOLD:
+            return None
+        return fPoll + ROUND_TRIP
+
+
+class cStep(object):
+    def __init__(self, sKind, lAfter):
+        self.sKind = sKind
+        self.lAfter = lAfter
+        self.nAttempts = 0
+        self.nSent = None
+        self.bDone = False
+        self.bFailed = False
+
+
+def Interview(oDevice, nOutstanding, fHostLatency, fTimeout, nRetries, fDeadline):
+    """Runs one interview: node descriptor and active endpoints, a simple descriptor per endpoint after
+       the active endpoints, then the Basic reads after the first simple descriptor. At most nOutstanding
+       requests are on air, and each is sent fHostLatency after it became ready, the time a host
+       needs to see the previous answer over the serial link and act on it.
+       Returns (every request answered, time of the last answer, requests sent)"""
+    oNode = cStep("node", [])
+    oActive = cStep("active", [])
+    lSimple = [cStep("simple", [oActive]) for _ in range(oDevice.nEndpoints)]
+    lBasic = [cStep("basic", [oActive, lSimple[0]]) for _ in range(DEVICE_INTERVIEW_BASIC_READS)]
+    lSteps = [oNode, oActive] + lBasic + lSimple
+
+    lEvents = []
+    nSeq = 0
+    nRequests = 0
+    fNow = 0.0
+    fLast = 0.0
+    # A step is ready to go once what it needs is in
+    dReadyAt = {}
+    while True:
+        for oStep in lSteps:
+            if (not oStep.bDone and not oStep.bFailed and oStep.nSent is None and oStep not in dReadyAt and
+                    all(oAfter.bDone for oAfter in oStep.lAfter)):
+                dReadyAt[oStep] = fNow + fHostLatency
+            if any(oAfter.bFailed for oAfter in oStep.lAfter) and not oStep.bDone:
+                oStep.bFailed = True
+        nOnAir = sum(1 for oStep in lSteps if oStep.nSent is not None)
+        for oStep in lSteps:
+            if nOnAir >= nOutstanding:
+                break
+            if oStep in dReadyAt and dReadyAt[oStep] <= fNow and oStep.nSent is None and not oStep.bFailed:
+                del dReadyAt[oStep]
+                nSeq += 1
+                nRequests += 1
+                oStep.nSent = nSeq
+                oStep.nAttempts += 1
+                nOnAir += 1
+                fResponse = oDevice.Request(fNow)
+                if fResponse is not None:
+                    heapq.heappush(lEvents, (fResponse, nSeq, "response", oStep))
+                heapq.heappush(lEvents, (fNow + fTimeout, nSeq, "timeout", oStep))
+        if all(oStep.bDone or oStep.bFailed for oStep in lSteps):
+            break
+        fNext = min([fTime for fTime in dReadyAt.values() if fTime > fNow] +
+                    [lEvents[0][0] if lEvents else fDeadline])
+        if fNext >= fDeadline:
+            break
+        fNow = fNext
+        while lEvents and lEvents[0][0] <= fNow:
+            (fTime, nEventSeq, sEvent, oStep) = heapq.heappop(lEvents)
+            if oStep.nSent != nEventSeq:
+                continue
+            oStep.nSent = None
+            if sEvent == "response":
+                oStep.bDone = True
+                fLast = fTime
+            elif oStep.nAttempts > nRetries:
+                oStep.bFailed = True
+            else:
+                dReadyAt[oStep] = fNow + fHostLatency
+    bComplete = all(oStep.bDone for oStep in lSteps)
+    return (bComplete, fLast, nRequests)
+
+
+def main(argv):
+    oParser = optparse.OptionParser(usage="%prog [options] [device kind...]")
+    oParser.add_option("-d", "--devices", type="int", default=2000, help="devices per kind")
+    oParser.add_option("-l", "--latency", type="float", default=0.6,
+                       help="host time from one answer to the next request, seconds")
+    oParser.add_option("-t", "--host-timeout", type="float", default=DEVICE_INTERVIEW_SLEEPY_TIMEOUT,
+                       help="host response timeout, seconds")
+    oParser.add_option("-p", "--loss", type="float", default=0.02, help="frame loss each way")
+    oParser.add_option("-r", "--seed", type="int", default=1, help="random seed")
+    (oOptions, lArgs) = oParser.parse_args(argv)
+
+    lKinds = lArgs or sorted(DEVICES)
+    for sKind in lKinds:
+        if sKind not in DEVICES:
+            oParser.error("unknown device kind %s, one of %s" % (sKind, ", ".join(sorted(DEVICES))))
+
+    print "%-11s %20s %20s" % ("", "host driven", "pipelined")
+    print "%-11s %8s %6s %4s %8s %6s %4s" % ("device", "success", "time", "req", "success", "time", "req")
+    dTotal = {"host" : [0, 0.0, 0], "node" : [0, 0.0, 0]}
+    nTotal = 0
+    for sKind in lKinds:
+        dResult = {"host" : [0, 0.0, 0], "node" : [0, 0.0, 0]}
+        for i in xrange(oOptions.devices):
+            # The same device and radio luck for both
+            nSeed = oOptions.seed * 1000003 + i * 31 + hash(sKind) % 997
+            for (sWho, nOutstanding, fLatency, fTimeout) in (
+                    ("host", 1, oOptions.latency, oOptions.host_timeout),
+                    ("node", DEVICE_INTERVIEW_MAX_OUTSTANDING, 0.0, None)):
+                oRandom = random.Random(nSeed)
+                oDevice = cDevice(oRandom, sKind, oOptions.loss)
+                if fTimeout is None:
+                    fTimeout = DEVICE_INTERVIEW_RX_ON_TIMEOUT if oDevice.bRxOn else DEVICE_INTERVIEW_SLEEPY_TIMEOUT
+                (bComplete, fTime, nRequests) = Interview(oDevice, nOutstanding, fLatency, fTimeout,
+                                                          DEVICE_INTERVIEW_RETRIES, DEVICE_INTERVIEW_MAX_DURATION)
+                if bComplete:
+                    dResult[sWho][0] += 1
+                    dResult[sWho][1] += fTime
+                dResult[sWho][2] += nRequests
+        lLine = []
+        for sWho in ("host", "node"):
+            (nComplete, fTime, nRequests) = dResult[sWho]
+            lLine += [100.0 * nComplete / oOptions.devices, fTime / max(nComplete, 1),
+                      float(nRequests) / oOptions.devices]
+            fShare = DEVICES[sKind][0]
+            dTotal[sWho][0] += fShare * nComplete
+            dTotal[sWho][1] += fShare * fTime
+            dTotal[sWho][2] += fShare * nRequests
+        nTotal += DEVICES[sKind][0] * oOptions.devices
+        print "%-11s %7.1f%% %5.1fs %4.1f %7.1f%% %5.1fs %4.1f" % tuple([sKind] + lLine)
+
+    if len(lKinds) > 1:
+        lLine = []
+        for sWho in ("host", "node"):
+            (fComplete, fTime, fRequests) = dTotal[sWho]
+            lLine += [100.0 * fComplete / nTotal, fTime / max(fComplete, 1), fRequests / nTotal]
+        print "%-11s %7.1f%% %5.1fs %4.1f %7.1f%% %5.1fs %4.1f" % tuple(["network"] + lLine)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,361 @@
+#*****************************************************************************
+#*
+# * MODULE:             ZigBee Control Bridge
+# *
+# * COMPONENT:          MemoryBudget.py
+# *
+# * DESCRIPTION:        Memory budget report from a GNU linker map. Sizes
+# *                     are attributed to modules (application, ZCL, ZPS,
+# *                     framework, toolchain), written as JSON, compared
+# *                     with a baseline report and checked against the
+# *                     budgets of a configuration file.
+# *
+# *                     Usage:
+# *                     MemoryBudget.py [--log build.log] [--json out.json]
+# *                                     [--baseline old.json]
+# *                                     [--budget MemoryBudget.cfg] image.map
+# *
+# *                     Exits with 2 when a budget is exceeded.
+# *
+# *****************************************************************************
+from __future__ import print_function
+
+import sys
+import re
+import os
+import json
+import optparse
+
+# Output regions by memory class, matched against the Memory Configuration names
+REGION_CLASSES = (
+    (re.compile(r"^Flash", re.I), "flash"),
+    (re.compile(r"^(RAM1|RAM2)$", re.I), "ram1"),
+    (re.compile(r"^(RAM0|RAM)$", re.I), "ram"),
+)
+
+# Symbol ending the RAM0 sections that must be kept through sleep
+RETENTION_END_SYMBOL = "_end_fw_retention"
+
+# Modules by object, archive member or source path, first match wins
+MODULES = (
+    ("toolchain",   re.compile(r"(^|[/\\])(libc|libc_nano|libgcc|libm|libnosys|libcr_\w*|crt\w*)(\.a|\.o)", re.I)),
+    ("zps",         re.compile(r"libZPS|libPDUM|MiniMac|libmMac|ZigbeeCommon|zps_gen|pdum_gen|[/\\]ieee-802\.15\.4[/\\]", re.I)),
+    ("zcl",         re.compile(r"[/\\](ZCL|ZCIF|BDB)[/\\]|libZCL", re.I)),
+    ("framework",   re.compile(r"[/\\](framework|devices|drivers|utilities|startup|board|CMSIS)[/\\]|libconnfwk|libPDM|libSecLib|libRadio|libfsl|libNVM", re.I)),
+    ("nci",         re.compile(r"nci|libNtag", re.I)),
+    ("application", re.compile(r"[/\\](ControlBridge|Common)[/\\]|\.o$", re.I)),
+)
+
+# Section name prefixes stripped to give the symbol of a -ffunction-sections / -fdata-sections input
+SECTION_PREFIXES = (".text.", ".rodata.", ".data.", ".bss.", ".noinit.", ".mac_buffer.")
+
+RE_OUTPUT = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?\s*$")
+RE_OUTPUT_NAME = re.compile(r"^([^\s*]\S*)\s*$")
+RE_INPUT = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(.*)$")
+RE_INPUT_NAME = re.compile(r"^ ([^\s*]\S*|\*fill\*)\s*$")
+RE_CONTINUED = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(.*)$")
+RE_SYMBOL = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$]*)\s*$")
+RE_ASSIGNMENT = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+(?:PROVIDE \()?([A-Za-z_.$][\w.$]*)\s*=")
+RE_REGION = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+
+
+class cMapError(Exception):
+    pass
+
+
+def ReadLog(sLogFile):
+    """Object to source path from the build .log, lines of 'object source'"""
+    dSource = {}
+    if sLogFile and os.path.exists(sLogFile):
+        for sLine in open(sLogFile):
+            lFields = sLine.split()
+            if len(lFields) == 2:
+                dSource[os.path.basename(lFields[0])] = lFields[1]
+    return dSource
+
+
+def Module(sInput, dSource):
+    """Module owning an input file, '<path>/libX.a(member.o)' or '<path>/obj.o'"""
+    sSource = dSource.get(os.path.basename(sInput), "")
+    for (sModule, oPattern) in MODULES:
+        if (sSource and oPattern.search(sSource)) or oPattern.search(sInput):
+            return sModule
+    return "other"
+
+
+def ObjectName(sInput):
+    """Short object name, member of an archive or object file name"""
+    oMatch = re.search(r"([^/\\()]+)\(([^()]+)\)\s*$", sInput)
+    if oMatch:
+        return "%s(%s)" % (oMatch.group(1), oMatch.group(2))
+    return os.path.basename(sInput.strip())
+
+
+class cMap(object):
+    """Parsed GNU ld map: regions, output sections and the input sections and symbols in them"""
+    def __init__(self, sMapFile, dSource):
+        self.dRegions = {}
+        self.lOutputs = []
+        self.u32RetentionEnd = None
+        self.dSource = dSource
+        self.Parse(sMapFile)
+
+    def RegionOf(self, u32Address):
+        for (sName, (u32Origin, u32Length)) in self.dRegions.items():
+            if u32Origin <= u32Address < u32Origin + u32Length and sName != "*default*":
+                return sName
+        return None
+
+    def ClassOf(self, sRegion):
+        if sRegion is not None:
+            for (oPattern, sClass) in REGION_CLASSES:
+                if oPattern.match(sRegion):
+                    return sClass
+        return None
+
+    def Parse(self, sMapFile):
+        lLines = open(sMapFile).read().splitlines()
+        i = 0
+        # Memory Configuration table
+        while i < len(lLines) and not lLines[i].startswith("Memory Configuration"):
+            i += 1
+        while i < len(lLines) and not lLines[i].startswith("Linker script and memory map"):
+            oMatch = RE_REGION.match(lLines[i])
+            if oMatch:
+                self.dRegions[oMatch.group(1)] = (int(oMatch.group(2), 16), int(oMatch.group(3), 16))
+            i += 1
+        if i >= len(lLines) or not self.dRegions:
+            raise cMapError("%s is not a GNU ld map file" % sMapFile)
+
+        dOutput = None
+        dInput = None
+        while i < len(lLines):
+            sLine = lLines[i]
+            i += 1
+            if sLine.startswith("OUTPUT(") or sLine.startswith("Cross Reference Table"):
+                break
+            # Names too long for their column continue on the next line
+            oName = RE_OUTPUT_NAME.match(sLine) or RE_INPUT_NAME.match(sLine)
+            if oName and i < len(lLines) and RE_CONTINUED.match(lLines[i]):
+                sLine = sLine.rstrip() + " " + lLines[i].strip()
+                i += 1
+            if sLine and not sLine[0].isspace():
+                oMatch = RE_OUTPUT.match(sLine)
+                if oMatch:
+                    u32Address = int(oMatch.group(2), 16)
+                    dOutput = {"name"    : oMatch.group(1),
+                               "address" : u32Address,
+                               "size"    : int(oMatch.group(3), 16),
+                               "load"    : int(oMatch.group(4), 16) if oMatch.group(4) else None,
+                               "inputs"  : []}
+                    dOutput["region"] = self.RegionOf(u32Address)
+                    dOutput["load_region"] = self.RegionOf(dOutput["load"]) if dOutput["load"] is not None else None
+                    self.lOutputs.append(dOutput)
+                    dInput = None
+                continue
+            oMatch = RE_ASSIGNMENT.match(sLine)
+            if oMatch:
+                if oMatch.group(2) == RETENTION_END_SYMBOL:
+                    self.u32RetentionEnd = int(oMatch.group(1), 16)
+                continue
+            if dOutput is None:
+                continue
+            oMatch = RE_INPUT.match(sLine)
+            if oMatch and not sLine.startswith(" *("):
+                dInput = {"section" : oMatch.group(1),
+                          "address" : int(oMatch.group(2), 16),
+                          "size"    : int(oMatch.group(3), 16),
+                          "file"    : oMatch.group(4).strip(),
+                          "symbols" : []}
+                dOutput["inputs"].append(dInput)
+                continue
+            oMatch = RE_SYMBOL.match(sLine)
+            if oMatch and dInput is not None:
+                dInput["symbols"].append((int(oMatch.group(1), 16), oMatch.group(2)))
+
+    def Report(self):
+        """Sizes by memory class and module, and the size of every symbol"""
+        dTotals = {}
+        dModules = {}
+        dSymbols = {}
+
+        def Add(sClass, sModule, u32Size):
+            dTotals[sClass] = dTotals.get(sClass, 0) + u32Size
+            dModule = dModules.setdefault(sModule, {})
+            dModule[sClass] = dModule.get(sClass, 0) + u32Size
+
+        for dOutput in self.lOutputs:
+            sClass = self.ClassOf(dOutput["region"])
+            sLoadClass = self.ClassOf(dOutput["load_region"])
+            if sClass is None or dOutput["size"] == 0:
+                continue
+            u32Attributed = 0
+            for dInput in dOutput["inputs"]:
+                if dInput["size"] == 0:
+                    continue
+                u32Attributed += dInput["size"]
+                if dInput["section"] == "*fill*" or not dInput["file"]:
+                    sModule = "padding"
+                else:
+                    sModule = Module(dInput["file"], self.dSource)
+                Add(sClass, sModule, dInput["size"])
+                if sLoadClass is not None and sLoadClass != sClass:
+                    Add(sLoadClass, sModule, dInput["size"])
+                if sModule != "padding":
+                    self.AddSymbols(dSymbols, dOutput, dInput, sClass, sModule)
+            # Space reserved by the script itself, heap and stacks
+            if dOutput["size"] > u32Attributed:
+                Add(sClass, "reserved", dOutput["size"] - u32Attributed)
+
+        if self.u32RetentionEnd is not None:
+            for (sName, (u32Origin, u32Length)) in self.dRegions.items():
+                if self.ClassOf(sName) == "ram" and u32Origin <= self.u32RetentionEnd <= u32Origin + u32Length:
+                    dTotals["retained_ram"] = self.u32RetentionEnd - u32Origin
+
+        dRegions = dict((sName, {"origin" : u32Origin, "length" : u32Length})
+                        for (sName, (u32Origin, u32Length)) in self.dRegions.items() if sName != "*default*")
+        return {"regions" : dRegions, "totals" : dTotals, "modules" : dModules, "symbols" : dSymbols}
+
+    def AddSymbols(self, dSymbols, dOutput, dInput, sClass, sModule):
+        """A symbol spans up to the next symbol in its input section; a section holding
+           no listed symbol is named after its -ffunction-sections / -fdata-sections suffix"""
+        sObject = ObjectName(dInput["file"])
+        lSymbols = sorted(dInput["symbols"])
+        if not lSymbols:
+            sName = dInput["section"]
+            for sPrefix in SECTION_PREFIXES:
+                if sName.startswith(sPrefix):
+                    sName = sName[len(sPrefix):]
+                    break
+            lSymbols = [(dInput["address"], sName)]
+        u32End = dInput["address"] + dInput["size"]
+        for (j, (u32Address, sName)) in enumerate(lSymbols):
+            u32Next = lSymbols[j + 1][0] if j + 1 < len(lSymbols) else u32End
+            sKey = "%s:%s" % (sObject, sName)
+            dSymbol = dSymbols.setdefault(sKey, {"module" : sModule, "memory" : sClass,
+                                                 "section" : dOutput["name"], "size" : 0})
+            dSymbol["size"] += max(0, u32Next - u32Address)
+
+
+def Diff(dReport, dBaseline, nTop):
+    """Growth against a baseline report"""
+    dTotals = {}
+    for sClass in set(dReport["totals"]) | set(dBaseline["totals"]):
+        dTotals[sClass] = dReport["totals"].get(sClass, 0) - dBaseline["totals"].get(sClass, 0)
+    dModules = {}
+    for sModule in set(dReport["modules"]) | set(dBaseline["modules"]):
+        dNew = dReport["modules"].get(sModule, {})
+        dOld = dBaseline["modules"].get(sModule, {})
+        dDelta = dict((sClass, dNew.get(sClass, 0) - dOld.get(sClass, 0)) for sClass in set(dNew) | set(dOld))
+        if any(dDelta.values()):
+            dModules[sModule] = dDelta
+    lSymbols = []
+    for sKey in set(dReport["symbols"]) | set(dBaseline["symbols"]):
+        u32New = dReport["symbols"].get(sKey, {}).get("size", 0)
+        u32Old = dBaseline["symbols"].get(sKey, {}).get("size", 0)
+        if u32New != u32Old:
+            dSymbol = dReport["symbols"].get(sKey) or dBaseline["symbols"][sKey]
+            lSymbols.append({"symbol" : sKey, "memory" : dSymbol["memory"], "module" : dSymbol["module"],
+                             "old" : u32Old, "new" : u32New, "delta" : u32New - u32Old})
+    lSymbols.sort(key=lambda d: (-abs(d["delta"]), d["symbol"]))
+    return {"totals" : dTotals, "modules" : dModules, "symbols" : lSymbols[:nTop]}
+
+
+def ReadBudget(sBudgetFile):
+    """Budget lines of '<memory> <bytes>' or 'module.<module>.<memory> <bytes>', # comments"""
+    lBudgets = []
+    for (nLine, sLine) in enumerate(open(sBudgetFile)):
+        sLine = sLine.split("#", 1)[0].strip()
+        if not sLine:
+            continue
+        lFields = sLine.split()
+        if len(lFields) != 2:
+            raise cMapError("%s:%d: expected '<name> <bytes>'" % (sBudgetFile, nLine + 1))
+        lBudgets.append((lFields[0], int(lFields[1], 0)))
+    return lBudgets
+
+
+def CheckBudget(dReport, lBudgets):
+    """Returns [(name, used, budget)] for every budget, exceeded ones marked by used > budget"""
+    lResults = []
+    for (sName, u32Budget) in lBudgets:
+        lParts = sName.split(".")
+        if len(lParts) == 3 and lParts[0] == "module":
+            u32Used = dReport["modules"].get(lParts[1], {}).get(lParts[2], 0)
+        else:
+            u32Used = dReport["totals"].get(sName, 0)
+        lResults.append((sName, u32Used, u32Budget))
+    return lResults
+
+
+def PrintReport(dReport, nTop):
+    lClasses = sorted(dReport["totals"])
+    print("%-14s" % "" + "".join("%14s" % sClass for sClass in lClasses))
+    print("%-14s" % "total" + "".join("%14d" % dReport["totals"][sClass] for sClass in lClasses))
+    for sModule in sorted(dReport["modules"]):
+        print("%-14s" % sModule + "".join("%14d" % dReport["modules"][sModule].get(sClass, 0)
+                                          for sClass in lClasses if sClass != "retained_ram"))
+    for sClass in ("ram", "ram1", "flash"):
+        lSymbols = sorted(((d["size"], sKey, d["module"]) for (sKey, d) in dReport["symbols"].items()
+                           if d["memory"] == sClass), reverse=True)[:nTop]
+        if lSymbols:
+            print("Largest in %s:" % sClass)
+            for (u32Size, sKey, sModule) in lSymbols:
+                print("  %8d  %-12s %s" % (u32Size, sModule, sKey))
+
+
+def PrintDiff(dDiff):
+    print("Against baseline:")
+    for sClass in sorted(dDiff["totals"]):
+        print("  %-14s %+d" % (sClass, dDiff["totals"][sClass]))
+    for sModule in sorted(dDiff["modules"]):
+        print("  %-14s %s" % (sModule, ", ".join("%s %+d" % (sClass, nDelta)
+                                                  for (sClass, nDelta) in sorted(dDiff["modules"][sModule].items())
+                                                  if nDelta)))
+    for dSymbol in dDiff["symbols"]:
+        print("  %+8d  %-5s %-12s %s" % (dSymbol["delta"], dSymbol["memory"], dSymbol["module"], dSymbol["symbol"]))
+
+
+def main(argv):
+    oParser = optparse.OptionParser(usage="%prog [options] image.map")
+    oParser.add_option("-l", "--log", help="build .log giving the source of each object")
+    oParser.add_option("-j", "--json", help="write the report as JSON")
+    oParser.add_option("-b", "--baseline", help="JSON report to compare with")
+    oParser.add_option("-c", "--budget", help="budget file, exit with 2 when exceeded")
+    oParser.add_option("-n", "--top", type="int", default=10, help="symbols listed per memory")
+    oParser.add_option("-q", "--quiet", action="store_true", help="only print budget failures")
+    (oOptions, lArgs) = oParser.parse_args(argv)
+    if len(lArgs) != 1:
+        oParser.error("expected one map file")
+
+    try:
+        dReport = cMap(lArgs[0], ReadLog(oOptions.log)).Report()
+        dReport["map"] = os.path.basename(lArgs[0])
+        if not oOptions.quiet:
+            PrintReport(dReport, oOptions.top)
+        if oOptions.baseline and os.path.exists(oOptions.baseline):
+            dReport["diff"] = Diff(dReport, json.load(open(oOptions.baseline)), oOptions.top * 2)
+            if not oOptions.quiet:
+                PrintDiff(dReport["diff"])
+        nExceeded = 0
+        if oOptions.budget:
+            dReport["budget"] = []
+            for (sName, u32Used, u32Budget) in CheckBudget(dReport, ReadBudget(oOptions.budget)):
+                dReport["budget"].append({"name" : sName, "used" : u32Used, "budget" : u32Budget})
+                if u32Used > u32Budget:
+                    nExceeded += 1
+                    print("MEMORY BUDGET EXCEEDED: %s uses %d of %d bytes (%+d)" % (
+                        sName, u32Used, u32Budget, u32Used - u32Budget))
+                elif not oOptions.quiet:
+                    print("Budget %-28s %8d of %8d bytes, %d free" % (sName, u32Used, u32Budget, u32Budget - u32Used))
+        if oOptions.json:
+            with open(oOptions.json, "w") as oFile:
+                json.dump(dReport, oFile, indent=1, sort_keys=True)
+    except (IOError, cMapError) as oError:
+        print("MemoryBudget: %s" % oError, file=sys.stderr)
+        return 1
+    return 2 if nExceeded else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,85 @@
+#*****************************************************************************
+#*
+# * MODULE:             ZigBee Control Bridge
+# *
+# * COMPONENT:          MemoryBudgetTest.py
+# *
+# * DESCRIPTION:        Check of MemoryBudget.py against the sample link in
+# *                     MemoryBudgetTest: sample.map with its build log,
+# *                     compared with baseline.json and checked against
+# *                     sample.cfg, whose application RAM budget is one byte
+# *                     short. The JSON report must match expected.json and
+# *                     the budget failure must give exit status 2.
+# *
+# *                     Usage:
+# *                     MemoryBudgetTest.py [--update]
+# *
+# *                     --update rewrites expected.json from the current
+# *                     output, after checking it by hand.
+# *
+# *****************************************************************************
+from __future__ import print_function
+
+import sys
+import os
+import json
+import tempfile
+
+sys.dont_write_bytecode = True
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import MemoryBudget
+
+SAMPLE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "MemoryBudgetTest")
+EXPECTED_STATUS = 2
+
+
+def Compare(oExpected, oActual, sPath, lErrors):
+    if isinstance(oExpected, dict) and isinstance(oActual, dict):
+        for sKey in sorted(set(oExpected) | set(oActual)):
+            if sKey not in oActual:
+                lErrors.append("%s/%s: missing" % (sPath, sKey))
+            elif sKey not in oExpected:
+                lErrors.append("%s/%s: unexpected %r" % (sPath, sKey, oActual[sKey]))
+            else:
+                Compare(oExpected[sKey], oActual[sKey], "%s/%s" % (sPath, sKey), lErrors)
+    elif isinstance(oExpected, list) and isinstance(oActual, list) and len(oExpected) == len(oActual):
+        for (nIndex, (oItem, oActualItem)) in enumerate(zip(oExpected, oActual)):
+            Compare(oItem, oActualItem, "%s[%d]" % (sPath, nIndex), lErrors)
+    elif oExpected != oActual:
+        lErrors.append("%s: expected %r, got %r" % (sPath, oExpected, oActual))
+
+
+def main(argv):
+    (nHandle, sJson) = tempfile.mkstemp(suffix=".json")
+    os.close(nHandle)
+    try:
+        nStatus = MemoryBudget.main(["--quiet",
+                                     "--log", os.path.join(SAMPLE_DIR, "sample.log"),
+                                     "--json", sJson,
+                                     "--baseline", os.path.join(SAMPLE_DIR, "baseline.json"),
+                                     "--budget", os.path.join(SAMPLE_DIR, "sample.cfg"),
+                                     os.path.join(SAMPLE_DIR, "sample.map")])
+        with open(sJson) as oFile:
+            dActual = json.load(oFile)
+    finally:
+        os.remove(sJson)
+
+    if "--update" in argv:
+        with open(os.path.join(SAMPLE_DIR, "expected.json"), "w") as oFile:
+            json.dump(dActual, oFile, indent=1, sort_keys=True)
+        return 0
+
+    with open(os.path.join(SAMPLE_DIR, "expected.json")) as oFile:
+        dExpected = json.load(oFile)
+    lErrors = []
+    if nStatus != EXPECTED_STATUS:
+        lErrors.append("exit status: expected %d, got %d" % (EXPECTED_STATUS, nStatus))
+    Compare(dExpected, dActual, "", lErrors)
+    for sError in lErrors:
+        print("FAIL %s" % sError)
+    print("MemoryBudgetTest: %s" % ("%d failed" % len(lErrors) if lErrors else "passed"))
+    return 1 if lErrors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,158 @@
+#*****************************************************************************
+#*
+# * MODULE:             ZigBee Control Bridge
+# *
+# * COMPONENT:          SerialCaptureTest.py
+# *
+# * DESCRIPTION:        Check of the SerialLink.py capture against the sample
+# *                     in SerialCaptureTest: sample.cap holds both
+# *                     directions of a short session with ok, crc, length
+# *                     and truncated frames. Its wire bytes are passed
+# *                     through cCapturePort again, in small reads with
+# *                     empty ones between them as a serial timeout gives,
+# *                     and must be recorded as in sample.cap, empty reads
+# *                     recording nothing. The --summary output of
+# *                     sample.cap must match expected.txt.
+# *
+# *                     SerialLink.py is Python 2; pyserial is not needed.
+# *
+# *                     Usage:
+# *                     SerialCaptureTest.py [--update]
+# *
+# *                     --update rewrites expected.txt from the current
+# *                     output, after checking it by hand.
+# *
+# *****************************************************************************
+from __future__ import print_function
+
+import sys
+import os
+import types
+import tempfile
+import StringIO
+
+sys.dont_write_bytecode = True
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+try:
+    import serial
+except ImportError:
+    # Only the capture code is used, which does not touch the port module
+    sys.modules["serial"] = types.ModuleType("serial")
+import SerialLink
+
+SAMPLE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "SerialCaptureTest")
+STATUSES = ("ok", "crc", "length", "truncated")
+
+
+class cSamplePort(object):
+    """Serial port giving back lReads one read at a time, empty when they run out"""
+    def __init__(self, lReads):
+        self.lReads = list(lReads)
+
+    def read(self, nBytes=1):
+        return self.lReads.pop(0) if self.lReads else ""
+
+    def write(self, sBytes):
+        return len(sBytes)
+
+
+class cCountingCapture(SerialLink.cSerialLinkCapture):
+    """Capture counting the chunks recorded"""
+    def __init__(self, sFileName):
+        SerialLink.cSerialLinkCapture.__init__(self, sFileName)
+        self.nRecorded = 0
+
+    def Record(self, sDirection, sBytes):
+        self.nRecorded += 1
+        SerialLink.cSerialLinkCapture.Record(self, sDirection, sBytes)
+
+
+def Recapture(lRecords):
+    """Passes the wire bytes of lRecords through cCapturePort, the host side written frame by
+       frame in two halves, the node side read a few bytes at a time with an empty read after
+       every chunk. Returns the frames recorded and the chunks recorded and expected"""
+    sNode = "".join(r[5] for r in lRecords if r[1] == "N")
+    lReads = []
+    nOffset = 0
+    while nOffset < len(sNode):
+        nSize = 1 + len(lReads) % 5
+        lReads += [sNode[nOffset:nOffset + nSize], ""]
+        nOffset += nSize
+    (nHandle, sFileName) = tempfile.mkstemp(suffix=".cap")
+    os.close(nHandle)
+    try:
+        oCapture = cCountingCapture(sFileName)
+        oPort = SerialLink.cCapturePort(cSamplePort(lReads), oCapture)
+        nChunks = 0
+        for r in lRecords:
+            if r[1] == "H":
+                nHalf = len(r[5]) // 2
+                oPort.write(r[5][:nHalf])
+                oPort.write(r[5][nHalf:])
+                nChunks += 2
+        for _ in lReads:
+            oPort.read(5)
+        nChunks += len([sRead for sRead in lReads if sRead])
+        oCapture.oFile.close()
+        lRecaptured = SerialLink.ReadCapture(sFileName)
+    finally:
+        os.remove(sFileName)
+    return (lRecaptured, oCapture.nRecorded, nChunks)
+
+
+def main(argv):
+    # The summary names the capture as given
+    os.chdir(SAMPLE_DIR)
+    sSample = "sample.cap"
+    lRecords = SerialLink.ReadCapture(sSample)
+
+    oStdout = sys.stdout
+    sys.stdout = StringIO.StringIO()
+    try:
+        SerialLink.SummariseCapture(sSample)
+        sSummary = sys.stdout.getvalue()
+    finally:
+        sys.stdout = oStdout
+
+    if "--update" in argv:
+        with open(os.path.join(SAMPLE_DIR, "expected.txt"), "w") as oFile:
+            oFile.write(sSummary)
+        return 0
+
+    lErrors = []
+    # Every status is in the sample
+    for sStatus in STATUSES:
+        if not [r for r in lRecords if r[4] == sStatus]:
+            lErrors.append("sample.cap: no %s frame" % sStatus)
+
+    (lRecaptured, nRecorded, nChunks) = Recapture(lRecords)
+    if nRecorded != nChunks:
+        lErrors.append("recorded %d chunks, expected %d without the empty reads" % (nRecorded, nChunks))
+    for sDirection in ("H", "N"):
+        lExpected = [r[1:] for r in lRecords if r[1] == sDirection]
+        lActual = [r[1:] for r in lRecaptured if r[1] == sDirection]
+        if len(lExpected) != len(lActual):
+            lErrors.append("%s: expected %d frames, got %d" % (sDirection, len(lExpected), len(lActual)))
+        for (nIndex, (tExpected, tActual)) in enumerate(zip(lExpected, lActual)):
+            if tExpected != tActual:
+                lErrors.append("%s[%d]: expected %04x %d %s %s, got %04x %d %s %s" % (
+                    (sDirection, nIndex) + tExpected[1:4] + (tExpected[4].encode("hex"),) +
+                    tActual[1:4] + (tActual[4].encode("hex"),)))
+
+    with open(os.path.join(SAMPLE_DIR, "expected.txt")) as oFile:
+        lExpectedSummary = oFile.read().splitlines()
+    lSummary = sSummary.splitlines()
+    for nLine in range(max(len(lExpectedSummary), len(lSummary))):
+        sExpected = lExpectedSummary[nLine] if nLine < len(lExpectedSummary) else "<none>"
+        sActual = lSummary[nLine] if nLine < len(lSummary) else "<none>"
+        if sExpected != sActual:
+            lErrors.append("summary line %d: expected %r, got %r" % (nLine + 1, sExpected, sActual))
+
+    for sError in lErrors:
+        print("FAIL %s" % sError)
+    print("SerialCaptureTest: %s" % ("%d failed" % len(lErrors) if lErrors else "passed"))
+    return 1 if lErrors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,102 @@
+#*****************************************************************************
+#*
+# * MODULE:             ZigBee Control Bridge
+# *
+# * COMPONENT:          SerialFuzzCorpus.py
+# *
+# * DESCRIPTION:        Seed corpus for the serial link fuzz target,
+# *                     Source/HostSim/Fuzz/fuzz_serial_link.c. Every host
+# *                     command in the teSL_MsgType enum of SerialLink.h
+# *                     gets three seeds: an empty and a short framed input,
+# *                     which the harness frames itself, and the same short
+# *                     frame as raw escaped bytes for the decoder.
+# *
+# *                     Usage:
+# *                     SerialFuzzCorpus.py [--header SerialLink.h] corpus_dir
+# *
+# *****************************************************************************
+from __future__ import print_function
+
+import sys
+import os
+import re
+import optparse
+
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                      "..", "Source", "ControlBridge", "SerialLink.h")
+
+SL_START_CHAR = 0x01
+SL_ESC_CHAR = 0x02
+SL_END_CHAR = 0x03
+
+# Short address mode, address 0x1234, endpoints 1 and 1, then a counting
+# tail: the start most addressed commands share
+SHORT_PAYLOAD = bytearray([0x02, 0x12, 0x34, 0x01, 0x01]) + bytearray(range(0x10, 0x10 + 19))
+
+
+def MessageTypes(sHeader):
+    """(name, value) of each teSL_MsgType member, in header order"""
+    sText = open(sHeader).read()
+    oEnum = re.search(r"typedef\s+enum\s*\{(.*?)\}\s*teSL_MsgType\s*;", sText, re.S)
+    if oEnum is None:
+        raise IOError("%s: no teSL_MsgType enum" % sHeader)
+    sBody = re.sub(r"/\*.*?\*/|//[^\n]*", "", oEnum.group(1), flags=re.S)
+    return [(sName, int(sValue, 0))
+            for (sName, sValue) in re.findall(r"(E_SL_MSG_\w+)\s*=\s*(0x[0-9A-Fa-f]+|\d+)", sBody)]
+
+
+def Crc(u16Type, sPayload):
+    """The CRC_XOR frame check of u8SL_CalculateCRC"""
+    u8Crc = (u16Type >> 8) ^ (u16Type & 0xFF) ^ (len(sPayload) >> 8) ^ (len(sPayload) & 0xFF)
+    for u8Byte in sPayload:
+        u8Crc ^= u8Byte
+    return u8Crc
+
+
+def RawFrame(u16Type, sPayload):
+    """A frame as it goes over the UART"""
+    sFrame = bytearray([SL_START_CHAR])
+    sHeader = bytearray([u16Type >> 8, u16Type & 0xFF, len(sPayload) >> 8, len(sPayload) & 0xFF,
+                         Crc(u16Type, sPayload)])
+    for u8Byte in sHeader + sPayload:
+        if u8Byte < 0x10:
+            sFrame += bytearray([SL_ESC_CHAR, u8Byte ^ 0x10])
+        else:
+            sFrame.append(u8Byte)
+    sFrame.append(SL_END_CHAR)
+    return sFrame
+
+
+def Seeds(u16Type):
+    sType = bytearray([u16Type >> 8, u16Type & 0xFF])
+    return [("empty", bytearray([0x00]) + sType),
+            ("short", bytearray([0x00]) + sType + SHORT_PAYLOAD),
+            ("raw", bytearray([0x01]) + RawFrame(u16Type, SHORT_PAYLOAD))]
+
+
+def main(argv):
+    oParser = optparse.OptionParser(usage="%prog [options] corpus_dir")
+    oParser.add_option("-H", "--header", default=HEADER, help="SerialLink.h to take the message types from")
+    (oOptions, lArgs) = oParser.parse_args(argv)
+    if len(lArgs) != 1:
+        oParser.error("expected one corpus directory")
+
+    try:
+        lTypes = [(sName, u16Type) for (sName, u16Type) in MessageTypes(oOptions.header) if u16Type < 0x8000]
+        if not os.path.isdir(lArgs[0]):
+            os.makedirs(lArgs[0])
+        nSeeds = 0
+        for (sName, u16Type) in lTypes:
+            for (sVariant, sSeed) in Seeds(u16Type):
+                with open(os.path.join(lArgs[0], "%04x_%s_%s" % (u16Type, sName[9:].lower(), sVariant)), "wb") as oFile:
+                    oFile.write(bytes(sSeed))
+                nSeeds += 1
+    except (IOError, OSError) as oError:
+        print("SerialFuzzCorpus: %s" % oError, file=sys.stderr)
+        return 1
+    print("  %d seeds for %d host commands" % (nSeeds, len(lTypes)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -27,6 +27,7 @@ import struct
 import threading
 import Queue
 import sqlite3
+import json
 
 # Message types
 
@@ -76,6 +77,28 @@ E_SL_MSG_COMPLEX_DESCRIPTOR_REQUEST     =   0x004C
 E_SL_MSG_DEVICE_ANNOUNCE                =   0x004D
 E_SL_MSG_MANAGEMENT_LQI_REQUEST         =   0x004E
 E_SL_MSG_MANAGEMENT_LQI_RESPONSE        =   0x804E
+E_SL_MSG_GET_DEVICE_SNAPSHOT            =   0x0055
+E_SL_MSG_DEVICE_SNAPSHOT_FRAME          =   0x8055
+E_SL_MSG_GET_PDM_TELEMETRY              =   0x0056
+E_SL_MSG_PDM_TELEMETRY                  =   0x8056
+E_SL_MSG_GET_BOOT_TIMING                =   0x0057
+E_SL_MSG_BOOT_TIMING                    =   0x8057
+E_SL_MSG_SECLIB_BENCHMARK               =   0x0058
+E_SL_MSG_SECLIB_BENCHMARK_RESULT        =   0x8058
+E_SL_MSG_GET_OTA_FLEET_STATS            =   0x0059
+E_SL_MSG_OTA_FLEET_STATS                =   0x8059
+E_SL_MSG_GET_OTA_BLOCK_SIZE             =   0x005A
+E_SL_MSG_OTA_BLOCK_SIZE                 =   0x805A
+E_SL_MSG_OTA_STORE                      =   0x005B
+E_SL_MSG_OTA_STORE_RESPONSE             =   0x805B
+E_SL_MSG_BEACON_FILTER                  =   0x005C
+E_SL_MSG_BEACON_FILTER_RESPONSE         =   0x805C
+E_SL_MSG_CHANNEL_QUALITY                =   0x005D
+E_SL_MSG_CHANNEL_QUALITY_RESPONSE       =   0x805D
+E_SL_MSG_STACK_WATERMARK                =   0x005E
+E_SL_MSG_STACK_WATERMARK_RESPONSE       =   0x805E
+E_SL_MSG_ZCL_BENCHMARK                  =   0x005F
+E_SL_MSG_ZCL_BENCHMARK_RESULT           =   0x805F
 # /* Group Cluster */
 E_SL_MSG_ADD_GROUP                      =   0x0060
 E_SL_MSG_VIEW_GROUP                     =   0x0061
@@ -151,6 +174,16 @@ E_SL_MSG_STEP_COLOUR_TEMPERATURE        =   0x00C2
 E_SL_MSG_LOCK_UNLOCK_DOOR               =   0x00F0
 E_SL_MSG_READ_ATTRIBUTE_REQUEST         =   0x0100
 E_SL_MSG_READ_ATTRIBUTE_RESPONSE        =   0x8100
+E_SL_MSG_ATTRIBUTE_CACHE_SET_RULE       =   0x0125
+E_SL_MSG_ATTRIBUTE_CACHE_GET_STATS      =   0x0126
+E_SL_MSG_ATTRIBUTE_CACHE_STATS          =   0x8126
+E_SL_MSG_DEVICE_INTERVIEW_START         =   0x0127
+E_SL_MSG_DEVICE_INTERVIEW_RESULT        =   0x8127
+E_SL_MSG_CHILD_QUEUE_SET_EXPIRY         =   0x0128
+E_SL_MSG_CHILD_QUEUE_GET_STATS          =   0x0129
+E_SL_MSG_CHILD_QUEUE_STATS              =   0x8129
+E_SL_MSG_CHILD_QUEUE_EXPIRED            =   0x812A
+E_SL_MSG_APS_QUEUE_REPORT_DEPTH         =   0x012B
 E_SL_MSG_SAVE_PDM_RECORD                =   0x0200
 E_SL_MSG_SAVE_PDM_RECORD_RESPONSE       =   0x8200
 E_SL_MSG_LOAD_PDM_RECORD_REQUEST        =   0x0201
@@ -279,7 +312,7 @@ class cModuleError(cSerialLinkError):
        
 class cSerialLink(threading.Thread):
     """Class implementing the binary serial protrocol to the control bridge node"""
-    def __init__(self, port, baudrate=115200):
+    def __init__(self, port, baudrate=115200, sCaptureFile=None):
         threading.Thread.__init__(self, name="SL")
         self.logger = logging.getLogger(str(port))
         self.commslogger = logging.getLogger("Comms("+str(port)+")")
@@ -288,6 +321,8 @@ class cSerialLink(threading.Thread):
         self.commslogger.setLevel(logging.WARNING)
         
         self.oPort = serial.Serial(port, baudrate)
+        if sCaptureFile is not None:
+            self.oPort = cCapturePort(self.oPort, cSerialLinkCapture(sCaptureFile))
         
         # Message queue used to pass messages between reader thread and WaitMessage()
         self.dMessageQueue = {}
@@ -460,7 +495,8 @@ class cSerialLink(threading.Thread):
                     (eMessageType == E_SL_MSG_DEVICE_ANNOUNCE) or
                     (eMessageType == E_SL_MSG_READ_ATTRIBUTE_RESPONSE)or
                     (eMessageType == E_SL_MSG_GET_GROUP_MEMBERSHIP_RESPONSE) or 
-                    (eMessageType == E_SL_MSG_MANAGEMENT_LQI_RESPONSE)):
+                    (eMessageType == E_SL_MSG_MANAGEMENT_LQI_RESPONSE) or
+                    (eMessageType == E_SL_MSG_CHILD_QUEUE_EXPIRED)):
                     if (eMessageType == E_SL_MSG_LOG):
                         logLevel = struct.unpack("B", sData[0])[0]
                         logLevel = ["EMERG", "ALERT", "CRIT ", "ERROR", "WARN ", "NOT  ", "INFO ", "DEBUG"][logLevel]
@@ -501,6 +537,11 @@ class cSerialLink(threading.Thread):
                         stringme= (':'.join(x.encode('hex') for x in sData))
                         self.logger.info("LQI response %s", stringme)                        
 
+                    if((eMessageType == E_SL_MSG_CHILD_QUEUE_EXPIRED)):
+                        (u16Addr, u16PacketType, u16Waited) = struct.unpack(">HHH", sData[:6])
+                        self.logger.warning("Command 0x%04x for sleepy child 0x%04x expired after %.1fs",
+                                            u16PacketType, u16Addr, u16Waited / 10.0)
+
                 else:
                     try:
                         
@@ -566,12 +607,328 @@ class cSerialLink(threading.Thread):
         return sData
 
 
+class cSerialLinkFrameDecoder(object):
+    """Reassembles SerialLink frames from the raw byte stream of one direction, keeping the bytes
+       exactly as sent and the time the start character was seen
+    """
+    def __init__(self):
+        self.sWire = None
+        self.u64Start = 0
+
+    def Feed(self, sBytes, u64Time):
+        """Feed bytes seen at u64Time. Returns a list of (start time, wire bytes, message type,
+           length, data, status) for the frames they complete, status one of ok, crc, length or
+           truncated (a start character inside a frame)
+        """
+        lFrames = []
+        for cByte in sBytes:
+            if cByte == "\x01":
+                if self.sWire is not None:
+                    lFrames.append(self._Decode("truncated"))
+                self.sWire = cByte
+                self.u64Start = u64Time
+            elif self.sWire is not None:
+                self.sWire += cByte
+                if cByte == "\x03":
+                    lFrames.append(self._Decode(None))
+                    self.sWire = None
+        return lFrames
+
+    def _Decode(self, sStatus):
+        sBody = ""
+        bInEsc = False
+        for cByte in self.sWire[1:-1] if sStatus is None else self.sWire[1:]:
+            if cByte == "\x02":
+                bInEsc = True
+            elif bInEsc:
+                sBody += chr(ord(cByte) ^ 0x10)
+                bInEsc = False
+            else:
+                sBody += cByte
+        (eMessageType, u16Length, u8Checksum) = (0, 0, 0)
+        if len(sBody) >= 5:
+            (eMessageType, u16Length, u8Checksum) = struct.unpack(">HHB", sBody[:5])
+        sData = sBody[5:]
+        if sStatus is None:
+            u8MyChecksum = ((eMessageType >> 8) ^ eMessageType ^ (u16Length >> 8) ^ u16Length) & 0xFF
+            for cByte in sData:
+                u8MyChecksum ^= ord(cByte)
+            if len(sBody) < 5 or len(sData) != u16Length:
+                sStatus = "length"
+            elif u8MyChecksum != u8Checksum:
+                sStatus = "crc"
+            else:
+                sStatus = "ok"
+        return (self.u64Start, self.sWire, eMessageType, u16Length, sData, sStatus)
+
+
+class cSerialLinkCapture(object):
+    """Records both directions of a SerialLink stream, one line per frame:
+           <us since start> <H host to node | N node to host> <type> <length> <status> <wire bytes>
+       with the wire bytes in hex exactly as sent, escaping included, so the host side can be
+       replayed byte for byte
+    """
+    def __init__(self, sFileName):
+        self.oFile = open(sFileName, "w")
+        self.oLock = threading.Lock()
+        self.fStart = time.time()
+        self.dDecoder = {"H" : cSerialLinkFrameDecoder(), "N" : cSerialLinkFrameDecoder()}
+        self.oFile.write("# SerialLink capture 1 %s\n" % time.strftime("%Y-%m-%dT%H:%M:%S", time.localtime(self.fStart)))
+
+    def Record(self, sDirection, sBytes):
+        u64Time = int((time.time() - self.fStart) * 1000000)
+        with self.oLock:
+            for (u64Start, sWire, eMessageType, u16Length, _, sStatus) in self.dDecoder[sDirection].Feed(sBytes, u64Time):
+                self.oFile.write("%d %s %04x %d %s %s\n" % (u64Start, sDirection, eMessageType, u16Length, sStatus,
+                                                            sWire.encode("hex")))
+            self.oFile.flush()
+
+
+class cCapturePort(object):
+    """Serial port wrapper passing everything written and read through a cSerialLinkCapture"""
+    def __init__(self, oPort, oCapture):
+        self.oPort = oPort
+        self.oCapture = oCapture
+
+    def write(self, sBytes):
+        self.oCapture.Record("H", sBytes)
+        return self.oPort.write(sBytes)
+
+    def read(self, nBytes=1):
+        sBytes = self.oPort.read(nBytes)
+        # A read timing out gives nothing, which is not worth a lock and a flush
+        if sBytes:
+            self.oCapture.Record("N", sBytes)
+        return sBytes
+
+    def __getattr__(self, sName):
+        return getattr(self.oPort, sName)
+
+
+def ReadCapture(sFileName):
+    """Returns the frames of a capture as (us, direction, type, length, status, wire bytes)"""
+    lRecords = []
+    with open(sFileName) as oFile:
+        for sLine in oFile:
+            if sLine.startswith("#") or not sLine.strip():
+                continue
+            (sTime, sDirection, sType, sLength, sStatus, sWire) = sLine.split()
+            lRecords.append((int(sTime), sDirection, int(sType, 16), int(sLength), sStatus, sWire.decode("hex")))
+    return lRecords
+
+
+def MessageName(eMessageType):
+    """Name of a message type from the E_SL_MSG_ constants"""
+    lNames = sorted(sName for (sName, oValue) in globals().items()
+                    if sName.startswith("E_SL_MSG_") and oValue == eMessageType)
+    return lNames[0][len("E_SL_MSG_"):] if lNames else "0x%04x" % eMessageType
+
+
+def _Percentile(lValues, fShare):
+    return lValues[min(len(lValues) - 1, int(fShare * len(lValues)))] if lValues else 0
+
+
+def _CommandLatencies(lHost, lNode):
+    """Pairs each host command (us, type) with the first later E_SL_MSG_STATUS for its type from
+       lNode (us, type, data). Returns {type : [us]} and {type : unanswered}
+    """
+    dPending = {}
+    dLatency = {}
+    dUnanswered = {}
+    lEvents = sorted([(u64Time, 0, eMessageType, None) for (u64Time, eMessageType) in lHost] +
+                     [(u64Time, 1, eMessageType, sData) for (u64Time, eMessageType, sData) in lNode])
+    for (u64Time, bNode, eMessageType, sData) in lEvents:
+        if not bNode:
+            dPending.setdefault(eMessageType, []).append(u64Time)
+        elif eMessageType == E_SL_MSG_STATUS and len(sData) >= 4:
+            eCommand = struct.unpack(">H", sData[2:4])[0]
+            if dPending.get(eCommand):
+                dLatency.setdefault(eCommand, []).append(u64Time - dPending[eCommand].pop(0))
+    for (eMessageType, lSent) in dPending.items():
+        dUnanswered[eMessageType] = len(lSent)
+    return (dLatency, dUnanswered)
+
+
+def SummariseCapture(sFileName, u32Baudrate=115200):
+    """Prints throughput per direction and message type, bad frames and command latency of a capture"""
+    lRecords = ReadCapture(sFileName)
+    if not lRecords:
+        print "%s: no frames" % sFileName
+        return
+    fSeconds = max(1, lRecords[-1][0] - lRecords[0][0]) / 1e6
+    print "%s: %d frames over %.3f s" % (sFileName, len(lRecords), fSeconds)
+    for (sDirection, sName) in (("H", "host to node"), ("N", "node to host")):
+        dTypes = {}
+        for (_, sRecordDirection, eMessageType, _, sStatus, sWire) in lRecords:
+            if sRecordDirection == sDirection:
+                lStats = dTypes.setdefault(eMessageType, [0, 0, 0])
+                lStats[0] += 1
+                lStats[1] += len(sWire)
+                lStats[2] += sStatus != "ok"
+        nBytes = sum(lStats[1] for lStats in dTypes.values())
+        print "%s: %d frames, %d bytes, %.0f bytes/s, %.1f%% of %d baud" % (
+            sName, sum(lStats[0] for lStats in dTypes.values()), nBytes, nBytes / fSeconds,
+            100.0 * nBytes * 10 / u32Baudrate / fSeconds, u32Baudrate)
+        for eMessageType in sorted(dTypes, key=lambda e: -dTypes[e][1]):
+            (nFrames, nBytes, nBad) = dTypes[eMessageType]
+            print "  %04x %-36s %7d frames %9d bytes %8.1f/s %9.0f bytes/s%s" % (
+                eMessageType, MessageName(eMessageType)[:36], nFrames, nBytes, nFrames / fSeconds, nBytes / fSeconds,
+                " %d BAD" % nBad if nBad else "")
+    (dLatency, dUnanswered) = _CommandLatencies(
+        [(r[0], r[2]) for r in lRecords if r[1] == "H" and r[4] == "ok"],
+        [(r[0], r[2], cSerialLinkFrameDecoder().Feed(r[5], 0)[0][4]) for r in lRecords if r[1] == "N" and r[4] == "ok"])
+    _PrintLatencies("status latency", dLatency, dUnanswered)
+
+
+def _PrintLatencies(sTitle, dLatency, dUnanswered, dOriginal={}):
+    print "%s ms%s" % (sTitle, ", captured p50 in brackets" if dOriginal else "")
+    for eMessageType in sorted(set(dLatency) | set(dUnanswered)):
+        lValues = sorted(dLatency.get(eMessageType, []))
+        sOriginal = ""
+        if eMessageType in dOriginal:
+            sOriginal = " (%.1f)" % (_Percentile(sorted(dOriginal[eMessageType]), 0.5) / 1e3)
+        print "  %04x %-36s %6d p50 %8.1f%s p90 %8.1f max %8.1f%s" % (
+            eMessageType, MessageName(eMessageType)[:36], len(lValues), _Percentile(lValues, 0.5) / 1e3, sOriginal,
+            _Percentile(lValues, 0.9) / 1e3, lValues[-1] / 1e3 if lValues else 0,
+            ", %d unanswered" % dUnanswered[eMessageType] if dUnanswered.get(eMessageType) else "")
+
+
+def ReplayCapture(sFileName, sPort, u32Baudrate=115200, fScale=1.0, fSettle=2.0):
+    """Re-sends the host to node frames of a capture, byte for byte, to a serial port or pty with
+       the captured spacing multiplied by fScale (0 sends back to back), then reports the latency of
+       the status each command gets against the capture
+    """
+    lRecords = ReadCapture(sFileName)
+    lHost = [r for r in lRecords if r[1] == "H"]
+    if not lHost:
+        print "%s: nothing sent by the host" % sFileName
+        return
+    oPort = serial.Serial(sPort, u32Baudrate, timeout=0.1)
+    oDecoder = cSerialLinkFrameDecoder()
+    lReceived = []
+    oStop = threading.Event()
+    fStart = time.time()
+
+    def Reader():
+        while not oStop.is_set():
+            sBytes = oPort.read(256)
+            if sBytes:
+                u64Time = int((time.time() - fStart) * 1000000)
+                lReceived.extend(oDecoder.Feed(sBytes, u64Time))
+
+    oReader = threading.Thread(target=Reader, name="Replay")
+    oReader.daemon = True
+    oReader.start()
+
+    lSent = []
+    u64First = lHost[0][0]
+    for (u64Time, _, eMessageType, _, sStatus, sWire) in lHost:
+        fDue = fStart + (u64Time - u64First) * fScale / 1e6
+        fWait = fDue - time.time()
+        if fWait > 0:
+            time.sleep(fWait)
+        oPort.write(sWire)
+        if sStatus == "ok":
+            lSent.append((int((time.time() - fStart) * 1000000), eMessageType))
+    time.sleep(fSettle)
+    oStop.set()
+    oReader.join()
+    oPort.close()
+
+    fSeconds = max(1, lSent[-1][0] if lSent else 1) / 1e6
+    print "replayed %d frames in %.3f s (captured %.3f s), %d frames back" % (
+        len(lHost), fSeconds, (lHost[-1][0] - u64First) / 1e6, len(lReceived))
+    nBad = sum(1 for tFrame in lReceived if tFrame[5] != "ok")
+    if nBad:
+        print "  %d frames back were BAD" % nBad
+    (dOriginal, _) = _CommandLatencies(
+        [(r[0], r[2]) for r in lHost if r[4] == "ok"],
+        [(r[0], r[2], cSerialLinkFrameDecoder().Feed(r[5], 0)[0][4]) for r in lRecords if r[1] == "N" and r[4] == "ok"])
+    (dLatency, dUnanswered) = _CommandLatencies(
+        lSent, [(tFrame[0], tFrame[2], tFrame[4]) for tFrame in lReceived if tFrame[5] == "ok"])
+    _PrintLatencies("status latency", dLatency, dUnanswered, dOriginal)
+
+
+# ZCL attribute types measured by the ZCL benchmark
+ZCL_TYPE_NAMES = {
+    0x08 : "gint8",     0x09 : "gint16",    0x0a : "gint24",    0x0b : "gint32",
+    0x0c : "gint40",    0x0d : "gint48",    0x0e : "gint56",    0x0f : "gint64",
+    0x10 : "bool",      0x18 : "bmap8",     0x19 : "bmap16",    0x1a : "bmap24",
+    0x1b : "bmap32",    0x1c : "bmap40",    0x1d : "bmap48",    0x1e : "bmap56",
+    0x1f : "bmap64",    0x20 : "uint8",     0x21 : "uint16",    0x22 : "uint24",
+    0x23 : "uint32",    0x24 : "uint40",    0x25 : "uint48",    0x26 : "uint56",
+    0x27 : "uint64",    0x28 : "int8",      0x29 : "int16",     0x2a : "int24",
+    0x2b : "int32",     0x2c : "int40",     0x2d : "int48",     0x2e : "int56",
+    0x2f : "int64",     0x30 : "enum8",     0x31 : "enum16",    0x38 : "semi",
+    0x39 : "single",    0x3a : "double",    0x41 : "ostring",   0x42 : "cstring",
+    0x43 : "lostring",  0x44 : "lcstring",  0x48 : "array",     0xe0 : "tod",
+    0xe1 : "date",      0xe2 : "utct",      0xe8 : "cluster",   0xe9 : "attribute",
+    0xea : "bacnet",    0xf0 : "ieee",      0xf1 : "key128",
+}
+
+DEVICE_INTERVIEW_STATUS = ("complete", "incomplete", "timed out")
+
+ZCL_BENCHMARK_STATUS = ("ok", "no buffer", "read back differs", "encoded back differs")
+
+
+def PrintZclBenchmark(dResult):
+    fNsPerCycle = 1e9 / dResult["clock_hz"]
+    print "ZCL benchmark x%d at %.1f MHz, cycles per operation%s" % (
+        dResult["iterations"], dResult["clock_hz"] / 1e6, "" if dResult["status"] == "ok" else ", %s" % dResult["status"])
+    print "  %-10s %5s %8s %8s %8s %8s %10s" % ("path", "bytes", "write", "read", "forward", "encode", "read ns/B")
+    dHeader = dResult["header"]
+    print "  %-10s %5d %8.0f %8.0f %8s %8s %10.1f" % ("header", dHeader["bytes"], dHeader["write"], dHeader["read"],
+                                                     "-", "-", dHeader["read"] * fNsPerCycle / dHeader["bytes"])
+    for sName in sorted(dResult["types"], key=lambda sName: dResult["types"][sName]["type"]):
+        dType = dResult["types"][sName]
+        print "  %-10s %5d %8.0f %8.0f %8.0f %8.0f %10.1f" % (sName, dType["bytes"], dType["write"], dType["read"],
+                                                             dType["forward"], dType["encode"],
+                                                             dType["read"] * fNsPerCycle / dType["bytes"])
+
+
+def CompareZclBenchmark(dResult, dBaseline, fTolerance):
+    """Returns [(path, operation, baseline cycles, cycles)] for every operation more than fTolerance
+       percent slower than in the baseline
+    """
+    lSlower = []
+    lPaths = [("header", dResult["header"], dBaseline.get("header", {}))]
+    lPaths += [(sName, dType, dBaseline.get("types", {}).get(sName, {})) for (sName, dType) in sorted(dResult["types"].items())]
+    for (sName, dNow, dThen) in lPaths:
+        for sOperation in ("write", "read", "forward", "encode"):
+            if sOperation in dNow and dThen.get(sOperation, 0) > 0:
+                if dNow[sOperation] > dThen[sOperation] * (1 + fTolerance / 100.0):
+                    lSlower.append((sName, sOperation, dThen[sOperation], dNow[sOperation]))
+    return lSlower
+
+
+def RunZclBenchmarkGate(sPort, u32Baudrate, sFileName, sBaseline=None, fTolerance=10.0, u16Iterations=0):
+    """Runs the ZCL benchmark on the node, writes the result to sFileName as JSON and compares it with
+       a baseline written the same way. Returns 1 when an operation got slower than fTolerance percent
+    """
+    oCB = cControlBridge(sPort, u32Baudrate)
+    dResult = oCB.RunZclBenchmark(u16Iterations)
+    PrintZclBenchmark(dResult)
+    with open(sFileName, "w") as oFile:
+        json.dump(dResult, oFile, indent=1, sort_keys=True)
+    if dResult["status"] != "ok":
+        return 1
+    if sBaseline is None:
+        return 0
+    lSlower = CompareZclBenchmark(dResult, json.load(open(sBaseline)), fTolerance)
+    for (sName, sOperation, fThen, fNow) in lSlower:
+        print "  %s %s %.0f -> %.0f cycles (%+.1f%%)" % (sName, sOperation, fThen, fNow, 100.0 * (fNow - fThen) / fThen)
+    print "%d operations more than %.0f%% slower than %s" % (len(lSlower), fTolerance, sBaseline)
+    return 1 if lSlower else 0
+
+
 
 class cControlBridge():
     """Class implementing commands to the control bridge node"""
-    def __init__(self, port, baudrate=115200):
-        self.oSL = cSerialLink(port, baudrate)
+    def __init__(self, port, baudrate=115200, sCaptureFile=None):
+        self.oSL = cSerialLink(port, baudrate, sCaptureFile)
         self.oPdm = cPDMFunctionality(port)
+        self.dDevices = {}
+        self.u32SnapshotGeneration = 0
         #self.oSL._WriteMessage(E_SL_MSG_PDM_HOST_AVAILABLE_RESPONSE,"00")
 
     def parseCommand(self,IncCommand):
@@ -700,6 +1057,218 @@ class cControlBridge():
             self.SendMatchDescriptor('FFFD','C05E','01','0006','00','0000')
             self.SendMatchDescriptor('FFFD','0104','01','0006','00','0000')
 
+        if command[0] == 'SNAP':
+            # SNAP for a full snapshot, SNAP,1 for the changes since the last one
+            fStart = time.time()
+            (bDiff, nRecords, nBytes) = self.GetDeviceSnapshot(len(command) > 1 and command[1] == '1')
+            print "%s snapshot gen 0x%08x: %d records, %d bytes, %.3fs, %d devices known" % (
+                "Diff" if bDiff else "Full", self.u32SnapshotGeneration, nRecords, nBytes,
+                time.time() - fStart, len(self.dDevices))
+            for u64Ieee in sorted(self.dDevices):
+                (u16Nwk, u8Flags, u8Lqi) = self.dDevices[u64Ieee]
+                print "  %016x %04x flags %02x lqi %d" % (u64Ieee, u16Nwk, u8Flags, u8Lqi)
+
+        if command[0] == 'BOOT':
+            (bStaged, lStages) = self.GetBootTiming()
+            print "Boot timing (%s):" % ("staged" if bStaged else "not staged")
+            u32Previous = 0
+            for (sStage, u32Us) in zip(("start", "pdm init", "app records", "stack", "ready", "zcl", "deferred"), lStages):
+                print "    %-12s %8d us (+%d)" % (sStage, u32Us, u32Us - u32Previous)
+                u32Previous = u32Us
+
+        if command[0] == 'OTAF':
+            # OTAF to read the OTA fleet statistics, OTAF,1 to read and reset them
+            (dSummary, lClients) = self.GetOtaFleetStats(len(command) > 1 and command[1] == '1')
+            print "OTA fleet: %(clients)d clients, %(complete)d complete, %(paging)d paging, %(pages)d page requests" % dSummary
+            print "    %(requests)d block requests, %(served)d blocks served, %(hits)d from cache, %(coalesced)d coalesced" % dSummary
+            print "    %(fetches)d host fetches, %(host_bytes)d UART bytes from host, %(air_bytes)d image bytes sent" % dSummary
+            if dSummary["served"] > 0:
+                # Serving every client independently costs one host fetch per block served
+                print "    host fetches %.1f%% of independent serving" % (100.0 * dSummary["fetches"] / dSummary["served"])
+            for (u16Addr, u8State, u32Offset, u32Blocks) in lClients:
+                lFlags = [sName for (u8Bit, sName) in ((0x01, "waiting"), (0x02, "page"), (0x04, "complete"), (0x08, "failed")) if u8State & u8Bit]
+                print "  %04x offset %8d blocks %6d %s" % (u16Addr, u32Offset, u32Blocks, " ".join(lFlags))
+
+        if command[0] == 'OTABS':
+            # OTABS,<short address>[,<image bytes>[,1]] block size served to a node, 1 resets the counters
+            u16Addr = int(command[1], 16)
+            u32Image = int(command[2]) if len(command) > 2 else 0
+            dResult = self.GetOtaBlockSize(u16Addr, len(command) > 3 and command[3] == '1')
+            print "OTA block size to %(address)04x: APS payload %(max_payload)d, block %(block)d of %(ceiling)d" % dResult
+            print "    %(sized)d requests sized, %(reduced)d reduced, blocks %(smallest)d..%(largest)d bytes" % dResult
+            if u32Image > 0 and dResult["block"] > 0:
+                # Each block costs a request/response exchange plus a UART round trip to the host
+                nBlocks = (u32Image + dResult["block"] - 1) / dResult["block"]
+                nLegacy = (u32Image + 63) / 64
+                print "    %d byte image: %d blocks against %d at 64 bytes, %.1f%% fewer exchanges" % (
+                    u32Image, nBlocks, nLegacy, 100.0 * (nLegacy - nBlocks) / nLegacy)
+
+        if command[0] == 'OTAS':
+            # OTAS for the store contents, OTAS,UPLOAD,<slot>,<file>, OTAS,SELECT,<slot|255>, OTAS,ERASE,<slot>
+            sOperation = command[1].upper() if len(command) > 1 else "INFO"
+            if sOperation == 'UPLOAD':
+                dResult = self.UploadOtaImage(int(command[2]), command[3])
+                print "OTA store slot %(slot)d: %(size)d bytes in %(seconds).1f s, %(rate).0f bytes/s over the UART" % dResult
+                print "    %(flash_us)d us spent programming flash on the node" % dResult
+            elif sOperation in ('SELECT', 'ERASE'):
+                self.OtaStoreCommand(4 if sOperation == 'SELECT' else 5, "%02x" % int(command[2]))
+            else:
+                (dSummary, lSlots) = self.GetOtaStoreInfo()
+                print "OTA store: %(slots)d slots of %(slot_size)d bytes in %(area_size)d bytes of flash, advertising slot %(advertised)d" % dSummary
+                if dSummary["served"] > 0:
+                    print "    %d blocks served from flash, %.1f us per block" % (
+                        dSummary["served"], float(dSummary["serve_us"]) / dSummary["served"])
+                for (i, (u8State, u16Manufacturer, u16ImageType, u32Version, u32Size, u32Received)) in enumerate(lSlots):
+                    print "  slot %d %-9s %04x %04x version %08x %8d bytes (%d received)" % (
+                        i, ("empty", "receiving", "verified")[u8State] if u8State < 3 else "unknown",
+                        u16Manufacturer, u16ImageType, u32Version, u32Size, u32Received)
+
+        if command[0] == 'BF':
+            # BF for the last scan per channel, BF,RESET, BF,CLEAR, BF,SET,<map>,<pan>,<lqi>,<depth>[,<epid>...] (hex map, pan and epids),
+            # BF,BENCH[,<beacons per channel>[,<list size>[,<networks per channel>]]] on a BEACON_FILTER_BENCHMARK build
+            sOperation = command[1].upper() if len(command) > 1 else "STATS"
+            if sOperation == 'SET':
+                self.SetBeaconFilter(int(command[2], 16), int(command[3], 16), int(command[4]), int(command[5]),
+                                     [int(sEpid, 16) for sEpid in command[6:]])
+            elif sOperation == 'CLEAR':
+                self.BeaconFilterCommand(2)
+            elif sOperation == 'BENCH':
+                lArgs = [int(sArg) for sArg in command[2:5]]
+                dResult = self.RunBeaconFilterBenchmark(*lArgs)
+                print "Beacon filter: %(beacons)d beacons per channel from %(networks)d networks, %(list_size)d extended PAN IDs listed" % dResult
+                nBeacons = dResult["beacons"] * 16
+                for (sRun, sName) in (("none", "no filter"), ("walk", "list walked"), ("table", "table lookup")):
+                    print "    %-13s %8d us, %.2f us per beacon, %d passed" % (
+                        sName, dResult[sRun + "_us"], float(dResult[sRun + "_us"]) / nBeacons, dResult[sRun + "_passed"])
+                if dResult["walk_passed"] != dResult["table_passed"]:
+                    print "    list walk and table lookup DIFFER"
+            else:
+                (dSummary, lChannels) = self.GetBeaconFilterStats(sOperation == 'RESET')
+                print "Beacon scan %(scans)d: %(networks)d networks heard, %(overflows)d not tracked" % dSummary
+                for (u8Channel, u16Beacons, u8Networks, u8Lqi, u16PermitJoin) in lChannels:
+                    if u16Beacons > 0:
+                        print "  channel %2d %5d beacons %3d networks LQI %3d %5d permitting joins" % (
+                            u8Channel, u16Beacons, u8Networks, u8Lqi, u16PermitJoin)
+
+        if command[0] == 'CQ':
+            # CQ[,<mask>] to rank the channels in a hex mask, all by default, CQ,CHANGE[,<channel>[,<mask>]] to move
+            # the network, to the best ranked channel when none is given, CQ,RESET to forget the history
+            sOperation = command[1].upper() if len(command) > 1 else ""
+            if sOperation == 'CHANGE':
+                u8Channel = self.ChangeChannel(int(command[2]) if len(command) > 2 else 0,
+                                               int(command[3], 16) if len(command) > 3 else 0x07FFF800)
+                print "Channel change to %d requested" % u8Channel
+            elif sOperation == 'RESET':
+                self.ChannelQualityCommand(2)
+            else:
+                (dSummary, lChannels) = self.GetChannelQuality(int(command[1], 16) if len(command) > 1 else 0x07FFF800)
+                print "Channel %(current)d delivers %(current_delivery)d per mille, best %(best)d at %(best_delivery)d per mille" % dSummary
+                for (u8Channel, u8Energy, u8Scans, u16Sent, u16NoAck, u16Busy, u16Delivery) in lChannels:
+                    print "  channel %2d energy %3d (%3d scans) %5d sent %5d no ack %5d busy, delivery %4d" % (
+                        u8Channel, u8Energy, u8Scans, u16Sent, u16NoAck, u16Busy, u16Delivery)
+
+        if command[0] == 'SW':
+            # SW to report the stack high-water marks, SW,RESET to report then clear them, SW,REPAINT to
+            # start measuring afresh
+            sOperation = command[1].upper() if len(command) > 1 else ""
+            if sOperation == 'REPAINT':
+                self.RepaintStackWatermark()
+            else:
+                (dSummary, lHandlers) = self.GetStackWatermark(sOperation == 'RESET')
+                print "Stack peak %(peak)d of %(size)d bytes in %(peak_name)s, %(depth)d since last repaint" % dSummary
+                print "  %(sweeps)d sweeps, %(repaints)d repaints, %(unattributed)d peaks found by a sweep%(overflow)s" % dSummary
+                for (sName, u16Peak, u16Marks) in sorted(lHandlers, key=lambda t: -t[1]):
+                    print "  %5d bytes %5d marks  %s" % (u16Peak, u16Marks, sName)
+
+        if command[0] == 'AESB':
+            # AESB for the default iteration count, AESB,<n> for n iterations
+            dResult = self.RunSecLibBenchmark(int(command[1]) if len(command) > 1 else 0)
+            print "SecLib AES x%(iterations)d: KAT %(kat)s, CCM round trip %(ccm)s" % dResult
+            for sBackend in (("hw", "sw") if dResult["sw_measured"] else ("hw",)):
+                u32BlockUs = dResult[sBackend + "_block_us"]
+                u32FrameUs = dResult[sBackend + "_frame_us"]
+                print "    %s block %.1f us, %d byte frame %.1f us" % (
+                    "software" if sBackend == "sw" else ("selected (software)" if dResult["hw_disabled"] else "selected"),
+                    float(u32BlockUs) / dResult["iterations"], dResult["frame_length"],
+                    float(u32FrameUs) / dResult["iterations"])
+            if dResult["sw_measured"]:
+                print "    backends %s" % ("agree" if dResult["agree"] else "DIFFER")
+
+        if command[0] == 'ZCLB':
+            # ZCLB for the default iteration count, ZCLB,<n> for n iterations
+            PrintZclBenchmark(self.RunZclBenchmark(int(command[1]) if len(command) > 1 else 0))
+
+        if command[0] == 'ACR':
+            # ACR,<index>,<cluster hex>,<seconds> to set an attribute cache rule, ACR,255 to clear the cache
+            if len(command) > 3:
+                self.SetAttributeCacheRule(int(command[1]), int(command[2], 16), int(command[3]))
+            else:
+                self.SetAttributeCacheRule(int(command[1]), 0, 0)
+
+        if command[0] == 'INTV':
+            # INTV,<short address hex>[,<capability hex>] to interview a joined device, INTV alone to wait
+            # for the interview of the next device to announce itself
+            if len(command) > 1:
+                self.StartDeviceInterview(int(command[1], 16), int(command[2], 16) if len(command) > 2 else 0)
+            dResult = self.WaitDeviceInterview()
+            print "Interview of 0x%(address)04x %(status)s in %(duration).1fs, %(requests)d requests" % dResult
+            for dEndpoint in dResult["endpoints"]:
+                if dEndpoint["status"] == 0:
+                    print "    endpoint %d profile 0x%04x device 0x%04x in %s out %s" % (
+                        dEndpoint["endpoint"], dEndpoint["profile"], dEndpoint["device"],
+                        " ".join("%04x" % u16Cluster for u16Cluster in dEndpoint["in"]),
+                        " ".join("%04x" % u16Cluster for u16Cluster in dEndpoint["out"]))
+                else:
+                    print "    endpoint %d no descriptor" % dEndpoint["endpoint"]
+            for (u16Attribute, u8Status, sType, sValue) in dResult["attributes"]:
+                print "    basic 0x%04x %s %r" % (u16Attribute, sType, sValue) if u8Status == 0 else \
+                      "    basic 0x%04x status 0x%02x" % (u16Attribute, u8Status)
+
+        if command[0] == 'ACS':
+            # ACS to read the attribute cache counters, ACS,1 to read and reset them
+            dStats = self.GetAttributeCacheStats(len(command) > 1 and command[1] == '1')
+            print "Attribute cache %(held)d/%(capacity)d values, %(rules)d rules" % dStats
+            print "    hits %(hits)d, misses %(misses)d, stored %(stored)d" % dStats
+            print "    expired %(expired)d, evicted %(evicted)d, invalidated %(invalidated)d" % dStats
+
+        if command[0] == 'CQE':
+            # CQE,<seconds> to hold commands for sleepy children that long, CQE,0 to send them straight away
+            self.SetChildQueueExpiry(int(command[1]))
+
+        if command[0] == 'CQS':
+            # CQS to read the sleepy child queue counters, CQS,1 to read and reset them
+            dStats = self.GetChildQueueStats(len(command) > 1 and command[1] == '1')
+            print "Child queue %(held)d/%(capacity)d commands for %(child_count)d children, expiry %(expiry)ds" % dStats
+            print "    held %(total_held)d, delivered %(delivered)d, expired %(expired)d" % dStats
+            print "    coalesced %(coalesced)d, rearmed %(rearmed)d, full %(full)d" % dStats
+            for dChild in dStats["children"]:
+                print "    0x%(address)04x held %(held)d delivered %(delivered)d expired %(expired)d " \
+                      "coalesced %(coalesced)d rearmed %(rearmed)d latency %(latency_mean).1fs/%(latency_max).1fs" % dChild
+
+        if command[0] == 'PDMT':
+            # PDMT to read the PDM telemetry, PDMT,1 to read and reset it
+            (dSummary, lWear, lRecords) = self.GetPdmTelemetry(len(command) > 1 and command[1] == '1')
+            print "PDM saves %(saves)d (command %(command)d, idle %(idle)d, failed %(failed)d), %(bytes)d bytes" % dSummary
+            print "    duration min %(min_us)d us, avg %(avg_us)d us, max %(max_us)d us" % dSummary
+            print "    erases %(erases)d since reset, %(wear)d total, segment wear %(wear_min)d..%(wear_max)d" % dSummary
+            if "latency" in dSummary:
+                print "    boot PDM recovery %(boot_us)d us" % dSummary
+                # Bucket i holds saves under 250us << i, the last one everything slower
+                lLatency = dSummary["latency"]
+                for (sName, fRank) in (("p50", 0.5), ("p90", 0.9), ("p99", 0.99)):
+                    nSeen = 0
+                    for i in range(len(lLatency)):
+                        nSeen += lLatency[i]
+                        if nSeen > 0 and nSeen >= fRank * sum(lLatency):
+                            break
+                    if i == len(lLatency) - 1:
+                        print "    %s >= %d us" % (sName, 250 << (i - 1))
+                    else:
+                        print "    %s < %d us" % (sName, 250 << i)
+            print "    wear per segment: %s" % " ".join(["%d" % u32Wear for u32Wear in lWear])
+            for (u16Id, u32Saves, u32Bytes) in lRecords:
+                print "    record 0x%04x: %d saves, %d bytes" % (u16Id, u32Saves, u32Bytes)
+
         if command[0] == 'PDMDUMP':        
             conn = sqlite3.connect('pdm.db')
             c = conn.cursor()
@@ -790,7 +1359,405 @@ class cControlBridge():
     def SendLqiRequest(self,TargetAddress,startidx):
          """Send LQI command"""
          self.oSL.SendMessage(E_SL_MSG_MANAGEMENT_LQI_REQUEST,(str(TargetAddress)+str(startidx)))
+
+    def _SnapshotCrc(self, sData):
+        """CRC-16/CCITT-FALSE as computed by app_device_snapshot.c"""
+        u16Crc = 0xFFFF
+        for c in sData:
+            u16Crc ^= ord(c) << 8
+            for i in range(8):
+                if u16Crc & 0x8000:
+                    u16Crc = ((u16Crc << 1) ^ 0x1021) & 0xFFFF
+                else:
+                    u16Crc = (u16Crc << 1) & 0xFFFF
+        return u16Crc
+
+    def GetDeviceSnapshot(self, bDiff=False):
+        """Fetch the device table snapshot and apply it to self.dDevices.
+           With bDiff only the records changed since the last snapshot are
+           requested; the node falls back to a full snapshot when it can't diff.
+           Returns (bDiff, number of records, bytes received)
+        """
+        u32Base = self.u32SnapshotGeneration if bDiff else 0
+        # Frames follow the status straight away, listen before sending
+        self.oSL.dMessageQueue[E_SL_MSG_DEVICE_SNAPSHOT_FRAME] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_GET_DEVICE_SNAPSHOT, "%08X" % u32Base)
+
+        sRecords = ""
+        sCovered = ""
+        nBytes = 0
+        u8FrameCount = 1
+        u8FrameIndex = 0
+        try:
+            while u8FrameIndex < u8FrameCount:
+                sData = self.oSL.dMessageQueue[E_SL_MSG_DEVICE_SNAPSHOT_FRAME].get(True, 2)
+                nBytes += len(sData)
+                (u8Version, u8Mode, u32Generation, u32Base, u8Index, u8FrameCount, u16Total, u8InFrame) = \
+                    struct.unpack(">BBIIBBHB", sData[:15])
+                if u8Index != u8FrameIndex:
+                    raise cSerialLinkError("Snapshot frame %d received, expected %d" % (u8Index, u8FrameIndex))
+                sRecords += sData[15:15 + (u8InFrame * 12)]
+                # The CRC covers the header and records of every frame
+                sCovered += sData[:15 + (u8InFrame * 12)]
+                u8FrameIndex += 1
+        except Queue.Empty:
+            raise cSerialLinkError("Snapshot frame %d not received" % u8FrameIndex)
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_DEVICE_SNAPSHOT_FRAME]
+
+        u16Crc = struct.unpack(">H", sData[-2:])[0]
+        if u16Crc != self._SnapshotCrc(sCovered) or len(sRecords) != (u16Total * 12):
+            raise cSerialLinkError("Snapshot CRC or length mismatch")
+
+        if u8Mode == 0:
+            self.dDevices = {}
+        for i in range(u16Total):
+            (u64Ieee, u16Nwk, u8Flags, u8Lqi) = struct.unpack(">QHBB", sRecords[i * 12:(i + 1) * 12])
+            if u8Flags & 0x80:
+                self.dDevices.pop(u64Ieee, None)
+            else:
+                self.dDevices[u64Ieee] = (u16Nwk, u8Flags, u8Lqi)
+        self.u32SnapshotGeneration = u32Generation
+        return (u8Mode == 1, u16Total, nBytes)
          
+    def GetBootTiming(self):
+        """Fetch the time in us from boot to the end of every boot stage.
+           Returns (bStaged, [us per stage])
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_BOOT_TIMING] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_GET_BOOT_TIMING)
+        try:
+            sData = self.oSL.dMessageQueue[E_SL_MSG_BOOT_TIMING].get(True, 2)
+        except Queue.Empty:
+            raise cSerialLinkError("Boot timing not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_BOOT_TIMING]
+        (u8Version, u8Staged, u8Stages) = struct.unpack(">BBB", sData[:3])
+        return (u8Staged != 0, list(struct.unpack(">%dI" % u8Stages, sData[3:3 + u8Stages * 4])))
+
+    def GetOtaFleetStats(self, bReset=False):
+        """Fetch the OTA fleet distribution counters and per client progress, optionally resetting them.
+           Returns (summary dictionary, [(short address, state, next offset, blocks)])
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_OTA_FLEET_STATS] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_GET_OTA_FLEET_STATS, "01" if bReset else "00")
+
+        dSummary = None
+        lClients = []
+        try:
+            while dSummary is None or len(lClients) < dSummary["clients"]:
+                sData = self.oSL.dMessageQueue[E_SL_MSG_OTA_FLEET_STATS].get(True, 2)
+                if ord(sData[0]) == 0:
+                    lFields = struct.unpack(">BBBBBH7I", sData[:35])
+                    dSummary = dict(zip(("section", "version", "clients", "complete", "paging", "pages",
+                                         "requests", "served", "hits", "coalesced", "fetches",
+                                         "host_bytes", "air_bytes"), lFields))
+                else:
+                    u8Count = ord(sData[2])
+                    for i in range(u8Count):
+                        lClients.append(struct.unpack(">HBII", sData[3 + i * 11:14 + i * 11]))
+        except Queue.Empty:
+            raise cSerialLinkError("OTA fleet statistics not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_OTA_FLEET_STATS]
+        return (dSummary, lClients)
+
+    def GetOtaBlockSize(self, u16Addr, bReset=False):
+        """Fetch the OTA block size the coordinator serves to u16Addr and its block sizing counters.
+           Returns a result dictionary
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_OTA_BLOCK_SIZE] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_GET_OTA_BLOCK_SIZE, "%04x%s" % (u16Addr, "01" if bReset else "00"))
+        try:
+            sData = self.oSL.dMessageQueue[E_SL_MSG_OTA_BLOCK_SIZE].get(True, 2)
+        except Queue.Empty:
+            raise cSerialLinkError("OTA block size not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_OTA_BLOCK_SIZE]
+        lFields = struct.unpack(">HBBBIIBB", sData[:15])
+        return dict(zip(("address", "max_payload", "block", "ceiling", "sized", "reduced", "smallest", "largest"), lFields))
+
+    def OtaStoreCommand(self, u8Operation, sData="", fTimeout=2):
+        """Send an OTA store operation and wait for its response.
+           Returns the response data after the operation, status and slot bytes
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_OTA_STORE_RESPONSE] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_OTA_STORE, "%02x%s" % (u8Operation, sData))
+        try:
+            sData = self.oSL.dMessageQueue[E_SL_MSG_OTA_STORE_RESPONSE].get(True, fTimeout)
+        except Queue.Empty:
+            raise cSerialLinkError("OTA store response not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_OTA_STORE_RESPONSE]
+        u8Status = ord(sData[1])
+        if u8Status != 0:
+            lStatus = ("ok", "bad slot", "too large", "bad state", "bad offset", "flash error",
+                       "bad header", "bad hash", "malformed", "no memory")
+            raise cSerialLinkError("OTA store operation %d failed: %s" % (
+                u8Operation, lStatus[u8Status] if u8Status < len(lStatus) else "status %d" % u8Status))
+        return sData[3:] if u8Operation != 0 else sData[2:]
+
+    def GetOtaStoreInfo(self):
+        """Fetch the OTA store capacity, serving counters and slot table.
+           Returns (summary dictionary, [(state, manufacturer, image type, version, size, received)])
+        """
+        sData = self.OtaStoreCommand(0)
+        lFields = struct.unpack(">BB4I", sData[:18])
+        dSummary = dict(zip(("slots", "advertised", "area_size", "slot_size", "served", "serve_us"), lFields))
+        lSlots = [struct.unpack(">BHHIII", sData[18 + i * 17:35 + i * 17]) for i in range(dSummary["slots"])]
+        return (dSummary, lSlots)
+
+    def UploadOtaImage(self, u8Slot, sFileName):
+        """Write an OTA file into a store slot, the node checks its SHA-256 and header before advertising it.
+           Returns a result dictionary with the UART rate and the flash programming time on the node
+        """
+        import hashlib
+        with open(sFileName, "rb") as oFile:
+            sImage = oFile.read()
+        fStart = time.time()
+        self.OtaStoreCommand(1, "%02x%08x%s" % (u8Slot, len(sImage), hashlib.sha256(sImage).hexdigest()))
+        for u32Offset in range(0, len(sImage), 256):
+            self.OtaStoreCommand(2, "%02x%08x%s" % (u8Slot, u32Offset, sImage[u32Offset:u32Offset + 256].encode("hex")))
+        (u32FlashUs,) = struct.unpack(">I", self.OtaStoreCommand(3, "%02x" % u8Slot, 10)[:4])
+        fSeconds = time.time() - fStart
+        return {"slot"     : u8Slot,
+                "size"     : len(sImage),
+                "seconds"  : fSeconds,
+                "rate"     : len(sImage) / fSeconds if fSeconds > 0 else 0.0,
+                "flash_us" : u32FlashUs}
+
+    def BeaconFilterCommand(self, u8Operation, sData="", fTimeout=2):
+        """Send a beacon filter operation and wait for its response.
+           Returns the response data after the operation and status bytes
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_BEACON_FILTER_RESPONSE] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_BEACON_FILTER, "%02x%s" % (u8Operation, sData))
+        try:
+            sData = self.oSL.dMessageQueue[E_SL_MSG_BEACON_FILTER_RESPONSE].get(True, fTimeout)
+        except Queue.Empty:
+            raise cSerialLinkError("Beacon filter response not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_BEACON_FILTER_RESPONSE]
+        u8Status = ord(sData[1])
+        if u8Status != 0:
+            lStatus = ("ok", "malformed", "too many extended PAN IDs", "unsupported")
+            raise cSerialLinkError("Beacon filter operation %d failed: %s" % (
+                u8Operation, lStatus[u8Status] if u8Status < len(lStatus) else "status %d" % u8Status))
+        return sData[2:]
+
+    def SetBeaconFilter(self, u16FilterMap, u16PanId, u8Lqi, u8Depth, lExtendedPanIds):
+        """Install a beacon filter as tsBeaconFilterType, the extended PAN IDs are black or white listed by u16FilterMap"""
+        self.BeaconFilterCommand(1, "%04x%04x%02x%02x%02x%s" % (u16FilterMap, u16PanId, u8Lqi, u8Depth, len(lExtendedPanIds),
+                                                             "".join("%016x" % u64Epid for u64Epid in lExtendedPanIds)))
+
+    def GetBeaconFilterStats(self, bReset=False):
+        """Fetch the per channel beacon counts of the last scan, optionally resetting them.
+           Returns (summary dictionary, [(channel, beacons, networks, average LQI, beacons permitting joins)])
+        """
+        sData = self.BeaconFilterCommand(0, "01" if bReset else "00")
+        lFields = struct.unpack(">HHHB", sData[:7])
+        dSummary = dict(zip(("scans", "overflows", "networks", "channels"), lFields))
+        lChannels = [struct.unpack(">BHBBH", sData[7 + i * 7:14 + i * 7]) for i in range(dSummary["channels"])]
+        return (dSummary, lChannels)
+
+    def RunBeaconFilterBenchmark(self, u16PerChannel=0, u8ListSize=0, u8Networks=0):
+        """Replay synthetic beacons on every channel through the node's beacon handler without a filter,
+           with the blacklist walked and with it looked up in its table. Returns a result dictionary
+        """
+        sData = self.BeaconFilterCommand(3, "%04x%02x%02x" % (u16PerChannel, u8ListSize, u8Networks), 10)
+        lFields = struct.unpack(">HBB" + "IH" * 3, sData[:22])
+        return dict(zip(("beacons", "list_size", "networks", "none_us", "none_passed", "walk_us", "walk_passed",
+                         "table_us", "table_passed"), lFields))
+
+    def ChannelQualityCommand(self, u8Operation, sData="", fTimeout=2):
+        """Send a channel quality operation and wait for its response.
+           Returns the response data after the operation and status bytes
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_CHANNEL_QUALITY_RESPONSE] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_CHANNEL_QUALITY, "%02x%s" % (u8Operation, sData))
+        try:
+            sData = self.oSL.dMessageQueue[E_SL_MSG_CHANNEL_QUALITY_RESPONSE].get(True, fTimeout)
+        except Queue.Empty:
+            raise cSerialLinkError("Channel quality response not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_CHANNEL_QUALITY_RESPONSE]
+        u8Status = ord(sData[1])
+        if u8Status != 0:
+            lStatus = ("ok", "malformed", "no better channel", "not on a network", "send failed", "unsupported")
+            raise cSerialLinkError("Channel quality operation %d failed: %s" % (
+                u8Operation, lStatus[u8Status] if u8Status < len(lStatus) else "status %d" % u8Status))
+        return sData[2:]
+
+    def GetChannelQuality(self, u32ChannelMask=0x07FFF800):
+        """Fetch the channel quality history and the ranking of the channels in u32ChannelMask.
+           Returns (summary dictionary, [(channel, energy, energy scans, sent, no ack, busy, delivery per mille)])
+        """
+        sData = self.ChannelQualityCommand(0, "%08x" % u32ChannelMask)
+        lFields = struct.unpack(">BBHHB", sData[:7])
+        dSummary = dict(zip(("current", "best", "current_delivery", "best_delivery", "channels"), lFields))
+        lChannels = [struct.unpack(">BBBHHHH", sData[7 + i * 11:18 + i * 11]) for i in range(dSummary["channels"])]
+        return (dSummary, lChannels)
+
+    def ChangeChannel(self, u8Channel=0, u32ChannelMask=0x07FFF800):
+        """Move the network to u8Channel, or to the best ranked channel in u32ChannelMask when 0.
+           Returns the channel asked for
+        """
+        sData = self.ChannelQualityCommand(1, "%02x%08x" % (u8Channel, u32ChannelMask))
+        return ord(sData[0])
+
+    def StackWatermarkCommand(self, u8Operation, sData="", fTimeout=2):
+        """Send a stack watermark operation and wait for its response.
+           Returns the response data after the operation and status bytes
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_STACK_WATERMARK_RESPONSE] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_STACK_WATERMARK, "%02x%s" % (u8Operation, sData))
+        try:
+            sData = self.oSL.dMessageQueue[E_SL_MSG_STACK_WATERMARK_RESPONSE].get(True, fTimeout)
+        except Queue.Empty:
+            raise cSerialLinkError("Stack watermark response not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_STACK_WATERMARK_RESPONSE]
+        u8Status = ord(sData[1])
+        if u8Status != 0:
+            lStatus = ("ok", "unsupported")
+            raise cSerialLinkError("Stack watermark operation %d failed: %s" % (
+                u8Operation, lStatus[u8Status] if u8Status < len(lStatus) else "status %d" % u8Status))
+        return sData[2:]
+
+    def StackWatermarkName(self, u8Kind, u16Id):
+        """Name a task or handler from the kind and id in a stack watermark report"""
+        if u8Kind == 0:
+            lTasks = ("zps task", "bdb task", "app events", "serial rx", "aps queue", "timers", "child queue")
+            return lTasks[u16Id] if u16Id < len(lTasks) else "task %d" % u16Id
+        if u8Kind == 1:
+            for (sName, oValue) in globals().items():
+                if sName.startswith("E_SL_MSG_") and oValue == u16Id:
+                    return "command " + sName[len("E_SL_MSG_"):]
+            return "command 0x%04x" % u16Id
+        lKinds = {2 : "stack event", 3 : "zcl event", 4 : "bdb event"}
+        if u8Kind in lKinds:
+            return "%s %d" % (lKinds[u8Kind], u16Id)
+        return "between tasks"
+
+    def GetStackWatermark(self, bReset=False):
+        """Fetch the stack high-water marks, clearing them afterwards when bReset.
+           Returns (summary dictionary, [(task or handler name, peak bytes, marks set)])
+        """
+        sData = self.StackWatermarkCommand(0, "%02x" % (1 if bReset else 0))
+        lFields = struct.unpack(">HHBHHHHHBB", sData[:17])
+        dSummary = dict(zip(("size", "peak", "peak_kind", "peak_id", "depth", "sweeps", "repaints", "unattributed",
+                             "overflowed", "handlers"), lFields))
+        dSummary["peak_name"] = self.StackWatermarkName(dSummary["peak_kind"], dSummary["peak_id"])
+        dSummary["overflow"] = ", STACK OVERFLOWED" if dSummary["overflowed"] else ""
+        lHandlers = []
+        for i in range(dSummary["handlers"]):
+            (u8Kind, u16Id, u16Peak, u16Marks) = struct.unpack(">BHHH", sData[17 + i * 7:24 + i * 7])
+            lHandlers.append((self.StackWatermarkName(u8Kind, u16Id), u16Peak, u16Marks))
+        return (dSummary, lHandlers)
+
+    def RepaintStackWatermark(self):
+        """Repaint the stack so that measuring starts afresh"""
+        self.StackWatermarkCommand(1)
+
+    def RunSecLibBenchmark(self, u16Iterations=0):
+        """Run the AES known answer test and time block and CCM frame encryption on the node.
+           Returns a result dictionary, times are totals over all iterations
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_SECLIB_BENCHMARK_RESULT] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_SECLIB_BENCHMARK, "%04x" % u16Iterations)
+        try:
+            sData = self.oSL.dMessageQueue[E_SL_MSG_SECLIB_BENCHMARK_RESULT].get(True, 5)
+        except Queue.Empty:
+            raise cSerialLinkError("SecLib benchmark result not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_SECLIB_BENCHMARK_RESULT]
+        (u8Result, u16Iterations, u8FrameLength, u32HwBlock, u32HwFrame, u32SwBlock, u32SwFrame) = struct.unpack(">BHB4I", sData[:20])
+        return {"kat"          : "passed" if u8Result & 0x01 else "FAILED",
+                "ccm"          : "passed" if u8Result & 0x02 else "FAILED",
+                "sw_measured"  : (u8Result & 0x04) != 0,
+                "agree"        : (u8Result & 0x08) != 0,
+                "hw_disabled"  : (u8Result & 0x10) != 0,
+                "iterations"   : u16Iterations,
+                "frame_length" : u8FrameLength,
+                "hw_block_us"  : u32HwBlock,
+                "hw_frame_us"  : u32HwFrame,
+                "sw_block_us"  : u32SwBlock,
+                "sw_frame_us"  : u32SwFrame}
+
+    def RunZclBenchmark(self, u16Iterations=0):
+        """Time ZCL header and attribute serialisation for each ZCL type on the node.
+           Returns a result dictionary with core cycles per operation
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_ZCL_BENCHMARK_RESULT] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_ZCL_BENCHMARK, "%04x" % u16Iterations)
+        try:
+            sData = self.oSL.dMessageQueue[E_SL_MSG_ZCL_BENCHMARK_RESULT].get(True, 10)
+        except Queue.Empty:
+            raise cSerialLinkError("ZCL benchmark result not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_ZCL_BENCHMARK_RESULT]
+        (u8Status, u16Iterations, u32Clock, u32HeaderWrite, u32HeaderRead, u8Types) = struct.unpack(">BHIIIB", sData[:16])
+        fIterations = float(u16Iterations)
+        dTypes = {}
+        for i in range(u8Types):
+            (u8Type, u8Bytes, u32Write, u32Read, u32Forward, u32Encode) = struct.unpack(
+                ">BBIIII", sData[16 + i * 18:34 + i * 18])
+            dTypes[ZCL_TYPE_NAMES.get(u8Type, "0x%02x" % u8Type)] = {
+                "type"    : u8Type,
+                "bytes"   : u8Bytes,
+                "write"   : u32Write / fIterations,
+                "read"    : u32Read / fIterations,
+                "forward" : u32Forward / fIterations,
+                "encode"  : u32Encode / fIterations}
+        if u8Status < len(ZCL_BENCHMARK_STATUS):
+            sStatus = ZCL_BENCHMARK_STATUS[u8Status]
+        else:
+            sStatus = "status %d" % u8Status
+        return {"status"     : sStatus,
+                "iterations" : u16Iterations,
+                "clock_hz"   : u32Clock,
+                # Frame control, manufacturer code, sequence number and command
+                "header"     : {"bytes" : 5, "write" : u32HeaderWrite / fIterations, "read" : u32HeaderRead / fIterations},
+                "types"      : dTypes}
+
+    def GetPdmTelemetry(self, bReset=False):
+        """Fetch the PDM save and flash wear counters, optionally resetting them.
+           Returns (summary dictionary, wear count per segment, [(record id, saves, bytes)])
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_PDM_TELEMETRY] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_GET_PDM_TELEMETRY, "01" if bReset else "00")
+
+        dSummary = None
+        lWear = []
+        lRecords = []
+        u8Segments = None
+        u8Records = None
+        try:
+            while dSummary is None or len(lWear) < u8Segments or u8Records is None or len(lRecords) < u8Records:
+                sData = self.oSL.dMessageQueue[E_SL_MSG_PDM_TELEMETRY].get(True, 2)
+                u8Section = ord(sData[0])
+                if u8Section == 0:
+                    lFields = struct.unpack(">BB12IBB", sData[:52])
+                    dSummary = dict(zip(("version", "saves", "command", "idle", "failed", "bytes",
+                                         "min_us", "avg_us", "max_us", "erases", "wear", "wear_min", "wear_max",
+                                         "segments", "records"), lFields[1:]))
+                    u8Segments = dSummary["segments"]
+                    if dSummary["version"] >= 2:
+                        (dSummary["boot_us"], u8Buckets) = struct.unpack(">IB", sData[52:57])
+                        dSummary["latency"] = struct.unpack(">%dI" % u8Buckets, sData[57:57 + u8Buckets * 4])
+                elif u8Section == 1:
+                    (u8First, u8Count, u8Segments) = struct.unpack(">BBB", sData[1:4])
+                    lWear += struct.unpack(">%dI" % u8Count, sData[4:4 + u8Count * 4])
+                elif u8Section == 2:
+                    (u8First, u8Count, u8Records) = struct.unpack(">BBB", sData[1:4])
+                    for i in range(u8Count):
+                        lRecords.append(struct.unpack(">HII", sData[4 + i * 10:14 + i * 10]))
+        except Queue.Empty:
+            raise cSerialLinkError("PDM telemetry incomplete")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_PDM_TELEMETRY]
+        return (dSummary, lWear, lRecords)
+
     def InitiateTouchLinkFactoryReset(self):
         """Initiate Touch Link factory reset"""
         self.oSL.SendMessage(E_SL_MSG_TOUCHLINK_FACTORY_RESET)
@@ -801,6 +1768,114 @@ class cControlBridge():
         self.oSL.SendMessage(E_SL_MSG_PERMIT_JOINING_REQUEST,(str(targetAddress)+str(pemitDuration)+str(TcOverride)))
 
 
+    def SetAttributeCacheRule(self, u8Index, u16ClusterId, u32Ttl):
+        """Cache the attributes of a cluster (0xFFFF for any other cluster) for u32Ttl seconds,
+           0 to remove the rule at u8Index. u8Index 0xFF removes every rule and cached value
+        """
+        self.oSL.SendMessage(E_SL_MSG_ATTRIBUTE_CACHE_SET_RULE, "%02x%04x%08x" % (u8Index, u16ClusterId, u32Ttl))
+
+    def GetAttributeCacheStats(self, bReset=False):
+        """Fetch the attribute cache counters, optionally resetting them.
+           Returns a dictionary
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_ATTRIBUTE_CACHE_STATS] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_ATTRIBUTE_CACHE_GET_STATS, "01" if bReset else "00")
+        try:
+            sData = self.oSL.dMessageQueue[E_SL_MSG_ATTRIBUTE_CACHE_STATS].get(True, 2)
+        except Queue.Empty:
+            raise cSerialLinkError("Attribute cache statistics not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_ATTRIBUTE_CACHE_STATS]
+        return dict(zip(("rules", "held", "capacity", "hits", "misses", "stored", "expired", "evicted",
+                         "invalidated"), struct.unpack(">BBB6I", sData[:27])))
+
+    def SetApsQueueReportDepth(self, bEnable):
+        """Append the number of commands waiting in the APS admission queue to every status
+           message, or stop doing so. Lasts until the node resets
+        """
+        self.oSL.SendMessage(E_SL_MSG_APS_QUEUE_REPORT_DEPTH, "01" if bEnable else "00")
+
+    def SetChildQueueExpiry(self, u16Seconds):
+        """Hold commands for a sleepy child up to u16Seconds until it polls for them, 0 to send them
+           straight away
+        """
+        self.oSL.SendMessage(E_SL_MSG_CHILD_QUEUE_SET_EXPIRY, "%04x" % u16Seconds)
+
+    def GetChildQueueStats(self, bReset=False):
+        """Fetch the sleepy child queue counters, optionally resetting them.
+           Returns a dictionary with a list of per child dictionaries, latencies in seconds
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_CHILD_QUEUE_STATS] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_CHILD_QUEUE_GET_STATS, "01" if bReset else "00")
+        try:
+            sData = self.oSL.dMessageQueue[E_SL_MSG_CHILD_QUEUE_STATS].get(True, 2)
+        except Queue.Empty:
+            raise cSerialLinkError("Child queue statistics not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_CHILD_QUEUE_STATS]
+        dStats = dict(zip(("expiry", "held", "capacity", "child_count", "total_held", "delivered", "expired",
+                           "coalesced", "rearmed", "full"), struct.unpack(">HBBB6I", sData[:29])))
+        dStats["children"] = []
+        for i in range(29, len(sData) - 14, 15):
+            dChild = dict(zip(("address", "held", "delivered", "expired", "coalesced", "rearmed", "latency_mean",
+                               "latency_max"), struct.unpack(">HBHHHHHH", sData[i:i + 15])))
+            dChild["latency_mean"] /= 10.0
+            dChild["latency_max"] /= 10.0
+            dStats["children"].append(dChild)
+        return dStats
+
+    def StartDeviceInterview(self, u16Addr, u8Capability=0):
+        """Interview a joined device as if it had just announced itself; a capability of 0
+           assumes it sleeps. Call WaitDeviceInterview for the result
+        """
+        self.oSL.dMessageQueue[E_SL_MSG_DEVICE_INTERVIEW_RESULT] = Queue.Queue()
+        self.oSL.SendMessage(E_SL_MSG_DEVICE_INTERVIEW_START, "%04x%02x" % (u16Addr, u8Capability))
+
+    def WaitDeviceInterview(self, fTimeout=70):
+        """Wait for the next interview result, of an announced device or of StartDeviceInterview.
+           Returns a dictionary with its endpoints and Basic cluster attribute records
+        """
+        if E_SL_MSG_DEVICE_INTERVIEW_RESULT not in self.oSL.dMessageQueue:
+            self.oSL.dMessageQueue[E_SL_MSG_DEVICE_INTERVIEW_RESULT] = Queue.Queue()
+        oQueue = self.oSL.dMessageQueue[E_SL_MSG_DEVICE_INTERVIEW_RESULT]
+        dResult = None
+        try:
+            while dResult is None or len(dResult["endpoints"]) < dResult["endpoint_count"] or \
+                    len(dResult["attributes"]) < dResult["attribute_count"]:
+                sData = oQueue.get(True, fTimeout)
+                (u16Addr, u8Section) = struct.unpack(">HB", sData[:3])
+                if u8Section == 0:
+                    lFields = struct.unpack(">QBBHBB13sBBBB", sData[3:34])
+                    dResult = dict(zip(("ieee", "capability", "status", "duration", "requests", "node_desc_status",
+                                        "node_desc", "active_ep_status", "endpoint_count", "basic_endpoint",
+                                        "attribute_count"), lFields))
+                    dResult["address"] = u16Addr
+                    dResult["duration"] /= 10.0
+                    dResult["status"] = DEVICE_INTERVIEW_STATUS[dResult["status"]] \
+                        if dResult["status"] < len(DEVICE_INTERVIEW_STATUS) else "status %d" % dResult["status"]
+                    dResult["endpoints"] = []
+                    dResult["attributes"] = []
+                elif dResult is None or u16Addr != dResult["address"]:
+                    continue
+                elif u8Section == 1:
+                    (u8Status, u8Endpoint) = struct.unpack(">BB", sData[3:5])
+                    dEndpoint = {"endpoint" : u8Endpoint, "status" : u8Status}
+                    if u8Status == 0:
+                        (dEndpoint["profile"], dEndpoint["device"], u8Version, u8In) = struct.unpack(">HHBB", sData[5:11])
+                        dEndpoint["in"] = struct.unpack(">%dH" % u8In, sData[11:11 + 2 * u8In])
+                        u8Out = ord(sData[11 + 2 * u8In])
+                        dEndpoint["out"] = struct.unpack(">%dH" % u8Out, sData[12 + 2 * u8In:12 + 2 * (u8In + u8Out)])
+                    dResult["endpoints"].append(dEndpoint)
+                elif u8Section == 2:
+                    (u16Attribute, u8Status, u8Type, u16Size) = struct.unpack(">HBBH", sData[3:9])
+                    dResult["attributes"].append((u16Attribute, u8Status, ZCL_TYPE_NAMES.get(u8Type, "0x%02x" % u8Type),
+                                                  sData[9:]))
+        except Queue.Empty:
+            raise cSerialLinkError("Device interview result not received")
+        finally:
+            del self.oSL.dMessageQueue[E_SL_MSG_DEVICE_INTERVIEW_RESULT]
+        return dResult
+
     def ReadAttributeRequest(self,addressmode,TargetAddress,srcEp,dstEp,clusterid,bServer,bManufactuer,ManId,numberOfAttributes,attributelist):
          """Send Read Attributes Request"""
          self.oSL.SendMessage(E_SL_MSG_READ_ATTRIBUTE_REQUEST,(str(addressmode)+str(TargetAddress)+str(srcEp)+str(dstEp)+str(clusterid)+str(bServer)+str(bManufactuer)+str(ManId)+str(numberOfAttributes)+str(attributelist)))
@@ -890,15 +1965,51 @@ if __name__ == "__main__":
     parser.add_option("-b", "--baudrate", dest="baudrate",
                       help="Baudrate", default=1000000)
 
+    parser.add_option("-c", "--capture", dest="capture",
+                      help="Record both directions of the session to a capture file", default=None)
+
+    parser.add_option("-r", "--replay", dest="replay",
+                      help="Replay the host side of a capture file to --port and report latencies", default=None)
+
+    parser.add_option("-s", "--scale", dest="scale", type="float",
+                      help="Timing scale for --replay, 0 to send back to back", default=1.0)
+
+    parser.add_option("-S", "--summary", dest="summary",
+                      help="Print throughput per message type of a capture file", default=None)
+
+    parser.add_option("-z", "--zcl-benchmark", dest="zcl_benchmark",
+                      help="Run the ZCL benchmark on --port, write the result to this JSON file and exit", default=None)
+
+    parser.add_option("--baseline", dest="baseline",
+                      help="ZCL benchmark JSON file to compare --zcl-benchmark with", default=None)
+
+    parser.add_option("--tolerance", dest="tolerance", type="float",
+                      help="Percent more cycles than --baseline counted as a regression", default=10.0)
+
+    parser.add_option("--iterations", dest="iterations", type="int",
+                      help="Iterations per ZCL benchmark path, 0 for the node default", default=0)
+
     (options, args) = parser.parse_args()
     
     logging.basicConfig(format="%(asctime)-15s %(levelname)s:%(name)s:%(message)s")
     logging.getLogger().setLevel(logging.INFO)
                     
+    if options.summary is not None:
+        SummariseCapture(options.summary, int(options.baudrate))
+        sys.exit(0)
+
     if options.port is None:
         #print "Please specify serial port with --port"
         parser.print_help()
         sys.exit(1)
+
+    if options.replay is not None:
+        ReplayCapture(options.replay, options.port, int(options.baudrate), options.scale)
+        sys.exit(0)
+
+    if options.zcl_benchmark is not None:
+        sys.exit(RunZclBenchmarkGate(options.port, int(options.baudrate), options.zcl_benchmark,
+                                     options.baseline, options.tolerance, options.iterations))
         
     conn = sqlite3.connect('pdm.db')
     c = conn.cursor()
@@ -910,7 +2021,7 @@ if __name__ == "__main__":
     conn.commit()
     conn.close()
 
-    oCB = cControlBridge(options.port, options.baudrate)
+    oCB = cControlBridge(options.port, options.baudrate, options.capture)
     continueToRun = True
     #bRunning = True
     oCB.oSL._WriteMessage(E_SL_MSG_PDM_HOST_AVAILABLE_RESPONSE,"00")
@@ -0,0 +1,111 @@
+#*****************************************************************************
+#*
+# * MODULE:             ZigBee Control Bridge
+# *
+# * COMPONENT:          ZclBenchmarkBaseline.py
+# *
+# * DESCRIPTION:        Runs the host zcl_benchmark, writes its JSON result
+# *                     and compares it with a baseline written the same way
+# *                     on the same host. A single type's path costs a
+# *                     cycle or less on the host, under its run to run
+# *                     noise, so the gate is on the ZCL header and on each
+# *                     path summed over every type; the types that moved
+# *                     most are listed with it. Without a baseline the
+# *                     result becomes one.
+# *
+# *                     Usage:
+# *                     ZclBenchmarkBaseline.py [--update] [--tolerance %]
+# *                                             --baseline file
+# *                                             zcl_benchmark result.json
+# *
+# *                     --update rewrites the baseline from this run.
+# *
+# *****************************************************************************
+from __future__ import print_function
+
+import sys
+import json
+import optparse
+import subprocess
+
+PATHS = ("write", "read", "forward", "encode")
+MOVERS = 5
+
+
+def Totals(dResult):
+    """Cycles per operation of the ZCL header, and of each path over every type"""
+    dTotals = {"header write" : dResult["header"]["write"], "header read" : dResult["header"]["read"]}
+    for sPath in PATHS:
+        dTotals[sPath] = sum(dType[sPath] for dType in dResult["types"].values())
+    return dTotals
+
+
+def Compare(dResult, dBaseline, fTolerance):
+    """Returns [(total, baseline cycles, cycles)] for every total more than fTolerance percent slower"""
+    dNow = Totals(dResult)
+    dThen = Totals(dBaseline)
+    return [(sName, dThen[sName], dNow[sName]) for sName in sorted(dNow)
+            if dThen[sName] > 0 and dNow[sName] > dThen[sName] * (1 + fTolerance / 100.0)]
+
+
+def Movers(dResult, dBaseline):
+    """The type paths that changed most from the baseline, [(change, type, path, baseline, cycles)]"""
+    lMovers = []
+    for (sName, dType) in dResult["types"].items():
+        dThen = dBaseline["types"].get(sName)
+        if dThen is None:
+            continue
+        for sPath in PATHS:
+            if dThen[sPath] > 0:
+                lMovers.append((dType[sPath] / dThen[sPath] - 1, sName, sPath, dThen[sPath], dType[sPath]))
+    return sorted(lMovers, reverse=True)[:MOVERS]
+
+
+def main(argv):
+    oParser = optparse.OptionParser(usage="%prog [--update] [--tolerance %] --baseline file zcl_benchmark result.json")
+    oParser.add_option("--baseline", dest="baseline", help="Baseline JSON written by an earlier run")
+    oParser.add_option("--tolerance", dest="tolerance", type="float", default=10.0,
+                       help="Percent more cycles than the baseline counted as a regression")
+    oParser.add_option("--update", dest="update", action="store_true", default=False,
+                       help="Rewrite the baseline from this run")
+    (oOptions, lArgs) = oParser.parse_args(argv)
+    if len(lArgs) != 2 or oOptions.baseline is None:
+        oParser.print_help()
+        return 2
+
+    (sBenchmark, sResult) = lArgs
+    dResult = json.loads(subprocess.check_output([sBenchmark]).decode())
+    with open(sResult, "w") as oFile:
+        json.dump(dResult, oFile, indent=1, sort_keys=True)
+    if dResult["status"] != "ok":
+        print("ZclBenchmarkBaseline: benchmark status %s" % dResult["status"])
+        return 1
+
+    try:
+        with open(oOptions.baseline) as oFile:
+            dBaseline = json.load(oFile)
+    except IOError:
+        dBaseline = None
+    if oOptions.update or dBaseline is None:
+        with open(oOptions.baseline, "w") as oFile:
+            json.dump(dResult, oFile, indent=1, sort_keys=True)
+        print("ZclBenchmarkBaseline: baseline %s written" % oOptions.baseline)
+        return 0
+
+    dNow = Totals(dResult)
+    dThen = Totals(dBaseline)
+    print("ZCL benchmark x%d, cycles per operation at %.1f MHz" % (dResult["iterations"], dResult["clock_hz"] / 1e6))
+    for sName in sorted(dNow):
+        print("  %-13s %8.2f %8.2f %+6.1f%%" % (sName, dThen[sName], dNow[sName],
+                                               100.0 * (dNow[sName] - dThen[sName]) / dThen[sName] if dThen[sName] else 0))
+    for (fChange, sName, sPath, fThen, fNow) in Movers(dResult, dBaseline):
+        print("  type %s %-7s %8.2f %8.2f %+6.1f%%" % (sName, sPath, fThen, fNow, 100.0 * fChange))
+    lSlower = Compare(dResult, dBaseline, oOptions.tolerance)
+    for (sName, fThen, fNow) in lSlower:
+        print("FAIL %s %.2f -> %.2f cycles, more than %.0f%% slower" % (sName, fThen, fNow, oOptions.tolerance))
+    print("ZclBenchmarkBaseline: %s" % ("%d failed" % len(lSlower) if lSlower else "passed"))
+    return 1 if lSlower else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))